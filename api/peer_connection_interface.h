@@ -93,6 +93,7 @@
 #include "api/stats/rtc_stats_collector_callback.h"
 #include "api/stats_types.h"
 #include "api/task_queue/task_queue_factory.h"
+#include "api/thread_placement.h"
 #include "api/transport/bitrate_settings.h"
 #include "api/transport/network_control.h"
 #include "api/turn_customizer.h"
@@ -600,6 +601,18 @@ class RTC_EXPORT PeerConnectionInterface : public rtc::RefCountInterface {
     // correctly. This flag will be deprecated soon. Do not rely on it.
     bool active_reset_srtp_params = false;
 
+    // If true, DTLS handshakes resume the session of an earlier handshake
+    // between the same two certificates when there is one, which takes one
+    // round trip instead of two. The sessions are kept by the
+    // PeerConnectionFactory and shared by the PeerConnections on the same
+    // network thread.
+    bool enable_dtls_session_resumption = false;
+
+    // If true, the DTLS handshake starts as soon as the DTLS role and the
+    // remote fingerprint are known, rather than once ICE is writable. Its
+    // first flight is sent on the first writable candidate pair.
+    bool early_dtls_handshake = false;
+
     // If MediaTransportFactory is provided in PeerConnectionFactory, this flag
     // informs PeerConnection that it should use the MediaTransportInterface for
     // media (audio/video). It's invalid to set it to |true| if the
@@ -1256,7 +1269,16 @@ struct PeerConnectionFactoryDependencies final {
   rtc::Thread* network_thread = nullptr;
   rtc::Thread* worker_thread = nullptr;
   rtc::Thread* signaling_thread = nullptr;
+  // PeerConnections created with the default PortAllocator are spread over
+  // |network_thread| and these threads, each running the sockets, ICE, DTLS
+  // and SRTP of the PeerConnections assigned to it. Must outlive the factory.
+  std::vector<rtc::Thread*> additional_network_threads;
   std::unique_ptr<TaskQueueFactory> task_queue_factory;
+  // Places the threads above, named "pc_network_thread", "pc_worker_thread",
+  // "pc_signaling_thread" and "pc_network_thread_<n>", and those of the task
+  // queues of Call, such as "EncoderQueue". These are created with
+  // |task_queue_factory|, or the default TaskQueueFactory if it isn't set.
+  std::unique_ptr<ThreadPlacementPolicy> thread_placement_policy;
   std::unique_ptr<cricket::MediaEngineInterface> media_engine;
   std::unique_ptr<CallFactoryInterface> call_factory;
   std::unique_ptr<RtcEventLogFactoryInterface> event_log_factory;
@@ -1314,6 +1336,14 @@ class PeerConnectionFactoryInterface : public rtc::RefCountInterface {
 
     // Sets crypto related options, e.g. enabled cipher suites.
     CryptoOptions crypto_options = CryptoOptions::NoGcm();
+
+    // If greater than zero, this many certificates with
+    // |certificate_pool_key_params| are generated ahead of time on the network
+    // thread, and created PeerConnections that use the default certificate
+    // generator take one instead of waiting for key generation. The pool is
+    // refilled in the background as certificates are taken.
+    int certificate_pool_size = 0;
+    rtc::KeyParams certificate_pool_key_params;
   };
 
   // Set the options to be used for subsequently created PeerConnections.
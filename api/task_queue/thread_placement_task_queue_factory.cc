@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "api/task_queue/thread_placement_task_queue_factory.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/thread_placement.h"
+
+namespace webrtc {
+namespace {
+
+class ThreadPlacementTaskQueueFactory : public TaskQueueFactory {
+ public:
+  ThreadPlacementTaskQueueFactory(std::unique_ptr<TaskQueueFactory> factory,
+                                  const ThreadPlacementPolicy* policy)
+      : factory_(std::move(factory)), policy_(policy) {
+    RTC_DCHECK(factory_);
+    RTC_DCHECK(policy_);
+  }
+
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
+      absl::string_view name,
+      Priority priority) const override {
+    std::unique_ptr<TaskQueueBase, TaskQueueDeleter> queue =
+        factory_->CreateTaskQueue(name, priority);
+    queue->PostTask(ToQueuedTask(
+        [name = std::string(name), placement = policy_->GetPlacement(name)] {
+          rtc::SetCurrentThreadPlacement(name, placement);
+        }));
+    return queue;
+  }
+
+ private:
+  const std::unique_ptr<TaskQueueFactory> factory_;
+  const ThreadPlacementPolicy* const policy_;
+};
+
+}  // namespace
+
+std::unique_ptr<TaskQueueFactory> CreateThreadPlacementTaskQueueFactory(
+    std::unique_ptr<TaskQueueFactory> factory,
+    const ThreadPlacementPolicy* policy) {
+  return absl::make_unique<ThreadPlacementTaskQueueFactory>(std::move(factory),
+                                                            policy);
+}
+
+}  // namespace webrtc
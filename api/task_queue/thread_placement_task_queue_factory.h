@@ -0,0 +1,35 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef API_TASK_QUEUE_THREAD_PLACEMENT_TASK_QUEUE_FACTORY_H_
+#define API_TASK_QUEUE_THREAD_PLACEMENT_TASK_QUEUE_FACTORY_H_
+
+#include <memory>
+
+#include "api/task_queue/task_queue_factory.h"
+#include "api/thread_placement.h"
+
+namespace webrtc {
+
+// Returns a factory that creates task queues with |factory|, and places their
+// threads with |policy| by the names of the queues. |policy| must outlive the
+// returned factory. The threads are also reported by
+// rtc::GetPlacedThreadsCpuUsage().
+//
+// The placement is applied by the first task of a queue, so it only makes
+// sense for factories that run each queue on a thread of its own, like the
+// default factory on Linux, Android and Windows.
+std::unique_ptr<TaskQueueFactory> CreateThreadPlacementTaskQueueFactory(
+    std::unique_ptr<TaskQueueFactory> factory,
+    const ThreadPlacementPolicy* policy);
+
+}  // namespace webrtc
+
+#endif  // API_TASK_QUEUE_THREAD_PLACEMENT_TASK_QUEUE_FACTORY_H_
@@ -0,0 +1,88 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "api/task_queue/thread_placement_task_queue_factory.h"
+
+#include <string>
+#include <vector>
+
+#include "api/task_queue/default_task_queue_factory.h"
+#include "api/task_queue/task_queue_test.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/thread_placement.h"
+#include "test/gmock.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Leaves the threads where they are, and records their names.
+class RecordingPolicy : public ThreadPlacementPolicy {
+ public:
+  ThreadPlacement GetPlacement(absl::string_view thread_name) const override {
+    rtc::CritScope cs(&crit_);
+    names_.emplace_back(thread_name);
+    return ThreadPlacement();
+  }
+
+  std::vector<std::string> names() const {
+    rtc::CritScope cs(&crit_);
+    return names_;
+  }
+
+ private:
+  rtc::CriticalSection crit_;
+  mutable std::vector<std::string> names_ RTC_GUARDED_BY(crit_);
+};
+
+bool IsPlaced(const std::string& name) {
+  for (const rtc::ThreadCpuUsage& usage : rtc::GetPlacedThreadsCpuUsage()) {
+    if (usage.name == name)
+      return true;
+  }
+  return false;
+}
+
+std::unique_ptr<TaskQueueFactory> CreatePlacedDefaultFactory() {
+  static const RecordingPolicy* const policy = new RecordingPolicy();
+  return CreateThreadPlacementTaskQueueFactory(CreateDefaultTaskQueueFactory(),
+                                               policy);
+}
+
+INSTANTIATE_TEST_SUITE_P(ThreadPlacement,
+                         TaskQueueTest,
+                         ::testing::Values(CreatePlacedDefaultFactory));
+
+TEST(ThreadPlacementTaskQueueFactoryTest, PlacesQueuesByName) {
+  RecordingPolicy policy;
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateThreadPlacementTaskQueueFactory(CreateDefaultTaskQueueFactory(),
+                                            &policy);
+  auto queue = factory->CreateTaskQueue("PlacedQueue",
+                                        TaskQueueFactory::Priority::NORMAL);
+  rtc::Event done;
+  queue->PostTask(ToQueuedTask([&done] { done.Set(); }));
+  ASSERT_TRUE(done.Wait(1000));
+
+  EXPECT_THAT(policy.names(), ElementsAre("PlacedQueue"));
+  EXPECT_TRUE(IsPlaced("PlacedQueue"));
+  queue = nullptr;
+#if !defined(WEBRTC_MAC)
+  // The queue had a thread of its own, which is gone. GCD reuses threads.
+  EXPECT_FALSE(IsPlaced("PlacedQueue"));
+#endif
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -0,0 +1,60 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef API_THREAD_PLACEMENT_H_
+#define API_THREAD_PLACEMENT_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace webrtc {
+
+// Where and how a thread runs, for hosts that dedicate cores to media. The
+// default placement leaves the thread as it is. Scheduling policies are only
+// supported on Linux and Android.
+struct ThreadPlacement {
+  enum class Scheduling {
+    kDefault,
+    // SCHED_OTHER, the time-sharing policy. Note that rtc::PlatformThread
+    // otherwise moves its threads to SCHED_FIFO on Linux where permitted.
+    kTimeSharing,
+    // SCHED_FIFO and SCHED_RR. They need CAP_SYS_NICE or an RLIMIT_RTPRIO of
+    // at least |realtime_priority|.
+    kFifo,
+    kRoundRobin,
+  };
+
+  // The CPUs the thread may run on, any CPU if empty.
+  std::vector<int> cpus;
+  // Restricts the thread to the CPUs of a NUMA node, and of |cpus| if that's
+  // set too. -1 for any node.
+  int numa_node = -1;
+  Scheduling scheduling = Scheduling::kDefault;
+  // 1 (lowest) to 99 (highest) for kFifo and kRoundRobin.
+  int realtime_priority = 1;
+};
+
+// Decides the placement of the threads WebRTC creates, by their names. These
+// include the "pc_network_thread", "pc_worker_thread" and
+// "pc_signaling_thread" threads of PeerConnectionFactory, and task queues such
+// as "EncoderQueue" and "DecodingQueue".
+//
+// The implementation of this interface must be thread-safe.
+class ThreadPlacementPolicy {
+ public:
+  virtual ~ThreadPlacementPolicy() = default;
+
+  virtual ThreadPlacement GetPlacement(absl::string_view thread_name) const = 0;
+};
+
+}  // namespace webrtc
+
+#endif  // API_THREAD_PLACEMENT_H_
@@ -20,7 +20,9 @@ namespace webrtc {
 
 // Format conversion (remixing and resampling) for audio. Only simple remixing
 // conversions are supported: downmix to mono (i.e. |dst_channels| == 1) or
-// upmix from mono (i.e. |src_channels == 1|).
+// upmix from mono (i.e. |src_channels == 1|). When both remixing and
+// resampling are needed they are done in a single pass, without intermediate
+// buffers, and only one channel is resampled.
 //
 // The source and destination chunks have the same duration in time; specifying
 // the number of frames is equivalent to specifying the sample rates.
@@ -49,7 +51,6 @@ class AudioConverter {
   size_t dst_frames() const { return dst_frames_; }
 
  protected:
-  AudioConverter();
   AudioConverter(size_t src_channels,
                  size_t src_frames,
                  size_t dst_channels,
@@ -159,4 +159,58 @@ TEST(AudioConverterTest, ConversionsPassSNRThreshold) {
   }
 }
 
+// The fused remix and resample converters must produce exactly the same output
+// as remixing and resampling in separate steps.
+TEST(AudioConverterTest, FusedRemixAndResampleMatchesSeparateSteps) {
+  const size_t kSrcFrames = 480;
+  const size_t kDstFrames = 160;
+  for (size_t num_channels : {2, 6}) {
+    std::vector<float> src_data;
+    for (size_t i = 0; i < num_channels; ++i)
+      src_data.push_back(0.0001f * (i + 1));
+    ScopedBuffer src_buffer = CreateBuffer(src_data, kSrcFrames);
+
+    // Downmix followed by resampling.
+    std::unique_ptr<AudioConverter> downmix = AudioConverter::Create(
+        num_channels, kSrcFrames, 1, kDstFrames);
+    ChannelBuffer<float> dst_mono(kDstFrames, 1);
+    ChannelBuffer<float> ref_mono_full_rate(kSrcFrames, 1);
+    ChannelBuffer<float> ref_mono(kDstFrames, 1);
+    PushSincResampler ref_resampler(kSrcFrames, kDstFrames);
+
+    // Resampling followed by upmix.
+    std::unique_ptr<AudioConverter> upmix = AudioConverter::Create(
+        1, kDstFrames, num_channels, kSrcFrames);
+    ChannelBuffer<float> dst_multi(kSrcFrames, num_channels);
+    ChannelBuffer<float> ref_mono_upsampled(kSrcFrames, 1);
+    PushSincResampler ref_upsampler(kDstFrames, kSrcFrames);
+
+    for (int frame = 0; frame < 5; ++frame) {
+      downmix->Convert(src_buffer->channels(), src_buffer->size(),
+                       dst_mono.channels(), dst_mono.size());
+      for (size_t i = 0; i < kSrcFrames; ++i) {
+        float sum = 0;
+        for (size_t j = 0; j < num_channels; ++j)
+          sum += src_buffer->channels()[j][i];
+        ref_mono_full_rate.channels()[0][i] = sum / num_channels;
+      }
+      ref_resampler.Resample(ref_mono_full_rate.channels()[0], kSrcFrames,
+                             ref_mono.channels()[0], kDstFrames);
+      for (size_t i = 0; i < kDstFrames; ++i)
+        ASSERT_EQ(ref_mono.channels()[0][i], dst_mono.channels()[0][i]);
+
+      upmix->Convert(dst_mono.channels(), dst_mono.size(),
+                     dst_multi.channels(), dst_multi.size());
+      ref_upsampler.Resample(dst_mono.channels()[0], kDstFrames,
+                             ref_mono_upsampled.channels()[0], kSrcFrames);
+      for (size_t j = 0; j < num_channels; ++j) {
+        for (size_t i = 0; i < kSrcFrames; ++i) {
+          ASSERT_EQ(ref_mono_upsampled.channels()[0][i],
+                    dst_multi.channels()[j][i]);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace webrtc
@@ -0,0 +1,182 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common_audio/audio_converter.h"
+#include "common_audio/channel_buffer.h"
+#include "common_audio/fir_filter.h"
+#include "common_audio/fir_filter_c.h"
+#include "common_audio/resampler/include/push_resampler.h"
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/system/arch.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include "common_audio/fir_filter_sse.h"
+#include "system_wrappers/include/cpu_features_wrapper.h"
+#if defined(WEBRTC_ENABLE_AVX2)
+#include "common_audio/fir_filter_avx2.h"
+#endif
+#endif
+
+namespace webrtc {
+
+namespace {
+
+// Number of 10 ms blocks processed per measurement.
+constexpr int kNumBlocks = 10000;
+
+// Returns the average time in microseconds spent in |process| per call.
+template <typename Function>
+double MeasureUs(Function process) {
+  const int64_t start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumBlocks; ++i)
+    process();
+  return static_cast<double>(rtc::TimeMicros() - start_us) / kNumBlocks;
+}
+
+std::string FormatLabel(int src_rate_hz,
+                        size_t src_channels,
+                        int dst_rate_hz,
+                        size_t dst_channels) {
+  rtc::StringBuilder label;
+  label << src_rate_hz / 1000 << "k_" << src_channels << "ch_to_"
+        << dst_rate_hz / 1000 << "k_" << dst_channels << "ch";
+  return label.Release();
+}
+
+void FillTone(float* buffer, size_t length, float frequency) {
+  for (size_t i = 0; i < length; ++i)
+    buffer[i] = 10000.f * sinf(frequency * i);
+}
+
+}  // namespace
+
+// Filters 10 ms at 48 kHz with FIR filters of typical lengths, using each of
+// the implementations available on this CPU.
+TEST(CommonAudioPerformanceTest, FirFilter) {
+  const size_t kBlockLength = 480;
+  std::vector<float> input(kBlockLength);
+  std::vector<float> output(kBlockLength);
+  FillTone(input.data(), input.size(), 0.05f);
+
+  for (size_t coefficients_length : {16, 64, 256}) {
+    std::vector<float> coefficients(coefficients_length);
+    for (size_t i = 0; i < coefficients_length; ++i)
+      coefficients[i] = 1.f / (i + 1);
+
+    std::vector<std::pair<std::string, std::unique_ptr<FIRFilter>>> filters;
+    filters.emplace_back(
+        "_c", std::unique_ptr<FIRFilter>(new FIRFilterC(
+                  coefficients.data(), coefficients_length)));
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    if (WebRtc_GetCPUInfo(kSSE2)) {
+      filters.emplace_back(
+          "_sse2", std::unique_ptr<FIRFilter>(new FIRFilterSSE2(
+                       coefficients.data(), coefficients_length,
+                       kBlockLength)));
+    }
+#if defined(WEBRTC_ENABLE_AVX2)
+    if (WebRtc_GetCPUInfo(kAVX2)) {
+      filters.emplace_back(
+          "_avx2", std::unique_ptr<FIRFilter>(new FIRFilterAVX2(
+                       coefficients.data(), coefficients_length,
+                       kBlockLength)));
+    }
+#endif
+#endif
+
+    rtc::StringBuilder trace;
+    trace << coefficients_length << "_taps";
+    for (auto& filter : filters) {
+      FIRFilter* fir = filter.second.get();
+      test::PrintResult("fir_filter_10ms_48k", filter.first, trace.str(),
+                        MeasureUs([&] {
+                          fir->Filter(input.data(), kBlockLength,
+                                      output.data());
+                        }),
+                        "us", false);
+    }
+  }
+}
+
+// Resamples interleaved 10 ms blocks with PushResampler.
+TEST(CommonAudioPerformanceTest, PushResamplerInterleaved) {
+  const int kRates[][2] = {
+      {48000, 16000}, {16000, 48000}, {44100, 48000}, {48000, 44100}};
+  for (size_t num_channels : {1, 2, 6}) {
+    for (const auto& rates : kRates) {
+      const size_t src_frames = rates[0] / 100;
+      const size_t dst_frames = rates[1] / 100;
+      std::vector<float> src(src_frames * num_channels);
+      std::vector<float> dst(dst_frames * num_channels);
+      FillTone(src.data(), src.size(), 0.01f);
+
+      PushResampler<float> resampler;
+      ASSERT_EQ(0, resampler.InitializeIfNeeded(rates[0], rates[1],
+                                                num_channels));
+      test::PrintResult(
+          "push_resampler_10ms", "",
+          FormatLabel(rates[0], num_channels, rates[1], num_channels),
+          MeasureUs([&] {
+            resampler.Resample(src.data(), src.size(), dst.data(),
+                               dst.size());
+          }),
+          "us", false);
+    }
+  }
+}
+
+// Converts 10 ms blocks with AudioConverter, covering the remix-only,
+// resample-only and fused remix and resample paths.
+TEST(CommonAudioPerformanceTest, AudioConverter) {
+  struct Format {
+    int src_rate_hz;
+    size_t src_channels;
+    int dst_rate_hz;
+    size_t dst_channels;
+  };
+  const Format kFormats[] = {
+      {48000, 2, 48000, 1}, {48000, 1, 48000, 2}, {48000, 2, 16000, 2},
+      {48000, 2, 16000, 1}, {48000, 6, 16000, 1}, {16000, 1, 48000, 2},
+      {44100, 2, 48000, 1}, {16000, 1, 48000, 6},
+  };
+  for (const Format& format : kFormats) {
+    const size_t src_frames = format.src_rate_hz / 100;
+    const size_t dst_frames = format.dst_rate_hz / 100;
+    ChannelBuffer<float> src(src_frames, format.src_channels);
+    ChannelBuffer<float> dst(dst_frames, format.dst_channels);
+    for (size_t i = 0; i < format.src_channels; ++i)
+      FillTone(src.channels()[i], src_frames, 0.01f * (i + 1));
+
+    std::unique_ptr<AudioConverter> converter =
+        AudioConverter::Create(format.src_channels, src_frames,
+                               format.dst_channels, dst_frames);
+    test::PrintResult(
+        "audio_converter_10ms", "",
+        FormatLabel(format.src_rate_hz, format.src_channels,
+                    format.dst_rate_hz, format.dst_channels),
+        MeasureUs([&] {
+          converter->Convert(src.channels(), src.size(), dst.channels(),
+                             dst.size());
+        }),
+        "us", false);
+  }
+}
+
+}  // namespace webrtc
@@ -17,6 +17,9 @@
 #if defined(WEBRTC_HAS_NEON)
 #include "common_audio/fir_filter_neon.h"
 #elif defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(WEBRTC_ENABLE_AVX2)
+#include "common_audio/fir_filter_avx2.h"
+#endif
 #include "common_audio/fir_filter_sse.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"  // kSSE2, WebRtc_G...
 #endif
@@ -34,6 +37,13 @@ FIRFilter* CreateFirFilter(const float* coefficients,
   FIRFilter* filter = nullptr;
 // If we know the minimum architecture at compile time, avoid CPU detection.
 #if defined(WEBRTC_ARCH_X86_FAMILY)
+#if defined(WEBRTC_ENABLE_AVX2)
+  // AVX2 is never part of the compile-time baseline.
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    return new FIRFilterAVX2(coefficients, coefficients_length,
+                             max_input_length);
+  }
+#endif
 #if defined(__SSE2__)
   filter =
       new FIRFilterSSE2(coefficients, coefficients_length, max_input_length);
@@ -14,9 +14,20 @@
 #include <string.h>
 
 #include <memory>
+#include <vector>
 
+#include "common_audio/fir_filter_c.h"
+#include "rtc_base/system/arch.h"
 #include "test/gtest.h"
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include "common_audio/fir_filter_sse.h"
+#include "system_wrappers/include/cpu_features_wrapper.h"
+#if defined(WEBRTC_ENABLE_AVX2)
+#include "common_audio/fir_filter_avx2.h"
+#endif
+#endif
+
 namespace webrtc {
 namespace {
 
@@ -205,4 +216,43 @@ TEST(FIRFilterTest, SameOutputWhenSwapedCoefficientsAndInput) {
   }
 }
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Verifies that the SIMD implementations match the C implementation for
+// lengths that are not multiples of their vector widths, and across blocks.
+TEST(FIRFilterTest, SimdImplementationsMatchC) {
+  const size_t kLongCoefficientsLength = 37;
+  const size_t kBlockLength = 67;
+  float coefficients[kLongCoefficientsLength];
+  for (size_t i = 0; i < kLongCoefficientsLength; ++i)
+    coefficients[i] = 0.5f / (i + 1);
+  float input[kBlockLength];
+  float expected_output[kBlockLength];
+  float output[kBlockLength];
+
+  std::vector<std::unique_ptr<FIRFilter>> filters;
+  if (WebRtc_GetCPUInfo(kSSE2)) {
+    filters.emplace_back(new FIRFilterSSE2(
+        coefficients, kLongCoefficientsLength, kBlockLength));
+  }
+#if defined(WEBRTC_ENABLE_AVX2)
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    filters.emplace_back(new FIRFilterAVX2(
+        coefficients, kLongCoefficientsLength, kBlockLength));
+  }
+#endif
+
+  for (auto& filter : filters) {
+    FIRFilterC reference(coefficients, kLongCoefficientsLength);
+    for (int block = 0; block < 4; ++block) {
+      for (size_t i = 0; i < kBlockLength; ++i)
+        input[i] = static_cast<float>((block * kBlockLength + i) % 11) - 5.f;
+      reference.Filter(input, kBlockLength, expected_output);
+      filter->Filter(input, kBlockLength, output);
+      for (size_t i = 0; i < kBlockLength; ++i)
+        EXPECT_NEAR(expected_output[i], output[i], 1e-5f);
+    }
+  }
+}
+#endif
+
 }  // namespace webrtc
@@ -18,8 +18,9 @@ namespace webrtc {
 
 class PushSincResampler;
 
-// Wraps PushSincResampler to provide stereo support.
-// TODO(ajm): add support for an arbitrary number of channels.
+// Wraps PushSincResampler to provide support for interleaved audio with an
+// arbitrary number of channels. Each channel is resampled directly from and
+// into the interleaved buffers.
 template <typename T>
 class PushResampler {
  public:
@@ -41,13 +42,7 @@ class PushResampler {
   int dst_sample_rate_hz_;
   size_t num_channels_;
 
-  struct ChannelResampler {
-    std::unique_ptr<PushSincResampler> resampler;
-    std::vector<T> source;
-    std::vector<T> destination;
-  };
-
-  std::vector<ChannelResampler> channel_resamplers_;
+  std::vector<std::unique_ptr<PushSincResampler>> channel_resamplers_;
 };
 }  // namespace webrtc
 
@@ -13,9 +13,7 @@
 #include <stdint.h>
 #include <string.h>
 
-#include "absl/container/inlined_vector.h"
 #include "absl/memory/memory.h"
-#include "common_audio/include/audio_util.h"
 #include "common_audio/resampler/push_sinc_resampler.h"
 #include "rtc_base/checks.h"
 
@@ -91,12 +89,8 @@ int PushResampler<T>::InitializeIfNeeded(int src_sample_rate_hz,
       static_cast<size_t>(dst_sample_rate_hz / 100);
   channel_resamplers_.clear();
   for (size_t i = 0; i < num_channels; ++i) {
-    channel_resamplers_.push_back(ChannelResampler());
-    auto channel_resampler = channel_resamplers_.rbegin();
-    channel_resampler->resampler = absl::make_unique<PushSincResampler>(
-        src_size_10ms_mono, dst_size_10ms_mono);
-    channel_resampler->source.resize(src_size_10ms_mono);
-    channel_resampler->destination.resize(dst_size_10ms_mono);
+    channel_resamplers_.push_back(absl::make_unique<PushSincResampler>(
+        src_size_10ms_mono, dst_size_10ms_mono));
   }
 
   return 0;
@@ -120,27 +114,14 @@ int PushResampler<T>::Resample(const T* src,
   const size_t src_length_mono = src_length / num_channels_;
   const size_t dst_capacity_mono = dst_capacity / num_channels_;
 
-  absl::InlinedVector<T*, 8> source_pointers;
-  for (auto& resampler : channel_resamplers_) {
-    source_pointers.push_back(resampler.source.data());
-  }
-
-  Deinterleave(src, src_length_mono, num_channels_, source_pointers.data());
-
+  // Each channel reads its samples straight from the interleaved |src| and
+  // writes them straight into the interleaved |dst|.
   size_t dst_length_mono = 0;
-
-  for (auto& resampler : channel_resamplers_) {
-    dst_length_mono = resampler.resampler->Resample(
-        resampler.source.data(), src_length_mono, resampler.destination.data(),
-        dst_capacity_mono);
-  }
-
-  absl::InlinedVector<T*, 8> destination_pointers;
-  for (auto& resampler : channel_resamplers_) {
-    destination_pointers.push_back(resampler.destination.data());
+  for (size_t ch = 0; ch < num_channels_; ++ch) {
+    dst_length_mono = channel_resamplers_[ch]->ResampleInterleaved(
+        src + ch, src_length_mono, num_channels_, dst + ch, dst_capacity_mono);
   }
 
-  Interleave(destination_pointers.data(), dst_length_mono, num_channels_, dst);
   return static_cast<int>(dst_length_mono * num_channels_);
 }
 
@@ -8,7 +8,19 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+// MSVC++ requires this to be set before any other includes to get M_PI.
+#define _USE_MATH_DEFINES
+
+#include <math.h>
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "common_audio/include/audio_util.h"
 #include "common_audio/resampler/include/push_resampler.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
 #include "rtc_base/checks.h"  // RTC_DCHECK_IS_ON
 #include "test/gtest.h"
 
@@ -49,4 +61,119 @@ TEST(PushResamplerTest, VerifiesBadInputParameters3) {
 #endif
 #endif
 
+namespace {
+
+// Fills |frames| frames of interleaved audio with a different tone in each
+// channel, continuing from frame |offset|.
+template <typename T>
+void FillInterleaved(size_t offset,
+                     size_t frames,
+                     size_t num_channels,
+                     int sample_rate_hz,
+                     T* buffer) {
+  for (size_t i = 0; i < frames; ++i) {
+    for (size_t ch = 0; ch < num_channels; ++ch) {
+      const double frequency_hz = 200.0 * (ch + 1);
+      buffer[i * num_channels + ch] = static_cast<T>(
+          10000 * sin(2 * M_PI * frequency_hz * (offset + i) / sample_rate_hz));
+    }
+  }
+}
+
+// Resamples interleaved audio the way PushResampler used to: deinterleave into
+// per-channel buffers, resample each of them and interleave the result.
+template <typename T>
+class DeinterleavingResampler {
+ public:
+  DeinterleavingResampler(int src_sample_rate_hz,
+                          int dst_sample_rate_hz,
+                          size_t num_channels)
+      : num_channels_(num_channels),
+        src_frames_(src_sample_rate_hz / 100),
+        dst_frames_(dst_sample_rate_hz / 100),
+        source_(num_channels, std::vector<T>(src_frames_)),
+        destination_(num_channels, std::vector<T>(dst_frames_)) {
+    for (size_t ch = 0; ch < num_channels; ++ch) {
+      resamplers_.push_back(
+          absl::make_unique<PushSincResampler>(src_frames_, dst_frames_));
+    }
+  }
+
+  void Resample(const T* src, T* dst) {
+    std::vector<T*> source_pointers;
+    std::vector<T*> destination_pointers;
+    for (size_t ch = 0; ch < num_channels_; ++ch) {
+      source_pointers.push_back(source_[ch].data());
+      destination_pointers.push_back(destination_[ch].data());
+    }
+    Deinterleave(src, src_frames_, num_channels_, source_pointers.data());
+    for (size_t ch = 0; ch < num_channels_; ++ch) {
+      resamplers_[ch]->Resample(source_[ch].data(), src_frames_,
+                                destination_[ch].data(), dst_frames_);
+    }
+    Interleave(destination_pointers.data(), dst_frames_, num_channels_, dst);
+  }
+
+ private:
+  const size_t num_channels_;
+  const size_t src_frames_;
+  const size_t dst_frames_;
+  std::vector<std::unique_ptr<PushSincResampler>> resamplers_;
+  std::vector<std::vector<T>> source_;
+  std::vector<std::vector<T>> destination_;
+};
+
+template <typename T>
+void ExpectMatchesDeinterleavedResampling(int src_sample_rate_hz,
+                                          int dst_sample_rate_hz,
+                                          size_t num_channels) {
+  const size_t src_frames = src_sample_rate_hz / 100;
+  const size_t dst_frames = dst_sample_rate_hz / 100;
+  PushResampler<T> resampler;
+  ASSERT_EQ(0, resampler.InitializeIfNeeded(src_sample_rate_hz,
+                                            dst_sample_rate_hz, num_channels));
+  DeinterleavingResampler<T> reference(src_sample_rate_hz, dst_sample_rate_hz,
+                                       num_channels);
+
+  std::vector<T> src(src_frames * num_channels);
+  std::vector<T> dst(dst_frames * num_channels);
+  std::vector<T> reference_dst(dst_frames * num_channels);
+  for (size_t frame = 0; frame < 20; ++frame) {
+    FillInterleaved(frame * src_frames, src_frames, num_channels,
+                    src_sample_rate_hz, src.data());
+    EXPECT_EQ(static_cast<int>(dst.size()),
+              resampler.Resample(src.data(), src.size(), dst.data(),
+                                 dst.size()));
+    reference.Resample(src.data(), reference_dst.data());
+    for (size_t i = 0; i < dst.size(); ++i) {
+      ASSERT_EQ(reference_dst[i], dst[i]) << "frame " << frame << " sample "
+                                          << i;
+    }
+  }
+}
+
+// Rates and channel counts used by the interleaved tests.
+const std::tuple<int, int, size_t> kInterleavedConfigs[] = {
+    std::make_tuple(48000, 16000, 2),  std::make_tuple(16000, 48000, 2),
+    std::make_tuple(44100, 48000, 2),  std::make_tuple(48000, 44100, 2),
+    std::make_tuple(48000, 16000, 6),  std::make_tuple(16000, 48000, 6),
+    std::make_tuple(44100, 48000, 6),  std::make_tuple(48000, 44100, 6),
+};
+
+}  // namespace
+
+TEST(PushResamplerTest, InterleavedMatchesDeinterleavedInt16) {
+  for (const auto& config : kInterleavedConfigs) {
+    ExpectMatchesDeinterleavedResampling<int16_t>(
+        std::get<0>(config), std::get<1>(config), std::get<2>(config));
+  }
+}
+
+TEST(PushResamplerTest, InterleavedMatchesDeinterleavedFloat) {
+  for (const auto& config : kInterleavedConfigs) {
+    ExpectMatchesDeinterleavedResampling<float>(
+        std::get<0>(config), std::get<1>(config), std::get<2>(config));
+  }
+}
+
 }  // namespace webrtc
@@ -24,6 +24,9 @@ PushSincResampler::PushSincResampler(size_t source_frames,
                                    this)),
       source_ptr_(nullptr),
       source_ptr_int_(nullptr),
+      source_channels_(nullptr),
+      num_source_channels_(0),
+      source_stride_(1),
       destination_frames_(destination_frames),
       first_pass_(true),
       source_available_(0) {}
@@ -49,6 +52,66 @@ size_t PushSincResampler::Resample(const float* source,
                                    size_t source_length,
                                    float* destination,
                                    size_t destination_capacity) {
+  return ResampleStrided(source, source_length, destination,
+                         destination_capacity, 1);
+}
+
+size_t PushSincResampler::ResampleInterleaved(const int16_t* source,
+                                              size_t source_frames,
+                                              size_t num_channels,
+                                              int16_t* destination,
+                                              size_t destination_capacity) {
+  RTC_DCHECK_GT(num_channels, 0);
+  RTC_CHECK_GE(destination_capacity, destination_frames_);
+  if (!float_buffer_.get())
+    float_buffer_.reset(new float[destination_frames_]);
+
+  source_ptr_int_ = source;
+  source_stride_ = num_channels;
+  // The output goes through |float_buffer_|, which is contiguous.
+  ResampleStrided(nullptr, source_frames, float_buffer_.get(),
+                  destination_frames_, 1);
+  for (size_t i = 0; i < destination_frames_; ++i)
+    destination[i * num_channels] = FloatS16ToS16(float_buffer_[i]);
+  source_ptr_int_ = nullptr;
+  source_stride_ = 1;
+  return destination_frames_;
+}
+
+size_t PushSincResampler::ResampleInterleaved(const float* source,
+                                              size_t source_frames,
+                                              size_t num_channels,
+                                              float* destination,
+                                              size_t destination_capacity) {
+  RTC_DCHECK_GT(num_channels, 0);
+  source_stride_ = num_channels;
+  ResampleStrided(source, source_frames, destination, destination_capacity,
+                  num_channels);
+  source_stride_ = 1;
+  return destination_frames_;
+}
+
+size_t PushSincResampler::ResampleDownmix(const float* const* sources,
+                                          size_t num_sources,
+                                          size_t source_frames,
+                                          float* destination,
+                                          size_t destination_capacity) {
+  RTC_DCHECK_GT(num_sources, 0);
+  source_channels_ = sources;
+  num_source_channels_ = num_sources;
+  // Pass nullptr as the float source to have Run() read from the channels.
+  ResampleStrided(nullptr, source_frames, destination, destination_capacity,
+                  1);
+  source_channels_ = nullptr;
+  num_source_channels_ = 0;
+  return destination_frames_;
+}
+
+size_t PushSincResampler::ResampleStrided(const float* source,
+                                          size_t source_length,
+                                          float* destination,
+                                          size_t destination_capacity,
+                                          size_t stride) {
   RTC_CHECK_EQ(source_length, resampler_->request_frames());
   RTC_CHECK_GE(destination_capacity, destination_frames_);
   // Cache the source pointer. Calling Resample() will immediately trigger
@@ -69,10 +132,13 @@ size_t PushSincResampler::Resample(const float* source,
   // It works out that ChunkSize() is exactly the amount of output we need to
   // request in order to prime the buffer with a single Run() request for
   // |source_frames|.
+  //
+  // The priming output is strided as well so that it never touches the samples
+  // of other channels in an interleaved |destination|.
   if (first_pass_)
-    resampler_->Resample(resampler_->ChunkSize(), destination);
+    resampler_->Resample(resampler_->ChunkSize(), destination, stride);
 
-  resampler_->Resample(destination_frames_, destination);
+  resampler_->Resample(destination_frames_, destination, stride);
   source_ptr_ = nullptr;
   return destination_frames_;
 }
@@ -91,10 +157,22 @@ void PushSincResampler::Run(size_t frames, float* destination) {
   }
 
   if (source_ptr_) {
-    std::memcpy(destination, source_ptr_, frames * sizeof(*destination));
+    if (source_stride_ == 1) {
+      std::memcpy(destination, source_ptr_, frames * sizeof(*destination));
+    } else {
+      for (size_t i = 0; i < frames; ++i)
+        destination[i] = source_ptr_[i * source_stride_];
+    }
+  } else if (source_channels_) {
+    for (size_t i = 0; i < frames; ++i) {
+      float sum = 0;
+      for (size_t j = 0; j < num_source_channels_; ++j)
+        sum += source_channels_[j][i];
+      destination[i] = sum / num_source_channels_;
+    }
   } else {
     for (size_t i = 0; i < frames; ++i)
-      destination[i] = static_cast<float>(source_ptr_int_[i]);
+      destination[i] = static_cast<float>(source_ptr_int_[i * source_stride_]);
   }
   source_available_ -= frames;
 }
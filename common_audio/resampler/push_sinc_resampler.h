@@ -46,6 +46,33 @@ class PushSincResampler : public SincResamplerCallback {
                   float* destination,
                   size_t destination_capacity);
 
+  // Same as Resample(), but for one channel of interleaved audio with
+  // |num_channels| channels. |source| and |destination| point to the first
+  // sample of the channel, and |source_frames| and |destination_capacity| are
+  // counted in frames per channel. Only the samples of this channel are read
+  // and written, so all channels of a buffer can be resampled in place without
+  // deinterleaving.
+  size_t ResampleInterleaved(const int16_t* source,
+                             size_t source_frames,
+                             size_t num_channels,
+                             int16_t* destination,
+                             size_t destination_capacity);
+  size_t ResampleInterleaved(const float* source,
+                             size_t source_frames,
+                             size_t num_channels,
+                             float* destination,
+                             size_t destination_capacity);
+
+  // Same as Resample(), but the input is the average of the |num_sources|
+  // channels in |sources|, each holding |source_frames| samples. The average
+  // is computed directly into the resampler's input buffer, so downmixing and
+  // resampling are done in a single pass without an intermediate buffer.
+  size_t ResampleDownmix(const float* const* sources,
+                         size_t num_sources,
+                         size_t source_frames,
+                         float* destination,
+                         size_t destination_capacity);
+
   // Delay due to the filter kernel. Essentially, the time after which an input
   // sample will appear in the resampled output.
   static float AlgorithmicDelaySeconds(int source_rate_hz) {
@@ -60,10 +87,22 @@ class PushSincResampler : public SincResamplerCallback {
   friend class PushSincResamplerTest;
   SincResampler* get_resampler_for_testing() { return resampler_.get(); }
 
+  size_t ResampleStrided(const float* source,
+                         size_t source_frames,
+                         float* destination,
+                         size_t destination_capacity,
+                         size_t stride);
+
   std::unique_ptr<SincResampler> resampler_;
   std::unique_ptr<float[]> float_buffer_;
   const float* source_ptr_;
   const int16_t* source_ptr_int_;
+  // Channels to average when set by ResampleDownmix().
+  const float* const* source_channels_;
+  size_t num_source_channels_;
+  // Distance in samples between consecutive frames of |source_ptr_| or
+  // |source_ptr_int_|.
+  size_t source_stride_;
   const size_t destination_frames_;
 
   // True on the first call to Resample(), to prime the SincResampler buffer.
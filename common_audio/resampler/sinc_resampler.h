@@ -66,6 +66,10 @@ class SincResampler {
   // Resample |frames| of data from |read_cb_| into |destination|.
   void Resample(size_t frames, float* destination);
 
+  // Same as above, but writes the output frames |destination_stride| samples
+  // apart.  Used to resample one channel directly into interleaved audio.
+  void Resample(size_t frames, float* destination, size_t destination_stride);
+
   // The maximum size in frames that guarantees Resample() will only make a
   // single call to |read_cb_| for more data.
   size_t ChunkSize() const;
@@ -89,6 +93,8 @@ class SincResampler {
  private:
   FRIEND_TEST_ALL_PREFIXES(SincResamplerTest, Convolve);
   FRIEND_TEST_ALL_PREFIXES(SincResamplerTest, ConvolveBenchmark);
+  FRIEND_TEST_ALL_PREFIXES(SincResamplerTest, ConvolveAvx2);
+  FRIEND_TEST_ALL_PREFIXES(SincResamplerTest, ConvolveAvx2Benchmark);
 
   void InitializeKernel();
   void UpdateRegions(bool second_load);
@@ -111,6 +117,12 @@ class SincResampler {
                             const float* k1,
                             const float* k2,
                             double kernel_interpolation_factor);
+#if defined(WEBRTC_ENABLE_AVX2)
+  static float Convolve_AVX2(const float* input_ptr,
+                             const float* k1,
+                             const float* k2,
+                             double kernel_interpolation_factor);
+#endif
 #elif defined(WEBRTC_HAS_NEON)
   static float Convolve_NEON(const float* input_ptr,
                              const float* k1,
@@ -154,7 +166,8 @@ class SincResampler {
 // TODO(ajm): Move to using a global static which must only be initialized
 // once by the user. We're not doing this initially, because we don't have
 // e.g. a LazyInstance helper in webrtc.
-#if defined(WEBRTC_ARCH_X86_FAMILY) && !defined(__SSE2__)
+#if defined(WEBRTC_ARCH_X86_FAMILY) && \
+    (!defined(__SSE2__) || defined(WEBRTC_ENABLE_AVX2))
   typedef float (*ConvolveProc)(const float*,
                                 const float*,
                                 const float*,
@@ -19,7 +19,11 @@
 #include <algorithm>
 #include <memory>
 #include <tuple>
+#include <vector>
 
+#include "absl/memory/memory.h"
+#include "common_audio/include/audio_util.h"
+#include "common_audio/resampler/push_sinc_resampler.h"
 #include "common_audio/resampler/sinc_resampler.h"
 #include "common_audio/resampler/sinusoidal_linear_chirp_source.h"
 #include "rtc_base/stringize_macros.h"
@@ -229,6 +233,191 @@ TEST(SincResamplerTest, ConvolveBenchmark) {
 
 #undef CONVOLVE_FUNC
 
+#if defined(WEBRTC_ARCH_X86_FAMILY) && defined(WEBRTC_ENABLE_AVX2)
+// Ensure Convolve_AVX2() returns the same value as Convolve_C() when the CPU
+// supports it.
+TEST(SincResamplerTest, ConvolveAvx2) {
+  if (!WebRtc_GetCPUInfo(kAVX2)) {
+    printf("Skipping, AVX2 not supported.\n");
+    return;
+  }
+
+  MockSource mock_source;
+  SincResampler resampler(kSampleRateRatio, SincResampler::kDefaultRequestSize,
+                          &mock_source);
+
+  // Convolve_AVX2() uses fused multiply-adds and a different summation order.
+  static const double kEpsilon = 0.0000001;
+
+  double result = resampler.Convolve_C(
+      resampler.kernel_storage_.get(), resampler.kernel_storage_.get(),
+      resampler.kernel_storage_.get(), kKernelInterpolationFactor);
+  double result2 = resampler.Convolve_AVX2(
+      resampler.kernel_storage_.get(), resampler.kernel_storage_.get(),
+      resampler.kernel_storage_.get(), kKernelInterpolationFactor);
+  EXPECT_NEAR(result2, result, kEpsilon);
+
+  // Test with input pointers that are 16-byte but not 32-byte aligned, and
+  // not aligned at all.
+  for (size_t offset : {1, 4}) {
+    result = resampler.Convolve_C(resampler.kernel_storage_.get() + offset,
+                                  resampler.kernel_storage_.get(),
+                                  resampler.kernel_storage_.get(),
+                                  kKernelInterpolationFactor);
+    result2 = resampler.Convolve_AVX2(resampler.kernel_storage_.get() + offset,
+                                      resampler.kernel_storage_.get(),
+                                      resampler.kernel_storage_.get(),
+                                      kKernelInterpolationFactor);
+    EXPECT_NEAR(result2, result, kEpsilon);
+  }
+}
+
+TEST(SincResamplerTest, ConvolveAvx2Benchmark) {
+  if (!WebRtc_GetCPUInfo(kAVX2)) {
+    printf("Skipping, AVX2 not supported.\n");
+    return;
+  }
+
+  MockSource mock_source;
+  SincResampler resampler(kSampleRateRatio, SincResampler::kDefaultRequestSize,
+                          &mock_source);
+  const int kConvolveIterations = 1000000;
+
+  int64_t start = rtc::TimeNanos();
+  for (int i = 0; i < kConvolveIterations; ++i) {
+    resampler.Convolve_SSE(
+        resampler.kernel_storage_.get() + 1, resampler.kernel_storage_.get(),
+        resampler.kernel_storage_.get(), kKernelInterpolationFactor);
+  }
+  double total_time_sse_us =
+      (rtc::TimeNanos() - start) / rtc::kNumNanosecsPerMicrosec;
+
+  start = rtc::TimeNanos();
+  for (int i = 0; i < kConvolveIterations; ++i) {
+    resampler.Convolve_AVX2(
+        resampler.kernel_storage_.get() + 1, resampler.kernel_storage_.get(),
+        resampler.kernel_storage_.get(), kKernelInterpolationFactor);
+  }
+  double total_time_avx2_us =
+      (rtc::TimeNanos() - start) / rtc::kNumNanosecsPerMicrosec;
+  printf("Convolve_AVX2 (unaligned) took %.2fms; which is %.2fx faster than "
+         "Convolve_SSE (unaligned).\n",
+         total_time_avx2_us / 1000, total_time_sse_us / total_time_avx2_us);
+}
+#endif
+
+// Resampling into a strided destination must produce exactly the same samples
+// as resampling into a contiguous one.
+TEST(SincResamplerTest, StridedResample) {
+  static const size_t kFrames = 480;
+  static const size_t kStride = 6;
+  const double io_ratio = 44100.0 / 48000.0;
+
+  SinusoidalLinearChirpSource source(44100, 44100, 22050.0, 0);
+  SincResampler resampler(io_ratio, SincResampler::kDefaultRequestSize,
+                          &source);
+  SinusoidalLinearChirpSource strided_source(44100, 44100, 22050.0, 0);
+  SincResampler strided_resampler(
+      io_ratio, SincResampler::kDefaultRequestSize, &strided_source);
+
+  std::unique_ptr<float[]> destination(new float[kFrames]);
+  std::unique_ptr<float[]> strided_destination(new float[kFrames * kStride]);
+  for (int i = 0; i < 10; ++i) {
+    std::fill(strided_destination.get(),
+              strided_destination.get() + kFrames * kStride, -1.f);
+    resampler.Resample(kFrames, destination.get());
+    strided_resampler.Resample(kFrames, strided_destination.get() + 1, kStride);
+    for (size_t j = 0; j < kFrames; ++j) {
+      ASSERT_EQ(destination[j], strided_destination[j * kStride + 1]);
+      ASSERT_EQ(-1.f, strided_destination[j * kStride]);
+    }
+  }
+}
+
+// Compares resampling interleaved stereo and 5.1 audio one channel at a time,
+// reading and writing it in place, with deinterleaving it first and
+// interleaving the result. Disabled because it takes too long to run
+// routinely. Use for performance benchmarking when needed.
+TEST(SincResamplerTest, DISABLED_InterleavedBenchmark) {
+  static const int kIterations = 20000;
+  static const struct {
+    int src_sample_rate_hz;
+    int dst_sample_rate_hz;
+    size_t num_channels;
+  } kConfigs[] = {
+      {48000, 16000, 2}, {16000, 48000, 2}, {44100, 48000, 2},
+      {48000, 44100, 2}, {48000, 16000, 6}, {16000, 48000, 6},
+      {44100, 48000, 6}, {48000, 44100, 6},
+  };
+  for (const auto& config : kConfigs) {
+    const size_t num_channels = config.num_channels;
+    const size_t src_frames = config.src_sample_rate_hz / 100;
+    const size_t dst_frames = config.dst_sample_rate_hz / 100;
+    std::vector<float> src(src_frames * num_channels);
+    std::vector<float> dst(dst_frames * num_channels);
+    for (size_t i = 0; i < src.size(); ++i) {
+      const double frequency_hz = 200.0 * (i % num_channels + 1);
+      src[i] = static_cast<float>(
+          10000 * sin(2 * M_PI * frequency_hz * (i / num_channels) /
+                      config.src_sample_rate_hz));
+    }
+    std::vector<std::unique_ptr<PushSincResampler>> resamplers;
+    std::vector<std::vector<float>> src_channels;
+    std::vector<std::vector<float>> dst_channels;
+    std::vector<float*> src_pointers;
+    std::vector<float*> dst_pointers;
+    for (size_t ch = 0; ch < num_channels; ++ch) {
+      resamplers.push_back(
+          absl::make_unique<PushSincResampler>(src_frames, dst_frames));
+      src_channels.emplace_back(src_frames);
+      dst_channels.emplace_back(dst_frames);
+    }
+    for (size_t ch = 0; ch < num_channels; ++ch) {
+      src_pointers.push_back(src_channels[ch].data());
+      dst_pointers.push_back(dst_channels[ch].data());
+    }
+
+    int64_t start = rtc::TimeNanos();
+    for (int i = 0; i < kIterations; ++i) {
+      Deinterleave(src.data(), src_frames, num_channels, src_pointers.data());
+      for (size_t ch = 0; ch < num_channels; ++ch) {
+        resamplers[ch]->Resample(src_pointers[ch], src_frames,
+                                 dst_pointers[ch], dst_frames);
+      }
+      Interleave(dst_pointers.data(), dst_frames, num_channels, dst.data());
+    }
+    const double deinterleaved_us =
+        (rtc::TimeNanos() - start) / rtc::kNumNanosecsPerMicrosec;
+
+    start = rtc::TimeNanos();
+    for (int i = 0; i < kIterations; ++i) {
+      for (size_t ch = 0; ch < num_channels; ++ch) {
+        resamplers[ch]->ResampleInterleaved(&src[ch], src_frames, num_channels,
+                                            &dst[ch], dst_frames);
+      }
+    }
+    const double interleaved_us =
+        (rtc::TimeNanos() - start) / rtc::kNumNanosecsPerMicrosec;
+
+    printf("%d Hz -> %d Hz, %zu channels: %.2f us per 10 ms interleaved, "
+           "%.2f us deinterleaved (%.2fx).\n",
+           config.src_sample_rate_hz, config.dst_sample_rate_hz, num_channels,
+           interleaved_us / kIterations, deinterleaved_us / kIterations,
+           deinterleaved_us / interleaved_us);
+  }
+}
+
+// Convolve_AVX2() fuses the multiply-adds, which moves the low frequency error
+// of some conversions by about 1e-4 dbFS. The thresholds below were chosen with
+// the other kernels, so allow for that only when the AVX2 kernel is selected.
+static double LowFrequencyErrorTolerance() {
+#if defined(WEBRTC_ARCH_X86_FAMILY) && defined(WEBRTC_ENABLE_AVX2)
+  if (WebRtc_GetCPUInfo(kAVX2))
+    return 0.01;
+#endif
+  return 0.0;
+}
+
 typedef std::tuple<int, int, double, double> SincResamplerTestData;
 class SincResamplerTest
     : public ::testing::TestWithParam<SincResamplerTestData> {
@@ -329,7 +518,7 @@ TEST_P(SincResamplerTest, Resample) {
   high_freq_max_error = DBFS(high_freq_max_error);
 
   EXPECT_LE(rms_error, rms_error_);
-  EXPECT_LE(low_freq_max_error, low_freq_error_);
+  EXPECT_LE(low_freq_max_error, low_freq_error_ + LowFrequencyErrorTolerance());
 
   // All conversions currently have a high frequency error around -6 dbFS.
   static const double kHighFrequencyMaxError = -6.02;
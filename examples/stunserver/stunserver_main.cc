@@ -9,17 +9,20 @@
  */
 #include <iostream>
 
+#include "p2p/base/sharded_stun_server.h"
 #include "p2p/base/stun_server.h"
 #include "rtc_base/async_udp_socket.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/socket_server.h"
+#include "rtc_base/string_to_number.h"
 #include "rtc_base/thread.h"
 
+using cricket::ShardedStunServer;
 using cricket::StunServer;
 
 int main(int argc, char* argv[]) {
-  if (argc != 2) {
-    std::cerr << "usage: stunserver address" << std::endl;
+  if (argc != 2 && argc != 3) {
+    std::cerr << "usage: stunserver address [shards]" << std::endl;
     return 1;
   }
 
@@ -31,6 +34,28 @@ int main(int argc, char* argv[]) {
 
   rtc::Thread* pthMain = rtc::Thread::Current();
 
+  // With a shard count, only RFC 5389 binding requests are answered, on as
+  // many threads.
+  if (argc == 3) {
+    absl::optional<int> num_shards = rtc::StringToNumber<int>(argv[2]);
+    if (!num_shards || *num_shards <= 0) {
+      std::cerr << "Invalid number of shards: " << argv[2] << std::endl;
+      return 1;
+    }
+    ShardedStunServer::Config config;
+    config.address = server_addr;
+    config.num_shards = *num_shards;
+    ShardedStunServer sharded_server(config);
+    if (!sharded_server.Start()) {
+      std::cerr << "Failed to start the STUN server shards" << std::endl;
+      return 1;
+    }
+    std::cout << "Listening at " << sharded_server.address().ToString()
+              << " with " << *num_shards << " shards" << std::endl;
+    pthMain->Run();
+    return 0;
+  }
+
   rtc::AsyncUDPSocket* server_socket =
       rtc::AsyncUDPSocket::Create(pthMain->socketserver(), server_addr);
   if (!server_socket) {
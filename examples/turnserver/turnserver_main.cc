@@ -26,6 +26,8 @@
 
 namespace {
 const char kSoftware[] = "libjingle TurnServer";
+// Datagrams read from the internal socket per read event.
+const size_t kMaxBatchedReads = 16;
 
 class TurnFileAuth : public cricket::TurnAuthInterface {
  public:
@@ -77,6 +79,8 @@ int main(int argc, char* argv[]) {
               << std::endl;
     return 1;
   }
+  // All clients share this socket, so read and relay to them in batches.
+  int_socket->EnableBatchedReads(kMaxBatchedReads);
 
   cricket::TurnServer server(main);
   std::fstream auth_file(argv[4], std::fstream::in);
@@ -87,6 +91,7 @@ int main(int argc, char* argv[]) {
   server.set_realm(argv[3]);
   server.set_software(kSoftware);
   server.set_auth_hook(&auth);
+  server.set_enable_batched_relay(true);
   server.AddInternalSocket(int_socket, cricket::PROTO_UDP);
   server.SetExternalSocketFactory(new rtc::BasicPacketSocketFactory(),
                                   rtc::SocketAddress(ext_addr, 0));
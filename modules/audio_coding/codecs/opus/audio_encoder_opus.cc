@@ -21,6 +21,7 @@
 #include "modules/audio_coding/audio_network_adaptor/controller_manager.h"
 #include "modules/audio_coding/codecs/opus/audio_coder_opus_common.h"
 #include "modules/audio_coding/codecs/opus/opus_interface.h"
+#include "modules/audio_coding/codecs/opus/opus_state_pool.h"
 #include "rtc_base/arraysize.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
@@ -471,7 +472,7 @@ AudioEncoderOpusImpl::AudioEncoderOpusImpl(int payload_type,
     : AudioEncoderOpusImpl(*SdpToConfig(format), payload_type) {}
 
 AudioEncoderOpusImpl::~AudioEncoderOpusImpl() {
-  RTC_CHECK_EQ(0, WebRtcOpus_EncoderFree(inst_));
+  RTC_CHECK_EQ(0, OpusStatePool::Default()->FreeEncoder(inst_));
 }
 
 int AudioEncoderOpusImpl::SampleRateHz() const {
@@ -744,10 +745,10 @@ bool AudioEncoderOpusImpl::RecreateEncoderInstance(
     return false;
   config_ = config;
   if (inst_)
-    RTC_CHECK_EQ(0, WebRtcOpus_EncoderFree(inst_));
+    RTC_CHECK_EQ(0, OpusStatePool::Default()->FreeEncoder(inst_));
   input_buffer_.clear();
   input_buffer_.reserve(Num10msFramesPerPacket() * SamplesPer10msFrame());
-  RTC_CHECK_EQ(0, WebRtcOpus_EncoderCreate(
+  RTC_CHECK_EQ(0, OpusStatePool::Default()->CreateEncoder(
                       &inst_, config.num_channels,
                       config.application ==
                               AudioEncoderOpusConfig::ApplicationMode::kVoip
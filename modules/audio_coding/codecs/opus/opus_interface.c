@@ -138,6 +138,32 @@ int16_t WebRtcOpus_EncoderFree(OpusEncInst* inst) {
   }
 }
 
+int16_t WebRtcOpus_EncoderReinit(OpusEncInst* inst, int32_t application) {
+  int opus_app;
+  if (!inst || !inst->encoder)
+    return -1;
+
+  switch (application) {
+    case 0:
+      opus_app = OPUS_APPLICATION_VOIP;
+      break;
+    case 1:
+      opus_app = OPUS_APPLICATION_AUDIO;
+      break;
+    default:
+      return -1;
+  }
+
+  // opus_encoder_init() restores both the codec state and all settings to
+  // their defaults, without reallocating the state memory.
+  if (opus_encoder_init(inst->encoder, 48000, (int)inst->channels,
+                        opus_app) != OPUS_OK) {
+    return -1;
+  }
+  inst->in_dtx_mode = 0;
+  return 0;
+}
+
 int WebRtcOpus_Encode(OpusEncInst* inst,
                       const int16_t* audio_in,
                       size_t samples,
@@ -458,6 +484,19 @@ int16_t WebRtcOpus_DecoderFree(OpusDecInst* inst) {
   }
 }
 
+int16_t WebRtcOpus_DecoderReinit(OpusDecInst* inst) {
+  if (!inst || !inst->decoder)
+    return -1;
+
+  if (opus_decoder_init(inst->decoder, 48000, (int)inst->channels) !=
+      OPUS_OK) {
+    return -1;
+  }
+  inst->prev_decoded_samples = kWebRtcOpusDefaultFrameSize;
+  inst->in_dtx_mode = 0;
+  return 0;
+}
+
 size_t WebRtcOpus_DecoderChannels(OpusDecInst* inst) {
   return inst->channels;
 }
@@ -81,6 +81,26 @@ int16_t WebRtcOpus_MultistreamEncoderCreate(
 
 int16_t WebRtcOpus_EncoderFree(OpusEncInst* inst);
 
+/****************************************************************************
+ * WebRtcOpus_EncoderReinit(...)
+ *
+ * This function reinitializes an encoder created by WebRtcOpus_EncoderCreate,
+ * discarding its state and all settings, so that it behaves exactly like a
+ * newly created encoder with the same number of channels. Multistream
+ * encoders are not supported.
+ *
+ * Input:
+ *      - inst               : Encoder context
+ *      - application        : 0 - VOIP applications.
+ *                                 Favor speech intelligibility.
+ *                             1 - Audio applications.
+ *                                 Favor faithfulness to the original input.
+ *
+ * Return value              :  0 - Success
+ *                             -1 - Error
+ */
+int16_t WebRtcOpus_EncoderReinit(OpusEncInst* inst, int32_t application);
+
 /****************************************************************************
  * WebRtcOpus_Encode(...)
  *
@@ -359,6 +379,22 @@ int16_t WebRtcOpus_MultistreamDecoderCreate(
 
 int16_t WebRtcOpus_DecoderFree(OpusDecInst* inst);
 
+/****************************************************************************
+ * WebRtcOpus_DecoderReinit(...)
+ *
+ * This function reinitializes a decoder created by WebRtcOpus_DecoderCreate,
+ * discarding its state and all settings, so that it behaves exactly like a
+ * newly created decoder with the same number of channels. Multistream
+ * decoders are not supported.
+ *
+ * Input:
+ *      - inst               : Decoder context
+ *
+ * Return value              :  0 - Success
+ *                             -1 - Error
+ */
+int16_t WebRtcOpus_DecoderReinit(OpusDecInst* inst);
+
 /****************************************************************************
  * WebRtcOpus_DecoderChannels(...)
  *
@@ -0,0 +1,162 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/codecs/opus/opus_state_pool.h"
+
+#include <stdio.h>
+
+#include <string>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "system_wrappers/include/field_trial.h"
+
+namespace webrtc {
+
+namespace {
+
+constexpr char kOpusStatePoolFieldTrial[] = "WebRTC-Audio-OpusStatePool";
+constexpr int kDefaultMaxPooledStates = 32;
+
+size_t GetMaxPooledStates() {
+  if (!field_trial::IsEnabled(kOpusStatePoolFieldTrial))
+    return 0;
+  const std::string field_trial_string =
+      field_trial::FindFullName(kOpusStatePoolFieldTrial);
+  int value = kDefaultMaxPooledStates;
+  if (sscanf(field_trial_string.c_str(), "Enabled-%d", &value) == 1 &&
+      value < 0) {
+    RTC_LOG(LS_WARNING) << "Invalid parameter for " << kOpusStatePoolFieldTrial
+                        << ", using default value: "
+                        << kDefaultMaxPooledStates;
+    value = kDefaultMaxPooledStates;
+  }
+  return static_cast<size_t>(value);
+}
+
+bool IsPoolableChannelCount(size_t channels) {
+  return channels == 1 || channels == 2;
+}
+
+}  // namespace
+
+OpusStatePool* OpusStatePool::Default() {
+  static OpusStatePool* const pool = new OpusStatePool(GetMaxPooledStates());
+  return pool;
+}
+
+OpusStatePool::OpusStatePool(size_t max_pooled_states)
+    : max_pooled_states_(max_pooled_states) {}
+
+OpusStatePool::~OpusStatePool() {
+  Clear();
+}
+
+int16_t OpusStatePool::CreateEncoder(OpusEncInst** inst,
+                                     size_t channels,
+                                     int32_t application) {
+  if (!inst)
+    return -1;
+  OpusEncInst* state = nullptr;
+  if (IsPoolableChannelCount(channels)) {
+    rtc::CritScope lock(&crit_);
+    std::vector<OpusEncInst*>& pooled = encoders_[channels - 1];
+    if (!pooled.empty()) {
+      state = pooled.back();
+      pooled.pop_back();
+    }
+  }
+  if (state) {
+    if (WebRtcOpus_EncoderReinit(state, application) == 0) {
+      *inst = state;
+      return 0;
+    }
+    // Most likely an invalid |application|; let the regular create path
+    // report the error.
+    WebRtcOpus_EncoderFree(state);
+  }
+  return WebRtcOpus_EncoderCreate(inst, channels, application);
+}
+
+int16_t OpusStatePool::FreeEncoder(OpusEncInst* inst) {
+  if (!inst)
+    return -1;
+  if (inst->encoder && IsPoolableChannelCount(inst->channels)) {
+    rtc::CritScope lock(&crit_);
+    std::vector<OpusEncInst*>& pooled = encoders_[inst->channels - 1];
+    if (pooled.size() < max_pooled_states_) {
+      pooled.push_back(inst);
+      return 0;
+    }
+  }
+  return WebRtcOpus_EncoderFree(inst);
+}
+
+int16_t OpusStatePool::CreateDecoder(OpusDecInst** inst, size_t channels) {
+  if (!inst)
+    return -1;
+  OpusDecInst* state = nullptr;
+  if (IsPoolableChannelCount(channels)) {
+    rtc::CritScope lock(&crit_);
+    std::vector<OpusDecInst*>& pooled = decoders_[channels - 1];
+    if (!pooled.empty()) {
+      state = pooled.back();
+      pooled.pop_back();
+    }
+  }
+  if (state) {
+    if (WebRtcOpus_DecoderReinit(state) == 0) {
+      *inst = state;
+      return 0;
+    }
+    WebRtcOpus_DecoderFree(state);
+  }
+  return WebRtcOpus_DecoderCreate(inst, channels);
+}
+
+int16_t OpusStatePool::FreeDecoder(OpusDecInst* inst) {
+  if (!inst)
+    return -1;
+  if (inst->decoder && IsPoolableChannelCount(inst->channels)) {
+    rtc::CritScope lock(&crit_);
+    std::vector<OpusDecInst*>& pooled = decoders_[inst->channels - 1];
+    if (pooled.size() < max_pooled_states_) {
+      pooled.push_back(inst);
+      return 0;
+    }
+  }
+  return WebRtcOpus_DecoderFree(inst);
+}
+
+void OpusStatePool::Clear() {
+  rtc::CritScope lock(&crit_);
+  for (std::vector<OpusEncInst*>& pooled : encoders_) {
+    for (OpusEncInst* inst : pooled)
+      RTC_CHECK_EQ(0, WebRtcOpus_EncoderFree(inst));
+    pooled.clear();
+  }
+  for (std::vector<OpusDecInst*>& pooled : decoders_) {
+    for (OpusDecInst* inst : pooled)
+      RTC_CHECK_EQ(0, WebRtcOpus_DecoderFree(inst));
+    pooled.clear();
+  }
+}
+
+size_t OpusStatePool::pooled_encoders() const {
+  rtc::CritScope lock(&crit_);
+  return encoders_[0].size() + encoders_[1].size();
+}
+
+size_t OpusStatePool::pooled_decoders() const {
+  rtc::CritScope lock(&crit_);
+  return decoders_[0].size() + decoders_[1].size();
+}
+
+}  // namespace webrtc
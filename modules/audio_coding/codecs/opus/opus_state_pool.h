@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_CODING_CODECS_OPUS_OPUS_STATE_POOL_H_
+#define MODULES_AUDIO_CODING_CODECS_OPUS_OPUS_STATE_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "modules/audio_coding/codecs/opus/opus_interface.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Keeps freed mono and stereo libopus encoder and decoder states, and hands
+// them out again, reinitialized, instead of allocating new ones. A reused
+// state behaves exactly like a newly created one. This avoids the allocation
+// and teardown cost when many streams are created and destroyed in a short
+// time. Multistream states are never pooled. The class is thread-safe.
+class OpusStatePool {
+ public:
+  // Returns the pool used by AudioEncoderOpusImpl and AudioDecoderOpusImpl.
+  // The pool is disabled (holds no states) unless the
+  // "WebRTC-Audio-OpusStatePool" field trial is enabled. Its capacity can be
+  // set with "Enabled-<max states per kind and channel count>".
+  static OpusStatePool* Default();
+
+  // Keeps at most |max_pooled_states| freed states for each of mono encoders,
+  // stereo encoders, mono decoders and stereo decoders. A value of zero
+  // disables pooling.
+  explicit OpusStatePool(size_t max_pooled_states);
+  ~OpusStatePool();
+
+  // Same contracts as WebRtcOpus_EncoderCreate and WebRtcOpus_EncoderFree.
+  int16_t CreateEncoder(OpusEncInst** inst,
+                        size_t channels,
+                        int32_t application);
+  int16_t FreeEncoder(OpusEncInst* inst);
+
+  // Same contracts as WebRtcOpus_DecoderCreate and WebRtcOpus_DecoderFree.
+  int16_t CreateDecoder(OpusDecInst** inst, size_t channels);
+  int16_t FreeDecoder(OpusDecInst* inst);
+
+  // Frees all pooled states.
+  void Clear();
+
+  size_t pooled_encoders() const;
+  size_t pooled_decoders() const;
+
+ private:
+  const size_t max_pooled_states_;
+  rtc::CriticalSection crit_;
+  // Indexed by the number of channels minus one.
+  std::vector<OpusEncInst*> encoders_[2] RTC_GUARDED_BY(crit_);
+  std::vector<OpusDecInst*> decoders_[2] RTC_GUARDED_BY(crit_);
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(OpusStatePool);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_CODING_CODECS_OPUS_OPUS_STATE_POOL_H_
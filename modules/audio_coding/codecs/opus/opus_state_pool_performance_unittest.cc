@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include "modules/audio_coding/codecs/opus/opus_inst.h"
+#include "modules/audio_coding/codecs/opus/opus_interface.h"
+#include "modules/audio_coding/codecs/opus/opus_state_pool.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+
+namespace {
+
+// Simulates join/leave storms: |kStreams| states are created and then all of
+// them are freed again, |kRounds| times.
+constexpr int kStreams = 200;
+constexpr int kRounds = 50;
+constexpr int kMaxPooledStates = kStreams;
+
+// Returns the average time in microseconds for one create/free cycle.
+double MeasureEncoderCycleUs(OpusStatePool* pool, size_t channels) {
+  std::vector<OpusEncInst*> encoders(kStreams);
+  const int64_t start_us = rtc::TimeMicros();
+  for (int round = 0; round < kRounds; ++round) {
+    for (OpusEncInst*& inst : encoders)
+      EXPECT_EQ(0, pool->CreateEncoder(&inst, channels, 0));
+    for (OpusEncInst* inst : encoders)
+      EXPECT_EQ(0, pool->FreeEncoder(inst));
+  }
+  return static_cast<double>(rtc::TimeMicros() - start_us) /
+         (kRounds * kStreams);
+}
+
+double MeasureDecoderCycleUs(OpusStatePool* pool, size_t channels) {
+  std::vector<OpusDecInst*> decoders(kStreams);
+  const int64_t start_us = rtc::TimeMicros();
+  for (int round = 0; round < kRounds; ++round) {
+    for (OpusDecInst*& inst : decoders)
+      EXPECT_EQ(0, pool->CreateDecoder(&inst, channels));
+    for (OpusDecInst* inst : decoders)
+      EXPECT_EQ(0, pool->FreeDecoder(inst));
+  }
+  return static_cast<double>(rtc::TimeMicros() - start_us) /
+         (kRounds * kStreams);
+}
+
+std::string ChannelsLabel(size_t channels) {
+  return channels == 1 ? "mono" : "stereo";
+}
+
+}  // namespace
+
+TEST(OpusStatePoolPerformanceTest, EncoderCreateAndFree) {
+  for (size_t channels : {1u, 2u}) {
+    OpusStatePool no_pool(0);
+    OpusStatePool pool(kMaxPooledStates);
+    test::PrintResult("opus_encoder_create_free", "_no_pool",
+                      ChannelsLabel(channels),
+                      MeasureEncoderCycleUs(&no_pool, channels), "us", false);
+    test::PrintResult("opus_encoder_create_free", "_pool",
+                      ChannelsLabel(channels),
+                      MeasureEncoderCycleUs(&pool, channels), "us", false);
+    // Memory kept alive by each pooled state, excluding the small wrapper.
+    test::PrintResult("opus_encoder_state_size", "", ChannelsLabel(channels),
+                      opus_encoder_get_size(static_cast<int>(channels)),
+                      "bytes", false);
+  }
+}
+
+TEST(OpusStatePoolPerformanceTest, DecoderCreateAndFree) {
+  for (size_t channels : {1u, 2u}) {
+    OpusStatePool no_pool(0);
+    OpusStatePool pool(kMaxPooledStates);
+    test::PrintResult("opus_decoder_create_free", "_no_pool",
+                      ChannelsLabel(channels),
+                      MeasureDecoderCycleUs(&no_pool, channels), "us", false);
+    test::PrintResult("opus_decoder_create_free", "_pool",
+                      ChannelsLabel(channels),
+                      MeasureDecoderCycleUs(&pool, channels), "us", false);
+    test::PrintResult("opus_decoder_state_size", "", ChannelsLabel(channels),
+                      opus_decoder_get_size(static_cast<int>(channels)),
+                      "bytes", false);
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,153 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/codecs/opus/opus_state_pool.h"
+
+#include <vector>
+
+#include "modules/audio_coding/codecs/opus/opus_inst.h"
+#include "modules/audio_coding/codecs/opus/opus_interface.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+
+constexpr size_t kFrameSamples = 960;  // 20 ms at 48 kHz.
+constexpr size_t kMaxBytes = 1000;
+
+// Encodes a few frames of a synthetic signal with |inst| after applying some
+// non-default settings, and returns the concatenated payloads.
+std::vector<uint8_t> EncodeTestSignal(OpusEncInst* inst, size_t channels) {
+  EXPECT_EQ(0, WebRtcOpus_SetBitRate(inst, 24000));
+  EXPECT_EQ(0, WebRtcOpus_SetComplexity(inst, 5));
+  std::vector<int16_t> audio(kFrameSamples * channels);
+  std::vector<uint8_t> result;
+  uint8_t encoded[kMaxBytes];
+  for (int frame = 0; frame < 10; ++frame) {
+    for (size_t i = 0; i < audio.size(); ++i) {
+      const int n = static_cast<int>(i) + frame * 37;
+      audio[i] = static_cast<int16_t>((n * 263) % 8000 - 4000);
+    }
+    const int bytes = WebRtcOpus_Encode(inst, audio.data(), kFrameSamples,
+                                        kMaxBytes, encoded);
+    EXPECT_GE(bytes, 0);
+    result.insert(result.end(), encoded, encoded + bytes);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(OpusStatePoolTest, ReusesFreedEncoder) {
+  OpusStatePool pool(1);
+  OpusEncInst* first = nullptr;
+  ASSERT_EQ(0, pool.CreateEncoder(&first, 2, 1));
+  ASSERT_EQ(0, pool.FreeEncoder(first));
+  EXPECT_EQ(1u, pool.pooled_encoders());
+
+  // A mono encoder cannot reuse the stereo state.
+  OpusEncInst* mono = nullptr;
+  ASSERT_EQ(0, pool.CreateEncoder(&mono, 1, 1));
+  EXPECT_NE(first, mono);
+  EXPECT_EQ(1u, pool.pooled_encoders());
+
+  OpusEncInst* second = nullptr;
+  ASSERT_EQ(0, pool.CreateEncoder(&second, 2, 0));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(0u, pool.pooled_encoders());
+  EXPECT_EQ(0, pool.FreeEncoder(second));
+  EXPECT_EQ(0, pool.FreeEncoder(mono));
+}
+
+TEST(OpusStatePoolTest, ReusesFreedDecoder) {
+  OpusStatePool pool(1);
+  OpusDecInst* first = nullptr;
+  ASSERT_EQ(0, pool.CreateDecoder(&first, 1));
+  ASSERT_EQ(0, pool.FreeDecoder(first));
+  EXPECT_EQ(1u, pool.pooled_decoders());
+
+  OpusDecInst* second = nullptr;
+  ASSERT_EQ(0, pool.CreateDecoder(&second, 1));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(1u, WebRtcOpus_DecoderChannels(second));
+  EXPECT_EQ(0, pool.FreeDecoder(second));
+}
+
+TEST(OpusStatePoolTest, RespectsCapacity) {
+  OpusStatePool pool(2);
+  std::vector<OpusEncInst*> encoders(3);
+  for (OpusEncInst*& inst : encoders)
+    ASSERT_EQ(0, pool.CreateEncoder(&inst, 1, 0));
+  for (OpusEncInst* inst : encoders)
+    EXPECT_EQ(0, pool.FreeEncoder(inst));
+  EXPECT_EQ(2u, pool.pooled_encoders());
+
+  pool.Clear();
+  EXPECT_EQ(0u, pool.pooled_encoders());
+}
+
+TEST(OpusStatePoolTest, DisabledPoolDoesNotKeepStates) {
+  OpusStatePool pool(0);
+  OpusEncInst* encoder = nullptr;
+  ASSERT_EQ(0, pool.CreateEncoder(&encoder, 1, 0));
+  EXPECT_EQ(0, pool.FreeEncoder(encoder));
+  OpusDecInst* decoder = nullptr;
+  ASSERT_EQ(0, pool.CreateDecoder(&decoder, 2));
+  EXPECT_EQ(0, pool.FreeDecoder(decoder));
+  EXPECT_EQ(0u, pool.pooled_encoders());
+  EXPECT_EQ(0u, pool.pooled_decoders());
+}
+
+TEST(OpusStatePoolTest, DoesNotPoolMultistreamEncoder) {
+  constexpr unsigned char kChannelMapping[] = {0, 1};
+  OpusStatePool pool(1);
+  OpusEncInst* inst = nullptr;
+  ASSERT_EQ(0, WebRtcOpus_MultistreamEncoderCreate(&inst, 2, 0, 1, 1,
+                                                   kChannelMapping));
+  EXPECT_EQ(0, pool.FreeEncoder(inst));
+  EXPECT_EQ(0u, pool.pooled_encoders());
+}
+
+TEST(OpusStatePoolTest, InvalidApplicationFails) {
+  OpusStatePool pool(1);
+  OpusEncInst* inst = nullptr;
+  ASSERT_EQ(0, pool.CreateEncoder(&inst, 1, 0));
+  ASSERT_EQ(0, pool.FreeEncoder(inst));
+  EXPECT_EQ(-1, pool.CreateEncoder(&inst, 1, 2));
+  EXPECT_EQ(0u, pool.pooled_encoders());
+}
+
+// A reused encoder must produce exactly the same bitstream as a newly created
+// one, i.e., no state or settings may leak from its previous use.
+TEST(OpusStatePoolTest, ReusedEncoderIsBitExactWithNewEncoder) {
+  for (size_t channels : {1u, 2u}) {
+    OpusEncInst* fresh = nullptr;
+    ASSERT_EQ(0, WebRtcOpus_EncoderCreate(&fresh, channels, 1));
+    const std::vector<uint8_t> expected = EncodeTestSignal(fresh, channels);
+    EXPECT_EQ(0, WebRtcOpus_EncoderFree(fresh));
+
+    OpusStatePool pool(1);
+    OpusEncInst* inst = nullptr;
+    ASSERT_EQ(0, pool.CreateEncoder(&inst, channels, 0));
+    EXPECT_EQ(0, WebRtcOpus_EnableDtx(inst));
+    EXPECT_EQ(0, WebRtcOpus_EnableFec(inst));
+    EncodeTestSignal(inst, channels);
+    ASSERT_EQ(0, pool.FreeEncoder(inst));
+
+    OpusEncInst* reused = nullptr;
+    ASSERT_EQ(0, pool.CreateEncoder(&reused, channels, 1));
+    ASSERT_EQ(inst, reused);
+    EXPECT_EQ(expected, EncodeTestSignal(reused, channels));
+    EXPECT_EQ(0, pool.FreeEncoder(reused));
+  }
+}
+
+}  // namespace webrtc
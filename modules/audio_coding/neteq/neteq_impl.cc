@@ -49,6 +49,7 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_conversions.h"
+#include "rtc_base/perf_event_counters.h"
 #include "rtc_base/sanitizer.h"
 #include "rtc_base/strings/audio_format_to_string.h"
 #include "rtc_base/trace_event.h"
@@ -212,6 +213,7 @@ int NetEqImpl::GetAudio(AudioFrame* audio_frame,
                         bool* muted,
                         absl::optional<Operations> action_override) {
   TRACE_EVENT0("webrtc", "NetEqImpl::GetAudio");
+  RTC_PERF_EVENT_SCOPE("NetEq.GetAudio");
   rtc::CritScope lock(&crit_sect_);
   if (GetAudioInternal(audio_frame, muted, action_override) != 0) {
     return kFail;
@@ -988,6 +990,7 @@ int NetEqImpl::GetDecision(Operations* operation,
                            DtmfEvent* dtmf_event,
                            bool* play_dtmf,
                            absl::optional<Operations> action_override) {
+  TRACE_EVENT0("webrtc", "NetEqImpl::GetDecision");
   // Initialize output variables.
   *play_dtmf = false;
   *operation = kUndefined;
@@ -1258,6 +1261,8 @@ int NetEqImpl::Decode(PacketList* packet_list,
                       Operations* operation,
                       int* decoded_length,
                       AudioDecoder::SpeechType* speech_type) {
+  TRACE_EVENT1("webrtc", "NetEqImpl::Decode", "num_packets",
+               packet_list->size());
   *speech_type = AudioDecoder::kSpeech;
 
   // When packet_list is empty, we may be in kCodecInternalCng mode, and for
@@ -1548,6 +1553,7 @@ bool NetEqImpl::DoCodecPlc() {
 }
 
 int NetEqImpl::DoExpand(bool play_dtmf) {
+  TRACE_EVENT0("webrtc", "NetEqImpl::DoExpand");
   while ((sync_buffer_->FutureLength() - expand_->overlap_length()) <
          output_size_samples_) {
     algorithm_buffer_->Clear();
@@ -1590,6 +1596,8 @@ int NetEqImpl::DoAccelerate(int16_t* decoded_buffer,
                             AudioDecoder::SpeechType speech_type,
                             bool play_dtmf,
                             bool fast_accelerate) {
+  TRACE_EVENT1("webrtc", "NetEqImpl::DoAccelerate", "fast_accelerate",
+               fast_accelerate);
   const size_t required_samples =
       static_cast<size_t>(240 * fs_mult_);  // Must have 30 ms.
   size_t borrowed_samples_per_channel = 0;
@@ -1662,6 +1670,7 @@ int NetEqImpl::DoPreemptiveExpand(int16_t* decoded_buffer,
                                   size_t decoded_length,
                                   AudioDecoder::SpeechType speech_type,
                                   bool play_dtmf) {
+  TRACE_EVENT0("webrtc", "NetEqImpl::DoPreemptiveExpand");
   const size_t required_samples =
       static_cast<size_t>(240 * fs_mult_);  // Must have 30 ms.
   size_t num_channels = algorithm_buffer_->Channels();
@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "modules/audio_coding/neteq/tools/neteq_batch_simulator.h"
+#include "modules/audio_coding/neteq/tools/neteq_test_factory.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/flags.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/string_to_number.h"
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/time_utils.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "system_wrappers/include/field_trial.h"
+#include "test/field_trial.h"
+
+namespace {
+
+WEBRTC_DEFINE_bool(help, false, "Prints this message");
+WEBRTC_DEFINE_string(
+    force_fieldtrials,
+    "",
+    "Field trials control experimental feature code which can be forced. "
+    "E.g. running with --force_fieldtrials=WebRTC-FooFeature/Enable/"
+    " will assign the group Enable to field trial WebRTC-FooFeature.");
+WEBRTC_DEFINE_string(input_list,
+                     "",
+                     "A text file listing one RTC event log per line, used in "
+                     "addition to the logs given on the command line");
+WEBRTC_DEFINE_int(threads,
+                  0,
+                  "Number of simulation threads; 0 means one per CPU core");
+WEBRTC_DEFINE_string(max_nr_packets_in_buffer,
+                     "50",
+                     "Comma-separated list of the maximum allowed number of "
+                     "packets in the buffer to simulate");
+WEBRTC_DEFINE_string(enable_fast_accelerate,
+                     "0",
+                     "Comma-separated list of 0 (disabled) and/or 1 (enabled) "
+                     "jitter buffer fast accelerate settings to simulate");
+WEBRTC_DEFINE_string(output_file,
+                     "",
+                     "Write the report to this file instead of stdout");
+
+// Parses a comma-separated list of integers into |values|. Returns false if
+// the list is empty or any element is not a valid integer.
+bool ParseIntList(const std::string& str, std::vector<int>* values) {
+  std::vector<std::string> fields;
+  rtc::split(str, ',', &fields);
+  for (const std::string& field : fields) {
+    absl::optional<int> value = rtc::StringToNumber<int>(field);
+    if (!value) {
+      printf("Invalid integer in list: %s\n", field.c_str());
+      return false;
+    }
+    values->push_back(*value);
+  }
+  return !values->empty();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string program_name = argv[0];
+  std::string usage =
+      "Tool for replaying many RTC event logs through NetEq in parallel, "
+      "optionally sweeping over NetEq parameters.\n"
+      "Run " +
+      program_name +
+      " --help for usage.\n"
+      "Example usage:\n" +
+      program_name +
+      " --max_nr_packets_in_buffer=50,100 --enable_fast_accelerate=0,1 "
+      "log1.rtc log2.rtc\n";
+  if (rtc::FlagList::SetFlagsFromCommandLine(&argc, argv, true)) {
+    exit(1);
+  }
+  if (FLAG_help) {
+    std::cout << usage;
+    rtc::FlagList::Print(nullptr, false);
+    exit(0);
+  }
+
+  std::vector<std::string> input_files(argv + 1, argv + argc);
+  if (strlen(FLAG_input_list) > 0) {
+    std::ifstream list(FLAG_input_list);
+    RTC_CHECK(list.good()) << "Cannot open " << FLAG_input_list;
+    std::string line;
+    while (std::getline(list, line)) {
+      if (!line.empty())
+        input_files.push_back(line);
+    }
+  }
+  if (input_files.empty()) {
+    std::cout << usage;
+    exit(0);
+  }
+
+  std::vector<int> max_packets_values;
+  RTC_CHECK(ParseIntList(FLAG_max_nr_packets_in_buffer, &max_packets_values));
+  std::vector<int> fast_accelerate_values;
+  RTC_CHECK(ParseIntList(FLAG_enable_fast_accelerate, &fast_accelerate_values));
+  RTC_CHECK_GE(FLAG_threads, 0);
+
+  webrtc::test::ValidateFieldTrialsStringOrDie(FLAG_force_fieldtrials);
+  webrtc::field_trial::InitFieldTrialsFromString(FLAG_force_fieldtrials);
+
+  std::vector<webrtc::test::NetEqBatchSimulator::Variant> variants;
+  for (int max_packets : max_packets_values) {
+    for (int fast_accelerate : fast_accelerate_values) {
+      RTC_CHECK_GT(max_packets, 0);
+      RTC_CHECK(fast_accelerate == 0 || fast_accelerate == 1);
+      webrtc::test::NetEqBatchSimulator::Variant variant;
+      rtc::StringBuilder name;
+      name << "max_packets=" << max_packets
+           << " fast_accelerate=" << fast_accelerate;
+      variant.name = name.Release();
+      variant.config.max_nr_packets_in_buffer = max_packets;
+      variant.config.enable_fast_accelerate = fast_accelerate == 1;
+      variants.push_back(variant);
+    }
+  }
+
+  const int num_threads =
+      FLAG_threads > 0 ? FLAG_threads
+                       : static_cast<int>(
+                             webrtc::CpuInfo::DetectNumberOfCores());
+  const size_t num_simulations = input_files.size() * variants.size();
+  webrtc::test::NetEqBatchSimulator simulator(std::move(input_files),
+                                              std::move(variants), num_threads);
+  const int64_t start_time_ms = rtc::TimeMillis();
+  const auto results = simulator.Run();
+  const int64_t elapsed_ms = rtc::TimeMillis() - start_time_ms;
+
+  FILE* report = stdout;
+  if (strlen(FLAG_output_file) > 0) {
+    report = fopen(FLAG_output_file, "w");
+    RTC_CHECK(report) << "Cannot open " << FLAG_output_file;
+  }
+  webrtc::test::NetEqBatchSimulator::PrintReport(results, report);
+  if (report != stdout)
+    fclose(report);
+
+  int64_t simulated_ms = 0;
+  for (const auto& result : results)
+    simulated_ms += result.simulation_time_ms;
+  printf("Ran %zu simulations of %d parsed logs on %d threads in %" PRId64
+         " ms (%.1f x real time).\n",
+         num_simulations, simulator.num_logs_parsed(), num_threads, elapsed_ms,
+         elapsed_ms > 0 ? static_cast<double>(simulated_ms) / elapsed_ms : 0.0);
+  return 0;
+}
@@ -0,0 +1,324 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/neteq/tools/neteq_batch_simulator.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "logging/rtc_event_log/rtc_event_log_parser.h"
+#include "modules/audio_coding/neteq/tools/neteq_delay_analyzer.h"
+#include "rtc_base/atomic_ops.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+void PrintResultLine(const std::string& input,
+                     const std::string& variant,
+                     int64_t simulation_time_ms,
+                     const NetEqStatsGetter::Stats& stats,
+                     double concealed_samples_ratio,
+                     const NetEqBatchSimulator::DelayStats& delay_stats,
+                     FILE* file) {
+  fprintf(file,
+          "%s,%s,%" PRId64 ",%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f\n",
+          input.c_str(), variant.c_str(), simulation_time_ms,
+          stats.current_buffer_size_ms, stats.preferred_buffer_size_ms,
+          100.0 * stats.packet_loss_rate, 100.0 * stats.expand_rate,
+          100.0 * stats.speech_expand_rate, 100.0 * stats.preemptive_rate,
+          100.0 * stats.accelerate_rate, stats.mean_waiting_time_ms,
+          stats.median_waiting_time_ms, stats.max_waiting_time_ms,
+          100.0 * concealed_samples_ratio, delay_stats.mean_arrival_delay_ms,
+          delay_stats.max_arrival_delay_ms, delay_stats.mean_playout_delay_ms,
+          delay_stats.max_playout_delay_ms, delay_stats.mean_target_delay_ms);
+}
+
+double ConcealedSamplesRatio(const NetEqLifetimeStatistics& lifetime_stats) {
+  if (lifetime_stats.total_samples_received == 0)
+    return 0.0;
+  return static_cast<double>(lifetime_stats.concealed_samples) /
+         lifetime_stats.total_samples_received;
+}
+
+void MeanAndMax(const NetEqDelayAnalyzer::Delays& delays,
+                double* mean,
+                double* max) {
+  if (delays.empty())
+    return;
+  double sum = 0.0;
+  *max = delays.front().second;
+  for (const auto& delay : delays) {
+    sum += delay.second;
+    *max = std::max(*max, static_cast<double>(delay.second));
+  }
+  *mean = sum / delays.size();
+}
+
+NetEqBatchSimulator::DelayStats SummarizeDelays(
+    const NetEqDelayAnalyzer& delay_analyzer) {
+  NetEqDelayAnalyzer::Delays arrival_delay_ms;
+  NetEqDelayAnalyzer::Delays corrected_arrival_delay_ms;
+  NetEqDelayAnalyzer::Delays playout_delay_ms;
+  NetEqDelayAnalyzer::Delays target_delay_ms;
+  delay_analyzer.CreateGraphs(&arrival_delay_ms, &corrected_arrival_delay_ms,
+                              &playout_delay_ms, &target_delay_ms);
+  NetEqBatchSimulator::DelayStats delay_stats;
+  double unused_max;
+  MeanAndMax(arrival_delay_ms, &delay_stats.mean_arrival_delay_ms,
+             &delay_stats.max_arrival_delay_ms);
+  MeanAndMax(playout_delay_ms, &delay_stats.mean_playout_delay_ms,
+             &delay_stats.max_playout_delay_ms);
+  MeanAndMax(target_delay_ms, &delay_stats.mean_target_delay_ms, &unused_max);
+  return delay_stats;
+}
+
+}  // namespace
+
+// Holds the parsed version of one input log for as long as there are
+// simulations of that log left to set up.
+class NetEqBatchSimulator::LogSlot {
+ public:
+  LogSlot(const std::string& file_name,
+          size_t num_simulations,
+          volatile int* num_logs_parsed)
+      : file_name_(file_name),
+        num_logs_parsed_(num_logs_parsed),
+        simulations_left_(num_simulations) {}
+
+  // Returns the parsed log, parsing the file if this is the first call. Other
+  // threads asking for the same log wait for the parsing to finish rather than
+  // parsing it again. Returns null if the file could not be parsed.
+  std::shared_ptr<const ParsedRtcEventLog> Acquire() {
+    rtc::CritScope lock(&crit_);
+    RTC_DCHECK_GT(simulations_left_, 0);
+    if (!parsed_log_ && !parse_attempted_) {
+      parse_attempted_ = true;
+      auto parsed_log = std::make_shared<ParsedRtcEventLog>();
+      if (parsed_log->ParseFile(file_name_)) {
+        parsed_log_ = std::move(parsed_log);
+        rtc::AtomicOps::Increment(num_logs_parsed_);
+      } else {
+        std::cerr << "Error: Cannot parse " << file_name_ << std::endl;
+      }
+    }
+    return parsed_log_;
+  }
+
+  // Called once per simulation when the parsed log is no longer needed for it.
+  void Release() {
+    rtc::CritScope lock(&crit_);
+    RTC_DCHECK_GT(simulations_left_, 0);
+    if (--simulations_left_ == 0)
+      parsed_log_.reset();
+  }
+
+ private:
+  const std::string file_name_;
+  volatile int* const num_logs_parsed_;
+  rtc::CriticalSection crit_;
+  size_t simulations_left_ RTC_GUARDED_BY(crit_);
+  bool parse_attempted_ RTC_GUARDED_BY(crit_) = false;
+  std::shared_ptr<const ParsedRtcEventLog> parsed_log_ RTC_GUARDED_BY(crit_);
+};
+
+NetEqBatchSimulator::NetEqBatchSimulator(
+    std::vector<std::string> input_filenames,
+    std::vector<Variant> variants,
+    int num_threads)
+    : input_filenames_(std::move(input_filenames)),
+      variants_(std::move(variants)),
+      num_threads_(num_threads) {
+  RTC_DCHECK_GT(num_threads_, 0);
+  RTC_DCHECK(!variants_.empty());
+  for (const std::string& file_name : input_filenames_) {
+    log_slots_.push_back(absl::make_unique<LogSlot>(
+        file_name, variants_.size(), &num_logs_parsed_));
+  }
+}
+
+NetEqBatchSimulator::~NetEqBatchSimulator() = default;
+
+std::vector<NetEqBatchSimulator::Result> NetEqBatchSimulator::Run() {
+  results_.clear();
+  results_.resize(input_filenames_.size() * variants_.size());
+  next_simulation_ = 0;
+
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < num_threads_; ++i) {
+    rtc::StringBuilder name;
+    name << "NetEqBatch" << i;
+    threads.push_back(absl::make_unique<rtc::PlatformThread>(
+        &NetEqBatchSimulator::WorkerThread, this, name.str()));
+    threads.back()->Start();
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+
+  return std::move(results_);
+}
+
+int NetEqBatchSimulator::num_logs_parsed() const {
+  return rtc::AtomicOps::AcquireLoad(&num_logs_parsed_);
+}
+
+void NetEqBatchSimulator::WorkerThread(void* obj) {
+  static_cast<NetEqBatchSimulator*>(obj)->ProcessSimulations();
+}
+
+void NetEqBatchSimulator::ProcessSimulations() {
+  // Simulations are handed out in log-major order, so that all variants of a
+  // log run close together in time and only a handful of parsed logs are kept
+  // in memory at any point.
+  const size_t num_simulations = results_.size();
+  while (true) {
+    const size_t index = rtc::AtomicOps::Increment(&next_simulation_) - 1;
+    if (index >= num_simulations)
+      return;
+    Simulate(index);
+  }
+}
+
+void NetEqBatchSimulator::Simulate(size_t simulation_index) {
+  const size_t log_index = simulation_index / variants_.size();
+  const Variant& variant = variants_[simulation_index % variants_.size()];
+  LogSlot* slot = log_slots_[log_index].get();
+  Result& result = results_[simulation_index];
+  result.input_filename = input_filenames_[log_index];
+  result.variant_name = variant.name;
+
+  NetEqTestFactory::Config config = variant.config;
+  config.quiet = true;
+  config.print_stats = false;
+  config.analyze_delays = true;
+  // The factory must outlive the test.
+  NetEqTestFactory factory;
+  std::unique_ptr<NetEqTest> test;
+  {
+    std::shared_ptr<const ParsedRtcEventLog> parsed_log = slot->Acquire();
+    if (parsed_log) {
+      test = factory.InitializeTestFromParsedLog(*parsed_log, config);
+    }
+  }
+  slot->Release();
+  if (!test)
+    return;
+
+  result.simulation_time_ms = test->Run();
+  result.stats = factory.stats_getter()->AverageStats();
+  result.lifetime_stats = test->LifetimeStats();
+  result.delay_stats =
+      SummarizeDelays(*factory.stats_getter()->delay_analyzer());
+  result.success = true;
+}
+
+void NetEqBatchSimulator::PrintReport(const std::vector<Result>& results,
+                                      FILE* file) {
+  static const char kHeader[] =
+      "input,variant,duration_ms,current_buffer_size_ms,"
+      "preferred_buffer_size_ms,packet_loss_rate_percent,expand_rate_percent,"
+      "speech_expand_rate_percent,preemptive_rate_percent,"
+      "accelerate_rate_percent,mean_waiting_time_ms,median_waiting_time_ms,"
+      "max_waiting_time_ms,concealed_samples_percent,mean_arrival_delay_ms,"
+      "max_arrival_delay_ms,mean_playout_delay_ms,max_playout_delay_ms,"
+      "mean_target_delay_ms\n";
+  fprintf(file, "%s", kHeader);
+
+  struct Sum {
+    int count = 0;
+    int64_t simulation_time_ms = 0;
+    NetEqStatsGetter::Stats stats;
+    double concealed_samples_ratio = 0.0;
+    DelayStats delay_stats;
+  };
+  // Keeps the variants in the order in which they first appear.
+  std::vector<std::string> variant_order;
+  std::map<std::string, Sum> sums;
+  int failures = 0;
+  for (const Result& result : results) {
+    if (!result.success) {
+      ++failures;
+      continue;
+    }
+    const double concealed_ratio =
+        ConcealedSamplesRatio(result.lifetime_stats);
+    PrintResultLine(result.input_filename, result.variant_name,
+                    result.simulation_time_ms, result.stats, concealed_ratio,
+                    result.delay_stats, file);
+
+    if (sums.find(result.variant_name) == sums.end())
+      variant_order.push_back(result.variant_name);
+    Sum& sum = sums[result.variant_name];
+    ++sum.count;
+    sum.simulation_time_ms += result.simulation_time_ms;
+    sum.stats.current_buffer_size_ms += result.stats.current_buffer_size_ms;
+    sum.stats.preferred_buffer_size_ms +=
+        result.stats.preferred_buffer_size_ms;
+    sum.stats.packet_loss_rate += result.stats.packet_loss_rate;
+    sum.stats.expand_rate += result.stats.expand_rate;
+    sum.stats.speech_expand_rate += result.stats.speech_expand_rate;
+    sum.stats.preemptive_rate += result.stats.preemptive_rate;
+    sum.stats.accelerate_rate += result.stats.accelerate_rate;
+    sum.stats.mean_waiting_time_ms += result.stats.mean_waiting_time_ms;
+    sum.stats.median_waiting_time_ms += result.stats.median_waiting_time_ms;
+    sum.stats.max_waiting_time_ms += result.stats.max_waiting_time_ms;
+    sum.concealed_samples_ratio += concealed_ratio;
+    const DelayStats& delays = result.delay_stats;
+    sum.delay_stats.mean_arrival_delay_ms += delays.mean_arrival_delay_ms;
+    sum.delay_stats.max_arrival_delay_ms += delays.max_arrival_delay_ms;
+    sum.delay_stats.mean_playout_delay_ms += delays.mean_playout_delay_ms;
+    sum.delay_stats.max_playout_delay_ms += delays.max_playout_delay_ms;
+    sum.delay_stats.mean_target_delay_ms += delays.mean_target_delay_ms;
+  }
+
+  fprintf(file, "\nAverages per variant:\n%s", kHeader);
+  for (const std::string& variant : variant_order) {
+    const Sum& sum = sums[variant];
+    const double n = sum.count;
+    NetEqStatsGetter::Stats mean;
+    mean.current_buffer_size_ms = sum.stats.current_buffer_size_ms / n;
+    mean.preferred_buffer_size_ms = sum.stats.preferred_buffer_size_ms / n;
+    mean.packet_loss_rate = sum.stats.packet_loss_rate / n;
+    mean.expand_rate = sum.stats.expand_rate / n;
+    mean.speech_expand_rate = sum.stats.speech_expand_rate / n;
+    mean.preemptive_rate = sum.stats.preemptive_rate / n;
+    mean.accelerate_rate = sum.stats.accelerate_rate / n;
+    mean.mean_waiting_time_ms = sum.stats.mean_waiting_time_ms / n;
+    mean.median_waiting_time_ms = sum.stats.median_waiting_time_ms / n;
+    mean.max_waiting_time_ms = sum.stats.max_waiting_time_ms / n;
+    DelayStats mean_delays;
+    mean_delays.mean_arrival_delay_ms =
+        sum.delay_stats.mean_arrival_delay_ms / n;
+    mean_delays.max_arrival_delay_ms = sum.delay_stats.max_arrival_delay_ms / n;
+    mean_delays.mean_playout_delay_ms =
+        sum.delay_stats.mean_playout_delay_ms / n;
+    mean_delays.max_playout_delay_ms = sum.delay_stats.max_playout_delay_ms / n;
+    mean_delays.mean_target_delay_ms = sum.delay_stats.mean_target_delay_ms / n;
+    rtc::StringBuilder input;
+    input << "all (" << sum.count << " logs)";
+    PrintResultLine(input.str(), variant, sum.simulation_time_ms, mean,
+                    sum.concealed_samples_ratio / n, mean_delays, file);
+  }
+  if (failures > 0)
+    fprintf(file, "\n%d simulation(s) failed.\n", failures);
+}
+
+}  // namespace test
+}  // namespace webrtc
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_BATCH_SIMULATOR_H_
+#define MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_BATCH_SIMULATOR_H_
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "modules/audio_coding/neteq/include/neteq.h"
+#include "modules/audio_coding/neteq/tools/neteq_stats_getter.h"
+#include "modules/audio_coding/neteq/tools/neteq_test_factory.h"
+#include "rtc_base/constructor_magic.h"
+
+namespace webrtc {
+namespace test {
+
+// Replays a set of RTC event logs through NetEq, once for each of a set of
+// configuration variants, using a pool of worker threads. Each log is parsed
+// only once; the parsed log is shared by all simulations of that log and is
+// released as soon as the last of them has been set up.
+class NetEqBatchSimulator {
+ public:
+  struct Variant {
+    std::string name;
+    NetEqTestFactory::Config config;
+  };
+
+  // Summary of the per-packet delays recorded by NetEqDelayAnalyzer. Arrival
+  // delays are relative to the packet that arrived earliest compared to its
+  // send time, so they reflect the network jitter.
+  struct DelayStats {
+    double mean_arrival_delay_ms = 0.0;
+    double max_arrival_delay_ms = 0.0;
+    double mean_playout_delay_ms = 0.0;
+    double max_playout_delay_ms = 0.0;
+    double mean_target_delay_ms = 0.0;
+  };
+
+  struct Result {
+    std::string input_filename;
+    std::string variant_name;
+    bool success = false;
+    int64_t simulation_time_ms = 0;
+    NetEqStatsGetter::Stats stats;
+    NetEqLifetimeStatistics lifetime_stats;
+    DelayStats delay_stats;
+  };
+
+  NetEqBatchSimulator(std::vector<std::string> input_filenames,
+                      std::vector<Variant> variants,
+                      int num_threads);
+  ~NetEqBatchSimulator();
+
+  // Runs all simulations and blocks until they have finished. Returns one
+  // result per input file and variant, ordered by input file first. The
+  // simulations run with NetEqTestFactory::Config::quiet set and without
+  // printing statistics, since they share stdout, and with analyze_delays set
+  // to fill in Result::delay_stats. Must only be called once.
+  std::vector<Result> Run();
+
+  // Number of input logs that Run() has parsed successfully. Each log is
+  // parsed at most once, however many variants are simulated with it.
+  int num_logs_parsed() const;
+
+  // Writes one line per result, followed by per-variant averages over all
+  // successful simulations, as comma-separated values.
+  static void PrintReport(const std::vector<Result>& results, FILE* file);
+
+ private:
+  class LogSlot;
+
+  static void WorkerThread(void* obj);
+  void ProcessSimulations();
+  void Simulate(size_t simulation_index);
+
+  const std::vector<std::string> input_filenames_;
+  const std::vector<Variant> variants_;
+  const int num_threads_;
+  std::vector<std::unique_ptr<LogSlot>> log_slots_;
+  std::vector<Result> results_;
+  // Index of the next simulation to hand out to a worker thread.
+  volatile int next_simulation_ = 0;
+  volatile int num_logs_parsed_ = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(NetEqBatchSimulator);
+};
+
+}  // namespace test
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_BATCH_SIMULATOR_H_
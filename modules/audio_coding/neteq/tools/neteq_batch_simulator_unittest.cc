@@ -0,0 +1,188 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/neteq/tools/neteq_batch_simulator.h"
+
+#include <stdio.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/units/time_delta.h"
+#include "api/units/timestamp.h"
+#include "logging/rtc_event_log/encoder/rtc_event_log_encoder_legacy.h"
+#include "logging/rtc_event_log/events/rtc_event_audio_playout.h"
+#include "logging/rtc_event_log/events/rtc_event_audio_receive_stream_config.h"
+#include "logging/rtc_event_log/events/rtc_event_rtp_packet_incoming.h"
+#include "logging/rtc_event_log/rtc_stream_config.h"
+#include "modules/rtp_rtcp/source/rtp_packet_received.h"
+#include "rtc_base/fake_clock.h"
+#include "test/gtest.h"
+#include "test/testsupport/file_utils.h"
+
+namespace webrtc {
+namespace test {
+namespace {
+
+constexpr uint32_t kSsrc = 0x1234;
+constexpr int kPcmuPayloadType = 0;
+constexpr int kPacketDurationMs = 20;
+constexpr int kPcmuSamplesPerPacket = 8 * kPacketDurationMs;
+
+// Writes an RTC event log with |num_packets| incoming PCMU packets, and the
+// corresponding audio playout events, to |file_name|.
+void WritePcmuEventLog(const std::string& file_name, int num_packets) {
+  rtc::ScopedBaseFakeClock clock;
+  clock.SetTime(Timestamp::ms(1000));
+  std::deque<std::unique_ptr<RtcEvent>> events;
+
+  auto stream_config = absl::make_unique<rtclog::StreamConfig>();
+  stream_config->remote_ssrc = kSsrc;
+  stream_config->codecs.emplace_back("PCMU", kPcmuPayloadType, 0);
+  events.push_back(absl::make_unique<RtcEventAudioReceiveStreamConfig>(
+      std::move(stream_config)));
+
+  for (int i = 0; i < num_packets; ++i) {
+    RtpPacketReceived packet;
+    packet.SetPayloadType(kPcmuPayloadType);
+    packet.SetSequenceNumber(i);
+    packet.SetTimestamp(i * kPcmuSamplesPerPacket);
+    packet.SetSsrc(kSsrc);
+    packet.SetPayloadSize(kPcmuSamplesPerPacket);
+    events.push_back(absl::make_unique<RtcEventRtpPacketIncoming>(packet));
+    for (int j = 0; j < kPacketDurationMs / 10; ++j) {
+      clock.AdvanceTime(TimeDelta::ms(10));
+      events.push_back(absl::make_unique<RtcEventAudioPlayout>(kSsrc));
+    }
+  }
+
+  RtcEventLogEncoderLegacy encoder;
+  std::string encoded = encoder.EncodeLogStart(rtc::TimeMicros(), 0);
+  encoded += encoder.EncodeBatch(events.begin(), events.end());
+  encoded += encoder.EncodeLogEnd(rtc::TimeMicros());
+  FILE* file = fopen(file_name.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(encoded.size(), fwrite(encoded.data(), 1, encoded.size(), file));
+  fclose(file);
+}
+
+NetEqBatchSimulator::Variant MakeVariant(const std::string& name,
+                                         int max_packets_in_buffer) {
+  NetEqBatchSimulator::Variant variant;
+  variant.name = name;
+  variant.config.max_nr_packets_in_buffer = max_packets_in_buffer;
+  return variant;
+}
+
+class NetEqBatchSimulatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    log_a_ = TempFilename(OutputPath(), "neteq_batch_log_a");
+    log_b_ = TempFilename(OutputPath(), "neteq_batch_log_b");
+    WritePcmuEventLog(log_a_, 100);
+    WritePcmuEventLog(log_b_, 150);
+    missing_log_ = log_a_ + ".missing";
+  }
+
+  void TearDown() override {
+    RemoveFile(log_a_);
+    RemoveFile(log_b_);
+  }
+
+  std::string log_a_;
+  std::string log_b_;
+  std::string missing_log_;
+};
+
+}  // namespace
+
+TEST_F(NetEqBatchSimulatorTest, OrdersResultsByInputThenVariant) {
+  const std::vector<std::string> inputs = {log_a_, missing_log_, log_b_};
+  const std::vector<NetEqBatchSimulator::Variant> variants = {
+      MakeVariant("small", 10), MakeVariant("default", 50),
+      MakeVariant("large", 200)};
+  NetEqBatchSimulator simulator(inputs, variants, 4);
+  const std::vector<NetEqBatchSimulator::Result> results = simulator.Run();
+
+  ASSERT_EQ(inputs.size() * variants.size(), results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    const std::string& input = inputs[i / variants.size()];
+    EXPECT_EQ(input, results[i].input_filename);
+    EXPECT_EQ(variants[i % variants.size()].name, results[i].variant_name);
+    EXPECT_EQ(input != missing_log_, results[i].success);
+  }
+}
+
+TEST_F(NetEqBatchSimulatorTest, SharesEachParsedLogBetweenVariants) {
+  const std::vector<NetEqBatchSimulator::Variant> variants = {
+      MakeVariant("first", 50), MakeVariant("second", 50),
+      MakeVariant("third", 50), MakeVariant("fourth", 50)};
+  NetEqBatchSimulator simulator({log_a_, log_b_}, variants, 4);
+  const std::vector<NetEqBatchSimulator::Result> results = simulator.Run();
+
+  EXPECT_EQ(2, simulator.num_logs_parsed());
+  ASSERT_EQ(8u, results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    const NetEqBatchSimulator::Result& result = results[i];
+    const NetEqBatchSimulator::Result& first =
+        results[i - i % variants.size()];
+    ASSERT_TRUE(result.success);
+    EXPECT_GT(result.simulation_time_ms, 0);
+    EXPECT_GT(result.delay_stats.mean_playout_delay_ms, 0.0);
+    // All variants of a log have the same configuration, so they replay the
+    // same packets with the same outcome.
+    EXPECT_EQ(first.simulation_time_ms, result.simulation_time_ms);
+    EXPECT_EQ(first.lifetime_stats.total_samples_received,
+              result.lifetime_stats.total_samples_received);
+    EXPECT_EQ(first.delay_stats.max_playout_delay_ms,
+              result.delay_stats.max_playout_delay_ms);
+  }
+  EXPECT_LT(results[0].simulation_time_ms, results[4].simulation_time_ms);
+}
+
+TEST_F(NetEqBatchSimulatorTest, ReportsLogsThatFailToParse) {
+  const std::string garbage_log = TempFilename(OutputPath(), "neteq_garbage");
+  FILE* file = fopen(garbage_log.c_str(), "wb");
+  ASSERT_TRUE(file);
+  fputs("This is not an RTC event log.", file);
+  fclose(file);
+
+  NetEqBatchSimulator simulator({missing_log_, garbage_log, log_a_},
+                                {MakeVariant("a", 50), MakeVariant("b", 50)},
+                                2);
+  const std::vector<NetEqBatchSimulator::Result> results = simulator.Run();
+  RemoveFile(garbage_log);
+
+  EXPECT_EQ(1, simulator.num_logs_parsed());
+  ASSERT_EQ(6u, results.size());
+  for (size_t i = 0; i < 4; ++i)
+    EXPECT_FALSE(results[i].success);
+  EXPECT_TRUE(results[4].success);
+  EXPECT_TRUE(results[5].success);
+
+  FILE* report = tmpfile();
+  ASSERT_TRUE(report);
+  NetEqBatchSimulator::PrintReport(results, report);
+  rewind(report);
+  std::string report_text;
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), report))
+    report_text += buffer;
+  fclose(report);
+  EXPECT_NE(std::string::npos, report_text.find("all (1 logs)"));
+  EXPECT_NE(std::string::npos, report_text.find("4 simulation(s) failed."));
+  EXPECT_EQ(std::string::npos, report_text.find(missing_log_));
+}
+
+}  // namespace test
+}  // namespace webrtc
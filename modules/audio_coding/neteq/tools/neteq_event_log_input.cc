@@ -41,6 +41,17 @@ NetEqEventLogInput* NetEqEventLogInput::CreateFromString(
   return new NetEqEventLogInput(std::move(event_log_src));
 }
 
+NetEqEventLogInput* NetEqEventLogInput::CreateFromParsedLog(
+    const ParsedRtcEventLog& parsed_log,
+    absl::optional<uint32_t> ssrc_filter) {
+  auto event_log_src =
+      RtcEventLogSource::CreateFromParsedLog(parsed_log, ssrc_filter);
+  if (!event_log_src) {
+    return nullptr;
+  }
+  return new NetEqEventLogInput(std::move(event_log_src));
+}
+
 absl::optional<int64_t> NetEqEventLogInput::NextOutputEventTime() const {
   return next_output_event_ms_;
 }
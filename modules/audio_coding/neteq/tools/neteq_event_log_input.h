@@ -19,6 +19,9 @@
 #include "modules/rtp_rtcp/include/rtp_rtcp_defines.h"
 
 namespace webrtc {
+
+class ParsedRtcEventLog;
+
 namespace test {
 
 class RtcEventLogSource;
@@ -33,6 +36,9 @@ class NetEqEventLogInput final : public NetEqPacketSourceInput {
   static NetEqEventLogInput* CreateFromString(
       const std::string& file_contents,
       absl::optional<uint32_t> ssrc_filter);
+  static NetEqEventLogInput* CreateFromParsedLog(
+      const ParsedRtcEventLog& parsed_log,
+      absl::optional<uint32_t> ssrc_filter);
 
   absl::optional<int64_t> NextOutputEventTime() const override;
   void AdvanceOutputEvent() override;
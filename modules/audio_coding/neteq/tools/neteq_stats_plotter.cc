@@ -20,13 +20,14 @@ namespace test {
 NetEqStatsPlotter::NetEqStatsPlotter(bool make_matlab_plot,
                                      bool make_python_plot,
                                      bool show_concealment_events,
+                                     bool analyze_delays,
                                      std::string base_file_name)
     : make_matlab_plot_(make_matlab_plot),
       make_python_plot_(make_python_plot),
       show_concealment_events_(show_concealment_events),
       base_file_name_(base_file_name) {
   std::unique_ptr<NetEqDelayAnalyzer> delay_analyzer;
-  if (make_matlab_plot || make_python_plot) {
+  if (make_matlab_plot || make_python_plot || analyze_delays) {
     delay_analyzer.reset(new NetEqDelayAnalyzer);
   }
   stats_getter_.reset(new NetEqStatsGetter(std::move(delay_analyzer)));
@@ -26,6 +26,7 @@ class NetEqStatsPlotter : public NetEqSimulationEndedCallback {
   NetEqStatsPlotter(bool make_matlab_plot,
                     bool make_python_plot,
                     bool show_concealment_events,
+                    bool analyze_delays,
                     std::string base_file_name);
 
   void SimulationEnded(int64_t simulation_time_ms) override;
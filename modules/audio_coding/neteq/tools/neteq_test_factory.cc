@@ -120,6 +120,22 @@ std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTestFromString(
   return InitializeTest(std::move(input), config);
 }
 
+std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTestFromParsedLog(
+    const ParsedRtcEventLog& parsed_log,
+    const Config& config) {
+  std::unique_ptr<NetEqInput> input(
+      NetEqEventLogInput::CreateFromParsedLog(parsed_log, config.ssrc_filter));
+  if (!input) {
+    std::cerr << "Error: Cannot read parsed event log" << std::endl;
+    return nullptr;
+  }
+  return InitializeTest(std::move(input), config);
+}
+
+const NetEqStatsGetter* NetEqTestFactory::stats_getter() const {
+  return stats_plotter_ ? stats_plotter_->stats_getter() : nullptr;
+}
+
 std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTestFromFile(
     const std::string& input_file_name,
     const Config& config) {
@@ -141,7 +157,8 @@ std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTestFromFile(
                                                    config.ssrc_filter));
   }
 
-  std::cout << "Input file: " << input_file_name << std::endl;
+  if (!config.quiet)
+    std::cout << "Input file: " << input_file_name << std::endl;
   if (!input) {
     std::cerr << "Error: Cannot open input file" << std::endl;
     return nullptr;
@@ -164,10 +181,12 @@ std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTest(
     RTC_DCHECK(first_rtp_header);
     sample_rate_hz = CodecSampleRate(first_rtp_header->payloadType, config);
     if (sample_rate_hz) {
-      std::cout << "Found valid packet with payload type "
-                << static_cast<int>(first_rtp_header->payloadType)
-                << " and SSRC 0x" << std::hex << first_rtp_header->ssrc
-                << std::dec << std::endl;
+      if (!config.quiet) {
+        std::cout << "Found valid packet with payload type "
+                  << static_cast<int>(first_rtp_header->payloadType)
+                  << " and SSRC 0x" << std::hex << first_rtp_header->ssrc
+                  << std::dec << std::endl;
+      }
       break;
     }
     // Discard this packet and move to the next. Keep track of discarded payload
@@ -176,7 +195,7 @@ std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTest(
                                   first_rtp_header->ssrc);
     input->PopPacket();
   }
-  if (!discarded_pt_and_ssrc.empty()) {
+  if (!discarded_pt_and_ssrc.empty() && !config.quiet) {
     std::cout << "Discarded initial packets with the following payload types "
                  "and SSRCs:"
               << std::endl;
@@ -195,20 +214,25 @@ std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTest(
   std::unique_ptr<AudioSink> output;
   if (!config.output_audio_filename.has_value()) {
     output = absl::make_unique<VoidAudioSink>();
-    std::cout << "No output audio file" << std::endl;
+    if (!config.quiet)
+      std::cout << "No output audio file" << std::endl;
   } else if (config.output_audio_filename->size() >= 4 &&
              config.output_audio_filename->substr(
                  config.output_audio_filename->size() - 4) == ".wav") {
     // Open a wav file with the known sample rate.
     output = absl::make_unique<OutputWavFile>(*config.output_audio_filename,
                                               *sample_rate_hz);
-    std::cout << "Output WAV file: " << *config.output_audio_filename
-              << std::endl;
+    if (!config.quiet) {
+      std::cout << "Output WAV file: " << *config.output_audio_filename
+                << std::endl;
+    }
   } else {
     // Open a pcm file.
     output = absl::make_unique<OutputAudioFile>(*config.output_audio_filename);
-    std::cout << "Output PCM file: " << *config.output_audio_filename
-              << std::endl;
+    if (!config.quiet) {
+      std::cout << "Output PCM file: " << *config.output_audio_filename
+                << std::endl;
+    }
   }
 
   NetEqTest::DecoderMap codecs = NetEqTest::StandardDecoderMap();
@@ -280,13 +304,21 @@ std::unique_ptr<NetEqTest> NetEqTestFactory::InitializeTest(
   NetEqTest::Callbacks callbacks;
   stats_plotter_ = absl::make_unique<NetEqStatsPlotter>(
       config.matlabplot, config.pythonplot, config.concealment_events,
-      config.plot_scripts_basename.value_or(""));
+      config.analyze_delays, config.plot_scripts_basename.value_or(""));
 
-  ssrc_switch_detector_.reset(
-      new SsrcSwitchDetector(stats_plotter_->stats_getter()->delay_analyzer()));
-  callbacks.post_insert_packet = ssrc_switch_detector_.get();
+  NetEqDelayAnalyzer* delay_analyzer =
+      stats_plotter_->stats_getter()->delay_analyzer();
+  if (config.quiet) {
+    ssrc_switch_detector_.reset();
+    callbacks.post_insert_packet = delay_analyzer;
+  } else {
+    ssrc_switch_detector_.reset(new SsrcSwitchDetector(delay_analyzer));
+    callbacks.post_insert_packet = ssrc_switch_detector_.get();
+  }
   callbacks.get_audio_callback = stats_plotter_->stats_getter();
-  callbacks.simulation_ended_callback = stats_plotter_.get();
+  if (config.print_stats) {
+    callbacks.simulation_ended_callback = stats_plotter_.get();
+  }
   NetEq::Config neteq_config;
   neteq_config.sample_rate_hz = *sample_rate_hz;
   neteq_config.max_packets_in_buffer = config.max_nr_packets_in_buffer;
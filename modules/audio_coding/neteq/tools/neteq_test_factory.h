@@ -18,6 +18,9 @@
 #include "modules/audio_coding/neteq/tools/neteq_test.h"
 
 namespace webrtc {
+
+class ParsedRtcEventLog;
+
 namespace test {
 
 class SsrcSwitchDetector;
@@ -119,6 +122,17 @@ class NetEqTestFactory {
     bool pythonplot = false;
     // Prints concealment events.
     bool concealment_events = false;
+    // Records the delays of each packet with a NetEqDelayAnalyzer, available
+    // from stats_getter() when the test has run. Implied by the plot options.
+    bool analyze_delays = false;
+    // Prints the simulation statistics, and creates the requested plot
+    // scripts, when the simulation has ended.
+    bool print_stats = true;
+    // Suppresses the informational output to stdout while setting up and
+    // running the test, such as the detected streams. Errors are still written
+    // to stderr. Needed when tests are set up on several threads at once, since
+    // the output stream and its formatting flags are process-wide.
+    bool quiet = false;
     // Maximum allowed number of packets in the buffer.
     static constexpr int default_max_nr_packets_in_buffer() { return 50; }
     int max_nr_packets_in_buffer = default_max_nr_packets_in_buffer();
@@ -139,6 +153,16 @@ class NetEqTestFactory {
   std::unique_ptr<NetEqTest> InitializeTestFromString(
       const std::string& input_string,
       const Config& config);
+  // Same as above, but uses an already parsed RTC event log. The log only needs
+  // to be valid for the duration of the call, which makes it possible to parse
+  // a log once and set up several simulations from it.
+  std::unique_ptr<NetEqTest> InitializeTestFromParsedLog(
+      const ParsedRtcEventLog& parsed_log,
+      const Config& config);
+
+  // Returns the statistics collected by the most recently initialized test, or
+  // null if no test has been initialized.
+  const NetEqStatsGetter* stats_getter() const;
 
  private:
   std::unique_ptr<NetEqTest> InitializeTest(std::unique_ptr<NetEqInput> input,
@@ -62,6 +62,17 @@ std::unique_ptr<RtcEventLogSource> RtcEventLogSource::CreateFromString(
   return source;
 }
 
+std::unique_ptr<RtcEventLogSource> RtcEventLogSource::CreateFromParsedLog(
+    const ParsedRtcEventLog& parsed_log,
+    absl::optional<uint32_t> ssrc_filter) {
+  auto source = std::unique_ptr<RtcEventLogSource>(new RtcEventLogSource());
+  if (!source->Initialize(parsed_log, ssrc_filter)) {
+    std::cerr << "Error while reading parsed event log, skipping." << std::endl;
+    return nullptr;
+  }
+  return source;
+}
+
 RtcEventLogSource::~RtcEventLogSource() {}
 
 std::unique_ptr<Packet> RtcEventLogSource::NextPacket() {
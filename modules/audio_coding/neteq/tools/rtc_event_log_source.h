@@ -40,6 +40,12 @@ class RtcEventLogSource : public PacketSource {
   static std::unique_ptr<RtcEventLogSource> CreateFromString(
       const std::string& file_contents,
       absl::optional<uint32_t> ssrc_filter);
+  // Same as above, but uses an already parsed log. The log is only accessed
+  // during the call, and may be shared between several sources as long as no
+  // one modifies it concurrently.
+  static std::unique_ptr<RtcEventLogSource> CreateFromParsedLog(
+      const ParsedRtcEventLog& parsed_log,
+      absl::optional<uint32_t> ssrc_filter);
 
   virtual ~RtcEventLogSource();
 
@@ -45,6 +45,7 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/constructor_magic.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/perf_event_counters.h"
 #include "rtc_base/ref_counted_object.h"
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
@@ -1251,6 +1252,8 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
 }
 
 int AudioProcessingImpl::ProcessCaptureStreamLocked() {
+  TRACE_EVENT0("webrtc", "AudioProcessing::ProcessCaptureStreamLocked");
+  RTC_PERF_EVENT_SCOPE("Apm.ProcessStream");
   HandleCaptureRuntimeSettings();
 
   // Ensure that not both the AEC and AECM are active at the same time.
@@ -1360,10 +1363,12 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
 
     public_submodules_->noise_suppression->ProcessCaptureAudio(capture_buffer);
 
+    TRACE_EVENT0("webrtc", "AudioProcessing::EchoControlMobile");
     RETURN_ON_ERR(private_submodules_->echo_control_mobile->ProcessCaptureAudio(
         capture_buffer, stream_delay_ms()));
   } else {
     if (private_submodules_->echo_controller) {
+      TRACE_EVENT0("webrtc", "AudioProcessing::EchoController");
       data_dumper_->DumpRaw("stream_delay", stream_delay_ms());
 
       if (was_stream_delay_set()) {
@@ -1445,6 +1450,7 @@ int AudioProcessingImpl::ProcessCaptureStreamLocked() {
   }
 
   if (config_.gain_controller2.enabled) {
+    TRACE_EVENT0("webrtc", "AudioProcessing::GainController2");
     private_submodules_->gain_controller2->NotifyAnalogLevel(
         agc1()->stream_analog_level());
     private_submodules_->gain_controller2->Process(capture_buffer);
@@ -1597,6 +1603,7 @@ int AudioProcessingImpl::ProcessReverseStream(AudioFrame* frame) {
 }
 
 int AudioProcessingImpl::ProcessRenderStreamLocked() {
+  TRACE_EVENT0("webrtc", "AudioProcessing::ProcessRenderStreamLocked");
   AudioBuffer* render_buffer = render_.render_audio.get();  // For brevity.
 
   HandleRenderRuntimeSettings();
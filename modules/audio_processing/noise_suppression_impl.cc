@@ -11,8 +11,10 @@
 #include "modules/audio_processing/noise_suppression_impl.h"
 
 #include "modules/audio_processing/audio_buffer.h"
+#include "modules/audio_processing/ns/noise_suppressor.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/constructor_magic.h"
+#include "system_wrappers/include/field_trial.h"
 #if defined(WEBRTC_NS_FLOAT)
 #include "modules/audio_processing/ns/noise_suppression.h"
 
@@ -32,6 +34,18 @@ typedef NsxHandle NsState;
 #endif
 
 namespace webrtc {
+namespace {
+
+bool UseNoiseSuppressor() {
+#if defined(WEBRTC_NS_FLOAT)
+  return field_trial::IsEnabled("WebRTC-Audio-SimdNoiseSuppressor");
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
 class NoiseSuppressionImpl::Suppressor {
  public:
   explicit Suppressor(int sample_rate_hz) {
@@ -49,7 +63,7 @@ class NoiseSuppressionImpl::Suppressor {
 };
 
 NoiseSuppressionImpl::NoiseSuppressionImpl(rtc::CriticalSection* crit)
-    : crit_(crit) {
+    : crit_(crit), use_noise_suppressor_(UseNoiseSuppressor()) {
   RTC_DCHECK(crit);
 }
 
@@ -60,7 +74,10 @@ void NoiseSuppressionImpl::Initialize(size_t channels, int sample_rate_hz) {
   channels_ = channels;
   sample_rate_hz_ = sample_rate_hz;
   std::vector<std::unique_ptr<Suppressor>> new_suppressors;
-  if (enabled_) {
+  noise_suppressor_.reset();
+  if (enabled_ && use_noise_suppressor_) {
+    noise_suppressor_.reset(new NoiseSuppressor(sample_rate_hz, channels));
+  } else if (enabled_) {
     new_suppressors.resize(channels);
     for (size_t i = 0; i < channels; i++) {
       new_suppressors[i].reset(new Suppressor(sample_rate_hz));
@@ -79,6 +96,14 @@ void NoiseSuppressionImpl::AnalyzeCaptureAudio(AudioBuffer* audio) {
   }
 
   RTC_DCHECK_GE(160, audio->num_frames_per_band());
+  if (noise_suppressor_) {
+    RTC_DCHECK_EQ(noise_suppressor_->num_channels(), audio->num_channels());
+    for (size_t i = 0; i < noise_suppressor_->num_channels(); i++) {
+      noise_suppressor_->Analyze(i,
+                                 audio->split_bands_const_f(i)[kBand0To8kHz]);
+    }
+    return;
+  }
   RTC_DCHECK_EQ(suppressors_.size(), audio->num_channels());
   for (size_t i = 0; i < suppressors_.size(); i++) {
     WebRtcNs_Analyze(suppressors_[i]->state(),
@@ -95,6 +120,14 @@ void NoiseSuppressionImpl::ProcessCaptureAudio(AudioBuffer* audio) {
   }
 
   RTC_DCHECK_GE(160, audio->num_frames_per_band());
+  if (noise_suppressor_) {
+    RTC_DCHECK_EQ(noise_suppressor_->num_channels(), audio->num_channels());
+    for (size_t i = 0; i < noise_suppressor_->num_channels(); i++) {
+      noise_suppressor_->Process(i, audio->split_bands_const_f(i),
+                                 audio->num_bands(), audio->split_bands_f(i));
+    }
+    return;
+  }
   RTC_DCHECK_EQ(suppressors_.size(), audio->num_channels());
   for (size_t i = 0; i < suppressors_.size(); i++) {
 #if defined(WEBRTC_NS_FLOAT)
@@ -141,6 +174,10 @@ int NoiseSuppressionImpl::set_level(Level level) {
   }
   rtc::CritScope cs(crit_);
   level_ = level;
+  if (noise_suppressor_) {
+    bool success = noise_suppressor_->SetPolicy(policy);
+    RTC_DCHECK(success);
+  }
   for (auto& suppressor : suppressors_) {
     int error = NS_SET_POLICY(suppressor->state(), policy);
     RTC_DCHECK_EQ(0, error);
@@ -157,6 +194,15 @@ float NoiseSuppressionImpl::speech_probability() const {
   rtc::CritScope cs(crit_);
 #if defined(WEBRTC_NS_FLOAT)
   float probability_average = 0.0f;
+  if (noise_suppressor_) {
+    for (size_t i = 0; i < noise_suppressor_->num_channels(); ++i) {
+      probability_average += noise_suppressor_->prior_speech_probability(i);
+    }
+    if (noise_suppressor_->num_channels() > 0) {
+      probability_average /= noise_suppressor_->num_channels();
+    }
+    return probability_average;
+  }
   for (auto& suppressor : suppressors_) {
     probability_average +=
         WebRtcNs_prior_speech_probability(suppressor->state());
@@ -176,8 +222,19 @@ std::vector<float> NoiseSuppressionImpl::NoiseEstimate() {
   rtc::CritScope cs(crit_);
   std::vector<float> noise_estimate;
 #if defined(WEBRTC_NS_FLOAT)
-  const float kNumChannelsFraction = 1.f / suppressors_.size();
   noise_estimate.assign(WebRtcNs_num_freq(), 0.f);
+  if (noise_suppressor_) {
+    const float kNumChannelsFraction = 1.f / noise_suppressor_->num_channels();
+    for (size_t i = 0; i < noise_suppressor_->num_channels(); ++i) {
+      rtc::ArrayView<const float, NoiseSuppressor::kNumFreqBins> noise =
+          noise_suppressor_->noise_estimate(i);
+      for (size_t j = 0; j < noise_estimate.size(); ++j) {
+        noise_estimate[j] += kNumChannelsFraction * noise[j];
+      }
+    }
+    return noise_estimate;
+  }
+  const float kNumChannelsFraction = 1.f / suppressors_.size();
   for (auto& suppressor : suppressors_) {
     const float* noise = WebRtcNs_noise_estimate(suppressor->state());
     for (size_t i = 0; i < noise_estimate.size(); ++i) {
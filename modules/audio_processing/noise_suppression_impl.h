@@ -21,6 +21,7 @@
 namespace webrtc {
 
 class AudioBuffer;
+class NoiseSuppressor;
 
 class NoiseSuppressionImpl : public NoiseSuppression {
  public:
@@ -44,11 +45,14 @@ class NoiseSuppressionImpl : public NoiseSuppression {
  private:
   class Suppressor;
   rtc::CriticalSection* const crit_;
+  // Whether the C++ NoiseSuppressor is used instead of the C implementation.
+  const bool use_noise_suppressor_;
   bool enabled_ RTC_GUARDED_BY(crit_) = false;
   Level level_ RTC_GUARDED_BY(crit_) = kModerate;
   size_t channels_ RTC_GUARDED_BY(crit_) = 0;
   int sample_rate_hz_ RTC_GUARDED_BY(crit_) = 0;
   std::vector<std::unique_ptr<Suppressor>> suppressors_ RTC_GUARDED_BY(crit_);
+  std::unique_ptr<NoiseSuppressor> noise_suppressor_ RTC_GUARDED_BY(crit_);
   RTC_DISALLOW_IMPLICIT_CONSTRUCTORS(NoiseSuppressionImpl);
 };
 }  // namespace webrtc
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "modules/audio_processing/ns/noise_suppression.h"
+#include "modules/audio_processing/ns/noise_suppressor.h"
+#include "rtc_base/random.h"
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kSampleRateHz = 48000;
+constexpr size_t kNumChannels = 2;
+constexpr size_t kNumBands = 3;
+constexpr size_t kNumFramesPerBand = 160;
+// Number of 10 ms frames processed per measurement.
+constexpr int kNumFrames = 3000;
+
+// Split band input of all channels, for all the frames of a measurement.
+class StereoInput {
+ public:
+  StereoInput() : random_(42) {
+    for (int frame = 0; frame < kNumFrames; ++frame) {
+      for (size_t ch = 0; ch < kNumChannels; ++ch) {
+        for (size_t band = 0; band < kNumBands; ++band) {
+          std::vector<float>& data = samples_[frame][ch][band];
+          data.resize(kNumFramesPerBand);
+          for (float& sample : data) {
+            sample = static_cast<float>(random_.Gaussian(0, 1000.0));
+          }
+          pointers_[frame][ch][band] = data.data();
+        }
+      }
+    }
+  }
+
+  const float* const* bands(int frame, size_t channel) const {
+    return pointers_[frame][channel].data();
+  }
+
+ private:
+  using Bands = std::array<std::vector<float>, kNumBands>;
+  Random random_;
+  std::array<std::array<Bands, kNumChannels>, kNumFrames> samples_;
+  std::array<std::array<std::array<const float*, kNumBands>, kNumChannels>,
+             kNumFrames>
+      pointers_;
+};
+
+class StereoOutput {
+ public:
+  StereoOutput() {
+    for (size_t ch = 0; ch < kNumChannels; ++ch) {
+      for (size_t band = 0; band < kNumBands; ++band) {
+        samples_[ch][band].resize(kNumFramesPerBand);
+        pointers_[ch][band] = samples_[ch][band].data();
+      }
+    }
+  }
+
+  float* const* bands(size_t channel) { return pointers_[channel].data(); }
+
+ private:
+  std::array<std::array<std::vector<float>, kNumBands>, kNumChannels> samples_;
+  std::array<std::array<float*, kNumBands>, kNumChannels> pointers_;
+};
+
+// Returns the average time in microseconds spent per 10 ms stereo frame.
+template <typename Function>
+double MeasureUs(Function process) {
+  const int64_t start_us = rtc::TimeMicros();
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    process(frame);
+  }
+  return static_cast<double>(rtc::TimeMicros() - start_us) / kNumFrames;
+}
+
+}  // namespace
+
+// Compares the CPU usage of the C noise suppressor and of NoiseSuppressor on
+// 48 kHz stereo audio, for all the suppression levels.
+TEST(NoiseSuppressionPerformanceTest, Stereo48kHz) {
+  std::unique_ptr<StereoInput> input(new StereoInput());
+  StereoOutput output;
+
+  for (int policy = 0; policy < 4; ++policy) {
+    rtc::StringBuilder trace;
+    trace << "level_" << policy;
+
+    std::array<NsHandle*, kNumChannels> handles;
+    for (NsHandle*& handle : handles) {
+      handle = WebRtcNs_Create();
+      ASSERT_EQ(0, WebRtcNs_Init(handle, kSampleRateHz));
+      ASSERT_EQ(0, WebRtcNs_set_policy(handle, policy));
+    }
+    test::PrintResult(
+        "ns_10ms_48k_stereo", "_c", trace.str(), MeasureUs([&](int frame) {
+          for (size_t ch = 0; ch < kNumChannels; ++ch) {
+            WebRtcNs_Analyze(handles[ch], input->bands(frame, ch)[0]);
+            WebRtcNs_Process(handles[ch], input->bands(frame, ch), kNumBands,
+                             output.bands(ch));
+          }
+        }),
+        "us", false);
+    for (NsHandle* handle : handles) {
+      WebRtcNs_Free(handle);
+    }
+
+    std::vector<std::pair<std::string, NoiseSuppressor::Optimization>>
+        optimizations = {{"_cpp", NoiseSuppressor::Optimization::kNone}};
+    if (NoiseSuppressor::DetectOptimization() ==
+        NoiseSuppressor::Optimization::kSse2) {
+      optimizations.emplace_back("_cpp_sse2",
+                                 NoiseSuppressor::Optimization::kSse2);
+    }
+    for (const auto& optimization : optimizations) {
+      NoiseSuppressor suppressor(kSampleRateHz, kNumChannels,
+                                 optimization.second);
+      ASSERT_TRUE(suppressor.SetPolicy(policy));
+      test::PrintResult(
+          "ns_10ms_48k_stereo", optimization.first, trace.str(),
+          MeasureUs([&](int frame) {
+            for (size_t ch = 0; ch < kNumChannels; ++ch) {
+              suppressor.Analyze(ch, input->bands(frame, ch)[0]);
+              suppressor.Process(ch, input->bands(frame, ch), kNumBands,
+                                 output.bands(ch));
+            }
+          }),
+          "us", false);
+    }
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,1051 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/ns/noise_suppressor.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "modules/audio_processing/ns/defines.h"
+#include "modules/audio_processing/ns/windows_private.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/system/arch.h"
+#include "system_wrappers/include/cpu_features_wrapper.h"
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+
+namespace webrtc {
+
+namespace {
+
+static_assert(NoiseSuppressor::kNumFreqBins == HALF_ANAL_BLOCKL, "");
+
+// Skip the first frequency bins when estimating the pink noise parameters.
+constexpr size_t kStartBand = 5;
+
+// Parameters for the feature extraction, see set_feature_extraction_parameters
+// in ns_core.c.
+constexpr float kBinSizeLrt = 0.1f;
+constexpr float kBinSizeSpecFlat = 0.05f;
+constexpr float kBinSizeSpecDiff = 0.1f;
+constexpr float kRangeAvgHistLrt = 1.f;
+constexpr float kFactor1ModelPars = 1.2f;
+constexpr float kFactor2ModelPars = 0.9f;
+constexpr float kThresPosSpecFlat = 0.6f;
+constexpr float kLimitPeakSpacingSpecFlat = 2 * kBinSizeSpecFlat;
+constexpr float kLimitPeakSpacingSpecDiff = 2 * kBinSizeSpecDiff;
+constexpr float kLimitPeakWeightsSpecFlat = 0.5f;
+constexpr float kLimitPeakWeightsSpecDiff = 0.5f;
+constexpr float kThresFluctLrt = 0.05f;
+constexpr float kMaxLrt = 1.f;
+constexpr float kMinLrt = 0.2f;
+constexpr float kMaxSpecFlat = 0.95f;
+constexpr float kMinSpecFlat = 0.1f;
+constexpr float kMaxSpecDiff = 1.f;
+constexpr float kMinSpecDiff = 0.16f;
+// Window length, in frames, over which the feature thresholds are estimated.
+constexpr int kFeatureUpdateWindowSize = 500;
+constexpr int kThresWeightSpecFlat =
+    static_cast<int>(0.3f * kFeatureUpdateWindowSize);
+constexpr int kThresWeightSpecDiff =
+    static_cast<int>(0.3f * kFeatureUpdateWindowSize);
+
+float SaturateToInt16Range(float value) {
+  return std::min(32767.f, std::max(-32768.f, value));
+}
+
+// Shifts |buffer| by |frame_length| samples and appends |frame|, or zeros if
+// |frame| is null.
+void UpdateBuffer(const float* frame,
+                  size_t frame_length,
+                  size_t buffer_length,
+                  float* buffer) {
+  RTC_DCHECK_LT(buffer_length, 2 * frame_length);
+  memcpy(buffer, buffer + frame_length,
+         sizeof(*buffer) * (buffer_length - frame_length));
+  if (frame) {
+    memcpy(buffer + buffer_length - frame_length, frame,
+           sizeof(*buffer) * frame_length);
+  } else {
+    memset(buffer + buffer_length - frame_length, 0,
+           sizeof(*buffer) * frame_length);
+  }
+}
+
+float Energy(const float* buffer, size_t length) {
+  float energy = 0.f;
+  for (size_t i = 0; i < length; ++i) {
+    energy += buffer[i] * buffer[i];
+  }
+  return energy;
+}
+
+// Finds the two highest peaks of |histogram| with bins of width |bin_size|.
+void FindHistogramPeaks(const int* histogram,
+                        float bin_size,
+                        float* position_peak1,
+                        int* weight_peak1,
+                        float* position_peak2,
+                        int* weight_peak2) {
+  int max_peak1 = 0;
+  int max_peak2 = 0;
+  *position_peak1 = 0.f;
+  *position_peak2 = 0.f;
+  *weight_peak1 = 0;
+  *weight_peak2 = 0;
+  for (int i = 0; i < HIST_PAR_EST; ++i) {
+    const float bin_mid = (static_cast<float>(i) + 0.5f) * bin_size;
+    if (histogram[i] > max_peak1) {
+      // Found new "first" peak.
+      max_peak2 = max_peak1;
+      *weight_peak2 = *weight_peak1;
+      *position_peak2 = *position_peak1;
+      max_peak1 = histogram[i];
+      *weight_peak1 = histogram[i];
+      *position_peak1 = bin_mid;
+    } else if (histogram[i] > max_peak2) {
+      // Found new "second" peak.
+      max_peak2 = histogram[i];
+      *weight_peak2 = histogram[i];
+      *position_peak2 = bin_mid;
+    }
+  }
+}
+
+// Computes the Wiener filter gain of bin |i|, see ComputeWienerFilter(). The
+// SIMD implementations perform the same operations in the same order.
+inline float WienerFilterBin(const float* magnitude,
+                             const float* noise,
+                             const float* noise_prev,
+                             const float* magn_prev_process,
+                             const float* init_magn_est,
+                             const float* parametric_noise,
+                             const float* smooth,
+                             float overdrive,
+                             float denoise_bound,
+                             bool startup,
+                             float block_ind,
+                             float startup_left,
+                             size_t i) {
+  // Previous estimate: based on previous frame with gain filter.
+  const float previous_estimate_stsa =
+      magn_prev_process[i] / (noise_prev[i] + 0.0001f) * smooth[i];
+  // Post and prior SNR.
+  float current_estimate_stsa = 0.f;
+  if (magnitude[i] > noise[i]) {
+    current_estimate_stsa = magnitude[i] / (noise[i] + 0.0001f) - 1.f;
+  }
+  // Directed decision update of the prior SNR.
+  const float snr_prior = DD_PR_SNR * previous_estimate_stsa +
+                          (1.f - DD_PR_SNR) * current_estimate_stsa;
+  float gain = snr_prior / (overdrive + snr_prior);
+  gain = std::min(std::max(gain, denoise_bound), 1.f);
+  if (startup) {
+    // Blend with the filter given by the parametric noise model.
+    float gain_model = (init_magn_est[i] - overdrive * parametric_noise[i]) /
+                       (init_magn_est[i] + 0.0001f);
+    gain_model = std::min(std::max(gain_model, denoise_bound), 1.f);
+    gain = (gain * block_ind + gain_model * startup_left) / END_STARTUP_SHORT;
+  }
+  return gain;
+}
+
+}  // namespace
+
+// Estimator state of one channel. The names follow those of
+// NoiseSuppressionC.
+struct NoiseSuppressor::ChannelState {
+  ChannelState() {
+    std::fill(std::begin(lquantile), std::end(lquantile), 8.f);
+    std::fill(std::begin(density), std::end(density), 0.3f);
+    for (int i = 0; i < SIMULT; ++i) {
+      counter[i] = static_cast<int>(
+          floor(static_cast<float>(END_STARTUP_LONG * (i + 1)) / SIMULT));
+    }
+    std::fill(std::begin(smooth), std::end(smooth), 1.f);
+    std::fill(std::begin(log_lrt_time_avg), std::end(log_lrt_time_avg),
+              LRT_FEATURE_THR);
+  }
+
+  float analyze_buf[ANAL_BLOCKL_MAX] = {};
+  float data_buf[ANAL_BLOCKL_MAX] = {};
+  float synt_buf[ANAL_BLOCKL_MAX] = {};
+  float data_buf_hb[NUM_HIGH_BANDS_MAX][ANAL_BLOCKL_MAX] = {};
+
+  // Quantile noise estimation.
+  float density[SIMULT * HALF_ANAL_BLOCKL];
+  float lquantile[SIMULT * HALF_ANAL_BLOCKL];
+  float quantile[HALF_ANAL_BLOCKL] = {};
+  int counter[SIMULT];
+  int updates = 0;
+
+  // Wiener filter.
+  float smooth[HALF_ANAL_BLOCKL];
+
+  int block_ind = -1;
+  // Update flag for the feature thresholds: 0 no update, 1 update once, 2
+  // update every window.
+  int update_pars_flag = 2;
+  // Frames left until the feature thresholds are updated.
+  int update_counter = kFeatureUpdateWindowSize;
+
+  // Thresholds and weights of the prior model.
+  float lrt_threshold = LRT_FEATURE_THR;
+  float spec_flat_threshold = 0.5f;
+  float spec_diff_threshold = 0.5f;
+  float lrt_weight = 1.f;
+  float spec_flat_weight = 0.f;
+  float spec_diff_weight = 0.f;
+
+  float noise[HALF_ANAL_BLOCKL] = {};
+  float noise_prev[HALF_ANAL_BLOCKL] = {};
+  float magn_prev_analyze[HALF_ANAL_BLOCKL] = {};
+  float magn_prev_process[HALF_ANAL_BLOCKL] = {};
+  float log_lrt_time_avg[HALF_ANAL_BLOCKL];
+  float prior_speech_prob = 0.5f;
+
+  // Features.
+  float spectral_flatness = SF_FEATURE_THR;
+  float lrt_feature = LRT_FEATURE_THR;
+  float spectral_diff = SF_FEATURE_THR;
+  float spectral_diff_norm = 0.f;
+  float signal_energy_sum = 0.f;
+
+  float magn_avg_pause[HALF_ANAL_BLOCKL] = {};
+  float signal_energy = 0.f;
+  float sum_magn = 0.f;
+  float white_noise_level = 0.f;
+  float init_magn_est[HALF_ANAL_BLOCKL] = {};
+  float pink_noise_numerator = 0.f;
+  float pink_noise_exp = 0.f;
+  float parametric_noise[HALF_ANAL_BLOCKL] = {};
+
+  int hist_lrt[HIST_PAR_EST] = {};
+  int hist_spec_flat[HIST_PAR_EST] = {};
+  int hist_spec_diff[HIST_PAR_EST] = {};
+
+  // Final speech probability, used for the high band gain.
+  float speech_prob[HALF_ANAL_BLOCKL] = {};
+};
+
+namespace {
+
+using ChannelState = NoiseSuppressor::ChannelState;
+
+void NoiseEstimation(const float* magnitude,
+                     size_t magn_len,
+                     ChannelState* st,
+                     float* noise) {
+  if (st->updates < END_STARTUP_LONG) {
+    st->updates++;
+  }
+
+  float lmagn[HALF_ANAL_BLOCKL];
+  for (size_t i = 0; i < magn_len; ++i) {
+    lmagn[i] = logf(magnitude[i]);
+  }
+
+  size_t offset = 0;
+  // Loop over simultaneous estimates.
+  for (int s = 0; s < SIMULT; ++s) {
+    offset = s * magn_len;
+    const float counter_plus_one = static_cast<float>(st->counter[s] + 1);
+    for (size_t i = 0; i < magn_len; ++i) {
+      float* lquantile = &st->lquantile[offset + i];
+      float* density = &st->density[offset + i];
+      const float delta = *density > 1.f ? FACTOR * 1.f / *density : FACTOR;
+      // Update log quantile estimate.
+      if (lmagn[i] > *lquantile) {
+        *lquantile += QUANTILE * delta / counter_plus_one;
+      } else {
+        *lquantile -= (1.f - QUANTILE) * delta / counter_plus_one;
+      }
+      // Update density estimate.
+      if (fabsf(lmagn[i] - *lquantile) < WIDTH) {
+        *density = (static_cast<float>(st->counter[s]) * *density +
+                    1.f / (2.f * WIDTH)) /
+                   counter_plus_one;
+      }
+    }
+
+    if (st->counter[s] >= END_STARTUP_LONG) {
+      st->counter[s] = 0;
+      if (st->updates >= END_STARTUP_LONG) {
+        for (size_t i = 0; i < magn_len; ++i) {
+          st->quantile[i] = expf(st->lquantile[offset + i]);
+        }
+      }
+    }
+    st->counter[s]++;
+  }
+
+  // Sequentially update the noise during startup, using the last estimate to
+  // get a noise that differs from zero.
+  if (st->updates < END_STARTUP_LONG) {
+    for (size_t i = 0; i < magn_len; ++i) {
+      st->quantile[i] = expf(st->lquantile[offset + i]);
+    }
+  }
+
+  memcpy(noise, st->quantile, sizeof(*noise) * magn_len);
+}
+
+// Updates the feature histograms, or extracts the thresholds and weights of
+// the prior model from them when |extract| is true.
+void FeatureParameterExtraction(bool extract, ChannelState* st) {
+  if (!extract) {
+    if (st->lrt_feature < HIST_PAR_EST * kBinSizeLrt &&
+        st->lrt_feature >= 0.f) {
+      st->hist_lrt[static_cast<int>(st->lrt_feature / kBinSizeLrt)]++;
+    }
+    if (st->spectral_flatness < HIST_PAR_EST * kBinSizeSpecFlat &&
+        st->spectral_flatness >= 0.f) {
+      st->hist_spec_flat[static_cast<int>(st->spectral_flatness /
+                                          kBinSizeSpecFlat)]++;
+    }
+    if (st->spectral_diff < HIST_PAR_EST * kBinSizeSpecDiff &&
+        st->spectral_diff >= 0.f) {
+      st->hist_spec_diff[static_cast<int>(st->spectral_diff /
+                                          kBinSizeSpecDiff)]++;
+    }
+    return;
+  }
+
+  // LRT feature: compute the average over kRangeAvgHistLrt.
+  float avg_hist_lrt = 0.f;
+  float avg_hist_lrt_compl = 0.f;
+  float avg_square_hist_lrt = 0.f;
+  int num_hist_lrt = 0;
+  for (int i = 0; i < HIST_PAR_EST; ++i) {
+    const float bin_mid = (static_cast<float>(i) + 0.5f) * kBinSizeLrt;
+    if (bin_mid <= kRangeAvgHistLrt) {
+      avg_hist_lrt += st->hist_lrt[i] * bin_mid;
+      num_hist_lrt += st->hist_lrt[i];
+    }
+    avg_square_hist_lrt += st->hist_lrt[i] * bin_mid * bin_mid;
+    avg_hist_lrt_compl += st->hist_lrt[i] * bin_mid;
+  }
+  if (num_hist_lrt > 0) {
+    avg_hist_lrt = avg_hist_lrt / static_cast<float>(num_hist_lrt);
+  }
+  avg_hist_lrt_compl = avg_hist_lrt_compl / kFeatureUpdateWindowSize;
+  avg_square_hist_lrt = avg_square_hist_lrt / kFeatureUpdateWindowSize;
+  const float fluct_lrt =
+      avg_square_hist_lrt - avg_hist_lrt * avg_hist_lrt_compl;
+  if (fluct_lrt < kThresFluctLrt) {
+    // Very low fluctuation, so likely noise.
+    st->lrt_threshold = kMaxLrt;
+  } else {
+    st->lrt_threshold = std::min(
+        std::max(kFactor1ModelPars * avg_hist_lrt, kMinLrt), kMaxLrt);
+  }
+
+  float pos_peak1_spec_flat, pos_peak2_spec_flat;
+  int weight_peak1_spec_flat, weight_peak2_spec_flat;
+  FindHistogramPeaks(st->hist_spec_flat, kBinSizeSpecFlat,
+                     &pos_peak1_spec_flat, &weight_peak1_spec_flat,
+                     &pos_peak2_spec_flat, &weight_peak2_spec_flat);
+  float pos_peak1_spec_diff, pos_peak2_spec_diff;
+  int weight_peak1_spec_diff, weight_peak2_spec_diff;
+  FindHistogramPeaks(st->hist_spec_diff, kBinSizeSpecDiff,
+                     &pos_peak1_spec_diff, &weight_peak1_spec_diff,
+                     &pos_peak2_spec_diff, &weight_peak2_spec_diff);
+
+  // Spectral flatness feature: merge the two peaks if they are close.
+  if (fabsf(pos_peak2_spec_flat - pos_peak1_spec_flat) <
+          kLimitPeakSpacingSpecFlat &&
+      weight_peak2_spec_flat >
+          kLimitPeakWeightsSpecFlat * weight_peak1_spec_flat) {
+    weight_peak1_spec_flat += weight_peak2_spec_flat;
+    pos_peak1_spec_flat = 0.5f * (pos_peak1_spec_flat + pos_peak2_spec_flat);
+  }
+  // Reject if weight of peaks is not large enough, or peak value too small.
+  const bool use_spec_flat = weight_peak1_spec_flat >= kThresWeightSpecFlat &&
+                             pos_peak1_spec_flat >= kThresPosSpecFlat;
+  if (use_spec_flat) {
+    st->spec_flat_threshold =
+        std::min(std::max(kFactor2ModelPars * pos_peak1_spec_flat,
+                          kMinSpecFlat),
+                 kMaxSpecFlat);
+  }
+
+  // Spectral difference feature: merge the two peaks if they are close.
+  if (fabsf(pos_peak2_spec_diff - pos_peak1_spec_diff) <
+          kLimitPeakSpacingSpecDiff &&
+      weight_peak2_spec_diff >
+          kLimitPeakWeightsSpecDiff * weight_peak1_spec_diff) {
+    weight_peak1_spec_diff += weight_peak2_spec_diff;
+    pos_peak1_spec_diff = 0.5f * (pos_peak1_spec_diff + pos_peak2_spec_diff);
+  }
+  st->spec_diff_threshold = std::min(
+      std::max(kFactor1ModelPars * pos_peak1_spec_diff, kMinSpecDiff),
+      kMaxSpecDiff);
+  // Reject if weight of peaks is not large enough, or if the fluctuation of
+  // the LRT feature is very low, which most likely means a noise state.
+  const bool use_spec_diff = weight_peak1_spec_diff >= kThresWeightSpecDiff &&
+                             fluct_lrt >= kThresFluctLrt;
+
+  // Select the weights between the features. The LRT is always used.
+  const float feature_sum =
+      static_cast<float>(1 + use_spec_flat + use_spec_diff);
+  st->lrt_weight = 1.f / feature_sum;
+  st->spec_flat_weight = static_cast<float>(use_spec_flat) / feature_sum;
+  st->spec_diff_weight = static_cast<float>(use_spec_diff) / feature_sum;
+
+  // Set histograms to zero for the next update.
+  if (st->update_pars_flag >= 1) {
+    std::fill(std::begin(st->hist_lrt), std::end(st->hist_lrt), 0);
+    std::fill(std::begin(st->hist_spec_flat), std::end(st->hist_spec_flat), 0);
+    std::fill(std::begin(st->hist_spec_diff), std::end(st->hist_spec_diff), 0);
+  }
+}
+
+void ComputeSpectralFlatness(const float* magnitude,
+                             size_t magn_len,
+                             ChannelState* st) {
+  // Compute log of ratio of the geometric to arithmetic mean, skipping the DC
+  // bin.
+  float avg_flatness_num = 0.f;
+  float avg_flatness_den = st->sum_magn - magnitude[0];
+  for (size_t i = 1; i < magn_len; ++i) {
+    if (magnitude[i] > 0.f) {
+      avg_flatness_num += logf(magnitude[i]);
+    } else {
+      st->spectral_flatness -= SPECT_FL_TAVG * st->spectral_flatness;
+      return;
+    }
+  }
+  avg_flatness_den = avg_flatness_den / magn_len;
+  avg_flatness_num = avg_flatness_num / magn_len;
+  const float flatness = expf(avg_flatness_num) / avg_flatness_den;
+  st->spectral_flatness += SPECT_FL_TAVG * (flatness - st->spectral_flatness);
+}
+
+// Computes the difference between the input spectrum and the conservative
+// noise spectrum estimated during pauses.
+void ComputeSpectralDifference(const float* magnitude,
+                               size_t magn_len,
+                               ChannelState* st) {
+  float avg_pause = 0.f;
+  for (size_t i = 0; i < magn_len; ++i) {
+    avg_pause += st->magn_avg_pause[i];
+  }
+  avg_pause /= magn_len;
+  const float avg_magn = st->sum_magn / magn_len;
+
+  float cov_magn_pause = 0.f;
+  float var_pause = 0.f;
+  float var_magn = 0.f;
+  for (size_t i = 0; i < magn_len; ++i) {
+    const float magn_diff = magnitude[i] - avg_magn;
+    const float pause_diff = st->magn_avg_pause[i] - avg_pause;
+    cov_magn_pause += magn_diff * pause_diff;
+    var_pause += pause_diff * pause_diff;
+    var_magn += magn_diff * magn_diff;
+  }
+  cov_magn_pause /= magn_len;
+  var_pause /= magn_len;
+  var_magn /= magn_len;
+  st->signal_energy_sum += st->signal_energy;
+
+  float avg_diff_norm_magn =
+      var_magn - (cov_magn_pause * cov_magn_pause) / (var_pause + 0.0001f);
+  avg_diff_norm_magn /= st->spectral_diff_norm + 0.0001f;
+  st->spectral_diff +=
+      SPECT_DIFF_TAVG * (avg_diff_norm_magn - st->spectral_diff);
+}
+
+void FeatureUpdate(const float* magnitude,
+                   size_t magn_len,
+                   int update_pars_flag,
+                   ChannelState* st) {
+  ComputeSpectralFlatness(magnitude, magn_len, st);
+  ComputeSpectralDifference(magnitude, magn_len, st);
+  // The feature thresholds are extracted once every window.
+  if (update_pars_flag < 1) {
+    return;
+  }
+  st->update_counter--;
+  if (st->update_counter > 0) {
+    FeatureParameterExtraction(false, st);
+  }
+  if (st->update_counter == 0) {
+    FeatureParameterExtraction(true, st);
+    st->update_counter = kFeatureUpdateWindowSize;
+    if (update_pars_flag == 1) {
+      st->update_pars_flag = 0;
+    } else {
+      // Get the normalization of the spectral difference for the next window.
+      st->signal_energy_sum /= kFeatureUpdateWindowSize;
+      st->spectral_diff_norm =
+          0.5f * (st->signal_energy_sum + st->spectral_diff_norm);
+      st->signal_energy_sum = 0.f;
+    }
+  }
+}
+
+void SpeechNoiseProb(const float* snr_loc_prior,
+                     const float* snr_loc_post,
+                     size_t magn_len,
+                     ChannelState* st) {
+  constexpr float kWidthPrior0 = WIDTH_PR_MAP;
+  // Width for pause region: lower range, so increase width in tanh map.
+  constexpr float kWidthPrior1 = 2.f * WIDTH_PR_MAP;
+  constexpr float kWidthPrior2 = 2.f * WIDTH_PR_MAP;
+
+  // Average over all frequencies of the smoothed log LRT.
+  float log_lrt_time_avg_ksum = 0.f;
+  for (size_t i = 0; i < magn_len; ++i) {
+    const float tmp1 = 1.f + 2.f * snr_loc_prior[i];
+    const float tmp2 = 2.f * snr_loc_prior[i] / (tmp1 + 0.0001f);
+    const float bessel_tmp = (snr_loc_post[i] + 1.f) * tmp2;
+    st->log_lrt_time_avg[i] +=
+        LRT_TAVG * (bessel_tmp - logf(tmp1) - st->log_lrt_time_avg[i]);
+    log_lrt_time_avg_ksum += st->log_lrt_time_avg[i];
+  }
+  log_lrt_time_avg_ksum /= magn_len;
+  st->lrt_feature = log_lrt_time_avg_ksum;
+
+  // Indicator functions: sigmoid maps of the features, with a larger width in
+  // pause regions.
+  float width = log_lrt_time_avg_ksum < st->lrt_threshold ? kWidthPrior1
+                                                          : kWidthPrior0;
+  const float indicator0 =
+      0.5f *
+      (tanhf(width * (log_lrt_time_avg_ksum - st->lrt_threshold)) + 1.f);
+
+  // The sign of the spectral flatness map is always 1.
+  width = st->spectral_flatness > st->spec_flat_threshold ? kWidthPrior1
+                                                          : kWidthPrior0;
+  const float indicator1 =
+      0.5f *
+      (tanhf(width * (st->spec_flat_threshold - st->spectral_flatness)) + 1.f);
+
+  width = st->spectral_diff < st->spec_diff_threshold ? kWidthPrior2
+                                                      : kWidthPrior0;
+  const float indicator2 =
+      0.5f * (tanhf(width * (st->spectral_diff - st->spec_diff_threshold)) +
+              1.f);
+
+  const float ind_prior = st->lrt_weight * indicator0 +
+                          st->spec_flat_weight * indicator1 +
+                          st->spec_diff_weight * indicator2;
+
+  st->prior_speech_prob += PRIOR_UPDATE * (ind_prior - st->prior_speech_prob);
+  st->prior_speech_prob = std::min(std::max(st->prior_speech_prob, 0.01f), 1.f);
+
+  // Final speech probability: combine the prior model with the LR factor.
+  const float gain_prior =
+      (1.f - st->prior_speech_prob) / (st->prior_speech_prob + 0.0001f);
+  for (size_t i = 0; i < magn_len; ++i) {
+    const float inv_lrt = gain_prior * expf(-st->log_lrt_time_avg[i]);
+    st->speech_prob[i] = 1.f / (1.f + inv_lrt);
+  }
+}
+
+void UpdateNoiseEstimate(const float* magnitude,
+                         size_t magn_len,
+                         ChannelState* st,
+                         float* noise) {
+  // As in ns_core.c, the temporary update of each bin uses the time constant
+  // selected for the previous bin.
+  float gamma = NOISE_UPDATE;
+  for (size_t i = 0; i < magn_len; ++i) {
+    const float prob_speech = st->speech_prob[i];
+    const float prob_non_speech = 1.f - prob_speech;
+    // Temporary noise update, used for speech frames if the update value is
+    // less than the previous one.
+    const float noise_update_tmp =
+        gamma * st->noise_prev[i] +
+        (1.f - gamma) *
+            (prob_non_speech * magnitude[i] + prob_speech * st->noise_prev[i]);
+    // Less noise update for frames likely to be speech.
+    const float gamma_old = gamma;
+    gamma = prob_speech > PROB_RANGE ? SPEECH_UPDATE : NOISE_UPDATE;
+    // Conservative noise update.
+    if (prob_speech < PROB_RANGE) {
+      st->magn_avg_pause[i] +=
+          GAMMA_PAUSE * (magnitude[i] - st->magn_avg_pause[i]);
+    }
+    if (gamma == gamma_old) {
+      noise[i] = noise_update_tmp;
+    } else {
+      noise[i] = gamma * st->noise_prev[i] +
+                 (1.f - gamma) * (prob_non_speech * magnitude[i] +
+                                  prob_speech * st->noise_prev[i]);
+      // Allow for noise update downwards.
+      noise[i] = std::min(noise[i], noise_update_tmp);
+    }
+  }
+}
+
+}  // namespace
+
+NoiseSuppressor::NoiseSuppressor(int sample_rate_hz, size_t num_channels)
+    : NoiseSuppressor(sample_rate_hz, num_channels, DetectOptimization()) {}
+
+NoiseSuppressor::NoiseSuppressor(int sample_rate_hz,
+                                 size_t num_channels,
+                                 Optimization optimization)
+    : optimization_(optimization),
+      block_len_(sample_rate_hz == 8000 ? 80 : 160),
+      ana_len_(sample_rate_hz == 8000 ? 128 : 256),
+      magn_len_(ana_len_ / 2 + 1),
+      window_(sample_rate_hz == 8000 ? kBlocks80w128 : kBlocks160w256),
+      fft_(ana_len_, Pffft::FftType::kReal),
+      time_data_(fft_.CreateBuffer()),
+      spectrum_(fft_.CreateBuffer()) {
+  RTC_DCHECK(sample_rate_hz == 8000 || sample_rate_hz == 16000 ||
+             sample_rate_hz == 32000 || sample_rate_hz == 48000);
+  for (size_t i = 0; i < num_channels; ++i) {
+    channels_.emplace_back(new ChannelState());
+  }
+  SetPolicy(0);
+}
+
+NoiseSuppressor::~NoiseSuppressor() = default;
+
+NoiseSuppressor::Optimization NoiseSuppressor::DetectOptimization() {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2) != 0) {
+    return Optimization::kSse2;
+  }
+#endif
+  return Optimization::kNone;
+}
+
+bool NoiseSuppressor::SetPolicy(int policy) {
+  switch (policy) {
+    case 0:
+      overdrive_ = 1.f;
+      denoise_bound_ = 0.5f;
+      gainmap_ = false;
+      return true;
+    case 1:
+      overdrive_ = 1.f;
+      denoise_bound_ = 0.25f;
+      gainmap_ = true;
+      return true;
+    case 2:
+      overdrive_ = 1.1f;
+      denoise_bound_ = 0.125f;
+      gainmap_ = true;
+      return true;
+    case 3:
+      overdrive_ = 1.25f;
+      denoise_bound_ = 0.09f;
+      gainmap_ = true;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void NoiseSuppressor::Analyze(size_t channel, const float* frame) {
+  RTC_DCHECK_LT(channel, channels_.size());
+  ChannelState* st = channels_[channel].get();
+  const int update_pars_flag = st->update_pars_flag;
+
+  UpdateBuffer(frame, block_len_, ana_len_, st->analyze_buf);
+
+  float* time_data = time_data_->GetView().data();
+  Windowing(st->analyze_buf, time_data);
+  if (Energy(time_data, ana_len_) == 0.f) {
+    // Avoid updating the statistics on all-zero input, since that moves the
+    // thresholds towards zero signal and would make everything be treated as
+    // speech once the signal is turned on.
+    st->signal_energy = 0.f;
+    return;
+  }
+
+  st->block_ind++;
+
+  fft_.ForwardTransform(*time_data_, spectrum_.get(), /*ordered=*/true);
+  float magnitude[HALF_ANAL_BLOCKL];
+  ComputeMagnitude(magnitude);
+
+  const float* spectrum = spectrum_->GetConstView().data();
+  const bool startup = st->block_ind < END_STARTUP_SHORT;
+  float signal_energy = spectrum[0] * spectrum[0];
+  float sum_magn = magnitude[0];
+  float sum_log_i = 0.f;
+  float sum_log_i_square = 0.f;
+  float sum_log_magn = 0.f;
+  float sum_log_i_log_magn = 0.f;
+  for (size_t i = 1; i < magn_len_; ++i) {
+    if (i < magn_len_ - 1) {
+      signal_energy += spectrum[2 * i] * spectrum[2 * i] +
+                       spectrum[2 * i + 1] * spectrum[2 * i + 1];
+    } else {
+      signal_energy += spectrum[1] * spectrum[1];
+    }
+    sum_magn += magnitude[i];
+    if (startup && i >= kStartBand) {
+      const float log_i = logf(static_cast<float>(i));
+      sum_log_i += log_i;
+      sum_log_i_square += log_i * log_i;
+      const float log_magn = logf(magnitude[i]);
+      sum_log_magn += log_magn;
+      sum_log_i_log_magn += log_i * log_magn;
+    }
+  }
+  signal_energy /= magn_len_;
+  st->signal_energy = signal_energy;
+  st->sum_magn = sum_magn;
+
+  // Quantile noise estimate.
+  float noise[HALF_ANAL_BLOCKL];
+  NoiseEstimation(magnitude, magn_len_, st, noise);
+
+  // Simplified parametric noise model during startup.
+  if (startup) {
+    // White noise.
+    st->white_noise_level += sum_magn / magn_len_ * overdrive_;
+    // Pink noise parameters.
+    const float num_log_bins = static_cast<float>(magn_len_ - kStartBand);
+    const float den = sum_log_i_square * num_log_bins - sum_log_i * sum_log_i;
+    const float numerator =
+        (sum_log_i_square * sum_log_magn - sum_log_i * sum_log_i_log_magn) /
+        den;
+    st->pink_noise_numerator += std::max(numerator, 0.f);
+    const float exponent =
+        (sum_log_i * sum_log_magn - num_log_bins * sum_log_i_log_magn) / den;
+    st->pink_noise_exp += std::min(std::max(exponent, 0.f), 1.f);
+
+    // Frequency independent parts of the parametric noise estimate.
+    float parametric_num = 0.f;
+    float parametric_exp = 0.f;
+    const float num_blocks = static_cast<float>(st->block_ind + 1);
+    if (st->pink_noise_exp > 0.f) {
+      parametric_num = expf(st->pink_noise_numerator / num_blocks) * num_blocks;
+      parametric_exp = st->pink_noise_exp / num_blocks;
+    }
+    for (size_t i = 0; i < magn_len_; ++i) {
+      if (st->pink_noise_exp == 0.f) {
+        st->parametric_noise[i] = st->white_noise_level;
+      } else {
+        const float use_band =
+            static_cast<float>(i < kStartBand ? kStartBand : i);
+        st->parametric_noise[i] =
+            parametric_num / powf(use_band, parametric_exp);
+      }
+      // Weight the quantile noise with the modeled noise.
+      noise[i] *= st->block_ind;
+      noise[i] += st->parametric_noise[i] *
+                  (END_STARTUP_SHORT - st->block_ind) / num_blocks;
+      noise[i] /= END_STARTUP_SHORT;
+    }
+  }
+
+  // Average signal energy during the long startup, used to normalize the
+  // spectral difference measure.
+  if (st->block_ind < END_STARTUP_LONG) {
+    st->spectral_diff_norm *= st->block_ind;
+    st->spectral_diff_norm += signal_energy;
+    st->spectral_diff_norm /= st->block_ind + 1;
+  }
+
+  // Post and decision-directed prior SNR.
+  float snr_loc_prior[HALF_ANAL_BLOCKL];
+  float snr_loc_post[HALF_ANAL_BLOCKL];
+  for (size_t i = 0; i < magn_len_; ++i) {
+    const float previous_estimate_stsa = st->magn_prev_analyze[i] /
+                                         (st->noise_prev[i] + 0.0001f) *
+                                         st->smooth[i];
+    snr_loc_post[i] = 0.f;
+    if (magnitude[i] > noise[i]) {
+      snr_loc_post[i] = magnitude[i] / (noise[i] + 0.0001f) - 1.f;
+    }
+    snr_loc_prior[i] = DD_PR_SNR * previous_estimate_stsa +
+                       (1.f - DD_PR_SNR) * snr_loc_post[i];
+  }
+
+  FeatureUpdate(magnitude, magn_len_, update_pars_flag, st);
+  SpeechNoiseProb(snr_loc_prior, snr_loc_post, magn_len_, st);
+  UpdateNoiseEstimate(magnitude, magn_len_, st, noise);
+
+  // Keep track of the noise and magnitude spectra for the next frame.
+  memcpy(st->noise, noise, sizeof(*noise) * magn_len_);
+  memcpy(st->magn_prev_analyze, magnitude, sizeof(*magnitude) * magn_len_);
+}
+
+void NoiseSuppressor::Process(size_t channel,
+                              const float* const* in,
+                              size_t num_bands,
+                              float* const* out) {
+  RTC_DCHECK_LT(channel, channels_.size());
+  RTC_DCHECK_GE(num_bands, 1);
+  RTC_DCHECK_LE(num_bands - 1, NUM_HIGH_BANDS_MAX);
+  ChannelState* st = channels_[channel].get();
+  const size_t num_high_bands = num_bands - 1;
+
+  UpdateBuffer(in[0], block_len_, ana_len_, st->data_buf);
+  for (size_t i = 0; i < num_high_bands; ++i) {
+    UpdateBuffer(in[i + 1], block_len_, ana_len_, st->data_buf_hb[i]);
+  }
+
+  float* time_data = time_data_->GetView().data();
+  Windowing(st->data_buf, time_data);
+  const float energy_before = Energy(time_data, ana_len_);
+  if (energy_before == 0.f || st->signal_energy == 0.f) {
+    // Read out the fully processed segment and pass the high bands through.
+    for (size_t i = 0; i < block_len_; ++i) {
+      out[0][i] = SaturateToInt16Range(st->synt_buf[i]);
+    }
+    UpdateBuffer(nullptr, block_len_, ana_len_, st->synt_buf);
+    for (size_t i = 0; i < num_high_bands; ++i) {
+      for (size_t j = 0; j < block_len_; ++j) {
+        out[i + 1][j] = SaturateToInt16Range(st->data_buf_hb[i][j]);
+      }
+    }
+    return;
+  }
+
+  fft_.ForwardTransform(*time_data_, spectrum_.get(), /*ordered=*/true);
+  float magnitude[HALF_ANAL_BLOCKL];
+  ComputeMagnitude(magnitude);
+
+  if (st->block_ind < END_STARTUP_SHORT) {
+    for (size_t i = 0; i < magn_len_; ++i) {
+      st->init_magn_est[i] += magnitude[i];
+    }
+  }
+
+  ComputeWienerFilter(magnitude, st);
+  ApplyGain(st->smooth);
+
+  // Keep track of the magnitude spectrum for the next frame.
+  memcpy(st->magn_prev_process, magnitude, sizeof(*magnitude) * magn_len_);
+  memcpy(st->noise_prev, st->noise, sizeof(st->noise[0]) * magn_len_);
+
+  // Back to time domain.
+  fft_.BackwardTransform(*spectrum_, time_data_.get(), /*ordered=*/true);
+  const float fft_scaling = 1.f / ana_len_;
+  for (size_t i = 0; i < ana_len_; ++i) {
+    time_data[i] *= fft_scaling;
+  }
+
+  // Scale factor: only applied after END_STARTUP_LONG time.
+  float factor = 1.f;
+  if (gainmap_ && st->block_ind > END_STARTUP_LONG) {
+    float factor1 = 1.f;
+    float factor2 = 1.f;
+    const float energy_after = Energy(time_data, ana_len_);
+    float gain = sqrtf(energy_after / (energy_before + 1.f));
+    if (gain > B_LIM) {
+      factor1 = 1.f + 1.3f * (gain - B_LIM);
+      if (gain * factor1 > 1.f) {
+        factor1 = 1.f / gain;
+      }
+    }
+    if (gain < B_LIM) {
+      // Don't reduce the scale too much in pause regions, the attenuation
+      // there is controlled by the flooring.
+      gain = std::max(gain, denoise_bound_);
+      factor2 = 1.f - 0.3f * (B_LIM - gain);
+    }
+    // Combine both scales with the (frequency independent) prior speech
+    // probability.
+    factor = st->prior_speech_prob * factor1 +
+             (1.f - st->prior_speech_prob) * factor2;
+  }
+
+  // Synthesis.
+  Windowing(time_data, time_data);
+  for (size_t i = 0; i < ana_len_; ++i) {
+    st->synt_buf[i] += factor * time_data[i];
+  }
+  for (size_t i = 0; i < block_len_; ++i) {
+    out[0][i] = SaturateToInt16Range(st->synt_buf[i]);
+  }
+  UpdateBuffer(nullptr, block_len_, ana_len_, st->synt_buf);
+
+  if (num_high_bands == 0) {
+    return;
+  }
+
+  // Time-domain gain of the high bands, based on the speech probability and
+  // the filter gain over the upper half (4-8 kHz) of the low band.
+  const size_t delta_hb = magn_len_ / 4;
+  float avg_prob_speech_hb = 0.f;
+  float avg_filter_gain_hb = 0.f;
+  for (size_t i = magn_len_ - delta_hb - 1; i < magn_len_ - 1; ++i) {
+    avg_prob_speech_hb += st->speech_prob[i];
+    avg_filter_gain_hb += st->smooth[i];
+  }
+  avg_prob_speech_hb /= delta_hb;
+  avg_filter_gain_hb /= delta_hb;
+  // If the speech was suppressed by a component between Analyze and Process,
+  // for example the AEC, it should not be considered speech for the purpose
+  // of high band suppression.
+  float sum_magn_analyze = 0.f;
+  float sum_magn_process = 0.f;
+  for (size_t i = 0; i < magn_len_; ++i) {
+    sum_magn_analyze += st->magn_prev_analyze[i];
+    sum_magn_process += st->magn_prev_process[i];
+  }
+  RTC_DCHECK_GT(sum_magn_analyze, 0);
+  avg_prob_speech_hb *= sum_magn_process / sum_magn_analyze;
+  const float gain_mod_hb =
+      0.5f * (1.f + tanhf(2.f * avg_prob_speech_hb - 1.f));
+  float gain_hb = avg_prob_speech_hb >= 0.5f
+                      ? 0.25f * gain_mod_hb + 0.75f * avg_filter_gain_hb
+                      : 0.5f * gain_mod_hb + 0.5f * avg_filter_gain_hb;
+  gain_hb = std::min(std::max(gain_hb, denoise_bound_), 1.f);
+  for (size_t i = 0; i < num_high_bands; ++i) {
+    for (size_t j = 0; j < block_len_; ++j) {
+      out[i + 1][j] = SaturateToInt16Range(gain_hb * st->data_buf_hb[i][j]);
+    }
+  }
+}
+
+float NoiseSuppressor::prior_speech_probability(size_t channel) const {
+  RTC_DCHECK_LT(channel, channels_.size());
+  return channels_[channel]->prior_speech_prob;
+}
+
+rtc::ArrayView<const float, NoiseSuppressor::kNumFreqBins>
+NoiseSuppressor::noise_estimate(size_t channel) const {
+  RTC_DCHECK_LT(channel, channels_.size());
+  return channels_[channel]->noise;
+}
+
+void NoiseSuppressor::ComputeMagnitude(float* magnitude) const {
+  // The ordered real PFFFT output is [DC, Nyquist, re(1), im(1), ...].
+  const float* spectrum = spectrum_->GetConstView().data();
+  const size_t half_len = ana_len_ / 2;
+  size_t i = 1;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (optimization_ == Optimization::kSse2) {
+    const __m128 one = _mm_set1_ps(1.f);
+    for (; i + 4 <= half_len; i += 4) {
+      const __m128 a = _mm_loadu_ps(&spectrum[2 * i]);
+      const __m128 b = _mm_loadu_ps(&spectrum[2 * i + 4]);
+      const __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+      const __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+      const __m128 power =
+          _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+      _mm_storeu_ps(&magnitude[i], _mm_add_ps(_mm_sqrt_ps(power), one));
+    }
+  }
+#endif
+  for (; i < half_len; ++i) {
+    const float re = spectrum[2 * i];
+    const float im = spectrum[2 * i + 1];
+    magnitude[i] = sqrtf(re * re + im * im) + 1.f;
+  }
+  magnitude[0] = fabsf(spectrum[0]) + 1.f;
+  magnitude[half_len] = fabsf(spectrum[1]) + 1.f;
+}
+
+void NoiseSuppressor::ComputeWienerFilter(const float* magnitude,
+                                          ChannelState* st) const {
+  const bool startup = st->block_ind < END_STARTUP_SHORT;
+  const float block_ind = static_cast<float>(st->block_ind);
+  const float startup_left =
+      static_cast<float>(END_STARTUP_SHORT - st->block_ind);
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (optimization_ == Optimization::kSse2) {
+    const __m128 eps = _mm_set1_ps(0.0001f);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 dd_pr_snr = _mm_set1_ps(DD_PR_SNR);
+    const __m128 one_minus_dd_pr_snr = _mm_set1_ps(1.f - DD_PR_SNR);
+    const __m128 overdrive = _mm_set1_ps(overdrive_);
+    const __m128 denoise_bound = _mm_set1_ps(denoise_bound_);
+    const __m128 block_ind_v = _mm_set1_ps(block_ind);
+    const __m128 startup_left_v = _mm_set1_ps(startup_left);
+    const __m128 end_startup = _mm_set1_ps(END_STARTUP_SHORT);
+    for (; i + 4 <= magn_len_; i += 4) {
+      const __m128 magn = _mm_loadu_ps(&magnitude[i]);
+      const __m128 noise = _mm_loadu_ps(&st->noise[i]);
+      const __m128 previous_estimate_stsa = _mm_mul_ps(
+          _mm_div_ps(_mm_loadu_ps(&st->magn_prev_process[i]),
+                     _mm_add_ps(_mm_loadu_ps(&st->noise_prev[i]), eps)),
+          _mm_loadu_ps(&st->smooth[i]));
+      const __m128 current_estimate_stsa = _mm_and_ps(
+          _mm_cmpgt_ps(magn, noise),
+          _mm_sub_ps(_mm_div_ps(magn, _mm_add_ps(noise, eps)), one));
+      const __m128 snr_prior =
+          _mm_add_ps(_mm_mul_ps(dd_pr_snr, previous_estimate_stsa),
+                     _mm_mul_ps(one_minus_dd_pr_snr, current_estimate_stsa));
+      __m128 gain = _mm_div_ps(snr_prior, _mm_add_ps(overdrive, snr_prior));
+      gain = _mm_min_ps(_mm_max_ps(gain, denoise_bound), one);
+      if (startup) {
+        const __m128 init_magn_est = _mm_loadu_ps(&st->init_magn_est[i]);
+        __m128 gain_model = _mm_div_ps(
+            _mm_sub_ps(init_magn_est,
+                       _mm_mul_ps(overdrive,
+                                  _mm_loadu_ps(&st->parametric_noise[i]))),
+            _mm_add_ps(init_magn_est, eps));
+        gain_model = _mm_min_ps(_mm_max_ps(gain_model, denoise_bound), one);
+        gain = _mm_div_ps(_mm_add_ps(_mm_mul_ps(gain, block_ind_v),
+                                     _mm_mul_ps(gain_model, startup_left_v)),
+                          end_startup);
+      }
+      _mm_storeu_ps(&st->smooth[i], gain);
+    }
+  }
+#endif
+  for (; i < magn_len_; ++i) {
+    st->smooth[i] = WienerFilterBin(
+        magnitude, st->noise, st->noise_prev, st->magn_prev_process,
+        st->init_magn_est, st->parametric_noise, st->smooth, overdrive_,
+        denoise_bound_, startup, block_ind, startup_left, i);
+  }
+}
+
+void NoiseSuppressor::ApplyGain(const float* gain) {
+  float* spectrum = spectrum_->GetView().data();
+  const size_t half_len = ana_len_ / 2;
+  const float nyquist = spectrum[1] * gain[half_len];
+  // The imaginary part of the DC bin is zero, so the Nyquist value that is
+  // stored there is temporarily replaced to let all bins be handled alike.
+  spectrum[1] = 0.f;
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (optimization_ == Optimization::kSse2) {
+    for (; i + 4 <= half_len; i += 4) {
+      const __m128 g = _mm_loadu_ps(&gain[i]);
+      float* bins = &spectrum[2 * i];
+      _mm_storeu_ps(bins,
+                    _mm_mul_ps(_mm_loadu_ps(bins), _mm_unpacklo_ps(g, g)));
+      _mm_storeu_ps(bins + 4,
+                    _mm_mul_ps(_mm_loadu_ps(bins + 4), _mm_unpackhi_ps(g, g)));
+    }
+  }
+#endif
+  for (; i < half_len; ++i) {
+    spectrum[2 * i] *= gain[i];
+    spectrum[2 * i + 1] *= gain[i];
+  }
+  spectrum[1] = nyquist;
+}
+
+void NoiseSuppressor::Windowing(const float* data, float* data_windowed) const {
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (optimization_ == Optimization::kSse2) {
+    for (; i + 4 <= ana_len_; i += 4) {
+      _mm_storeu_ps(&data_windowed[i], _mm_mul_ps(_mm_loadu_ps(&window_[i]),
+                                                  _mm_loadu_ps(&data[i])));
+    }
+  }
+#endif
+  for (; i < ana_len_; ++i) {
+    data_windowed[i] = window_[i] * data[i];
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_NS_NOISE_SUPPRESSOR_H_
+#define MODULES_AUDIO_PROCESSING_NS_NOISE_SUPPRESSOR_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "api/array_view.h"
+#include "modules/audio_processing/utility/pffft_wrapper.h"
+#include "rtc_base/constructor_magic.h"
+
+namespace webrtc {
+
+// C++ implementation of the floating point noise suppressor in ns_core.c. The
+// FFTs are computed with PFFFT, and the spectral magnitude, Wiener filter and
+// gain application are vectorized where the CPU allows it. A single instance
+// handles all the channels of a stream: the FFT setup, window and scratch
+// buffers are shared and only the estimator state is kept per channel.
+class NoiseSuppressor {
+ public:
+  enum class Optimization { kNone, kSse2 };
+
+  // Number of frequency bins in the noise estimate, independent of the sample
+  // rate. Bins above the analysis bandwidth are zero.
+  static constexpr size_t kNumFreqBins = 129;
+
+  // |sample_rate_hz| must be 8000, 16000, 32000 or 48000.
+  NoiseSuppressor(int sample_rate_hz, size_t num_channels);
+  NoiseSuppressor(int sample_rate_hz,
+                  size_t num_channels,
+                  Optimization optimization);
+  ~NoiseSuppressor();
+
+  // Returns the fastest implementation available on this CPU.
+  static Optimization DetectOptimization();
+
+  // Changes the aggressiveness of the suppression: 0 is mild (6 dB), 1 is
+  // medium (10 dB), 2 is aggressive (15 dB) and 3 is the most aggressive.
+  // Returns false if |policy| is out of range.
+  bool SetPolicy(int policy);
+
+  // Updates the noise estimate of |channel| with a 10 ms frame of its lowest
+  // band, without modifying it.
+  void Analyze(size_t channel, const float* frame);
+
+  // Suppresses the noise in the |num_bands| 10 ms bands of |channel|. |in| and
+  // |out| may point to the same buffers.
+  void Process(size_t channel,
+               const float* const* in,
+               size_t num_bands,
+               float* const* out);
+
+  // Returns the prior speech probability of the latest frame of |channel|.
+  float prior_speech_probability(size_t channel) const;
+
+  // Returns the current noise magnitude spectrum of |channel|.
+  rtc::ArrayView<const float, kNumFreqBins> noise_estimate(
+      size_t channel) const;
+
+  size_t num_channels() const { return channels_.size(); }
+
+  // Estimator state of one channel, defined in the .cc file.
+  struct ChannelState;
+
+ private:
+  // Computes the magnitude spectrum of the ordered PFFFT output in
+  // |spectrum_|.
+  void ComputeMagnitude(float* magnitude) const;
+  // Computes the decision-directed Wiener filter of |state|, floored and
+  // blended with the startup noise model, and stores it as the new smoothed
+  // gain.
+  void ComputeWienerFilter(const float* magnitude, ChannelState* state) const;
+  // Multiplies the spectrum in |spectrum_| by |gain|.
+  void ApplyGain(const float* gain);
+  // Multiplies |ana_len_| samples of |data| by the analysis window.
+  void Windowing(const float* data, float* data_windowed) const;
+
+  const Optimization optimization_;
+  const size_t block_len_;
+  const size_t ana_len_;
+  const size_t magn_len_;
+  const float* const window_;
+
+  float overdrive_;
+  float denoise_bound_;
+  bool gainmap_;
+
+  Pffft fft_;
+  std::unique_ptr<Pffft::FloatBuffer> time_data_;
+  std::unique_ptr<Pffft::FloatBuffer> spectrum_;
+  std::vector<std::unique_ptr<ChannelState>> channels_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(NoiseSuppressor);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_NS_NOISE_SUPPRESSOR_H_
@@ -0,0 +1,223 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/ns/noise_suppressor.h"
+
+#include <math.h>
+
+#include <array>
+#include <vector>
+
+#include "modules/audio_processing/ns/noise_suppression.h"
+#include "rtc_base/random.h"
+#include "rtc_base/strings/string_builder.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kMaxNumBands = 3;
+
+// Produces the split bands of a stationary noise with periodic tone bursts in
+// the lowest band, which lets the suppressor go through both speech and noise
+// states.
+class BandsGenerator {
+ public:
+  BandsGenerator(int sample_rate_hz, uint64_t seed)
+      : num_bands_(sample_rate_hz <= 16000 ? 1 : sample_rate_hz / 16000),
+        num_frames_(sample_rate_hz == 8000 ? 80 : 160),
+        random_(seed) {
+    for (auto& band : bands_) {
+      band.resize(num_frames_);
+    }
+    for (size_t i = 0; i < kMaxNumBands; ++i) {
+      in_[i] = bands_[i].data();
+    }
+  }
+
+  void Generate() {
+    const bool burst = (frame_index_ / 50) % 2 == 1;
+    for (size_t k = 0; k < num_bands_; ++k) {
+      for (size_t i = 0; i < num_frames_; ++i) {
+        bands_[k][i] = static_cast<float>(random_.Gaussian(0, 300.0));
+        if (k == 0 && burst) {
+          bands_[k][i] +=
+              3000.f * sinf(0.2f * (frame_index_ * num_frames_ + i));
+        }
+      }
+    }
+    ++frame_index_;
+  }
+
+  const float* const* bands() const { return in_.data(); }
+  size_t num_bands() const { return num_bands_; }
+  size_t num_frames() const { return num_frames_; }
+
+ private:
+  const size_t num_bands_;
+  const size_t num_frames_;
+  Random random_;
+  size_t frame_index_ = 0;
+  std::array<std::vector<float>, kMaxNumBands> bands_;
+  std::array<const float*, kMaxNumBands> in_;
+};
+
+class BandsBuffer {
+ public:
+  BandsBuffer(size_t num_bands, size_t num_frames) {
+    for (size_t i = 0; i < num_bands; ++i) {
+      bands_.emplace_back(num_frames);
+      pointers_.push_back(bands_.back().data());
+    }
+  }
+  float* const* bands() { return pointers_.data(); }
+  const std::vector<std::vector<float>>& data() const { return bands_; }
+
+ private:
+  std::vector<std::vector<float>> bands_;
+  std::vector<float*> pointers_;
+};
+
+std::string ProduceDebugText(int sample_rate_hz, int policy) {
+  rtc::StringBuilder ss;
+  ss << "Sample rate: " << sample_rate_hz << ", policy: " << policy;
+  return ss.Release();
+}
+
+}  // namespace
+
+// Verifies that the SIMD optimizations produce the same output as the scalar
+// code.
+TEST(NoiseSuppressor, OptimizationsAreBitExact) {
+  if (NoiseSuppressor::DetectOptimization() ==
+      NoiseSuppressor::Optimization::kNone) {
+    return;
+  }
+  for (int sample_rate_hz : {8000, 16000, 32000, 48000}) {
+    for (int policy = 0; policy < 4; ++policy) {
+      SCOPED_TRACE(ProduceDebugText(sample_rate_hz, policy));
+      BandsGenerator generator(sample_rate_hz, 42);
+      NoiseSuppressor scalar(sample_rate_hz, 1,
+                             NoiseSuppressor::Optimization::kNone);
+      NoiseSuppressor optimized(sample_rate_hz, 1,
+                                NoiseSuppressor::DetectOptimization());
+      ASSERT_TRUE(scalar.SetPolicy(policy));
+      ASSERT_TRUE(optimized.SetPolicy(policy));
+      BandsBuffer scalar_out(generator.num_bands(), generator.num_frames());
+      BandsBuffer optimized_out(generator.num_bands(), generator.num_frames());
+      for (int frame = 0; frame < 700; ++frame) {
+        generator.Generate();
+        scalar.Analyze(0, generator.bands()[0]);
+        optimized.Analyze(0, generator.bands()[0]);
+        scalar.Process(0, generator.bands(), generator.num_bands(),
+                       scalar_out.bands());
+        optimized.Process(0, generator.bands(), generator.num_bands(),
+                          optimized_out.bands());
+        ASSERT_EQ(scalar_out.data(), optimized_out.data());
+      }
+      EXPECT_EQ(scalar.prior_speech_probability(0),
+                optimized.prior_speech_probability(0));
+    }
+  }
+}
+
+// Verifies that the channels of a multichannel suppressor are processed as by
+// separate single channel suppressors.
+TEST(NoiseSuppressor, ChannelsAreIndependent) {
+  constexpr int kSampleRateHz = 48000;
+  BandsGenerator generator0(kSampleRateHz, 1);
+  BandsGenerator generator1(kSampleRateHz, 2);
+  NoiseSuppressor stereo(kSampleRateHz, 2);
+  NoiseSuppressor mono(kSampleRateHz, 1);
+  ASSERT_EQ(2u, stereo.num_channels());
+  BandsBuffer stereo_out(generator0.num_bands(), generator0.num_frames());
+  BandsBuffer mono_out(generator0.num_bands(), generator0.num_frames());
+  for (int frame = 0; frame < 300; ++frame) {
+    generator0.Generate();
+    generator1.Generate();
+    stereo.Analyze(0, generator0.bands()[0]);
+    stereo.Analyze(1, generator1.bands()[0]);
+    mono.Analyze(0, generator1.bands()[0]);
+    stereo.Process(0, generator0.bands(), generator0.num_bands(),
+                   stereo_out.bands());
+    stereo.Process(1, generator1.bands(), generator1.num_bands(),
+                   stereo_out.bands());
+    mono.Process(0, generator1.bands(), generator1.num_bands(),
+                 mono_out.bands());
+    ASSERT_EQ(mono_out.data(), stereo_out.data());
+  }
+  EXPECT_EQ(mono.prior_speech_probability(0),
+            stereo.prior_speech_probability(1));
+  EXPECT_NE(stereo.prior_speech_probability(0),
+            stereo.prior_speech_probability(1));
+}
+
+// Verifies that the output is close to that of the C implementation. The two
+// are not bitexact since they use different FFTs.
+TEST(NoiseSuppressor, MatchesCImplementation) {
+  for (int sample_rate_hz : {8000, 16000, 48000}) {
+    for (int policy = 0; policy < 4; ++policy) {
+      SCOPED_TRACE(ProduceDebugText(sample_rate_hz, policy));
+      BandsGenerator generator(sample_rate_hz, 7);
+      NoiseSuppressor suppressor(sample_rate_hz, 1);
+      ASSERT_TRUE(suppressor.SetPolicy(policy));
+      NsHandle* reference = WebRtcNs_Create();
+      ASSERT_EQ(0, WebRtcNs_Init(reference, sample_rate_hz));
+      ASSERT_EQ(0, WebRtcNs_set_policy(reference, policy));
+
+      BandsBuffer out(generator.num_bands(), generator.num_frames());
+      BandsBuffer reference_out(generator.num_bands(), generator.num_frames());
+      double in_energy = 0.0;
+      double reference_energy = 0.0;
+      double error_energy = 0.0;
+      for (int frame = 0; frame < 1000; ++frame) {
+        generator.Generate();
+        suppressor.Analyze(0, generator.bands()[0]);
+        WebRtcNs_Analyze(reference, generator.bands()[0]);
+        suppressor.Process(0, generator.bands(), generator.num_bands(),
+                           out.bands());
+        WebRtcNs_Process(reference, generator.bands(), generator.num_bands(),
+                         reference_out.bands());
+        for (size_t k = 0; k < generator.num_bands(); ++k) {
+          for (size_t i = 0; i < generator.num_frames(); ++i) {
+            const float reference_sample = reference_out.data()[k][i];
+            const float error = out.data()[k][i] - reference_sample;
+            in_energy += generator.bands()[k][i] * generator.bands()[k][i];
+            reference_energy += reference_sample * reference_sample;
+            error_energy += error * error;
+          }
+        }
+      }
+      // The suppressor must attenuate the noise, and do so like the C
+      // implementation.
+      EXPECT_LT(reference_energy, in_energy);
+      EXPECT_GT(10 * log10(reference_energy / (error_energy + 1.0)), 40.0);
+      EXPECT_NEAR(WebRtcNs_prior_speech_probability(reference),
+                  suppressor.prior_speech_probability(0), 0.01f);
+      const float* reference_noise = WebRtcNs_noise_estimate(reference);
+      rtc::ArrayView<const float, NoiseSuppressor::kNumFreqBins> noise =
+          suppressor.noise_estimate(0);
+      for (size_t i = 0; i < noise.size(); ++i) {
+        EXPECT_NEAR(reference_noise[i], noise[i],
+                    0.01f * reference_noise[i] + 0.01f);
+      }
+      WebRtcNs_Free(reference);
+    }
+  }
+}
+
+TEST(NoiseSuppressor, RejectsInvalidPolicies) {
+  NoiseSuppressor suppressor(16000, 1);
+  EXPECT_FALSE(suppressor.SetPolicy(-1));
+  EXPECT_FALSE(suppressor.SetPolicy(4));
+  EXPECT_TRUE(suppressor.SetPolicy(3));
+}
+
+}  // namespace webrtc
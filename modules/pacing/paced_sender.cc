@@ -21,6 +21,8 @@
 #include "modules/utility/include/process_thread.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/perf_event_counters.h"
+#include "rtc_base/trace_event.h"
 #include "system_wrappers/include/clock.h"
 
 namespace webrtc {
@@ -315,6 +317,8 @@ bool PacedSender::ShouldSendKeepalive(int64_t now_us) const {
 }
 
 void PacedSender::Process() {
+  TRACE_EVENT0("webrtc", "PacedSender::Process");
+  RTC_PERF_EVENT_SCOPE("Pacer.Process");
   rtc::CritScope cs(&critsect_);
   int64_t now_us = clock_->TimeInMicroseconds();
   int64_t elapsed_time_ms = UpdateTimeAndGetElapsedMs(now_us);
@@ -415,6 +419,8 @@ void PacedSender::Process() {
   }
   if (alr_detector_)
     alr_detector_->OnBytesSent(bytes_sent, now_us / 1000);
+  TRACE_COUNTER1("webrtc", "PacedSender::QueueSizeBytes",
+                 packets_.SizeInBytes());
 }
 
 void PacedSender::ProcessThreadAttached(ProcessThread* process_thread) {
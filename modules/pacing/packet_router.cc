@@ -21,6 +21,7 @@
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/time_utils.h"
+#include "rtc_base/trace_event.h"
 
 namespace webrtc {
 namespace {
@@ -105,6 +106,8 @@ RtpPacketSendResult PacketRouter::TimeToSendPacket(
     int64_t capture_timestamp,
     bool retransmission,
     const PacedPacketInfo& pacing_info) {
+  TRACE_EVENT2("webrtc", "PacketRouter::TimeToSendPacket", "ssrc", ssrc,
+               "sequence_number", sequence_number);
   rtc::CritScope cs(&modules_crit_);
   for (auto* rtp_module : rtp_send_modules_) {
     if (!rtp_module->SendingMedia()) {
@@ -127,6 +130,8 @@ RtpPacketSendResult PacketRouter::TimeToSendPacket(
 
 size_t PacketRouter::TimeToSendPadding(size_t bytes_to_send,
                                        const PacedPacketInfo& pacing_info) {
+  TRACE_EVENT1("webrtc", "PacketRouter::TimeToSendPadding", "bytes_to_send",
+               bytes_to_send);
   size_t total_bytes_sent = 0;
   rtc::CritScope cs(&modules_crit_);
   // First try on the last rtp module to have sent media. This increases the
@@ -10,10 +10,12 @@
 
 #include "modules/utility/source/process_thread_impl.h"
 
+#include <algorithm>
 #include <string>
 
 #include "modules/include/module.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
 
@@ -42,6 +44,8 @@ std::unique_ptr<ProcessThread> ProcessThread::Create(const char* thread_name) {
   return std::unique_ptr<ProcessThread>(new ProcessThreadImpl(thread_name));
 }
 
+constexpr size_t ProcessThreadImpl::kNotScheduled;
+
 ProcessThreadImpl::ProcessThreadImpl(const char* thread_name)
     : stop_(false), thread_name_(thread_name) {}
 
@@ -90,6 +94,17 @@ void ProcessThreadImpl::Stop() {
   thread_.reset();
   for (ModuleCallback& m : modules_)
     m.module->ProcessThreadAttached(nullptr);
+
+  Stats stats = GetStats();
+  RTC_LOG(LS_INFO) << "ProcessThread " << thread_name_
+                   << " stopped. Wakeups: " << stats.wakeups
+                   << ", idle: " << stats.idle_wakeups
+                   << ", Process calls: " << stats.process_calls
+                   << ", TimeUntilNextProcess calls: "
+                   << stats.time_until_next_process_calls
+                   << ", tasks: " << stats.tasks_run
+                   << ", max process delay: " << stats.max_process_delay_ms
+                   << " ms";
 }
 
 void ProcessThreadImpl::WakeUp(Module* module) {
@@ -97,8 +112,16 @@ void ProcessThreadImpl::WakeUp(Module* module) {
   {
     rtc::CritScope lock(&lock_);
     for (ModuleCallback& m : modules_) {
-      if (m.module == module)
+      if (m.module == module) {
+        // Modules being processed are not in |schedule_|, and get scheduled
+        // with their new |next_callback| when done.
+        bool scheduled = m.schedule_index != kNotScheduled;
+        if (scheduled)
+          Unschedule(&m);
         m.next_callback = kCallProcessImmediately;
+        if (scheduled)
+          Schedule(&m);
+      }
     }
   }
   wake_up_.Set();
@@ -138,7 +161,8 @@ void ProcessThreadImpl::RegisterModule(Module* module,
 
   {
     rtc::CritScope lock(&lock_);
-    modules_.push_back(ModuleCallback(module, from));
+    modules_.push_back(ModuleCallback(module, from, next_module_order_++));
+    Schedule(&modules_.back());
   }
 
   // Wake the thread calling ProcessThreadImpl::Process() to update the
@@ -153,6 +177,10 @@ void ProcessThreadImpl::DeRegisterModule(Module* module) {
 
   {
     rtc::CritScope lock(&lock_);
+    for (ModuleCallback& m : modules_) {
+      if (m.module == module && m.schedule_index != kNotScheduled)
+        Unschedule(&m);
+    }
     modules_.remove_if(
         [&module](const ModuleCallback& m) { return m.module == module; });
   }
@@ -177,31 +205,57 @@ bool ProcessThreadImpl::Process() {
     rtc::CritScope lock(&lock_);
     if (stop_)
       return false;
-    for (ModuleCallback& m : modules_) {
+    ++stats_.wakeups;
+    const int64_t process_calls_before = stats_.process_calls;
+    const int64_t tasks_run_before = stats_.tasks_run;
+
+    // Take the due modules out of the schedule first, so that each of them is
+    // processed at most once per wakeup, even if it asks to be called again
+    // right away.
+    due_modules_.clear();
+    while (!schedule_.empty() && schedule_.front()->next_callback <= now) {
+      ModuleCallback* m = schedule_.front();
+      Unschedule(m);
+      due_modules_.push_back(m);
+    }
+
+    for (ModuleCallback* m : due_modules_) {
       // TODO(tommi): Would be good to measure the time TimeUntilNextProcess
       // takes and dcheck if it takes too long (e.g. >=10ms).  Ideally this
       // operation should not require taking a lock, so querying all modules
       // should run in a matter of nanoseconds.
-      if (m.next_callback == 0)
-        m.next_callback = GetNextCallbackTime(m.module, now);
+      if (m->next_callback == 0) {
+        m->next_callback = GetNextCallbackTime(m->module, now);
+        ++stats_.time_until_next_process_calls;
+      }
 
-      if (m.next_callback <= now ||
-          m.next_callback == kCallProcessImmediately) {
+      if (m->next_callback <= now ||
+          m->next_callback == kCallProcessImmediately) {
+        if (m->next_callback != kCallProcessImmediately) {
+          stats_.max_process_delay_ms =
+              std::max(stats_.max_process_delay_ms, now - m->next_callback);
+        }
         {
           TRACE_EVENT2("webrtc", "ModuleProcess", "function",
-                       m.location.function_name(), "file",
-                       m.location.file_and_line());
-          m.module->Process();
+                       m->location.function_name(), "file",
+                       m->location.file_and_line());
+          m->module->Process();
         }
+        ++stats_.process_calls;
         // Use a new 'now' reference to calculate when the next callback
         // should occur.  We'll continue to use 'now' above for the baseline
         // of calculating how long we should wait, to reduce variance.
         int64_t new_now = rtc::TimeMillis();
-        m.next_callback = GetNextCallbackTime(m.module, new_now);
+        m->next_callback = GetNextCallbackTime(m->module, new_now);
+        ++stats_.time_until_next_process_calls;
       }
+      Schedule(m);
+    }
+    due_modules_.clear();
 
-      if (m.next_callback < next_checkpoint)
-        next_checkpoint = m.next_callback;
+    if (!schedule_.empty() &&
+        schedule_.front()->next_callback < next_checkpoint) {
+      next_checkpoint = schedule_.front()->next_callback;
     }
 
     while (!queue_.empty()) {
@@ -211,6 +265,12 @@ bool ProcessThreadImpl::Process() {
       task->Run();
       delete task;
       lock_.Enter();
+      ++stats_.tasks_run;
+    }
+
+    if (stats_.process_calls == process_calls_before &&
+        stats_.tasks_run == tasks_run_before) {
+      ++stats_.idle_wakeups;
     }
   }
 
@@ -220,4 +280,64 @@ bool ProcessThreadImpl::Process() {
 
   return true;
 }
+
+ProcessThreadImpl::Stats ProcessThreadImpl::GetStats() const {
+  rtc::CritScope lock(&lock_);
+  return stats_;
+}
+
+void ProcessThreadImpl::Schedule(ModuleCallback* m) {
+  RTC_DCHECK_EQ(m->schedule_index, kNotScheduled);
+  m->schedule_index = schedule_.size();
+  schedule_.push_back(m);
+  SiftUp(m->schedule_index);
+}
+
+void ProcessThreadImpl::Unschedule(ModuleCallback* m) {
+  RTC_DCHECK_LT(m->schedule_index, schedule_.size());
+  size_t index = m->schedule_index;
+  m->schedule_index = kNotScheduled;
+  ModuleCallback* last = schedule_.back();
+  schedule_.pop_back();
+  if (index == schedule_.size())
+    return;
+  schedule_[index] = last;
+  last->schedule_index = index;
+  SiftUp(index);
+  SiftDown(last->schedule_index);
+}
+
+void ProcessThreadImpl::SiftUp(size_t index) {
+  ModuleCallback* m = schedule_[index];
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!m->RunsBefore(*schedule_[parent]))
+      break;
+    schedule_[index] = schedule_[parent];
+    schedule_[index]->schedule_index = index;
+    index = parent;
+  }
+  schedule_[index] = m;
+  m->schedule_index = index;
+}
+
+void ProcessThreadImpl::SiftDown(size_t index) {
+  ModuleCallback* m = schedule_[index];
+  while (true) {
+    size_t child = 2 * index + 1;
+    if (child >= schedule_.size())
+      break;
+    if (child + 1 < schedule_.size() &&
+        schedule_[child + 1]->RunsBefore(*schedule_[child])) {
+      ++child;
+    }
+    if (!schedule_[child]->RunsBefore(*m))
+      break;
+    schedule_[index] = schedule_[child];
+    schedule_[index]->schedule_index = index;
+    index = child;
+  }
+  schedule_[index] = m;
+  m->schedule_index = index;
+}
 }  // namespace webrtc
@@ -15,6 +15,7 @@
 #include <list>
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "api/task_queue/queued_task.h"
 #include "modules/include/module.h"
@@ -23,12 +24,26 @@
 #include "rtc_base/event.h"
 #include "rtc_base/location.h"
 #include "rtc_base/platform_thread.h"
+#include "rtc_base/thread_annotations.h"
 #include "rtc_base/thread_checker.h"
 
 namespace webrtc {
 
 class ProcessThreadImpl : public ProcessThread {
  public:
+  // Counts of the work done by the worker thread since it was created.
+  struct Stats {
+    // Times the worker thread has woken up.
+    int64_t wakeups = 0;
+    // Wakeups that neither processed a module nor ran a task.
+    int64_t idle_wakeups = 0;
+    int64_t process_calls = 0;
+    int64_t time_until_next_process_calls = 0;
+    int64_t tasks_run = 0;
+    // The latest a module has been processed after its requested time.
+    int64_t max_process_delay_ms = 0;
+  };
+
   explicit ProcessThreadImpl(const char* thread_name);
   ~ProcessThreadImpl() override;
 
@@ -41,6 +56,8 @@ class ProcessThreadImpl : public ProcessThread {
   void RegisterModule(Module* module, const rtc::Location& from) override;
   void DeRegisterModule(Module* module) override;
 
+  Stats GetStats() const;
+
  protected:
   static void Run(void* obj);
   bool Process();
@@ -50,15 +67,28 @@ class ProcessThreadImpl : public ProcessThread {
     ModuleCallback() = delete;
     ModuleCallback(ModuleCallback&& cb) = default;
     ModuleCallback(const ModuleCallback& cb) = default;
-    ModuleCallback(Module* module, const rtc::Location& location)
-        : module(module), location(location) {}
+    ModuleCallback(Module* module,
+                   const rtc::Location& location,
+                   uint64_t order)
+        : module(module),
+          location(location),
+          order(order),
+          schedule_index(kNotScheduled) {}
     bool operator==(const ModuleCallback& cb) const {
       return cb.module == module;
     }
+    bool RunsBefore(const ModuleCallback& cb) const {
+      return next_callback < cb.next_callback ||
+             (next_callback == cb.next_callback && order < cb.order);
+    }
 
     Module* const module;
     int64_t next_callback = 0;  // Absolute timestamp.
     const rtc::Location location;
+    // Orders modules with the same |next_callback| by registration.
+    const uint64_t order;
+    // Index in |schedule_|, or kNotScheduled.
+    size_t schedule_index;
 
    private:
     ModuleCallback& operator=(ModuleCallback&);
@@ -66,6 +96,13 @@ class ProcessThreadImpl : public ProcessThread {
 
   typedef std::list<ModuleCallback> ModuleList;
 
+  static constexpr size_t kNotScheduled = static_cast<size_t>(-1);
+
+  void Schedule(ModuleCallback* m) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void Unschedule(ModuleCallback* m) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void SiftUp(size_t index) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void SiftDown(size_t index) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Warning: For some reason, if |lock_| comes immediately before |modules_|
   // with the current class layout, we will  start to have mysterious crashes
   // on Mac 10.9 debug.  I (Tommi) suspect we're hitting some obscure alignemnt
@@ -80,8 +117,15 @@ class ProcessThreadImpl : public ProcessThread {
   std::unique_ptr<rtc::PlatformThread> thread_;
 
   ModuleList modules_;
+  // Min-heap of the modules of |modules_|, ordered by when they are next
+  // due, so that wakeups only look at the modules that are due.
+  std::vector<ModuleCallback*> schedule_ RTC_GUARDED_BY(lock_);
+  // The modules taken out of |schedule_| by the current Process() call.
+  std::vector<ModuleCallback*> due_modules_ RTC_GUARDED_BY(lock_);
+  uint64_t next_module_order_ = 0;
   std::queue<QueuedTask*> queue_;
   bool stop_;
+  Stats stats_ RTC_GUARDED_BY(lock_);
   const char* thread_name_;
 };
 
@@ -0,0 +1,121 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "modules/include/module.h"
+#include "modules/utility/source/process_thread_impl.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/event.h"
+#include "rtc_base/location.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kNumModules = 500;
+constexpr int kMinPeriodMs = 5;
+constexpr int kMaxPeriodMs = 100;
+constexpr int kNumBusyModules = 10;
+constexpr int kBusyPeriodMs = 1;
+constexpr int kIdlePeriodMs = 1000;
+constexpr int kRunTimeMs = 5000;
+
+// Asks to be processed every |period_ms|, like the RTP and bandwidth
+// estimation modules do.
+class PeriodicModule : public Module {
+ public:
+  PeriodicModule(int64_t first_delay_ms, int64_t period_ms)
+      : next_process_ms_(rtc::TimeMillis() + first_delay_ms),
+        period_ms_(period_ms) {}
+
+  int64_t TimeUntilNextProcess() override {
+    return next_process_ms_ - rtc::TimeMillis();
+  }
+  void Process() override { next_process_ms_ += period_ms_; }
+
+ private:
+  int64_t next_process_ms_;
+  const int64_t period_ms_;
+};
+
+// Runs |modules| on a process thread for |kRunTimeMs|, and prints how much
+// CPU and how many wakeups and module calls it took.
+void MeasureProcessThread(
+    const std::string& trace,
+    const std::vector<std::unique_ptr<PeriodicModule>>& modules) {
+  ProcessThreadImpl thread("ProcessThreadPerf");
+  for (const auto& module : modules)
+    thread.RegisterModule(module.get(), RTC_FROM_HERE);
+
+  const int64_t start_cpu_ns = rtc::GetProcessCpuTimeNanos();
+  const int64_t start_ms = rtc::TimeMillis();
+  thread.Start();
+  rtc::Event().Wait(kRunTimeMs);
+  thread.Stop();
+  const double elapsed_s = static_cast<double>(rtc::TimeMillis() - start_ms) /
+                           rtc::kNumMillisecsPerSec;
+  const int64_t cpu_ns = rtc::GetProcessCpuTimeNanos() - start_cpu_ns;
+  const ProcessThreadImpl::Stats stats = thread.GetStats();
+
+  for (const auto& module : modules)
+    thread.DeRegisterModule(module.get());
+
+  test::PrintResult("process_thread", "_" + trace, "cpu_usage",
+                    100.0 * cpu_ns / (elapsed_s * rtc::kNumNanosecsPerSec),
+                    "%", false);
+  test::PrintResult("process_thread", "_" + trace, "wakeups",
+                    stats.wakeups / elapsed_s, "wakeups/s", false);
+  test::PrintResult("process_thread", "_" + trace, "idle_wakeups",
+                    stats.idle_wakeups / elapsed_s, "wakeups/s", false);
+  test::PrintResult("process_thread", "_" + trace, "process_calls",
+                    stats.process_calls / elapsed_s, "calls/s", false);
+  test::PrintResult("process_thread", "_" + trace,
+                    "time_until_next_process_calls",
+                    stats.time_until_next_process_calls / elapsed_s,
+                    "calls/s", false);
+  test::PrintResult("process_thread", "_" + trace, "max_process_delay",
+                    stats.max_process_delay_ms, "ms", false);
+}
+
+}  // namespace
+
+// Modules with a spread of periods, so that a few are due on most wakeups.
+TEST(ProcessThreadPerfTest, ManyPeriodicModules) {
+  Random random(42);
+  std::vector<std::unique_ptr<PeriodicModule>> modules;
+  for (int i = 0; i < kNumModules; ++i) {
+    int period_ms = random.Rand(kMinPeriodMs, kMaxPeriodMs);
+    modules.push_back(absl::make_unique<PeriodicModule>(
+        random.Rand(0, period_ms - 1), period_ms));
+  }
+  MeasureProcessThread("periodic", modules);
+}
+
+// A few busy modules among many mostly idle ones, so that most wakeups are
+// for a handful of modules.
+TEST(ProcessThreadPerfTest, FewBusyModules) {
+  Random random(42);
+  std::vector<std::unique_ptr<PeriodicModule>> modules;
+  for (int i = 0; i < kNumModules; ++i) {
+    int period_ms = i < kNumBusyModules ? kBusyPeriodMs : kIdlePeriodMs;
+    modules.push_back(absl::make_unique<PeriodicModule>(
+        random.Rand(0, period_ms - 1), period_ms));
+  }
+  MeasureProcessThread("few_busy", modules);
+}
+
+}  // namespace webrtc
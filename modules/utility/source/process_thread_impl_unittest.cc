@@ -10,7 +10,9 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "api/task_queue/queued_task.h"
 #include "modules/include/module.h"
 #include "modules/utility/source/process_thread_impl.h"
@@ -309,4 +311,105 @@ TEST(ProcessThreadImpl, PostTask) {
   thread.Stop();
 }
 
+// A module that asks to be processed every |period_ms|, starting after
+// |first_delay_ms|, and signals |done| after |num_calls| calls.
+class PeriodicModule : public Module {
+ public:
+  PeriodicModule(int64_t first_delay_ms,
+                 int64_t period_ms,
+                 int num_calls,
+                 rtc::Event* done)
+      : next_process_ms_(rtc::TimeMillis() + first_delay_ms),
+        period_ms_(period_ms),
+        num_calls_(num_calls),
+        done_(done) {}
+
+  int64_t TimeUntilNextProcess() override {
+    return next_process_ms_ - rtc::TimeMillis();
+  }
+  void Process() override {
+    next_process_ms_ = rtc::TimeMillis() + period_ms_;
+    if (++calls_ == num_calls_ && done_)
+      done_->Set();
+  }
+
+  int calls() const { return calls_; }
+
+ private:
+  int64_t next_process_ms_;
+  const int64_t period_ms_;
+  const int num_calls_;
+  rtc::Event* const done_;
+  int calls_ = 0;
+};
+
+// Tests that with many modules registered, only the due ones are queried and
+// processed on each wakeup.
+TEST(ProcessThreadImpl, ManyModulesAreProcessedWhenDue) {
+  constexpr int kNumModules = 50;
+  constexpr int kNumCalls = 5;
+  ProcessThreadImpl thread("ProcessThread");
+  std::vector<std::unique_ptr<rtc::Event>> done;
+  std::vector<std::unique_ptr<PeriodicModule>> modules;
+  for (int i = 0; i < kNumModules; ++i) {
+    done.push_back(absl::make_unique<rtc::Event>());
+    modules.push_back(absl::make_unique<PeriodicModule>(
+        i % 10, 5 + i % 7, kNumCalls, done.back().get()));
+    thread.RegisterModule(modules.back().get(), RTC_FROM_HERE);
+  }
+  // A module that is never due should never be processed or queried again.
+  PeriodicModule idle_module(100000, 100000, 1, nullptr);
+  thread.RegisterModule(&idle_module, RTC_FROM_HERE);
+
+  thread.Start();
+  for (const auto& event : done)
+    EXPECT_TRUE(event->Wait(kEventWaitTimeout));
+  thread.Stop();
+
+  EXPECT_EQ(0, idle_module.calls());
+  ProcessThreadImpl::Stats stats = thread.GetStats();
+  EXPECT_GE(stats.process_calls, kNumModules * kNumCalls);
+  // Each module is queried once when first scheduled and once after each
+  // Process() call, however many modules are registered.
+  EXPECT_EQ(stats.process_calls + kNumModules + 1,
+            stats.time_until_next_process_calls);
+  EXPECT_GE(stats.wakeups, kNumCalls);
+
+  for (const auto& module : modules)
+    thread.DeRegisterModule(module.get());
+  thread.DeRegisterModule(&idle_module);
+}
+
+// Tests that a module deregistered while waiting for its turn is not
+// processed.
+TEST(ProcessThreadImpl, DeregisterScheduledModule) {
+  ProcessThreadImpl thread("ProcessThread");
+  rtc::Event done;
+  PeriodicModule removed_module(20, 20, 1, nullptr);
+  PeriodicModule module(0, 5, 10, &done);
+  thread.RegisterModule(&removed_module, RTC_FROM_HERE);
+  thread.RegisterModule(&module, RTC_FROM_HERE);
+  thread.Start();
+  thread.DeRegisterModule(&removed_module);
+  EXPECT_TRUE(done.Wait(kEventWaitTimeout));
+  thread.Stop();
+  EXPECT_EQ(0, removed_module.calls());
+  thread.DeRegisterModule(&module);
+}
+
+TEST(ProcessThreadImpl, StatsCountTasks) {
+  ProcessThreadImpl thread("ProcessThread");
+  rtc::Event task_ran;
+  thread.Start();
+  thread.PostTask(absl::make_unique<RaiseEventTask>(&task_ran));
+  EXPECT_TRUE(task_ran.Wait(kEventWaitTimeout));
+  thread.Stop();
+
+  ProcessThreadImpl::Stats stats = thread.GetStats();
+  EXPECT_EQ(1, stats.tasks_run);
+  EXPECT_EQ(0, stats.process_calls);
+  EXPECT_GE(stats.wakeups, 1);
+  EXPECT_LT(stats.idle_wakeups, stats.wakeups);
+}
+
 }  // namespace webrtc
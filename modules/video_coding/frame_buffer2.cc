@@ -160,6 +160,7 @@ FrameBuffer::ReturnReason FrameBuffer::NextFrame(
 }
 
 int64_t FrameBuffer::FindNextFrame(int64_t now_ms) {
+  TRACE_EVENT0("webrtc", "FrameBuffer::FindNextFrame");
   int64_t wait_ms = latest_return_time_ms_ - now_ms;
   frames_to_decode_.clear();
 
@@ -254,6 +255,7 @@ int64_t FrameBuffer::FindNextFrame(int64_t now_ms) {
 }
 
 EncodedFrame* FrameBuffer::GetNextFrame() {
+  TRACE_EVENT0("webrtc", "FrameBuffer::GetNextFrame");
   int64_t now_ms = clock_->TimeInMilliseconds();
   // TODO(ilnik): remove |frames_out| use frames_to_decode_ directly.
   std::vector<EncodedFrame*> frames_out;
@@ -448,8 +450,9 @@ bool FrameBuffer::IsCompleteSuperFrame(const EncodedFrame& frame) {
 }
 
 int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
-  TRACE_EVENT0("webrtc", "FrameBuffer::InsertFrame");
   RTC_DCHECK(frame);
+  TRACE_EVENT2("webrtc", "FrameBuffer::InsertFrame", "picture_id",
+               frame->id.picture_id, "spatial_layer", frame->id.spatial_layer);
 
   rtc::CritScope lock(&crit_);
 
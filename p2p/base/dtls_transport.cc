@@ -8,6 +8,7 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string.h>
 #include <algorithm>
 #include <memory>
 #include <utility>
@@ -39,6 +40,8 @@ static const size_t kMinRtpPacketLen = 12;
 // Maximum number of pending packets in the queue. Packets are read immediately
 // after they have been written, so a capacity of "1" is sufficient.
 static const size_t kMaxPendingPackets = 1;
+// A flight of the handshake is a few packets at most.
+static const size_t kMaxHeldPackets = 8;
 
 // Minimum and maximum values for the initial DTLS handshake timeout. We'll pick
 // an initial timeout based on ICE RTT estimates, but clamp it to this range.
@@ -56,6 +59,35 @@ static bool IsDtlsClientHelloPacket(const char* data, size_t len) {
   const uint8_t* u = reinterpret_cast<const uint8_t*>(data);
   return len > 17 && u[0] == 22 && u[13] == 1;
 }
+// Returns true if |data| carries the same DTLS records as |packet|, as a
+// retransmission does: only the record sequence numbers may differ.
+static bool IsDtlsRetransmission(const rtc::Buffer& packet,
+                                 const char* data,
+                                 size_t len) {
+  if (packet.size() != len) {
+    return false;
+  }
+  const uint8_t* u = packet.data();
+  const uint8_t* v = reinterpret_cast<const uint8_t*>(data);
+  size_t offset = 0;
+  while (offset < len) {
+    if (len - offset < kDtlsRecordHeaderLen) {
+      return false;
+    }
+    size_t record_len = (u[offset + 11] << 8) | u[offset + 12];
+    if (record_len + kDtlsRecordHeaderLen > len - offset) {
+      return false;
+    }
+    // Content type, version and epoch are followed by the 48-bit sequence
+    // number at offset 5.
+    if (memcmp(u + offset, v + offset, 5) != 0 ||
+        memcmp(u + offset + 11, v + offset + 11, record_len + 2) != 0) {
+      return false;
+    }
+    offset += kDtlsRecordHeaderLen + record_len;
+  }
+  return true;
+}
 static bool IsRtpPacket(const char* data, size_t len) {
   const uint8_t* u = reinterpret_cast<const uint8_t*>(data);
   return (len >= kMinRtpPacketLen && (u[0] & 0xC0) == 0x80);
@@ -87,18 +119,46 @@ rtc::StreamResult StreamInterfaceChannel::Write(const void* data,
                                                 size_t data_len,
                                                 size_t* written,
                                                 int* error) {
+  if (written) {
+    *written = data_len;
+  }
+  if (hold_packets_until_writable_ && !ice_transport_->writable()) {
+    for (rtc::Buffer& packet : held_packets_) {
+      if (IsDtlsRetransmission(packet, static_cast<const char*>(data),
+                               data_len)) {
+        packet.SetData(static_cast<const uint8_t*>(data), data_len);
+        return rtc::SR_SUCCESS;
+      }
+    }
+    // Beyond that, the retransmission timer resends what gets dropped.
+    if (held_packets_.size() < kMaxHeldPackets) {
+      held_packets_.emplace_back(static_cast<const uint8_t*>(data), data_len);
+    }
+    return rtc::SR_SUCCESS;
+  }
+
   // Always succeeds, since this is an unreliable transport anyway.
   // TODO(zhihuang): Should this block if ice_transport_'s temporarily
   // unwritable?
   rtc::PacketOptions packet_options;
   ice_transport_->SendPacket(static_cast<const char*>(data), data_len,
                              packet_options);
-  if (written) {
-    *written = data_len;
-  }
   return rtc::SR_SUCCESS;
 }
 
+void StreamInterfaceChannel::SetHoldPacketsUntilWritable(bool hold) {
+  hold_packets_until_writable_ = hold;
+}
+
+void StreamInterfaceChannel::FlushHeldPackets() {
+  rtc::PacketOptions packet_options;
+  for (const rtc::Buffer& packet : held_packets_) {
+    ice_transport_->SendPacket(packet.data<char>(), packet.size(),
+                               packet_options);
+  }
+  held_packets_.clear();
+}
+
 bool StreamInterfaceChannel::OnPacketReceived(const char* data, size_t size) {
   // We force a read event here to ensure that we don't overflow our queue.
   bool ret = packets_.WriteBack(data, size, NULL);
@@ -134,7 +194,9 @@ DtlsTransport::DtlsTransport(
   ConnectToIceTransport();
 }
 
-DtlsTransport::~DtlsTransport() = default;
+DtlsTransport::~DtlsTransport() {
+  ice_transport_->DeregisterReceivedPacketCallback(this);
+}
 
 const webrtc::CryptoOptions& DtlsTransport::crypto_options() const {
   return crypto_options_;
@@ -197,6 +259,16 @@ bool DtlsTransport::SetSslMaxProtocolVersion(rtc::SSLProtocolVersion version) {
   return true;
 }
 
+void DtlsTransport::SetSessionCache(rtc::SSLSessionCache* session_cache) {
+  RTC_DCHECK(!dtls_);
+  session_cache_ = session_cache;
+}
+
+void DtlsTransport::SetEarlyHandshake(bool early_handshake) {
+  RTC_DCHECK(!dtls_);
+  early_handshake_ = early_handshake;
+}
+
 bool DtlsTransport::SetDtlsRole(rtc::SSLRole role) {
   if (dtls_) {
     RTC_DCHECK(dtls_role_);
@@ -344,6 +416,10 @@ bool DtlsTransport::SetupDtls() {
   dtls_->SetMode(rtc::SSL_MODE_DTLS);
   dtls_->SetMaxProtocolVersion(ssl_max_version_);
   dtls_->SetServerRole(*dtls_role_);
+  if (session_cache_) {
+    dtls_->SetSessionCache(session_cache_);
+  }
+  downward->SetHoldPacketsUntilWritable(early_handshake_);
   dtls_->SignalEvent.connect(this, &DtlsTransport::OnDtlsEvent);
   dtls_->SignalSSLHandshakeError.connect(this,
                                          &DtlsTransport::OnDtlsHandshakeError);
@@ -369,8 +445,8 @@ bool DtlsTransport::SetupDtls() {
 
   RTC_LOG(LS_INFO) << ToString() << ": DTLS setup complete.";
 
-  // If the underlying ice_transport is already writable at this point, we may
-  // be able to start DTLS right away.
+  // If the underlying ice_transport is already writable at this point, or the
+  // handshake starts early, we may be able to start DTLS right away.
   MaybeStartDtls();
   return true;
 }
@@ -432,6 +508,10 @@ bool DtlsTransport::IsDtlsConnected() {
   return dtls_ && dtls_->IsTlsConnected();
 }
 
+bool DtlsTransport::IsDtlsSessionResumed() {
+  return dtls_ && dtls_->IsSessionResumed();
+}
+
 bool DtlsTransport::receiving() const {
   return receiving_;
 }
@@ -460,7 +540,11 @@ void DtlsTransport::ConnectToIceTransport() {
   RTC_DCHECK(ice_transport_);
   ice_transport_->SignalWritableState.connect(this,
                                               &DtlsTransport::OnWritableState);
-  ice_transport_->SignalReadPacket.connect(this, &DtlsTransport::OnReadPacket);
+  ice_transport_->RegisterReceivedPacketCallback(
+      this, [this](rtc::PacketTransportInternal* transport, const char* data,
+                   size_t size, const int64_t& packet_time_us, int flags) {
+        OnReadPacket(transport, data, size, packet_time_us, flags);
+      });
   ice_transport_->SignalSentPacket.connect(this, &DtlsTransport::OnSentPacket);
   ice_transport_->SignalReadyToSend.connect(this,
                                             &DtlsTransport::OnReadyToSend);
@@ -494,6 +578,11 @@ void DtlsTransport::OnWritableState(rtc::PacketTransportInternal* transport) {
     return;
   }
 
+  // Send what an early handshake wrote so far on the first writable pair.
+  if (dtls_ && ice_transport_->writable()) {
+    downward_->FlushHeldPackets();
+  }
+
   switch (dtls_state()) {
     case DTLS_TRANSPORT_NEW:
       MaybeStartDtls();
@@ -536,7 +625,7 @@ void DtlsTransport::OnReadPacket(rtc::PacketTransportInternal* transport,
 
   if (!dtls_active_) {
     // Not doing DTLS.
-    SignalReadPacket(this, data, size, packet_time_us, 0);
+    NotifyPacketReceived(data, size, packet_time_us, 0);
     return;
   }
 
@@ -599,7 +688,7 @@ void DtlsTransport::OnReadPacket(rtc::PacketTransportInternal* transport,
         RTC_DCHECK(!srtp_ciphers_.empty());
 
         // Signal this upwards as a bypass packet.
-        SignalReadPacket(this, data, size, packet_time_us, PF_SRTP_BYPASS);
+        NotifyPacketReceived(data, size, packet_time_us, PF_SRTP_BYPASS);
       }
       break;
     case DTLS_TRANSPORT_FAILED:
@@ -645,7 +734,7 @@ void DtlsTransport::OnDtlsEvent(rtc::StreamInterface* dtls, int sig, int err) {
     do {
       ret = dtls_->Read(buf, sizeof(buf), &read, &read_error);
       if (ret == rtc::SR_SUCCESS) {
-        SignalReadPacket(this, buf, read, rtc::TimeMicros(), 0);
+        NotifyPacketReceived(buf, read, rtc::TimeMicros(), 0);
       } else if (ret == rtc::SR_EOS) {
         // Remote peer shut down the association with no error.
         RTC_LOG(LS_INFO) << ToString() << ": DTLS transport closed";
@@ -680,7 +769,7 @@ void DtlsTransport::OnNetworkRouteChanged(
 }
 
 void DtlsTransport::MaybeStartDtls() {
-  if (dtls_ && ice_transport_->writable()) {
+  if (dtls_ && (ice_transport_->writable() || early_handshake_)) {
     ConfigureHandshakeTimeout();
 
     if (dtls_->StartSSL()) {
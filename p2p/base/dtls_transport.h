@@ -41,6 +41,12 @@ class StreamInterfaceChannel : public rtc::StreamInterface {
   // Push in a packet; this gets pulled out from Read().
   bool OnPacketReceived(const char* data, size_t size);
 
+  // While |hold| is true, packets written while the ICE transport isn't
+  // writable are held instead of dropped, until FlushHeldPackets() is called.
+  // A retransmission replaces the held packet it repeats.
+  void SetHoldPacketsUntilWritable(bool hold);
+  void FlushHeldPackets();
+
   // Implementations of StreamInterface
   rtc::StreamState GetState() const override;
   void Close() override;
@@ -57,6 +63,8 @@ class StreamInterfaceChannel : public rtc::StreamInterface {
   IceTransportInternal* ice_transport_;  // owned by DtlsTransport
   rtc::StreamState state_;
   rtc::BufferQueue packets_;
+  bool hold_packets_until_writable_ = false;
+  std::vector<rtc::Buffer> held_packets_;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(StreamInterfaceChannel);
 };
@@ -141,6 +149,19 @@ class DtlsTransport : public DtlsTransportInternal {
 
   bool SetSslMaxProtocolVersion(rtc::SSLProtocolVersion version) override;
 
+  // Lets the handshake resume a session negotiated earlier with the same
+  // remote certificate, from |session_cache|, which must outlive this
+  // transport. Must be called before SetRemoteFingerprint.
+  void SetSessionCache(rtc::SSLSessionCache* session_cache);
+
+  // If enabled, the handshake starts as soon as the DTLS role and remote
+  // fingerprint are known, instead of when the ICE transport becomes
+  // writable. What it sends until then, like the ClientHello, is held and
+  // sent on the first candidate pair that becomes writable, and a ClientHello
+  // received early is answered right away. Must be called before
+  // SetRemoteFingerprint.
+  void SetEarlyHandshake(bool early_handshake);
+
   // Find out which DTLS-SRTP cipher was negotiated
   bool GetSrtpCryptoSuite(int* cipher) override;
 
@@ -173,6 +194,9 @@ class DtlsTransport : public DtlsTransportInternal {
   // has not yet been verified.
   bool IsDtlsConnected();
 
+  // Tells if the DTLS handshake resumed a session from the session cache.
+  bool IsDtlsSessionResumed();
+
   bool receiving() const override;
   bool writable() const override;
 
@@ -235,6 +259,8 @@ class DtlsTransport : public DtlsTransportInternal {
   webrtc::CryptoOptions crypto_options_;
   rtc::Buffer remote_fingerprint_value_;
   std::string remote_fingerprint_algorithm_;
+  rtc::SSLSessionCache* session_cache_ = nullptr;
+  bool early_handshake_ = false;
 
   // Cached DTLS ClientHello packet that was received before we started the
   // DTLS handshake. This could happen if the hello was received before the
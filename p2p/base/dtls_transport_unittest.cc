@@ -25,6 +25,7 @@
 #include "rtc_base/ssl_adapter.h"
 #include "rtc_base/ssl_identity.h"
 #include "rtc_base/ssl_stream_adapter.h"
+#include "rtc_base/time_utils.h"
 
 #define MAYBE_SKIP_TEST(feature)                                  \
   if (!(rtc::SSLStreamAdapter::feature())) {                      \
@@ -75,6 +76,12 @@ class DtlsTestClient : public sigslot::has_slots<> {
   void SetupMaxProtocolVersion(rtc::SSLProtocolVersion version) {
     ssl_max_version_ = version;
   }
+  void SetupSessionCache(rtc::SSLSessionCache* session_cache) {
+    session_cache_ = session_cache;
+  }
+  void SetupEarlyHandshake(bool early_handshake) {
+    early_handshake_ = early_handshake;
+  }
   // Set up fake ICE transport and real DTLS transport under test.
   void SetupTransports(IceRole role, int async_delay_ms = 0) {
     std::unique_ptr<FakeIceTransport> fake_ice_transport;
@@ -91,6 +98,8 @@ class DtlsTestClient : public sigslot::has_slots<> {
         std::move(fake_ice_transport), webrtc::CryptoOptions(),
         /*event_log=*/nullptr);
     dtls_transport_->SetSslMaxProtocolVersion(ssl_max_version_);
+    dtls_transport_->SetSessionCache(session_cache_);
+    dtls_transport_->SetEarlyHandshake(early_handshake_);
     // Note: Certificate may be null here if testing passthrough.
     dtls_transport_->SetLocalCertificate(certificate_);
     dtls_transport_->SignalWritableState.connect(
@@ -99,6 +108,8 @@ class DtlsTestClient : public sigslot::has_slots<> {
         this, &DtlsTestClient::OnTransportReadPacket);
     dtls_transport_->SignalSentPacket.connect(
         this, &DtlsTestClient::OnTransportSentPacket);
+    dtls_transport_->SignalDtlsHandshakeError.connect(
+        this, &DtlsTestClient::OnDtlsHandshakeError);
   }
 
   FakeIceTransport* fake_ice_transport() {
@@ -122,6 +133,8 @@ class DtlsTestClient : public sigslot::has_slots<> {
     return received_dtls_server_hellos_;
   }
 
+  int dtls_handshake_errors() const { return dtls_handshake_errors_; }
+
   void CheckRole(rtc::SSLRole role) {
     if (role == rtc::SSL_CLIENT) {
       ASSERT_EQ(0, received_dtls_client_hellos_);
@@ -229,6 +242,10 @@ class DtlsTestClient : public sigslot::has_slots<> {
   }
 
   // Transport callbacks
+  void OnDtlsHandshakeError(rtc::SSLHandshakeError error) {
+    ++dtls_handshake_errors_;
+  }
+
   void OnTransportWritableState(rtc::PacketTransportInternal* transport) {
     RTC_LOG(LS_INFO) << name_ << ": Transport '" << transport->transport_name()
                      << "' is writable";
@@ -291,8 +308,11 @@ class DtlsTestClient : public sigslot::has_slots<> {
   size_t packet_size_ = 0u;
   std::set<int> received_;
   rtc::SSLProtocolVersion ssl_max_version_ = rtc::SSL_PROTOCOL_DTLS_12;
+  rtc::SSLSessionCache* session_cache_ = nullptr;
+  bool early_handshake_ = false;
   int received_dtls_client_hellos_ = 0;
   int received_dtls_server_hellos_ = 0;
+  int dtls_handshake_errors_ = 0;
   rtc::SentPacket sent_packet_;
 };
 
@@ -372,6 +392,31 @@ class DtlsTransportTestBase {
     }
   }
 
+  // Sets up new transports with a one-way delay of |delay_ms|, with
+  // |client1_| as the DTLS server, connects them and returns the time until
+  // both can send SRTP.
+  int64_t MeasureTimeToSrtpReady(int delay_ms) {
+    client1_.SetupTransports(ICEROLE_CONTROLLING, delay_ms);
+    client2_.SetupTransports(ICEROLE_CONTROLLED, delay_ms);
+    client1_.dtls_transport()->SetDtlsRole(rtc::SSL_SERVER);
+    client2_.dtls_transport()->SetDtlsRole(rtc::SSL_CLIENT);
+    SetRemoteFingerprintFromCert(client1_.dtls_transport(),
+                                 client2_.certificate());
+    SetRemoteFingerprintFromCert(client2_.dtls_transport(),
+                                 client1_.certificate());
+    const int64_t start_ms = rtc::TimeMillis();
+    EXPECT_TRUE(client1_.Connect(&client2_, false));
+    EXPECT_TRUE_SIMULATED_WAIT(client1_.dtls_transport()->writable() &&
+                                   client2_.dtls_transport()->writable(),
+                               kTimeout, fake_clock_);
+    const int64_t elapsed_ms = rtc::TimeMillis() - start_ms;
+    RTC_LOG(LS_INFO) << "SRTP ready after " << elapsed_ms << " ms, "
+                     << static_cast<double>(elapsed_ms) / (2 * delay_ms)
+                     << " round trips, session resumed: "
+                     << client2_.dtls_transport()->IsDtlsSessionResumed();
+    return elapsed_ms;
+  }
+
   void TestTransfer(size_t size, size_t count, bool srtp) {
     RTC_LOG(LS_INFO) << "Expect packets, size=" << size;
     client2_.ExpectPackets(size);
@@ -591,6 +636,110 @@ TEST_F(DtlsTransportTest, TestRetransmissionSchedule) {
   }
 }
 
+// Resuming the session of an earlier handshake between the same certificates
+// takes one round trip less for the DTLS client, and half a round trip less
+// until both ends can send SRTP.
+TEST_F(DtlsTransportTest, TestSessionResumption) {
+  const int kOneWayDelayMs = 50;
+  std::unique_ptr<rtc::SSLSessionCache> session_cache1 =
+      rtc::SSLSessionCache::Create(rtc::SSL_MODE_DTLS);
+  std::unique_ptr<rtc::SSLSessionCache> session_cache2 =
+      rtc::SSLSessionCache::Create(rtc::SSL_MODE_DTLS);
+  ASSERT_TRUE(session_cache1);
+  ASSERT_TRUE(session_cache2);
+  client1_.SetupSessionCache(session_cache1.get());
+  client2_.SetupSessionCache(session_cache2.get());
+  PrepareDtls(rtc::KT_ECDSA);
+
+  // Full handshake: two round trips until the client has the server's
+  // Finished, which comes last.
+  const int64_t full_handshake_ms = MeasureTimeToSrtpReady(kOneWayDelayMs);
+  EXPECT_FALSE(client1_.dtls_transport()->IsDtlsSessionResumed());
+  EXPECT_FALSE(client2_.dtls_transport()->IsDtlsSessionResumed());
+  EXPECT_NEAR(4 * kOneWayDelayMs, full_handshake_ms, 2);
+
+  // Abbreviated handshake: one and a half round trips until the server has
+  // the client's Finished.
+  const int64_t resumed_ms = MeasureTimeToSrtpReady(kOneWayDelayMs);
+  EXPECT_TRUE(client1_.dtls_transport()->IsDtlsSessionResumed());
+  EXPECT_TRUE(client2_.dtls_transport()->IsDtlsSessionResumed());
+  EXPECT_NEAR(3 * kOneWayDelayMs, resumed_ms, 2);
+  // The certificates of the resumed session were verified again.
+  ASSERT_TRUE(client1_.dtls_transport()->GetRemoteSSLCertChain());
+  EXPECT_EQ(client2_.certificate()->GetSSLCertificate().ToPEMString(),
+            client1_.dtls_transport()
+                ->GetRemoteSSLCertChain()
+                ->Get(0)
+                .ToPEMString());
+  TestTransfer(1000, 100, /*srtp=*/false);
+
+  // A new certificate gets a full handshake.
+  client2_.CreateCertificate(rtc::KT_ECDSA);
+  EXPECT_NEAR(4 * kOneWayDelayMs, MeasureTimeToSrtpReady(kOneWayDelayMs), 2);
+  EXPECT_FALSE(client2_.dtls_transport()->IsDtlsSessionResumed());
+}
+
+// The server checks the client certificate of a resumed session against the
+// signaled fingerprint too, and fails the handshake if it doesn't match.
+TEST_F(DtlsTransportTest, TestSessionResumptionWithWrongFingerprint) {
+  std::unique_ptr<rtc::SSLSessionCache> session_cache1 =
+      rtc::SSLSessionCache::Create(rtc::SSL_MODE_DTLS);
+  std::unique_ptr<rtc::SSLSessionCache> session_cache2 =
+      rtc::SSLSessionCache::Create(rtc::SSL_MODE_DTLS);
+  ASSERT_TRUE(session_cache1);
+  ASSERT_TRUE(session_cache2);
+  client1_.SetupSessionCache(session_cache1.get());
+  client2_.SetupSessionCache(session_cache2.get());
+  PrepareDtls(rtc::KT_ECDSA);
+  MeasureTimeToSrtpReady(/*delay_ms=*/10);
+
+  client1_.SetupTransports(ICEROLE_CONTROLLING, /*async_delay_ms=*/10);
+  client2_.SetupTransports(ICEROLE_CONTROLLED, /*async_delay_ms=*/10);
+  client1_.dtls_transport()->SetDtlsRole(rtc::SSL_SERVER);
+  client2_.dtls_transport()->SetDtlsRole(rtc::SSL_CLIENT);
+  SetRemoteFingerprintFromCert(client1_.dtls_transport(),
+                               client2_.certificate(),
+                               true /*modify_digest*/);
+  SetRemoteFingerprintFromCert(client2_.dtls_transport(),
+                               client1_.certificate());
+  EXPECT_TRUE(client1_.Connect(&client2_, false));
+  EXPECT_EQ_SIMULATED_WAIT(DTLS_TRANSPORT_FAILED,
+                           client1_.dtls_transport()->dtls_state(), kTimeout,
+                           fake_clock_);
+  EXPECT_EQ(1, client1_.dtls_handshake_errors());
+}
+
+// With the early handshake, each end starts the handshake when it has the
+// remote fingerprint, and holds what it sends until its ICE transport is
+// writable.
+TEST_F(DtlsTransportTest, TestEarlyHandshake) {
+  client1_.SetupEarlyHandshake(true);
+  client2_.SetupEarlyHandshake(true);
+  PrepareDtls(rtc::KT_ECDSA);
+  Negotiate();
+  EXPECT_EQ(DTLS_TRANSPORT_CONNECTING, client1_.dtls_transport()->dtls_state());
+  EXPECT_EQ(DTLS_TRANSPORT_CONNECTING, client2_.dtls_transport()->dtls_state());
+
+  // Let retransmission timers fire; the held ClientHello isn't duplicated.
+  SIMULATED_WAIT(false, 3000, fake_clock_);
+  EXPECT_EQ(0, client1_.received_dtls_client_hellos());
+
+  // The DTLS client gets a writable candidate pair first, and the server
+  // answers its ClientHello before having one.
+  EXPECT_TRUE(client2_.Connect(&client1_, true));
+  EXPECT_EQ_SIMULATED_WAIT(1, client1_.received_dtls_client_hellos(), kTimeout,
+                           fake_clock_);
+  EXPECT_EQ(0, client2_.received_dtls_server_hellos());
+
+  EXPECT_TRUE(client1_.Connect(&client2_, true));
+  EXPECT_TRUE_SIMULATED_WAIT(client1_.dtls_transport()->writable() &&
+                                 client2_.dtls_transport()->writable(),
+                             kTimeout, fake_clock_);
+  EXPECT_EQ(1, client1_.received_dtls_client_hellos());
+  EXPECT_EQ(1, client2_.received_dtls_server_hellos());
+  TestTransfer(1000, 100, /*srtp=*/false);
+}
+
 // The following events can occur in many different orders:
 // 1. Caller receives remote fingerprint.
 // 2. Caller is writable.
@@ -250,7 +250,7 @@ class FakeDtlsTransport : public DtlsTransportInternal {
                                 size_t len,
                                 const int64_t& packet_time_us,
                                 int flags) {
-    SignalReadPacket(this, data, len, packet_time_us, flags);
+    NotifyPacketReceived(data, len, packet_time_us, flags);
   }
 
   void set_receiving(bool receiving) {
@@ -292,8 +292,8 @@ class FakeIceTransport : public IceTransportInternal {
   void SendPacketInternal(const rtc::CopyOnWriteBuffer& packet) {
     if (dest_) {
       last_sent_packet_ = packet;
-      dest_->SignalReadPacket(dest_, packet.data<char>(), packet.size(),
-                              rtc::TimeMicros(), 0);
+      dest_->NotifyPacketReceived(packet.data<char>(), packet.size(),
+                                  rtc::TimeMicros(), 0);
     }
   }
 
@@ -10,8 +10,10 @@
 
 #include "p2p/base/p2p_transport_channel.h"
 
+#include <algorithm>
 #include <iterator>
 #include <set>
+#include <tuple>
 #include <utility>
 
 #include "absl/algorithm/container.h"
@@ -83,6 +85,40 @@ int CompareCandidatePairsByNetworkPreference(
   return a_and_b_equal;
 }
 
+// The values connections are sorted by, in decreasing order of precedence.
+// These are the inputs of CompareConnections() without a receiving threshold,
+// followed by the RTT, stored so that greater values are better.
+struct ConnectionSortKey {
+  cricket::Connection* connection;
+  bool writable;
+  int write_state;  // Negated, since better states have lower values.
+  bool receiving;
+  bool connected;  // Only set for writable connections.
+  uint32_t remote_nomination;  // Only set on the controlled side.
+  int64_t last_data_received;  // Only set on the controlled side.
+  bool uses_preferred_network;
+  int64_t network_cost;  // Negated.
+  uint64_t priority;
+  uint32_t generation;
+  bool not_pruned;
+  int rtt;  // Negated.
+};
+
+bool IsBetterSortKey(const ConnectionSortKey& a, const ConnectionSortKey& b) {
+  return std::tie(a.writable, a.write_state, a.receiving, a.connected,
+                  a.remote_nomination, a.last_data_received,
+                  a.uses_preferred_network, a.network_cost, a.priority,
+                  a.generation, a.not_pruned, a.rtt) >
+         std::tie(b.writable, b.write_state, b.receiving, b.connected,
+                  b.remote_nomination, b.last_data_received,
+                  b.uses_preferred_network, b.network_cost, b.priority,
+                  b.generation, b.not_pruned, b.rtt);
+}
+
+// When the connections form at most this many runs that are still in order,
+// they are merged rather than sorted from scratch.
+const size_t kMaxSortedRunsToMerge = 8;
+
 uint32_t GetWeakPingIntervalInFieldTrial() {
   uint32_t weak_ping_interval = ::strtoul(
       webrtc::field_trial::FindFullName("WebRTC-StunInterPacketDelay").c_str(),
@@ -166,6 +202,9 @@ P2PTransportChannel::~P2PTransportChannel() {
   }
   resolvers_.clear();
   RTC_DCHECK(network_thread_ == rtc::Thread::Current());
+  for (Connection* connection : connections_) {
+    connection->DeregisterReceivedPacketCallback();
+  }
 }
 
 // Add the allocator session to our list so that we know which sessions
@@ -203,8 +242,11 @@ void P2PTransportChannel::AddConnection(Connection* connection) {
   connection->set_unwritable_timeout(config_.ice_unwritable_timeout);
   connection->set_unwritable_min_checks(config_.ice_unwritable_min_checks);
   connection->set_inactive_timeout(config_.ice_inactive_timeout);
-  connection->SignalReadPacket.connect(
-      this, &P2PTransportChannel::OnReadPacket);
+  connection->RegisterReceivedPacketCallback(
+      [this](Connection* connection, const char* data, size_t len,
+             int64_t packet_time_us) {
+        OnReadPacket(connection, data, len, packet_time_us);
+      });
   connection->SignalReadyToSend.connect(
       this, &P2PTransportChannel::OnReadyToSend);
   connection->SignalStateChange.connect(
@@ -1720,20 +1762,91 @@ void P2PTransportChannel::SortConnectionsAndUpdateState(
   // one whose estimated latency is lowest.  So it is the only one that we
   // need to consider switching to.
   // TODO(honghaiz): Don't sort;  Just use std::max_element in the right places.
-  absl::c_stable_sort(
-      connections_, [this](const Connection* a, const Connection* b) {
-        int cmp = CompareConnections(a, b, absl::nullopt, nullptr);
-        if (cmp != 0) {
-          return cmp > 0;
-        }
-        // Otherwise, sort based on latency estimate.
-        return a->rtt() < b->rtt();
-      });
+  //
+  // With hundreds of connections, evaluating CompareConnections() in every
+  // comparison dominates, mostly looking up whether ports and remote
+  // candidates are pruned. Instead, the values it compares are computed once
+  // per connection and the connections are sorted by those, in the same order.
+  std::vector<const Candidate*> remote_candidates_by_id;
+  remote_candidates_by_id.reserve(remote_candidates_.size());
+  for (const RemoteCandidate& candidate : remote_candidates_) {
+    remote_candidates_by_id.push_back(&candidate);
+  }
+  absl::c_sort(remote_candidates_by_id,
+               [](const Candidate* a, const Candidate* b) {
+                 return a->id() < b->id();
+               });
+  auto is_remote_candidate_pruned = [&](const Candidate& candidate) {
+    for (auto it = absl::c_lower_bound(
+             remote_candidates_by_id, candidate.id(),
+             [](const Candidate* a, const std::string& id) {
+               return a->id() < id;
+             });
+         it != remote_candidates_by_id.end() && (*it)->id() == candidate.id();
+         ++it) {
+      if (**it == candidate) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  const bool controlled = ice_role_ == ICEROLE_CONTROLLED;
+  std::vector<ConnectionSortKey> sort_keys;
+  sort_keys.reserve(connections_.size());
+  for (Connection* conn : connections_) {
+    ConnectionSortKey key;
+    key.connection = conn;
+    key.writable = conn->writable() || PresumedWritable(conn);
+    key.write_state = -conn->write_state();
+    key.receiving = conn->receiving();
+    key.connected = conn->write_state() == Connection::STATE_WRITABLE &&
+                    conn->connected();
+    key.remote_nomination = controlled ? conn->remote_nomination() : 0;
+    key.last_data_received = controlled ? conn->last_data_received() : 0;
+    key.uses_preferred_network =
+        LocalCandidateUsesPreferredNetwork(conn, config_.network_preference);
+    key.network_cost = -static_cast<int64_t>(conn->ComputeNetworkCost());
+    key.priority = conn->priority();
+    key.generation =
+        conn->remote_candidate().generation() + conn->port()->generation();
+    key.not_pruned = !IsPortPruned(conn->port()) &&
+                     !is_remote_candidate_pruned(conn->remote_candidate());
+    key.rtt = -conn->rtt();
+    sort_keys.push_back(key);
+  }
+
+  // Between two sorts, usually only a few connections have changed, so the
+  // list still consists of a few runs in the right order. Merging these takes
+  // linear time per run. Both merging and sorting are stable, so the result
+  // is the same either way.
+  std::vector<size_t> run_starts;
+  for (size_t i = 1; i < sort_keys.size(); ++i) {
+    if (IsBetterSortKey(sort_keys[i], sort_keys[i - 1])) {
+      run_starts.push_back(i);
+    }
+  }
+  if (run_starts.size() > kMaxSortedRunsToMerge) {
+    absl::c_stable_sort(sort_keys, IsBetterSortKey);
+  } else {
+    for (size_t i = 0; i < run_starts.size(); ++i) {
+      size_t run_end =
+          i + 1 < run_starts.size() ? run_starts[i + 1] : sort_keys.size();
+      std::inplace_merge(sort_keys.begin(), sort_keys.begin() + run_starts[i],
+                         sort_keys.begin() + run_end, IsBetterSortKey);
+    }
+  }
+  for (size_t i = 0; i < sort_keys.size(); ++i) {
+    connections_[i] = sort_keys[i].connection;
+  }
 
   RTC_LOG(LS_VERBOSE) << "Sorting " << connections_.size()
                       << " available connections";
-  for (size_t i = 0; i < connections_.size(); ++i) {
-    RTC_LOG(LS_VERBOSE) << connections_[i]->ToString();
+  // Connection::ToString() is expensive, so skip it unless it gets logged.
+  if (!rtc::LogMessage::IsNoop(rtc::LS_VERBOSE)) {
+    for (size_t i = 0; i < connections_.size(); ++i) {
+      RTC_LOG(LS_VERBOSE) << connections_[i]->ToString();
+    }
   }
 
   Connection* top_connection =
@@ -2166,10 +2279,17 @@ Connection* P2PTransportChannel::FindNextPingableConnection() {
     }
   }
 
+  // The remaining rules only consider pingable connections. Find them once,
+  // in the order of |connections_|.
+  std::vector<Connection*> pingable_connections;
+  absl::c_copy_if(
+      connections_, std::back_inserter(pingable_connections),
+      [this, now](Connection* conn) { return IsPingable(conn, now); });
+
   // Rule 3: Triggered checks have priority over non-triggered connections.
   // Rule 3.1: Among triggered checks, oldest takes precedence.
   Connection* oldest_triggered_check =
-      FindOldestConnectionNeedingTriggeredCheck(now);
+      FindOldestConnectionNeedingTriggeredCheck(pingable_connections);
   if (oldest_triggered_check) {
     return oldest_triggered_check;
   }
@@ -2181,20 +2301,23 @@ Connection* P2PTransportChannel::FindNextPingableConnection() {
   // Otherwise, treat everything as unpinged.
   // TODO(honghaiz): Instead of adding two separate vectors, we can add a state
   // "pinged" to filter out unpinged connections.
-  if (absl::c_none_of(unpinged_connections_, [this, now](Connection* conn) {
-        return this->IsPingable(conn, now);
-      })) {
+  std::vector<Connection*> unpinged_pingable_connections;
+  absl::c_copy_if(pingable_connections,
+                  std::back_inserter(unpinged_pingable_connections),
+                  [this](Connection* conn) {
+                    return unpinged_connections_.count(conn) > 0;
+                  });
+  if (unpinged_pingable_connections.empty()) {
     unpinged_connections_.insert(pinged_connections_.begin(),
                                  pinged_connections_.end());
     pinged_connections_.clear();
+    unpinged_pingable_connections.swap(pingable_connections);
   }
 
   // Among un-pinged pingable connections, "more pingable" takes precedence.
-  std::vector<Connection*> pingable_connections;
-  absl::c_copy_if(
-      unpinged_connections_, std::back_inserter(pingable_connections),
-      [this, now](Connection* conn) { return IsPingable(conn, now); });
-  auto iter = absl::c_max_element(pingable_connections,
+  // Ties go to the first one in the ordered |connections_|, which is the
+  // first one max_element() sees.
+  auto iter = absl::c_max_element(unpinged_pingable_connections,
                                   [this](Connection* conn1, Connection* conn2) {
                                     // Some implementations of max_element
                                     // compare an element with itself.
@@ -2203,7 +2326,7 @@ Connection* P2PTransportChannel::FindNextPingableConnection() {
                                     }
                                     return MorePingable(conn1, conn2) == conn2;
                                   });
-  if (iter != pingable_connections.end()) {
+  if (iter != unpinged_pingable_connections.end()) {
     return *iter;
   }
   return nullptr;
@@ -2405,12 +2528,12 @@ void P2PTransportChannel::OnReadPacket(Connection* connection,
                                        int64_t packet_time_us) {
   RTC_DCHECK(network_thread_ == rtc::Thread::Current());
 
-  // Do not deliver, if packet doesn't belong to the correct transport channel.
-  if (!FindConnection(connection))
-    return;
+  // Only the connections in |connections_| deliver their packets here, so
+  // there is no need to search for it on every packet.
+  RTC_DCHECK(FindConnection(connection));
 
   // Let the client know of an incoming packet
-  SignalReadPacket(this, data, len, packet_time_us, 0);
+  NotifyPacketReceived(data, len, packet_time_us, 0);
 
   // May need to switch the sending connection based on the receiving media path
   // if this is the controlled side.
@@ -2436,12 +2559,9 @@ void P2PTransportChannel::OnReadyToSend(Connection* connection) {
 // (last_ping_received > last_ping_sent).  But we shouldn't do
 // triggered checks if the connection is already writable.
 Connection* P2PTransportChannel::FindOldestConnectionNeedingTriggeredCheck(
-    int64_t now) {
+    const std::vector<Connection*>& pingable_connections) {
   Connection* oldest_needing_triggered_check = nullptr;
-  for (auto* conn : connections_) {
-    if (!IsPingable(conn, now)) {
-      continue;
-    }
+  for (auto* conn : pingable_connections) {
     bool needs_triggered_check =
         (!conn->writable() &&
          conn->last_ping_received() > conn->last_ping_sent());
@@ -2501,16 +2621,9 @@ Connection* P2PTransportChannel::MorePingable(Connection* conn1,
     }
   }
 
-  Connection* least_recently_pinged_conn = LeastRecentlyPinged(conn1, conn2);
-  if (least_recently_pinged_conn) {
-    return least_recently_pinged_conn;
-  }
-
-  // During the initial state when nothing has been pinged yet, return the first
-  // one in the ordered |connections_|.
-  return *(absl::c_find_if(connections_, [conn1, conn2](Connection* conn) {
-    return conn == conn1 || conn == conn2;
-  }));
+  // During the initial state when nothing has been pinged yet, this returns
+  // nullptr and the caller picks the first one in the ordered |connections_|.
+  return LeastRecentlyPinged(conn1, conn2);
 }
 
 void P2PTransportChannel::SetWritable(bool writable) {
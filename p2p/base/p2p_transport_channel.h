@@ -175,6 +175,13 @@ class RTC_EXPORT P2PTransportChannel : public IceTransportInternal {
     return remote_candidates_;
   }
 
+  // Public for unit tests. Compares |a| and |b| the way the connections are
+  // sorted, before the RTT is taken into account.
+  int CompareConnectionsForTesting(const Connection* a,
+                                   const Connection* b) const {
+    return CompareConnections(a, b, absl::nullopt, nullptr);
+  }
+
   std::string ToString() const {
     const std::string RECEIVING_ABBREV[2] = {"_", "R"};
     const std::string WRITABLE_ABBREV[2] = {"_", "W"};
@@ -337,9 +344,12 @@ class RTC_EXPORT P2PTransportChannel : public IceTransportInternal {
   void PruneConnections();
   bool IsBackupConnection(const Connection* conn) const;
 
-  Connection* FindOldestConnectionNeedingTriggeredCheck(int64_t now);
+  // Returns the connection of |pingable_connections| that has waited the
+  // longest for a triggered check, if any.
+  Connection* FindOldestConnectionNeedingTriggeredCheck(
+      const std::vector<Connection*>& pingable_connections);
   // Between |conn1| and |conn2|, this function returns the one which should
-  // be pinged first.
+  // be pinged first, or nullptr if neither should.
   Connection* MorePingable(Connection* conn1, Connection* conn2);
   // Select the connection which is Relay/Relay. If both of them are,
   // UDP relay protocol takes precedence.
@@ -0,0 +1,299 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/fake_port_allocator.h"
+#include "p2p/base/p2p_transport_channel.h"
+#include "p2p/base/test_turn_server.h"
+#include "p2p/client/basic_port_allocator.h"
+#include "rtc_base/async_resolver_interface.h"
+#include "rtc_base/fake_clock.h"
+#include "rtc_base/fake_network.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/message_handler.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_base/virtual_socket_server.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+// A transport with a few networks, TURN over UDP/TCP/TLS and IPv6 can end up
+// with hundreds of candidate pairs, and one network thread serves many
+// transports.
+constexpr int kNumConnections = 500;
+constexpr int kNumTransports = 1000;
+constexpr int kNumCheckRounds = 20;
+
+const IceParameters kLocalIceParameters("LOCALUFRAG", "LOCALPASSWORDLOCALPASS",
+                                        false);
+const IceParameters kRemoteIceParameters("REMOTEUFRAG",
+                                         "REMOTEPASSWORDREMOTEPAS",
+                                         false);
+
+Candidate CreateRemoteCandidate(int index) {
+  Candidate candidate;
+  candidate.set_address(rtc::SocketAddress(
+      "10.0." + rtc::ToString(index / 250) + "." +
+          rtc::ToString(index % 250 + 1),
+      5000 + index));
+  candidate.set_component(ICE_CANDIDATE_COMPONENT_DEFAULT);
+  candidate.set_protocol(UDP_PROTOCOL_NAME);
+  candidate.set_priority(static_cast<uint32_t>(index + 1));
+  candidate.set_type(LOCAL_PORT_TYPE);
+  return candidate;
+}
+
+// Each transport is paired with all |kNumConnections| remote candidates.
+// The transports are controlled and never nominated, so none of the
+// connections are pruned.
+std::unique_ptr<P2PTransportChannel> CreateTransport(
+    FakePortAllocator* allocator,
+    int index) {
+  auto channel = absl::make_unique<P2PTransportChannel>(
+      "perf" + rtc::ToString(index), ICE_CANDIDATE_COMPONENT_DEFAULT,
+      allocator);
+  channel->SetIceRole(ICEROLE_CONTROLLED);
+  channel->SetIceParameters(kLocalIceParameters);
+  channel->SetRemoteIceParameters(kRemoteIceParameters);
+  // Adding the remote candidates first creates all connections at once when
+  // the local port is ready.
+  for (int i = 0; i < kNumConnections; ++i) {
+    channel->AddRemoteCandidate(CreateRemoteCandidate(i));
+  }
+  channel->MaybeStartGathering();
+  return channel;
+}
+
+// The relay-only call set-up: both endpoints reach each other only through a
+// TURN server that is configured by hostname.
+constexpr int kNetworkDelayMs = 25;
+constexpr int kDnsLatencyMs = 40;
+constexpr int kConnectTimeoutMs = 10000;
+const char kTurnHostname[] = "turn.example.org";
+const rtc::SocketAddress kTurnUdpIntAddr("99.99.99.4", 3478);
+const rtc::SocketAddress kTurnUdpExtAddr("99.99.99.6", 0);
+const rtc::SocketAddress kLocalAddresses[] = {
+    rtc::SocketAddress("11.11.11.11", 0), rtc::SocketAddress("22.22.22.22", 0)};
+
+// Resolves every hostname to the TURN server after |kDnsLatencyMs|.
+class DelayedResolver : public rtc::AsyncResolverInterface,
+                        public rtc::MessageHandler {
+ public:
+  void Start(const rtc::SocketAddress& addr) override {
+    rtc::Thread::Current()->PostDelayed(RTC_FROM_HERE, kDnsLatencyMs, this);
+  }
+  bool GetResolvedAddress(int family, rtc::SocketAddress* addr) const override {
+    if (family != AF_INET) {
+      return false;
+    }
+    addr->SetResolvedIP(kTurnUdpIntAddr.ipaddr());
+    return true;
+  }
+  int GetError() const override { return 0; }
+  void Destroy(bool wait) override {
+    rtc::Thread::Current()->Clear(this);
+    delete this;
+  }
+  void OnMessage(rtc::Message* msg) override { SignalDone(this); }
+};
+
+class DelayedResolverPacketSocketFactory
+    : public rtc::BasicPacketSocketFactory {
+ public:
+  explicit DelayedResolverPacketSocketFactory(rtc::Thread* thread)
+      : rtc::BasicPacketSocketFactory(thread) {}
+  rtc::AsyncResolverInterface* CreateAsyncResolver() override {
+    return new DelayedResolver();
+  }
+};
+
+class RelayOnlyEndpoint : public sigslot::has_slots<> {
+ public:
+  RelayOnlyEndpoint(int index, bool parallel_gathering)
+      : socket_factory_(rtc::Thread::Current()),
+        allocator_(&network_manager_, &socket_factory_) {
+    network_manager_.AddInterface(kLocalAddresses[index]);
+    allocator_.Initialize();
+    RelayServerConfig turn_server(RELAY_TURN);
+    turn_server.credentials = RelayCredentials("test", "test");
+    turn_server.ports.push_back(ProtocolAddress(
+        rtc::SocketAddress(kTurnHostname, kTurnUdpIntAddr.port()), PROTO_UDP));
+    allocator_.SetConfiguration(ServerAddresses(), {turn_server}, 0, false);
+    allocator_.set_step_delay(kMinimumStepDelay);
+    allocator_.set_flags(PORTALLOCATOR_ENABLE_SHARED_SOCKET |
+                         PORTALLOCATOR_DISABLE_TCP |
+                         (parallel_gathering
+                              ? PORTALLOCATOR_ENABLE_PARALLEL_GATHERING
+                              : 0));
+    allocator_.SetCandidateFilter(CF_RELAY);
+
+    channel_ = absl::make_unique<P2PTransportChannel>(
+        "relay" + rtc::ToString(index), ICE_CANDIDATE_COMPONENT_DEFAULT,
+        &allocator_);
+    channel_->SetIceRole(index == 0 ? ICEROLE_CONTROLLING : ICEROLE_CONTROLLED);
+    channel_->SetIceTiebreaker(index + 1);
+    channel_->SetIceParameters(index == 0 ? kLocalIceParameters
+                                          : kRemoteIceParameters);
+    channel_->SetRemoteIceParameters(index == 0 ? kRemoteIceParameters
+                                                : kLocalIceParameters);
+    channel_->SignalCandidateGathered.connect(
+        this, &RelayOnlyEndpoint::OnCandidateGathered);
+  }
+
+  void set_remote(RelayOnlyEndpoint* remote) { remote_ = remote; }
+  P2PTransportChannel* channel() { return channel_.get(); }
+  // Fully relayed connections are presumed writable before any check, so
+  // this waits for a connectivity check response on the selected one.
+  bool connected() const {
+    const Connection* conn = channel_->selected_connection();
+    return conn && conn->writable() && conn->receiving();
+  }
+  int64_t first_candidate_ms() const { return first_candidate_ms_; }
+
+ private:
+  void OnCandidateGathered(IceTransportInternal* transport,
+                           const Candidate& candidate) {
+    if (first_candidate_ms_ < 0) {
+      first_candidate_ms_ = rtc::TimeMillis();
+    }
+    remote_->channel()->AddRemoteCandidate(candidate);
+  }
+
+  rtc::FakeNetworkManager network_manager_;
+  DelayedResolverPacketSocketFactory socket_factory_;
+  BasicPortAllocator allocator_;
+  std::unique_ptr<P2PTransportChannel> channel_;
+  RelayOnlyEndpoint* remote_ = nullptr;
+  int64_t first_candidate_ms_ = -1;
+};
+
+void MeasureRelayOnlySetup(bool parallel_gathering) {
+  rtc::VirtualSocketServer socket_server;
+  rtc::AutoSocketServerThread thread(&socket_server);
+  rtc::ScopedFakeClock clock;
+  clock.AdvanceTime(webrtc::TimeDelta::seconds(1));
+  socket_server.set_delay_mean(kNetworkDelayMs);
+  socket_server.UpdateDelayDistribution();
+  TestTurnServer turn_server(rtc::Thread::Current(), kTurnUdpIntAddr,
+                             kTurnUdpExtAddr);
+
+  RelayOnlyEndpoint caller(0, parallel_gathering);
+  RelayOnlyEndpoint callee(1, parallel_gathering);
+  caller.set_remote(&callee);
+  callee.set_remote(&caller);
+  const int64_t start_ms = rtc::TimeMillis();
+  caller.channel()->MaybeStartGathering();
+  callee.channel()->MaybeStartGathering();
+  EXPECT_TRUE_SIMULATED_WAIT(
+      caller.connected() && callee.connected(),
+      kConnectTimeoutMs, clock);
+  const int64_t connected_ms = rtc::TimeMillis();
+  ASSERT_GE(caller.first_candidate_ms(), 0);
+
+  const std::string trace =
+      parallel_gathering ? "_relay_only_parallel" : "_relay_only_sequential";
+  webrtc::test::PrintResult("p2p_transport_channel", trace,
+                            "time_to_first_relay_candidate",
+                            caller.first_candidate_ms() - start_ms, "ms",
+                            false);
+  webrtc::test::PrintResult("p2p_transport_channel", trace,
+                            "time_to_connected", connected_ms - start_ms, "ms",
+                            true);
+}
+
+}  // namespace
+
+// Simulates the network thread work of rounds of connectivity checks on
+// |kNumTransports| transports with |kNumConnections| candidate pairs each:
+// picking the next connection to ping, and sorting the connections again
+// after the response made it writable.
+TEST(P2PTransportChannelPerfTest, ConnectivityCheckRounds) {
+  rtc::VirtualSocketServer socket_server;
+  rtc::AutoSocketServerThread thread(&socket_server);
+  // Freeze time, so that no timer driven pings interfere.
+  rtc::ScopedFakeClock clock;
+  FakePortAllocator allocator(rtc::Thread::Current(), nullptr);
+
+  std::vector<std::unique_ptr<P2PTransportChannel>> transports;
+  for (int i = 0; i < kNumTransports; ++i) {
+    transports.push_back(CreateTransport(&allocator, i));
+  }
+  thread.ProcessMessages(0);
+  for (const auto& transport : transports) {
+    ASSERT_EQ(static_cast<size_t>(kNumConnections),
+              transport->connections().size());
+  }
+
+  int64_t ping_ns = 0;
+  int64_t sort_ns = 0;
+  int num_pings = 0;
+  for (int round = 0; round < kNumCheckRounds; ++round) {
+    int64_t start_ns = rtc::SystemTimeNanos();
+    std::vector<Connection*> pinged;
+    for (const auto& transport : transports) {
+      Connection* conn = transport->FindNextPingableConnection();
+      if (conn) {
+        transport->MarkConnectionPinged(conn);
+        pinged.push_back(conn);
+      }
+    }
+    ping_ns += rtc::SystemTimeNanos() - start_ns;
+    num_pings += static_cast<int>(pinged.size());
+
+    // The responses request a sort of their transport, which runs as a
+    // message on the network thread.
+    for (Connection* conn : pinged) {
+      conn->ReceivedPingResponse(/*rtt=*/20 + round, "request" +
+                                                         rtc::ToString(round));
+    }
+    start_ns = rtc::SystemTimeNanos();
+    thread.ProcessMessages(0);
+    sort_ns += rtc::SystemTimeNanos() - start_ns;
+  }
+  EXPECT_EQ(kNumTransports * kNumCheckRounds, num_pings);
+
+  webrtc::test::PrintResult(
+      "p2p_transport_channel", "_500_pairs_1000_transports",
+      "find_next_pingable_connection",
+      static_cast<double>(ping_ns) / (kNumCheckRounds * kNumTransports) /
+          rtc::kNumNanosecsPerMicrosec,
+      "us", false);
+  webrtc::test::PrintResult(
+      "p2p_transport_channel", "_500_pairs_1000_transports",
+      "sort_connections_and_update_state",
+      static_cast<double>(sort_ns) / (kNumCheckRounds * kNumTransports) /
+          rtc::kNumNanosecsPerMicrosec,
+      "us", false);
+  webrtc::test::PrintResult(
+      "p2p_transport_channel", "_500_pairs_1000_transports",
+      "network_thread_time_per_round",
+      static_cast<double>(ping_ns + sort_ns) / kNumCheckRounds /
+          rtc::kNumNanosecsPerMillisec,
+      "ms", true);
+}
+
+// Measures the simulated time from the start of gathering to a writable
+// relayed connection, with a TURN server that needs a DNS lookup, with the
+// gathering phases run one after another and all at once.
+TEST(P2PTransportChannelPerfTest, RelayOnlyTimeToConnected) {
+  MeasureRelayOnlySetup(/*parallel_gathering=*/false);
+  MeasureRelayOnlySetup(/*parallel_gathering=*/true);
+}
+
+}  // namespace cricket
@@ -11,6 +11,7 @@
 #include <list>
 #include <memory>
 
+#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "p2p/base/fake_port_allocator.h"
 #include "p2p/base/ice_transport_internal.h"
@@ -31,6 +32,7 @@
 #include "rtc_base/logging.h"
 #include "rtc_base/nat_server.h"
 #include "rtc_base/nat_socket_factory.h"
+#include "rtc_base/network_constants.h"
 #include "rtc_base/proxy_server.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/ssl_adapter.h"
@@ -4031,6 +4033,89 @@ TEST_F(P2PTransportChannelPingTest,
   EXPECT_EQ(0, reset_selected_candidate_pair_switches());
 }
 
+// Test that sorting the connections, whether by merging the runs that are
+// still in order or by sorting from scratch, gives the same order as a stable
+// sort by CompareConnections() and then by RTT.
+TEST_F(P2PTransportChannelPingTest, TestSortMatchesCompareConnections) {
+  rtc::ScopedFakeClock clock;
+  clock.AdvanceTime(webrtc::TimeDelta::seconds(1));
+  FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  P2PTransportChannel ch("sort connections", 1, &pa);
+  PrepareChannel(&ch);
+  ch.SetIceRole(ICEROLE_CONTROLLED);
+  ch.MaybeStartGathering();
+
+  // Some of the candidates share a priority and a network cost, and the
+  // second half of them belong to the next remote ICE generation.
+  const int kNumConnections = 40;
+  std::vector<Connection*> conns;
+  for (int i = 0; i < kNumConnections; ++i) {
+    if (i == kNumConnections / 2) {
+      ch.SetRemoteIceParameters(kIceParams[2]);
+    }
+    Candidate candidate =
+        CreateUdpCandidate(LOCAL_PORT_TYPE, "1.1.1.1", i + 1, 100 + i % 4);
+    candidate.set_network_cost(i % 3 == 0 ? rtc::kNetworkCostHigh : 0);
+    ch.AddRemoteCandidate(candidate);
+    Connection* conn = WaitForConnectionTo(&ch, "1.1.1.1", i + 1, &clock);
+    ASSERT_TRUE(conn != nullptr);
+    conns.push_back(conn);
+  }
+
+  auto is_sorted_before = [&ch](const Connection* a, const Connection* b) {
+    int cmp = ch.CompareConnectionsForTesting(a, b);
+    if (cmp != 0) {
+      return cmp > 0;
+    }
+    return a->rtt() < b->rtt();
+  };
+
+  int num_reordered = 0;
+  for (int round = 0; round < 8; ++round) {
+    // Advance the clock so that data received in this round is more recent.
+    SIMULATED_WAIT(false, 1, clock);
+    // Change the states of fewer connections in each round, so that both
+    // many and few runs are left in order.
+    for (int i = round % 2; i < kNumConnections; i += round + 1) {
+      Connection* conn = conns[i];
+      switch ((i + round) % 6) {
+        case 0:
+          conn->ReceivedPingResponse(LOW_RTT + 10 * (i % 5), "id");
+          break;
+        case 1:
+          conn->ReceivedPing();
+          break;
+        case 2:
+          NominateConnection(conn, round + 1);
+          break;
+        case 3:
+          conn->OnReadPacket("XYZ", 3, rtc::TimeMicros());
+          break;
+        case 4:
+          conn->Prune();
+          break;
+        case 5:
+          ch.RemoveRemoteCandidate(conn->remote_candidate());
+          conn->ReceivedPing();
+          break;
+      }
+    }
+
+    std::vector<Connection*> expected = ch.connections();
+    absl::c_stable_sort(expected, is_sorted_before);
+    if (expected != ch.connections()) {
+      ++num_reordered;
+    }
+    // Run only the sort requested by the changes above, since it may prune
+    // connections and so request another one.
+    rtc::Message msg;
+    ASSERT_TRUE(rtc::Thread::Current()->Get(&msg, 0));
+    rtc::Thread::Current()->Dispatch(&msg);
+    EXPECT_EQ(expected, ch.connections()) << "round " << round;
+  }
+  EXPECT_GT(num_reordered, 0);
+}
+
 // Test that if a new remote candidate has the same address and port with
 // an old one, it will be used to create a new connection.
 TEST_F(P2PTransportChannelPingTest, TestAddRemoteCandidateWithAddressReuse) {
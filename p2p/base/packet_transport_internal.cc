@@ -10,6 +10,11 @@
 
 #include "p2p/base/packet_transport_internal.h"
 
+#include <algorithm>
+
+#include "absl/algorithm/container.h"
+#include "rtc_base/checks.h"
+
 namespace rtc {
 
 PacketTransportInternal::PacketTransportInternal() = default;
@@ -28,4 +33,37 @@ absl::optional<NetworkRoute> PacketTransportInternal::network_route() const {
   return absl::optional<NetworkRoute>();
 }
 
+void PacketTransportInternal::RegisterReceivedPacketCallback(
+    const void* id,
+    ReceivedPacketCallback callback) {
+  RTC_DCHECK(id);
+  RTC_DCHECK(absl::c_none_of(
+      received_packet_callbacks_,
+      [id](const std::pair<const void*, ReceivedPacketCallback>& entry) {
+        return entry.first == id;
+      }));
+  received_packet_callbacks_.emplace_back(id, std::move(callback));
+}
+
+void PacketTransportInternal::DeregisterReceivedPacketCallback(const void* id) {
+  received_packet_callbacks_.erase(
+      std::remove_if(
+          received_packet_callbacks_.begin(), received_packet_callbacks_.end(),
+          [id](const std::pair<const void*, ReceivedPacketCallback>& entry) {
+            return entry.first == id;
+          }),
+      received_packet_callbacks_.end());
+}
+
+void PacketTransportInternal::NotifyPacketReceived(
+    const char* data,
+    size_t len,
+    const int64_t& packet_time_us,
+    int flags) {
+  for (const auto& entry : received_packet_callbacks_) {
+    entry.second(this, data, len, packet_time_us, flags);
+  }
+  SignalReadPacket(this, data, len, packet_time_us, flags);
+}
+
 }  // namespace rtc
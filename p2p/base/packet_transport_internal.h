@@ -11,7 +11,9 @@
 #ifndef P2P_BASE_PACKET_TRANSPORT_INTERNAL_H_
 #define P2P_BASE_PACKET_TRANSPORT_INTERNAL_H_
 
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/types/optional.h"
@@ -92,6 +94,17 @@ class RTC_EXPORT PacketTransportInternal
                    int>
       SignalReadPacket;
 
+  // Delivers the packets received on this transport to |callback| with a
+  // direct call, in addition to SignalReadPacket. Meant for the transport
+  // stacked on top of this one, which receives every packet. |id| identifies
+  // the callback to DeregisterReceivedPacketCallback().
+  typedef std::function<
+      void(PacketTransportInternal*, const char*, size_t, const int64_t&, int)>
+      ReceivedPacketCallback;
+  void RegisterReceivedPacketCallback(const void* id,
+                                      ReceivedPacketCallback callback);
+  void DeregisterReceivedPacketCallback(const void* id);
+
   // Signalled each time a packet is sent on this channel.
   sigslot::signal2<PacketTransportInternal*, const rtc::SentPacket&>
       SignalSentPacket;
@@ -104,6 +117,18 @@ class RTC_EXPORT PacketTransportInternal
   ~PacketTransportInternal() override;
 
   PacketTransportInternal* GetInternal() override;
+
+  // Delivers a received packet to the registered callbacks and to
+  // SignalReadPacket. Implementations call this instead of emitting
+  // SignalReadPacket themselves.
+  void NotifyPacketReceived(const char* data,
+                            size_t len,
+                            const int64_t& packet_time_us,
+                            int flags);
+
+ private:
+  std::vector<std::pair<const void*, ReceivedPacketCallback>>
+      received_packet_callbacks_;
 };
 
 }  // namespace rtc
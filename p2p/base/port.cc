@@ -20,6 +20,7 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "p2p/base/port_allocator.h"
+#include "p2p/base/stun_message_view.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/crc32.h"
 #include "rtc_base/helpers.h"
@@ -157,6 +158,11 @@ const int kPortTimeoutDelay = cricket::STUN_TOTAL_TIMEOUT + 5000;
 
 constexpr int64_t kMinExtraPingDelayMs = 100;
 
+// Upper bound of the size of a binding success response: the header,
+// RETRANSMIT-COUNT, an IPv6 XOR-MAPPED-ADDRESS, MESSAGE-INTEGRITY and
+// FINGERPRINT.
+constexpr size_t kMaxBindingResponseSize = 20 + 8 + 24 + 24 + 8;
+
 }  // namespace
 
 namespace cricket {
@@ -474,6 +480,13 @@ bool Port::MaybeObfuscateAddress(Candidate* c,
   return true;
 }
 
+const rtc::HmacSha1& Port::password_hmac() {
+  if (password_hmac_.key() != password_) {
+    password_hmac_.SetKey(password_);
+  }
+  return password_hmac_;
+}
+
 void Port::FinishAddingAddress(const Candidate& c, bool is_final) {
   candidates_.push_back(c);
   SignalCandidateReady(this, c);
@@ -618,7 +631,7 @@ bool Port::GetStunMessage(const char* data,
     }
 
     // If ICE, and the MESSAGE-INTEGRITY is bad, fail with a 401 Unauthorized
-    if (!stun_msg->ValidateMessageIntegrity(data, size, password_)) {
+    if (!StunMessage::ValidateMessageIntegrity(data, size, password_hmac())) {
       RTC_LOG(LS_ERROR) << ToString()
                         << ": Received STUN request with bad M-I from "
                         << addr.ToSensitiveString()
@@ -809,17 +822,23 @@ void Port::SendBindingResponse(StunMessage* request,
     return;
   }
 
-  // Fill in the response message.
-  StunMessage response;
-  response.SetType(STUN_BINDING_RESPONSE);
-  response.SetTransactionID(request->transaction_id());
+  // Fill in the response message. A response is sent for every connectivity
+  // check and consent refresh, so it is serialized in place rather than built
+  // as a StunMessage.
+  const std::string& transaction_id = request->transaction_id();
+  uint8_t response[kMaxBindingResponseSize];
+  StunMessageWriter writer(
+      STUN_BINDING_RESPONSE,
+      rtc::ArrayView<const uint8_t>(
+          reinterpret_cast<const uint8_t*>(transaction_id.data()),
+          transaction_id.size()),
+      response);
   const StunUInt32Attribute* retransmit_attr =
       request->GetUInt32(STUN_ATTR_RETRANSMIT_COUNT);
   if (retransmit_attr) {
     // Inherit the incoming retransmit value in the response so the other side
     // can see our view of lost pings.
-    response.AddAttribute(absl::make_unique<StunUInt32Attribute>(
-        STUN_ATTR_RETRANSMIT_COUNT, retransmit_attr->value()));
+    writer.AddUInt32(STUN_ATTR_RETRANSMIT_COUNT, retransmit_attr->value());
 
     if (retransmit_attr->value() > CONNECTION_WRITE_CONNECT_FAILURES) {
       RTC_LOG(LS_INFO)
@@ -829,23 +848,28 @@ void Port::SendBindingResponse(StunMessage* request,
     }
   }
 
-  response.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
-      STUN_ATTR_XOR_MAPPED_ADDRESS, addr));
-  response.AddMessageIntegrity(password_);
-  response.AddFingerprint();
+  writer.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, addr);
+  writer.AddMessageIntegrity(password_hmac());
+  writer.AddFingerprint();
+  if (!writer.ok()) {
+    RTC_LOG(LS_ERROR) << ToString()
+                      << ": Failed to serialize STUN ping response, to="
+                      << addr.ToSensitiveString()
+                      << ", id=" << rtc::hex_encode(transaction_id);
+    return;
+  }
 
   // Send the response message.
-  rtc::ByteBufferWriter buf;
-  response.Write(&buf);
   rtc::PacketOptions options(StunDscpValue());
   options.info_signaled_after_sent.packet_type =
       rtc::PacketType::kIceConnectivityCheckResponse;
-  auto err = SendTo(buf.Data(), buf.Length(), addr, options, false);
+  auto err = SendTo(writer.message().data(), writer.message().size(), addr,
+                    options, false);
   if (err < 0) {
     RTC_LOG(LS_ERROR) << ToString()
                       << ": Failed to send STUN ping response, to="
                       << addr.ToSensitiveString() << ", err=" << err
-                      << ", id=" << rtc::hex_encode(response.transaction_id());
+                      << ", id=" << rtc::hex_encode(transaction_id);
   } else {
     // Log at LS_INFO if we send a stun ping response on an unwritable
     // connection.
@@ -854,7 +878,7 @@ void Port::SendBindingResponse(StunMessage* request,
         (conn && !conn->writable()) ? rtc::LS_INFO : rtc::LS_VERBOSE;
     RTC_LOG_V(sev) << ToString() << ": Sent STUN ping response, to="
                    << addr.ToSensitiveString()
-                   << ", id=" << rtc::hex_encode(response.transaction_id());
+                   << ", id=" << rtc::hex_encode(transaction_id);
 
     conn->stats_.sent_ping_responses++;
     conn->LogCandidatePairEvent(
@@ -885,7 +909,7 @@ void Port::SendBindingErrorResponse(StunMessage* request,
   // because we don't have enough information to determine the shared secret.
   if (error_code != STUN_ERROR_BAD_REQUEST &&
       error_code != STUN_ERROR_UNAUTHORIZED)
-    response.AddMessageIntegrity(password_);
+    response.AddMessageIntegrity(password_hmac());
   response.AddFingerprint();
 
   // Send the response message.
@@ -1065,7 +1089,7 @@ class ConnectionRequest : public StunRequest {
         STUN_ATTR_PRIORITY, prflx_priority));
 
     // Adding Message Integrity attribute.
-    request->AddMessageIntegrity(connection_->remote_candidate().password());
+    request->AddMessageIntegrity(connection_->remote_password_hmac());
     // Adding Fingerprint.
     request->AddFingerprint();
   }
@@ -1264,7 +1288,11 @@ void Connection::OnReadPacket(const char* data,
     last_data_received_ = rtc::TimeMillis();
     UpdateReceiving(last_data_received_);
     recv_rate_tracker_.AddSamples(size);
-    SignalReadPacket(this, data, size, packet_time_us);
+    if (received_packet_callback_) {
+      received_packet_callback_(this, data, size, packet_time_us);
+    } else {
+      SignalReadPacket(this, data, size, packet_time_us);
+    }
 
     // If timed out sending writability checks, start up again
     if (!pruned_ && (write_state_ == STATE_WRITE_TIMEOUT)) {
@@ -1307,8 +1335,8 @@ void Connection::OnReadPacket(const char* data,
       // id's match.
       case STUN_BINDING_RESPONSE:
       case STUN_BINDING_ERROR_RESPONSE:
-        if (msg->ValidateMessageIntegrity(data, size,
-                                          remote_candidate().password())) {
+        if (StunMessage::ValidateMessageIntegrity(data, size,
+                                                  remote_password_hmac())) {
           requests_.CheckResponse(msg.get());
         }
         // Otherwise silently discard the response message.
@@ -1415,6 +1443,16 @@ void Connection::HandleBindingRequest(IceMessage* msg) {
   }
 }
 
+void Connection::RegisterReceivedPacketCallback(
+    ReceivedPacketCallback callback) {
+  RTC_DCHECK(!received_packet_callback_);
+  received_packet_callback_ = std::move(callback);
+}
+
+void Connection::DeregisterReceivedPacketCallback() {
+  received_packet_callback_ = nullptr;
+}
+
 void Connection::OnReadyToSend() {
   SignalReadyToSend(this);
 }
@@ -1710,6 +1748,13 @@ void Connection::LogCandidatePairEvent(webrtc::IceCandidatePairEventType type,
   ice_event_log_->LogCandidatePairEvent(type, id(), transaction_id);
 }
 
+const rtc::HmacSha1& Connection::remote_password_hmac() {
+  if (remote_password_hmac_.key() != remote_candidate_.password()) {
+    remote_password_hmac_.SetKey(remote_candidate_.password());
+  }
+  return remote_password_hmac_;
+}
+
 void Connection::OnConnectionRequestResponse(ConnectionRequest* request,
                                              StunMessage* response) {
   // Log at LS_INFO if we receive a ping response on an unwritable
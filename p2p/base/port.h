@@ -11,10 +11,12 @@
 #ifndef P2P_BASE_PORT_H_
 #define P2P_BASE_PORT_H_
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/types/optional.h"
@@ -31,6 +33,7 @@
 #include "p2p/base/stun_request.h"
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/hmac_sha1.h"
 #include "rtc_base/net_helper.h"
 #include "rtc_base/network.h"
 #include "rtc_base/proxy_info.h"
@@ -298,9 +301,16 @@ class Port : public PortInterface,
   // connection.
   sigslot::signal1<Port*> SignalPortError;
 
+  struct SocketAddressHash {
+    size_t operator()(const rtc::SocketAddress& address) const {
+      return address.Hash();
+    }
+  };
+
   // Returns a map containing all of the connections of this port, keyed by the
-  // remote address.
-  typedef std::map<rtc::SocketAddress, Connection*> AddressMap;
+  // remote address. Hashed, as every received packet looks up its connection.
+  typedef std::unordered_map<rtc::SocketAddress, Connection*, SocketAddressHash>
+      AddressMap;
   const AddressMap& connections() { return connections_; }
 
   // Returns the connection to the given address or NULL if none exists.
@@ -491,6 +501,9 @@ class Port : public PortInterface,
   // username_fragment().
   std::string ice_username_fragment_;
   std::string password_;
+  // HMAC state of |password_|, refreshed by password_hmac() when the password
+  // changes.
+  rtc::HmacSha1 password_hmac_;
   std::vector<Candidate> candidates_;
   AddressMap connections_;
   int timeout_delay_;
@@ -517,6 +530,9 @@ class Port : public PortInterface,
                              const std::string& type,
                              bool is_final);
 
+  // Returns the key to sign responses and check requests with.
+  const rtc::HmacSha1& password_hmac();
+
   friend class Connection;
 };
 
@@ -611,6 +627,14 @@ class Connection : public CandidatePairInterface,
 
   sigslot::signal4<Connection*, const char*, size_t, int64_t> SignalReadPacket;
 
+  // Delivers the received data packets to |callback| with a direct call,
+  // instead of through SignalReadPacket, which is then no longer emitted. Used
+  // by the transport that owns the connection, which receives every packet.
+  typedef std::function<void(Connection*, const char*, size_t, int64_t)>
+      ReceivedPacketCallback;
+  void RegisterReceivedPacketCallback(ReceivedPacketCallback callback);
+  void DeregisterReceivedPacketCallback();
+
   sigslot::signal1<Connection*> SignalReadyToSend;
 
   // Called when a packet is received on this connection.
@@ -797,6 +821,9 @@ class Connection : public CandidatePairInterface,
   void LogCandidatePairEvent(webrtc::IceCandidatePairEventType type,
                              uint32_t transaction_id);
 
+  // Returns the key to sign requests and check responses with.
+  const rtc::HmacSha1& remote_password_hmac();
+
   WriteState write_state_;
   bool receiving_;
   bool connected_;
@@ -821,6 +848,8 @@ class Connection : public CandidatePairInterface,
   uint32_t remote_nomination_ = 0;
 
   IceMode remote_ice_mode_;
+  // HMAC state of the remote candidate password, see remote_password_hmac().
+  rtc::HmacSha1 remote_password_hmac_;
   StunRequestManager requests_;
   int rtt_;
   int rtt_samples_ = 0;
@@ -849,6 +878,7 @@ class Connection : public CandidatePairInterface,
 
   absl::optional<webrtc::IceCandidatePairDescription> log_description_;
   webrtc::IceEventLog* ice_event_log_ = nullptr;
+  ReceivedPacketCallback received_packet_callback_;
 
   friend class Port;
   friend class ConnectionRequest;
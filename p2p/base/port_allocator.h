@@ -87,6 +87,11 @@ enum {
   // Exclude link-local network interfaces
   // from considertaion after adapter enumeration.
   PORTALLOCATOR_DISABLE_LINK_LOCAL_NETWORKS = 0x10000,
+
+  // Allocates the UDP, relay and TCP ports of every network at once, instead
+  // of one phase per step_delay(), and resolves the hostnames of the TURN
+  // servers as soon as gathering starts, once for all networks.
+  PORTALLOCATOR_ENABLE_PARALLEL_GATHERING = 0x20000,
 };
 
 // Defines various reasons that have caused ICE regathering.
@@ -1457,6 +1457,42 @@ TEST_F(PortTest, TestLoopbackCall) {
   EXPECT_EQ(STUN_BINDING_ERROR_RESPONSE, msg->type());
 }
 
+// A registered callback gets the data packets of a connection, while STUN
+// messages are still handled by the connection itself.
+TEST_F(PortTest, TestReceivedPacketCallback) {
+  auto lport = CreateTestPort(kLocalAddr1, "lfrag", "lpass");
+  lport->SetIceRole(cricket::ICEROLE_CONTROLLING);
+  lport->SetIceTiebreaker(kTiebreaker1);
+  lport->PrepareAddress();
+  ASSERT_FALSE(lport->Candidates().empty());
+  Connection* conn =
+      lport->CreateConnection(lport->Candidates()[0], Port::ORIGIN_MESSAGE);
+  std::vector<std::string> received;
+  conn->RegisterReceivedPacketCallback(
+      [&received, conn](Connection* connection, const char* data, size_t size,
+                        int64_t packet_time_us) {
+        EXPECT_EQ(conn, connection);
+        EXPECT_EQ(1234, packet_time_us);
+        received.emplace_back(data, size);
+      });
+
+  const char kData[] = "data";
+  conn->OnReadPacket(kData, strlen(kData), /* packet_time_us */ 1234);
+  EXPECT_EQ(std::vector<std::string>({"data"}), received);
+
+  conn->Ping(0);
+  ASSERT_TRUE_WAIT(lport->last_stun_msg() != NULL, kDefaultTimeout);
+  conn->OnReadPacket(lport->last_stun_buf()->data<char>(),
+                     lport->last_stun_buf()->size(), /* packet_time_us */ 1234);
+  ASSERT_TRUE_WAIT(lport->last_stun_msg() != NULL, kDefaultTimeout);
+  EXPECT_EQ(STUN_BINDING_RESPONSE, lport->last_stun_msg()->type());
+  EXPECT_EQ(1u, received.size());
+
+  conn->DeregisterReceivedPacketCallback();
+  conn->OnReadPacket(kData, strlen(kData), /* packet_time_us */ 1234);
+  EXPECT_EQ(1u, received.size());
+}
+
 // This test verifies role conflict signal is received when there is
 // conflict in the role. In this case both ports are in controlling and
 // |rport| has higher tiebreaker value than |lport|. Since |lport| has lower
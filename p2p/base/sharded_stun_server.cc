@@ -0,0 +1,176 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/sharded_stun_server.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/stun_server.h"
+#include "rtc_base/async_socket.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+
+namespace cricket {
+
+namespace {
+
+// Datagrams read and answered per read event.
+const size_t kBatchSize = 32;
+// Larger requests are truncated, and then dropped since they don't parse.
+const size_t kMaxRequestSize = 1280;
+
+}  // namespace
+
+class ShardedStunServer::Shard : public sigslot::has_slots<> {
+ public:
+  explicit Shard(int index)
+      : thread_(rtc::Thread::CreateWithSocketServer()),
+        buffer_(kBatchSize * kMaxRequestSize) {
+    thread_->SetName("StunShard" + rtc::ToString(index), nullptr);
+  }
+
+  ~Shard() override {
+    thread_->Invoke<void>(RTC_FROM_HERE, [this] { socket_.reset(); });
+    thread_->Stop();
+  }
+
+  bool Start(const Config& config,
+             const rtc::SocketAddress& address,
+             rtc::SocketAddress* bound_address) {
+    thread_->Start();
+    return thread_->Invoke<bool>(RTC_FROM_HERE, [&] {
+      return StartOnThread(config, address, bound_address);
+    });
+  }
+
+  int64_t num_responses() {
+    return thread_->Invoke<int64_t>(RTC_FROM_HERE,
+                                    [this] { return num_responses_; });
+  }
+
+ private:
+  bool StartOnThread(const Config& config,
+                     const rtc::SocketAddress& address,
+                     rtc::SocketAddress* bound_address) {
+    socket_.reset(thread_->socketserver()->CreateAsyncSocket(address.family(),
+                                                             SOCK_DGRAM));
+    if (!socket_) {
+      return false;
+    }
+    if (config.num_shards > 1 &&
+        socket_->SetOption(rtc::Socket::OPT_REUSEPORT, 1) != 0) {
+      RTC_LOG(LS_ERROR) << "Failed to set SO_REUSEPORT, error "
+                        << socket_->GetError();
+      return false;
+    }
+    if (socket_->Bind(address) < 0) {
+      RTC_LOG(LS_ERROR) << "Bind() failed with error " << socket_->GetError();
+      return false;
+    }
+    *bound_address = socket_->GetLocalAddress();
+    socket_->SignalReadEvent.connect(this, &Shard::OnReadEvent);
+    return true;
+  }
+
+  void OnReadEvent(rtc::AsyncSocket* socket) {
+    RTC_DCHECK(thread_->IsCurrent());
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      datagrams_[i].data = &buffer_[i * kMaxRequestSize];
+      datagrams_[i].size = kMaxRequestSize;
+    }
+    int received = socket_->RecvFromBatch(datagrams_, kBatchSize);
+    if (received <= 0) {
+      return;
+    }
+    // Each request is overwritten by its response, and the datagrams without
+    // a response are skipped, so the batch is sent back as it is.
+    size_t num_responses = 0;
+    for (int i = 0; i < received; ++i) {
+      rtc::Socket::Datagram& datagram = datagrams_[i];
+      rtc::ArrayView<uint8_t> packet(reinterpret_cast<uint8_t*>(datagram.data),
+                                     datagram.size);
+      datagram.size = StunServer::WriteStatelessBindingResponse(
+          packet, datagram.addr,
+          rtc::ArrayView<uint8_t>(packet.data(), kMaxRequestSize));
+      if (datagram.size > 0) {
+        if (num_responses != static_cast<size_t>(i)) {
+          datagrams_[num_responses] = datagram;
+        }
+        ++num_responses;
+      }
+    }
+    if (num_responses == 0) {
+      return;
+    }
+    // Clients retransmit what can't be sent now.
+    int sent = socket_->SendToBatch(datagrams_, num_responses);
+    if (sent > 0) {
+      num_responses_ += sent;
+    }
+  }
+
+  const std::unique_ptr<rtc::Thread> thread_;
+  std::unique_ptr<rtc::AsyncSocket> socket_;
+  std::vector<char> buffer_;
+  rtc::Socket::Datagram datagrams_[kBatchSize];
+  int64_t num_responses_ = 0;
+};
+
+ShardedStunServer::ShardedStunServer(const Config& config) : config_(config) {
+  RTC_DCHECK_GT(config_.num_shards, 0);
+}
+
+ShardedStunServer::~ShardedStunServer() {
+  Stop();
+}
+
+bool ShardedStunServer::Start() {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  RTC_DCHECK(shards_.empty());
+  address_ = config_.address;
+  for (int i = 0; i < config_.num_shards; ++i) {
+    auto shard = absl::make_unique<Shard>(i);
+    // The other shards bind to the port that the first one got.
+    if (!shard->Start(config_, address_, &address_)) {
+      RTC_LOG(LS_ERROR) << "Failed to start STUN server shard " << i << " at "
+                        << address_.ToString();
+      Stop();
+      return false;
+    }
+    shards_.push_back(std::move(shard));
+  }
+  RTC_LOG(LS_INFO) << "Started " << shards_.size()
+                   << " STUN server shards at " << address_.ToString();
+  return true;
+}
+
+void ShardedStunServer::Stop() {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  shards_.clear();
+}
+
+rtc::SocketAddress ShardedStunServer::address() const {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  return address_;
+}
+
+std::vector<int64_t> ShardedStunServer::GetResponseCounts() {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  std::vector<int64_t> counts;
+  for (const auto& shard : shards_) {
+    counts.push_back(shard->num_responses());
+  }
+  return counts;
+}
+
+}  // namespace cricket
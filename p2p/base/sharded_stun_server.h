@@ -0,0 +1,65 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_SHARDED_STUN_SERVER_H_
+#define P2P_BASE_SHARDED_STUN_SERVER_H_
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/socket_address.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/thread_checker.h"
+
+namespace cricket {
+
+// Answers STUN binding requests on several worker threads. Each shard has its
+// own UDP socket, bound to the same address with SO_REUSEPORT, reads the
+// requests in batches, rewrites each of them in place into its response with
+// StunServer::WriteStatelessBindingResponse() and sends the batch back. No
+// state is kept between packets.
+//
+// Only RFC 5389 binding requests are answered; everything else, including
+// legacy RFC 3489 requests, is dropped. Use StunServer to answer those.
+class ShardedStunServer {
+ public:
+  struct Config {
+    // The address to listen at. If its port is 0, the first shard picks one,
+    // which address() returns.
+    rtc::SocketAddress address;
+    int num_shards = 1;
+  };
+
+  explicit ShardedStunServer(const Config& config);
+  ~ShardedStunServer();
+
+  // Starts the worker threads and binds their sockets. Returns false if a
+  // socket could not be bound, after stopping the shards already started.
+  bool Start();
+  void Stop();
+
+  rtc::SocketAddress address() const;
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+
+  // The number of responses sent by each shard.
+  std::vector<int64_t> GetResponseCounts();
+
+ private:
+  class Shard;
+
+  const Config config_;
+  rtc::ThreadChecker thread_checker_;
+  rtc::SocketAddress address_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace cricket
+
+#endif  // P2P_BASE_SHARDED_STUN_SERVER_H_
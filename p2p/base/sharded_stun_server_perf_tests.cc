@@ -0,0 +1,256 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/sharded_stun_server.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/stun_server.h"
+#include "rtc_base/async_socket.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/message_handler.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+constexpr int kNumGenerators = 4;
+// The kernel picks the shard of a request from the client address, so each
+// generator sends from several sockets.
+constexpr int kSocketsPerGenerator = 16;
+constexpr int kRequestsInFlightPerSocket = 16;
+constexpr int kWarmupMs = 200;
+constexpr int kMeasureMs = 2000;
+// A socket that got no answer for this long resends its window.
+constexpr int kLossTimeoutMs = 50;
+constexpr size_t kBatchSize = 32;
+constexpr size_t kMaxResponseSize = 128;
+const rtc::IPAddress kLoopback(INADDR_LOOPBACK);
+
+// The binding request sent by an ICE agent to a STUN server.
+std::string CreateBindingRequest() {
+  StunMessage request;
+  request.SetType(STUN_BINDING_REQUEST);
+  request.SetTransactionID("0123456789ab");
+  request.AddFingerprint();
+  rtc::ByteBufferWriter buffer;
+  request.Write(&buffer);
+  return std::string(buffer.Data(), buffer.Length());
+}
+
+// Keeps a window of binding requests in flight from each of its sockets, on
+// its own thread, and counts the responses.
+class StunLoadGenerator : public sigslot::has_slots<>,
+                          public rtc::MessageHandler {
+ public:
+  StunLoadGenerator(int index, const rtc::SocketAddress& server_address)
+      : thread_(rtc::Thread::CreateWithSocketServer()),
+        server_address_(server_address),
+        request_(CreateBindingRequest()),
+        buffer_(kBatchSize * kMaxResponseSize) {
+    thread_->SetName("StunLoad" + rtc::ToString(index), nullptr);
+    thread_->Start();
+    thread_->Invoke<void>(RTC_FROM_HERE, [this] { StartOnThread(); });
+  }
+
+  ~StunLoadGenerator() override {
+    thread_->Invoke<void>(RTC_FROM_HERE, [this] {
+      thread_->Clear(this);
+      sockets_.clear();
+    });
+    thread_->Stop();
+  }
+
+  int64_t num_responses() const { return num_responses_.load(); }
+
+ private:
+  struct ClientSocket {
+    std::unique_ptr<rtc::AsyncSocket> socket;
+    bool answered = false;
+  };
+
+  void StartOnThread() {
+    for (int i = 0; i < kSocketsPerGenerator; ++i) {
+      auto client = absl::make_unique<ClientSocket>();
+      client->socket.reset(thread_->socketserver()->CreateAsyncSocket(
+          AF_INET, SOCK_DGRAM));
+      RTC_CHECK_EQ(0, client->socket->Bind(rtc::SocketAddress(kLoopback, 0)));
+      client->socket->SignalReadEvent.connect(this,
+                                              &StunLoadGenerator::OnReadEvent);
+      SendRequests(client->socket.get(), kRequestsInFlightPerSocket);
+      sockets_.push_back(std::move(client));
+    }
+    thread_->PostDelayed(RTC_FROM_HERE, kLossTimeoutMs, this);
+  }
+
+  void SendRequests(rtc::AsyncSocket* socket, size_t count) {
+    rtc::Socket::Datagram requests[kBatchSize];
+    count = std::min(count, kBatchSize);
+    for (size_t i = 0; i < count; ++i) {
+      requests[i].data = const_cast<char*>(request_.data());
+      requests[i].size = request_.size();
+      requests[i].addr = server_address_;
+    }
+    socket->SendToBatch(requests, count);
+  }
+
+  void OnReadEvent(rtc::AsyncSocket* socket) {
+    rtc::Socket::Datagram responses[kBatchSize];
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      responses[i].data = &buffer_[i * kMaxResponseSize];
+      responses[i].size = kMaxResponseSize;
+    }
+    int received = socket->RecvFromBatch(responses, kBatchSize);
+    if (received <= 0) {
+      return;
+    }
+    int num_answers = 0;
+    for (int i = 0; i < received; ++i) {
+      if (responses[i].size >= kStunHeaderSize &&
+          rtc::GetBE16(responses[i].data) == STUN_BINDING_RESPONSE) {
+        ++num_answers;
+      }
+    }
+    num_responses_ += num_answers;
+    for (const auto& client : sockets_) {
+      if (client->socket.get() == socket) {
+        client->answered = true;
+      }
+    }
+    // Each answer makes room for a new request.
+    SendRequests(socket, num_answers);
+  }
+
+  // Refills the window of the sockets whose requests were all lost.
+  void OnMessage(rtc::Message* msg) override {
+    for (const auto& client : sockets_) {
+      if (!client->answered) {
+        SendRequests(client->socket.get(), kRequestsInFlightPerSocket);
+      }
+      client->answered = false;
+    }
+    thread_->PostDelayed(RTC_FROM_HERE, kLossTimeoutMs, this);
+  }
+
+  const std::unique_ptr<rtc::Thread> thread_;
+  const rtc::SocketAddress server_address_;
+  const std::string request_;
+  std::vector<char> buffer_;
+  std::vector<std::unique_ptr<ClientSocket>> sockets_;
+  std::atomic<int64_t> num_responses_{0};
+};
+
+// Loads the server at |server_address| and prints the answered requests per
+// second, in total and per core used by the server.
+void MeasureRequestRate(const std::string& trace,
+                        const rtc::SocketAddress& server_address,
+                        int num_server_threads) {
+  std::vector<std::unique_ptr<StunLoadGenerator>> generators;
+  for (int i = 0; i < kNumGenerators; ++i) {
+    generators.push_back(
+        absl::make_unique<StunLoadGenerator>(i, server_address));
+  }
+  auto count_responses = [&generators] {
+    int64_t count = 0;
+    for (const auto& generator : generators) {
+      count += generator->num_responses();
+    }
+    return count;
+  };
+
+  rtc::Thread::SleepMs(kWarmupMs);
+  const int64_t start_count = count_responses();
+  const int64_t start_ms = rtc::TimeMillis();
+  rtc::Thread::SleepMs(kMeasureMs);
+  const int64_t num_responses = count_responses() - start_count;
+  const int64_t elapsed_ms = rtc::TimeMillis() - start_ms;
+  generators.clear();
+
+  ASSERT_GT(num_responses, 0);
+  const double requests_per_second = num_responses * 1000.0 / elapsed_ms;
+  const int num_cores =
+      std::min<int>(num_server_threads, webrtc::CpuInfo::DetectNumberOfCores());
+  webrtc::test::PrintResult("stun_server", "_" + trace, "requests",
+                            requests_per_second, "requests/s", false);
+  webrtc::test::PrintResult("stun_server", "_" + trace, "requests_per_core",
+                            requests_per_second / num_cores, "requests/s",
+                            false);
+}
+
+// Runs a StunServer on a thread of its own.
+class StunServerThread {
+ public:
+  explicit StunServerThread(bool stateless)
+      : thread_(rtc::Thread::CreateWithSocketServer()) {
+    thread_->Start();
+    thread_->Invoke<void>(RTC_FROM_HERE, [this, stateless] {
+      rtc::AsyncUDPSocket* socket = rtc::AsyncUDPSocket::Create(
+          thread_->socketserver(), rtc::SocketAddress(kLoopback, 0));
+      address_ = socket->GetLocalAddress();
+      server_ = absl::make_unique<StunServer>(socket);
+      server_->set_stateless_binding_responses(stateless);
+    });
+  }
+
+  ~StunServerThread() {
+    thread_->Invoke<void>(RTC_FROM_HERE, [this] { server_.reset(); });
+    thread_->Stop();
+  }
+
+  const rtc::SocketAddress& address() const { return address_; }
+
+ private:
+  const std::unique_ptr<rtc::Thread> thread_;
+  rtc::SocketAddress address_;
+  std::unique_ptr<StunServer> server_;
+};
+
+}  // namespace
+
+// Compares StunServer, which parses each request into a StunMessage, with its
+// stateless mode and with ShardedStunServer, which also reads and writes in
+// batches, on as many threads as there are shards.
+TEST(StunServerPerfTest, BindingRequestRate) {
+  rtc::LogMessage::LogToDebug(rtc::LS_WARNING);
+  {
+    StunServerThread server(/*stateless=*/false);
+    MeasureRequestRate("stun_server", server.address(), 1);
+  }
+  {
+    StunServerThread server(/*stateless=*/true);
+    MeasureRequestRate("stun_server_stateless", server.address(), 1);
+  }
+  for (int num_shards : {1, 2, 4}) {
+    ShardedStunServer::Config config;
+    config.address = rtc::SocketAddress(kLoopback, 0);
+    config.num_shards = num_shards;
+    ShardedStunServer server(config);
+    ASSERT_TRUE(server.Start());
+    MeasureRequestRate("sharded_" + rtc::ToString(num_shards),
+                       server.address(), num_shards);
+  }
+}
+
+}  // namespace cricket
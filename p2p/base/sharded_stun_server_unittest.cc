@@ -0,0 +1,128 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/sharded_stun_server.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/stun.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/test_client.h"
+#include "rtc_base/thread.h"
+#include "test/gtest.h"
+
+namespace cricket {
+
+namespace {
+
+const rtc::IPAddress kLoopback(INADDR_LOOPBACK);
+const int kNumShards = 3;
+const int kNumClients = 16;
+
+std::unique_ptr<rtc::TestClient> CreateClient(rtc::Thread* thread) {
+  return absl::make_unique<rtc::TestClient>(
+      absl::WrapUnique(rtc::AsyncUDPSocket::Create(
+          thread->socketserver(), rtc::SocketAddress(kLoopback, 0))));
+}
+
+void SendRequest(rtc::TestClient* client,
+                 int type,
+                 const std::string& transaction_id,
+                 const rtc::SocketAddress& address) {
+  StunMessage request;
+  request.SetType(type);
+  request.SetTransactionID(transaction_id);
+  rtc::ByteBufferWriter buffer;
+  request.Write(&buffer);
+  client->SendTo(buffer.Data(), buffer.Length(), address);
+}
+
+}  // namespace
+
+class ShardedStunServerTest : public ::testing::Test {
+ public:
+  ShardedStunServerTest() : thread_(rtc::Thread::Current()) {}
+
+ protected:
+  rtc::AutoThread main_thread_;
+  rtc::Thread* thread_;
+};
+
+#if defined(WEBRTC_LINUX)
+// Every client is answered from the shared address, by whichever shard the
+// kernel picked, with its own address.
+TEST_F(ShardedStunServerTest, AnswersBindingRequests) {
+  ShardedStunServer::Config config;
+  config.address = rtc::SocketAddress(kLoopback, 0);
+  config.num_shards = kNumShards;
+  ShardedStunServer server(config);
+  ASSERT_TRUE(server.Start());
+  EXPECT_EQ(kNumShards, server.num_shards());
+  const rtc::SocketAddress address = server.address();
+  EXPECT_NE(0, address.port());
+
+  std::vector<std::unique_ptr<rtc::TestClient>> clients;
+  std::vector<std::string> transaction_ids;
+  for (int i = 0; i < kNumClients; ++i) {
+    clients.push_back(CreateClient(thread_));
+    transaction_ids.push_back(
+        rtc::CreateRandomString(kStunTransactionIdLength));
+    SendRequest(clients.back().get(), STUN_BINDING_REQUEST,
+                transaction_ids.back(), address);
+  }
+
+  for (int i = 0; i < kNumClients; ++i) {
+    std::unique_ptr<rtc::TestClient::Packet> packet =
+        clients[i]->NextPacket(rtc::TestClient::kTimeoutMs);
+    ASSERT_TRUE(packet);
+    EXPECT_EQ(address, packet->addr);
+    EXPECT_TRUE(StunMessage::ValidateFingerprint(packet->buf, packet->size));
+    StunMessage response;
+    rtc::ByteBufferReader buffer(packet->buf, packet->size);
+    ASSERT_TRUE(response.Read(&buffer));
+    EXPECT_EQ(STUN_BINDING_RESPONSE, response.type());
+    EXPECT_EQ(transaction_ids[i], response.transaction_id());
+    const StunAddressAttribute* mapped_address =
+        response.GetAddress(STUN_ATTR_XOR_MAPPED_ADDRESS);
+    ASSERT_TRUE(mapped_address);
+    EXPECT_EQ(clients[i]->address(), mapped_address->GetAddress());
+  }
+
+  int64_t num_responses = 0;
+  for (int64_t count : server.GetResponseCounts()) {
+    num_responses += count;
+  }
+  EXPECT_EQ(kNumClients, num_responses);
+}
+#endif
+
+// Requests that can't be answered statelessly are dropped.
+TEST_F(ShardedStunServerTest, DropsOtherMessages) {
+  ShardedStunServer::Config config;
+  config.address = rtc::SocketAddress(kLoopback, 0);
+  ShardedStunServer server(config);
+  ASSERT_TRUE(server.Start());
+
+  std::unique_ptr<rtc::TestClient> client = CreateClient(thread_);
+  // A legacy RFC 3489 transaction id.
+  SendRequest(client.get(), STUN_BINDING_REQUEST, "0123456789abcdef",
+              server.address());
+  SendRequest(client.get(), STUN_ALLOCATE_REQUEST, "0123456789ab",
+              server.address());
+  EXPECT_TRUE(client->CheckNoPacket());
+  EXPECT_EQ(std::vector<int64_t>({0}), server.GetResponseCounts());
+}
+
+}  // namespace cricket
@@ -0,0 +1,191 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/sharded_turn_server.h"
+
+#include <map>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/basic_packet_socket_factory.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/string_encode.h"
+
+namespace cricket {
+
+namespace {
+
+// Keys cached per shard. The cache is simply dropped when it is full.
+const size_t kMaxCachedKeys = 1000;
+// Datagrams read per read event when batching is enabled.
+const size_t kMaxBatchedReads = 16;
+
+}  // namespace
+
+// A TurnServer and the thread it runs on. The shard is its server's auth hook,
+// so that the keys it gets from the shared hook are cached without locking.
+class ShardedTurnServer::Shard : public TurnAuthInterface {
+ public:
+  Shard(int index, TurnAuthInterface* auth_hook)
+      : thread_(rtc::Thread::CreateWithSocketServer()), auth_hook_(auth_hook) {
+    thread_->SetName("TurnShard" + rtc::ToString(index), nullptr);
+  }
+
+  ~Shard() override {
+    thread_->Invoke<void>(RTC_FROM_HERE, [this] { server_.reset(); });
+    thread_->Stop();
+  }
+
+  bool Start(const Config& config,
+             const rtc::SocketAddress& address,
+             rtc::SocketAddress* bound_address) {
+    thread_->Start();
+    return thread_->Invoke<bool>(RTC_FROM_HERE, [&] {
+      return StartOnThread(config, address, bound_address);
+    });
+  }
+
+  rtc::Thread* thread() { return thread_.get(); }
+  TurnServer* server() { return server_.get(); }
+
+ private:
+  bool StartOnThread(const Config& config,
+                     const rtc::SocketAddress& address,
+                     rtc::SocketAddress* bound_address) {
+    rtc::AsyncSocket* socket =
+        thread_->socketserver()->CreateAsyncSocket(address.family(),
+                                                   SOCK_DGRAM);
+    if (!socket) {
+      return false;
+    }
+    if (config.num_shards > 1 &&
+        socket->SetOption(rtc::Socket::OPT_REUSEPORT, 1) != 0) {
+      RTC_LOG(LS_ERROR) << "Failed to set SO_REUSEPORT, error "
+                        << socket->GetError();
+      delete socket;
+      return false;
+    }
+    // Takes ownership of |socket|, also when it fails.
+    rtc::AsyncUDPSocket* udp_socket =
+        rtc::AsyncUDPSocket::Create(socket, address);
+    if (!udp_socket) {
+      return false;
+    }
+    if (config.enable_batched_relay) {
+      udp_socket->EnableBatchedReads(kMaxBatchedReads);
+    }
+    *bound_address = udp_socket->GetLocalAddress();
+
+    server_ = absl::make_unique<TurnServer>(thread_.get());
+    server_->set_realm(config.realm);
+    server_->set_software(config.software);
+    server_->set_auth_hook(this);
+    server_->set_enable_batched_relay(config.enable_batched_relay);
+    server_->AddInternalSocket(udp_socket, PROTO_UDP);
+    server_->SetExternalSocketFactory(
+        new rtc::BasicPacketSocketFactory(thread_.get()),
+        config.external_address);
+    return true;
+  }
+
+  // TurnAuthInterface implementation.
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    RTC_DCHECK(thread_->IsCurrent());
+    std::pair<std::string, std::string> id(username, realm);
+    auto it = keys_.find(id);
+    if (it != keys_.end()) {
+      *key = it->second;
+      return true;
+    }
+    if (!auth_hook_->GetKey(username, realm, key)) {
+      return false;
+    }
+    if (keys_.size() >= kMaxCachedKeys) {
+      keys_.clear();
+    }
+    keys_.emplace(std::move(id), *key);
+    return true;
+  }
+
+  const std::unique_ptr<rtc::Thread> thread_;
+  TurnAuthInterface* const auth_hook_;
+  std::unique_ptr<TurnServer> server_;
+  std::map<std::pair<std::string, std::string>, std::string> keys_;
+};
+
+ShardedTurnServer::Config::Config() = default;
+ShardedTurnServer::Config::~Config() = default;
+
+ShardedTurnServer::ShardedTurnServer(const Config& config,
+                                     TurnAuthInterface* auth_hook)
+    : config_(config), auth_hook_(auth_hook) {
+  RTC_DCHECK_GT(config_.num_shards, 0);
+  RTC_DCHECK(auth_hook_);
+}
+
+ShardedTurnServer::~ShardedTurnServer() {
+  Stop();
+}
+
+bool ShardedTurnServer::Start() {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  RTC_DCHECK(shards_.empty());
+  internal_address_ = config_.internal_address;
+  for (int i = 0; i < config_.num_shards; ++i) {
+    auto shard = absl::make_unique<Shard>(i, auth_hook_);
+    // The other shards bind to the port that the first one got.
+    if (!shard->Start(config_, internal_address_, &internal_address_)) {
+      RTC_LOG(LS_ERROR) << "Failed to start TURN server shard " << i << " at "
+                        << internal_address_.ToString();
+      Stop();
+      return false;
+    }
+    shards_.push_back(std::move(shard));
+  }
+  RTC_LOG(LS_INFO) << "Started " << shards_.size()
+                   << " TURN server shards at " << internal_address_.ToString();
+  return true;
+}
+
+void ShardedTurnServer::Stop() {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  shards_.clear();
+}
+
+rtc::SocketAddress ShardedTurnServer::internal_address() const {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  return internal_address_;
+}
+
+rtc::Thread* ShardedTurnServer::shard_thread(int index) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  return shards_[index]->thread();
+}
+
+TurnServer* ShardedTurnServer::shard_server(int index) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  return shards_[index]->server();
+}
+
+std::vector<size_t> ShardedTurnServer::GetAllocationCounts() {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  std::vector<size_t> counts;
+  for (const auto& shard : shards_) {
+    counts.push_back(shard->thread()->Invoke<size_t>(
+        RTC_FROM_HERE, [&] { return shard->server()->allocations().size(); }));
+  }
+  return counts;
+}
+
+}  // namespace cricket
@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_SHARDED_TURN_SERVER_H_
+#define P2P_BASE_SHARDED_TURN_SERVER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "p2p/base/turn_server.h"
+#include "rtc_base/socket_address.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/thread_checker.h"
+
+namespace cricket {
+
+// Runs a TurnServer on each of several worker threads. Each shard has its own
+// UDP socket, bound to the same internal address with SO_REUSEPORT, and its
+// own allocations, relay sockets and nonce key. The kernel hashes the
+// addresses of a datagram to pick the socket that receives it, so all packets
+// of a client land on the same shard, and nothing is shared between shards.
+//
+// Only UDP clients are supported, and SO_REUSEPORT must distribute datagrams
+// between the sockets, as on Linux.
+class ShardedTurnServer {
+ public:
+  struct Config {
+    Config();
+    ~Config();
+
+    // The address the clients send to. If its port is 0, the first shard
+    // picks one, which internal_address() returns.
+    rtc::SocketAddress internal_address;
+    // The address to bind the relay sockets of allocations to.
+    rtc::SocketAddress external_address;
+    std::string realm;
+    std::string software;
+    int num_shards = 1;
+    // See TurnServer::set_enable_batched_relay(). Also makes the shards read
+    // their sockets in batches.
+    bool enable_batched_relay = false;
+  };
+
+  // |auth_hook| is called from all worker threads, and must be thread safe.
+  // Each shard caches the keys it gets from it.
+  ShardedTurnServer(const Config& config, TurnAuthInterface* auth_hook);
+  ~ShardedTurnServer();
+
+  // Starts the worker threads and binds their sockets. Returns false if a
+  // socket could not be bound, after stopping the shards already started.
+  bool Start();
+  void Stop();
+
+  rtc::SocketAddress internal_address() const;
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+  // The worker thread of shard |index|. Its TurnServer may only be used on
+  // this thread.
+  rtc::Thread* shard_thread(int index);
+  TurnServer* shard_server(int index);
+
+  // The number of allocations on each shard.
+  std::vector<size_t> GetAllocationCounts();
+
+ private:
+  class Shard;
+
+  const Config config_;
+  TurnAuthInterface* const auth_hook_;
+  rtc::ThreadChecker thread_checker_;
+  rtc::SocketAddress internal_address_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace cricket
+
+#endif  // P2P_BASE_SHARDED_TURN_SERVER_H_
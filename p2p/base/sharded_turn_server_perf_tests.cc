@@ -0,0 +1,349 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/sharded_turn_server.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/test_turn_server.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+constexpr int kNumGenerators = 4;
+constexpr int kClientsPerGenerator = 100;
+constexpr int kPacketsPerClient = 500;
+// Packets a generator has sent that its peer socket has not yet received.
+constexpr int kMaxPacketsInFlight = 1024;
+constexpr size_t kPayloadSize = 160;
+constexpr int kChannelId = 0x4000;
+constexpr int kSetupTimeoutMs = 10000;
+// Requests are retransmitted at this interval until answered.
+constexpr int kRetransmitIntervalMs = 100;
+// Packets in flight for this long without any arriving are counted as lost.
+constexpr int kLossTimeoutMs = 50;
+// A load run ends when nothing more has arrived for this long.
+constexpr int kDrainTimeoutMs = 500;
+const rtc::IPAddress kLoopback(INADDR_LOOPBACK);
+
+// Encodes a request for the TURN server, signed if |nonce| is set.
+std::string CreateRequest(int type,
+                          const std::string& transaction_id,
+                          const std::string& username,
+                          const std::string& realm,
+                          const std::string& nonce,
+                          const rtc::SocketAddress& peer) {
+  TurnMessage request;
+  request.SetType(type);
+  request.SetTransactionID(transaction_id);
+  if (type == STUN_ALLOCATE_REQUEST) {
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24));
+  } else {
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_CHANNEL_NUMBER, kChannelId << 16));
+    request.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_PEER_ADDRESS, peer));
+  }
+  if (!nonce.empty()) {
+    request.AddAttribute(absl::make_unique<StunByteStringAttribute>(
+        STUN_ATTR_USERNAME, username));
+    request.AddAttribute(
+        absl::make_unique<StunByteStringAttribute>(STUN_ATTR_REALM, realm));
+    request.AddAttribute(
+        absl::make_unique<StunByteStringAttribute>(STUN_ATTR_NONCE, nonce));
+    std::string key;
+    TestTurnAuth().GetKey(username, realm, &key);
+    request.AddMessageIntegrity(key);
+  }
+  rtc::ByteBufferWriter buffer;
+  request.Write(&buffer);
+  return std::string(buffer.Data(), buffer.Length());
+}
+
+// Drives |kClientsPerGenerator| TURN clients on its own thread. Each client
+// allocates and binds a channel to the generator's peer socket, and then
+// sends ChannelData stamped with the send time, from which the peer socket
+// computes the relay latency.
+class TurnLoadGenerator : public rtc::Runnable, public sigslot::has_slots<> {
+ public:
+  TurnLoadGenerator(int index,
+                    const rtc::SocketAddress& server_address,
+                    rtc::Event* start_load)
+      : index_(index),
+        server_address_(server_address),
+        start_load_(start_load),
+        thread_(rtc::Thread::CreateWithSocketServer()) {}
+
+  void Start() { thread_->Start(this); }
+  // Waits for the load to end. Stopping the thread before would keep it from
+  // processing I/O.
+  void Join() {
+    load_done_.Wait(rtc::Event::kForever);
+    thread_->Stop();
+  }
+
+  // Signaled when the clients are ready, or have given up.
+  rtc::Event* setup_done() { return &setup_done_; }
+  int num_ready_clients() const { return num_ready_; }
+  int num_sent() const { return num_sent_; }
+  int num_received() const { return num_received_; }
+  const std::vector<int64_t>& latencies_us() const { return latencies_us_; }
+
+  void Run(rtc::Thread* thread) override {
+    peer_socket_.reset(rtc::AsyncUDPSocket::Create(
+        thread->socketserver(), rtc::SocketAddress(kLoopback, 0)));
+    RTC_CHECK(peer_socket_);
+    peer_socket_->SignalReadPacket.connect(this,
+                                           &TurnLoadGenerator::OnPeerPacket);
+    for (int i = 0; i < kClientsPerGenerator; ++i) {
+      auto client = absl::make_unique<Client>();
+      client->username =
+          "user" + rtc::ToString(index_) + "_" + rtc::ToString(i);
+      client->socket.reset(rtc::AsyncUDPSocket::Create(
+          thread->socketserver(), rtc::SocketAddress(kLoopback, 0)));
+      RTC_CHECK(client->socket);
+      client->socket->SignalReadPacket.connect(
+          this, &TurnLoadGenerator::OnClientPacket);
+      // Without credentials, the server answers with its realm and nonce.
+      SendRequest(client.get(), STUN_ALLOCATE_REQUEST);
+      clients_.push_back(std::move(client));
+    }
+    int64_t deadline_ms = rtc::TimeMillis() + kSetupTimeoutMs;
+    while (num_ready_ < kClientsPerGenerator &&
+           rtc::TimeMillis() < deadline_ms) {
+      thread->ProcessMessages(kRetransmitIntervalMs);
+      // The server socket drops requests when they come in faster than it
+      // reads them.
+      for (const auto& client : clients_) {
+        if (!client->ready) {
+          Send(client.get(), client->request);
+        }
+      }
+    }
+    setup_done_.Set();
+    start_load_->Wait(rtc::Event::kForever);
+
+    std::vector<Client*> ready_clients;
+    for (const auto& client : clients_) {
+      if (client->ready) {
+        ready_clients.push_back(client.get());
+      }
+    }
+    const int num_packets =
+        static_cast<int>(ready_clients.size()) * kPacketsPerClient;
+    std::string message(4 + kPayloadSize, 0);
+    rtc::SetBE16(&message[0], kChannelId);
+    rtc::SetBE16(&message[2], static_cast<uint16_t>(kPayloadSize));
+    int64_t last_progress_ms = rtc::TimeMillis();
+    int last_received = 0;
+    int num_lost = 0;
+    while (num_received_ + num_lost < num_packets &&
+           rtc::TimeMillis() - last_progress_ms < kDrainTimeoutMs) {
+      while (num_sent_ < num_packets &&
+             num_sent_ - num_received_ - num_lost < kMaxPacketsInFlight) {
+        rtc::SetBE64(&message[4], rtc::TimeMicros());
+        Send(ready_clients[num_sent_ % ready_clients.size()], message);
+        ++num_sent_;
+      }
+      thread->ProcessMessages(1);
+      if (num_received_ != last_received) {
+        last_received = num_received_;
+        last_progress_ms = rtc::TimeMillis();
+      } else if (rtc::TimeMillis() - last_progress_ms > kLossTimeoutMs) {
+        num_lost = num_sent_ - num_received_;
+      }
+    }
+
+    clients_.clear();
+    peer_socket_.reset();
+    load_done_.Set();
+  }
+
+ private:
+  struct Client {
+    std::string username;
+    std::string realm;
+    std::string nonce;
+    // The request to retransmit until it is answered.
+    std::string request;
+    std::string transaction_id;
+    std::unique_ptr<rtc::AsyncUDPSocket> socket;
+    bool ready = false;
+  };
+
+  void SendRequest(Client* client, int type) {
+    client->transaction_id =
+        rtc::CreateRandomString(kStunTransactionIdLength);
+    client->request = CreateRequest(type, client->transaction_id,
+                                    client->username, client->realm,
+                                    client->nonce,
+                                    peer_socket_->GetLocalAddress());
+    Send(client, client->request);
+  }
+
+  void Send(Client* client, const std::string& packet) {
+    client->socket->SendTo(packet.data(), packet.size(), server_address_,
+                           rtc::PacketOptions());
+  }
+
+  void OnClientPacket(rtc::AsyncPacketSocket* socket,
+                      const char* data,
+                      size_t size,
+                      const rtc::SocketAddress& addr,
+                      const int64_t& packet_time_us) {
+    auto it = std::find_if(clients_.begin(), clients_.end(),
+                           [socket](const std::unique_ptr<Client>& client) {
+                             return client->socket.get() == socket;
+                           });
+    RTC_CHECK(it != clients_.end());
+    Client* client = it->get();
+    TurnMessage response;
+    rtc::ByteBufferReader buffer(data, size);
+    if (!response.Read(&buffer)) {
+      return;
+    }
+    if (response.type() == STUN_ALLOCATE_ERROR_RESPONSE &&
+        response.GetErrorCodeValue() == STUN_ERROR_UNAUTHORIZED &&
+        client->nonce.empty()) {
+      client->realm = response.GetByteString(STUN_ATTR_REALM)->GetString();
+      client->nonce = response.GetByteString(STUN_ATTR_NONCE)->GetString();
+      SendRequest(client, STUN_ALLOCATE_REQUEST);
+    } else if (response.transaction_id() != client->transaction_id) {
+      // A late answer to an earlier request.
+      return;
+    } else if (response.type() == STUN_ALLOCATE_RESPONSE) {
+      SendRequest(client, TURN_CHANNEL_BIND_REQUEST);
+    } else if (response.type() == TURN_CHANNEL_BIND_RESPONSE &&
+               !client->ready) {
+      client->ready = true;
+      ++num_ready_;
+    }
+  }
+
+  void OnPeerPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& addr,
+                    const int64_t& packet_time_us) {
+    if (size != kPayloadSize) {
+      return;
+    }
+    latencies_us_.push_back(rtc::TimeMicros() -
+                            static_cast<int64_t>(rtc::GetBE64(data)));
+    ++num_received_;
+  }
+
+  const int index_;
+  const rtc::SocketAddress server_address_;
+  rtc::Event* const start_load_;
+  rtc::Event setup_done_;
+  rtc::Event load_done_;
+  std::unique_ptr<rtc::Thread> thread_;
+  std::unique_ptr<rtc::AsyncUDPSocket> peer_socket_;
+  std::vector<std::unique_ptr<Client>> clients_;
+  int num_ready_ = 0;
+  int num_sent_ = 0;
+  int num_received_ = 0;
+  std::vector<int64_t> latencies_us_;
+};
+
+void RunRelayLoad(int num_shards) {
+  TestTurnAuth auth;
+  ShardedTurnServer::Config config;
+  config.internal_address = rtc::SocketAddress(kLoopback, 0);
+  config.external_address = rtc::SocketAddress(kLoopback, 0);
+  config.realm = kTestRealm;
+  config.software = kTestSoftware;
+  config.num_shards = num_shards;
+  config.enable_batched_relay = true;
+  ShardedTurnServer server(config, &auth);
+  ASSERT_TRUE(server.Start());
+
+  // Wakes all generators at once.
+  rtc::Event start_load(/*manual_reset=*/true, /*initially_signaled=*/false);
+  std::vector<std::unique_ptr<TurnLoadGenerator>> generators;
+  for (int i = 0; i < kNumGenerators; ++i) {
+    generators.push_back(absl::make_unique<TurnLoadGenerator>(
+        i, server.internal_address(), &start_load));
+    generators.back()->Start();
+  }
+  int num_ready_clients = 0;
+  for (const auto& generator : generators) {
+    generator->setup_done()->Wait(rtc::Event::kForever);
+    num_ready_clients += generator->num_ready_clients();
+  }
+  EXPECT_EQ(kNumGenerators * kClientsPerGenerator, num_ready_clients);
+
+  int64_t start_us = rtc::TimeMicros();
+  start_load.Set();
+  for (const auto& generator : generators) {
+    generator->Join();
+  }
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+
+  int num_sent = 0;
+  std::vector<int64_t> latencies_us;
+  for (const auto& generator : generators) {
+    num_sent += generator->num_sent();
+    latencies_us.insert(latencies_us.end(),
+                        generator->latencies_us().begin(),
+                        generator->latencies_us().end());
+  }
+  ASSERT_FALSE(latencies_us.empty());
+  auto p99 = latencies_us.begin() + latencies_us.size() * 99 / 100;
+  std::nth_element(latencies_us.begin(), p99, latencies_us.end());
+
+  const std::string story = "_" + rtc::ToString(num_shards) + "_shards";
+  webrtc::test::PrintResult("sharded_turn_server", story, "relayed_packets",
+                            static_cast<double>(latencies_us.size()) *
+                                rtc::kNumMicrosecsPerSec / elapsed_us,
+                            "packets/s", true);
+  webrtc::test::PrintResult("sharded_turn_server", story, "lost_packets",
+                            num_sent - static_cast<double>(latencies_us.size()),
+                            "packets", false);
+  webrtc::test::PrintResult("sharded_turn_server", story, "relay_latency_p99",
+                            static_cast<double>(*p99), "us", true);
+
+  std::vector<size_t> allocations = server.GetAllocationCounts();
+  for (size_t i = 0; i < allocations.size(); ++i) {
+    RTC_LOG(LS_INFO) << "Shard " << i << ": " << allocations[i]
+                     << " allocations";
+  }
+}
+
+}  // namespace
+
+// Relays ChannelData from |kNumGenerators| * |kClientsPerGenerator| clients
+// over loopback through 1, 2 and 4 shards.
+TEST(ShardedTurnServerPerfTest, RelayThroughputAndLatency) {
+  for (int num_shards : {1, 2, 4}) {
+    RunRelayLoad(num_shards);
+  }
+}
+
+}  // namespace cricket
@@ -0,0 +1,111 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/sharded_turn_server.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/test_turn_server.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/test_client.h"
+#include "rtc_base/thread.h"
+#include "test/gtest.h"
+
+namespace cricket {
+
+namespace {
+
+const rtc::IPAddress kLoopback(INADDR_LOOPBACK);
+const int kNumShards = 3;
+const int kNumClients = 16;
+
+ShardedTurnServer::Config CreateConfig(const rtc::SocketAddress& address) {
+  ShardedTurnServer::Config config;
+  config.internal_address = address;
+  config.external_address = rtc::SocketAddress(kLoopback, 0);
+  config.realm = kTestRealm;
+  config.num_shards = kNumShards;
+  return config;
+}
+
+}  // namespace
+
+class ShardedTurnServerTest : public ::testing::Test {
+ public:
+  ShardedTurnServerTest() : thread_(rtc::Thread::Current()) {}
+
+ protected:
+  rtc::AutoThread main_thread_;
+  rtc::Thread* thread_;
+  TestTurnAuth auth_;
+};
+
+#if defined(WEBRTC_LINUX)
+// All shards listen at the same address, and each client gets its answers
+// from there, from whichever shard the kernel picked.
+TEST_F(ShardedTurnServerTest, ShardsShareInternalAddress) {
+  ShardedTurnServer server(
+      CreateConfig(rtc::SocketAddress(kLoopback, 0)), &auth_);
+  ASSERT_TRUE(server.Start());
+  EXPECT_EQ(kNumShards, server.num_shards());
+  const rtc::SocketAddress address = server.internal_address();
+  EXPECT_NE(0, address.port());
+
+  std::vector<std::unique_ptr<rtc::TestClient>> clients;
+  for (int i = 0; i < kNumClients; ++i) {
+    clients.push_back(absl::make_unique<rtc::TestClient>(
+        absl::WrapUnique(rtc::AsyncUDPSocket::Create(
+            thread_->socketserver(), rtc::SocketAddress(kLoopback, 0)))));
+    // Without credentials, the server answers with a realm and a nonce.
+    TurnMessage request;
+    request.SetType(STUN_ALLOCATE_REQUEST);
+    request.SetTransactionID(rtc::CreateRandomString(kStunTransactionIdLength));
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24));
+    rtc::ByteBufferWriter buffer;
+    request.Write(&buffer);
+    clients.back()->SendTo(buffer.Data(), buffer.Length(), address);
+  }
+
+  for (const auto& client : clients) {
+    std::unique_ptr<rtc::TestClient::Packet> packet =
+        client->NextPacket(rtc::TestClient::kTimeoutMs);
+    ASSERT_TRUE(packet);
+    EXPECT_EQ(address, packet->addr);
+    TurnMessage response;
+    rtc::ByteBufferReader buffer(packet->buf, packet->size);
+    ASSERT_TRUE(response.Read(&buffer));
+    EXPECT_EQ(STUN_ALLOCATE_ERROR_RESPONSE, response.type());
+    EXPECT_EQ(STUN_ERROR_UNAUTHORIZED, response.GetErrorCodeValue());
+    ASSERT_TRUE(response.GetByteString(STUN_ATTR_REALM));
+    EXPECT_EQ(kTestRealm,
+              response.GetByteString(STUN_ATTR_REALM)->GetString());
+  }
+}
+#endif
+
+// A socket without SO_REUSEPORT at the address keeps the shards from binding
+// to it.
+TEST_F(ShardedTurnServerTest, StartFailsIfAddressInUse) {
+  std::unique_ptr<rtc::AsyncUDPSocket> socket(rtc::AsyncUDPSocket::Create(
+      thread_->socketserver(), rtc::SocketAddress(kLoopback, 0)));
+  ASSERT_TRUE(socket);
+  ShardedTurnServer server(CreateConfig(socket->GetLocalAddress()), &auth_);
+  EXPECT_FALSE(server.Start());
+  EXPECT_EQ(0, server.num_shards());
+}
+
+}  // namespace cricket
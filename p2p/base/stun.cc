@@ -17,6 +17,7 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "p2p/base/stun_message_view.h"
 #include "rtc_base/byte_order.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/crc32.h"
@@ -60,7 +61,6 @@ const char STUN_ERROR_REASON_SERVER_ERROR[] = "Server Error";
 
 const char TURN_MAGIC_COOKIE_VALUE[] = {'\x72', '\xC6', '\x4B', '\xC6'};
 const char EMPTY_TRANSACTION_ID[] = "0000000000000000";
-const uint32_t STUN_FINGERPRINT_XOR_VALUE = 0x5354554E;
 
 // StunMessage
 
@@ -257,6 +257,13 @@ bool StunMessage::ValidateMessageIntegrity(const char* data,
                 sizeof(hmac)) == 0;
 }
 
+bool StunMessage::ValidateMessageIntegrity(const char* data,
+                                           size_t size,
+                                           const rtc::HmacSha1& key) {
+  StunMessageView view;
+  return view.Parse(data, size) && view.ValidateMessageIntegrity(key);
+}
+
 bool StunMessage::AddMessageIntegrity(const std::string& password) {
   return AddMessageIntegrity(password.c_str(), password.size());
 }
@@ -291,6 +298,24 @@ bool StunMessage::AddMessageIntegrity(const char* key, size_t keylen) {
   return true;
 }
 
+bool StunMessage::AddMessageIntegrity(const rtc::HmacSha1& key) {
+  auto msg_integrity_attr_ptr = absl::make_unique<StunByteStringAttribute>(
+      STUN_ATTR_MESSAGE_INTEGRITY, std::string(kStunMessageIntegritySize, '0'));
+  auto* msg_integrity_attr = msg_integrity_attr_ptr.get();
+  AddAttribute(std::move(msg_integrity_attr_ptr));
+
+  ByteBufferWriter buf;
+  if (!Write(&buf))
+    return false;
+
+  size_t msg_len_for_hmac =
+      buf.Length() - kStunAttributeHeaderSize - msg_integrity_attr->length();
+  uint8_t hmac[kStunMessageIntegritySize];
+  key.Compute(buf.Data(), msg_len_for_hmac, hmac);
+  msg_integrity_attr->CopyBytes(hmac, sizeof(hmac));
+  return true;
+}
+
 // Verifies a message is in fact a STUN message, by performing the checks
 // outlined in RFC 5389, section 7.3, including the FINGERPRINT check detailed
 // in section 15.5.
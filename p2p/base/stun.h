@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "rtc_base/byte_buffer.h"
+#include "rtc_base/hmac_sha1.h"
 #include "rtc_base/ip_address.h"
 #include "rtc_base/socket_address.h"
 
@@ -119,6 +120,9 @@ const size_t kStunLegacyTransactionIdLength = 16;
 // STUN Message Integrity HMAC length.
 const size_t kStunMessageIntegritySize = 20;
 
+// The FINGERPRINT CRC-32 is XOR'ed with this value ("STUN").
+const uint32_t STUN_FINGERPRINT_XOR_VALUE = 0x5354554E;
+
 class StunAddressAttribute;
 class StunAttribute;
 class StunByteStringAttribute;
@@ -178,9 +182,15 @@ class StunMessage {
   static bool ValidateMessageIntegrity(const char* data,
                                        size_t size,
                                        const std::string& password);
+  // Same as above, with the HMAC state of the password precomputed in |key|.
+  // This doesn't allocate memory, but only accepts RFC 5389 messages.
+  static bool ValidateMessageIntegrity(const char* data,
+                                       size_t size,
+                                       const rtc::HmacSha1& key);
   // Adds a MESSAGE-INTEGRITY attribute that is valid for the current message.
   bool AddMessageIntegrity(const std::string& password);
   bool AddMessageIntegrity(const char* key, size_t keylen);
+  bool AddMessageIntegrity(const rtc::HmacSha1& key);
 
   // Verifies that a given buffer is STUN by checking for a correct FINGERPRINT.
   static bool ValidateFingerprint(const char* data, size_t size);
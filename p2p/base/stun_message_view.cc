@@ -0,0 +1,316 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/stun_message_view.h"
+
+#include <string.h>
+
+#include "rtc_base/byte_order.h"
+#include "rtc_base/crc32.h"
+
+namespace cricket {
+namespace {
+
+// The magic cookie followed by the transaction id, which XOR-MAPPED-ADDRESS
+// values are masked with.
+constexpr size_t kXorMaskOffset = kStunTransactionIdOffset -
+                                  kStunMagicCookieLength;
+
+size_t PaddedSize(size_t size) {
+  return (size + 3) & ~static_cast<size_t>(3);
+}
+
+// Returns the offset of the header of the first attribute of |type| in the
+// well-formed message |data|, or 0 if there is none.
+size_t FindAttribute(const uint8_t* data, size_t size, int type) {
+  size_t offset = kStunHeaderSize;
+  while (offset < size) {
+    if (rtc::GetBE16(data + offset) == type) {
+      return offset;
+    }
+    offset += kStunAttributeHeaderSize +
+              PaddedSize(rtc::GetBE16(data + offset + sizeof(uint16_t)));
+  }
+  return 0;
+}
+
+}  // namespace
+
+StunMessageView::StunMessageView() : data_(nullptr), size_(0) {}
+
+bool StunMessageView::Parse(const char* data, size_t size) {
+  data_ = nullptr;
+  size_ = 0;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  if (size < kStunHeaderSize || size % 4 != 0) {
+    return false;
+  }
+  // RTP and RTCP set the most significant bit, STUN messages never do.
+  if ((bytes[0] & 0xC0) != 0 ||
+      rtc::GetBE16(bytes + sizeof(uint16_t)) + kStunHeaderSize != size ||
+      rtc::GetBE32(bytes + kXorMaskOffset) != kStunMagicCookie) {
+    return false;
+  }
+  // Since both the size and the padded attributes are multiples of 4, the
+  // attributes are within bounds if the last one ends at the end.
+  size_t offset = kStunHeaderSize;
+  while (offset < size) {
+    offset += kStunAttributeHeaderSize +
+              PaddedSize(rtc::GetBE16(bytes + offset + sizeof(uint16_t)));
+  }
+  if (offset != size) {
+    return false;
+  }
+  data_ = bytes;
+  size_ = size;
+  return true;
+}
+
+int StunMessageView::type() const {
+  return data_ ? rtc::GetBE16(data_) : 0;
+}
+
+rtc::ArrayView<const uint8_t> StunMessageView::transaction_id() const {
+  if (!data_) {
+    return rtc::ArrayView<const uint8_t>();
+  }
+  return rtc::ArrayView<const uint8_t>(data_ + kStunTransactionIdOffset,
+                                       kStunTransactionIdLength);
+}
+
+bool StunMessageView::HasAttribute(int type) const {
+  return data_ && FindAttribute(data_, size_, type) != 0;
+}
+
+bool StunMessageView::GetAttribute(int type,
+                                   rtc::ArrayView<const uint8_t>* value) const {
+  const size_t offset = data_ ? FindAttribute(data_, size_, type) : 0;
+  if (offset == 0) {
+    return false;
+  }
+  *value = rtc::ArrayView<const uint8_t>(
+      data_ + offset + kStunAttributeHeaderSize,
+      rtc::GetBE16(data_ + offset + sizeof(uint16_t)));
+  return true;
+}
+
+bool StunMessageView::GetUInt32(int type, uint32_t* value) const {
+  rtc::ArrayView<const uint8_t> attribute;
+  if (!GetAttribute(type, &attribute) || attribute.size() != sizeof(*value)) {
+    return false;
+  }
+  *value = rtc::GetBE32(attribute.data());
+  return true;
+}
+
+bool StunMessageView::GetUInt64(int type, uint64_t* value) const {
+  rtc::ArrayView<const uint8_t> attribute;
+  if (!GetAttribute(type, &attribute) || attribute.size() != sizeof(*value)) {
+    return false;
+  }
+  *value = rtc::GetBE64(attribute.data());
+  return true;
+}
+
+bool StunMessageView::GetXorAddress(int type,
+                                    rtc::SocketAddress* address) const {
+  rtc::ArrayView<const uint8_t> attribute;
+  if (!GetAttribute(type, &attribute) || attribute.size() < 4) {
+    return false;
+  }
+  const uint16_t port =
+      rtc::GetBE16(attribute.data() + 2) ^ (kStunMagicCookie >> 16);
+  const uint8_t* mask = data_ + kXorMaskOffset;
+  if (attribute[1] == STUN_ADDRESS_IPV4 &&
+      attribute.size() == StunAddressAttribute::SIZE_IP4) {
+    in_addr v4addr;
+    uint8_t* ip = reinterpret_cast<uint8_t*>(&v4addr);
+    for (size_t i = 0; i < sizeof(v4addr); ++i) {
+      ip[i] = attribute[4 + i] ^ mask[i];
+    }
+    *address = rtc::SocketAddress(rtc::IPAddress(v4addr), port);
+    return true;
+  }
+  if (attribute[1] == STUN_ADDRESS_IPV6 &&
+      attribute.size() == StunAddressAttribute::SIZE_IP6) {
+    in6_addr v6addr;
+    uint8_t* ip = reinterpret_cast<uint8_t*>(&v6addr);
+    for (size_t i = 0; i < sizeof(v6addr); ++i) {
+      ip[i] = attribute[4 + i] ^ mask[i];
+    }
+    *address = rtc::SocketAddress(rtc::IPAddress(v6addr), port);
+    return true;
+  }
+  return false;
+}
+
+bool StunMessageView::ValidateMessageIntegrity(
+    const rtc::HmacSha1& key) const {
+  const size_t offset =
+      data_ ? FindAttribute(data_, size_, STUN_ATTR_MESSAGE_INTEGRITY) : 0;
+  if (offset == 0 || rtc::GetBE16(data_ + offset + sizeof(uint16_t)) !=
+                         kStunMessageIntegritySize) {
+    return false;
+  }
+  // The MAC covers the message up to the MESSAGE-INTEGRITY attribute, with a
+  // header length as if the message ended right after that attribute.
+  uint8_t length[sizeof(uint16_t)];
+  rtc::SetBE16(length, static_cast<uint16_t>(offset + kStunAttributeHeaderSize +
+                                             kStunMessageIntegritySize -
+                                             kStunHeaderSize));
+  uint8_t mac[rtc::HmacSha1::kDigestSize];
+  key.Compute({rtc::ArrayView<const uint8_t>(data_, sizeof(uint16_t)),
+               rtc::ArrayView<const uint8_t>(length),
+               rtc::ArrayView<const uint8_t>(data_ + kXorMaskOffset,
+                                             offset - kXorMaskOffset)},
+              mac);
+  return memcmp(data_ + offset + kStunAttributeHeaderSize, mac,
+                sizeof(mac)) == 0;
+}
+
+bool StunMessageView::ValidateFingerprint() const {
+  return data_ && StunMessage::ValidateFingerprint(data(), size_);
+}
+
+StunMessageWriter::StunMessageWriter(
+    int type,
+    rtc::ArrayView<const uint8_t> transaction_id,
+    rtc::ArrayView<uint8_t> buffer)
+    : buffer_(buffer), size_(kStunHeaderSize), ok_(true) {
+  if (buffer_.size() < kStunHeaderSize ||
+      transaction_id.size() != kStunTransactionIdLength) {
+    ok_ = false;
+    return;
+  }
+  rtc::SetBE16(buffer_.data(), static_cast<uint16_t>(type));
+  rtc::SetBE16(buffer_.data() + sizeof(uint16_t), 0);
+  rtc::SetBE32(buffer_.data() + kXorMaskOffset, kStunMagicCookie);
+  memcpy(buffer_.data() + kStunTransactionIdOffset, transaction_id.data(),
+         kStunTransactionIdLength);
+}
+
+uint8_t* StunMessageWriter::AddAttribute(int type, size_t value_size) {
+  const size_t padded_size = PaddedSize(value_size);
+  if (!ok_ || value_size > 0xFFFF ||
+      size_ + kStunAttributeHeaderSize + padded_size > buffer_.size() ||
+      size_ + kStunAttributeHeaderSize + padded_size - kStunHeaderSize >
+          0xFFFF) {
+    ok_ = false;
+    return nullptr;
+  }
+  uint8_t* header = buffer_.data() + size_;
+  rtc::SetBE16(header, static_cast<uint16_t>(type));
+  rtc::SetBE16(header + sizeof(uint16_t), static_cast<uint16_t>(value_size));
+  uint8_t* value = header + kStunAttributeHeaderSize;
+  memset(value + value_size, 0, padded_size - value_size);
+  size_ += kStunAttributeHeaderSize + padded_size;
+  rtc::SetBE16(buffer_.data() + sizeof(uint16_t),
+               static_cast<uint16_t>(size_ - kStunHeaderSize));
+  return value;
+}
+
+bool StunMessageWriter::AddUInt32(int type, uint32_t value) {
+  uint8_t* data = AddAttribute(type, sizeof(value));
+  if (!data) {
+    return false;
+  }
+  rtc::SetBE32(data, value);
+  return true;
+}
+
+bool StunMessageWriter::AddUInt64(int type, uint64_t value) {
+  uint8_t* data = AddAttribute(type, sizeof(value));
+  if (!data) {
+    return false;
+  }
+  rtc::SetBE64(data, value);
+  return true;
+}
+
+bool StunMessageWriter::AddFlag(int type) {
+  return AddAttribute(type, 0) != nullptr;
+}
+
+bool StunMessageWriter::AddByteString(int type,
+                                      rtc::ArrayView<const uint8_t> value) {
+  uint8_t* data = AddAttribute(type, value.size());
+  if (!data) {
+    return false;
+  }
+  if (!value.empty()) {
+    memcpy(data, value.data(), value.size());
+  }
+  return true;
+}
+
+bool StunMessageWriter::AddXorAddress(int type,
+                                      const rtc::SocketAddress& address) {
+  const rtc::IPAddress& ip = address.ipaddr();
+  uint8_t ip_bytes[sizeof(in6_addr)];
+  size_t ip_size;
+  uint8_t family;
+  if (ip.family() == AF_INET) {
+    in_addr v4addr = ip.ipv4_address();
+    memcpy(ip_bytes, &v4addr, sizeof(v4addr));
+    ip_size = sizeof(v4addr);
+    family = STUN_ADDRESS_IPV4;
+  } else if (ip.family() == AF_INET6) {
+    in6_addr v6addr = ip.ipv6_address();
+    memcpy(ip_bytes, &v6addr, sizeof(v6addr));
+    ip_size = sizeof(v6addr);
+    family = STUN_ADDRESS_IPV6;
+  } else {
+    ok_ = false;
+    return false;
+  }
+  uint8_t* data = AddAttribute(type, 4 + ip_size);
+  if (!data) {
+    return false;
+  }
+  const uint8_t* mask = buffer_.data() + kXorMaskOffset;
+  data[0] = 0;
+  data[1] = family;
+  rtc::SetBE16(data + 2, address.port() ^ (kStunMagicCookie >> 16));
+  for (size_t i = 0; i < ip_size; ++i) {
+    data[4 + i] = ip_bytes[i] ^ mask[i];
+  }
+  return true;
+}
+
+bool StunMessageWriter::AddMessageIntegrity(const rtc::HmacSha1& key) {
+  const size_t offset = size_;
+  uint8_t* data =
+      AddAttribute(STUN_ATTR_MESSAGE_INTEGRITY, kStunMessageIntegritySize);
+  if (!data) {
+    return false;
+  }
+  key.Compute(buffer_.data(), offset, data);
+  return true;
+}
+
+bool StunMessageWriter::AddFingerprint() {
+  const size_t offset = size_;
+  uint8_t* data = AddAttribute(STUN_ATTR_FINGERPRINT, sizeof(uint32_t));
+  if (!data) {
+    return false;
+  }
+  rtc::SetBE32(data, rtc::ComputeCrc32(buffer_.data(), offset) ^
+                         STUN_FINGERPRINT_XOR_VALUE);
+  return true;
+}
+
+rtc::ArrayView<const uint8_t> StunMessageWriter::message() const {
+  if (!ok_) {
+    return rtc::ArrayView<const uint8_t>();
+  }
+  return rtc::ArrayView<const uint8_t>(buffer_.data(), size_);
+}
+
+}  // namespace cricket
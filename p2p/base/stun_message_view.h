@@ -0,0 +1,108 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_STUN_MESSAGE_VIEW_H_
+#define P2P_BASE_STUN_MESSAGE_VIEW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "api/array_view.h"
+#include "p2p/base/stun.h"
+#include "rtc_base/hmac_sha1.h"
+#include "rtc_base/socket_address.h"
+
+namespace cricket {
+
+// Read-only view of a serialized RFC 5389 STUN message. Unlike StunMessage,
+// parsing neither copies the message nor decodes its attributes: it only
+// checks that the header and the attribute headers are consistent, and the
+// attributes are looked up by type on demand. This is enough for the binding
+// requests and responses of ICE connectivity checks and consent freshness,
+// which have a handful of attributes, and it never allocates memory. Legacy
+// RFC 3489 messages, which have no magic cookie, are rejected.
+class StunMessageView {
+ public:
+  StunMessageView();
+
+  // Parses the |size| bytes at |data|, which must outlive the view. Returns
+  // false if they are not a well-formed STUN message.
+  bool Parse(const char* data, size_t size);
+
+  int type() const;
+  // Length of the message body, excluding the header.
+  size_t length() const { return size_ == 0 ? 0 : size_ - kStunHeaderSize; }
+  const char* data() const { return reinterpret_cast<const char*>(data_); }
+  size_t size() const { return size_; }
+  rtc::ArrayView<const uint8_t> transaction_id() const;
+
+  bool HasAttribute(int type) const;
+  // Sets |value| to the value of the first attribute of |type|, without its
+  // padding. Returns false if there is no such attribute.
+  bool GetAttribute(int type, rtc::ArrayView<const uint8_t>* value) const;
+  // Same as GetAttribute(), but also fails if the attribute doesn't have the
+  // size of the decoded value.
+  bool GetUInt32(int type, uint32_t* value) const;
+  bool GetUInt64(int type, uint64_t* value) const;
+  bool GetXorAddress(int type, rtc::SocketAddress* address) const;
+
+  // Verifies the MESSAGE-INTEGRITY attribute with |key|, which holds the
+  // password, as StunMessage::ValidateMessageIntegrity() does.
+  bool ValidateMessageIntegrity(const rtc::HmacSha1& key) const;
+  // Verifies that the message ends with a valid FINGERPRINT attribute.
+  bool ValidateFingerprint() const;
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+};
+
+// Serializes a STUN message into a caller provided buffer, without
+// allocating. The attributes are written in the order they are added, so
+// AddMessageIntegrity() and AddFingerprint() must be called last, in this
+// order. The output is byte for byte the same as StunMessage::Write() for the
+// same attributes.
+class StunMessageWriter {
+ public:
+  // Writes the header of a message of |type| with the 12 byte
+  // |transaction_id| to |buffer|, which must outlive the writer.
+  StunMessageWriter(int type,
+                    rtc::ArrayView<const uint8_t> transaction_id,
+                    rtc::ArrayView<uint8_t> buffer);
+
+  // The Add methods return false, and leave the writer in an error state, if
+  // the attribute doesn't fit in the buffer.
+  bool AddUInt32(int type, uint32_t value);
+  bool AddUInt64(int type, uint64_t value);
+  // Adds an attribute without value, such as USE-CANDIDATE.
+  bool AddFlag(int type);
+  bool AddByteString(int type, rtc::ArrayView<const uint8_t> value);
+  bool AddXorAddress(int type, const rtc::SocketAddress& address);
+  bool AddMessageIntegrity(const rtc::HmacSha1& key);
+  bool AddFingerprint();
+
+  // Returns false if an attribute didn't fit or couldn't be encoded.
+  bool ok() const { return ok_; }
+  // The serialized message, or an empty view if !ok().
+  rtc::ArrayView<const uint8_t> message() const;
+
+ private:
+  // Appends an attribute header, updates the message length and returns a
+  // pointer to the zero padded value, or null if it doesn't fit.
+  uint8_t* AddAttribute(int type, size_t value_size);
+
+  const rtc::ArrayView<uint8_t> buffer_;
+  size_t size_;
+  bool ok_;
+};
+
+}  // namespace cricket
+
+#endif  // P2P_BASE_STUN_MESSAGE_VIEW_H_
@@ -0,0 +1,246 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/stun_message_view.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/stun.h"
+#include "rtc_base/byte_buffer.h"
+#include "test/gtest.h"
+
+namespace cricket {
+namespace {
+
+// RFC 5769 sample request, where the USERNAME is padded with spaces rather
+// than zeros.
+const unsigned char kSampleRequest[] = {
+    0x00, 0x01, 0x00, 0x58, 0x21, 0x12, 0xa4, 0x42, 0xb7, 0xe7, 0xa7, 0x01,
+    0xbc, 0x34, 0xd6, 0x86, 0xfa, 0x87, 0xdf, 0xae, 0x80, 0x22, 0x00, 0x10,
+    0x53, 0x54, 0x55, 0x4e, 0x20, 0x74, 0x65, 0x73, 0x74, 0x20, 0x63, 0x6c,
+    0x69, 0x65, 0x6e, 0x74, 0x00, 0x24, 0x00, 0x04, 0x6e, 0x00, 0x01, 0xff,
+    0x80, 0x29, 0x00, 0x08, 0x93, 0x2f, 0xf9, 0xb1, 0x51, 0x26, 0x3b, 0x36,
+    0x00, 0x06, 0x00, 0x09, 0x65, 0x76, 0x74, 0x6a, 0x3a, 0x68, 0x36, 0x76,
+    0x59, 0x20, 0x20, 0x20, 0x00, 0x08, 0x00, 0x14, 0x9a, 0xea, 0xa7, 0x0c,
+    0xbf, 0xd8, 0xcb, 0x56, 0x78, 0x1e, 0xf2, 0xb5, 0xb2, 0xd3, 0xf2, 0x49,
+    0xc1, 0xb5, 0x71, 0xa2, 0x80, 0x28, 0x00, 0x04, 0xe5, 0x7a, 0x3b, 0xcf};
+
+// RFC 5769 sample IPv6 response.
+const unsigned char kSampleResponseIPv6[] = {
+    0x01, 0x01, 0x00, 0x48, 0x21, 0x12, 0xa4, 0x42, 0xb7, 0xe7, 0xa7, 0x01,
+    0xbc, 0x34, 0xd6, 0x86, 0xfa, 0x87, 0xdf, 0xae, 0x80, 0x22, 0x00, 0x0b,
+    0x74, 0x65, 0x73, 0x74, 0x20, 0x76, 0x65, 0x63, 0x74, 0x6f, 0x72, 0x20,
+    0x00, 0x20, 0x00, 0x14, 0x00, 0x02, 0xa1, 0x47, 0x01, 0x13, 0xa9, 0xfa,
+    0xa5, 0xd3, 0xf1, 0x79, 0xbc, 0x25, 0xf4, 0xb5, 0xbe, 0xd2, 0xb9, 0xd9,
+    0x00, 0x08, 0x00, 0x14, 0xa3, 0x82, 0x95, 0x4e, 0x4b, 0xe6, 0x7b, 0xf1,
+    0x17, 0x84, 0xc9, 0x7c, 0x82, 0x92, 0xc2, 0x75, 0xbf, 0xe3, 0xed, 0x41,
+    0x80, 0x28, 0x00, 0x04, 0xc8, 0xfb, 0x0b, 0x4c};
+
+const char kSamplePassword[] = "VOkJxbRl1RmTxUk/WvJxBt";
+const char kTransactionId[] = "0123456789ab";
+
+const char* AsChars(const unsigned char* data) {
+  return reinterpret_cast<const char*>(data);
+}
+
+rtc::ArrayView<const uint8_t> AsBytes(const std::string& str) {
+  return rtc::ArrayView<const uint8_t>(
+      reinterpret_cast<const uint8_t*>(str.data()), str.size());
+}
+
+std::vector<uint8_t> Serialize(const StunMessage& message) {
+  rtc::ByteBufferWriter buffer;
+  EXPECT_TRUE(message.Write(&buffer));
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.Data());
+  return std::vector<uint8_t>(data, data + buffer.Length());
+}
+
+}  // namespace
+
+TEST(StunMessageViewTest, ParsesRfc5769SampleRequest) {
+  StunMessageView view;
+  ASSERT_TRUE(view.Parse(AsChars(kSampleRequest), sizeof(kSampleRequest)));
+  EXPECT_EQ(STUN_BINDING_REQUEST, view.type());
+  EXPECT_EQ(sizeof(kSampleRequest) - kStunHeaderSize, view.length());
+  EXPECT_EQ(0, memcmp(kSampleRequest + kStunTransactionIdOffset,
+                      view.transaction_id().data(), kStunTransactionIdLength));
+
+  rtc::ArrayView<const uint8_t> username;
+  ASSERT_TRUE(view.GetAttribute(STUN_ATTR_USERNAME, &username));
+  EXPECT_EQ("evtj:h6vY",
+            std::string(reinterpret_cast<const char*>(username.data()),
+                        username.size()));
+  uint32_t priority;
+  ASSERT_TRUE(view.GetUInt32(STUN_ATTR_PRIORITY, &priority));
+  EXPECT_EQ(0x6e0001ffu, priority);
+  uint64_t tiebreaker;
+  ASSERT_TRUE(view.GetUInt64(STUN_ATTR_ICE_CONTROLLED, &tiebreaker));
+  EXPECT_EQ(0x932ff9b151263b36u, tiebreaker);
+  EXPECT_FALSE(view.HasAttribute(STUN_ATTR_USE_CANDIDATE));
+  // PRIORITY is not 64 bits long.
+  EXPECT_FALSE(view.GetUInt64(STUN_ATTR_PRIORITY, &tiebreaker));
+
+  EXPECT_TRUE(view.ValidateFingerprint());
+  EXPECT_TRUE(view.ValidateMessageIntegrity(rtc::HmacSha1(kSamplePassword)));
+  EXPECT_FALSE(view.ValidateMessageIntegrity(rtc::HmacSha1("wrong")));
+  EXPECT_TRUE(StunMessage::ValidateMessageIntegrity(
+      AsChars(kSampleRequest), sizeof(kSampleRequest),
+      rtc::HmacSha1(kSamplePassword)));
+}
+
+TEST(StunMessageViewTest, ParsesRfc5769SampleIPv6Response) {
+  StunMessageView view;
+  ASSERT_TRUE(view.Parse(AsChars(kSampleResponseIPv6),
+                         sizeof(kSampleResponseIPv6)));
+  EXPECT_EQ(STUN_BINDING_RESPONSE, view.type());
+  rtc::SocketAddress address;
+  ASSERT_TRUE(view.GetXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, &address));
+  EXPECT_EQ(
+      rtc::SocketAddress("2001:db8:1234:5678:11:2233:4455:6677", 32853),
+      address);
+  EXPECT_TRUE(view.ValidateMessageIntegrity(rtc::HmacSha1(kSamplePassword)));
+}
+
+TEST(StunMessageViewTest, RejectsMalformedMessages) {
+  std::vector<char> message(kSampleRequest,
+                            kSampleRequest + sizeof(kSampleRequest));
+  StunMessageView view;
+
+  // Truncated message.
+  EXPECT_FALSE(view.Parse(message.data(), message.size() - 4));
+  EXPECT_FALSE(view.Parse(message.data(), kStunHeaderSize - 4));
+  // Size not a multiple of 4.
+  EXPECT_FALSE(view.Parse(message.data(), message.size() - 1));
+
+  // Missing magic cookie.
+  std::vector<char> legacy = message;
+  legacy[4] = 0;
+  EXPECT_FALSE(view.Parse(legacy.data(), legacy.size()));
+
+  // RTP packet.
+  std::vector<char> rtp = message;
+  rtp[0] = static_cast<char>(0x80);
+  EXPECT_FALSE(view.Parse(rtp.data(), rtp.size()));
+
+  // Last attribute ends past the end of the message.
+  std::vector<char> overflow = message;
+  overflow[overflow.size() - 5] = 8;
+  EXPECT_FALSE(view.Parse(overflow.data(), overflow.size()));
+
+  // A failed parse leaves an empty view.
+  EXPECT_EQ(0, view.type());
+  EXPECT_FALSE(view.HasAttribute(STUN_ATTR_USERNAME));
+  EXPECT_FALSE(view.ValidateMessageIntegrity(rtc::HmacSha1(kSamplePassword)));
+}
+
+// Verifies that the writer produces the same bytes as StunMessage for a
+// connectivity check request.
+TEST(StunMessageViewTest, WriterMatchesStunMessageForRequest) {
+  const rtc::HmacSha1 key("remote_password_1234567");
+  IceMessage message;
+  message.SetType(STUN_BINDING_REQUEST);
+  message.SetTransactionID(kTransactionId);
+  message.AddAttribute(absl::make_unique<StunByteStringAttribute>(
+      STUN_ATTR_USERNAME, "remote:local"));
+  message.AddAttribute(
+      absl::make_unique<StunUInt32Attribute>(STUN_ATTR_RETRANSMIT_COUNT, 2));
+  message.AddAttribute(absl::make_unique<StunUInt64Attribute>(
+      STUN_ATTR_ICE_CONTROLLING, 0x0123456789abcdef));
+  message.AddAttribute(
+      absl::make_unique<StunByteStringAttribute>(STUN_ATTR_USE_CANDIDATE));
+  message.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+      STUN_ATTR_PRIORITY, 0x6e7f1eff));
+  ASSERT_TRUE(message.AddMessageIntegrity(key.key()));
+  ASSERT_TRUE(message.AddFingerprint());
+
+  uint8_t buffer[256];
+  StunMessageWriter writer(STUN_BINDING_REQUEST, AsBytes(kTransactionId),
+                           buffer);
+  writer.AddByteString(STUN_ATTR_USERNAME, AsBytes("remote:local"));
+  writer.AddUInt32(STUN_ATTR_RETRANSMIT_COUNT, 2);
+  writer.AddUInt64(STUN_ATTR_ICE_CONTROLLING, 0x0123456789abcdef);
+  writer.AddFlag(STUN_ATTR_USE_CANDIDATE);
+  writer.AddUInt32(STUN_ATTR_PRIORITY, 0x6e7f1eff);
+  writer.AddMessageIntegrity(key);
+  writer.AddFingerprint();
+  ASSERT_TRUE(writer.ok());
+
+  const std::vector<uint8_t> expected = Serialize(message);
+  EXPECT_EQ(expected, std::vector<uint8_t>(writer.message().begin(),
+                                           writer.message().end()));
+
+  StunMessageView view;
+  ASSERT_TRUE(view.Parse(reinterpret_cast<const char*>(writer.message().data()),
+                         writer.message().size()));
+  EXPECT_TRUE(view.ValidateFingerprint());
+  EXPECT_TRUE(view.ValidateMessageIntegrity(key));
+  EXPECT_TRUE(view.HasAttribute(STUN_ATTR_USE_CANDIDATE));
+}
+
+// Verifies that the writer produces the same bytes as StunMessage for
+// binding responses to IPv4 and IPv6 addresses, and that the key based
+// StunMessage methods match the password based ones.
+TEST(StunMessageViewTest, WriterMatchesStunMessageForResponses) {
+  const rtc::HmacSha1 key("local_password");
+  for (const rtc::SocketAddress& address :
+       {rtc::SocketAddress("192.0.2.1", 32853),
+        rtc::SocketAddress("2001:db8:1234:5678:11:2233:4455:6677", 32853)}) {
+    StunMessage message;
+    message.SetType(STUN_BINDING_RESPONSE);
+    message.SetTransactionID(kTransactionId);
+    message.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_MAPPED_ADDRESS, address));
+    StunMessage keyed_message;
+    keyed_message.SetType(STUN_BINDING_RESPONSE);
+    keyed_message.SetTransactionID(kTransactionId);
+    keyed_message.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_MAPPED_ADDRESS, address));
+    ASSERT_TRUE(message.AddMessageIntegrity(key.key()));
+    ASSERT_TRUE(keyed_message.AddMessageIntegrity(key));
+    ASSERT_TRUE(message.AddFingerprint());
+    ASSERT_TRUE(keyed_message.AddFingerprint());
+
+    uint8_t buffer[128];
+    StunMessageWriter writer(STUN_BINDING_RESPONSE, AsBytes(kTransactionId),
+                             buffer);
+    writer.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, address);
+    writer.AddMessageIntegrity(key);
+    writer.AddFingerprint();
+    ASSERT_TRUE(writer.ok());
+
+    const std::vector<uint8_t> expected = Serialize(message);
+    EXPECT_EQ(expected, Serialize(keyed_message));
+    EXPECT_EQ(expected, std::vector<uint8_t>(writer.message().begin(),
+                                             writer.message().end()));
+
+    StunMessageView view;
+    ASSERT_TRUE(view.Parse(reinterpret_cast<const char*>(expected.data()),
+                           expected.size()));
+    rtc::SocketAddress parsed;
+    ASSERT_TRUE(view.GetXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, &parsed));
+    EXPECT_EQ(address, parsed);
+  }
+}
+
+TEST(StunMessageViewTest, WriterFailsWhenBufferIsTooSmall) {
+  uint8_t buffer[kStunHeaderSize + 8];
+  StunMessageWriter writer(STUN_BINDING_RESPONSE, AsBytes(kTransactionId),
+                           buffer);
+  EXPECT_TRUE(writer.AddUInt32(STUN_ATTR_PRIORITY, 1));
+  EXPECT_FALSE(writer.AddFingerprint());
+  EXPECT_FALSE(writer.ok());
+  EXPECT_TRUE(writer.message().empty());
+}
+
+}  // namespace cricket
@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/stun_message_view.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+constexpr int kNumIterations = 200000;
+const char kPassword[] = "abcdefghijklmnopqrstuv";
+const char kTransactionId[] = "0123456789ab";
+const rtc::SocketAddress kAddress("192.168.1.17", 40123);
+
+// Returns the average time in nanoseconds spent per call of |function|.
+template <typename Function>
+double MeasureNs(Function function) {
+  const int64_t start_ns = rtc::TimeNanos();
+  for (int i = 0; i < kNumIterations; ++i) {
+    function();
+  }
+  return static_cast<double>(rtc::TimeNanos() - start_ns) / kNumIterations;
+}
+
+// Serializes a connectivity check as sent by ConnectionRequest::Prepare().
+std::string CreateBindingRequest() {
+  IceMessage request;
+  request.SetType(STUN_BINDING_REQUEST);
+  request.SetTransactionID(kTransactionId);
+  request.AddAttribute(absl::make_unique<StunByteStringAttribute>(
+      STUN_ATTR_USERNAME, "ufraglocal:ufragremote"));
+  request.AddAttribute(absl::make_unique<StunUInt64Attribute>(
+      STUN_ATTR_ICE_CONTROLLING, 0x0123456789abcdef));
+  request.AddAttribute(
+      absl::make_unique<StunByteStringAttribute>(STUN_ATTR_USE_CANDIDATE));
+  request.AddAttribute(
+      absl::make_unique<StunUInt32Attribute>(STUN_ATTR_PRIORITY, 0x6e7f1eff));
+  request.AddMessageIntegrity(kPassword);
+  request.AddFingerprint();
+  rtc::ByteBufferWriter buffer;
+  request.Write(&buffer);
+  return std::string(buffer.Data(), buffer.Length());
+}
+
+}  // namespace
+
+// Compares the cost of authenticating an incoming connectivity check, as in
+// Port::GetStunMessage(), with StunMessage and with StunMessageView.
+TEST(StunPerfTest, ParseAndAuthenticateBindingRequest) {
+  const std::string packet = CreateBindingRequest();
+  int num_valid = 0;
+
+  webrtc::test::PrintResult(
+      "stun_binding_request_check", "_stun_message", "parse_and_validate",
+      MeasureNs([&] {
+        std::unique_ptr<IceMessage> message(new IceMessage());
+        rtc::ByteBufferReader buffer(packet.data(), packet.size());
+        if (StunMessage::ValidateFingerprint(packet.data(), packet.size()) &&
+            message->Read(&buffer) &&
+            message->GetByteString(STUN_ATTR_USERNAME) &&
+            StunMessage::ValidateMessageIntegrity(packet.data(), packet.size(),
+                                                  kPassword)) {
+          ++num_valid;
+        }
+      }),
+      "ns", false);
+
+  const rtc::HmacSha1 key(kPassword);
+  webrtc::test::PrintResult(
+      "stun_binding_request_check", "_stun_message_view", "parse_and_validate",
+      MeasureNs([&] {
+        StunMessageView view;
+        if (view.Parse(packet.data(), packet.size()) &&
+            view.ValidateFingerprint() &&
+            view.HasAttribute(STUN_ATTR_USERNAME) &&
+            view.ValidateMessageIntegrity(key)) {
+          ++num_valid;
+        }
+      }),
+      "ns", false);
+
+  EXPECT_EQ(2 * kNumIterations, num_valid);
+}
+
+// Compares the cost of serializing a binding response, as in
+// Port::SendBindingResponse(), with StunMessage and with StunMessageWriter.
+TEST(StunPerfTest, SerializeBindingResponse) {
+  size_t total_size = 0;
+
+  webrtc::test::PrintResult(
+      "stun_binding_response_write", "_stun_message", "serialize",
+      MeasureNs([&] {
+        StunMessage response;
+        response.SetType(STUN_BINDING_RESPONSE);
+        response.SetTransactionID(kTransactionId);
+        response.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+            STUN_ATTR_XOR_MAPPED_ADDRESS, kAddress));
+        response.AddMessageIntegrity(kPassword);
+        response.AddFingerprint();
+        rtc::ByteBufferWriter buffer;
+        response.Write(&buffer);
+        total_size += buffer.Length();
+      }),
+      "ns", false);
+
+  const rtc::HmacSha1 key(kPassword);
+  const rtc::ArrayView<const uint8_t> transaction_id(
+      reinterpret_cast<const uint8_t*>(kTransactionId),
+      kStunTransactionIdLength);
+  webrtc::test::PrintResult(
+      "stun_binding_response_write", "_stun_message_writer", "serialize",
+      MeasureNs([&] {
+        uint8_t buffer[128];
+        StunMessageWriter writer(STUN_BINDING_RESPONSE, transaction_id,
+                                 buffer);
+        writer.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, kAddress);
+        writer.AddMessageIntegrity(key);
+        writer.AddFingerprint();
+        total_size += writer.message().size();
+      }),
+      "ns", false);
+
+  // Both paths produce 64 byte responses.
+  EXPECT_EQ(2u * 64 * kNumIterations, total_size);
+}
+
+}  // namespace cricket
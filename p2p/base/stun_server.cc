@@ -10,13 +10,24 @@
 
 #include "p2p/base/stun_server.h"
 
+#include <string.h>
 #include <utility>
 
+#include "p2p/base/stun_message_view.h"
 #include "rtc_base/byte_buffer.h"
 #include "rtc_base/logging.h"
 
 namespace cricket {
 
+namespace {
+
+// Header, an IPv6 XOR-MAPPED-ADDRESS and FINGERPRINT.
+const size_t kMaxStatelessResponseSize = kStunHeaderSize +
+                                         kStunAttributeHeaderSize + 20 +
+                                         kStunAttributeHeaderSize + 4;
+
+}  // namespace
+
 StunServer::StunServer(rtc::AsyncUDPSocket* socket) : socket_(socket) {
   socket_->SignalReadPacket.connect(this, &StunServer::OnPacket);
 }
@@ -30,6 +41,19 @@ void StunServer::OnPacket(rtc::AsyncPacketSocket* socket,
                           size_t size,
                           const rtc::SocketAddress& remote_addr,
                           const int64_t& /* packet_time_us */) {
+  if (stateless_binding_responses_) {
+    uint8_t response[kMaxStatelessResponseSize];
+    size_t response_size = WriteStatelessBindingResponse(
+        rtc::MakeArrayView(reinterpret_cast<const uint8_t*>(buf), size),
+        remote_addr, response);
+    if (response_size > 0) {
+      rtc::PacketOptions options;
+      if (socket_->SendTo(response, response_size, remote_addr, options) < 0)
+        RTC_LOG_ERR(LS_ERROR) << "sendto";
+      return;
+    }
+  }
+
   // Parse the STUN message; eat any messages that fail to parse.
   rtc::ByteBufferReader bbuf(buf, size);
   StunMessage msg;
@@ -83,6 +107,26 @@ void StunServer::SendResponse(const StunMessage& msg,
     RTC_LOG_ERR(LS_ERROR) << "sendto";
 }
 
+size_t StunServer::WriteStatelessBindingResponse(
+    rtc::ArrayView<const uint8_t> request,
+    const rtc::SocketAddress& remote_addr,
+    rtc::ArrayView<uint8_t> response) {
+  StunMessageView view;
+  if (!view.Parse(reinterpret_cast<const char*>(request.data()),
+                  request.size()) ||
+      view.type() != STUN_BINDING_REQUEST) {
+    return 0;
+  }
+  // The header of the response overwrites the request when they share a
+  // buffer.
+  uint8_t transaction_id[kStunTransactionIdLength];
+  memcpy(transaction_id, view.transaction_id().data(), sizeof(transaction_id));
+  StunMessageWriter writer(STUN_BINDING_RESPONSE, transaction_id, response);
+  writer.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, remote_addr);
+  writer.AddFingerprint();
+  return writer.message().size();
+}
+
 void StunServer::GetStunBindReqponse(StunMessage* request,
                                      const rtc::SocketAddress& remote_addr,
                                      StunMessage* response) const {
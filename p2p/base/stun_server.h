@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <memory>
 
+#include "api/array_view.h"
 #include "p2p/base/stun.h"
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/async_udp_socket.h"
@@ -32,6 +33,23 @@ class StunServer : public sigslot::has_slots<> {
   // Removes the STUN server from the socket and deletes the socket.
   ~StunServer() override;
 
+  // When enabled, RFC 5389 binding requests are answered straight from the
+  // received bytes, with XOR-MAPPED-ADDRESS and FINGERPRINT, without parsing
+  // them into a StunMessage. Other messages still take the regular path.
+  void set_stateless_binding_responses(bool enable) {
+    stateless_binding_responses_ = enable;
+  }
+
+  // Writes the response to the binding request in |request|, received from
+  // |remote_addr|, to |response|, and returns its size. |response| may be the
+  // buffer of |request|, to rewrite the request in place. Returns 0, and
+  // leaves |response| unspecified, if |request| isn't a well-formed RFC 5389
+  // binding request or the response doesn't fit.
+  static size_t WriteStatelessBindingResponse(
+      rtc::ArrayView<const uint8_t> request,
+      const rtc::SocketAddress& remote_addr,
+      rtc::ArrayView<uint8_t> response);
+
  protected:
   // Slot for AsyncSocket.PacketRead:
   void OnPacket(rtc::AsyncPacketSocket* socket,
@@ -63,6 +81,7 @@ class StunServer : public sigslot::has_slots<> {
 
  private:
   std::unique_ptr<rtc::AsyncUDPSocket> socket_;
+  bool stateless_binding_responses_ = false;
 };
 
 }  // namespace cricket
@@ -48,6 +48,12 @@ class StunServerTest : public ::testing::Test {
   void Send(const char* buf, int len) {
     client_->SendTo(buf, len, server_addr);
   }
+  void EnableStatelessBindingResponses() {
+    server_->set_stateless_binding_responses(true);
+  }
+  std::unique_ptr<rtc::TestClient::Packet> ReceivePacket() {
+    return client_->NextPacket(rtc::TestClient::kTimeoutMs);
+  }
   bool ReceiveFails() { return (client_->CheckNoPacket()); }
   StunMessage* Receive() {
     StunMessage* msg = NULL;
@@ -98,6 +104,44 @@ TEST_F(StunServerTest, TestGood) {
   delete msg;
 }
 
+TEST_F(StunServerTest, TestStatelessGood) {
+  EnableStatelessBindingResponses();
+  StunMessage req;
+  req.SetType(STUN_BINDING_REQUEST);
+  req.SetTransactionID("0123456789ab");
+  req.AddFingerprint();
+  Send(req);
+
+  std::unique_ptr<rtc::TestClient::Packet> packet = ReceivePacket();
+  ASSERT_TRUE(packet);
+  EXPECT_TRUE(StunMessage::ValidateFingerprint(packet->buf, packet->size));
+  StunMessage msg;
+  rtc::ByteBufferReader reader(packet->buf, packet->size);
+  ASSERT_TRUE(msg.Read(&reader));
+  EXPECT_EQ(STUN_BINDING_RESPONSE, msg.type());
+  EXPECT_EQ(req.transaction_id(), msg.transaction_id());
+  const StunAddressAttribute* mapped_addr =
+      msg.GetAddress(STUN_ATTR_XOR_MAPPED_ADDRESS);
+  ASSERT_TRUE(mapped_addr != NULL);
+  EXPECT_EQ(client_addr, mapped_addr->GetAddress());
+}
+
+// Legacy requests have no magic cookie, and are still answered by parsing
+// them.
+TEST_F(StunServerTest, TestStatelessLegacy) {
+  EnableStatelessBindingResponses();
+  StunMessage req;
+  std::string transaction_id = "0123456789abcdef";
+  req.SetType(STUN_BINDING_REQUEST);
+  req.SetTransactionID(transaction_id);
+  Send(req);
+
+  std::unique_ptr<StunMessage> msg(Receive());
+  ASSERT_TRUE(msg);
+  EXPECT_EQ(STUN_BINDING_RESPONSE, msg->type());
+  EXPECT_EQ(req.transaction_id(), msg->transaction_id());
+}
+
 #endif  // if !defined(THREAD_SANITIZER)
 
 TEST_F(StunServerTest, TestBad) {
@@ -48,6 +48,17 @@ class TestTurnRedirector : public TurnRedirectInterface {
   std::vector<rtc::SocketAddress>::const_iterator iter_;
 };
 
+// Accepts any user whose password is the same as the username, like
+// TestTurnServer. Unlike it, may be used from any thread.
+class TestTurnAuth : public TurnAuthInterface {
+ public:
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    return ComputeStunCredentialHash(username, realm, username, key);
+  }
+};
+
 class TestTurnServer : public TurnAuthInterface {
  public:
   TestTurnServer(rtc::Thread* thread,
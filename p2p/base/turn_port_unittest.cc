@@ -1373,6 +1373,13 @@ TEST_F(TurnPortTest, TestTurnSendDataTurnUdpToUdp) {
   EXPECT_EQ(UDP_PROTOCOL_NAME, turn_port_->Candidates()[0].relay_protocol());
 }
 
+// Same as above, with the server relaying ChannelData in batches.
+TEST_F(TurnPortTest, TestTurnSendDataTurnUdpToUdpWithBatchedRelay) {
+  turn_server_.server()->set_enable_batched_relay(true);
+  CreateTurnPort(kTurnUsername, kTurnPassword, kTurnUdpProtoAddr);
+  TestTurnSendData(PROTO_UDP);
+}
+
 // Do a TURN allocation, establish a TCP connection, and send some data.
 TEST_F(TurnPortTest, TestTurnSendDataTurnTcpToUdp) {
   turn_server_.AddInternalSocket(kTurnTcpIntAddr, PROTO_TCP);
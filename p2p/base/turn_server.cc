@@ -10,16 +10,18 @@
 
 #include "p2p/base/turn_server.h"
 
+#include <string.h>
+
 #include <tuple>  // for std::tie
 #include <utility>
 
-#include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
 #include "p2p/base/async_stun_tcp_socket.h"
 #include "p2p/base/packet_socket_factory.h"
 #include "p2p/base/stun.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/byte_buffer.h"
+#include "rtc_base/byte_order.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/helpers.h"
 #include "rtc_base/logging.h"
@@ -45,6 +47,10 @@ static const size_t kNonceSize = 48;
 
 static const size_t TURN_CHANNEL_HEADER_SIZE = 4U;
 
+// ChannelData messages queued for a batched send, when enabled, before the
+// queue is flushed regardless of pending socket events.
+static const size_t kMaxQueuedRelayPackets = 64;
+
 // TODO(mallinath) - Move these to a common place.
 inline bool IsTurnChannelData(uint16_t msg_type) {
   // The first two bits of a channel data message are 0b01.
@@ -74,6 +80,7 @@ class TurnServerAllocation::Permission : public rtc::MessageHandler {
 
   rtc::Thread* thread_;
   rtc::IPAddress peer_;
+  int64_t expires_ms_;
 };
 
 // Encapsulates a TURN channel binding.
@@ -97,6 +104,7 @@ class TurnServerAllocation::Channel : public rtc::MessageHandler {
   rtc::Thread* thread_;
   int id_;
   rtc::SocketAddress peer_;
+  int64_t expires_ms_;
 };
 
 static bool InitResponse(const StunMessage* req, StunMessage* resp) {
@@ -131,6 +139,7 @@ TurnServer::TurnServer(rtc::Thread* thread)
 
 TurnServer::~TurnServer() {
   RTC_DCHECK(thread_checker_.IsCurrent());
+  FlushRelayQueue();
   for (InternalSocketMap::iterator it = server_sockets_.begin();
        it != server_sockets_.end(); ++it) {
     rtc::AsyncPacketSocket* socket = it->first;
@@ -148,7 +157,7 @@ void TurnServer::AddInternalSocket(rtc::AsyncPacketSocket* socket,
                                    ProtocolType proto) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   RTC_DCHECK(server_sockets_.end() == server_sockets_.find(socket));
-  server_sockets_[socket] = proto;
+  server_sockets_[socket] = {proto, socket->GetRemoteAddress()};
   socket->SignalReadPacket.connect(this, &TurnServer::OnInternalPacket);
 }
 
@@ -210,7 +219,8 @@ void TurnServer::OnInternalPacket(rtc::AsyncPacketSocket* socket,
   }
   InternalSocketMap::iterator iter = server_sockets_.find(socket);
   RTC_DCHECK(iter != server_sockets_.end());
-  TurnServerConnection conn(addr, iter->second, socket);
+  TurnServerConnection conn(addr, iter->second.remote_address,
+                            iter->second.proto, socket);
   uint16_t msg_type = rtc::GetBE16(data);
   if (!IsTurnChannelData(msg_type)) {
     // This is a STUN message.
@@ -531,9 +541,83 @@ void TurnServer::SendStun(TurnServerConnection* conn, StunMessage* msg) {
 
 void TurnServer::Send(TurnServerConnection* conn,
                       const rtc::ByteBufferWriter& buf) {
+  Send(conn, buf.Data(), buf.Length());
+}
+
+void TurnServer::Send(TurnServerConnection* conn,
+                      const char* data,
+                      size_t size) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  // Keep the order of the queued ChannelData messages and this one.
+  if (!relay_queue_.empty()) {
+    FlushRelayQueue();
+  }
+  rtc::PacketOptions options;
+  conn->socket()->SendTo(data, size, conn->src(), options);
+}
+
+void TurnServer::SendChannelData(TurnServerConnection* conn,
+                                 uint16_t channel_id,
+                                 const char* data,
+                                 size_t size) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  const size_t message_size = TURN_CHANNEL_HEADER_SIZE + size;
+  // TCP sockets are not shared between allocations, so they gain nothing from
+  // batching.
+  if (!enable_batched_relay_ || conn->proto() != PROTO_UDP) {
+    channel_data_buffer_.resize(message_size);
+    char* message = channel_data_buffer_.data();
+    rtc::SetBE16(message, channel_id);
+    rtc::SetBE16(message + 2, static_cast<uint16_t>(size));
+    memcpy(message + TURN_CHANNEL_HEADER_SIZE, data, size);
+    Send(conn, message, message_size);
+    return;
+  }
+
+  if (relay_queue_.empty()) {
+    // Runs after the other socket events of this round have been handled.
+    invoker_.AsyncInvoke<void>(RTC_FROM_HERE, thread_,
+                               rtc::Bind(&TurnServer::FlushRelayQueue, this));
+  }
+  const size_t offset = relay_buffer_.size();
+  relay_buffer_.resize(offset + message_size);
+  char* message = &relay_buffer_[offset];
+  rtc::SetBE16(message, channel_id);
+  rtc::SetBE16(message + 2, static_cast<uint16_t>(size));
+  memcpy(message + TURN_CHANNEL_HEADER_SIZE, data, size);
+  relay_queue_.push_back({conn->socket(), conn->src(), offset, message_size});
+  if (relay_queue_.size() >= kMaxQueuedRelayPackets) {
+    FlushRelayQueue();
+  }
+}
+
+void TurnServer::FlushRelayQueue() {
   RTC_DCHECK(thread_checker_.IsCurrent());
+  if (relay_queue_.empty()) {
+    return;
+  }
+  // |relay_buffer_| no longer grows, so the datagrams can point into it.
+  std::vector<rtc::Socket::Datagram> datagrams(relay_queue_.size());
+  for (size_t i = 0; i < relay_queue_.size(); ++i) {
+    datagrams[i].data = &relay_buffer_[relay_queue_[i].offset];
+    datagrams[i].size = relay_queue_[i].size;
+    datagrams[i].addr = relay_queue_[i].addr;
+  }
   rtc::PacketOptions options;
-  conn->socket()->SendTo(buf.Data(), buf.Length(), conn->src(), options);
+  size_t begin = 0;
+  while (begin < relay_queue_.size()) {
+    // Send each run of messages for the same socket at once. Like a single
+    // failed SendTo(), a failed batch drops its packets.
+    rtc::AsyncPacketSocket* socket = relay_queue_[begin].socket;
+    size_t end = begin + 1;
+    while (end < relay_queue_.size() && relay_queue_[end].socket == socket) {
+      ++end;
+    }
+    socket->SendToBatch(&datagrams[begin], end - begin, options);
+    begin = end;
+  }
+  relay_queue_.clear();
+  relay_buffer_.clear();
 }
 
 void TurnServer::OnAllocationDestroyed(TurnServerAllocation* allocation) {
@@ -545,7 +629,8 @@ void TurnServer::OnAllocationDestroyed(TurnServerAllocation* allocation) {
   // by all allocations.
   // Note: We may not find a socket if it's a TCP socket that was closed, and
   // the allocation is only now timing out.
-  if (iter != server_sockets_.end() && iter->second != cricket::PROTO_UDP) {
+  if (iter != server_sockets_.end() &&
+      iter->second.proto != cricket::PROTO_UDP) {
     DestroyInternalSocket(socket);
   }
 
@@ -558,6 +643,7 @@ void TurnServer::OnAllocationDestroyed(TurnServerAllocation* allocation) {
 
 void TurnServer::DestroyInternalSocket(rtc::AsyncPacketSocket* socket) {
   RTC_DCHECK(thread_checker_.IsCurrent());
+  FlushRelayQueue();
   InternalSocketMap::iterator iter = server_sockets_.find(socket);
   if (iter != server_sockets_.end()) {
     rtc::AsyncPacketSocket* socket = iter->first;
@@ -581,16 +667,25 @@ void TurnServer::FreeSockets() {
 TurnServerConnection::TurnServerConnection(const rtc::SocketAddress& src,
                                            ProtocolType proto,
                                            rtc::AsyncPacketSocket* socket)
-    : src_(src),
-      dst_(socket->GetRemoteAddress()),
-      proto_(proto),
-      socket_(socket) {
-}
+    : TurnServerConnection(src, socket->GetRemoteAddress(), proto, socket) {}
+
+TurnServerConnection::TurnServerConnection(const rtc::SocketAddress& src,
+                                           const rtc::SocketAddress& dst,
+                                           ProtocolType proto,
+                                           rtc::AsyncPacketSocket* socket)
+    : src_(src), dst_(dst), proto_(proto), socket_(socket) {}
 
 bool TurnServerConnection::operator==(const TurnServerConnection& c) const {
   return src_ == c.src_ && dst_ == c.dst_ && proto_ == c.proto_;
 }
 
+size_t TurnServerConnection::Hash::operator()(
+    const TurnServerConnection& conn) const {
+  // |src_| and |dst_| are the same for TCP connections, so that they would
+  // cancel out if simply XORed.
+  return (conn.src_.Hash() * 31 + conn.dst_.Hash()) * 31 + conn.proto_;
+}
+
 bool TurnServerConnection::operator<(const TurnServerConnection& c) const {
   return std::tie(src_, dst_, proto_) < std::tie(c.src_, c.dst_, c.proto_);
 }
@@ -619,13 +714,11 @@ TurnServerAllocation::TurnServerAllocation(TurnServer* server,
 }
 
 TurnServerAllocation::~TurnServerAllocation() {
-  for (ChannelList::iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    delete *it;
+  for (const auto& kv : channels_) {
+    delete kv.second;
   }
-  for (PermissionList::iterator it = perms_.begin();
-       it != perms_.end(); ++it) {
-    delete *it;
+  for (const auto& kv : perms_) {
+    delete kv.second;
   }
   thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
   RTC_LOG(LS_INFO) << ToString() << ": Allocation destroyed";
@@ -678,8 +771,11 @@ void TurnServerAllocation::HandleAllocateRequest(const TurnMessage* msg) {
 
   // Figure out the lifetime and start the allocation timer.
   int lifetime_secs = ComputeLifetime(msg);
-  thread_->PostDelayed(RTC_FROM_HERE, lifetime_secs * 1000, this,
-                       MSG_ALLOCATION_TIMEOUT);
+  if (expires_ms_ == 0) {
+    thread_->PostDelayed(RTC_FROM_HERE, lifetime_secs * 1000, this,
+                         MSG_ALLOCATION_TIMEOUT);
+  }
+  expires_ms_ = rtc::TimeMillis() + lifetime_secs * 1000;
 
   RTC_LOG(LS_INFO) << ToString()
                    << ": Created allocation with lifetime=" << lifetime_secs;
@@ -705,10 +801,16 @@ void TurnServerAllocation::HandleRefreshRequest(const TurnMessage* msg) {
   // Figure out the new lifetime.
   int lifetime_secs = ComputeLifetime(msg);
 
-  // Reset the expiration timer.
-  thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
-  thread_->PostDelayed(RTC_FROM_HERE, lifetime_secs * 1000, this,
-                       MSG_ALLOCATION_TIMEOUT);
+  // Reset the expiration timer. Only a shorter lifetime, like the zero of a
+  // deallocation, needs the pending timeout to be replaced; Clear() scans the
+  // whole message queue.
+  int64_t expires_ms = rtc::TimeMillis() + lifetime_secs * 1000;
+  if (expires_ms < expires_ms_) {
+    thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
+    thread_->PostDelayed(RTC_FROM_HERE, lifetime_secs * 1000, this,
+                         MSG_ALLOCATION_TIMEOUT);
+  }
+  expires_ms_ = expires_ms;
 
   RTC_LOG(LS_INFO) << ToString()
                    << ": Refreshed allocation, lifetime=" << lifetime_secs;
@@ -808,7 +910,8 @@ void TurnServerAllocation::HandleChannelBindRequest(const TurnMessage* msg) {
     channel1 = new Channel(thread_, channel_id, peer_attr->GetAddress());
     channel1->SignalDestroyed.connect(this,
         &TurnServerAllocation::OnChannelDestroyed);
-    channels_.push_back(channel1);
+    channels_[channel_id] = channel1;
+    channels_by_peer_[channel1->peer()] = channel1;
   } else {
     channel1->Refresh();
   }
@@ -851,11 +954,8 @@ void TurnServerAllocation::OnExternalPacket(
   Channel* channel = FindChannel(addr);
   if (channel) {
     // There is a channel bound to this address. Send as a channel message.
-    rtc::ByteBufferWriter buf;
-    buf.WriteUInt16(channel->id());
-    buf.WriteUInt16(static_cast<uint16_t>(size));
-    buf.WriteBytes(data, size);
-    server_->Send(&conn_, buf);
+    server_->SendChannelData(&conn_, static_cast<uint16_t>(channel->id()),
+                             data, size);
   } else if (!server_->enable_permission_checks_ ||
              HasPermission(addr.ipaddr())) {
     // No channel, but a permission exists. Send as a data indication.
@@ -896,7 +996,7 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
     perm = new Permission(thread_, addr);
     perm->SignalDestroyed.connect(
         this, &TurnServerAllocation::OnPermissionDestroyed);
-    perms_.push_back(perm);
+    perms_[addr] = perm;
   } else {
     perm->Refresh();
   }
@@ -904,32 +1004,20 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
 
 TurnServerAllocation::Permission* TurnServerAllocation::FindPermission(
     const rtc::IPAddress& addr) const {
-  for (PermissionList::const_iterator it = perms_.begin();
-       it != perms_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  auto it = perms_.find(addr);
+  return (it != perms_.end()) ? it->second : nullptr;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     int channel_id) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->id() == channel_id)
-      return *it;
-  }
-  return NULL;
+  auto it = channels_.find(channel_id);
+  return (it != channels_.end()) ? it->second : nullptr;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     const rtc::SocketAddress& addr) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  auto it = channels_by_peer_.find(addr);
+  return (it != channels_by_peer_.end()) ? it->second : nullptr;
 }
 
 void TurnServerAllocation::SendResponse(TurnMessage* msg) {
@@ -955,26 +1043,40 @@ void TurnServerAllocation::SendExternal(const void* data, size_t size,
 
 void TurnServerAllocation::OnMessage(rtc::Message* msg) {
   RTC_DCHECK(msg->message_id == MSG_ALLOCATION_TIMEOUT);
+  int64_t remaining_ms = expires_ms_ - rtc::TimeMillis();
+  if (remaining_ms > 0) {
+    // Refreshed since the timeout was posted.
+    thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(remaining_ms), this,
+                         MSG_ALLOCATION_TIMEOUT);
+    return;
+  }
   SignalDestroyed(this);
   delete this;
 }
 
 void TurnServerAllocation::OnPermissionDestroyed(Permission* perm) {
-  auto it = absl::c_find(perms_, perm);
-  RTC_DCHECK(it != perms_.end());
+  auto it = perms_.find(perm->peer());
+  RTC_DCHECK(it != perms_.end() && it->second == perm);
   perms_.erase(it);
 }
 
 void TurnServerAllocation::OnChannelDestroyed(Channel* channel) {
-  auto it = absl::c_find(channels_, channel);
-  RTC_DCHECK(it != channels_.end());
-  channels_.erase(it);
+  RTC_DCHECK(channels_.count(channel->id()) == 1);
+  RTC_DCHECK(channels_by_peer_.count(channel->peer()) == 1);
+  channels_.erase(channel->id());
+  channels_by_peer_.erase(channel->peer());
 }
 
+// Permissions and channels keep a single timeout message posted, which is
+// posted again when it fires before the refreshed lifetime has passed. The
+// lifetimes are fixed, so that a refresh never shortens them.
 TurnServerAllocation::Permission::Permission(rtc::Thread* thread,
                                    const rtc::IPAddress& peer)
-    : thread_(thread), peer_(peer) {
-  Refresh();
+    : thread_(thread),
+      peer_(peer),
+      expires_ms_(rtc::TimeMillis() + kPermissionTimeout) {
+  thread_->PostDelayed(RTC_FROM_HERE, kPermissionTimeout, this,
+                       MSG_ALLOCATION_TIMEOUT);
 }
 
 TurnServerAllocation::Permission::~Permission() {
@@ -982,21 +1084,29 @@ TurnServerAllocation::Permission::~Permission() {
 }
 
 void TurnServerAllocation::Permission::Refresh() {
-  thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
-  thread_->PostDelayed(RTC_FROM_HERE, kPermissionTimeout, this,
-                       MSG_ALLOCATION_TIMEOUT);
+  expires_ms_ = rtc::TimeMillis() + kPermissionTimeout;
 }
 
 void TurnServerAllocation::Permission::OnMessage(rtc::Message* msg) {
   RTC_DCHECK(msg->message_id == MSG_ALLOCATION_TIMEOUT);
+  int64_t remaining_ms = expires_ms_ - rtc::TimeMillis();
+  if (remaining_ms > 0) {
+    thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(remaining_ms), this,
+                         MSG_ALLOCATION_TIMEOUT);
+    return;
+  }
   SignalDestroyed(this);
   delete this;
 }
 
 TurnServerAllocation::Channel::Channel(rtc::Thread* thread, int id,
                              const rtc::SocketAddress& peer)
-    : thread_(thread), id_(id), peer_(peer) {
-  Refresh();
+    : thread_(thread),
+      id_(id),
+      peer_(peer),
+      expires_ms_(rtc::TimeMillis() + kChannelTimeout) {
+  thread_->PostDelayed(RTC_FROM_HERE, kChannelTimeout, this,
+                       MSG_ALLOCATION_TIMEOUT);
 }
 
 TurnServerAllocation::Channel::~Channel() {
@@ -1004,13 +1114,17 @@ TurnServerAllocation::Channel::~Channel() {
 }
 
 void TurnServerAllocation::Channel::Refresh() {
-  thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
-  thread_->PostDelayed(RTC_FROM_HERE, kChannelTimeout, this,
-                       MSG_ALLOCATION_TIMEOUT);
+  expires_ms_ = rtc::TimeMillis() + kChannelTimeout;
 }
 
 void TurnServerAllocation::Channel::OnMessage(rtc::Message* msg) {
   RTC_DCHECK(msg->message_id == MSG_ALLOCATION_TIMEOUT);
+  int64_t remaining_ms = expires_ms_ - rtc::TimeMillis();
+  if (remaining_ms > 0) {
+    thread_->PostDelayed(RTC_FROM_HERE, static_cast<int>(remaining_ms), this,
+                         MSG_ALLOCATION_TIMEOUT);
+    return;
+  }
   SignalDestroyed(this);
   delete this;
 }
@@ -11,17 +11,18 @@
 #ifndef P2P_BASE_TURN_SERVER_H_
 #define P2P_BASE_TURN_SERVER_H_
 
-#include <list>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "p2p/base/port_interface.h"
 #include "rtc_base/async_invoker.h"
 #include "rtc_base/async_packet_socket.h"
+#include "rtc_base/ip_address.h"
 #include "rtc_base/message_queue.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
@@ -49,12 +50,24 @@ class TurnServerConnection {
   TurnServerConnection(const rtc::SocketAddress& src,
                        ProtocolType proto,
                        rtc::AsyncPacketSocket* socket);
+  // Takes the remote address of |socket| as |dst|, so that it need not be
+  // queried for every packet.
+  TurnServerConnection(const rtc::SocketAddress& src,
+                       const rtc::SocketAddress& dst,
+                       ProtocolType proto,
+                       rtc::AsyncPacketSocket* socket);
   const rtc::SocketAddress& src() const { return src_; }
+  ProtocolType proto() const { return proto_; }
   rtc::AsyncPacketSocket* socket() { return socket_; }
   bool operator==(const TurnServerConnection& t) const;
   bool operator<(const TurnServerConnection& t) const;
   std::string ToString() const;
 
+  // Consistent with operator==.
+  struct Hash {
+    size_t operator()(const TurnServerConnection& conn) const;
+  };
+
  private:
   rtc::SocketAddress src_;
   rtc::SocketAddress dst_;
@@ -95,8 +108,22 @@ class TurnServerAllocation : public rtc::MessageHandler,
  private:
   class Channel;
   class Permission;
-  typedef std::list<Permission*> PermissionList;
-  typedef std::list<Channel*> ChannelList;
+  struct IPAddressHash {
+    size_t operator()(const rtc::IPAddress& addr) const {
+      return rtc::HashIP(addr);
+    }
+  };
+  struct SocketAddressHash {
+    size_t operator()(const rtc::SocketAddress& addr) const {
+      return addr.Hash();
+    }
+  };
+  // Hashed, as every relayed packet looks up its channel or permission.
+  typedef std::unordered_map<rtc::IPAddress, Permission*, IPAddressHash>
+      PermissionMap;
+  typedef std::unordered_map<int, Channel*> ChannelMap;
+  typedef std::unordered_map<rtc::SocketAddress, Channel*, SocketAddressHash>
+      ChannelPeerMap;
 
   void HandleAllocateRequest(const TurnMessage* msg);
   void HandleRefreshRequest(const TurnMessage* msg);
@@ -137,8 +164,12 @@ class TurnServerAllocation : public rtc::MessageHandler,
   std::string username_;
   std::string origin_;
   std::string last_nonce_;
-  PermissionList perms_;
-  ChannelList channels_;
+  // Lifetime of the allocation; a refresh only moves this forward, and the
+  // timeout message is posted again if it fires early.
+  int64_t expires_ms_ = 0;
+  PermissionMap perms_;
+  ChannelMap channels_;
+  ChannelPeerMap channels_by_peer_;
 };
 
 // An interface through which the MD5 credential hash can be retrieved.
@@ -173,7 +204,9 @@ class StunMessageObserver {
 // Not yet wired up: TCP support.
 class TurnServer : public sigslot::has_slots<> {
  public:
-  typedef std::map<TurnServerConnection, std::unique_ptr<TurnServerAllocation>>
+  typedef std::unordered_map<TurnServerConnection,
+                             std::unique_ptr<TurnServerAllocation>,
+                             TurnServerConnection::Hash>
       AllocationMap;
 
   explicit TurnServer(rtc::Thread* thread);
@@ -231,6 +264,15 @@ class TurnServer : public sigslot::has_slots<> {
     enable_permission_checks_ = enable;
   }
 
+  // If set to true, ChannelData messages relayed from peers to clients on UDP
+  // are queued and sent with AsyncPacketSocket::SendToBatch() once the
+  // current batch of socket events has been handled, or when the queue is
+  // full.
+  void set_enable_batched_relay(bool enable) {
+    RTC_DCHECK(thread_checker_.IsCurrent());
+    enable_batched_relay_ = enable;
+  }
+
   // Starts listening for packets from internal clients.
   void AddInternalSocket(rtc::AsyncPacketSocket* socket,
                          ProtocolType proto);
@@ -299,6 +341,14 @@ class TurnServer : public sigslot::has_slots<> {
 
   void SendStun(TurnServerConnection* conn, StunMessage* msg);
   void Send(TurnServerConnection* conn, const rtc::ByteBufferWriter& buf);
+  void Send(TurnServerConnection* conn, const char* data, size_t size);
+  // Sends a ChannelData message with |size| bytes of |data| to the client.
+  void SendChannelData(TurnServerConnection* conn,
+                       uint16_t channel_id,
+                       const char* data,
+                       size_t size);
+  // Sends the ChannelData messages queued by SendChannelData().
+  void FlushRelayQueue();
 
   void OnAllocationDestroyed(TurnServerAllocation* allocation);
   void DestroyInternalSocket(rtc::AsyncPacketSocket* socket);
@@ -306,8 +356,12 @@ class TurnServer : public sigslot::has_slots<> {
   // Just clears |sockets_to_delete_|; called asynchronously.
   void FreeSockets();
 
-  typedef std::map<rtc::AsyncPacketSocket*,
-                   ProtocolType> InternalSocketMap;
+  struct InternalSocket {
+    ProtocolType proto;
+    // Cached, as PhysicalSocket::GetRemoteAddress() makes a system call.
+    rtc::SocketAddress remote_address;
+  };
+  typedef std::map<rtc::AsyncPacketSocket*, InternalSocket> InternalSocketMap;
   typedef std::map<rtc::AsyncSocket*,
                    ProtocolType> ServerSocketMap;
 
@@ -324,6 +378,20 @@ class TurnServer : public sigslot::has_slots<> {
   bool reject_private_addresses_ = false;
   // Check for permission when receiving an external packet.
   bool enable_permission_checks_ = true;
+  bool enable_batched_relay_ = false;
+
+  // ChannelData messages waiting for FlushRelayQueue(), stored back to back
+  // in |relay_buffer_|.
+  struct QueuedPacket {
+    rtc::AsyncPacketSocket* socket;
+    rtc::SocketAddress addr;
+    size_t offset;
+    size_t size;
+  };
+  std::vector<QueuedPacket> relay_queue_;
+  std::vector<char> relay_buffer_;
+  // Reused by SendChannelData() when not batching.
+  std::vector<char> channel_data_buffer_;
 
   InternalSocketMap server_sockets_;
   ServerSocketMap server_listen_sockets_;
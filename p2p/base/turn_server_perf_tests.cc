@@ -0,0 +1,317 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "p2p/base/packet_socket_factory.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/turn_server.h"
+#include "rtc_base/async_packet_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_base/virtual_socket_server.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+constexpr int kNumAllocations = 10000;
+constexpr int kNumRounds = 20;
+constexpr size_t kPayloadSize = 160;
+constexpr int kChannelId = 0x4000;
+constexpr size_t kChannelDataHeaderSize = 4;
+const char kRealm[] = "perf.test";
+const char kUsername[] = "user";
+const char kPassword[] = "password";
+const rtc::SocketAddress kInternalAddress("192.168.0.1", 3478);
+const rtc::IPAddress kExternalIp(0xC0A80101);  // 192.168.1.1
+
+// Stands in for a UDP socket, counting what would be sent, so that only the
+// server's own work is measured.
+class CountingPacketSocket : public rtc::AsyncPacketSocket {
+ public:
+  explicit CountingPacketSocket(const rtc::SocketAddress& address)
+      : address_(address) {}
+
+  rtc::SocketAddress GetLocalAddress() const override { return address_; }
+  rtc::SocketAddress GetRemoteAddress() const override {
+    return rtc::SocketAddress();
+  }
+  int Send(const void* pv,
+           size_t cb,
+           const rtc::PacketOptions& options) override {
+    return -1;
+  }
+  int SendTo(const void* pv,
+             size_t cb,
+             const rtc::SocketAddress& addr,
+             const rtc::PacketOptions& options) override {
+    ++send_calls_;
+    ++sent_packets_;
+    return static_cast<int>(cb);
+  }
+  int SendToBatch(const rtc::Socket::Datagram* datagrams,
+                  size_t count,
+                  const rtc::PacketOptions& options) override {
+    ++send_calls_;
+    sent_packets_ += static_cast<int>(count);
+    return static_cast<int>(count);
+  }
+  int Close() override { return 0; }
+  State GetState() const override { return STATE_BOUND; }
+  int GetOption(rtc::Socket::Option opt, int* value) override { return -1; }
+  int SetOption(rtc::Socket::Option opt, int value) override { return 0; }
+  int GetError() const override { return 0; }
+  void SetError(int error) override {}
+
+  // Delivers |size| bytes of |data| from |addr| to the server.
+  void Receive(const char* data, size_t size, const rtc::SocketAddress& addr) {
+    SignalReadPacket(this, data, size, addr, rtc::TimeMicros());
+  }
+
+  int send_calls() const { return send_calls_; }
+  int sent_packets() const { return sent_packets_; }
+  void ResetCounters() {
+    send_calls_ = 0;
+    sent_packets_ = 0;
+  }
+
+ private:
+  const rtc::SocketAddress address_;
+  int send_calls_ = 0;
+  int sent_packets_ = 0;
+};
+
+// Creates the relay sockets of the allocations.
+class CountingPacketSocketFactory : public rtc::PacketSocketFactory {
+ public:
+  rtc::AsyncPacketSocket* CreateUdpSocket(const rtc::SocketAddress& address,
+                                          uint16_t min_port,
+                                          uint16_t max_port) override {
+    auto* socket = new CountingPacketSocket(rtc::SocketAddress(
+        address.ipaddr(), static_cast<int>(1024 + sockets_.size())));
+    sockets_.push_back(socket);
+    return socket;
+  }
+  rtc::AsyncPacketSocket* CreateServerTcpSocket(
+      const rtc::SocketAddress& local_address,
+      uint16_t min_port,
+      uint16_t max_port,
+      int opts) override {
+    return nullptr;
+  }
+  rtc::AsyncPacketSocket* CreateClientTcpSocket(
+      const rtc::SocketAddress& local_address,
+      const rtc::SocketAddress& remote_address,
+      const rtc::ProxyInfo& proxy_info,
+      const std::string& user_agent,
+      int opts) override {
+    return nullptr;
+  }
+  rtc::AsyncResolverInterface* CreateAsyncResolver() override {
+    return nullptr;
+  }
+
+  // The sockets are owned by the allocations, in the order they were made.
+  const std::vector<CountingPacketSocket*>& sockets() const {
+    return sockets_;
+  }
+
+ private:
+  std::vector<CountingPacketSocket*> sockets_;
+};
+
+class PerfTestAuth : public TurnAuthInterface {
+ public:
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    return ComputeStunCredentialHash(username, realm, kPassword, key);
+  }
+};
+
+rtc::SocketAddress ClientAddress(int index) {
+  return rtc::SocketAddress(rtc::IPAddress(0x0A000000 + index / 1000 + 1),
+                            10000 + index % 1000);
+}
+
+rtc::SocketAddress PeerAddress(int index) {
+  return rtc::SocketAddress(rtc::IPAddress(0x14000000 + index + 1), 5000);
+}
+
+// Serializes an authenticated request, as a TurnPort sends it.
+std::string CreateRequest(int type,
+                          const std::string& nonce,
+                          std::unique_ptr<StunAttribute> attribute) {
+  TurnMessage request;
+  request.SetType(type);
+  request.SetTransactionID(rtc::CreateRandomString(kStunTransactionIdLength));
+  request.AddAttribute(std::move(attribute));
+  if (type == TURN_CHANNEL_BIND_REQUEST) {
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_CHANNEL_NUMBER, kChannelId << 16));
+  }
+  request.AddAttribute(absl::make_unique<StunByteStringAttribute>(
+      STUN_ATTR_USERNAME, kUsername));
+  request.AddAttribute(
+      absl::make_unique<StunByteStringAttribute>(STUN_ATTR_REALM, kRealm));
+  request.AddAttribute(
+      absl::make_unique<StunByteStringAttribute>(STUN_ATTR_NONCE, nonce));
+  std::string key;
+  ComputeStunCredentialHash(kUsername, kRealm, kPassword, &key);
+  request.AddMessageIntegrity(key);
+  rtc::ByteBufferWriter buffer;
+  request.Write(&buffer);
+  return std::string(buffer.Data(), buffer.Length());
+}
+
+class TurnServerPerfTest : public ::testing::Test {
+ public:
+  TurnServerPerfTest()
+      : thread_(&socket_server_),
+        server_(rtc::Thread::Current()),
+        internal_socket_(new CountingPacketSocket(kInternalAddress)),
+        socket_factory_(new CountingPacketSocketFactory()) {
+    server_.set_realm(kRealm);
+    server_.set_auth_hook(&auth_);
+    server_.AddInternalSocket(internal_socket_, PROTO_UDP);
+    server_.SetExternalSocketFactory(socket_factory_,
+                                     rtc::SocketAddress(kExternalIp, 0));
+  }
+
+  // Creates |kNumAllocations| allocations, each with a channel bound to its
+  // own peer.
+  void CreateAllocations() {
+    const std::string nonce = server_.SetTimestampForNextNonce(
+        rtc::TimeMillis());
+    for (int i = 0; i < kNumAllocations; ++i) {
+      std::string request = CreateRequest(
+          STUN_ALLOCATE_REQUEST, nonce,
+          absl::make_unique<StunUInt32Attribute>(
+              STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24));
+      internal_socket_->Receive(request.data(), request.size(),
+                                ClientAddress(i));
+      request = CreateRequest(TURN_CHANNEL_BIND_REQUEST, nonce,
+                              absl::make_unique<StunXorAddressAttribute>(
+                                  STUN_ATTR_XOR_PEER_ADDRESS, PeerAddress(i)));
+      internal_socket_->Receive(request.data(), request.size(),
+                                ClientAddress(i));
+    }
+    thread_.ProcessMessages(0);
+    internal_socket_->ResetCounters();
+  }
+
+  // Returns the nanoseconds spent relaying |kNumRounds| packets from every
+  // peer to its client.
+  int64_t RelayFromPeers() {
+    const std::vector<CountingPacketSocket*>& sockets =
+        socket_factory_->sockets();
+    const std::string payload(kPayloadSize, 'x');
+    int64_t start_ns = rtc::SystemTimeNanos();
+    for (int round = 0; round < kNumRounds; ++round) {
+      for (int i = 0; i < kNumAllocations; ++i) {
+        sockets[i]->Receive(payload.data(), payload.size(), PeerAddress(i));
+      }
+      // Like the end of a round of socket events.
+      thread_.ProcessMessages(0);
+    }
+    return rtc::SystemTimeNanos() - start_ns;
+  }
+
+ protected:
+  rtc::VirtualSocketServer socket_server_;
+  rtc::AutoSocketServerThread thread_;
+  PerfTestAuth auth_;
+  TurnServer server_;
+  // Owned by |server_|.
+  CountingPacketSocket* internal_socket_;
+  CountingPacketSocketFactory* socket_factory_;
+};
+
+void PrintPacketsPerSecond(const std::string& trace,
+                           int64_t elapsed_ns,
+                           bool important) {
+  webrtc::test::PrintResult(
+      "turn_server", "_10k_allocations", trace,
+      static_cast<double>(kNumRounds) * kNumAllocations *
+          rtc::kNumNanosecsPerSec / elapsed_ns,
+      "packets/s", important);
+}
+
+}  // namespace
+
+// Relays ChannelData from every client to its peer, through the single
+// internal socket the clients share.
+TEST_F(TurnServerPerfTest, RelayChannelDataToPeers) {
+  CreateAllocations();
+  ASSERT_EQ(static_cast<size_t>(kNumAllocations),
+            server_.allocations().size());
+
+  std::vector<char> message(kChannelDataHeaderSize + kPayloadSize, 'x');
+  rtc::SetBE16(message.data(), kChannelId);
+  rtc::SetBE16(message.data() + 2, static_cast<uint16_t>(kPayloadSize));
+  std::vector<rtc::SocketAddress> clients;
+  for (int i = 0; i < kNumAllocations; ++i) {
+    clients.push_back(ClientAddress(i));
+  }
+  int64_t start_ns = rtc::SystemTimeNanos();
+  for (int round = 0; round < kNumRounds; ++round) {
+    for (int i = 0; i < kNumAllocations; ++i) {
+      internal_socket_->Receive(message.data(), message.size(), clients[i]);
+    }
+  }
+  int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+
+  int relayed = 0;
+  for (const CountingPacketSocket* socket : socket_factory_->sockets()) {
+    relayed += socket->sent_packets();
+  }
+  EXPECT_EQ(kNumRounds * kNumAllocations, relayed);
+  PrintPacketsPerSecond("client_to_peer", elapsed_ns, true);
+}
+
+// Relays packets from every peer to its client as ChannelData, one send per
+// packet and then in batches.
+TEST_F(TurnServerPerfTest, RelayChannelDataToClients) {
+  CreateAllocations();
+  ASSERT_EQ(static_cast<size_t>(kNumAllocations),
+            server_.allocations().size());
+
+  int64_t elapsed_ns = RelayFromPeers();
+  EXPECT_EQ(kNumRounds * kNumAllocations, internal_socket_->sent_packets());
+  PrintPacketsPerSecond("peer_to_client", elapsed_ns, true);
+  webrtc::test::PrintResult(
+      "turn_server", "_10k_allocations", "peer_to_client_packets_per_send",
+      static_cast<double>(internal_socket_->sent_packets()) /
+          internal_socket_->send_calls(),
+      "packets", false);
+
+  internal_socket_->ResetCounters();
+  server_.set_enable_batched_relay(true);
+  elapsed_ns = RelayFromPeers();
+  EXPECT_EQ(kNumRounds * kNumAllocations, internal_socket_->sent_packets());
+  PrintPacketsPerSecond("peer_to_client_batched", elapsed_ns, true);
+  webrtc::test::PrintResult(
+      "turn_server", "_10k_allocations",
+      "peer_to_client_batched_packets_per_send",
+      static_cast<double>(internal_socket_->sent_packets()) /
+          internal_socket_->send_calls(),
+      "packets", false);
+}
+
+}  // namespace cricket
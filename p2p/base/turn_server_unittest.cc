@@ -10,15 +10,41 @@
 
 #include "p2p/base/turn_server.h"
 
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "api/units/time_delta.h"
 #include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/stun.h"
+#include "p2p/base/test_turn_server.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/fake_clock.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/test_client.h"
 #include "rtc_base/virtual_socket_server.h"
 #include "test/gtest.h"
 
 // NOTE: This is a work in progress. Currently this file only has tests for
-// TurnServerConnection, a primitive class used by TurnServer.
+// TurnServerConnection, a primitive class used by TurnServer, and for the
+// lifetimes of allocations and of their permissions and channels.
 
 namespace cricket {
 
+namespace {
+
+const rtc::SocketAddress kTurnIntAddr("99.99.99.3", 3478);
+const rtc::SocketAddress kTurnExtAddr("99.99.99.5", 0);
+const rtc::SocketAddress kClientAddr("11.11.11.11", 1111);
+const rtc::SocketAddress kPeerAddr("22.22.22.22", 2222);
+const char kUsername[] = "test";
+const int kChannelId = 0x4000;
+// How long to wait for a packet that should not arrive.
+const int kNoPacketTimeoutMs = 100;
+
+}  // namespace
+
 class TurnServerConnectionTest : public ::testing::Test {
  public:
   TurnServerConnectionTest() : thread_(&vss_) {}
@@ -28,6 +54,7 @@ class TurnServerConnectionTest : public ::testing::Test {
     EXPECT_TRUE(a == b);
     EXPECT_FALSE(a < b);
     EXPECT_FALSE(b < a);
+    EXPECT_EQ(TurnServerConnection::Hash()(a), TurnServerConnection::Hash()(b));
   }
 
   void ExpectNotEqual(const TurnServerConnection& a,
@@ -64,4 +91,232 @@ TEST_F(TurnServerConnectionTest, ComparisonOperators) {
   ExpectNotEqual(connection1, connection4);
 }
 
+// The source and destination of a TCP connection are the same, which must not
+// make the hashes of all TCP connections collide.
+TEST_F(TurnServerConnectionTest, HashOfTcpConnections) {
+  std::unique_ptr<rtc::AsyncPacketSocket> socket(
+      socket_factory_.CreateUdpSocket(rtc::SocketAddress("1.1.1.1", 1), 0, 0));
+  const rtc::SocketAddress address1("2.2.2.2", 2);
+  const rtc::SocketAddress address2("3.3.3.3", 3);
+  TurnServerConnection connection1(address1, address1, PROTO_TCP,
+                                   socket.get());
+  TurnServerConnection connection2(address2, address2, PROTO_TCP,
+                                   socket.get());
+  ExpectNotEqual(connection1, connection2);
+  EXPECT_NE(TurnServerConnection::Hash()(connection1),
+            TurnServerConnection::Hash()(connection2));
+}
+
+// Tests the timers of an allocation, its permissions and its channels, by
+// sending requests from a client and packets from a peer, on a fake clock.
+class TurnServerAllocationTest : public ::testing::Test {
+ public:
+  TurnServerAllocationTest()
+      : thread_(&vss_),
+        turn_server_(rtc::Thread::Current(), kTurnIntAddr, kTurnExtAddr),
+        client_(absl::WrapUnique(rtc::AsyncUDPSocket::Create(&vss_,
+                                                             kClientAddr)),
+                &clock_),
+        peer_(absl::WrapUnique(rtc::AsyncUDPSocket::Create(&vss_, kPeerAddr)),
+              &clock_) {}
+
+  // Relayed packets from the peer, as the client receives them.
+  enum class Relayed { kNothing, kDataIndication, kChannelData };
+
+ protected:
+  // Sends |request| from the client with the long-term credentials a TurnPort
+  // uses, and returns the response.
+  std::unique_ptr<TurnMessage> SendRequest(TurnMessage* request) {
+    request->SetTransactionID(
+        rtc::CreateRandomString(kStunTransactionIdLength));
+    request->AddAttribute(absl::make_unique<StunByteStringAttribute>(
+        STUN_ATTR_USERNAME, kUsername));
+    request->AddAttribute(absl::make_unique<StunByteStringAttribute>(
+        STUN_ATTR_REALM, kTestRealm));
+    request->AddAttribute(absl::make_unique<StunByteStringAttribute>(
+        STUN_ATTR_NONCE, turn_server_.server()->SetTimestampForNextNonce(
+                             rtc::TimeMillis())));
+    std::string key;
+    ComputeStunCredentialHash(kUsername, kTestRealm, kUsername, &key);
+    request->AddMessageIntegrity(key);
+    rtc::ByteBufferWriter buffer;
+    request->Write(&buffer);
+    client_.SendTo(buffer.Data(), buffer.Length(), kTurnIntAddr);
+
+    std::unique_ptr<rtc::TestClient::Packet> packet =
+        client_.NextPacket(rtc::TestClient::kTimeoutMs);
+    if (!packet) {
+      return nullptr;
+    }
+    auto response = absl::make_unique<TurnMessage>();
+    rtc::ByteBufferReader reader(packet->buf, packet->size);
+    if (!response->Read(&reader)) {
+      return nullptr;
+    }
+    return response;
+  }
+
+  // Allocates a relayed address, with the default lifetime if
+  // |lifetime_secs| is negative.
+  void Allocate(int lifetime_secs) {
+    TurnMessage request;
+    request.SetType(STUN_ALLOCATE_REQUEST);
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24));
+    if (lifetime_secs >= 0) {
+      request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+          STUN_ATTR_LIFETIME, lifetime_secs));
+    }
+    std::unique_ptr<TurnMessage> response = SendRequest(&request);
+    ASSERT_TRUE(response);
+    ASSERT_EQ(STUN_ALLOCATE_RESPONSE, response->type());
+    const StunAddressAttribute* relayed_address =
+        response->GetAddress(STUN_ATTR_XOR_RELAYED_ADDRESS);
+    ASSERT_TRUE(relayed_address);
+    relayed_address_ = relayed_address->GetAddress();
+  }
+
+  // Refreshes the allocation and returns the granted lifetime, or -1 if the
+  // refresh failed.
+  int Refresh(int lifetime_secs) {
+    TurnMessage request;
+    request.SetType(TURN_REFRESH_REQUEST);
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_LIFETIME, lifetime_secs));
+    std::unique_ptr<TurnMessage> response = SendRequest(&request);
+    if (!response || response->type() != TURN_REFRESH_RESPONSE ||
+        !response->GetUInt32(STUN_ATTR_LIFETIME)) {
+      return -1;
+    }
+    return static_cast<int>(response->GetUInt32(STUN_ATTR_LIFETIME)->value());
+  }
+
+  bool CreatePermission() {
+    TurnMessage request;
+    request.SetType(TURN_CREATE_PERMISSION_REQUEST);
+    request.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_PEER_ADDRESS, kPeerAddr));
+    std::unique_ptr<TurnMessage> response = SendRequest(&request);
+    return response && response->type() == TURN_CREATE_PERMISSION_RESPONSE;
+  }
+
+  bool BindChannel() {
+    TurnMessage request;
+    request.SetType(TURN_CHANNEL_BIND_REQUEST);
+    request.AddAttribute(absl::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_CHANNEL_NUMBER, kChannelId << 16));
+    request.AddAttribute(absl::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_PEER_ADDRESS, kPeerAddr));
+    std::unique_ptr<TurnMessage> response = SendRequest(&request);
+    return response && response->type() == TURN_CHANNEL_BIND_RESPONSE;
+  }
+
+  // Sends a packet from the peer to the relayed address, and returns how it
+  // reaches the client, if it does.
+  Relayed SendFromPeer() {
+    const char kData[] = "data";
+    peer_.SendTo(kData, sizeof(kData), relayed_address_);
+    std::unique_ptr<rtc::TestClient::Packet> packet =
+        client_.NextPacket(kNoPacketTimeoutMs);
+    if (!packet) {
+      return Relayed::kNothing;
+    }
+    // ChannelData starts with a channel number, which has the bits 01 on top,
+    // and STUN messages with the bits 00.
+    return (packet->buf[0] & 0xC0) == 0x40 ? Relayed::kChannelData
+                                           : Relayed::kDataIndication;
+  }
+
+  size_t num_allocations() {
+    return turn_server_.server()->allocations().size();
+  }
+
+  void AdvanceMinutes(int minutes) {
+    clock_.AdvanceTime(webrtc::TimeDelta::seconds(60 * minutes));
+  }
+
+  rtc::ScopedFakeClock clock_;
+  rtc::VirtualSocketServer vss_;
+  rtc::AutoSocketServerThread thread_;
+  TestTurnServer turn_server_;
+  rtc::TestClient client_;
+  rtc::TestClient peer_;
+  rtc::SocketAddress relayed_address_;
+};
+
+TEST_F(TurnServerAllocationTest, RefreshLengthensLifetime) {
+  Allocate(60);
+  ASSERT_EQ(1u, num_allocations());
+  clock_.AdvanceTime(webrtc::TimeDelta::seconds(50));
+  EXPECT_EQ(120, Refresh(120));
+
+  // The timeout posted for the first lifetime fires, but the allocation is
+  // kept until the refreshed lifetime has passed.
+  clock_.AdvanceTime(webrtc::TimeDelta::seconds(110));
+  EXPECT_EQ(1u, num_allocations());
+  clock_.AdvanceTime(webrtc::TimeDelta::seconds(20));
+  EXPECT_EQ(0u, num_allocations());
+}
+
+TEST_F(TurnServerAllocationTest, RefreshShortensLifetime) {
+  Allocate(-1);
+  ASSERT_EQ(1u, num_allocations());
+  clock_.AdvanceTime(webrtc::TimeDelta::seconds(10));
+  EXPECT_EQ(30, Refresh(30));
+
+  clock_.AdvanceTime(webrtc::TimeDelta::seconds(25));
+  EXPECT_EQ(1u, num_allocations());
+  clock_.AdvanceTime(webrtc::TimeDelta::seconds(10));
+  EXPECT_EQ(0u, num_allocations());
+}
+
+TEST_F(TurnServerAllocationTest, RefreshWithZeroLifetimeDeletesAllocation) {
+  Allocate(-1);
+  ASSERT_EQ(1u, num_allocations());
+  EXPECT_EQ(0, Refresh(0));
+  clock_.AdvanceTime(webrtc::TimeDelta::ms(1));
+  EXPECT_EQ(0u, num_allocations());
+  // A new allocation may be made from the same address.
+  Allocate(-1);
+  EXPECT_EQ(1u, num_allocations());
+}
+
+TEST_F(TurnServerAllocationTest, PermissionExpiresAfterRefresh) {
+  Allocate(-1);
+  EXPECT_EQ(Relayed::kNothing, SendFromPeer());
+  ASSERT_TRUE(CreatePermission());
+  EXPECT_EQ(Relayed::kDataIndication, SendFromPeer());
+
+  // Permissions last 5 minutes from their last refresh.
+  AdvanceMinutes(3);
+  ASSERT_TRUE(CreatePermission());
+  AdvanceMinutes(3);
+  EXPECT_EQ(Relayed::kDataIndication, SendFromPeer());
+  AdvanceMinutes(3);
+  EXPECT_EQ(Relayed::kNothing, SendFromPeer());
+  EXPECT_EQ(1u, num_allocations());
+}
+
+TEST_F(TurnServerAllocationTest, ChannelExpiresAfterRefresh) {
+  Allocate(-1);
+  ASSERT_TRUE(BindChannel());
+  EXPECT_EQ(Relayed::kChannelData, SendFromPeer());
+
+  // Channels and allocations last 10 minutes from their last refresh, and
+  // binding a channel refreshes its permission as well.
+  AdvanceMinutes(8);
+  EXPECT_EQ(600, Refresh(600));
+  ASSERT_TRUE(BindChannel());
+  AdvanceMinutes(4);
+  EXPECT_EQ(Relayed::kChannelData, SendFromPeer());
+  ASSERT_TRUE(CreatePermission());
+  EXPECT_EQ(600, Refresh(600));
+  AdvanceMinutes(4);
+  EXPECT_EQ(Relayed::kChannelData, SendFromPeer());
+  // Keep the permission once the channel has expired.
+  ASSERT_TRUE(CreatePermission());
+  AdvanceMinutes(3);
+  EXPECT_EQ(Relayed::kDataIndication, SendFromPeer());
+}
+
 }  // namespace cricket
@@ -27,6 +27,7 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/helpers.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/metrics.h"
 
 using rtc::CreateRandomId;
@@ -324,6 +325,9 @@ BasicPortAllocatorSession::~BasicPortAllocatorSession() {
 
   for (uint32_t i = 0; i < sequences_.size(); ++i)
     delete sequences_[i];
+
+  for (auto& resolver : turn_server_resolvers_)
+    resolver.second.first->Destroy(false);
 }
 
 BasicPortAllocator* BasicPortAllocatorSession::allocator() {
@@ -400,6 +404,14 @@ void BasicPortAllocatorSession::StartGettingPorts() {
     socket_factory_ = owned_socket_factory_.get();
   }
 
+  gathering_start_ms_ = rtc::TimeMillis();
+  gathering_timeline_ = GatheringTimeline();
+  if (flags() & PORTALLOCATOR_ENABLE_PARALLEL_GATHERING) {
+    // Resolving in parallel with the network enumeration and with each other,
+    // so that the relay ports of all networks can use the result.
+    ResolveTurnServers();
+  }
+
   network_thread_->Post(RTC_FROM_HERE, this, MSG_CONFIG_START);
 
   RTC_LOG(LS_INFO) << "Start getting ports with prune_turn_ports "
@@ -1011,6 +1023,7 @@ void BasicPortAllocatorSession::OnCandidateReady(Port* port,
   }
 
   if (data->ready() && CheckCandidateFilter(c)) {
+    UpdateGatheringTimeline(c);
     std::vector<Candidate> candidates;
     candidates.push_back(SanitizeCandidate(c));
     SignalCandidatesReady(this, candidates);
@@ -1159,6 +1172,7 @@ void BasicPortAllocatorSession::MaybeSignalCandidatesAllocationDone() {
       RTC_LOG(LS_INFO) << "All candidates gathered for " << content_name()
                        << ":" << component() << ":" << generation();
     }
+    ReportGatheringTimeline();
     SignalCandidatesAllocationDone(this);
   }
 }
@@ -1177,6 +1191,131 @@ void BasicPortAllocatorSession::OnPortDestroyed(PortInterface* port) {
   RTC_NOTREACHED();
 }
 
+void BasicPortAllocatorSession::ResolveTurnServers() {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  for (const RelayServerConfig& turn_server : allocator_->turn_servers()) {
+    for (const ProtocolAddress& server_address : turn_server.ports) {
+      const rtc::SocketAddress& address = server_address.address;
+      if (!address.IsUnresolvedIP() ||
+          turn_server_resolvers_.count(address.hostname()) > 0) {
+        continue;
+      }
+      webrtc::AsyncResolverFactory* factory =
+          allocator_->async_resolver_factory();
+      rtc::AsyncResolverInterface* resolver =
+          factory ? factory->Create() : socket_factory_->CreateAsyncResolver();
+      turn_server_resolvers_[address.hostname()] =
+          std::make_pair(resolver, false);
+      RTC_LOG(LS_INFO) << "Starting TURN host lookup for "
+                       << address.ToSensitiveString();
+      resolver->SignalDone.connect(
+          this, &BasicPortAllocatorSession::OnTurnServerResolved);
+      resolver->Start(address);
+    }
+  }
+}
+
+void BasicPortAllocatorSession::OnTurnServerResolved(
+    rtc::AsyncResolverInterface* resolver) {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  for (auto& entry : turn_server_resolvers_) {
+    if (entry.second.first != resolver) {
+      continue;
+    }
+    entry.second.second = true;
+    RTC_LOG(LS_INFO) << "TURN host lookup done for " << entry.first
+                     << " with error " << resolver->GetError();
+    for (AllocationSequence* sequence : sequences_) {
+      sequence->OnTurnServerResolved();
+    }
+    return;
+  }
+}
+
+bool BasicPortAllocatorSession::GetResolvedTurnServerAddress(
+    const rtc::SocketAddress& address,
+    int family,
+    rtc::SocketAddress* resolved) const {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  *resolved = address;
+  if (!address.IsUnresolvedIP()) {
+    return true;
+  }
+  auto it = turn_server_resolvers_.find(address.hostname());
+  if (it == turn_server_resolvers_.end()) {
+    // Left to the port to resolve.
+    return true;
+  }
+  rtc::AsyncResolverInterface* resolver = it->second.first;
+  if (!it->second.second) {
+    return false;
+  }
+  // On failure, the port retries the lookup, and reports the error.
+  rtc::SocketAddress result;
+  if (resolver->GetError() == 0 &&
+      resolver->GetResolvedAddress(family, &result)) {
+    // Keeps the hostname, which TLS needs.
+    resolved->SetResolvedIP(result.ipaddr());
+  }
+  return true;
+}
+
+void BasicPortAllocatorSession::UpdateGatheringTimeline(const Candidate& c) {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  int64_t* first_candidate_ms = nullptr;
+  if (c.type() == LOCAL_PORT_TYPE) {
+    first_candidate_ms = &gathering_timeline_.first_host_candidate_ms;
+  } else if (c.type() == STUN_PORT_TYPE) {
+    first_candidate_ms = &gathering_timeline_.first_srflx_candidate_ms;
+  } else if (c.type() == RELAY_PORT_TYPE) {
+    first_candidate_ms = &gathering_timeline_.first_relay_candidate_ms;
+  }
+  if (first_candidate_ms && *first_candidate_ms < 0 &&
+      gathering_start_ms_ >= 0) {
+    *first_candidate_ms = rtc::TimeMillis() - gathering_start_ms_;
+  }
+}
+
+void BasicPortAllocatorSession::ReportGatheringTimeline() {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  if (gathering_start_ms_ < 0 || gathering_timeline_.done_ms >= 0) {
+    return;
+  }
+  gathering_timeline_.done_ms = rtc::TimeMillis() - gathering_start_ms_;
+  RTC_LOG(LS_INFO) << "Gathering timeline for " << content_name() << ":"
+                   << component() << ":" << generation()
+                   << ": first host candidate "
+                   << gathering_timeline_.first_host_candidate_ms
+                   << " ms, first srflx candidate "
+                   << gathering_timeline_.first_srflx_candidate_ms
+                   << " ms, first relay candidate "
+                   << gathering_timeline_.first_relay_candidate_ms
+                   << " ms, done " << gathering_timeline_.done_ms << " ms";
+
+  // Regathering is left out, since its timing mostly depends on the reason.
+  if (gathering_timeline_reported_) {
+    return;
+  }
+  gathering_timeline_reported_ = true;
+  if (gathering_timeline_.first_host_candidate_ms >= 0) {
+    RTC_HISTOGRAM_COUNTS_10000(
+        "WebRTC.PeerConnection.IceGathering.TimeToFirstHostCandidate",
+        gathering_timeline_.first_host_candidate_ms);
+  }
+  if (gathering_timeline_.first_srflx_candidate_ms >= 0) {
+    RTC_HISTOGRAM_COUNTS_10000(
+        "WebRTC.PeerConnection.IceGathering.TimeToFirstSrflxCandidate",
+        gathering_timeline_.first_srflx_candidate_ms);
+  }
+  if (gathering_timeline_.first_relay_candidate_ms >= 0) {
+    RTC_HISTOGRAM_COUNTS_10000(
+        "WebRTC.PeerConnection.IceGathering.TimeToFirstRelayCandidate",
+        gathering_timeline_.first_relay_candidate_ms);
+  }
+  RTC_HISTOGRAM_COUNTS_100000("WebRTC.PeerConnection.IceGathering.TimeToDone",
+                              gathering_timeline_.done_ms);
+}
+
 BasicPortAllocatorSession::PortData* BasicPortAllocatorSession::FindPort(
     Port* port) {
   RTC_DCHECK_RUN_ON(network_thread_);
@@ -1366,6 +1505,11 @@ void AllocationSequence::OnMessage(rtc::Message* msg) {
   RTC_DCHECK(rtc::Thread::Current() == session_->network_thread());
   RTC_DCHECK(msg->message_id == MSG_ALLOCATION_PHASE);
 
+  if (IsFlagSet(PORTALLOCATOR_ENABLE_PARALLEL_GATHERING)) {
+    CreateAllPorts();
+    return;
+  }
+
   const char* const PHASE_NAMES[kNumPhases] = {"Udp", "Relay", "Tcp"};
 
   // Perform all of the phases in the current step.
@@ -1404,6 +1548,39 @@ void AllocationSequence::OnMessage(rtc::Message* msg) {
   }
 }
 
+void AllocationSequence::CreateAllPorts() {
+  RTC_LOG(LS_INFO) << network_->ToString() << ": Allocation Phase=All";
+  // The relay candidates take the longest to gather, so their allocate
+  // requests go out first.
+  CreateRelayPorts();
+  CreateUDPPorts();
+  CreateStunPorts();
+  CreateTCPPorts();
+  phase_ = kNumPhases;
+
+  // Otherwise OnTurnServerResolved() completes the sequence.
+  if (pending_turn_servers_.empty()) {
+    state_ = kCompleted;
+    SignalPortAllocationComplete(this);
+  }
+}
+
+void AllocationSequence::OnTurnServerResolved() {
+  if (state_ != kRunning || pending_turn_servers_.empty()) {
+    return;
+  }
+  // The servers that are still being resolved are pending again.
+  std::vector<std::pair<const RelayServerConfig*, ProtocolAddress>> servers;
+  servers.swap(pending_turn_servers_);
+  for (const auto& server : servers) {
+    CreateTurnPort(*server.first, server.second);
+  }
+  if (pending_turn_servers_.empty()) {
+    state_ = kCompleted;
+    SignalPortAllocationComplete(this);
+  }
+}
+
 void AllocationSequence::CreateUDPPorts() {
   if (IsFlagSet(PORTALLOCATOR_DISABLE_UDP)) {
     RTC_LOG(LS_VERBOSE) << "AllocationSequence: UDP ports disabled, skipping.";
@@ -1565,65 +1742,77 @@ void AllocationSequence::CreateTurnPort(const RelayServerConfig& config) {
         relay_port->proto == PROTO_UDP) {
       continue;
     }
+    CreateTurnPort(config, *relay_port);
+  }
+}
 
-    // Do not create a port if the server address family is known and does
-    // not match the local IP address family.
-    int server_ip_family = relay_port->address.ipaddr().family();
-    int local_ip_family = network_->GetBestIP().family();
-    if (server_ip_family != AF_UNSPEC && server_ip_family != local_ip_family) {
-      RTC_LOG(LS_INFO)
-          << "Server and local address families are not compatible. "
-             "Server address: "
-          << relay_port->address.ipaddr().ToString()
-          << " Local address: " << network_->GetBestIP().ToString();
-      continue;
-    }
+void AllocationSequence::CreateTurnPort(const RelayServerConfig& config,
+                                        const ProtocolAddress& server_address) {
+  ProtocolAddress relay_port = server_address;
+  if (IsFlagSet(PORTALLOCATOR_ENABLE_PARALLEL_GATHERING) &&
+      !session_->GetResolvedTurnServerAddress(server_address.address,
+                                              network_->GetBestIP().family(),
+                                              &relay_port.address)) {
+    pending_turn_servers_.push_back(std::make_pair(&config, server_address));
+    return;
+  }
 
-    CreateRelayPortArgs args;
-    args.network_thread = session_->network_thread();
-    args.socket_factory = session_->socket_factory();
-    args.network = network_;
-    args.username = session_->username();
-    args.password = session_->password();
-    args.server_address = &(*relay_port);
-    args.config = &config;
-    args.origin = session_->allocator()->origin();
-    args.turn_customizer = session_->allocator()->turn_customizer();
-
-    std::unique_ptr<cricket::Port> port;
-    // Shared socket mode must be enabled only for UDP based ports. Hence
-    // don't pass shared socket for ports which will create TCP sockets.
-    // TODO(mallinath) - Enable shared socket mode for TURN ports. Disabled
-    // due to webrtc bug https://code.google.com/p/webrtc/issues/detail?id=3537
-    if (IsFlagSet(PORTALLOCATOR_ENABLE_SHARED_SOCKET) &&
-        relay_port->proto == PROTO_UDP && udp_socket_) {
-      port = session_->allocator()->relay_port_factory()->Create(
-          args, udp_socket_.get());
-
-      if (!port) {
-        RTC_LOG(LS_WARNING) << "Failed to create relay port with "
-                            << args.server_address->address.ToString();
-        continue;
-      }
+  // Do not create a port if the server address family is known and does
+  // not match the local IP address family.
+  int server_ip_family = relay_port.address.ipaddr().family();
+  int local_ip_family = network_->GetBestIP().family();
+  if (server_ip_family != AF_UNSPEC && server_ip_family != local_ip_family) {
+    RTC_LOG(LS_INFO) << "Server and local address families are not compatible. "
+                        "Server address: "
+                     << relay_port.address.ipaddr().ToString()
+                     << " Local address: " << network_->GetBestIP().ToString();
+    return;
+  }
 
-      relay_ports_.push_back(port.get());
-      // Listen to the port destroyed signal, to allow AllocationSequence to
-      // remove entrt from it's map.
-      port->SignalDestroyed.connect(this, &AllocationSequence::OnPortDestroyed);
-    } else {
-      port = session_->allocator()->relay_port_factory()->Create(
-          args, session_->allocator()->min_port(),
-          session_->allocator()->max_port());
+  CreateRelayPortArgs args;
+  args.network_thread = session_->network_thread();
+  args.socket_factory = session_->socket_factory();
+  args.network = network_;
+  args.username = session_->username();
+  args.password = session_->password();
+  args.server_address = &relay_port;
+  args.config = &config;
+  args.origin = session_->allocator()->origin();
+  args.turn_customizer = session_->allocator()->turn_customizer();
+
+  std::unique_ptr<cricket::Port> port;
+  // Shared socket mode must be enabled only for UDP based ports. Hence
+  // don't pass shared socket for ports which will create TCP sockets.
+  // TODO(mallinath) - Enable shared socket mode for TURN ports. Disabled
+  // due to webrtc bug https://code.google.com/p/webrtc/issues/detail?id=3537
+  if (IsFlagSet(PORTALLOCATOR_ENABLE_SHARED_SOCKET) &&
+      relay_port.proto == PROTO_UDP && udp_socket_) {
+    port = session_->allocator()->relay_port_factory()->Create(
+        args, udp_socket_.get());
+
+    if (!port) {
+      RTC_LOG(LS_WARNING) << "Failed to create relay port with "
+                          << args.server_address->address.ToString();
+      return;
+    }
 
-      if (!port) {
-        RTC_LOG(LS_WARNING) << "Failed to create relay port with "
-                            << args.server_address->address.ToString();
-        continue;
-      }
+    relay_ports_.push_back(port.get());
+    // Listen to the port destroyed signal, to allow AllocationSequence to
+    // remove entrt from it's map.
+    port->SignalDestroyed.connect(this, &AllocationSequence::OnPortDestroyed);
+  } else {
+    port = session_->allocator()->relay_port_factory()->Create(
+        args, session_->allocator()->min_port(),
+        session_->allocator()->max_port());
+
+    if (!port) {
+      RTC_LOG(LS_WARNING) << "Failed to create relay port with "
+                          << args.server_address->address.ToString();
+      return;
     }
-    RTC_DCHECK(port != NULL);
-    session_->AddAllocatedPort(port.release(), this, true);
   }
+  RTC_DCHECK(port != NULL);
+  session_->AddAllocatedPort(port.release(), this, true);
 }
 
 void AllocationSequence::OnReadPacket(rtc::AsyncPacketSocket* socket,
@@ -11,10 +11,13 @@
 #ifndef P2P_CLIENT_BASIC_PORT_ALLOCATOR_H_
 #define P2P_CLIENT_BASIC_PORT_ALLOCATOR_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "api/async_resolver_factory.h"
 #include "api/turn_customizer.h"
 #include "p2p/base/port_allocator.h"
 #include "p2p/client/relay_port_factory_interface.h"
@@ -79,6 +82,19 @@ class RTC_EXPORT BasicPortAllocator : public PortAllocator {
     return relay_port_factory_;
   }
 
+  // Creates the resolvers of the TURN server hostnames with
+  // PORTALLOCATOR_ENABLE_PARALLEL_GATHERING. If null, they come from the
+  // socket factory. Must outlive the allocator.
+  void set_async_resolver_factory(
+      webrtc::AsyncResolverFactory* async_resolver_factory) {
+    CheckRunOnValidThreadIfInitialized();
+    async_resolver_factory_ = async_resolver_factory;
+  }
+  webrtc::AsyncResolverFactory* async_resolver_factory() {
+    CheckRunOnValidThreadIfInitialized();
+    return async_resolver_factory_;
+  }
+
  private:
   void Construct();
 
@@ -98,6 +114,8 @@ class RTC_EXPORT BasicPortAllocator : public PortAllocator {
 
   // This instance is created if caller does pass a factory.
   std::unique_ptr<RelayPortFactoryInterface> default_relay_port_factory_;
+
+  webrtc::AsyncResolverFactory* async_resolver_factory_ = nullptr;
 };
 
 struct PortConfiguration;
@@ -114,6 +132,16 @@ enum class SessionState {
 class RTC_EXPORT BasicPortAllocatorSession : public PortAllocatorSession,
                                              public rtc::MessageHandler {
  public:
+  // When the first candidate of each type was gathered, and when gathering
+  // completed, in milliseconds since gathering started, or -1 if it didn't
+  // happen yet.
+  struct GatheringTimeline {
+    int64_t first_host_candidate_ms = -1;
+    int64_t first_srflx_candidate_ms = -1;
+    int64_t first_relay_candidate_ms = -1;
+    int64_t done_ms = -1;
+  };
+
   BasicPortAllocatorSession(BasicPortAllocator* allocator,
                             const std::string& content_name,
                             int component,
@@ -151,6 +179,12 @@ class RTC_EXPORT BasicPortAllocatorSession : public PortAllocatorSession,
       const absl::optional<int>& stun_keepalive_interval) override;
   void PruneAllPorts() override;
 
+  // Reset each time gathering starts. Also logged, and reported to UMA the
+  // first time, once gathering is done.
+  const GatheringTimeline& gathering_timeline() const {
+    return gathering_timeline_;
+  }
+
  protected:
   void UpdateIceParametersInternal() override;
 
@@ -244,6 +278,19 @@ class RTC_EXPORT BasicPortAllocatorSession : public PortAllocatorSession,
                 bool disable_equivalent_phases,
                 IceRegatheringReason reason);
 
+  // With PORTALLOCATOR_ENABLE_PARALLEL_GATHERING, starts resolving the TURN
+  // server hostnames that aren't resolved or being resolved yet.
+  void ResolveTurnServers();
+  void OnTurnServerResolved(rtc::AsyncResolverInterface* resolver);
+  // Sets |resolved| to |address|, with the IP of |family| that its hostname
+  // was resolved to, if it was. Returns false if the hostname is still being
+  // resolved.
+  bool GetResolvedTurnServerAddress(const rtc::SocketAddress& address,
+                                    int family,
+                                    rtc::SocketAddress* resolved) const;
+  void UpdateGatheringTimeline(const Candidate& c);
+  void ReportGatheringTimeline();
+
   bool CheckCandidateFilter(const Candidate& c) const;
   bool CandidatePairable(const Candidate& c, const Port* port) const;
 
@@ -283,6 +330,12 @@ class RTC_EXPORT BasicPortAllocatorSession : public PortAllocatorSession,
   // Whether to prune low-priority ports, taken from the port allocator.
   bool prune_turn_ports_;
   SessionState state_ = SessionState::CLEARED;
+  // The resolvers of the TURN server hostnames, and whether they are done.
+  std::map<std::string, std::pair<rtc::AsyncResolverInterface*, bool>>
+      turn_server_resolvers_;
+  int64_t gathering_start_ms_ = -1;
+  GatheringTimeline gathering_timeline_;
+  bool gathering_timeline_reported_ = false;
 
   friend class AllocationSequence;
 };
@@ -372,6 +425,10 @@ class AllocationSequence : public rtc::MessageHandler,
   // MessageHandler
   void OnMessage(rtc::Message* msg) override;
 
+  // Creates the relay ports whose TURN server hostname was resolved since
+  // they were deferred.
+  void OnTurnServerResolved();
+
   // Signal from AllocationSequence, when it's done with allocating ports.
   // This signal is useful, when port allocation fails which doesn't result
   // in any candidates. Using this signal BasicPortAllocatorSession can send
@@ -388,11 +445,14 @@ class AllocationSequence : public rtc::MessageHandler,
   typedef std::vector<ProtocolType> ProtocolList;
 
   bool IsFlagSet(uint32_t flag) { return ((flags_ & flag) != 0); }
+  void CreateAllPorts();
   void CreateUDPPorts();
   void CreateTCPPorts();
   void CreateStunPorts();
   void CreateRelayPorts();
   void CreateGturnPort(const RelayServerConfig& config);
+  void CreateTurnPort(const RelayServerConfig& config,
+                      const ProtocolAddress& server_address);
 
   void OnReadPacket(rtc::AsyncPacketSocket* socket,
                     const char* data,
@@ -415,6 +475,10 @@ class AllocationSequence : public rtc::MessageHandler,
   // There will be only one udp port per AllocationSequence.
   UDPPort* udp_port_;
   std::vector<Port*> relay_ports_;
+  // With PORTALLOCATOR_ENABLE_PARALLEL_GATHERING, the TURN servers whose
+  // hostname is still being resolved.
+  std::vector<std::pair<const RelayServerConfig*, ProtocolAddress>>
+      pending_turn_servers_;
   int phase_;
 };
 
@@ -13,6 +13,7 @@
 
 #include "absl/algorithm/container.h"
 #include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/mock_async_resolver.h"
 #include "p2p/base/p2p_constants.h"
 #include "p2p/base/stun_port.h"
 #include "p2p/base/stun_request.h"
@@ -46,8 +47,13 @@
 
 using rtc::IPAddress;
 using rtc::SocketAddress;
+using ::testing::_;
 using ::testing::Contains;
+using ::testing::DoAll;
+using ::testing::NiceMock;
 using ::testing::Not;
+using ::testing::Return;
+using ::testing::SetArgPointee;
 
 #define MAYBE_SKIP_IPV4                        \
   if (!rtc::HasIPv4Enabled()) {                \
@@ -1169,6 +1175,77 @@ TEST_F(BasicPortAllocatorTest, TestGetAllPortsWithOneSecondStepDelay) {
   session_->StopGettingPorts();
 }
 
+// Tests that with parallel gathering, all phases are allocated at once, before
+// the first step delay.
+TEST_F(BasicPortAllocatorTest, TestGetAllPortsInParallel) {
+  AddInterface(kClientAddr);
+  allocator_->set_step_delay(kDefaultStepDelay);
+  ASSERT_TRUE(CreateSession(ICE_CANDIDATE_COMPONENT_RTP));
+  session_->set_flags(session_->flags() |
+                      PORTALLOCATOR_ENABLE_PARALLEL_GATHERING);
+  session_->StartGettingPorts();
+  EXPECT_EQ_SIMULATED_WAIT(4U, ports_.size(), 1, fake_clock);
+  ASSERT_TRUE_SIMULATED_WAIT(candidate_allocation_done_, kDefaultStepDelay - 1,
+                             fake_clock);
+  EXPECT_EQ(7U, candidates_.size());
+  EXPECT_TRUE(HasCandidate(candidates_, "local", "udp", kClientAddr));
+  EXPECT_TRUE(HasCandidate(candidates_, "stun", "udp", kClientAddr));
+  EXPECT_TRUE(HasCandidate(candidates_, "relay", "udp", kRelayUdpIntAddr));
+  EXPECT_TRUE(HasCandidate(candidates_, "local", "tcp", kClientAddr));
+
+  const BasicPortAllocatorSession::GatheringTimeline& timeline =
+      static_cast<BasicPortAllocatorSession*>(session_.get())
+          ->gathering_timeline();
+  EXPECT_GE(timeline.first_host_candidate_ms, 0);
+  EXPECT_GE(timeline.first_srflx_candidate_ms, 0);
+  EXPECT_GE(timeline.first_relay_candidate_ms, 0);
+  EXPECT_GE(timeline.done_ms, timeline.first_relay_candidate_ms);
+  EXPECT_EQ(1, webrtc::metrics::NumSamples(
+                   "WebRTC.PeerConnection.IceGathering.TimeToFirstRelayCandidate"));
+}
+
+// Tests that with parallel gathering, the hostname of a TURN server is
+// resolved once for all networks, and that the relay ports wait for it while
+// the other ports are gathering.
+TEST_F(BasicPortAllocatorTest, TestParallelGatheringResolvesTurnServerOnce) {
+  AddInterface(kClientAddr, "net1");
+  AddInterface(kClientAddr2, "net2");
+  ResetWithNoServersOrNat();
+  NiceMock<rtc::MockAsyncResolver> resolver;
+  // Resolved when the test signals it.
+  EXPECT_CALL(resolver, Start(_)).WillOnce(Return());
+  EXPECT_CALL(resolver, GetError()).WillRepeatedly(Return(0));
+  EXPECT_CALL(resolver, GetResolvedAddress(AF_INET, _))
+      .WillRepeatedly(
+          DoAll(SetArgPointee<1>(kTurnUdpIntAddr), Return(true)));
+  webrtc::MockAsyncResolverFactory resolver_factory;
+  EXPECT_CALL(resolver_factory, Create()).WillOnce(Return(&resolver));
+  allocator_->set_async_resolver_factory(&resolver_factory);
+  AddTurnServers(rtc::SocketAddress("turn.example.org", kTurnUdpIntAddr.port()),
+                 rtc::SocketAddress());
+
+  ASSERT_TRUE(CreateSession(ICE_CANDIDATE_COMPONENT_RTP));
+  session_->set_flags(session_->flags() | PORTALLOCATOR_DISABLE_TCP |
+                      PORTALLOCATOR_ENABLE_PARALLEL_GATHERING);
+  session_->StartGettingPorts();
+  // The UDP ports of both networks.
+  EXPECT_EQ_SIMULATED_WAIT(2U, ports_.size(), kDefaultAllocationTimeout,
+                           fake_clock);
+  SIMULATED_WAIT(false, 100, fake_clock);
+  EXPECT_EQ(2U, ports_.size());
+  EXPECT_FALSE(candidate_allocation_done_);
+
+  resolver.SignalDone(&resolver);
+  ASSERT_TRUE_SIMULATED_WAIT(candidate_allocation_done_,
+                             kDefaultAllocationTimeout, fake_clock);
+  EXPECT_EQ(4U, ports_.size());
+  EXPECT_EQ(2, absl::c_count_if(candidates_, [](const Candidate& c) {
+              return c.type() == RELAY_PORT_TYPE;
+            }));
+  // The session destroys the resolver.
+  session_.reset();
+}
+
 TEST_F(BasicPortAllocatorTest, TestSetupVideoRtpPortsWithNormalSendBuffers) {
   AddInterface(kClientAddr);
   ASSERT_TRUE(CreateSession(ICE_CANDIDATE_COMPONENT_RTP, CN_VIDEO));
@@ -159,6 +159,7 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
     const cricket::MediaConfig& media_config,
     webrtc::RtpTransportInternal* rtp_transport,
     webrtc::MediaTransportInterface* media_transport,
+    rtc::Thread* network_thread,
     rtc::Thread* signaling_thread,
     const std::string& content_name,
     bool srtp_required,
@@ -167,9 +168,10 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
     const AudioOptions& options) {
   if (!worker_thread_->IsCurrent()) {
     return worker_thread_->Invoke<VoiceChannel*>(RTC_FROM_HERE, [&] {
-      return CreateVoiceChannel(
-          call, media_config, rtp_transport, media_transport, signaling_thread,
-          content_name, srtp_required, crypto_options, ssrc_generator, options);
+      return CreateVoiceChannel(call, media_config, rtp_transport,
+                                media_transport, network_thread,
+                                signaling_thread, content_name, srtp_required,
+                                crypto_options, ssrc_generator, options);
     });
   }
 
@@ -187,7 +189,7 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
   }
 
   auto voice_channel = absl::make_unique<VoiceChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread, signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -228,6 +230,7 @@ VideoChannel* ChannelManager::CreateVideoChannel(
     const cricket::MediaConfig& media_config,
     webrtc::RtpTransportInternal* rtp_transport,
     webrtc::MediaTransportInterface* media_transport,
+    rtc::Thread* network_thread,
     rtc::Thread* signaling_thread,
     const std::string& content_name,
     bool srtp_required,
@@ -237,10 +240,10 @@ VideoChannel* ChannelManager::CreateVideoChannel(
     webrtc::VideoBitrateAllocatorFactory* video_bitrate_allocator_factory) {
   if (!worker_thread_->IsCurrent()) {
     return worker_thread_->Invoke<VideoChannel*>(RTC_FROM_HERE, [&] {
-      return CreateVideoChannel(call, media_config, rtp_transport,
-                                media_transport, signaling_thread, content_name,
-                                srtp_required, crypto_options, ssrc_generator,
-                                options, video_bitrate_allocator_factory);
+      return CreateVideoChannel(
+          call, media_config, rtp_transport, media_transport, network_thread,
+          signaling_thread, content_name, srtp_required, crypto_options,
+          ssrc_generator, options, video_bitrate_allocator_factory);
     });
   }
 
@@ -259,7 +262,7 @@ VideoChannel* ChannelManager::CreateVideoChannel(
   }
 
   auto video_channel = absl::make_unique<VideoChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread, signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -298,6 +301,7 @@ void ChannelManager::DestroyVideoChannel(VideoChannel* video_channel) {
 RtpDataChannel* ChannelManager::CreateRtpDataChannel(
     const cricket::MediaConfig& media_config,
     webrtc::RtpTransportInternal* rtp_transport,
+    rtc::Thread* network_thread,
     rtc::Thread* signaling_thread,
     const std::string& content_name,
     bool srtp_required,
@@ -305,8 +309,9 @@ RtpDataChannel* ChannelManager::CreateRtpDataChannel(
     rtc::UniqueRandomIdGenerator* ssrc_generator) {
   if (!worker_thread_->IsCurrent()) {
     return worker_thread_->Invoke<RtpDataChannel*>(RTC_FROM_HERE, [&] {
-      return CreateRtpDataChannel(media_config, rtp_transport, signaling_thread,
-                                  content_name, srtp_required, crypto_options,
+      return CreateRtpDataChannel(media_config, rtp_transport, network_thread,
+                                  signaling_thread, content_name,
+                                  srtp_required, crypto_options,
                                   ssrc_generator);
     });
   }
@@ -320,7 +325,7 @@ RtpDataChannel* ChannelManager::CreateRtpDataChannel(
   }
 
   auto data_channel = absl::make_unique<RtpDataChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread, signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
   data_channel->Init_w(rtp_transport);
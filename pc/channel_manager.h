@@ -96,6 +96,7 @@ class ChannelManager final {
       const cricket::MediaConfig& media_config,
       webrtc::RtpTransportInternal* rtp_transport,
       webrtc::MediaTransportInterface* media_transport,
+      rtc::Thread* network_thread,
       rtc::Thread* signaling_thread,
       const std::string& content_name,
       bool srtp_required,
@@ -113,6 +114,7 @@ class ChannelManager final {
       const cricket::MediaConfig& media_config,
       webrtc::RtpTransportInternal* rtp_transport,
       webrtc::MediaTransportInterface* media_transport,
+      rtc::Thread* network_thread,
       rtc::Thread* signaling_thread,
       const std::string& content_name,
       bool srtp_required,
@@ -126,6 +128,7 @@ class ChannelManager final {
   RtpDataChannel* CreateRtpDataChannel(
       const cricket::MediaConfig& media_config,
       webrtc::RtpTransportInternal* rtp_transport,
+      rtc::Thread* network_thread,
       rtc::Thread* signaling_thread,
       const std::string& content_name,
       bool srtp_required,
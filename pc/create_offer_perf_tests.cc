@@ -0,0 +1,93 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/audio_codecs/builtin_audio_decoder_factory.h"
+#include "api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "api/create_peerconnection_factory.h"
+#include "api/video_codecs/builtin_video_decoder_factory.h"
+#include "api/video_codecs/builtin_video_encoder_factory.h"
+#include "p2p/base/fake_port_allocator.h"
+#include "pc/peer_connection_wrapper.h"
+#include "pc/test/fake_audio_capture_module.h"
+#include "pc/test/mock_peer_connection_observers.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_base/virtual_socket_server.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kNumPeerConnections = 50;
+constexpr int kPoolSize = 4;
+// The time between PeerConnections, enough for the pool to refill.
+constexpr int kIdleMs = 100;
+
+// Creates |kNumPeerConnections| PeerConnections one after the other, and
+// prints the time from creating each until its first offer is created, which
+// includes waiting for its certificate. The PeerConnections are created
+// |kIdleMs| apart, as when they are created on user action.
+void MeasureTimeToFirstOffer(const std::string& trace, int pool_size) {
+  rtc::VirtualSocketServer socket_server;
+  rtc::AutoSocketServerThread main_thread(&socket_server);
+  std::unique_ptr<rtc::Thread> network_thread = rtc::Thread::Create();
+  network_thread->Start();
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> pc_factory =
+      CreatePeerConnectionFactory(
+          network_thread.get(), rtc::Thread::Current(), rtc::Thread::Current(),
+          FakeAudioCaptureModule::Create(), CreateBuiltinAudioEncoderFactory(),
+          CreateBuiltinAudioDecoderFactory(),
+          CreateBuiltinVideoEncoderFactory(),
+          CreateBuiltinVideoDecoderFactory(), nullptr /* audio_mixer */,
+          nullptr /* audio_processing */);
+  ASSERT_TRUE(pc_factory);
+  PeerConnectionFactoryInterface::Options options;
+  options.certificate_pool_size = pool_size;
+  pc_factory->SetOptions(options);
+
+  std::vector<double> latencies_ms;
+  for (int i = 0; i < kNumPeerConnections; ++i) {
+    rtc::Thread::Current()->ProcessMessages(kIdleMs);
+    const int64_t start_us = rtc::TimeMicros();
+    auto observer = absl::make_unique<MockPeerConnectionObserver>();
+    auto pc = pc_factory->CreatePeerConnection(
+        PeerConnectionInterface::RTCConfiguration(),
+        absl::make_unique<cricket::FakePortAllocator>(network_thread.get(),
+                                                      nullptr),
+        nullptr, observer.get());
+    ASSERT_TRUE(pc);
+    observer->SetPeerConnectionInterface(pc.get());
+    PeerConnectionWrapper wrapper(pc_factory, pc, std::move(observer));
+    wrapper.AddAudioTrack("a");
+    wrapper.AddVideoTrack("v");
+    ASSERT_TRUE(wrapper.CreateOffer());
+    latencies_ms.push_back((rtc::TimeMicros() - start_us) /
+                           static_cast<double>(rtc::kNumMicrosecsPerMillisec));
+  }
+
+  webrtc::test::PrintResultList("create_offer", "_" + trace,
+                                "time_to_first_offer", latencies_ms, "ms",
+                                true);
+}
+
+}  // namespace
+
+TEST(CreateOfferPerfTest, TimeToFirstOfferWithAndWithoutCertificatePool) {
+  MeasureTimeToFirstOffer("generator", 0);
+  MeasureTimeToFirstOffer("certificate_pool", kPoolSize);
+}
+
+}  // namespace webrtc
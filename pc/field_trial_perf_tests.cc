@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/audio_codecs/builtin_audio_decoder_factory.h"
+#include "api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "api/create_peerconnection_factory.h"
+#include "api/video_codecs/builtin_video_decoder_factory.h"
+#include "api/video_codecs/builtin_video_encoder_factory.h"
+#include "p2p/base/fake_port_allocator.h"
+#include "pc/peer_connection_wrapper.h"
+#include "pc/test/fake_audio_capture_module.h"
+#include "pc/test/mock_peer_connection_observers.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/experiments/rate_control_settings.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_base/virtual_socket_server.h"
+#include "system_wrappers/include/field_trial.h"
+#include "test/field_trial.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kTrialsSize = 2048;
+constexpr int kNumLookups = 100000;
+constexpr int kNumPeerConnectionPairs = 20;
+
+const char kRateControlTrials[] =
+    "WebRTC-CongestionWindow/QueueSize:350,MinBitrate:30000/"
+    "WebRTC-VideoRateControl/alr_probing:true/";
+
+// A trials string like the one of a browser taking part in many experiments,
+// with the trials that WebRTC looks up last.
+std::string TwoKilobyteTrials() {
+  std::string trials;
+  int i = 0;
+  while (trials.size() + 64 < kTrialsSize - sizeof(kRateControlTrials)) {
+    trials += "WebRTC-UnrelatedExperiment" + std::to_string(i++) +
+              "/Enabled-100,200,0.5/";
+  }
+  trials += kRateControlTrials;
+  return trials;
+}
+
+void PrintCpuTimePerCall(const std::string& trace,
+                         int64_t cpu_time_ns,
+                         int num_calls) {
+  webrtc::test::PrintResult("field_trial", "", trace,
+                            static_cast<double>(cpu_time_ns) / num_calls,
+                            "ns/call", false);
+}
+
+// Creates |kNumPeerConnectionPairs| pairs of PeerConnections sending audio and
+// video, and prints the time it takes to create each pair and to negotiate
+// between them, which creates the send and receive streams.
+void MeasurePeerConnectionCreation(const std::string& trace) {
+  rtc::VirtualSocketServer socket_server;
+  rtc::AutoSocketServerThread main_thread(&socket_server);
+  std::unique_ptr<rtc::Thread> network_thread = rtc::Thread::Create();
+  network_thread->Start();
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> pc_factory =
+      CreatePeerConnectionFactory(
+          network_thread.get(), rtc::Thread::Current(), rtc::Thread::Current(),
+          FakeAudioCaptureModule::Create(), CreateBuiltinAudioEncoderFactory(),
+          CreateBuiltinAudioDecoderFactory(),
+          CreateBuiltinVideoEncoderFactory(),
+          CreateBuiltinVideoDecoderFactory(), nullptr /* audio_mixer */,
+          nullptr /* audio_processing */);
+  ASSERT_TRUE(pc_factory);
+
+  auto create_peer_connection = [&] {
+    auto observer = absl::make_unique<MockPeerConnectionObserver>();
+    auto pc = pc_factory->CreatePeerConnection(
+        PeerConnectionInterface::RTCConfiguration(),
+        absl::make_unique<cricket::FakePortAllocator>(network_thread.get(),
+                                                      nullptr),
+        nullptr, observer.get());
+    observer->SetPeerConnectionInterface(pc.get());
+    return absl::make_unique<PeerConnectionWrapper>(pc_factory, pc,
+                                                    std::move(observer));
+  };
+
+  std::vector<double> create_ms;
+  std::vector<double> negotiate_ms;
+  for (int i = 0; i < kNumPeerConnectionPairs; ++i) {
+    int64_t start_us = rtc::TimeMicros();
+    std::unique_ptr<PeerConnectionWrapper> caller = create_peer_connection();
+    std::unique_ptr<PeerConnectionWrapper> callee = create_peer_connection();
+    caller->AddAudioTrack("a");
+    caller->AddVideoTrack("v");
+    create_ms.push_back((rtc::TimeMicros() - start_us) /
+                        static_cast<double>(rtc::kNumMicrosecsPerMillisec));
+
+    start_us = rtc::TimeMicros();
+    ASSERT_TRUE(caller->ExchangeOfferAnswerWith(callee.get()));
+    negotiate_ms.push_back((rtc::TimeMicros() - start_us) /
+                           static_cast<double>(rtc::kNumMicrosecsPerMillisec));
+  }
+
+  webrtc::test::PrintResultList("peer_connection", "_" + trace,
+                                "create_pair", create_ms, "ms", false);
+  webrtc::test::PrintResultList("peer_connection", "_" + trace,
+                                "negotiate_pair", negotiate_ms, "ms", false);
+}
+
+}  // namespace
+
+TEST(FieldTrialPerfTest, FindFullName) {
+  test::ScopedFieldTrials field_trials(TwoKilobyteTrials());
+  size_t total_size = 0;
+  const int64_t start_ns = rtc::GetThreadCpuTimeNanos();
+  for (int i = 0; i < kNumLookups; ++i)
+    total_size += field_trial::FindFullName("WebRTC-VideoRateControl").size();
+  PrintCpuTimePerCall("find_full_name", rtc::GetThreadCpuTimeNanos() - start_ns,
+                      kNumLookups);
+  EXPECT_GT(total_size, 0u);
+}
+
+// Each video send stream and encoder parses the rate control settings, some
+// of them more than once.
+TEST(FieldTrialPerfTest, ParseRateControlSettings) {
+  test::ScopedFieldTrials field_trials(TwoKilobyteTrials());
+  int num_alr_probing = 0;
+  const int64_t start_ns = rtc::GetThreadCpuTimeNanos();
+  for (int i = 0; i < kNumLookups; ++i) {
+    if (RateControlSettings::ParseFromFieldTrials().UseAlrProbing())
+      ++num_alr_probing;
+  }
+  PrintCpuTimePerCall("parse_rate_control_settings",
+                      rtc::GetThreadCpuTimeNanos() - start_ns, kNumLookups);
+  EXPECT_EQ(kNumLookups, num_alr_probing);
+}
+
+TEST(FieldTrialPerfTest, PeerConnectionCreation) {
+  MeasurePeerConnectionCreation("no_trials");
+  test::ScopedFieldTrials field_trials(TwoKilobyteTrials());
+  MeasurePeerConnectionCreation("2kb_trials");
+}
+
+}  // namespace webrtc
@@ -455,8 +455,11 @@ JsepTransportController::CreateDtlsTransport(
     dtls = config_.external_transport_factory->CreateDtlsTransport(
         std::move(ice), config_.crypto_options);
   } else {
-    dtls = absl::make_unique<cricket::DtlsTransport>(
+    auto dtls_transport = absl::make_unique<cricket::DtlsTransport>(
         std::move(ice), config_.crypto_options, config_.event_log);
+    dtls_transport->SetSessionCache(config_.dtls_session_cache);
+    dtls_transport->SetEarlyHandshake(config_.early_dtls_handshake);
+    dtls = std::move(dtls_transport);
   }
 
   RTC_DCHECK(dtls);
@@ -83,6 +83,14 @@ class JsepTransportController : public sigslot::has_slots<> {
     bool active_reset_srtp_params = false;
     RtcEventLog* event_log = nullptr;
 
+    // If set, the DTLS transports resume the sessions in this cache when the
+    // remote certificate matches, and add theirs to it. Must outlive the
+    // controller.
+    rtc::SSLSessionCache* dtls_session_cache = nullptr;
+    // Whether the DTLS transports start the handshake before ICE is writable,
+    // and send its first flight on the first writable candidate pair.
+    bool early_dtls_handshake = false;
+
     // Whether media transport is used for media.
     bool use_media_transport_for_media = false;
 
@@ -0,0 +1,236 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/audio_codecs/builtin_audio_decoder_factory.h"
+#include "api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "api/call/call_factory_interface.h"
+#include "api/jsep.h"
+#include "api/peer_connection_interface.h"
+#include "api/stats/rtcstats_objects.h"
+#include "api/video_codecs/builtin_video_decoder_factory.h"
+#include "api/video_codecs/builtin_video_encoder_factory.h"
+#include "media/engine/webrtc_media_engine.h"
+#include "modules/audio_processing/include/audio_processing.h"
+#include "pc/peer_connection_wrapper.h"
+#include "pc/test/fake_audio_capture_module.h"
+#include "pc/test/mock_peer_connection_observers.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/network_constants.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kNumPeerConnectionPairs = 500;
+constexpr int kConnectTimeoutMs = 60000;
+constexpr int kWarmupMs = 2000;
+constexpr int kMeasureMs = 10000;
+
+class PeerConnectionWrapperForScalingTest : public PeerConnectionWrapper {
+ public:
+  using PeerConnectionWrapper::PeerConnectionWrapper;
+
+  // Adds |candidates| as if signaled, through SDP. That leaves out what only
+  // the gathering side knows, such as the network type.
+  void AddIceCandidates(std::vector<const IceCandidateInterface*> candidates) {
+    for (const auto* candidate : candidates) {
+      std::string sdp;
+      RTC_CHECK(candidate->ToString(&sdp));
+      std::unique_ptr<IceCandidateInterface> signaled_candidate(
+          CreateIceCandidate(candidate->sdp_mid(),
+                             candidate->sdp_mline_index(), sdp, nullptr));
+      RTC_CHECK(signaled_candidate);
+      pc()->AddIceCandidate(signaled_candidate.get());
+    }
+  }
+
+  int64_t PacketsReceived() {
+    int64_t packets_received = 0;
+    auto report = GetStats();
+    for (const auto* stats :
+         report->GetStatsOfType<RTCInboundRTPStreamStats>()) {
+      if (stats->packets_received.is_defined()) {
+        packets_received += *stats->packets_received;
+      }
+    }
+    return packets_received;
+  }
+};
+
+// Runs |kNumPeerConnectionPairs| pairs of PeerConnections, connected over
+// loopback and each sending audio to the other, on a factory with
+// |num_network_threads| network threads. Prints the rate of received packets,
+// and the CPU usage of the busiest network thread.
+class NetworkThreadScalingTest {
+ public:
+  explicit NetworkThreadScalingTest(int num_network_threads)
+      : worker_thread_(rtc::Thread::Create()) {
+    for (int i = 0; i < num_network_threads; ++i) {
+      network_threads_.push_back(rtc::Thread::CreateWithSocketServer());
+      network_threads_.back()->SetName("PCNetworkThread" + rtc::ToString(i),
+                                       nullptr);
+      RTC_CHECK(network_threads_.back()->Start());
+    }
+    worker_thread_->SetName("PCWorkerThread", nullptr);
+    RTC_CHECK(worker_thread_->Start());
+
+    PeerConnectionFactoryDependencies dependencies;
+    dependencies.network_thread = network_threads_[0].get();
+    for (size_t i = 1; i < network_threads_.size(); ++i) {
+      dependencies.additional_network_threads.push_back(
+          network_threads_[i].get());
+    }
+    dependencies.worker_thread = worker_thread_.get();
+    dependencies.signaling_thread = rtc::Thread::Current();
+    dependencies.media_engine = cricket::WebRtcMediaEngineFactory::Create(
+        FakeAudioCaptureModule::Create(), CreateBuiltinAudioEncoderFactory(),
+        CreateBuiltinAudioDecoderFactory(), CreateBuiltinVideoEncoderFactory(),
+        CreateBuiltinVideoDecoderFactory(), nullptr /* audio_mixer */,
+        AudioProcessingBuilder().Create());
+    dependencies.call_factory = CreateCallFactory();
+    pc_factory_ = CreateModularPeerConnectionFactory(std::move(dependencies));
+    RTC_CHECK(pc_factory_);
+    PeerConnectionFactoryInterface::Options options;
+    // Connect over loopback only. A mask of 0 would gather on every network
+    // too, and the TCP connections between all of them exhaust the file
+    // descriptors long before the last pair is connected.
+    options.network_ignore_mask = ~rtc::ADAPTER_TYPE_LOOPBACK;
+    pc_factory_->SetOptions(options);
+  }
+
+  ~NetworkThreadScalingTest() {
+    pcs_.clear();
+    pc_factory_ = nullptr;
+  }
+
+  void ConnectPairs() {
+    std::vector<std::pair<PeerConnectionWrapperForScalingTest*,
+                          PeerConnectionWrapperForScalingTest*>>
+        pairs;
+    // Without comfort noise, the silence of the fake audio device is sent at
+    // the full packet rate, whichever codec is negotiated.
+    PeerConnectionInterface::RTCOfferAnswerOptions options;
+    options.voice_activity_detection = false;
+    for (int i = 0; i < kNumPeerConnectionPairs; ++i) {
+      PeerConnectionWrapperForScalingTest* caller = CreatePeerConnection();
+      PeerConnectionWrapperForScalingTest* callee = CreatePeerConnection();
+      ASSERT_TRUE(caller && callee);
+      caller->AddAudioTrack("caller_audio");
+      callee->AddAudioTrack("callee_audio");
+      ASSERT_TRUE(caller->ExchangeOfferAnswerWith(callee, options, options));
+      pairs.emplace_back(caller, callee);
+    }
+    for (const auto& pair : pairs) {
+      ASSERT_TRUE_WAIT(pair.first->IsIceGatheringDone(), kConnectTimeoutMs);
+      ASSERT_TRUE_WAIT(pair.second->IsIceGatheringDone(), kConnectTimeoutMs);
+      pair.second->AddIceCandidates(
+          pair.first->observer()->GetAllCandidates());
+      pair.first->AddIceCandidates(
+          pair.second->observer()->GetAllCandidates());
+    }
+    for (const auto& pc : pcs_) {
+      ASSERT_TRUE_WAIT(pc->IsIceConnected(), kConnectTimeoutMs);
+    }
+  }
+
+  void Measure(const std::string& trace) {
+    rtc::Thread::Current()->ProcessMessages(kWarmupMs);
+    const int64_t start_packets = CountPacketsReceived();
+    const std::vector<int64_t> start_cpu_ns = GetNetworkThreadCpuTimes();
+    const int64_t start_ms = rtc::TimeMillis();
+    rtc::Thread::Current()->ProcessMessages(kMeasureMs);
+    const int64_t elapsed_ms = rtc::TimeMillis() - start_ms;
+    const std::vector<int64_t> end_cpu_ns = GetNetworkThreadCpuTimes();
+    const int64_t packets = CountPacketsReceived() - start_packets;
+
+    int64_t max_cpu_ns = 0;
+    for (size_t i = 0; i < end_cpu_ns.size(); ++i) {
+      max_cpu_ns = std::max(max_cpu_ns, end_cpu_ns[i] - start_cpu_ns[i]);
+    }
+    test::PrintResult("network_thread_scaling", "_" + trace,
+                      "packets_received", packets * 1000.0 / elapsed_ms,
+                      "packets/s", true);
+    test::PrintResult(
+        "network_thread_scaling", "_" + trace, "busiest_network_thread_cpu",
+        100.0 * max_cpu_ns / (elapsed_ms * rtc::kNumNanosecsPerMillisec), "%",
+        false);
+  }
+
+ private:
+  PeerConnectionWrapperForScalingTest* CreatePeerConnection() {
+    auto observer = absl::make_unique<MockPeerConnectionObserver>();
+    PeerConnectionInterface::RTCConfiguration config;
+    config.sdp_semantics = SdpSemantics::kUnifiedPlan;
+    config.tcp_candidate_policy =
+        PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+    auto pc = pc_factory_->CreatePeerConnection(config, nullptr, nullptr,
+                                                observer.get());
+    if (!pc) {
+      return nullptr;
+    }
+    observer->SetPeerConnectionInterface(pc.get());
+    pcs_.push_back(absl::make_unique<PeerConnectionWrapperForScalingTest>(
+        pc_factory_, pc, std::move(observer)));
+    return pcs_.back().get();
+  }
+
+  int64_t CountPacketsReceived() {
+    int64_t packets_received = 0;
+    for (const auto& pc : pcs_) {
+      packets_received += pc->PacketsReceived();
+    }
+    return packets_received;
+  }
+
+  std::vector<int64_t> GetNetworkThreadCpuTimes() {
+    std::vector<int64_t> cpu_times_ns;
+    for (const auto& thread : network_threads_) {
+      cpu_times_ns.push_back(thread->Invoke<int64_t>(
+          RTC_FROM_HERE, [] { return rtc::GetThreadCpuTimeNanos(); }));
+    }
+    return cpu_times_ns;
+  }
+
+  std::vector<std::unique_ptr<rtc::Thread>> network_threads_;
+  std::unique_ptr<rtc::Thread> worker_thread_;
+  // Uses the threads above, so it must be destroyed first.
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> pc_factory_;
+  std::vector<std::unique_ptr<PeerConnectionWrapperForScalingTest>> pcs_;
+};
+
+}  // namespace
+
+TEST(NetworkThreadScalingPerfTest, LoopbackPeerConnectionsWithAudio) {
+  rtc::LogMessage::LogToDebug(rtc::LS_WARNING);
+  for (int num_network_threads : {1, 2, 4, 8}) {
+    NetworkThreadScalingTest test(num_network_threads);
+    test.ConnectPairs();
+    if (::testing::Test::HasFatalFailure()) {
+      return;
+    }
+    test.Measure(rtc::ToString(num_network_threads) + "_network_threads");
+  }
+}
+
+}  // namespace webrtc
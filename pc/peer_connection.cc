@@ -762,6 +762,8 @@ bool PeerConnectionInterface::RTCConfiguration::operator==(
     SdpSemantics sdp_semantics;
     absl::optional<rtc::AdapterType> network_preference;
     bool active_reset_srtp_params;
+    bool enable_dtls_session_resumption;
+    bool early_dtls_handshake;
     bool use_media_transport;
     bool use_media_transport_for_data_channels;
     absl::optional<CryptoOptions> crypto_options;
@@ -819,6 +821,8 @@ bool PeerConnectionInterface::RTCConfiguration::operator==(
          sdp_semantics == o.sdp_semantics &&
          network_preference == o.network_preference &&
          active_reset_srtp_params == o.active_reset_srtp_params &&
+         enable_dtls_session_resumption == o.enable_dtls_session_resumption &&
+         early_dtls_handshake == o.early_dtls_handshake &&
          use_media_transport == o.use_media_transport &&
          use_media_transport_for_data_channels ==
              o.use_media_transport_for_data_channels &&
@@ -857,9 +861,11 @@ void ExtractSharedMediaSessionOptions(
 }
 
 PeerConnection::PeerConnection(PeerConnectionFactory* factory,
+                               rtc::Thread* network_thread,
                                std::unique_ptr<RtcEventLog> event_log,
                                std::unique_ptr<Call> call)
     : factory_(factory),
+      network_thread_(network_thread),
       event_log_(std::move(event_log)),
       event_log_ptr_(event_log_.get()),
       rtcp_cname_(GenerateRtcpCname()),
@@ -1020,6 +1026,10 @@ bool PeerConnection::Initialize(
   config.enable_external_auth = true;
 #endif
   config.active_reset_srtp_params = configuration.active_reset_srtp_params;
+  if (configuration.enable_dtls_session_resumption) {
+    config.dtls_session_cache = factory_->GetDtlsSessionCache(network_thread());
+  }
+  config.early_dtls_handshake = configuration.early_dtls_handshake;
 
   if (configuration.use_media_transport ||
       configuration.use_media_transport_for_data_channels) {
@@ -1072,7 +1082,8 @@ bool PeerConnection::Initialize(
   transport_controller_->SignalDtlsHandshakeError.connect(
       this, &PeerConnection::OnTransportControllerDtlsHandshakeError);
 
-  sctp_factory_ = factory_->CreateSctpTransportInternalFactory();
+  sctp_factory_ =
+      factory_->CreateSctpTransportInternalFactory(network_thread());
 
   stats_.reset(new StatsCollector(this));
   stats_collector_ = RTCStatsCollector::Create(this);
@@ -6302,8 +6313,8 @@ cricket::VoiceChannel* PeerConnection::CreateVoiceChannel(
 
   cricket::VoiceChannel* voice_channel = channel_manager()->CreateVoiceChannel(
       call_ptr_, configuration_.media_config, rtp_transport, media_transport,
-      signaling_thread(), mid, SrtpRequired(), GetCryptoOptions(),
-      &ssrc_generator_, audio_options_);
+      network_thread(), signaling_thread(), mid, SrtpRequired(),
+      GetCryptoOptions(), &ssrc_generator_, audio_options_);
   if (!voice_channel) {
     return nullptr;
   }
@@ -6327,8 +6338,9 @@ cricket::VideoChannel* PeerConnection::CreateVideoChannel(
 
   cricket::VideoChannel* video_channel = channel_manager()->CreateVideoChannel(
       call_ptr_, configuration_.media_config, rtp_transport, media_transport,
-      signaling_thread(), mid, SrtpRequired(), GetCryptoOptions(),
-      &ssrc_generator_, video_options_, video_bitrate_allocator_factory_.get());
+      network_thread(), signaling_thread(), mid, SrtpRequired(),
+      GetCryptoOptions(), &ssrc_generator_, video_options_,
+      video_bitrate_allocator_factory_.get());
   if (!video_channel) {
     return nullptr;
   }
@@ -6374,8 +6386,9 @@ bool PeerConnection::CreateDataChannel(const std::string& mid) {
     default:
       RtpTransportInternal* rtp_transport = GetRtpTransport(mid);
       rtp_data_channel_ = channel_manager()->CreateRtpDataChannel(
-          configuration_.media_config, rtp_transport, signaling_thread(), mid,
-          SrtpRequired(), GetCryptoOptions(), &ssrc_generator_);
+          configuration_.media_config, rtp_transport, network_thread(),
+          signaling_thread(), mid, SrtpRequired(), GetCryptoOptions(),
+          &ssrc_generator_);
       if (!rtp_data_channel_) {
         return false;
       }
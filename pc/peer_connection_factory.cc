@@ -10,6 +10,7 @@
 
 #include "pc/peer_connection_factory.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -22,6 +23,8 @@
 #include "api/network_state_predictor.h"
 #include "api/peer_connection_factory_proxy.h"
 #include "api/peer_connection_proxy.h"
+#include "api/task_queue/default_task_queue_factory.h"
+#include "api/task_queue/thread_placement_task_queue_factory.h"
 #include "api/turn_customizer.h"
 #include "api/video_track_source_proxy.h"
 #include "logging/rtc_event_log/rtc_event_log.h"
@@ -37,9 +40,28 @@
 #include "pc/video_track.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/thread_placement.h"
 #include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
+namespace {
+
+// Wraps |factory| to place its task queues with |policy|, if set. Without a
+// factory, Call would create its task queues with the global factory, so the
+// default factory is used instead.
+std::unique_ptr<TaskQueueFactory> PlaceTaskQueues(
+    std::unique_ptr<TaskQueueFactory> factory,
+    const ThreadPlacementPolicy* policy) {
+  if (!policy)
+    return factory;
+  if (!factory)
+    factory = CreateDefaultTaskQueueFactory();
+  return CreateThreadPlacementTaskQueueFactory(std::move(factory), policy);
+}
+
+}  // namespace
 
 rtc::scoped_refptr<PeerConnectionFactoryInterface>
 CreateModularPeerConnectionFactory(
@@ -112,7 +134,11 @@ PeerConnectionFactory::PeerConnectionFactory(
       network_thread_(dependencies.network_thread),
       worker_thread_(dependencies.worker_thread),
       signaling_thread_(dependencies.signaling_thread),
-      task_queue_factory_(std::move(dependencies.task_queue_factory)),
+      thread_placement_policy_(
+          std::move(dependencies.thread_placement_policy)),
+      task_queue_factory_(
+          PlaceTaskQueues(std::move(dependencies.task_queue_factory),
+                          thread_placement_policy_.get())),
       media_engine_(std::move(dependencies.media_engine)),
       call_factory_(std::move(dependencies.call_factory)),
       event_log_factory_(std::move(dependencies.event_log_factory)),
@@ -123,6 +149,11 @@ PeerConnectionFactory::PeerConnectionFactory(
           std::move(dependencies.network_controller_factory)),
       media_transport_factory_(
           std::move(dependencies.media_transport_factory)) {
+  for (rtc::Thread* thread : dependencies.additional_network_threads) {
+    RTC_DCHECK(thread);
+    additional_network_threads_.emplace_back(thread);
+  }
+
   if (!network_thread_) {
     owned_network_thread_ = rtc::Thread::CreateWithSocketServer();
     owned_network_thread_->SetName("pc_network_thread", nullptr);
@@ -148,6 +179,15 @@ PeerConnectionFactory::PeerConnectionFactory(
   }
 }
 
+PeerConnectionFactory::NetworkThreadContext::NetworkThreadContext(
+    rtc::Thread* thread)
+    : thread(thread) {}
+
+PeerConnectionFactory::NetworkThreadContext::NetworkThreadContext(
+    NetworkThreadContext&&) = default;
+
+PeerConnectionFactory::NetworkThreadContext::~NetworkThreadContext() = default;
+
 PeerConnectionFactory::~PeerConnectionFactory() {
   RTC_DCHECK(signaling_thread_->IsCurrent());
   channel_manager_.reset(nullptr);
@@ -156,6 +196,7 @@ PeerConnectionFactory::~PeerConnectionFactory() {
   // |default_socket_factory_| and |default_network_manager_|.
   default_socket_factory_ = nullptr;
   default_network_manager_ = nullptr;
+  additional_network_threads_.clear();
 
   if (wraps_current_thread_)
     rtc::ThreadManager::Instance()->UnwrapCurrentThread();
@@ -176,6 +217,29 @@ bool PeerConnectionFactory::Initialize() {
     return false;
   }
 
+  for (NetworkThreadContext& context : additional_network_threads_) {
+    context.network_manager = absl::make_unique<rtc::BasicNetworkManager>();
+    context.socket_factory =
+        absl::make_unique<rtc::BasicPacketSocketFactory>(context.thread);
+    // Like the ChannelManager does for |network_thread_|, do not allow
+    // invoking calls to other threads on the network threads.
+    if (!context.thread->IsCurrent()) {
+      context.thread->Invoke<void>(RTC_FROM_HERE, [&context] {
+        context.thread->DisallowBlockingCalls();
+      });
+    }
+  }
+
+  if (thread_placement_policy_) {
+    PlaceThread(signaling_thread_, "pc_signaling_thread");
+    PlaceThread(worker_thread_, "pc_worker_thread");
+    PlaceThread(network_thread_, "pc_network_thread");
+    for (size_t i = 0; i < additional_network_threads_.size(); ++i) {
+      PlaceThread(additional_network_threads_[i].thread,
+                  "pc_network_thread_" + rtc::ToString(i + 1));
+    }
+  }
+
   channel_manager_ = absl::make_unique<cricket::ChannelManager>(
       std::move(media_engine_), absl::make_unique<cricket::RtpDataEngine>(),
       worker_thread_, network_thread_);
@@ -190,6 +254,15 @@ bool PeerConnectionFactory::Initialize() {
 
 void PeerConnectionFactory::SetOptions(const Options& options) {
   options_ = options;
+  if (options_.certificate_pool_size > 0 && !certificate_pool_) {
+    certificate_pool_ = new rtc::RefCountedObject<rtc::RTCCertificatePool>(
+        signaling_thread_, network_thread_);
+  }
+  if (certificate_pool_) {
+    certificate_pool_->Configure(
+        options_.certificate_pool_key_params,
+        static_cast<size_t>(std::max(options_.certificate_pool_size, 0)));
+  }
 }
 
 RtpCapabilities PeerConnectionFactory::GetRtpSenderCapabilities(
@@ -286,17 +359,34 @@ PeerConnectionFactory::CreatePeerConnection(
   RTC_DCHECK(signaling_thread_->IsCurrent());
 
   // Set internal defaults if optional dependencies are not set.
+  if (!dependencies.cert_generator && certificate_pool_) {
+    dependencies.cert_generator = certificate_pool_->CreateGenerator();
+  }
   if (!dependencies.cert_generator) {
     dependencies.cert_generator =
         absl::make_unique<rtc::RTCCertificateGenerator>(signaling_thread_,
                                                         network_thread_);
   }
+  // A PortAllocator passed in is bound to |network_thread_|, so only the
+  // PeerConnections with the default one can run on another network thread.
+  rtc::Thread* network_thread = network_thread_;
   if (!dependencies.allocator) {
-    network_thread_->Invoke<void>(RTC_FROM_HERE, [this, &configuration,
-                                                  &dependencies]() {
+    rtc::BasicNetworkManager* network_manager = default_network_manager_.get();
+    rtc::PacketSocketFactory* socket_factory = default_socket_factory_.get();
+    const size_t index =
+        next_network_thread_++ % (additional_network_threads_.size() + 1);
+    if (index > 0) {
+      const NetworkThreadContext& context =
+          additional_network_threads_[index - 1];
+      network_thread = context.thread;
+      network_manager = context.network_manager.get();
+      socket_factory = context.socket_factory.get();
+    }
+    network_thread->Invoke<void>(RTC_FROM_HERE, [&configuration, &dependencies,
+                                                 network_manager,
+                                                 socket_factory]() {
       dependencies.allocator = absl::make_unique<cricket::BasicPortAllocator>(
-          default_network_manager_.get(), default_socket_factory_.get(),
-          configuration.turn_customizer);
+          network_manager, socket_factory, configuration.turn_customizer);
     });
   }
 
@@ -304,7 +394,7 @@ PeerConnectionFactory::CreatePeerConnection(
   // |dependencies.async_resolver_factory| to a new
   // |rtc::BasicAsyncResolverFactory| if no factory is provided.
 
-  network_thread_->Invoke<void>(
+  network_thread->Invoke<void>(
       RTC_FROM_HERE,
       rtc::Bind(&cricket::PortAllocator::SetNetworkIgnoreMask,
                 dependencies.allocator.get(), options_.network_ignore_mask));
@@ -319,8 +409,8 @@ PeerConnectionFactory::CreatePeerConnection(
       rtc::Bind(&PeerConnectionFactory::CreateCall_w, this, event_log.get()));
 
   rtc::scoped_refptr<PeerConnection> pc(
-      new rtc::RefCountedObject<PeerConnection>(this, std::move(event_log),
-                                                std::move(call)));
+      new rtc::RefCountedObject<PeerConnection>(
+          this, network_thread, std::move(event_log), std::move(call)));
   ActionsBeforeInitializeForTesting(pc);
   if (!pc->Initialize(configuration, std::move(dependencies))) {
     return nullptr;
@@ -353,18 +443,40 @@ rtc::scoped_refptr<AudioTrackInterface> PeerConnectionFactory::CreateAudioTrack(
 }
 
 std::unique_ptr<cricket::SctpTransportInternalFactory>
-PeerConnectionFactory::CreateSctpTransportInternalFactory() {
+PeerConnectionFactory::CreateSctpTransportInternalFactory(
+    rtc::Thread* network_thread) {
 #ifdef HAVE_SCTP
-  return absl::make_unique<cricket::SctpTransportFactory>(network_thread());
+  return absl::make_unique<cricket::SctpTransportFactory>(network_thread);
 #else
   return nullptr;
 #endif
 }
 
+rtc::SSLSessionCache* PeerConnectionFactory::GetDtlsSessionCache(
+    rtc::Thread* network_thread) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  std::unique_ptr<rtc::SSLSessionCache>& cache =
+      dtls_session_caches_[network_thread];
+  if (!cache)
+    cache = rtc::SSLSessionCache::Create(rtc::SSL_MODE_DTLS);
+  return cache.get();
+}
+
 cricket::ChannelManager* PeerConnectionFactory::channel_manager() {
   return channel_manager_.get();
 }
 
+void PeerConnectionFactory::PlaceThread(rtc::Thread* thread,
+                                        const std::string& name) {
+  const ThreadPlacement placement =
+      thread_placement_policy_->GetPlacement(name);
+  if (!thread->Invoke<bool>(RTC_FROM_HERE, [&name, &placement] {
+        return rtc::SetCurrentThreadPlacement(name, placement);
+      })) {
+    RTC_LOG(LS_WARNING) << "Failed to fully place " << name;
+  }
+}
+
 std::unique_ptr<RtcEventLog> PeerConnectionFactory::CreateRtcEventLog_w() {
   RTC_DCHECK_RUN_ON(worker_thread_);
 
@@ -12,8 +12,10 @@
 #ifndef PC_PEER_CONNECTION_FACTORY_H_
 #define PC_PEER_CONNECTION_FACTORY_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "api/media_stream_interface.h"
 #include "api/media_transport_interface.h"
@@ -22,6 +24,8 @@
 #include "media/sctp/sctp_transport_internal.h"
 #include "pc/channel_manager.h"
 #include "rtc_base/rtc_certificate_generator.h"
+#include "rtc_base/rtc_certificate_pool.h"
+#include "rtc_base/ssl_stream_adapter.h"
 #include "rtc_base/thread.h"
 
 namespace rtc {
@@ -72,8 +76,10 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   bool StartAecDump(rtc::PlatformFile file, int64_t max_size_bytes) override;
   void StopAecDump() override;
 
+  // |network_thread| is the network thread of the PeerConnection, either
+  // network_thread() or one of the additional network threads.
   virtual std::unique_ptr<cricket::SctpTransportInternalFactory>
-  CreateSctpTransportInternalFactory();
+  CreateSctpTransportInternalFactory(rtc::Thread* network_thread);
 
   virtual cricket::ChannelManager* channel_manager();
 
@@ -84,13 +90,27 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   }
   rtc::Thread* worker_thread() { return worker_thread_; }
   rtc::Thread* network_thread() { return network_thread_; }
+  size_t num_additional_network_threads() const {
+    return additional_network_threads_.size();
+  }
 
   const Options& options() const { return options_; }
 
+  // The pool of pre-generated certificates, or null if
+  // |Options::certificate_pool_size| was never set.
+  rtc::RTCCertificatePool* certificate_pool() const {
+    return certificate_pool_.get();
+  }
+
   MediaTransportFactory* media_transport_factory() {
     return media_transport_factory_.get();
   }
 
+  // The DTLS session cache shared by the PeerConnections on |network_thread|,
+  // created on first use. A session cache may only be used on one thread, so
+  // each network thread has its own. Called on the signaling thread.
+  rtc::SSLSessionCache* GetDtlsSessionCache(rtc::Thread* network_thread);
+
  protected:
   // This structure allows simple management of all new dependencies being added
   // to the PeerConnectionFactory.
@@ -106,6 +126,20 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
  private:
   std::unique_ptr<RtcEventLog> CreateRtcEventLog_w();
   std::unique_ptr<Call> CreateCall_w(RtcEventLog* event_log);
+  // Applies the placement of |thread_placement_policy_| for |name| to |thread|.
+  void PlaceThread(rtc::Thread* thread, const std::string& name);
+
+  // An additional network thread, and the default networking of the
+  // PeerConnections assigned to it.
+  struct NetworkThreadContext {
+    explicit NetworkThreadContext(rtc::Thread* thread);
+    NetworkThreadContext(NetworkThreadContext&&);
+    ~NetworkThreadContext();
+
+    rtc::Thread* thread;
+    std::unique_ptr<rtc::BasicNetworkManager> network_manager;
+    std::unique_ptr<rtc::BasicPacketSocketFactory> socket_factory;
+  };
 
   bool wraps_current_thread_;
   rtc::Thread* network_thread_;
@@ -113,11 +147,16 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   rtc::Thread* signaling_thread_;
   std::unique_ptr<rtc::Thread> owned_network_thread_;
   std::unique_ptr<rtc::Thread> owned_worker_thread_;
+  const std::unique_ptr<ThreadPlacementPolicy> thread_placement_policy_;
   const std::unique_ptr<TaskQueueFactory> task_queue_factory_;
   Options options_;
+  rtc::scoped_refptr<rtc::RTCCertificatePool> certificate_pool_;
   std::unique_ptr<cricket::ChannelManager> channel_manager_;
   std::unique_ptr<rtc::BasicNetworkManager> default_network_manager_;
   std::unique_ptr<rtc::BasicPacketSocketFactory> default_socket_factory_;
+  std::vector<NetworkThreadContext> additional_network_threads_;
+  // Round-robin index over |network_thread_| and the additional threads.
+  size_t next_network_thread_ = 0;
   std::unique_ptr<cricket::MediaEngineInterface> media_engine_;
   std::unique_ptr<webrtc::CallFactoryInterface> call_factory_;
   std::unique_ptr<RtcEventLogFactoryInterface> event_log_factory_;
@@ -127,6 +166,8 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   std::unique_ptr<NetworkControllerFactoryInterface>
       injected_network_controller_factory_;
   std::unique_ptr<MediaTransportFactory> media_transport_factory_;
+  std::map<rtc::Thread*, std::unique_ptr<rtc::SSLSessionCache>>
+      dtls_session_caches_;
 };
 
 }  // namespace webrtc
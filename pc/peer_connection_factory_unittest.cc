@@ -9,34 +9,47 @@
  */
 
 #include <stddef.h>
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "api/audio/audio_mixer.h"
 #include "api/audio_codecs/audio_decoder_factory.h"
 #include "api/audio_codecs/audio_encoder_factory.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
 #include "api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "api/call/call_factory_interface.h"
 #include "api/create_peerconnection_factory.h"
 #include "api/data_channel_interface.h"
 #include "api/jsep.h"
 #include "api/media_stream_interface.h"
+#include "api/peer_connection_factory_proxy.h"
+#include "api/peer_connection_proxy.h"
+#include "api/thread_placement.h"
 #include "api/video_codecs/builtin_video_decoder_factory.h"
 #include "api/video_codecs/builtin_video_encoder_factory.h"
 #include "api/video_codecs/video_decoder_factory.h"
 #include "api/video_codecs/video_encoder_factory.h"
 #include "media/base/fake_frame_source.h"
+#include "media/base/fake_media_engine.h"
 #include "modules/audio_device/include/audio_device.h"
 #include "modules/audio_processing/include/audio_processing.h"
 #include "p2p/base/fake_port_allocator.h"
 #include "p2p/base/port.h"
 #include "p2p/base/port_interface.h"
+#include "pc/peer_connection.h"
 #include "pc/peer_connection_factory.h"
 #include "pc/test/fake_audio_capture_module.h"
 #include "pc/test/fake_video_track_source.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/gunit.h"
 #include "rtc_base/socket_address.h"
+#include "rtc_base/ssl_stream_adapter.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/thread_annotations.h"
 #include "test/gtest.h"
 
 #ifdef WEBRTC_ANDROID
@@ -96,6 +109,27 @@ class NullPeerConnectionObserver : public PeerConnectionObserver {
   }
 };
 
+// Records the names of the threads it places.
+class RecordingThreadPlacementPolicy : public webrtc::ThreadPlacementPolicy {
+ public:
+  webrtc::ThreadPlacement GetPlacement(
+      absl::string_view thread_name) const override {
+    rtc::CritScope cs(&crit_);
+    names_.emplace_back(thread_name);
+    return webrtc::ThreadPlacement();
+  }
+
+  bool Placed(const std::string& thread_name) const {
+    rtc::CritScope cs(&crit_);
+    return std::find(names_.begin(), names_.end(), thread_name) !=
+           names_.end();
+  }
+
+ private:
+  rtc::CriticalSection crit_;
+  mutable std::vector<std::string> names_ RTC_GUARDED_BY(crit_);
+};
+
 }  // namespace
 
 class PeerConnectionFactoryTest : public ::testing::Test {
@@ -479,3 +513,119 @@ TEST_F(PeerConnectionFactoryTest, LocalRendering) {
   EXPECT_EQ(3, local_renderer.num_rendered_frames());
   EXPECT_FALSE(local_renderer.black_frame());
 }
+
+// Verifies that PeerConnections with the default PortAllocator are spread
+// round-robin over the network thread and the additional network threads, and
+// that the ones with a PortAllocator passed in stay on the network thread.
+TEST(PeerConnectionFactoryTestInternal,
+     SpreadsPeerConnectionsOverNetworkThreads) {
+  std::unique_ptr<rtc::Thread> thread1 = rtc::Thread::CreateWithSocketServer();
+  std::unique_ptr<rtc::Thread> thread2 = rtc::Thread::CreateWithSocketServer();
+  ASSERT_TRUE(thread1->Start());
+  ASSERT_TRUE(thread2->Start());
+
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.network_thread = rtc::Thread::Current();
+  dependencies.worker_thread = rtc::Thread::Current();
+  dependencies.signaling_thread = rtc::Thread::Current();
+  dependencies.additional_network_threads = {thread1.get(), thread2.get()};
+  dependencies.media_engine = absl::make_unique<cricket::FakeMediaEngine>();
+  dependencies.call_factory = webrtc::CreateCallFactory();
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> factory =
+      webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
+  ASSERT_TRUE(factory);
+
+  NullPeerConnectionObserver observer;
+  auto get_network_thread = [](PeerConnectionInterface* pc) {
+    auto* proxy = static_cast<
+        webrtc::PeerConnectionProxyWithInternal<PeerConnectionInterface>*>(pc);
+    return static_cast<webrtc::PeerConnection*>(proxy->internal())
+        ->network_thread();
+  };
+  std::vector<rtc::scoped_refptr<PeerConnectionInterface>> pcs;
+  std::vector<rtc::Thread*> network_threads;
+  for (int i = 0; i < 4; ++i) {
+    pcs.push_back(factory->CreatePeerConnection(
+        PeerConnectionInterface::RTCConfiguration(), nullptr,
+        absl::make_unique<FakeRTCCertificateGenerator>(), &observer));
+    ASSERT_TRUE(pcs.back());
+    network_threads.push_back(get_network_thread(pcs.back()));
+  }
+  EXPECT_EQ(rtc::Thread::Current(), network_threads[0]);
+  EXPECT_EQ(thread1.get(), network_threads[1]);
+  EXPECT_EQ(thread2.get(), network_threads[2]);
+  EXPECT_EQ(rtc::Thread::Current(), network_threads[3]);
+
+  // The next PeerConnection with the default allocator would go to |thread1|.
+  pcs.push_back(factory->CreatePeerConnection(
+      PeerConnectionInterface::RTCConfiguration(),
+      absl::make_unique<cricket::FakePortAllocator>(rtc::Thread::Current(),
+                                                    nullptr),
+      absl::make_unique<FakeRTCCertificateGenerator>(), &observer));
+  ASSERT_TRUE(pcs.back());
+  EXPECT_EQ(rtc::Thread::Current(), get_network_thread(pcs.back()));
+
+  for (const auto& pc : pcs) {
+    pc->Close();
+  }
+}
+
+// Verifies that the PeerConnections on a network thread share a DTLS session
+// cache, and that each network thread has its own.
+TEST(PeerConnectionFactoryTestInternal, KeepsDtlsSessionCachePerNetworkThread) {
+  std::unique_ptr<rtc::Thread> thread1 = rtc::Thread::CreateWithSocketServer();
+  ASSERT_TRUE(thread1->Start());
+
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.network_thread = rtc::Thread::Current();
+  dependencies.worker_thread = rtc::Thread::Current();
+  dependencies.signaling_thread = rtc::Thread::Current();
+  dependencies.additional_network_threads = {thread1.get()};
+  dependencies.media_engine = absl::make_unique<cricket::FakeMediaEngine>();
+  dependencies.call_factory = webrtc::CreateCallFactory();
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> factory =
+      webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
+  ASSERT_TRUE(factory);
+  auto* proxy = static_cast<webrtc::PeerConnectionFactoryProxyWithInternal<
+      PeerConnectionFactoryInterface>*>(factory.get());
+  auto* internal_factory =
+      static_cast<webrtc::PeerConnectionFactory*>(proxy->internal());
+
+  rtc::SSLSessionCache* cache =
+      internal_factory->GetDtlsSessionCache(rtc::Thread::Current());
+  ASSERT_TRUE(cache);
+  EXPECT_EQ(cache,
+            internal_factory->GetDtlsSessionCache(rtc::Thread::Current()));
+  rtc::SSLSessionCache* cache1 =
+      internal_factory->GetDtlsSessionCache(thread1.get());
+  ASSERT_TRUE(cache1);
+  EXPECT_NE(cache, cache1);
+  EXPECT_EQ(cache1, internal_factory->GetDtlsSessionCache(thread1.get()));
+}
+
+// Verifies that the threads of the factory are placed, and the task queues of
+// Call too, although no TaskQueueFactory is injected.
+TEST(PeerConnectionFactoryTestInternal, PlacesThreadsAndTaskQueues) {
+  auto policy = absl::make_unique<RecordingThreadPlacementPolicy>();
+  RecordingThreadPlacementPolicy* policy_ptr = policy.get();
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.media_engine = absl::make_unique<cricket::FakeMediaEngine>();
+  dependencies.call_factory = webrtc::CreateCallFactory();
+  dependencies.thread_placement_policy = std::move(policy);
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> factory =
+      webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
+  ASSERT_TRUE(factory);
+  EXPECT_TRUE(policy_ptr->Placed("pc_network_thread"));
+  EXPECT_TRUE(policy_ptr->Placed("pc_worker_thread"));
+  EXPECT_TRUE(policy_ptr->Placed("pc_signaling_thread"));
+
+  // Creating the PeerConnection creates Call, with its task queues.
+  NullPeerConnectionObserver observer;
+  rtc::scoped_refptr<PeerConnectionInterface> pc =
+      factory->CreatePeerConnection(
+          PeerConnectionInterface::RTCConfiguration(), nullptr,
+          absl::make_unique<FakeRTCCertificateGenerator>(), &observer);
+  ASSERT_TRUE(pc);
+  EXPECT_TRUE_WAIT(policy_ptr->Placed("rtp_send_controller"), 5000);
+  pc->Close();
+}
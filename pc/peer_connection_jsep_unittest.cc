@@ -64,7 +64,7 @@ class PeerConnectionFactoryForJsepTest : public PeerConnectionFactory {
         }()) {}
 
   std::unique_ptr<cricket::SctpTransportInternalFactory>
-  CreateSctpTransportInternalFactory() {
+  CreateSctpTransportInternalFactory(rtc::Thread* network_thread) override {
     return absl::make_unique<FakeSctpTransportFactory>();
   }
 };
@@ -0,0 +1,170 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/crypto/crypto_options.h"
+#include "call/rtp_demuxer.h"
+#include "call/rtp_packet_sink_interface.h"
+#include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/dtls_transport.h"
+#include "p2p/base/fake_port_allocator.h"
+#include "p2p/base/p2p_transport_channel.h"
+#include "pc/rtp_transport.h"
+#include "rtc_base/async_packet_socket.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_base/virtual_socket_server.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kNumPackets = 1000000;
+constexpr uint32_t kSsrc = 0x12345678;
+constexpr size_t kRtpHeaderSize = 12;
+constexpr size_t kPacketSize = 1200;
+
+const cricket::IceParameters kLocalIceParameters("LOCALUFRAG",
+                                                 "LOCALPASSWORDLOCALPASS",
+                                                 false);
+const cricket::IceParameters kRemoteIceParameters("REMOTEUFRAG",
+                                                  "REMOTEPASSWORDREMOTEPAS",
+                                                  false);
+
+// Remembers the UDP socket of the port, to hand it packets as if they had
+// just been read from the network.
+class RecordingPacketSocketFactory : public rtc::BasicPacketSocketFactory {
+ public:
+  explicit RecordingPacketSocketFactory(rtc::Thread* thread)
+      : rtc::BasicPacketSocketFactory(thread) {}
+
+  rtc::AsyncPacketSocket* CreateUdpSocket(const rtc::SocketAddress& address,
+                                          uint16_t min_port,
+                                          uint16_t max_port) override {
+    udp_socket_ = rtc::BasicPacketSocketFactory::CreateUdpSocket(
+        address, min_port, max_port);
+    return udp_socket_;
+  }
+
+  rtc::AsyncPacketSocket* udp_socket() const { return udp_socket_; }
+
+ private:
+  rtc::AsyncPacketSocket* udp_socket_ = nullptr;
+};
+
+class CountingSink : public RtpPacketSinkInterface {
+ public:
+  void OnRtpPacket(const RtpPacketReceived& packet) override { ++count_; }
+  int count() const { return count_; }
+
+ private:
+  int count_ = 0;
+};
+
+cricket::Candidate CreateRemoteCandidate(int index) {
+  cricket::Candidate candidate;
+  candidate.set_address(rtc::SocketAddress(
+      "10.0." + rtc::ToString(index / 250) + "." +
+          rtc::ToString(index % 250 + 1),
+      5000 + index));
+  candidate.set_component(cricket::ICE_CANDIDATE_COMPONENT_DEFAULT);
+  candidate.set_protocol(cricket::UDP_PROTOCOL_NAME);
+  candidate.set_priority(static_cast<uint32_t>(index + 1));
+  candidate.set_type(cricket::LOCAL_PORT_TYPE);
+  return candidate;
+}
+
+std::vector<char> CreateRtpPacket() {
+  std::vector<char> packet(kPacketSize);
+  packet[0] = static_cast<char>(0x80);
+  packet[1] = 96;
+  rtc::SetBE16(&packet[2], 1);
+  rtc::SetBE32(&packet[4], 90000);
+  rtc::SetBE32(&packet[8], kSsrc);
+  for (size_t i = kRtpHeaderSize; i < packet.size(); ++i) {
+    packet[i] = static_cast<char>(i);
+  }
+  return packet;
+}
+
+// Hands |kNumPackets| RTP packets to the UDP socket of an ICE transport with
+// |num_connections| candidate pairs, and prints the time per packet until it
+// reaches the RtpTransport sink, through the port, the connection, the ICE
+// transport and the DTLS transport.
+void MeasureReceivePath(int num_connections) {
+  rtc::VirtualSocketServer socket_server;
+  rtc::AutoSocketServerThread thread(&socket_server);
+  RecordingPacketSocketFactory socket_factory(&thread);
+  cricket::FakePortAllocator allocator(&thread, &socket_factory);
+
+  auto ice = absl::make_unique<cricket::P2PTransportChannel>(
+      "receive", cricket::ICE_CANDIDATE_COMPONENT_DEFAULT, &allocator);
+  cricket::P2PTransportChannel* ice_transport = ice.get();
+  ice_transport->SetIceRole(cricket::ICEROLE_CONTROLLING);
+  ice_transport->SetIceParameters(kLocalIceParameters);
+  ice_transport->SetRemoteIceParameters(kRemoteIceParameters);
+  for (int i = 0; i < num_connections; ++i) {
+    ice_transport->AddRemoteCandidate(CreateRemoteCandidate(i));
+  }
+  ice_transport->MaybeStartGathering();
+  thread.ProcessMessages(0);
+  ASSERT_EQ(static_cast<size_t>(num_connections),
+            ice_transport->connections().size());
+  rtc::AsyncPacketSocket* socket = socket_factory.udp_socket();
+  ASSERT_TRUE(socket);
+
+  // Without a local certificate, DTLS is not negotiated and packets are
+  // passed through.
+  cricket::DtlsTransport dtls_transport(std::move(ice), CryptoOptions(),
+                                       /*event_log=*/nullptr);
+  RtpTransport rtp_transport(/*rtcp_mux_enabled=*/true);
+  rtp_transport.SetRtpPacketTransport(&dtls_transport);
+  CountingSink sink;
+  RtpDemuxerCriteria criteria;
+  criteria.ssrcs.insert(kSsrc);
+  ASSERT_TRUE(rtp_transport.RegisterRtpDemuxerSink(criteria, &sink));
+
+  // Packets arrive on the connection with the last remote candidate.
+  const rtc::SocketAddress remote_address =
+      CreateRemoteCandidate(num_connections - 1).address();
+  const std::vector<char> packet = CreateRtpPacket();
+  const int64_t packet_time_us = rtc::TimeMicros();
+  const int64_t start_ns = rtc::SystemTimeNanos();
+  for (int i = 0; i < kNumPackets; ++i) {
+    socket->SignalReadPacket(socket, packet.data(), packet.size(),
+                             remote_address, packet_time_us);
+  }
+  const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+  EXPECT_EQ(kNumPackets, sink.count());
+  rtp_transport.UnregisterRtpDemuxerSink(&sink);
+  rtp_transport.SetRtpPacketTransport(nullptr);
+
+  webrtc::test::PrintResult(
+      "receive_path", "_" + rtc::ToString(num_connections) + "_connections",
+      "socket_to_rtp_sink", static_cast<double>(elapsed_ns) / kNumPackets,
+      "ns", true);
+}
+
+}  // namespace
+
+TEST(ReceivePathPerfTest, SocketToRtpSink) {
+  for (int num_connections : {1, 20, 500}) {
+    MeasureReceivePath(num_connections);
+  }
+}
+
+}  // namespace webrtc
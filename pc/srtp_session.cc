@@ -14,6 +14,7 @@
 #include "pc/external_hmac.h"
 #include "rtc_base/critical_section.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/perf_event_counters.h"
 #include "rtc_base/ssl_stream_adapter.h"
 #include "system_wrappers/include/metrics.h"
 #include "third_party/libsrtp/include/srtp.h"
@@ -68,6 +69,7 @@ bool SrtpSession::UpdateRecv(int cs,
 
 bool SrtpSession::ProtectRtp(void* p, int in_len, int max_len, int* out_len) {
   RTC_DCHECK(thread_checker_.IsCurrent());
+  RTC_PERF_EVENT_SCOPE("Srtp.ProtectRtp");
   if (!session_) {
     RTC_LOG(LS_WARNING) << "Failed to protect SRTP packet: no SRTP Session";
     return false;
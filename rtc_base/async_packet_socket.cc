@@ -29,6 +29,18 @@ AsyncPacketSocket::AsyncPacketSocket() = default;
 
 AsyncPacketSocket::~AsyncPacketSocket() = default;
 
+int AsyncPacketSocket::SendToBatch(const Socket::Datagram* datagrams,
+                                   size_t count,
+                                   const PacketOptions& options) {
+  for (size_t i = 0; i < count; ++i) {
+    if (SendTo(datagrams[i].data, datagrams[i].size, datagrams[i].addr,
+               options) < 0) {
+      return i > 0 ? static_cast<int>(i) : -1;
+    }
+  }
+  return static_cast<int>(count);
+}
+
 void CopySocketInformationToPacketInfo(size_t packet_size_bytes,
                                        const AsyncPacketSocket& socket_from,
                                        bool is_connectionless,
@@ -79,6 +79,12 @@ class AsyncPacketSocket : public sigslot::has_slots<> {
                      size_t cb,
                      const SocketAddress& addr,
                      const PacketOptions& options) = 0;
+  // Send several packets with the same |options|. Returns the number of
+  // packets that were sent, which may be less than |count|, or -1 if the
+  // first one failed. The default implementation calls SendTo() for each.
+  virtual int SendToBatch(const Socket::Datagram* datagrams,
+                          size_t count,
+                          const PacketOptions& options);
 
   // Close the socket.
   virtual int Close() = 0;
@@ -86,6 +86,27 @@ int AsyncUDPSocket::SendTo(const void* pv,
   return ret;
 }
 
+int AsyncUDPSocket::SendToBatch(const Socket::Datagram* datagrams,
+                                size_t count,
+                                const rtc::PacketOptions& options) {
+  size_t sent = 0;
+  while (sent < count) {
+    int ret = socket_->SendToBatch(datagrams + sent, count - sent);
+    if (ret <= 0) {
+      break;
+    }
+    for (int i = 0; i < ret; ++i) {
+      rtc::SentPacket sent_packet(options.packet_id, rtc::TimeMillis(),
+                                  options.info_signaled_after_sent);
+      CopySocketInformationToPacketInfo(datagrams[sent + i].size, *this, true,
+                                        &sent_packet.info);
+      SignalSentPacket(this, sent_packet);
+    }
+    sent += ret;
+  }
+  return sent > 0 ? static_cast<int>(sent) : -1;
+}
+
 int AsyncUDPSocket::Close() {
   return socket_->Close();
 }
@@ -110,9 +131,36 @@ void AsyncUDPSocket::SetError(int error) {
   return socket_->SetError(error);
 }
 
+void AsyncUDPSocket::EnableBatchedReads(size_t max_datagrams) {
+  RTC_DCHECK_GT(max_datagrams, 0);
+  batch_buffer_.resize(max_datagrams * BUF_SIZE);
+  batch_.resize(max_datagrams);
+}
+
 void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
   RTC_DCHECK(socket_.get() == socket);
 
+  if (!batch_.empty()) {
+    for (size_t i = 0; i < batch_.size(); ++i) {
+      batch_[i].data = &batch_buffer_[i * BUF_SIZE];
+      batch_[i].size = BUF_SIZE;
+    }
+    int count = socket_->RecvFromBatch(batch_.data(), batch_.size());
+    if (count < 0) {
+      RTC_LOG(LS_INFO) << "AsyncUDPSocket["
+                       << socket_->GetLocalAddress().ToSensitiveString()
+                       << "] receive failed with error " << socket_->GetError();
+      return;
+    }
+    int64_t now_us = TimeMicros();
+    for (int i = 0; i < count; ++i) {
+      const Socket::Datagram& datagram = batch_[i];
+      SignalReadPacket(this, datagram.data, datagram.size, datagram.addr,
+                       (datagram.timestamp > -1 ? datagram.timestamp : now_us));
+    }
+    return;
+  }
+
   SocketAddress remote_addr;
   int64_t timestamp;
   int len = socket_->RecvFrom(buf_, size_, &remote_addr, &timestamp);
@@ -13,6 +13,7 @@
 
 #include <stddef.h>
 #include <memory>
+#include <vector>
 
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/async_socket.h"
@@ -47,6 +48,11 @@ class AsyncUDPSocket : public AsyncPacketSocket {
              size_t cb,
              const SocketAddress& addr,
              const rtc::PacketOptions& options) override;
+  // Sends through Socket::SendToBatch(), so that the packets take as few
+  // system calls as the platform allows.
+  int SendToBatch(const Socket::Datagram* datagrams,
+                  size_t count,
+                  const rtc::PacketOptions& options) override;
   int Close() override;
 
   State GetState() const override;
@@ -55,6 +61,12 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   int GetError() const override;
   void SetError(int error) override;
 
+  // Makes each read event receive up to |max_datagrams| packets with
+  // Socket::RecvFromBatch(), rather than one. This saves system calls on
+  // sockets that receive from many peers, like those of a TURN server. Each
+  // datagram gets its own 64 KB buffer.
+  void EnableBatchedReads(size_t max_datagrams);
+
  private:
   // Called when the underlying socket is ready to be read from.
   void OnReadEvent(AsyncSocket* socket);
@@ -64,6 +76,9 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   std::unique_ptr<AsyncSocket> socket_;
   char* buf_;
   size_t size_;
+  // Used instead of |buf_| when batched reads are enabled.
+  std::vector<char> batch_buffer_;
+  std::vector<Socket::Datagram> batch_;
 };
 
 }  // namespace rtc
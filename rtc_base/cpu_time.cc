@@ -14,6 +14,7 @@
 #include "rtc_base/time_utils.h"
 
 #if defined(WEBRTC_LINUX)
+#include <pthread.h>
 #include <time.h>
 #elif defined(WEBRTC_MAC)
 #include <mach/mach_init.h>
@@ -122,4 +123,55 @@ int64_t GetThreadCpuTimeNanos() {
   return -1;
 }
 
+int64_t GetThreadCpuTimeNanos(PlatformThreadRef thread) {
+#if defined(WEBRTC_LINUX)
+  clockid_t clock_id;
+  struct timespec ts;
+  if (pthread_getcpuclockid(thread, &clock_id) == 0 &&
+      clock_gettime(clock_id, &ts) == 0) {
+    return ts.tv_sec * kNumNanosecsPerSec + ts.tv_nsec;
+  } else {
+    RTC_LOG_ERR(LS_ERROR) << "clock_gettime() failed.";
+  }
+#elif defined(WEBRTC_MAC)
+  thread_basic_info_data_t info;
+  mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+  kern_return_t kr = thread_info(pthread_mach_thread_np(thread),
+                                 THREAD_BASIC_INFO, (thread_info_t)&info,
+                                 &count);
+  if (kr == KERN_SUCCESS) {
+    return info.user_time.seconds * kNumNanosecsPerSec +
+           info.user_time.microseconds * kNumNanosecsPerMicrosec;
+  } else {
+    RTC_LOG_ERR(LS_ERROR) << "thread_info() failed.";
+  }
+#elif defined(WEBRTC_WIN)
+  HANDLE handle = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, thread);
+  FILETIME createTime;
+  FILETIME exitTime;
+  FILETIME kernelTime;
+  FILETIME userTime;
+  const bool success =
+      handle && GetThreadTimes(handle, &createTime, &exitTime, &kernelTime,
+                               &userTime) != 0;
+  if (handle)
+    CloseHandle(handle);
+  if (success) {
+    return ((static_cast<uint64_t>(userTime.dwHighDateTime) << 32) +
+            userTime.dwLowDateTime) *
+           kNanosecsPerFiletime;
+  } else {
+    RTC_LOG_ERR(LS_ERROR) << "GetThreadTimes() failed.";
+  }
+#elif defined(WEBRTC_FUCHSIA)
+  RTC_LOG_ERR(LS_ERROR) << "GetThreadCpuTimeNanos() not implemented";
+  return 0;
+#else
+  // Not implemented yet.
+  static_assert(
+      false, "GetThreadCpuTimeNanos() platform support not yet implemented.");
+#endif
+  return -1;
+}
+
 }  // namespace rtc
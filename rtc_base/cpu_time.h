@@ -13,6 +13,8 @@
 
 #include <stdint.h>
 
+#include "rtc_base/platform_thread_types.h"
+
 namespace rtc {
 
 // Returns total CPU time of a current process in nanoseconds.
@@ -23,6 +25,10 @@ int64_t GetProcessCpuTimeNanos();
 // Time base is unknown, therefore use only to calculate deltas.
 int64_t GetThreadCpuTimeNanos();
 
+// Returns total CPU time of |thread|, which must be running, in nanoseconds.
+// Time base is unknown, therefore use only to calculate deltas.
+int64_t GetThreadCpuTimeNanos(PlatformThreadRef thread);
+
 }  // namespace rtc
 
 #endif  // RTC_BASE_CPU_TIME_H_
@@ -89,6 +89,20 @@ TEST(CpuTimeTest, MAYBE_TEST(TwoThreads)) {
                 kNumNanosecsPerMillisec);
 }
 
+TEST(CpuTimeTest, MAYBE_TEST(ThreadRef)) {
+  int64_t start_time_nanos = GetThreadCpuTimeNanos(CurrentThreadRef());
+  int64_t counter;
+  WorkingFunction(&counter);
+  int64_t duration_nanos =
+      GetThreadCpuTimeNanos(CurrentThreadRef()) - start_time_nanos;
+  EXPECT_GE(duration_nanos,
+            (kProcessingTimeMillisecs - kAllowedErrorMillisecs) *
+                kNumNanosecsPerMillisec);
+  EXPECT_LE(duration_nanos,
+            (kProcessingTimeMillisecs + kAllowedErrorMillisecs) *
+                kNumNanosecsPerMillisec);
+}
+
 TEST(CpuTimeTest, MAYBE_TEST(Sleeping)) {
   int64_t process_start_time_nanos = GetProcessCpuTimeNanos();
   webrtc::SleepMs(kProcessingTimeMillisecs);
@@ -13,17 +13,22 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/checks.h"
-#include "rtc_base/critical_section.h"
 #include "rtc_base/event.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/platform_thread.h"
 #include "rtc_base/platform_thread_types.h"
 #include "rtc_base/thread_annotations.h"
+#include "rtc_base/thread_buffer_registry.h"
 #include "rtc_base/thread_checker.h"
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
@@ -83,7 +88,630 @@ static void EventTracingThreadFunc(void* params);
 // Atomic-int fast path for avoiding logging when disabled.
 static volatile int g_event_logging_active = 0;
 
-// TODO(pbos): Log metadata for all threads, etc.
+// Only one in this many top-level trace scopes are recorded.
+std::atomic<int> g_sample_interval(1);
+
+// The trace event macros pass at most two arguments.
+constexpr int kMaxTraceArgs = 2;
+// Number of events buffered for each thread between two runs of the logging
+// thread. A power of two, so that positions can be used modulo it.
+constexpr size_t kRecordsPerThread = 8192;
+constexpr int kLoggingIntervalMs = 100;
+// Process id written to the traces.
+constexpr int kTracePid = 1;
+
+// Copied from webrtc/rtc_base/trace_event.h TraceValueUnion.
+union TraceArgValue {
+  bool as_bool;
+  unsigned long long as_uint;
+  long long as_int;
+  double as_double;
+  const void* as_pointer;
+  const char* as_string;
+};
+
+// Assert that the size of the union is equal to the size of the as_uint
+// field since we are assigning to arbitrary types using it.
+static_assert(sizeof(TraceArgValue) == sizeof(unsigned long long),
+              "Size of TraceArg value union is not equal to the size of "
+              "the uint field of that union.");
+
+// A trace event, as buffered until the logging thread writes it. Names,
+// categories and argument names are the string literals of the trace macros,
+// so only their pointers are kept. Strings that the macros ask to be copied
+// are copied to the heap, and freed once the record is written.
+struct TraceRecord {
+  const char* name;
+  const unsigned char* category_enabled;
+  unsigned long long id;
+  int64_t timestamp_ns;
+  const char* arg_names[kMaxTraceArgs];
+  TraceArgValue arg_values[kMaxTraceArgs];
+  unsigned char arg_types[kMaxTraceArgs];
+  unsigned char num_args;
+  unsigned char flags;
+  char phase;
+};
+
+const char* CopyString(const char* str) {
+  // Space for the string and for the terminating null character.
+  size_t length = strlen(str) + 1;
+  char* copy = new char[length];
+  memcpy(copy, str, length);
+  return copy;
+}
+
+void FreeCopiedStrings(TraceRecord* record) {
+  if (record->flags & TRACE_EVENT_FLAG_COPY) {
+    delete[] record->name;
+    record->name = nullptr;
+  }
+  for (int i = 0; i < record->num_args; ++i) {
+    if (record->arg_types[i] == TRACE_VALUE_TYPE_COPY_STRING) {
+      delete[] record->arg_values[i].as_string;
+      record->arg_values[i].as_string = nullptr;
+    }
+  }
+}
+
+const char* CategoryName(const TraceRecord& record) {
+  // InternalGetCategoryEnabled() returns the name of enabled categories.
+  return reinterpret_cast<const char*>(record.category_enabled);
+}
+
+// Ring buffer of the trace events of one thread. Written by that thread
+// without locking, and read by the logging thread.
+class ThreadTraceBuffer {
+ public:
+  explicit ThreadTraceBuffer(PlatformThreadId thread_id)
+      : thread_id_(thread_id), records_(new TraceRecord[kRecordsPerThread]) {}
+
+  PlatformThreadId thread_id() const { return thread_id_; }
+
+  // Returns true if an event of |phase| should be recorded when one in
+  // |sample_interval| events is. Events nested in a scope are recorded along
+  // with the top-level scope, so that begin and end events stay paired.
+  // |capture| identifies the capture, which starts with no scope open, since
+  // the end events of the previous capture may not have been seen.
+  bool Sample(char phase, int sample_interval, int capture) {
+    if (capture != capture_) {
+      capture_ = capture;
+      depth_ = 0;
+      sampled_ = true;
+      sample_count_ = 0;
+    }
+    if (phase == TRACE_EVENT_PHASE_BEGIN) {
+      if (depth_++ == 0)
+        sampled_ = NextSample(sample_interval);
+      return sampled_;
+    }
+    if (phase == TRACE_EVENT_PHASE_END) {
+      // The end of a scope that began before the capture started.
+      if (depth_ == 0)
+        return sample_interval <= 1;
+      --depth_;
+      return sampled_;
+    }
+    return depth_ > 0 ? sampled_ : NextSample(sample_interval);
+  }
+
+  // Returns the record to fill in, or null if the buffer is full. The record
+  // is published by EndWrite().
+  TraceRecord* BeginWrite() {
+    const size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+    if (write_pos - read_pos_.load(std::memory_order_acquire) ==
+        kRecordsPerThread) {
+      return nullptr;
+    }
+    return &records_[write_pos % kRecordsPerThread];
+  }
+
+  void EndWrite() {
+    write_pos_.store(write_pos_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+  }
+
+  // Calls |handler| with each record written so far, and releases them.
+  template <typename Handler>
+  void Read(Handler handler) {
+    const size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    for (size_t pos = read_pos; pos != write_pos; ++pos) {
+      TraceRecord& record = records_[pos % kRecordsPerThread];
+      handler(record);
+      FreeCopiedStrings(&record);
+    }
+    read_pos_.store(write_pos, std::memory_order_release);
+  }
+
+ private:
+  bool NextSample(int sample_interval) {
+    if (++sample_count_ < sample_interval)
+      return false;
+    sample_count_ = 0;
+    return true;
+  }
+
+  const PlatformThreadId thread_id_;
+  const std::unique_ptr<TraceRecord[]> records_;
+  std::atomic<size_t> write_pos_{0};
+  std::atomic<size_t> read_pos_{0};
+
+  // Sampling state, only used by the writing thread.
+  int capture_ = 0;
+  int depth_ = 0;
+  bool sampled_ = true;
+  int sample_count_ = 0;
+};
+
+static std::string TraceArgValueAsString(unsigned char type,
+                                         TraceArgValue value) {
+  std::string output;
+
+  if (type == TRACE_VALUE_TYPE_STRING || type == TRACE_VALUE_TYPE_COPY_STRING) {
+    // Space for every character to be an espaced character + two for
+    // quatation marks.
+    output.reserve(strlen(value.as_string) * 2 + 2);
+    output += '\"';
+    const char* c = value.as_string;
+    do {
+      if (*c == '"' || *c == '\\') {
+        output += '\\';
+        output += *c;
+      } else {
+        output += *c;
+      }
+    } while (*++c);
+    output += '\"';
+  } else {
+    output.resize(kTraceArgBufferLength);
+    size_t print_length = 0;
+    switch (type) {
+      case TRACE_VALUE_TYPE_BOOL:
+        if (value.as_bool) {
+          strcpy(&output[0], "true");
+          print_length = 4;
+        } else {
+          strcpy(&output[0], "false");
+          print_length = 5;
+        }
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "%llu",
+                                value.as_uint);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "%lld",
+                                value.as_int);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "%f",
+                                value.as_double);
+        break;
+      case TRACE_VALUE_TYPE_POINTER:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "\"%p\"",
+                                value.as_pointer);
+        break;
+    }
+    size_t output_length = print_length < kTraceArgBufferLength
+                               ? print_length
+                               : kTraceArgBufferLength - 1;
+    // This will hopefully be very close to nop. On most implementations, it
+    // just writes null byte and sets the length field of the string.
+    output.resize(output_length);
+  }
+
+  return output;
+}
+
+// Writes trace events to a file in one of the trace formats.
+class TraceWriter {
+ public:
+  virtual ~TraceWriter() = default;
+  virtual void WriteHeader() = 0;
+  virtual void WriteEvent(PlatformThreadId thread_id,
+                          const TraceRecord& record) = 0;
+  virtual void WriteFooter() = 0;
+};
+
+// The TraceEvent format is documented here:
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
+class JsonTraceWriter final : public TraceWriter {
+ public:
+  explicit JsonTraceWriter(FILE* file) : file_(file) {
+    args_str_.reserve(kEventLoggerArgsStrBufferInitialSize);
+  }
+
+  void WriteHeader() override { fprintf(file_, "{ \"traceEvents\": [\n"); }
+
+  void WriteEvent(PlatformThreadId thread_id,
+                  const TraceRecord& record) override {
+    args_str_.clear();
+    if (record.flags & TRACE_EVENT_FLAG_HAS_ID) {
+      char id_str[kTraceArgBufferLength];
+      snprintf(id_str, sizeof(id_str), ", \"id\": \"0x%llx\"", record.id);
+      args_str_ += id_str;
+    }
+    if (record.num_args > 0) {
+      args_str_ += ", \"args\": {";
+      for (int i = 0; i < record.num_args; ++i) {
+        if (i > 0)
+          args_str_ += ",";
+        args_str_ += " \"";
+        args_str_ += record.arg_names[i];
+        args_str_ += "\": ";
+        args_str_ +=
+            TraceArgValueAsString(record.arg_types[i], record.arg_values[i]);
+      }
+      args_str_ += " }";
+    }
+    fprintf(file_,
+            "%s{ \"name\": \"%s\""
+            ", \"cat\": \"%s\""
+            ", \"ph\": \"%c\""
+            ", \"ts\": %" PRIu64
+            ", \"pid\": %d"
+#if defined(WEBRTC_WIN)
+            ", \"tid\": %lu"
+#else
+            ", \"tid\": %d"
+#endif  // defined(WEBRTC_WIN)
+            "%s"
+            "}\n",
+            has_logged_event_ ? "," : " ", record.name, CategoryName(record),
+            record.phase,
+            static_cast<uint64_t>(record.timestamp_ns /
+                                  rtc::kNumNanosecsPerMicrosec),
+            kTracePid, thread_id, args_str_.c_str());
+    has_logged_event_ = true;
+  }
+
+  void WriteFooter() override { fprintf(file_, "]}\n"); }
+
+ private:
+  FILE* const file_;
+  std::string args_str_;
+  bool has_logged_event_ = false;
+};
+
+// Encodes the few protobuf field types used by the Perfetto trace format.
+class ProtoWriter {
+ public:
+  void AddVarint(int field, uint64_t value) {
+    AddTag(field, kVarint);
+    AddRawVarint(value);
+  }
+
+  void AddDouble(int field, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    AddTag(field, kFixed64);
+    for (int i = 0; i < 8; ++i) {
+      data_ += static_cast<char>(bits & 0xff);
+      bits >>= 8;
+    }
+  }
+
+  void AddString(int field, const char* str) {
+    AddBytes(field, str, strlen(str));
+  }
+
+  void AddMessage(int field, const ProtoWriter& message) {
+    AddBytes(field, message.data_.data(), message.data_.size());
+  }
+
+  bool empty() const { return data_.empty(); }
+  const std::string& data() const { return data_; }
+
+ private:
+  enum WireType { kVarint = 0, kFixed64 = 1, kLengthDelimited = 2 };
+
+  void AddBytes(int field, const char* data, size_t size) {
+    AddTag(field, kLengthDelimited);
+    AddRawVarint(size);
+    data_.append(data, size);
+  }
+
+  void AddTag(int field, WireType type) {
+    AddRawVarint(static_cast<uint64_t>(field) << 3 | type);
+  }
+
+  void AddRawVarint(uint64_t value) {
+    while (value >= 0x80) {
+      data_ += static_cast<char>((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    data_ += static_cast<char>(value);
+  }
+
+  std::string data_;
+};
+
+// Writes a Perfetto trace, a sequence of TracePacket protos, see
+// https://perfetto.dev/docs/reference/trace-packet-proto
+// Event names, categories and argument names are interned, and each thread,
+// async event id and counter gets a track.
+class PerfettoTraceWriter final : public TraceWriter {
+ public:
+  explicit PerfettoTraceWriter(FILE* file) : file_(file) {}
+
+  void WriteHeader() override {
+    ProtoWriter packet;
+    packet.AddVarint(kTracePacketSequenceId, kSequenceId);
+    packet.AddVarint(kTracePacketSequenceFlags, kSeqIncrementalStateCleared);
+    WritePacket(packet);
+  }
+
+  void WriteEvent(PlatformThreadId thread_id,
+                  const TraceRecord& record) override {
+    ProtoWriter interned_data;
+    ProtoWriter event;
+    uint64_t track_uuid;
+    int type;
+    switch (record.phase) {
+      case TRACE_EVENT_PHASE_BEGIN:
+        type = kTypeSliceBegin;
+        track_uuid = ThreadTrack(thread_id);
+        break;
+      case TRACE_EVENT_PHASE_END:
+        type = kTypeSliceEnd;
+        track_uuid = ThreadTrack(thread_id);
+        break;
+      case TRACE_EVENT_PHASE_ASYNC_BEGIN:
+        type = kTypeSliceBegin;
+        track_uuid = AsyncTrack(record);
+        break;
+      case TRACE_EVENT_PHASE_ASYNC_STEP:
+        type = kTypeInstant;
+        track_uuid = AsyncTrack(record);
+        break;
+      case TRACE_EVENT_PHASE_ASYNC_END:
+        type = kTypeSliceEnd;
+        track_uuid = AsyncTrack(record);
+        async_tracks_.erase({record.name, record.id});
+        break;
+      case TRACE_EVENT_PHASE_COUNTER:
+        type = kTypeCounter;
+        track_uuid = CounterTrack(record);
+        break;
+      default:
+        type = kTypeInstant;
+        track_uuid = ThreadTrack(thread_id);
+        break;
+    }
+    event.AddVarint(kTrackEventType, type);
+    event.AddVarint(kTrackEventTrackUuid, track_uuid);
+    if (type == kTypeCounter) {
+      AddCounterValue(record, &event);
+    } else if (type != kTypeSliceEnd) {
+      event.AddVarint(kTrackEventCategoryIids,
+                      Intern(CategoryName(record), kInternedEventCategories,
+                             &category_iids_, &interned_data));
+      if (record.flags & TRACE_EVENT_FLAG_COPY) {
+        event.AddString(kTrackEventName, record.name);
+      } else {
+        event.AddVarint(kTrackEventNameIid,
+                        Intern(record.name, kInternedEventNames, &name_iids_,
+                               &interned_data));
+      }
+      for (int i = 0; i < record.num_args; ++i) {
+        ProtoWriter annotation;
+        annotation.AddVarint(
+            kDebugAnnotationNameIid,
+            Intern(record.arg_names[i], kInternedDebugAnnotationNames,
+                   &arg_name_iids_, &interned_data));
+        AddAnnotationValue(record.arg_types[i], record.arg_values[i],
+                           &annotation);
+        event.AddMessage(kTrackEventDebugAnnotations, annotation);
+      }
+    }
+
+    ProtoWriter packet;
+    packet.AddVarint(kTracePacketTimestamp, record.timestamp_ns);
+    packet.AddVarint(kTracePacketTimestampClockId, kBuiltinClockMonotonic);
+    packet.AddVarint(kTracePacketSequenceId, kSequenceId);
+    packet.AddVarint(kTracePacketSequenceFlags, kSeqNeedsIncrementalState);
+    if (!interned_data.empty())
+      packet.AddMessage(kTracePacketInternedData, interned_data);
+    packet.AddMessage(kTracePacketTrackEvent, event);
+    WritePacket(packet);
+  }
+
+  void WriteFooter() override {}
+
+ private:
+  // Field numbers and values from protos/perfetto/trace/.
+  enum TracePacketField {
+    kTracePacketTimestamp = 8,
+    kTracePacketSequenceId = 10,
+    kTracePacketTrackEvent = 11,
+    kTracePacketInternedData = 12,
+    kTracePacketSequenceFlags = 13,
+    kTracePacketTimestampClockId = 58,
+    kTracePacketTrackDescriptor = 60,
+  };
+  enum TrackEventField {
+    kTrackEventCategoryIids = 3,
+    kTrackEventDebugAnnotations = 4,
+    kTrackEventType = 9,
+    kTrackEventNameIid = 10,
+    kTrackEventTrackUuid = 11,
+    kTrackEventName = 23,
+    kTrackEventCounterValue = 30,
+    kTrackEventDoubleCounterValue = 44,
+  };
+  enum TrackEventType {
+    kTypeSliceBegin = 1,
+    kTypeSliceEnd = 2,
+    kTypeInstant = 3,
+    kTypeCounter = 4,
+  };
+  enum TrackDescriptorField {
+    kTrackDescriptorUuid = 1,
+    kTrackDescriptorName = 2,
+    kTrackDescriptorThread = 4,
+    kTrackDescriptorCounter = 8,
+  };
+  enum ThreadDescriptorField {
+    kThreadDescriptorPid = 1,
+    kThreadDescriptorTid = 2,
+  };
+  enum InternedDataField {
+    kInternedEventCategories = 1,
+    kInternedEventNames = 2,
+    kInternedDebugAnnotationNames = 3,
+  };
+  enum InternedStringField {
+    kInternedIid = 1,
+    kInternedName = 2,
+  };
+  enum DebugAnnotationField {
+    kDebugAnnotationNameIid = 1,
+    kDebugAnnotationBoolValue = 2,
+    kDebugAnnotationUintValue = 3,
+    kDebugAnnotationIntValue = 4,
+    kDebugAnnotationDoubleValue = 5,
+    kDebugAnnotationStringValue = 6,
+    kDebugAnnotationPointerValue = 7,
+  };
+  enum SequenceFlags {
+    kSeqIncrementalStateCleared = 1,
+    kSeqNeedsIncrementalState = 2,
+  };
+  static constexpr int kBuiltinClockMonotonic = 3;
+  static constexpr int kSequenceId = 1;
+
+  // Returns the interned id of |str|, adding it to |interned_data| the first
+  // time. Keyed by pointer, since the strings are literals.
+  static uint64_t Intern(const char* str,
+                         InternedDataField field,
+                         std::map<const char*, uint64_t>* iids,
+                         ProtoWriter* interned_data) {
+    auto it = iids->find(str);
+    if (it != iids->end())
+      return it->second;
+    const uint64_t iid = iids->size() + 1;
+    iids->emplace(str, iid);
+    ProtoWriter entry;
+    entry.AddVarint(kInternedIid, iid);
+    entry.AddString(kInternedName, str);
+    interned_data->AddMessage(field, entry);
+    return iid;
+  }
+
+  uint64_t ThreadTrack(PlatformThreadId thread_id) {
+    auto it = thread_tracks_.find(thread_id);
+    if (it != thread_tracks_.end())
+      return it->second;
+    const uint64_t uuid = next_track_uuid_++;
+    thread_tracks_.emplace(thread_id, uuid);
+    ProtoWriter thread;
+    thread.AddVarint(kThreadDescriptorPid, kTracePid);
+    thread.AddVarint(kThreadDescriptorTid, thread_id);
+    ProtoWriter track;
+    track.AddVarint(kTrackDescriptorUuid, uuid);
+    track.AddMessage(kTrackDescriptorThread, thread);
+    WriteTrackDescriptor(track);
+    return uuid;
+  }
+
+  uint64_t AsyncTrack(const TraceRecord& record) {
+    auto it = async_tracks_.find({record.name, record.id});
+    if (it != async_tracks_.end())
+      return it->second;
+    const uint64_t uuid = next_track_uuid_++;
+    async_tracks_.emplace(std::make_pair(record.name, record.id), uuid);
+    ProtoWriter track;
+    track.AddVarint(kTrackDescriptorUuid, uuid);
+    track.AddString(kTrackDescriptorName, record.name);
+    WriteTrackDescriptor(track);
+    return uuid;
+  }
+
+  uint64_t CounterTrack(const TraceRecord& record) {
+    auto it = counter_tracks_.find(record.name);
+    if (it != counter_tracks_.end())
+      return it->second;
+    const uint64_t uuid = next_track_uuid_++;
+    counter_tracks_.emplace(record.name, uuid);
+    ProtoWriter track;
+    track.AddVarint(kTrackDescriptorUuid, uuid);
+    track.AddString(kTrackDescriptorName, record.name);
+    track.AddMessage(kTrackDescriptorCounter, ProtoWriter());
+    WriteTrackDescriptor(track);
+    return uuid;
+  }
+
+  static void AddCounterValue(const TraceRecord& record, ProtoWriter* event) {
+    if (record.num_args == 0)
+      return;
+    switch (record.arg_types[0]) {
+      case TRACE_VALUE_TYPE_DOUBLE:
+        event->AddDouble(kTrackEventDoubleCounterValue,
+                         record.arg_values[0].as_double);
+        break;
+      case TRACE_VALUE_TYPE_BOOL:
+        event->AddVarint(kTrackEventCounterValue,
+                         record.arg_values[0].as_bool ? 1 : 0);
+        break;
+      default:
+        event->AddVarint(kTrackEventCounterValue, record.arg_values[0].as_uint);
+        break;
+    }
+  }
+
+  static void AddAnnotationValue(unsigned char type,
+                                 TraceArgValue value,
+                                 ProtoWriter* annotation) {
+    switch (type) {
+      case TRACE_VALUE_TYPE_BOOL:
+        annotation->AddVarint(kDebugAnnotationBoolValue, value.as_bool);
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        annotation->AddVarint(kDebugAnnotationUintValue, value.as_uint);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        annotation->AddVarint(kDebugAnnotationIntValue, value.as_int);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE:
+        annotation->AddDouble(kDebugAnnotationDoubleValue, value.as_double);
+        break;
+      case TRACE_VALUE_TYPE_POINTER:
+        annotation->AddVarint(kDebugAnnotationPointerValue,
+                              reinterpret_cast<uintptr_t>(value.as_pointer));
+        break;
+      case TRACE_VALUE_TYPE_STRING:
+      case TRACE_VALUE_TYPE_COPY_STRING:
+        annotation->AddString(kDebugAnnotationStringValue, value.as_string);
+        break;
+    }
+  }
+
+  void WriteTrackDescriptor(const ProtoWriter& track) {
+    ProtoWriter packet;
+    packet.AddVarint(kTracePacketSequenceId, kSequenceId);
+    packet.AddMessage(kTracePacketTrackDescriptor, track);
+    WritePacket(packet);
+  }
+
+  // Writes |packet| as a repeated field of the Trace proto.
+  void WritePacket(const ProtoWriter& packet) {
+    static constexpr int kTracePacket = 1;
+    ProtoWriter trace;
+    trace.AddMessage(kTracePacket, packet);
+    fwrite(trace.data().data(), 1, trace.data().size(), file_);
+  }
+
+  FILE* const file_;
+  std::map<const char*, uint64_t> category_iids_;
+  std::map<const char*, uint64_t> name_iids_;
+  std::map<const char*, uint64_t> arg_name_iids_;
+  std::map<PlatformThreadId, uint64_t> thread_tracks_;
+  std::map<std::pair<const char*, unsigned long long>, uint64_t> async_tracks_;
+  std::map<const char*, uint64_t> counter_tracks_;
+  uint64_t next_track_uuid_ = 1;
+};
+
 class EventLogger final {
  public:
   EventLogger()
@@ -96,112 +724,87 @@ class EventLogger final {
   void AddTraceEvent(const char* name,
                      const unsigned char* category_enabled,
                      char phase,
+                     unsigned long long id,
                      int num_args,
                      const char** arg_names,
                      const unsigned char* arg_types,
                      const unsigned long long* arg_values,
-                     uint64_t timestamp,
-                     int pid,
-                     rtc::PlatformThreadId thread_id) {
-    std::vector<TraceArg> args(num_args);
+                     unsigned char flags) {
+    ThreadTraceBuffer* buffer = GetThreadBuffer();
+    if (!buffer ||
+        !buffer->Sample(phase,
+                        g_sample_interval.load(std::memory_order_relaxed),
+                        capture_.load(std::memory_order_relaxed))) {
+      return;
+    }
+    TraceRecord* record = buffer->BeginWrite();
+    if (!record) {
+      dropped_events_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    record->name = (flags & TRACE_EVENT_FLAG_COPY) ? CopyString(name) : name;
+    record->category_enabled = category_enabled;
+    record->id = id;
+    record->timestamp_ns = rtc::TimeNanos();
+    record->num_args = static_cast<unsigned char>(num_args);
+    record->flags = flags;
+    record->phase = phase;
+    RTC_DCHECK_LE(num_args, kMaxTraceArgs);
     for (int i = 0; i < num_args; ++i) {
-      TraceArg& arg = args[i];
-      arg.name = arg_names[i];
-      arg.type = arg_types[i];
-      arg.value.as_uint = arg_values[i];
-
+      record->arg_names[i] = arg_names[i];
+      record->arg_types[i] = arg_types[i];
+      record->arg_values[i].as_uint = arg_values[i];
       // Value is a pointer to a temporary string, so we have to make a copy.
-      if (arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
-        // Space for the string and for the terminating null character.
-        size_t str_length = strlen(arg.value.as_string) + 1;
-        char* str_copy = new char[str_length];
-        memcpy(str_copy, arg.value.as_string, str_length);
-        arg.value.as_string = str_copy;
+      if (arg_types[i] == TRACE_VALUE_TYPE_COPY_STRING) {
+        record->arg_values[i].as_string =
+            CopyString(record->arg_values[i].as_string);
       }
     }
-    rtc::CritScope lock(&crit_);
-    trace_events_.push_back(
-        {name, category_enabled, phase, args, timestamp, 1, thread_id});
+    buffer->EndWrite();
   }
 
-  // The TraceEvent format is documented here:
-  // https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
   void Log() {
-    RTC_DCHECK(output_file_);
-    static const int kLoggingIntervalMs = 100;
-    fprintf(output_file_, "{ \"traceEvents\": [\n");
-    bool has_logged_event = false;
+    RTC_DCHECK(writer_);
+    writer_->WriteHeader();
     while (true) {
       bool shutting_down = shutdown_event_.Wait(kLoggingIntervalMs);
-      std::vector<TraceEvent> events;
-      {
-        rtc::CritScope lock(&crit_);
-        trace_events_.swap(events);
-      }
-      std::string args_str;
-      args_str.reserve(kEventLoggerArgsStrBufferInitialSize);
-      for (TraceEvent& e : events) {
-        args_str.clear();
-        if (!e.args.empty()) {
-          args_str += ", \"args\": {";
-          bool is_first_argument = true;
-          for (TraceArg& arg : e.args) {
-            if (!is_first_argument)
-              args_str += ",";
-            is_first_argument = false;
-            args_str += " \"";
-            args_str += arg.name;
-            args_str += "\": ";
-            args_str += TraceArgValueAsString(arg);
-
-            // Delete our copy of the string.
-            if (arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
-              delete[] arg.value.as_string;
-              arg.value.as_string = nullptr;
-            }
-          }
-          args_str += " }";
-        }
-        fprintf(output_file_,
-                "%s{ \"name\": \"%s\""
-                ", \"cat\": \"%s\""
-                ", \"ph\": \"%c\""
-                ", \"ts\": %" PRIu64
-                ", \"pid\": %d"
-#if defined(WEBRTC_WIN)
-                ", \"tid\": %lu"
-#else
-                ", \"tid\": %d"
-#endif  // defined(WEBRTC_WIN)
-                "%s"
-                "}\n",
-                has_logged_event ? "," : " ", e.name, e.category_enabled,
-                e.phase, e.timestamp, e.pid, e.tid, args_str.c_str());
-        has_logged_event = true;
-      }
+      DrainBuffers(writer_.get());
       if (shutting_down)
         break;
     }
-    fprintf(output_file_, "]}\n");
+    writer_->WriteFooter();
+    writer_.reset();
     if (output_file_owned_)
       fclose(output_file_);
     output_file_ = nullptr;
+
+    const int64_t dropped_events = dropped_events_.exchange(0);
+    if (dropped_events > 0) {
+      RTC_LOG(LS_WARNING) << "Dropped " << dropped_events
+                          << " trace events, the trace buffers were full.";
+    }
   }
 
-  void Start(FILE* file, bool owned) {
+  void Start(FILE* file, bool owned, TraceFormat format) {
     RTC_DCHECK(thread_checker_.IsCurrent());
     RTC_DCHECK(file);
     RTC_DCHECK(!output_file_);
     output_file_ = file;
     output_file_owned_ = owned;
-    {
-      rtc::CritScope lock(&crit_);
-      // Since the atomic fast-path for adding events to the queue can be
-      // bypassed while the logging thread is shutting down there may be some
-      // stale events in the queue, hence the vector needs to be cleared to not
-      // log events from a previous logging session (which may be days old).
-      trace_events_.clear();
+    if (format == TraceFormat::kPerfetto) {
+      writer_ = absl::make_unique<PerfettoTraceWriter>(file);
+    } else {
+      writer_ = absl::make_unique<JsonTraceWriter>(file);
     }
+    // Since the atomic fast-path for adding events to the buffers can be
+    // bypassed while the logging thread is shutting down there may be some
+    // stale events buffered, hence the buffers need to be cleared to not log
+    // events from a previous logging session (which may be days old).
+    DrainBuffers(nullptr);
+    dropped_events_.store(0);
+    // Threads reset their sampling state when they see the new capture.
+    // Enabling the logging below publishes it.
+    capture_.fetch_add(1, std::memory_order_relaxed);
     // Enable event logging (fast-path). This should be disabled since starting
     // shouldn't be done twice.
     RTC_CHECK_EQ(0,
@@ -226,98 +829,27 @@ class EventLogger final {
   }
 
  private:
-  struct TraceArg {
-    const char* name;
-    unsigned char type;
-    // Copied from webrtc/rtc_base/trace_event.h TraceValueUnion.
-    union TraceArgValue {
-      bool as_bool;
-      unsigned long long as_uint;
-      long long as_int;
-      double as_double;
-      const void* as_pointer;
-      const char* as_string;
-    } value;
-
-    // Assert that the size of the union is equal to the size of the as_uint
-    // field since we are assigning to arbitrary types using it.
-    static_assert(sizeof(TraceArgValue) == sizeof(unsigned long long),
-                  "Size of TraceArg value union is not equal to the size of "
-                  "the uint field of that union.");
-  };
-
-  struct TraceEvent {
-    const char* name;
-    const unsigned char* category_enabled;
-    char phase;
-    std::vector<TraceArg> args;
-    uint64_t timestamp;
-    int pid;
-    rtc::PlatformThreadId tid;
-  };
-
-  static std::string TraceArgValueAsString(TraceArg arg) {
-    std::string output;
-
-    if (arg.type == TRACE_VALUE_TYPE_STRING ||
-        arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
-      // Space for every character to be an espaced character + two for
-      // quatation marks.
-      output.reserve(strlen(arg.value.as_string) * 2 + 2);
-      output += '\"';
-      const char* c = arg.value.as_string;
-      do {
-        if (*c == '"' || *c == '\\') {
-          output += '\\';
-          output += *c;
-        } else {
-          output += *c;
-        }
-      } while (*++c);
-      output += '\"';
-    } else {
-      output.resize(kTraceArgBufferLength);
-      size_t print_length = 0;
-      switch (arg.type) {
-        case TRACE_VALUE_TYPE_BOOL:
-          if (arg.value.as_bool) {
-            strcpy(&output[0], "true");
-            print_length = 4;
-          } else {
-            strcpy(&output[0], "false");
-            print_length = 5;
-          }
-          break;
-        case TRACE_VALUE_TYPE_UINT:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "%llu",
-                                  arg.value.as_uint);
-          break;
-        case TRACE_VALUE_TYPE_INT:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "%lld",
-                                  arg.value.as_int);
-          break;
-        case TRACE_VALUE_TYPE_DOUBLE:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "%f",
-                                  arg.value.as_double);
-          break;
-        case TRACE_VALUE_TYPE_POINTER:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "\"%p\"",
-                                  arg.value.as_pointer);
-          break;
-      }
-      size_t output_length = print_length < kTraceArgBufferLength
-                                 ? print_length
-                                 : kTraceArgBufferLength - 1;
-      // This will hopefully be very close to nop. On most implementations, it
-      // just writes null byte and sets the length field of the string.
-      output.resize(output_length);
-    }
+  ThreadTraceBuffer* GetThreadBuffer() {
+    return buffers_.GetThreadBuffer(CurrentThreadId());
+  }
 
-    return output;
+  // Writes the buffered events with |writer|, or discards them if it's null.
+  void DrainBuffers(TraceWriter* writer) {
+    buffers_.ReadAll([writer](ThreadTraceBuffer* buffer) {
+      buffer->Read([writer, buffer](const TraceRecord& record) {
+        if (writer)
+          writer->WriteEvent(buffer->thread_id(), record);
+      });
+    });
   }
 
-  rtc::CriticalSection crit_;
-  std::vector<TraceEvent> trace_events_ RTC_GUARDED_BY(crit_);
+  // Read by DrainBuffers(), which runs either on the logging thread or while
+  // it isn't running.
+  ThreadBufferRegistry<ThreadTraceBuffer> buffers_;
+  // Incremented when a capture starts.
+  std::atomic<int> capture_{0};
+  std::unique_ptr<TraceWriter> writer_;
+  std::atomic<int64_t> dropped_events_{0};
   rtc::PlatformThread logging_thread_;
   rtc::Event shutdown_event_;
   rtc::ThreadChecker thread_checker_;
@@ -356,9 +888,8 @@ void InternalAddTraceEvent(char phase,
   if (rtc::AtomicOps::AcquireLoad(&g_event_logging_active) == 0)
     return;
 
-  g_event_logger->AddTraceEvent(name, category_enabled, phase, num_args,
-                                arg_names, arg_types, arg_values,
-                                rtc::TimeMicros(), 1, rtc::CurrentThreadId());
+  g_event_logger->AddTraceEvent(name, category_enabled, phase, id, num_args,
+                                arg_names, arg_types, arg_values, flags);
 }
 
 }  // namespace
@@ -370,26 +901,31 @@ void SetupInternalTracer() {
   webrtc::SetupEventTracer(InternalGetCategoryEnabled, InternalAddTraceEvent);
 }
 
-void StartInternalCaptureToFile(FILE* file) {
+void StartInternalCaptureToFile(FILE* file, TraceFormat format) {
   if (g_event_logger) {
-    g_event_logger->Start(file, false);
+    g_event_logger->Start(file, false, format);
   }
 }
 
-bool StartInternalCapture(const char* filename) {
+bool StartInternalCapture(const char* filename, TraceFormat format) {
   if (!g_event_logger)
     return false;
 
-  FILE* file = fopen(filename, "w");
+  FILE* file = fopen(filename, format == TraceFormat::kPerfetto ? "wb" : "w");
   if (!file) {
     RTC_LOG(LS_ERROR) << "Failed to open trace file '" << filename
                       << "' for writing.";
     return false;
   }
-  g_event_logger->Start(file, true);
+  g_event_logger->Start(file, true, format);
   return true;
 }
 
+void SetInternalTraceSampling(int sample_interval) {
+  RTC_DCHECK_GE(sample_interval, 1);
+  g_sample_interval.store(sample_interval, std::memory_order_relaxed);
+}
+
 void StopInternalCapture() {
   if (g_event_logger) {
     g_event_logger->Stop();
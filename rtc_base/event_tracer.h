@@ -69,11 +69,25 @@ class EventTracer {
 
 namespace rtc {
 namespace tracing {
-// Set up internal event tracer.
+enum class TraceFormat {
+  // JSON Trace Event Format, for chrome://tracing.
+  kChromeJson,
+  // Protobuf trace, for https://ui.perfetto.dev.
+  kPerfetto,
+};
+
+// Set up internal event tracer. Each thread buffers its events without
+// locking, and a background thread writes them out.
 void SetupInternalTracer();
-bool StartInternalCapture(const char* filename);
-void StartInternalCaptureToFile(FILE* file);
+bool StartInternalCapture(const char* filename,
+                          TraceFormat format = TraceFormat::kChromeJson);
+void StartInternalCaptureToFile(FILE* file,
+                                TraceFormat format = TraceFormat::kChromeJson);
 void StopInternalCapture();
+// Records only one in |sample_interval| top-level trace scopes of each thread,
+// together with the events nested in them, and one in |sample_interval| of
+// the other events. 1, the default, records everything.
+void SetInternalTraceSampling(int sample_interval);
 // Make sure we run this, this will tear down the internal tracing.
 void ShutdownInternalTracer();
 }  // namespace tracing
@@ -0,0 +1,125 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/event.h"
+#include "rtc_base/event_tracer.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/trace_event.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace tracing {
+namespace {
+
+// Bursts of scopes that fit in the buffer of a thread, with pauses long
+// enough for the buffers to be written out in between, so that no events are
+// dropped.
+constexpr int kNumBursts = 20;
+constexpr int kScopesPerBurst = 2000;
+constexpr int kPauseMs = 150;
+constexpr int kScopesPerThread = kNumBursts * kScopesPerBurst;
+
+// Traces scopes with an argument, like a packet being processed, and returns
+// the CPU time it took.
+int64_t TraceScopes() {
+  int64_t cpu_time_ns = 0;
+  for (int burst = 0; burst < kNumBursts; ++burst) {
+    const int64_t start_ns = GetThreadCpuTimeNanos();
+    for (int i = 0; i < kScopesPerBurst; ++i) {
+      TRACE_EVENT1("webrtc", "TracePerfTest::Scope", "sequence_number", i);
+    }
+    cpu_time_ns += GetThreadCpuTimeNanos() - start_ns;
+    Event().Wait(kPauseMs);
+  }
+  return cpu_time_ns;
+}
+
+class TracingThread {
+ public:
+  TracingThread() : thread_(&Run, this, "TracingThread") { thread_.Start(); }
+  int64_t Join() {
+    thread_.Stop();
+    return cpu_time_ns_;
+  }
+
+ private:
+  static void Run(void* obj) {
+    TracingThread* thread = static_cast<TracingThread*>(obj);
+    thread->cpu_time_ns_ = TraceScopes();
+  }
+
+  PlatformThread thread_;
+  int64_t cpu_time_ns_ = 0;
+};
+
+// Prints the CPU time per traced scope, a begin and an end event, on
+// |num_threads| threads tracing at the same time.
+void MeasureTracing(const std::string& trace,
+                    bool capture,
+                    TraceFormat format,
+                    int sample_interval,
+                    int num_threads) {
+  SetupInternalTracer();
+  SetInternalTraceSampling(sample_interval);
+  FILE* file = tmpfile();
+  if (capture)
+    StartInternalCaptureToFile(file, format);
+
+  std::vector<std::unique_ptr<TracingThread>> threads;
+  for (int i = 0; i < num_threads; ++i)
+    threads.push_back(absl::make_unique<TracingThread>());
+  int64_t cpu_time_ns = 0;
+  for (auto& thread : threads)
+    cpu_time_ns += thread->Join();
+
+  StopInternalCapture();
+  ShutdownInternalTracer();
+  SetInternalTraceSampling(1);
+  fclose(file);
+
+  webrtc::test::PrintResult(
+      "event_tracer", "", trace,
+      static_cast<double>(cpu_time_ns) / (num_threads * kScopesPerThread),
+      "ns/scope", false);
+}
+
+}  // namespace
+
+TEST(EventTracerPerfTest, NotCapturing) {
+  MeasureTracing("not_capturing", false, TraceFormat::kChromeJson, 1, 1);
+}
+
+TEST(EventTracerPerfTest, ChromeJson) {
+  MeasureTracing("chrome_json", true, TraceFormat::kChromeJson, 1, 1);
+}
+
+TEST(EventTracerPerfTest, ChromeJsonFourThreads) {
+  MeasureTracing("chrome_json_four_threads", true, TraceFormat::kChromeJson, 1,
+                 4);
+}
+
+TEST(EventTracerPerfTest, Perfetto) {
+  MeasureTracing("perfetto", true, TraceFormat::kPerfetto, 1, 1);
+}
+
+TEST(EventTracerPerfTest, PerfettoSampled) {
+  MeasureTracing("perfetto_one_in_ten", true, TraceFormat::kPerfetto, 10, 1);
+}
+
+}  // namespace tracing
+}  // namespace rtc
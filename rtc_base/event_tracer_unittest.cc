@@ -10,6 +10,13 @@
 
 #include "rtc_base/event_tracer.h"
 
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/platform_thread.h"
 #include "rtc_base/trace_event.h"
 #include "test/gtest.h"
 
@@ -36,6 +43,40 @@ class TestStatistics {
   int events_logged_;
 };
 
+// Returns the contents of |file| and closes it.
+std::string ReadAndClose(FILE* file) {
+  std::string contents;
+  rewind(file);
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    contents.append(buffer, read);
+  fclose(file);
+  return contents;
+}
+
+int CountOccurrences(const std::string& str, const std::string& substr) {
+  int count = 0;
+  for (size_t pos = str.find(substr); pos != std::string::npos;
+       pos = str.find(substr, pos + substr.size())) {
+    ++count;
+  }
+  return count;
+}
+
+// Captures the events traced by |trace| with the internal tracer.
+template <typename Closure>
+std::string CaptureInternalTrace(rtc::tracing::TraceFormat format,
+                                 Closure trace) {
+  rtc::tracing::SetupInternalTracer();
+  FILE* file = tmpfile();
+  rtc::tracing::StartInternalCaptureToFile(file, format);
+  trace();
+  rtc::tracing::StopInternalCapture();
+  rtc::tracing::ShutdownInternalTracer();
+  return ReadAndClose(file);
+}
+
 static const unsigned char* GetCategoryEnabledHandler(const char* name) {
   return reinterpret_cast<const unsigned char*>("test");
 }
@@ -69,4 +110,112 @@ TEST(EventTracerTest, ScopedTraceEvent) {
   TestStatistics::Get()->Reset();
 }
 
+TEST(EventTracerTest, InternalTracerWritesChromeJson) {
+  const std::string trace =
+      CaptureInternalTrace(rtc::tracing::TraceFormat::kChromeJson, [] {
+        TRACE_EVENT1("test", "Scope", "value", 42);
+        TRACE_EVENT_INSTANT1("test", "Instant", "str", "quoted\"");
+      });
+  EXPECT_EQ(0u, trace.find("{ \"traceEvents\": ["));
+  EXPECT_EQ(2, CountOccurrences(trace, "\"name\": \"Scope\""));
+  EXPECT_EQ(1, CountOccurrences(trace, "\"ph\": \"B\""));
+  EXPECT_EQ(1, CountOccurrences(trace, "\"ph\": \"E\""));
+  EXPECT_EQ(1, CountOccurrences(trace, "\"value\": 42"));
+  EXPECT_EQ(1, CountOccurrences(trace, "\"str\": \"quoted\\\"\""));
+  EXPECT_EQ(trace.size() - 3, trace.rfind("]}\n"));
+}
+
+TEST(EventTracerTest, InternalTracerWritesEventsOfAllThreads) {
+  static constexpr int kNumThreads = 4;
+  static constexpr int kEventsPerThread = 1000;
+  auto trace_events = [](void*) {
+    for (int i = 0; i < kEventsPerThread; ++i) {
+      TRACE_EVENT0("test", "ThreadScope");
+    }
+  };
+  const std::string trace =
+      CaptureInternalTrace(rtc::tracing::TraceFormat::kChromeJson, [&] {
+        std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+        for (int i = 0; i < kNumThreads; ++i) {
+          threads.push_back(absl::make_unique<rtc::PlatformThread>(
+              trace_events, nullptr, "TraceThread"));
+          threads.back()->Start();
+        }
+        for (auto& thread : threads)
+          thread->Stop();
+      });
+  EXPECT_EQ(2 * kNumThreads * kEventsPerThread,
+            CountOccurrences(trace, "\"name\": \"ThreadScope\""));
+}
+
+TEST(EventTracerTest, InternalTracerSamplesTopLevelScopes) {
+  rtc::tracing::SetInternalTraceSampling(4);
+  const std::string trace =
+      CaptureInternalTrace(rtc::tracing::TraceFormat::kChromeJson, [] {
+        for (int i = 0; i < 20; ++i) {
+          TRACE_EVENT0("test", "Outer");
+          TRACE_EVENT0("test", "Inner");
+        }
+      });
+  rtc::tracing::SetInternalTraceSampling(1);
+  // Begin and end of 5 of the 20 scopes, and of everything nested in them.
+  EXPECT_EQ(10, CountOccurrences(trace, "\"name\": \"Outer\""));
+  EXPECT_EQ(10, CountOccurrences(trace, "\"name\": \"Inner\""));
+}
+
+// A scope left open when a capture stops shouldn't affect the sampling of the
+// next capture.
+TEST(EventTracerTest, InternalTracerResetsSamplingOnStart) {
+  rtc::tracing::SetupInternalTracer();
+  rtc::tracing::SetInternalTraceSampling(3);
+  FILE* first = tmpfile();
+  rtc::tracing::StartInternalCaptureToFile(
+      first, rtc::tracing::TraceFormat::kChromeJson);
+  // Not sampled, after the instant event of the starting tracer.
+  TRACE_EVENT_BEGIN0("test", "Open");
+  rtc::tracing::StopInternalCapture();
+  ReadAndClose(first);
+
+  rtc::tracing::SetInternalTraceSampling(1);
+  FILE* second = tmpfile();
+  rtc::tracing::StartInternalCaptureToFile(
+      second, rtc::tracing::TraceFormat::kChromeJson);
+  TRACE_EVENT_INSTANT0("test", "Instant");
+  rtc::tracing::StopInternalCapture();
+  rtc::tracing::ShutdownInternalTracer();
+  EXPECT_EQ(1, CountOccurrences(ReadAndClose(second), "\"name\": \"Instant\""));
+}
+
+TEST(EventTracerTest, InternalTracerWritesPerfetto) {
+  const std::string trace =
+      CaptureInternalTrace(rtc::tracing::TraceFormat::kPerfetto, [] {
+        for (int i = 0; i < 10; ++i) {
+          TRACE_EVENT1("test", "PerfettoScope", "iteration", i);
+        }
+      });
+  // The trace is a sequence of packets, each a length-delimited field 1.
+  int num_packets = 0;
+  size_t pos = 0;
+  while (pos < trace.size()) {
+    ASSERT_EQ(0x0a, trace[pos++]);
+    uint64_t length = 0;
+    for (int shift = 0;; shift += 7) {
+      ASSERT_LT(pos, trace.size());
+      const uint8_t byte = static_cast<uint8_t>(trace[pos++]);
+      length |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+    pos += length;
+    ++num_packets;
+  }
+  EXPECT_EQ(trace.size(), pos);
+  // The sequence start, a thread track, 20 events and the instant events of
+  // the starting and stopping tracer.
+  EXPECT_EQ(24, num_packets);
+  // Names are interned, so written once.
+  EXPECT_EQ(1, CountOccurrences(trace, "PerfettoScope"));
+  EXPECT_EQ(1, CountOccurrences(trace, "iteration"));
+}
+
 }  // namespace webrtc
@@ -16,9 +16,12 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/types/optional.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/thread_annotations.h"
 
 // Field trial parser functionality. Provides funcitonality to parse field trial
 // argument strings in key:value format. Each parameter is described using
@@ -228,6 +231,38 @@ class FieldTrialFlag : public FieldTrialParameterInterface {
   bool value_;
 };
 
+// Memoizes settings parsed from field trials, for settings that are parsed
+// every time an object such as a stream or an encoder is created. The settings
+// are parsed again only when the values of the trials they're parsed from
+// change, e.g. between tests.
+template <typename T>
+class FieldTrialMemo {
+ public:
+  // Returns a copy of the settings last returned by |parse|, or calls it again
+  // if any of |trial_values|, the values of the trials the settings are parsed
+  // from, changed since.
+  template <typename Parse>
+  T Get(const std::vector<std::string>& trial_values, Parse parse) {
+    std::string values;
+    for (const std::string& value : trial_values) {
+      // Trial values can't contain '/', so the joined values are unique.
+      values.append(value);
+      values.push_back('/');
+    }
+    rtc::CritScope cs(&crit_);
+    if (!settings_ || values != trial_values_) {
+      settings_.emplace(parse());
+      trial_values_ = std::move(values);
+    }
+    return *settings_;
+  }
+
+ private:
+  rtc::CriticalSection crit_;
+  std::string trial_values_ RTC_GUARDED_BY(crit_);
+  absl::optional<T> settings_ RTC_GUARDED_BY(crit_);
+};
+
 // Accepts true, false, else parsed with sscanf %i, true if != 0.
 extern template class FieldTrialParameter<bool>;
 // Interpreted using sscanf %lf.
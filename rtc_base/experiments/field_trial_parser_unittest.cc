@@ -157,4 +157,36 @@ TEST(FieldTrialParserTest, ParsesCustomEnumParameter) {
   EXPECT_EQ(my_enum.Get(), CustomEnum::kBlue);
 }
 
+TEST(FieldTrialParserTest, MemoParsesOnlyWhenTrialValuesChange) {
+  FieldTrialMemo<DummyExperiment> memo;
+  int num_parses = 0;
+  auto parse = [&num_parses] {
+    ++num_parses;
+    return DummyExperiment();
+  };
+  {
+    test::ScopedFieldTrials field_trials("WebRTC-DummyExperiment/f:0.2/");
+    EXPECT_EQ(
+        memo.Get({field_trial::FindFullName(kDummyExperiment)}, parse).factor,
+        0.2);
+    EXPECT_EQ(
+        memo.Get({field_trial::FindFullName(kDummyExperiment)}, parse).factor,
+        0.2);
+    EXPECT_EQ(num_parses, 1);
+  }
+  EXPECT_EQ(
+      memo.Get({field_trial::FindFullName(kDummyExperiment)}, parse).factor,
+      0.5);
+  EXPECT_EQ(num_parses, 2);
+}
+
+TEST(FieldTrialParserTest, MemoTellsTrialValuesApart) {
+  FieldTrialMemo<int> memo;
+  int num_parses = 0;
+  auto parse = [&num_parses] { return ++num_parses; };
+  EXPECT_EQ(memo.Get({"ab", ""}, parse), 1);
+  EXPECT_EQ(memo.Get({"a", "b"}, parse), 2);
+  EXPECT_EQ(memo.Get({"a", "b"}, parse), 2);
+}
+
 }  // namespace webrtc
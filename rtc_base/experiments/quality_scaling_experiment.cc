@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <string>
 
+#include "rtc_base/experiments/field_trial_parser.h"
 #include "rtc_base/logging.h"
 #include "system_wrappers/include/field_trial.h"
 
@@ -42,19 +43,23 @@ bool QualityScalingExperiment::Enabled() {
 
 absl::optional<QualityScalingExperiment::Settings>
 QualityScalingExperiment::ParseSettings() {
+  static FieldTrialMemo<absl::optional<Settings>>* const memo =
+      new FieldTrialMemo<absl::optional<Settings>>();
   const std::string group = webrtc::field_trial::FindFullName(kFieldTrial);
-  if (group.empty())
-    return absl::nullopt;
+  return memo->Get({group}, [&group]() -> absl::optional<Settings> {
+    if (group.empty())
+      return absl::nullopt;
 
-  Settings s;
-  if (sscanf(group.c_str(), "Enabled-%d,%d,%d,%d,%d,%d,%d,%d,%f,%f,%d",
-             &s.vp8_low, &s.vp8_high, &s.vp9_low, &s.vp9_high, &s.h264_low,
-             &s.h264_high, &s.generic_low, &s.generic_high, &s.alpha_high,
-             &s.alpha_low, &s.drop) != 11) {
-    RTC_LOG(LS_WARNING) << "Invalid number of parameters provided.";
-    return absl::nullopt;
-  }
-  return s;
+    Settings s;
+    if (sscanf(group.c_str(), "Enabled-%d,%d,%d,%d,%d,%d,%d,%d,%f,%f,%d",
+               &s.vp8_low, &s.vp8_high, &s.vp9_low, &s.vp9_high, &s.h264_low,
+               &s.h264_high, &s.generic_low, &s.generic_high, &s.alpha_high,
+               &s.alpha_low, &s.drop) != 11) {
+      RTC_LOG(LS_WARNING) << "Invalid number of parameters provided.";
+      return absl::nullopt;
+    }
+    return s;
+  });
 }
 
 absl::optional<VideoEncoder::QpThresholds>
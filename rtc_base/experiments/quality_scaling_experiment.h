@@ -42,7 +42,8 @@ class QualityScalingExperiment {
   // Returns true if the experiment is enabled.
   static bool Enabled();
 
-  // Returns settings from field trial.
+  // Returns settings from field trial. Parsed once for as long as the field
+  // trial doesn't change, since every encoder asks for its QP thresholds.
   static absl::optional<Settings> ParseSettings();
 
   // Returns QpThresholds for the |codec_type|.
@@ -13,9 +13,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <iterator>
 #include <string>
+#include <vector>
 
 #include "api/transport/field_trial_based_config.h"
+#include "rtc_base/checks.h"
 #include "rtc_base/experiments/field_trial_parser.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_conversions.h"
@@ -33,14 +37,46 @@ const char kVp8TrustedRateControllerFieldTrialName[] =
 const char kVp9TrustedRateControllerFieldTrialName[] =
     "WebRTC-LibvpxVp9TrustedRateController";
 
-const char* kVideoHysteresisFieldTrialname =
+const char kVideoHysteresisFieldTrialname[] =
     "WebRTC-SimulcastUpswitchHysteresisPercent";
 const double kDefaultVideoHysteresisFactor = 1.0;
-const char* kScreenshareHysteresisFieldTrialname =
+const char kScreenshareHysteresisFieldTrialname[] =
     "WebRTC-SimulcastScreenshareUpswitchHysteresisPercent";
+
+const char kCongestionWindowFieldTrialName[] = "WebRTC-CongestionWindow";
+const char kVideoRateControlFieldTrialName[] = "WebRTC-VideoRateControl";
 // Default to 35% hysteresis for simulcast screenshare.
 const double kDefaultScreenshareHysteresisFactor = 1.35;
 
+// All the field trials the settings are parsed from. ParseFromFieldTrials()
+// parses the settings again only when one of these changes.
+const char* const kFieldTrialNames[] = {
+    kCongestionWindowFieldTrialName,
+    kVideoRateControlFieldTrialName,
+    kVp8TrustedRateControllerFieldTrialName,
+    kVp9TrustedRateControllerFieldTrialName,
+    kVideoHysteresisFieldTrialname,
+    kScreenshareHysteresisFieldTrialname,
+};
+
+// Looks up field trials like FieldTrialBasedConfig, and checks that they are
+// listed in kFieldTrialNames. A trial that the constructor reads but that
+// isn't listed would leave ParseFromFieldTrials() with stale settings.
+class ListedFieldTrialsConfig : public WebRtcKeyValueConfig {
+ public:
+  std::string Lookup(absl::string_view key) const override {
+    RTC_DCHECK(std::find_if(std::begin(kFieldTrialNames),
+                            std::end(kFieldTrialNames),
+                            [key](const char* name) { return key == name; }) !=
+               std::end(kFieldTrialNames))
+        << "Add " << key << " to kFieldTrialNames.";
+    return field_trial_config_.Lookup(key);
+  }
+
+ private:
+  const FieldTrialBasedConfig field_trial_config_;
+};
+
 bool IsEnabled(const WebRtcKeyValueConfig* const key_value_config,
                absl::string_view key) {
   return key_value_config->Lookup(key).find("Enabled") == 0;
@@ -89,21 +125,29 @@ RateControlSettings::RateControlSettings(
       vp8_dynamic_rate_("vp8_dynamic_rate", false),
       vp9_dynamic_rate_("vp9_dynamic_rate", false) {
   ParseFieldTrial({&congestion_window_, &congestion_window_pushback_},
-                  key_value_config->Lookup("WebRTC-CongestionWindow"));
+                  key_value_config->Lookup(kCongestionWindowFieldTrialName));
   ParseFieldTrial(
       {&pacing_factor_, &alr_probing_, &vp8_qp_max_, &trust_vp8_, &trust_vp9_,
        &video_hysteresis_, &screenshare_hysteresis_, &probe_max_allocation_,
        &bitrate_adjuster_, &adjuster_use_headroom_, &vp8_s0_boost_,
        &vp8_dynamic_rate_, &vp9_dynamic_rate_},
-      key_value_config->Lookup("WebRTC-VideoRateControl"));
+      key_value_config->Lookup(kVideoRateControlFieldTrialName));
 }
 
 RateControlSettings::~RateControlSettings() = default;
+RateControlSettings::RateControlSettings(const RateControlSettings&) = default;
 RateControlSettings::RateControlSettings(RateControlSettings&&) = default;
 
 RateControlSettings RateControlSettings::ParseFromFieldTrials() {
-  FieldTrialBasedConfig field_trial_config;
-  return RateControlSettings(&field_trial_config);
+  static FieldTrialMemo<RateControlSettings>* const memo =
+      new FieldTrialMemo<RateControlSettings>();
+  ListedFieldTrialsConfig field_trial_config;
+  std::vector<std::string> trial_values;
+  for (const char* name : kFieldTrialNames)
+    trial_values.push_back(field_trial_config.Lookup(name));
+  return memo->Get(trial_values, [&field_trial_config] {
+    return RateControlSettings(&field_trial_config);
+  });
 }
 
 RateControlSettings RateControlSettings::ParseFromKeyValueConfig(
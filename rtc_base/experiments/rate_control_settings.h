@@ -23,8 +23,11 @@ namespace webrtc {
 class RateControlSettings final {
  public:
   ~RateControlSettings();
+  RateControlSettings(const RateControlSettings&);
   RateControlSettings(RateControlSettings&&);
 
+  // Parsed once for as long as the field trials don't change, since every
+  // stream and encoder asks for the settings.
   static RateControlSettings ParseFromFieldTrials();
   static RateControlSettings ParseFromKeyValueConfig(
       const WebRtcKeyValueConfig* const key_value_config);
@@ -0,0 +1,86 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/hmac_sha1.h"
+
+#include <openssl/sha.h>
+#include <string.h>
+
+namespace rtc {
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+static_assert(HmacSha1::kDigestSize == SHA_DIGEST_LENGTH,
+              "Unexpected SHA-1 digest size");
+
+}  // namespace
+
+HmacSha1::HmacSha1() {
+  SetKey(std::string());
+}
+
+HmacSha1::HmacSha1(const std::string& key) {
+  SetKey(key);
+}
+
+void HmacSha1::SetKey(const std::string& key) {
+  static_assert(sizeof(SHA_CTX) <= kStateSize, "kStateSize is too small");
+  key_ = key;
+
+  // Keys longer than a block are replaced by their hash.
+  uint8_t block[kBlockSize] = {0};
+  if (key.size() > kBlockSize) {
+    SHA1(reinterpret_cast<const uint8_t*>(key.data()), key.size(), block);
+  } else {
+    memcpy(block, key.data(), key.size());
+  }
+
+  uint8_t pad[kBlockSize];
+  SHA_CTX context;
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    pad[i] = block[i] ^ 0x36;
+  }
+  SHA1_Init(&context);
+  SHA1_Update(&context, pad, kBlockSize);
+  memcpy(inner_state_, &context, sizeof(context));
+
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    pad[i] = block[i] ^ 0x5c;
+  }
+  SHA1_Init(&context);
+  SHA1_Update(&context, pad, kBlockSize);
+  memcpy(outer_state_, &context, sizeof(context));
+}
+
+void HmacSha1::Compute(std::initializer_list<ArrayView<const uint8_t>> parts,
+                       uint8_t* digest) const {
+  SHA_CTX context;
+  memcpy(&context, inner_state_, sizeof(context));
+  for (const ArrayView<const uint8_t>& part : parts) {
+    SHA1_Update(&context, part.data(), part.size());
+  }
+  uint8_t inner_digest[kDigestSize];
+  SHA1_Final(inner_digest, &context);
+
+  memcpy(&context, outer_state_, sizeof(context));
+  SHA1_Update(&context, inner_digest, kDigestSize);
+  SHA1_Final(digest, &context);
+}
+
+void HmacSha1::Compute(const void* input,
+                       size_t in_len,
+                       uint8_t* digest) const {
+  Compute(
+      {ArrayView<const uint8_t>(static_cast<const uint8_t*>(input), in_len)},
+      digest);
+}
+
+}  // namespace rtc
@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_HMAC_SHA1_H_
+#define RTC_BASE_HMAC_SHA1_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <initializer_list>
+#include <string>
+
+#include "api/array_view.h"
+
+namespace rtc {
+
+// HMAC-SHA1 (RFC 2104) with a fixed key. The SHA-1 states after hashing the
+// inner and outer key pads are computed once, when the key is set, so that
+// computing a MAC hashes two blocks less than ComputeHmac() and never
+// allocates memory. This is meant for the short keys used for the STUN
+// MESSAGE-INTEGRITY of every ICE connectivity check.
+class HmacSha1 {
+ public:
+  static constexpr size_t kDigestSize = 20;
+
+  // Creates an instance with an empty key.
+  HmacSha1();
+  explicit HmacSha1(const std::string& key);
+
+  // Replaces the key and recomputes the pad states.
+  void SetKey(const std::string& key);
+  const std::string& key() const { return key_; }
+
+  // Computes the MAC of the concatenation of |parts| and writes it to
+  // |digest|, which must hold kDigestSize bytes.
+  void Compute(std::initializer_list<ArrayView<const uint8_t>> parts,
+               uint8_t* digest) const;
+  void Compute(const void* input, size_t in_len, uint8_t* digest) const;
+
+ private:
+  // Large enough for the SHA-1 context of both OpenSSL and BoringSSL; checked
+  // in the .cc file.
+  static constexpr size_t kStateSize = 128;
+
+  std::string key_;
+  alignas(8) uint8_t inner_state_[kStateSize];
+  alignas(8) uint8_t outer_state_[kStateSize];
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_HMAC_SHA1_H_
@@ -0,0 +1,76 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/hmac_sha1.h"
+
+#include <string.h>
+
+#include <string>
+
+#include "rtc_base/message_digest.h"
+#include "rtc_base/string_encode.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+std::string ComputeHex(const HmacSha1& hmac, const std::string& input) {
+  uint8_t digest[HmacSha1::kDigestSize];
+  hmac.Compute(input.data(), input.size(), digest);
+  return hex_encode(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+}  // namespace
+
+// Test vectors from RFC 2202.
+TEST(HmacSha1Test, Rfc2202TestVectors) {
+  EXPECT_EQ("b617318655057264e28bc0b6fb378c8ef146be00",
+            ComputeHex(HmacSha1(std::string(20, '\x0b')), "Hi There"));
+  EXPECT_EQ("effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+            ComputeHex(HmacSha1("Jefe"), "what do ya want for nothing?"));
+  EXPECT_EQ("125d7342b9ac11cd91a39af48aa17b4f63f175d3",
+            ComputeHex(HmacSha1(std::string(20, '\xaa')),
+                       std::string(50, '\xdd')));
+  // A key larger than the block size.
+  EXPECT_EQ(
+      "aa4ae5e15272d00e95705637ce8a3b55ed402112",
+      ComputeHex(HmacSha1(std::string(80, '\xaa')),
+                 "Test Using Larger Than Block-Size Key - Hash Key First"));
+}
+
+TEST(HmacSha1Test, MatchesComputeHmac) {
+  const std::string input = "The quick brown fox jumps over the lazy dog";
+  HmacSha1 hmac;
+  for (size_t key_len : {0, 1, 22, 63, 64, 65, 200}) {
+    const std::string key(key_len, 'k');
+    hmac.SetKey(key);
+    EXPECT_EQ(key, hmac.key());
+    std::string expected;
+    ASSERT_TRUE(ComputeHmac(DIGEST_SHA_1, key, input, &expected));
+    EXPECT_EQ(expected, ComputeHex(hmac, input));
+  }
+}
+
+// Verifies that a MAC computed over several parts equals the MAC of their
+// concatenation.
+TEST(HmacSha1Test, ComputesOverConcatenatedParts) {
+  const HmacSha1 hmac("password");
+  const uint8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  uint8_t whole[HmacSha1::kDigestSize];
+  uint8_t parts[HmacSha1::kDigestSize];
+  hmac.Compute(data, sizeof(data), whole);
+  hmac.Compute({ArrayView<const uint8_t>(data, 3),
+                ArrayView<const uint8_t>(data + 3, 0),
+                ArrayView<const uint8_t>(data + 3, sizeof(data) - 3)},
+               parts);
+  EXPECT_EQ(0, memcmp(whole, parts, sizeof(whole)));
+}
+
+}  // namespace rtc
@@ -11,11 +11,13 @@
 #include "rtc_base/log_sinks.h"
 
 #include <string.h>
+#include <algorithm>
 #include <cstdio>
 #include <string>
 
 #include "rtc_base/checks.h"
 #include "rtc_base/stream.h"
+#include "rtc_base/strings/string_builder.h"
 
 namespace rtc {
 
@@ -72,4 +74,175 @@ CallSessionFileRotatingLogSink::CallSessionFileRotatingLogSink(
 
 CallSessionFileRotatingLogSink::~CallSessionFileRotatingLogSink() {}
 
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t size) {
+  size_t rounded = 1;
+  while (rounded < size)
+    rounded <<= 1;
+  return rounded;
+}
+
+}  // namespace
+
+// Ring buffer written by one logging thread and read by the drain thread.
+// Positions grow without wrapping; the index into |data_| is the position
+// modulo the buffer size. A message is published by advancing |write_pos_|
+// after all of it is copied, so the reader only ever sees whole messages.
+class AsyncFileRotatingLogSink::ThreadBuffer {
+ public:
+  explicit ThreadBuffer(size_t size)
+      : data_(new char[size]), mask_(size - 1) {}
+
+  // Returns false if the message doesn't fit. Sets |*half_full| if this
+  // message made the buffer cross half of its size.
+  bool Write(const char* tag, const std::string& message, bool* half_full) {
+    const size_t size = mask_ + 1;
+    const size_t tag_length = tag ? strlen(tag) : 0;
+    const size_t length = (tag ? tag_length + 2 : 0) + message.size();
+    const size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+    const size_t used = write_pos - read_pos_.load(std::memory_order_acquire);
+    if (length > size - used)
+      return false;
+    size_t pos = write_pos;
+    if (tag) {
+      pos = Copy(pos, tag, tag_length);
+      pos = Copy(pos, ": ", 2);
+    }
+    pos = Copy(pos, message.data(), message.size());
+    write_pos_.store(pos, std::memory_order_release);
+    *half_full = used <= size / 2 && used + length > size / 2;
+    return true;
+  }
+
+  // Writes everything buffered so far to |stream|.
+  void Read(StreamInterface* stream) {
+    const size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    if (read_pos == write_pos)
+      return;
+    const size_t begin = read_pos & mask_;
+    const size_t length = write_pos - read_pos;
+    const size_t first = std::min(length, mask_ + 1 - begin);
+    stream->WriteAll(&data_[begin], first, nullptr, nullptr);
+    if (first < length)
+      stream->WriteAll(&data_[0], length - first, nullptr, nullptr);
+    read_pos_.store(write_pos, std::memory_order_release);
+  }
+
+ private:
+  size_t Copy(size_t pos, const char* data, size_t length) {
+    const size_t begin = pos & mask_;
+    const size_t first = std::min(length, mask_ + 1 - begin);
+    memcpy(&data_[begin], data, first);
+    memcpy(&data_[0], data + first, length - first);
+    return pos + length;
+  }
+
+  const std::unique_ptr<char[]> data_;
+  const size_t mask_;
+  std::atomic<size_t> write_pos_{0};
+  std::atomic<size_t> read_pos_{0};
+};
+
+constexpr size_t AsyncFileRotatingLogSink::kDefaultBufferSize;
+constexpr int AsyncFileRotatingLogSink::kDrainIntervalMs;
+
+AsyncFileRotatingLogSink::AsyncFileRotatingLogSink(
+    const std::string& log_dir_path,
+    const std::string& log_prefix,
+    size_t max_log_size,
+    size_t num_log_files,
+    size_t buffer_size)
+    : buffer_size_(RoundUpToPowerOfTwo(buffer_size)),
+      stream_(new FileRotatingStream(log_dir_path,
+                                     log_prefix,
+                                     max_log_size,
+                                     num_log_files)),
+      drain_thread_(&AsyncFileRotatingLogSink::DrainThread,
+                    this,
+                    "LogDrainThread",
+                    kLowPriority) {
+  RTC_DCHECK_GT(buffer_size, 0);
+}
+
+AsyncFileRotatingLogSink::~AsyncFileRotatingLogSink() {
+  quit_.store(true);
+  wake_up_.Set();
+  drain_thread_.Stop();
+  Flush();
+}
+
+void AsyncFileRotatingLogSink::OnLogMessage(const std::string& message) {
+  Append(nullptr, message);
+}
+
+void AsyncFileRotatingLogSink::OnLogMessage(const std::string& message,
+                                            LoggingSeverity sev,
+                                            const char* tag) {
+  Append(tag, message);
+}
+
+bool AsyncFileRotatingLogSink::Init() {
+  {
+    CritScope cs(&drain_crit_);
+    if (!stream_->Open())
+      return false;
+  }
+  if (!drain_thread_.IsRunning())
+    drain_thread_.Start();
+  return true;
+}
+
+void AsyncFileRotatingLogSink::Flush() {
+  CritScope cs(&drain_crit_);
+  Drain();
+  if (stream_->GetState() == SS_OPEN)
+    stream_->Flush();
+}
+
+size_t AsyncFileRotatingLogSink::num_thread_buffers() {
+  return buffers_.size();
+}
+
+void AsyncFileRotatingLogSink::Append(const char* tag,
+                                      const std::string& message) {
+  bool half_full = false;
+  ThreadBuffer* buffer = buffers_.GetThreadBuffer(buffer_size_);
+  if (!buffer || !buffer->Write(tag, message, &half_full)) {
+    dropped_messages_.fetch_add(1, std::memory_order_relaxed);
+    half_full = true;
+  }
+  if (half_full)
+    wake_up_.Set();
+}
+
+void AsyncFileRotatingLogSink::Drain() {
+  if (stream_->GetState() != SS_OPEN)
+    return;
+  StreamInterface* stream = stream_.get();
+  buffers_.ReadAll([stream](ThreadBuffer* buffer) { buffer->Read(stream); });
+
+  const int64_t dropped = dropped_messages_.load(std::memory_order_relaxed);
+  if (dropped > reported_dropped_messages_) {
+    char note[64];
+    SimpleStringBuilder builder(note);
+    builder << "[" << (dropped - reported_dropped_messages_)
+            << " log messages dropped]\n";
+    stream_->WriteAll(builder.str(), builder.size(), nullptr, nullptr);
+    reported_dropped_messages_ = dropped;
+  }
+}
+
+// static
+void AsyncFileRotatingLogSink::DrainThread(void* param) {
+  AsyncFileRotatingLogSink* sink =
+      static_cast<AsyncFileRotatingLogSink*>(param);
+  while (!sink->quit_.load()) {
+    sink->wake_up_.Wait(kDrainIntervalMs);
+    CritScope cs(&sink->drain_crit_);
+    sink->Drain();
+  }
+}
+
 }  // namespace rtc
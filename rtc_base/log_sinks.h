@@ -12,12 +12,19 @@
 #define RTC_BASE_LOG_SINKS_H_
 
 #include <stddef.h>
+#include <stdint.h>
+#include <atomic>
 #include <memory>
 #include <string>
 
 #include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
 #include "rtc_base/file_rotating_stream.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/thread_annotations.h"
+#include "rtc_base/thread_buffer_registry.h"
 
 namespace rtc {
 
@@ -67,6 +74,72 @@ class CallSessionFileRotatingLogSink : public FileRotatingLogSink {
   RTC_DISALLOW_COPY_AND_ASSIGN(CallSessionFileRotatingLogSink);
 };
 
+// Log sink that writes to a FileRotatingStream from a background thread.
+// Each logging thread appends its messages to a lock-free ring buffer of its
+// own, so that logging doesn't wait for the disk or for other logging
+// threads. The buffers are drained every |kDrainIntervalMs|, or sooner when
+// one of them is half full. Messages that don't fit in their thread's buffer
+// are dropped, and the number of dropped messages is written to the log.
+// Messages of different threads may be written out of order within a drain.
+// Init() must be called before adding this sink, on the thread that creates
+// and destroys it.
+class AsyncFileRotatingLogSink : public LogSink {
+ public:
+  static constexpr size_t kDefaultBufferSize = 256 * 1024;
+  static constexpr int kDrainIntervalMs = 100;
+
+  // |num_log_files| must be greater than 1 and |max_log_size| must be greater
+  // than 0. |buffer_size| is the size of the buffer of each logging thread,
+  // and is rounded up to a power of two.
+  AsyncFileRotatingLogSink(const std::string& log_dir_path,
+                           const std::string& log_prefix,
+                           size_t max_log_size,
+                           size_t num_log_files,
+                           size_t buffer_size = kDefaultBufferSize);
+  ~AsyncFileRotatingLogSink() override;
+
+  void OnLogMessage(const std::string& message) override;
+  void OnLogMessage(const std::string& message,
+                    LoggingSeverity sev,
+                    const char* tag) override;
+
+  // Deletes any existing files in the directory, creates a new log file and
+  // starts the drain thread.
+  bool Init();
+
+  // Writes all buffered messages to the stream, and flushes it.
+  void Flush();
+
+  int64_t dropped_messages() const { return dropped_messages_.load(); }
+
+  // The number of logging threads with a buffer. The buffer of a thread that
+  // has exited is freed once the drain thread has written it out.
+  size_t num_thread_buffers();
+
+ private:
+  class ThreadBuffer;
+
+  void Append(const char* tag, const std::string& message);
+  void Drain() RTC_EXCLUSIVE_LOCKS_REQUIRED(drain_crit_);
+  static void DrainThread(void* param);
+
+  const size_t buffer_size_;
+  // Read by Drain(), with |drain_crit_| held.
+  ThreadBufferRegistry<ThreadBuffer> buffers_;
+
+  CriticalSection drain_crit_;
+  const std::unique_ptr<FileRotatingStream> stream_
+      RTC_PT_GUARDED_BY(drain_crit_);
+  int64_t reported_dropped_messages_ RTC_GUARDED_BY(drain_crit_) = 0;
+
+  std::atomic<int64_t> dropped_messages_{0};
+  std::atomic<bool> quit_{false};
+  Event wake_up_;
+  PlatformThread drain_thread_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(AsyncFileRotatingLogSink);
+};
+
 }  // namespace rtc
 
 #endif  // RTC_BASE_LOG_SINKS_H_
@@ -0,0 +1,182 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/file_rotating_stream.h"
+#include "rtc_base/log_sinks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "test/gtest.h"
+#include "test/testsupport/file_utils.h"
+
+namespace rtc {
+
+namespace {
+
+const char kFilePrefix[] = "AsyncFileRotatingLogSinkTest";
+const size_t kMaxFileSize = 1024 * 1024;
+const size_t kNumFiles = 3;
+
+}  // namespace
+
+#if defined(WEBRTC_ANDROID)
+// Fails on Android: https://bugs.chromium.org/p/webrtc/issues/detail?id=4364.
+#define MAYBE_AsyncFileRotatingLogSinkTest DISABLED_AsyncFileRotatingLogSinkTest
+#else
+#define MAYBE_AsyncFileRotatingLogSinkTest AsyncFileRotatingLogSinkTest
+#endif
+
+class MAYBE_AsyncFileRotatingLogSinkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_path_ = webrtc::test::OutputPath();
+    // Append per-test output path in order to run within gtest parallel.
+    dir_path_.append("AsyncFileRotatingLogSinkTest");
+    dir_path_.append(webrtc::test::kPathDelimiter);
+    ASSERT_TRUE(webrtc::test::CreateDir(dir_path_));
+  }
+
+  void TearDown() override {
+    sink_.reset();
+    FileRotatingStream stream(dir_path_, kFilePrefix, kMaxFileSize, kNumFiles);
+    for (size_t i = 0; i < stream.GetNumFiles(); ++i) {
+      // Ignore return value, not all files are expected to exist.
+      webrtc::test::RemoveFile(stream.GetFilePath(i));
+    }
+    EXPECT_TRUE(webrtc::test::RemoveDir(dir_path_));
+  }
+
+  void CreateSink(size_t buffer_size) {
+    sink_ = absl::make_unique<AsyncFileRotatingLogSink>(
+        dir_path_, kFilePrefix, kMaxFileSize, kNumFiles, buffer_size);
+  }
+
+  // Returns the contents of all log files, oldest first.
+  std::string ReadLog() {
+    FileRotatingStreamReader reader(dir_path_, kFilePrefix);
+    std::string contents(reader.GetSize(), '\0');
+    contents.resize(reader.ReadAll(&contents[0], contents.size()));
+    return contents;
+  }
+
+  std::string dir_path_;
+  std::unique_ptr<AsyncFileRotatingLogSink> sink_;
+};
+
+TEST_F(MAYBE_AsyncFileRotatingLogSinkTest, WritesMessagesOnFlush) {
+  CreateSink(AsyncFileRotatingLogSink::kDefaultBufferSize);
+  ASSERT_TRUE(sink_->Init());
+  LogSink* sink = sink_.get();
+  sink->OnLogMessage("first\n");
+  sink->OnLogMessage("second\n", LS_INFO, "Tag");
+  sink_->Flush();
+  EXPECT_EQ("first\nTag: second\n", ReadLog());
+  EXPECT_EQ(0, sink_->dropped_messages());
+}
+
+TEST_F(MAYBE_AsyncFileRotatingLogSinkTest, WritesMessagesOnDestruction) {
+  CreateSink(AsyncFileRotatingLogSink::kDefaultBufferSize);
+  ASSERT_TRUE(sink_->Init());
+  LogMessage::AddLogToStream(sink_.get(), LS_INFO);
+  RTC_LOG(LS_INFO) << "Logged";
+  RTC_LOG(LS_VERBOSE) << "Filtered";
+  LogMessage::RemoveLogToStream(sink_.get());
+  sink_.reset();
+
+  const std::string log = ReadLog();
+  EXPECT_NE(std::string::npos, log.find("Logged"));
+  EXPECT_EQ(std::string::npos, log.find("Filtered"));
+}
+
+TEST_F(MAYBE_AsyncFileRotatingLogSinkTest, DropsMessagesThatDontFit) {
+  CreateSink(64);
+  // Nothing is drained before Init(), so the buffer of this thread fills up.
+  const std::string message(20, 'x');
+  for (int i = 0; i < 10; ++i)
+    sink_->OnLogMessage(message);
+  EXPECT_EQ(7, sink_->dropped_messages());
+
+  ASSERT_TRUE(sink_->Init());
+  sink_->Flush();
+  EXPECT_EQ(message + message + message + "[7 log messages dropped]\n",
+            ReadLog());
+}
+
+// Each thread's messages should be written whole and in order.
+TEST_F(MAYBE_AsyncFileRotatingLogSinkTest, KeepsOrderOfEachThread) {
+  static constexpr int kNumThreads = 4;
+  static constexpr int kMessagesPerThread = 2000;
+  struct LogParams {
+    LogSink* sink;
+    int thread;
+  };
+  auto log_messages = [](void* param) {
+    const LogParams* params = static_cast<const LogParams*>(param);
+    for (int i = 0; i < kMessagesPerThread; ++i) {
+      params->sink->OnLogMessage(std::to_string(params->thread) + " " +
+                                 std::to_string(i) + "\n");
+    }
+  };
+
+  CreateSink(AsyncFileRotatingLogSink::kDefaultBufferSize);
+  ASSERT_TRUE(sink_->Init());
+  std::vector<LogParams> params;
+  std::vector<std::unique_ptr<PlatformThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i)
+    params.push_back({sink_.get(), i});
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(
+        absl::make_unique<PlatformThread>(log_messages, &params[i], "Log"));
+    threads.back()->Start();
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+  sink_->Flush();
+  ASSERT_EQ(0, sink_->dropped_messages());
+
+  std::istringstream log(ReadLog());
+  std::vector<int> next_message(kNumThreads, 0);
+  int thread;
+  int message;
+  while (log >> thread >> message) {
+    ASSERT_GE(thread, 0);
+    ASSERT_LT(thread, kNumThreads);
+    EXPECT_EQ(next_message[thread]++, message);
+  }
+  EXPECT_TRUE(log.eof());
+  for (int i = 0; i < kNumThreads; ++i)
+    EXPECT_EQ(kMessagesPerThread, next_message[i]);
+}
+
+// The buffers of threads that have exited should be written and then freed.
+TEST_F(MAYBE_AsyncFileRotatingLogSinkTest, FreesBuffersOfExitedThreads) {
+  CreateSink(AsyncFileRotatingLogSink::kDefaultBufferSize);
+  ASSERT_TRUE(sink_->Init());
+  for (int i = 0; i < 3; ++i) {
+    PlatformThread thread(
+        [](void* sink) {
+          static_cast<LogSink*>(sink)->OnLogMessage("exited\n");
+        },
+        sink_.get(), "Log");
+    thread.Start();
+    thread.Stop();
+  }
+  sink_->OnLogMessage("running\n");
+  sink_->Flush();
+  EXPECT_EQ("exited\nexited\nexited\nrunning\n", ReadLog());
+  EXPECT_EQ(1u, sink_->num_thread_buffers());
+}
+
+}  // namespace rtc
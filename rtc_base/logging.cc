@@ -31,6 +31,7 @@ static const int kMaxLogLineSize = 1024 - 60;
 #include <string.h>
 #include <time.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <vector>
 
@@ -46,13 +47,14 @@ static const int kMaxLogLineSize = 1024 - 60;
 
 namespace rtc {
 namespace {
-// By default, release builds don't log, debug builds at info level
+// By default, release builds don't log, debug builds at info level.
+// Written under g_log_crit, but read without it on every log statement.
 #if !defined(NDEBUG)
-static LoggingSeverity g_min_sev = LS_INFO;
-static LoggingSeverity g_dbg_sev = LS_INFO;
+static std::atomic<LoggingSeverity> g_min_sev(LS_INFO);
+static std::atomic<LoggingSeverity> g_dbg_sev(LS_INFO);
 #else
-static LoggingSeverity g_min_sev = LS_NONE;
-static LoggingSeverity g_dbg_sev = LS_NONE;
+static std::atomic<LoggingSeverity> g_min_sev(LS_NONE);
+static std::atomic<LoggingSeverity> g_dbg_sev(LS_NONE);
 #endif
 
 // Return the filename portion of the string (that following the last slash).
@@ -197,7 +199,7 @@ LogMessage::~LogMessage() {
 
   const std::string str = print_stream_.Release();
 
-  if (severity_ >= g_dbg_sev) {
+  if (severity_ >= g_dbg_sev.load(std::memory_order_relaxed)) {
 #if defined(WEBRTC_ANDROID)
     OutputToDebug(str, severity_, tag_);
 #else
@@ -228,11 +230,11 @@ rtc::StringBuilder& LogMessage::stream() {
 }
 
 int LogMessage::GetMinLogSeverity() {
-  return g_min_sev;
+  return g_min_sev.load(std::memory_order_relaxed);
 }
 
 LoggingSeverity LogMessage::GetLogToDebug() {
-  return g_dbg_sev;
+  return g_dbg_sev.load(std::memory_order_relaxed);
 }
 int64_t LogMessage::LogStartTime() {
   static const int64_t g_start = SystemTimeMillis();
@@ -253,8 +255,8 @@ void LogMessage::LogTimestamps(bool on) {
 }
 
 void LogMessage::LogToDebug(LoggingSeverity min_sev) {
-  g_dbg_sev = min_sev;
   CritScope cs(&g_log_crit);
+  g_dbg_sev.store(min_sev, std::memory_order_relaxed);
   UpdateMinLogSeverity();
 }
 
@@ -341,12 +343,12 @@ void LogMessage::ConfigureLogging(const char* params) {
 
 void LogMessage::UpdateMinLogSeverity()
     RTC_EXCLUSIVE_LOCKS_REQUIRED(g_log_crit) {
-  LoggingSeverity min_sev = g_dbg_sev;
+  LoggingSeverity min_sev = g_dbg_sev.load(std::memory_order_relaxed);
   for (const auto& kv : streams_) {
     const LoggingSeverity sev = kv.second;
     min_sev = std::min(min_sev, sev);
   }
-  g_min_sev = min_sev;
+  g_min_sev.store(min_sev, std::memory_order_relaxed);
 }
 
 #if defined(WEBRTC_ANDROID)
@@ -443,17 +445,11 @@ void LogMessage::OutputToDebug(const std::string& str,
 
 // static
 bool LogMessage::IsNoop(LoggingSeverity severity) {
-  if (severity >= g_dbg_sev || severity >= g_min_sev)
-    return false;
-
-  // TODO(tommi): We're grabbing this lock for every LogMessage instance that
-  // is going to be logged. This introduces unnecessary synchronization for
-  // a feature that's mostly used for testing.
-  CritScope cs(&g_log_crit);
-  if (streams_.size() > 0)
-    return false;
-
-  return true;
+  // g_min_sev is the lowest severity of the debug output and of all streams,
+  // so a message below it is dropped by all of them and needn't be formatted.
+  // A stream added concurrently may miss a message, like it would if it was
+  // added a moment later.
+  return severity < g_min_sev.load(std::memory_order_relaxed);
 }
 
 void LogMessage::FinishPrintStream() {
@@ -474,10 +474,9 @@ class LogMessage {
   // Useful for configuring logging from the command line.
   static void ConfigureLogging(const char* params);
 
-  // Checks the current global debug severity and if the |streams_| collection
-  // is empty. If |severity| is smaller than the global severity and if the
-  // |streams_| collection is empty, the LogMessage will be considered a noop
-  // LogMessage.
+  // Returns true if |severity| is below the global debug severity and below
+  // the severity of every stream, in which case a LogMessage would be a noop
+  // and needn't be formatted. Doesn't lock.
   static bool IsNoop(LoggingSeverity severity);
 
  private:
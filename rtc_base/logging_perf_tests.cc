@@ -0,0 +1,150 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/file_rotating_stream.h"
+#include "rtc_base/log_sinks.h"
+#include "rtc_base/logging.h"
+#include "test/gtest.h"
+#include "test/testsupport/file_utils.h"
+#include "test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+constexpr int kNumLogCalls = 200000;
+constexpr size_t kMaxLogSize = 10 * 1024 * 1024;
+constexpr size_t kNumLogFiles = 2;
+
+// Sink that drops everything, for sinks that only exist to be filtered out.
+class NullLogSink : public LogSink {
+ public:
+  void OnLogMessage(const std::string& message) override {}
+};
+
+class LoggingPerfTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    debug_sev_ = LogMessage::GetLogToDebug();
+    LogMessage::LogToDebug(LS_NONE);
+    dir_path_ = webrtc::test::OutputPath();
+    dir_path_.append("LoggingPerfTest");
+    dir_path_.append(webrtc::test::kPathDelimiter);
+    ASSERT_TRUE(webrtc::test::CreateDir(dir_path_));
+  }
+
+  void TearDown() override {
+    for (LogSink* sink : sinks_)
+      LogMessage::RemoveLogToStream(sink);
+    file_sink_.reset();
+    async_file_sink_.reset();
+    for (const char* prefix : {"sync", "async"}) {
+      FileRotatingStream stream(dir_path_, prefix, kMaxLogSize, kNumLogFiles);
+      for (size_t i = 0; i < stream.GetNumFiles(); ++i)
+        webrtc::test::RemoveFile(stream.GetFilePath(i));
+    }
+    webrtc::test::RemoveDir(dir_path_);
+    LogMessage::LogToDebug(debug_sev_);
+  }
+
+  void AddSink(LogSink* sink, LoggingSeverity min_sev) {
+    LogMessage::AddLogToStream(sink, min_sev);
+    sinks_.push_back(sink);
+  }
+
+  void AddFileSink(LoggingSeverity min_sev) {
+    file_sink_ = absl::make_unique<FileRotatingLogSink>(
+        dir_path_, "sync", kMaxLogSize, kNumLogFiles);
+    ASSERT_TRUE(file_sink_->Init());
+    AddSink(file_sink_.get(), min_sev);
+  }
+
+  void AddAsyncFileSink(LoggingSeverity min_sev) {
+    async_file_sink_ = absl::make_unique<AsyncFileRotatingLogSink>(
+        dir_path_, "async", kMaxLogSize, kNumLogFiles);
+    ASSERT_TRUE(async_file_sink_->Init());
+    AddSink(async_file_sink_.get(), min_sev);
+  }
+
+  // Logs a typical line at LS_INFO |kNumLogCalls| times and prints the
+  // average CPU time of a call on the logging thread. Work moved to the drain
+  // thread of an async sink isn't counted.
+  void MeasureLogCalls(const std::string& trace) {
+    const std::string name = "peer_connection";
+    const int64_t start_ns = GetThreadCpuTimeNanos();
+    for (int i = 0; i < kNumLogCalls; ++i) {
+      RTC_LOG(LS_INFO) << "Sending packet " << i << " of " << name
+                       << ", size " << 1200 << " bytes";
+    }
+    const int64_t elapsed_ns = GetThreadCpuTimeNanos() - start_ns;
+    if (async_file_sink_)
+      async_file_sink_->Flush();
+    webrtc::test::PrintResult("rtc_log", "", trace,
+                              static_cast<double>(elapsed_ns) / kNumLogCalls,
+                              "ns/call", false);
+    if (async_file_sink_) {
+      webrtc::test::PrintResult("rtc_log", "", trace + "_dropped",
+                                async_file_sink_->dropped_messages(),
+                                "messages", false);
+    }
+  }
+
+  std::string dir_path_;
+  LoggingSeverity debug_sev_;
+  std::vector<LogSink*> sinks_;
+  std::unique_ptr<FileRotatingLogSink> file_sink_;
+  std::unique_ptr<AsyncFileRotatingLogSink> async_file_sink_;
+  NullLogSink null_sinks_[2];
+};
+
+}  // namespace
+
+TEST_F(LoggingPerfTest, NoSinks) {
+  MeasureLogCalls("no_sinks");
+}
+
+// A sink exists, but doesn't want the message.
+TEST_F(LoggingPerfTest, FilteredSink) {
+  AddSink(&null_sinks_[0], LS_ERROR);
+  MeasureLogCalls("filtered_sink");
+}
+
+TEST_F(LoggingPerfTest, OneFileSink) {
+  AddFileSink(LS_INFO);
+  MeasureLogCalls("one_file_sink");
+}
+
+TEST_F(LoggingPerfTest, OneAsyncFileSink) {
+  AddAsyncFileSink(LS_INFO);
+  MeasureLogCalls("one_async_file_sink");
+}
+
+// One sink taking the message and two filtering it out, like when logging to
+// a file while some components only listen for errors.
+TEST_F(LoggingPerfTest, ThreeSinksOneFile) {
+  AddFileSink(LS_INFO);
+  AddSink(&null_sinks_[0], LS_ERROR);
+  AddSink(&null_sinks_[1], LS_ERROR);
+  MeasureLogCalls("three_sinks_one_file");
+}
+
+TEST_F(LoggingPerfTest, ThreeSinksOneAsyncFile) {
+  AddAsyncFileSink(LS_INFO);
+  AddSink(&null_sinks_[0], LS_ERROR);
+  AddSink(&null_sinks_[1], LS_ERROR);
+  MeasureLogCalls("three_sinks_one_async_file");
+}
+
+}  // namespace rtc
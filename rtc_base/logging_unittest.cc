@@ -254,6 +254,28 @@ TEST(LogTest, MultipleStreams) {
   EXPECT_EQ(sev, LogMessage::GetLogToStream(nullptr));
 }
 
+// Messages below the severity of all streams shouldn't be formatted, even
+// when some stream is added.
+TEST(LogTest, IsNoopBelowAllStreams) {
+  const LoggingSeverity debug_sev = LogMessage::GetLogToDebug();
+  LogMessage::LogToDebug(LS_ERROR);
+
+  std::string str;
+  LogSinkImpl<StringStream> stream(&str);
+  LogMessage::AddLogToStream(&stream, LS_INFO);
+  EXPECT_TRUE(LogMessage::IsNoop(LS_VERBOSE));
+  EXPECT_FALSE(LogMessage::IsNoop(LS_INFO));
+  EXPECT_FALSE(LogMessage::IsNoop(LS_ERROR));
+
+  RTC_LOG(LS_VERBOSE) << "VERBOSE";
+  RTC_LOG(LS_INFO) << "INFO";
+  EXPECT_EQ(std::string::npos, str.find("VERBOSE"));
+  EXPECT_NE(std::string::npos, str.find("INFO"));
+
+  LogMessage::RemoveLogToStream(&stream);
+  LogMessage::LogToDebug(debug_sev);
+}
+
 class LogThread {
  public:
   LogThread() : thread_(&ThreadEntry, this, "LogThread") {}
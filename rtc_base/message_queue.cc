@@ -7,6 +7,7 @@
  *  in the file PATENTS.  All contributing project authors may
  *  be found in the AUTHORS file in the root of the source tree.
  */
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -47,6 +48,259 @@ class RTC_SCOPED_LOCKABLE MarkProcessingCritScope {
 };
 }  // namespace
 
+//------------------------------------------------------------------
+// MessageStore
+
+namespace {
+// Recycled nodes kept beyond this are freed, so that a burst of messages does
+// not pin its memory for the lifetime of the queue.
+const size_t kMaxFreeNodes = 1024;
+}  // namespace
+
+struct MessageStore::Node {
+  Message msg;
+  // Set while the node is in |delayed_|.
+  bool delayed = false;
+  // Set when a delayed node has been cleared, but is still in |delayed_|.
+  bool cancelled = false;
+  // Ready list links. |next| also links the free list.
+  Node* prev = nullptr;
+  Node* next = nullptr;
+  // Links of the chain of messages of |msg.phandler|.
+  Node* handler_prev = nullptr;
+  Node* handler_next = nullptr;
+  HandlerChain* chain = nullptr;
+};
+
+MessageStore::MessageStore() = default;
+
+MessageStore::~MessageStore() {
+  // Pending delayed messages are freed with their chains.
+  for (const DelayedEntry& entry : delayed_) {
+    if (entry.node->cancelled)
+      delete entry.node;
+  }
+  for (auto& handler_and_chain : handler_chains_) {
+    Node* node = handler_and_chain.second.head;
+    while (node) {
+      Node* next = node->handler_next;
+      delete node;
+      node = next;
+    }
+  }
+  while (free_nodes_) {
+    Node* next = free_nodes_->next;
+    delete free_nodes_;
+    free_nodes_ = next;
+  }
+}
+
+int64_t MessageStore::next_trigger_ms() const {
+  RTC_DCHECK(!delayed_.empty());
+  return delayed_.front().trigger_ms;
+}
+
+void MessageStore::PushReady(const Message& msg) {
+  AppendReady(NewNode(msg));
+}
+
+void MessageStore::PushDelayed(const Message& msg,
+                               int64_t trigger_ms,
+                               uint32_t num) {
+  Node* node = NewNode(msg);
+  node->delayed = true;
+  delayed_.push_back(DelayedEntry{trigger_ms, num, node});
+  std::push_heap(delayed_.begin(), delayed_.end());
+}
+
+void MessageStore::PromoteDelayed(int64_t now_ms) {
+  // The top of |delayed_| is never cancelled, so that next_trigger_ms() is
+  // that of a pending message.
+  while (!delayed_.empty() && delayed_.front().trigger_ms <= now_ms) {
+    std::pop_heap(delayed_.begin(), delayed_.end());
+    Node* node = delayed_.back().node;
+    delayed_.pop_back();
+    node->delayed = false;
+    AppendReady(node);
+    PruneDelayed();
+  }
+}
+
+bool MessageStore::PopReady(Message* msg) {
+  if (!ready_head_)
+    return false;
+  Node* node = ready_head_;
+  *msg = node->msg;
+  Remove(node);
+  return true;
+}
+
+void MessageStore::Clear(MessageHandler* phandler,
+                         uint32_t id,
+                         MessageList* removed) {
+  auto clear_chain = [this, id, removed](HandlerChain* chain) {
+    Node* node = chain->head;
+    while (node) {
+      Node* next = node->handler_next;
+      if (id == MQID_ANY || id == node->msg.message_id) {
+        if (removed) {
+          removed->push_back(node->msg);
+        } else {
+          delete node->msg.pdata;
+        }
+        Remove(node);
+      }
+      node = next;
+    }
+  };
+
+  if (phandler) {
+    auto it = handler_chains_.find(phandler);
+    if (it != handler_chains_.end()) {
+      clear_chain(&it->second);
+      // Clearing all messages of a handler usually means it is going away, so
+      // drop its chain rather than keeping it around for later posts.
+      if (id == MQID_ANY) {
+        handler_chains_.erase(it);
+        last_chain_ = nullptr;
+      }
+    }
+  } else {
+    last_chain_ = nullptr;
+    for (auto it = handler_chains_.begin(); it != handler_chains_.end();) {
+      clear_chain(&it->second);
+      if (!it->second.head) {
+        it = handler_chains_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  PruneDelayed();
+}
+
+MessageStore::Node* MessageStore::NewNode(const Message& msg) {
+  Node* node;
+  if (free_nodes_) {
+    node = free_nodes_;
+    free_nodes_ = node->next;
+    --num_free_nodes_;
+    node->next = nullptr;
+  } else {
+    node = new Node();
+  }
+  node->msg = msg;
+
+  HandlerChain* chain = GetChain(msg.phandler);
+  node->chain = chain;
+  node->handler_prev = chain->tail;
+  if (chain->tail) {
+    chain->tail->handler_next = node;
+  } else {
+    chain->head = node;
+  }
+  chain->tail = node;
+  return node;
+}
+
+MessageStore::HandlerChain* MessageStore::GetChain(MessageHandler* phandler) {
+  if (!last_chain_ || last_handler_ != phandler) {
+    last_handler_ = phandler;
+    last_chain_ = &handler_chains_[phandler];
+  }
+  return last_chain_;
+}
+
+void MessageStore::Remove(Node* node) {
+  HandlerChain* chain = node->chain;
+  if (node->handler_prev) {
+    node->handler_prev->handler_next = node->handler_next;
+  } else {
+    chain->head = node->handler_next;
+  }
+  if (node->handler_next) {
+    node->handler_next->handler_prev = node->handler_prev;
+  } else {
+    chain->tail = node->handler_prev;
+  }
+  node->chain = nullptr;
+  if (node->delayed) {
+    node->cancelled = true;
+    ++num_cancelled_;
+    return;
+  }
+  UnlinkReady(node);
+  Recycle(node);
+}
+
+void MessageStore::Recycle(Node* node) {
+  if (num_free_nodes_ >= kMaxFreeNodes) {
+    delete node;
+    return;
+  }
+  node->delayed = false;
+  node->cancelled = false;
+  node->handler_prev = nullptr;
+  node->handler_next = nullptr;
+  node->next = free_nodes_;
+  free_nodes_ = node;
+  ++num_free_nodes_;
+}
+
+void MessageStore::AppendReady(Node* node) {
+  node->prev = ready_tail_;
+  node->next = nullptr;
+  if (ready_tail_) {
+    ready_tail_->next = node;
+  } else {
+    ready_head_ = node;
+  }
+  ready_tail_ = node;
+  ++num_ready_;
+}
+
+void MessageStore::UnlinkReady(Node* node) {
+  if (node->prev) {
+    node->prev->next = node->next;
+  } else {
+    ready_head_ = node->next;
+  }
+  if (node->next) {
+    node->next->prev = node->prev;
+  } else {
+    ready_tail_ = node->prev;
+  }
+  node->prev = nullptr;
+  node->next = nullptr;
+  --num_ready_;
+}
+
+void MessageStore::PruneDelayed() {
+  if (num_cancelled_ == 0)
+    return;
+  if (num_cancelled_ > delayed_.size() / 2) {
+    // Keeps the cancelled messages from holding on to more memory than the
+    // pending ones, at a cost proportional to the cancellations.
+    auto new_end = std::remove_if(delayed_.begin(), delayed_.end(),
+                                  [this](const DelayedEntry& entry) {
+                                    if (!entry.node->cancelled)
+                                      return false;
+                                    Recycle(entry.node);
+                                    return true;
+                                  });
+    delayed_.erase(new_end, delayed_.end());
+    std::make_heap(delayed_.begin(), delayed_.end());
+    num_cancelled_ = 0;
+    return;
+  }
+  while (!delayed_.empty() && delayed_.front().node->cancelled) {
+    std::pop_heap(delayed_.begin(), delayed_.end());
+    Recycle(delayed_.back().node);
+    delayed_.pop_back();
+    --num_cancelled_;
+  }
+}
+
 //------------------------------------------------------------------
 // MessageQueueManager
 
@@ -273,21 +527,14 @@ bool MessageQueue::Get(Message* pmsg, int cmsWait, bool process_io) {
         // triggered and calculate the next trigger time.
         if (first_pass) {
           first_pass = false;
-          while (!dmsgq_.empty()) {
-            if (msCurrent < dmsgq_.top().msTrigger_) {
-              cmsDelayNext = TimeDiff(dmsgq_.top().msTrigger_, msCurrent);
-              break;
-            }
-            msgq_.push_back(dmsgq_.top().msg_);
-            dmsgq_.pop();
+          messages_.PromoteDelayed(msCurrent);
+          if (messages_.has_delayed()) {
+            cmsDelayNext = TimeDiff(messages_.next_trigger_ms(), msCurrent);
           }
         }
         // Pull a message off the message queue, if available.
-        if (msgq_.empty()) {
+        if (!messages_.PopReady(pmsg)) {
           break;
-        } else {
-          *pmsg = msgq_.front();
-          msgq_.pop_front();
         }
       }  // crit_ is released here.
 
@@ -368,7 +615,7 @@ void MessageQueue::Post(const Location& posted_from,
     if (time_sensitive) {
       msg.ts_sensitive = TimeMillis() + kMaxMsgLatency;
     }
-    msgq_.push_back(msg);
+    messages_.PushReady(msg);
   }
   WakeUpSocketServer();
 }
@@ -423,8 +670,7 @@ void MessageQueue::DoDelayPost(const Location& posted_from,
     msg.phandler = phandler;
     msg.message_id = id;
     msg.pdata = pdata;
-    DelayedMessage dmsg(cmsDelay, tstamp, dmsgq_next_num_, msg);
-    dmsgq_.push(dmsg);
+    messages_.PushDelayed(msg, tstamp, dmsgq_next_num_);
     // If this message queue processes 1 message every millisecond for 50 days,
     // we will wrap this number.  Even then, only messages with identical times
     // will be misordered, and then only briefly.  This is probably ok.
@@ -437,11 +683,11 @@ void MessageQueue::DoDelayPost(const Location& posted_from,
 int MessageQueue::GetDelay() {
   CritScope cs(&crit_);
 
-  if (!msgq_.empty())
+  if (messages_.has_ready())
     return 0;
 
-  if (!dmsgq_.empty()) {
-    int delay = TimeUntil(dmsgq_.top().msTrigger_);
+  if (messages_.has_delayed()) {
+    int delay = TimeUntil(messages_.next_trigger_ms());
     if (delay < 0)
       delay = 0;
     return delay;
@@ -471,38 +717,7 @@ void MessageQueue::ClearInternal(MessageHandler* phandler,
     fPeekKeep_ = false;
   }
 
-  // Remove from ordered message queue
-
-  for (MessageList::iterator it = msgq_.begin(); it != msgq_.end();) {
-    if (it->Match(phandler, id)) {
-      if (removed) {
-        removed->push_back(*it);
-      } else {
-        delete it->pdata;
-      }
-      it = msgq_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-
-  // Remove from priority queue. Not directly iterable, so use this approach
-
-  PriorityQueue::container_type::iterator new_end = dmsgq_.container().begin();
-  for (PriorityQueue::container_type::iterator it = new_end;
-       it != dmsgq_.container().end(); ++it) {
-    if (it->msg_.Match(phandler, id)) {
-      if (removed) {
-        removed->push_back(it->msg_);
-      } else {
-        delete it->msg_.pdata;
-      }
-    } else {
-      *new_end++ = *it;
-    }
-  }
-  dmsgq_.container().erase(new_end, dmsgq_.container().end());
-  dmsgq_.reheap();
+  messages_.Clear(phandler, id, removed);
 }
 
 void MessageQueue::Dispatch(Message* pmsg) {
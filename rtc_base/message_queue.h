@@ -16,7 +16,7 @@
 #include <algorithm>
 #include <list>
 #include <memory>
-#include <queue>
+#include <unordered_map>
 #include <vector>
 
 #include "api/scoped_refptr.h"
@@ -166,26 +166,83 @@ struct Message {
 
 typedef std::list<Message> MessageList;
 
-// DelayedMessage goes into a priority queue, sorted by trigger time.  Messages
-// with the same trigger time are processed in num_ (FIFO) order.
-
-class DelayedMessage {
+// The pending messages of a MessageQueue. Ready messages are kept in FIFO
+// order, and delayed ones in a heap ordered by trigger time. The messages of
+// each handler, ready or delayed, are also chained together, so that clearing
+// them does not walk the messages of other handlers. Message nodes are
+// recycled, so that posting does not allocate once the queue has warmed up.
+// Not thread safe.
+class MessageStore {
  public:
-  DelayedMessage(int64_t delay,
-                 int64_t trigger,
-                 uint32_t num,
-                 const Message& msg)
-      : cmsDelay_(delay), msTrigger_(trigger), num_(num), msg_(msg) {}
-
-  bool operator<(const DelayedMessage& dmsg) const {
-    return (dmsg.msTrigger_ < msTrigger_) ||
-           ((dmsg.msTrigger_ == msTrigger_) && (dmsg.num_ < num_));
+  MessageStore();
+  ~MessageStore();
+
+  size_t size() const {
+    return num_ready_ + delayed_.size() - num_cancelled_;
   }
+  bool has_ready() const { return ready_head_ != nullptr; }
+  bool has_delayed() const { return !delayed_.empty(); }
+  // Trigger time of the next delayed message. Requires has_delayed().
+  int64_t next_trigger_ms() const;
+
+  void PushReady(const Message& msg);
+  // Delayed messages with the same trigger time become ready in |num| order.
+  void PushDelayed(const Message& msg, int64_t trigger_ms, uint32_t num);
+  // Makes the delayed messages with a trigger time up to |now_ms| ready.
+  void PromoteDelayed(int64_t now_ms);
+  // Removes the first ready message into |msg|, or returns false if there is
+  // none.
+  bool PopReady(Message* msg);
+  // Removes the messages that match |phandler| and |id|, and appends them to
+  // |removed|, or deletes their data if |removed| is null.
+  void Clear(MessageHandler* phandler, uint32_t id, MessageList* removed);
 
-  int64_t cmsDelay_;  // for debugging
-  int64_t msTrigger_;
-  uint32_t num_;
-  Message msg_;
+ private:
+  struct Node;
+  struct HandlerChain {
+    Node* head = nullptr;
+    Node* tail = nullptr;
+  };
+  // Cleared delayed messages are only marked as cancelled, since the heap
+  // cannot remove them in place, and are dropped once they reach its top.
+  struct DelayedEntry {
+    // Orders |delayed_| as a min-heap.
+    bool operator<(const DelayedEntry& other) const {
+      return (other.trigger_ms < trigger_ms) ||
+             ((other.trigger_ms == trigger_ms) && (other.num < num));
+    }
+
+    int64_t trigger_ms;
+    uint32_t num;
+    Node* node;
+  };
+
+  Node* NewNode(const Message& msg);
+  HandlerChain* GetChain(MessageHandler* phandler);
+  // Unlinks |node| from its handler chain, and then either from the ready
+  // list to recycle it, or, if it is delayed, cancels it.
+  void Remove(Node* node);
+  void Recycle(Node* node);
+  void AppendReady(Node* node);
+  void UnlinkReady(Node* node);
+  // Drops the cancelled messages at the top of |delayed_|, or all of them once
+  // they make up most of it.
+  void PruneDelayed();
+
+  Node* ready_head_ = nullptr;
+  Node* ready_tail_ = nullptr;
+  size_t num_ready_ = 0;
+  std::vector<DelayedEntry> delayed_;
+  size_t num_cancelled_ = 0;
+  std::unordered_map<MessageHandler*, HandlerChain> handler_chains_;
+  // Most messages are posted by the same handler as the previous one, so the
+  // last chain looked up is remembered.
+  MessageHandler* last_handler_ = nullptr;
+  HandlerChain* last_chain_ = nullptr;
+  Node* free_nodes_ = nullptr;
+  size_t num_free_nodes_ = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MessageStore);
 };
 
 class MessageQueue {
@@ -262,8 +319,8 @@ class MessageQueue {
 
   bool empty() const { return size() == 0u; }
   size_t size() const {
-    CritScope cs(&crit_);  // msgq_.size() is not thread safe.
-    return msgq_.size() + dmsgq_.size() + (fPeekKeep_ ? 1u : 0u);
+    CritScope cs(&crit_);  // messages_.size() is not thread safe.
+    return messages_.size() + (fPeekKeep_ ? 1u : 0u);
   }
 
   // Internally posts a message which causes the doomed object to be deleted
@@ -279,12 +336,6 @@ class MessageQueue {
   sigslot::signal0<> SignalQueueDestroyed;
 
  protected:
-  class PriorityQueue : public std::priority_queue<DelayedMessage> {
-   public:
-    container_type& container() { return c; }
-    void reheap() { make_heap(c.begin(), c.end(), comp); }
-  };
-
   void DoDelayPost(const Location& posted_from,
                    int64_t cmsDelay,
                    int64_t tstamp,
@@ -310,8 +361,7 @@ class MessageQueue {
 
   bool fPeekKeep_;
   Message msgPeek_;
-  MessageList msgq_ RTC_GUARDED_BY(crit_);
-  PriorityQueue dmsgq_ RTC_GUARDED_BY(crit_);
+  MessageStore messages_ RTC_GUARDED_BY(crit_);
   uint32_t dmsgq_next_num_ RTC_GUARDED_BY(crit_);
   CriticalSection crit_;
   bool fInitialized_;
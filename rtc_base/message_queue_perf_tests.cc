@@ -0,0 +1,149 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/message_queue.h"
+#include "rtc_base/null_socket_server.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+constexpr int kNumMessages = 1000000;
+constexpr int kBurstSize = 1000;
+constexpr int kNumDelayedMessages = 200000;
+constexpr int kMaxDelayMs = 1000;
+constexpr int kNumTimers = 1000;
+constexpr int kNumHandlers = 16;
+constexpr int kMessagesPerHandler = 10000;
+
+class NullMessageHandler : public MessageHandler {
+ public:
+  void OnMessage(Message* msg) override {}
+};
+
+std::unique_ptr<MessageQueue> CreateQueue() {
+  return absl::make_unique<MessageQueue>(absl::make_unique<NullSocketServer>(),
+                                         true);
+}
+
+void PrintRate(const std::string& trace, int messages, int64_t elapsed_us) {
+  webrtc::test::PrintResult(
+      "message_queue", "", trace,
+      messages * static_cast<double>(kNumMicrosecsPerSec) / elapsed_us,
+      "messages/s", true);
+}
+
+}  // namespace
+
+// Posts bursts of messages, and gets each burst before posting the next.
+TEST(MessageQueuePerfTest, PostAndGetBursts) {
+  auto queue = CreateQueue();
+  NullMessageHandler handler;
+  Message msg;
+  const int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumMessages; i += kBurstSize) {
+    for (int j = 0; j < kBurstSize; ++j) {
+      queue->Post(RTC_FROM_HERE, &handler, j);
+    }
+    for (int j = 0; j < kBurstSize; ++j) {
+      ASSERT_TRUE(queue->Get(&msg, 0, false));
+    }
+  }
+  PrintRate("post_and_get_bursts", kNumMessages, TimeMicros() - start_us);
+}
+
+// Keeps a single message in flight, the common case of a mostly idle thread.
+TEST(MessageQueuePerfTest, PostAndGetOneByOne) {
+  auto queue = CreateQueue();
+  NullMessageHandler handler;
+  Message msg;
+  const int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumMessages; ++i) {
+    queue->Post(RTC_FROM_HERE, &handler, i);
+    ASSERT_TRUE(queue->Get(&msg, 0, false));
+  }
+  PrintRate("post_and_get_one_by_one", kNumMessages, TimeMicros() - start_us);
+}
+
+// Posts delayed messages at random trigger times that have all passed, so that
+// the following gets go through the delayed message ordering.
+TEST(MessageQueuePerfTest, PostDelayedAndGet) {
+  auto queue = CreateQueue();
+  NullMessageHandler handler;
+  webrtc::Random random(17);
+  const int64_t now_ms = TimeMillis();
+  Message msg;
+  const int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumDelayedMessages; ++i) {
+    queue->PostAt(RTC_FROM_HERE, now_ms - random.Rand(1, kMaxDelayMs),
+                  &handler, i);
+  }
+  for (int i = 0; i < kNumDelayedMessages; ++i) {
+    ASSERT_TRUE(queue->Get(&msg, 0, false));
+  }
+  PrintRate("post_delayed_and_get", kNumDelayedMessages,
+            TimeMicros() - start_us);
+}
+
+// Keeps a steady set of timers of different handlers pending, and re-arms each
+// timer when it fires, like the STUN and DTLS timers of a network thread. The
+// trigger times have all passed, so that gets do not wait.
+TEST(MessageQueuePerfTest, RearmTimers) {
+  auto queue = CreateQueue();
+  std::vector<NullMessageHandler> handlers(kNumTimers);
+  webrtc::Random random(17);
+  const int64_t now_ms = TimeMillis();
+  for (NullMessageHandler& handler : handlers) {
+    queue->PostAt(RTC_FROM_HERE, now_ms - random.Rand(1, kMaxDelayMs),
+                  &handler);
+  }
+  Message msg;
+  const int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumMessages; ++i) {
+    ASSERT_TRUE(queue->Get(&msg, 0, false));
+    queue->PostAt(RTC_FROM_HERE, now_ms - random.Rand(1, kMaxDelayMs),
+                  msg.phandler);
+  }
+  PrintRate("rearm_timers", kNumMessages, TimeMicros() - start_us);
+  queue->Clear(nullptr);
+}
+
+// Clears the messages of one handler out of a queue holding the messages of
+// many, like when one of several objects using a thread goes away.
+TEST(MessageQueuePerfTest, ClearOneHandler) {
+  auto queue = CreateQueue();
+  std::vector<NullMessageHandler> handlers(kNumHandlers);
+  for (int i = 0; i < kMessagesPerHandler; ++i) {
+    for (NullMessageHandler& handler : handlers) {
+      if (i % 2) {
+        queue->Post(RTC_FROM_HERE, &handler, i);
+      } else {
+        queue->PostDelayed(RTC_FROM_HERE, kMaxDelayMs + i, &handler, i);
+      }
+    }
+  }
+  const int64_t start_us = TimeMicros();
+  queue->Clear(&handlers[0]);
+  const int64_t elapsed_us = TimeMicros() - start_us;
+  EXPECT_EQ(static_cast<size_t>((kNumHandlers - 1) * kMessagesPerHandler),
+            queue->size());
+  webrtc::test::PrintResult("message_queue", "", "clear_one_handler",
+                            static_cast<double>(elapsed_us), "us", false);
+  queue->Clear(nullptr);
+}
+
+}  // namespace rtc
@@ -121,6 +121,197 @@ TEST_F(MessageQueueTest, DiposeHandlerWithPostedMessagePending) {
   EXPECT_TRUE(deleted);
 }
 
+class NullMessageHandler : public MessageHandler {
+ public:
+  void OnMessage(Message* msg) override {}
+};
+
+class FlagMessageData : public MessageData {
+ public:
+  explicit FlagMessageData(bool* deleted) : deleted_(deleted) {}
+  ~FlagMessageData() override { *deleted_ = true; }
+
+ private:
+  bool* deleted_;
+};
+
+TEST_F(MessageQueueTest, DelayedMessagesBecomeReadyAfterPostedMessages) {
+  int64_t now = TimeMillis();
+  Post(RTC_FROM_HERE, nullptr, 0);
+  PostAt(RTC_FROM_HERE, now - 1, nullptr, 2);
+  Post(RTC_FROM_HERE, nullptr, 1);
+  PostDelayed(RTC_FROM_HERE, 10000, nullptr, 3);
+  EXPECT_EQ(4u, size());
+
+  Message msg;
+  for (uint32_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(Get(&msg, 0));
+    EXPECT_EQ(i, msg.message_id);
+  }
+  EXPECT_FALSE(Get(&msg, 0));
+  EXPECT_EQ(1u, size());
+  EXPECT_GT(GetDelay(), 0);
+}
+
+TEST_F(MessageQueueTest, ClearRemovesMatchingMessagesInPostOrder) {
+  NullMessageHandler handler1;
+  NullMessageHandler handler2;
+  int64_t now = TimeMillis();
+  Post(RTC_FROM_HERE, &handler1, 1);
+  Post(RTC_FROM_HERE, &handler2, 1);
+  PostAt(RTC_FROM_HERE, now - 1, &handler1, 2);
+  PostDelayed(RTC_FROM_HERE, 10000, &handler1, 1);
+  Post(RTC_FROM_HERE, &handler2, 2);
+  Post(RTC_FROM_HERE, &handler1, 1);
+
+  MessageList removed;
+  Clear(&handler1, 1, &removed);
+  ASSERT_EQ(3u, removed.size());
+  for (const Message& msg : removed) {
+    EXPECT_EQ(&handler1, msg.phandler);
+    EXPECT_EQ(1u, msg.message_id);
+  }
+  EXPECT_EQ(3u, size());
+
+  removed.clear();
+  Clear(nullptr, 2, &removed);
+  ASSERT_EQ(2u, removed.size());
+  for (const Message& msg : removed) {
+    EXPECT_EQ(2u, msg.message_id);
+  }
+  EXPECT_EQ(1u, size());
+
+  Message msg;
+  EXPECT_TRUE(Get(&msg, 0));
+  EXPECT_EQ(&handler2, msg.phandler);
+  EXPECT_EQ(1u, msg.message_id);
+  EXPECT_FALSE(Get(&msg, 0));
+}
+
+TEST_F(MessageQueueTest, ClearDeletesMessageData) {
+  NullMessageHandler handler;
+  bool ready_deleted = false;
+  bool delayed_deleted = false;
+  Post(RTC_FROM_HERE, &handler, 1, new FlagMessageData(&ready_deleted));
+  PostDelayed(RTC_FROM_HERE, 10000, &handler, 1,
+              new FlagMessageData(&delayed_deleted));
+  Clear(&handler);
+  EXPECT_TRUE(ready_deleted);
+  EXPECT_TRUE(delayed_deleted);
+  EXPECT_EQ(0u, size());
+  EXPECT_TRUE(GetDelay() == kForever);
+}
+
+TEST_F(MessageQueueTest, ClearDelayedMessagesKeepsTriggerOrder) {
+  NullMessageHandler handler1;
+  NullMessageHandler handler2;
+  int64_t now = TimeMillis();
+  // Interleave the handlers, so that clearing one of them removes messages
+  // from all over the delayed messages.
+  auto age_ms = [](uint32_t id) { return 1 + (id * 37) % 100; };
+  for (uint32_t i = 0; i < 100; ++i) {
+    PostAt(RTC_FROM_HERE, now - age_ms(i), i % 2 ? &handler1 : &handler2, i);
+  }
+  Clear(&handler1);
+  EXPECT_EQ(50u, size());
+
+  Message msg;
+  uint32_t last_age_ms = 101;
+  for (size_t i = 0; i < 50; ++i) {
+    ASSERT_TRUE(Get(&msg, 0));
+    EXPECT_EQ(&handler2, msg.phandler);
+    EXPECT_LT(age_ms(msg.message_id), last_age_ms);
+    last_age_ms = age_ms(msg.message_id);
+  }
+  EXPECT_FALSE(Get(&msg, 0));
+}
+
+TEST_F(MessageQueueTest, ClearedDelayedMessagesAreNotDelivered) {
+  NullMessageHandler handler1;
+  NullMessageHandler handler2;
+  int64_t now = TimeMillis();
+  // The earliest message belongs to |handler1|, so clearing it changes the
+  // next trigger time to that of the earliest message of |handler2|.
+  PostAt(RTC_FROM_HERE, now + 10000, &handler1, 0);
+  PostAt(RTC_FROM_HERE, now + 30000, &handler2, 1);
+  PostAt(RTC_FROM_HERE, now + 20000, &handler1, 2);
+  PostAt(RTC_FROM_HERE, now + 40000, &handler2, 3);
+  bool deleted = false;
+  PostAt(RTC_FROM_HERE, now + 50000, &handler1, 4,
+         new FlagMessageData(&deleted));
+
+  Clear(&handler1);
+  EXPECT_TRUE(deleted);
+  EXPECT_EQ(2u, size());
+  int delay = GetDelay();
+  EXPECT_GT(delay, 20000);
+  EXPECT_LE(delay, 30000);
+
+  // Posting again to the cleared handler does not bring back its messages.
+  PostAt(RTC_FROM_HERE, now - 1, &handler1, 5);
+  EXPECT_EQ(3u, size());
+  Message msg;
+  ASSERT_TRUE(Get(&msg, 0));
+  EXPECT_EQ(&handler1, msg.phandler);
+  EXPECT_EQ(5u, msg.message_id);
+  EXPECT_FALSE(Get(&msg, 0));
+  EXPECT_EQ(2u, size());
+}
+
+TEST_F(MessageQueueTest, ClearMostDelayedMessages) {
+  NullMessageHandler handler1;
+  NullMessageHandler handler2;
+  int64_t now = TimeMillis();
+  // The messages of |handler1| are the earliest ones, so clearing them
+  // cancels the top of the delayed messages, and then most of them.
+  for (uint32_t i = 0; i < 100; ++i) {
+    PostAt(RTC_FROM_HERE, now - 200 + i, i < 90 ? &handler1 : &handler2, i);
+  }
+  Clear(&handler1, 1);
+  EXPECT_EQ(99u, size());
+  Clear(&handler1);
+  EXPECT_EQ(10u, size());
+  // Clearing a handler without delayed messages left keeps them as they are.
+  Clear(&handler1);
+  EXPECT_EQ(10u, size());
+
+  Message msg;
+  for (uint32_t i = 90; i < 100; ++i) {
+    ASSERT_TRUE(Get(&msg, 0));
+    EXPECT_EQ(&handler2, msg.phandler);
+    EXPECT_EQ(i, msg.message_id);
+  }
+  EXPECT_FALSE(Get(&msg, 0));
+  EXPECT_EQ(0u, size());
+}
+
+TEST(MessageStoreTest, DestroyWithClearedDelayedMessages) {
+  NullMessageHandler handler1;
+  NullMessageHandler handler2;
+  bool deleted = false;
+  MessageStore store;
+  Message msg;
+  msg.phandler = &handler2;
+  msg.pdata = new FlagMessageData(&deleted);
+  store.PushDelayed(msg, 20000, 0);
+  msg.phandler = &handler1;
+  msg.pdata = nullptr;
+  for (uint32_t i = 0; i < 10; ++i) {
+    msg.message_id = i;
+    store.PushDelayed(msg, 10000 + i, i + 1);
+  }
+  // Leaves the cleared messages in the heap, for the destructor to free.
+  store.Clear(&handler1, 3, nullptr);
+  EXPECT_EQ(10u, store.size());
+  EXPECT_EQ(10000, store.next_trigger_ms());
+  store.Clear(&handler1, 0, nullptr);
+  EXPECT_EQ(9u, store.size());
+  EXPECT_EQ(10001, store.next_trigger_ms());
+  store.Clear(&handler2, MQID_ANY, nullptr);
+  EXPECT_TRUE(deleted);
+  EXPECT_EQ(8u, store.size());
+}
+
 struct UnwrapMainThreadScope {
   UnwrapMainThreadScope() : rewrap_(Thread::Current() != nullptr) {
     if (rewrap_)
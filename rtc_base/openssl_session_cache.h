@@ -26,15 +26,17 @@ namespace rtc {
 
 // The OpenSSLSessionCache maps hostnames to SSL_SESSIONS. This cache is
 // owned by the OpenSSLAdapterFactory and is passed down to each OpenSSLAdapter
-// created with the factory.
-class OpenSSLSessionCache final {
+// created with the factory. OpenSSLStreamAdapters key their sessions by the
+// certificate digests instead, and use the session ticket keys of the
+// SSL_CTX.
+class OpenSSLSessionCache final : public SSLSessionCache {
  public:
   // Creates a new OpenSSLSessionCache using the provided the SSL_CTX and
   // the ssl_mode. The SSL_CTX will be up_refed. ssl_ctx cannot be nullptr,
   // the constructor immediately dchecks this.
   OpenSSLSessionCache(SSLMode ssl_mode, SSL_CTX* ssl_ctx);
   // Frees the cached SSL_SESSIONS and then frees the SSL_CTX.
-  ~OpenSSLSessionCache();
+  ~OpenSSLSessionCache() override;
   // Looks up a session by hostname. The returned SSL_SESSION is not up_refed.
   SSL_SESSION* LookupSession(const std::string& hostname) const;
   // Adds a session to the cache, and up_refs it. Any existing session with the
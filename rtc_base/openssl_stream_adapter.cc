@@ -33,8 +33,10 @@
 #include "rtc_base/openssl_adapter.h"
 #include "rtc_base/openssl_digest.h"
 #include "rtc_base/openssl_identity.h"
+#include "rtc_base/message_digest.h"
 #include "rtc_base/ssl_certificate.h"
 #include "rtc_base/stream.h"
+#include "rtc_base/string_encode.h"
 #include "rtc_base/thread.h"
 #include "rtc_base/time_utils.h"
 
@@ -146,6 +148,12 @@ void TimeCallbackForTesting(const SSL* ssl, struct timeval* out_clock) {
 }
 #endif
 
+// Upper bound on the size of the key name, HMAC key and AES key that session
+// tickets are protected with: 48 bytes in BoringSSL, 80 in OpenSSL.
+constexpr size_t kMaxTicketKeysLength = 80;
+// Sessions are only resumed by contexts with the same session id context.
+constexpr char kSessionIdContext[] = "WebRTC DTLS";
+
 }  // namespace
 
 //////////////////////////////////////////////////////////////////////
@@ -505,6 +513,40 @@ void OpenSSLStreamAdapter::SetInitialRetransmissionTimeout(int timeout_ms) {
   dtls_handshake_timeout_ms_ = timeout_ms;
 }
 
+void OpenSSLStreamAdapter::SetSessionCache(SSLSessionCache* session_cache) {
+  RTC_DCHECK(ssl_ctx_ == nullptr);
+  // OpenSSLStreamAdapter::CreateSessionCache is the only implementation.
+  session_cache_ = static_cast<OpenSSLSessionCache*>(session_cache);
+}
+
+bool OpenSSLStreamAdapter::IsSessionResumed() const {
+  return state_ == SSL_CONNECTED && SSL_session_reused(ssl_);
+}
+
+std::unique_ptr<SSLSessionCache> OpenSSLStreamAdapter::CreateSessionCache(
+    SSLMode mode) {
+  SSL_CTX* ctx =
+      SSL_CTX_new(mode == SSL_MODE_DTLS ? DTLS_method() : TLS_method());
+  if (ctx == nullptr) {
+    return nullptr;
+  }
+  // The contexts of all the adapters sharing the cache copy these keys, so
+  // that any of them can decrypt the tickets issued by the others.
+  unsigned char ticket_keys[kMaxTicketKeysLength];
+  long ticket_keys_length = SSL_CTX_get_tlsext_ticket_keys(ctx, nullptr, 0);
+  if (ticket_keys_length <= 0 ||
+      static_cast<size_t>(ticket_keys_length) > sizeof(ticket_keys) ||
+      RAND_bytes(ticket_keys, ticket_keys_length) != 1 ||
+      !SSL_CTX_set_tlsext_ticket_keys(ctx, ticket_keys, ticket_keys_length)) {
+    SSL_CTX_free(ctx);
+    return nullptr;
+  }
+  auto session_cache = absl::make_unique<OpenSSLSessionCache>(mode, ctx);
+  // The cache holds its own reference.
+  SSL_CTX_free(ctx);
+  return session_cache;
+}
+
 //
 // StreamInterface Implementation
 //
@@ -812,6 +854,16 @@ int OpenSSLStreamAdapter::BeginSSL() {
   SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE |
                          SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 
+  // Offer the session of the last handshake with the same peer, if any. The
+  // server resumes it if it can decrypt the ticket, or else falls back to a
+  // full handshake.
+  if (session_cache_ && role_ == SSL_CLIENT) {
+    SSL_SESSION* session = session_cache_->LookupSession(GetSessionKey());
+    if (session && !SSL_set_session(ssl_, session)) {
+      RTC_LOG(LS_WARNING) << "Failed to set the cached session.";
+    }
+  }
+
   // Do the connect
   return ContinueSSL();
 }
@@ -829,10 +881,26 @@ int OpenSSLStreamAdapter::ContinueSSL() {
   switch (ssl_error) {
     case SSL_ERROR_NONE:
       RTC_LOG(LS_VERBOSE) << " -- success";
+      // A resumed session skips the certificate exchange, so the peer
+      // certificate comes from the session, and is verified here.
+      if (SSL_session_reused(ssl_) && !peer_cert_chain_) {
+        RTC_LOG(LS_INFO) << "Resumed a cached session.";
+        if (!LoadSessionPeerCertificate()) {
+          SignalSSLHandshakeError(SSLHandshakeError::UNKNOWN);
+          return -1;
+        }
+      }
       // By this point, OpenSSL should have given us a certificate, or errored
       // out if one was missing.
       RTC_DCHECK(peer_cert_chain_ || !GetClientAuthEnabled());
 
+      if (session_cache_ && role_ == SSL_CLIENT) {
+        std::string session_key = GetSessionKey();
+        if (!session_key.empty()) {
+          session_cache_->AddSession(session_key, SSL_get1_session(ssl_));
+        }
+      }
+
       state_ = SSL_CONNECTED;
       if (!WaitingToVerifyPeerCertificate()) {
         // We have everything we need to start the connection, so signal
@@ -939,7 +1007,10 @@ void OpenSSLStreamAdapter::OnMessage(Message* msg) {
   if (MSG_TIMEOUT == msg->message_id) {
     RTC_LOG(LS_INFO) << "DTLS timeout expired";
     DTLSv1_handle_timeout(ssl_);
-    ContinueSSL();
+    // The retransmitted flight may complete the handshake, and fail it.
+    if (int err = ContinueSSL()) {
+      Error("ContinueSSL", err, 0, true);
+    }
   } else {
     StreamInterface::OnMessage(msg);
   }
@@ -983,6 +1054,23 @@ SSL_CTX* OpenSSLStreamAdapter::SetupSSLContext() {
     return nullptr;
   }
 
+  if (session_cache_) {
+    unsigned char ticket_keys[kMaxTicketKeysLength];
+    long ticket_keys_length = SSL_CTX_get_tlsext_ticket_keys(ctx, nullptr, 0);
+    if (ticket_keys_length <= 0 ||
+        static_cast<size_t>(ticket_keys_length) > sizeof(ticket_keys) ||
+        !SSL_CTX_get_tlsext_ticket_keys(session_cache_->GetSSLContext(),
+                                        ticket_keys, ticket_keys_length) ||
+        !SSL_CTX_set_tlsext_ticket_keys(ctx, ticket_keys,
+                                        ticket_keys_length) ||
+        !SSL_CTX_set_session_id_context(
+            ctx, reinterpret_cast<const unsigned char*>(kSessionIdContext),
+            sizeof(kSessionIdContext) - 1)) {
+      SSL_CTX_free(ctx);
+      return nullptr;
+    }
+  }
+
 #if !defined(NDEBUG)
   SSL_CTX_set_info_callback(ctx, OpenSSLAdapter::SSLInfoCallback);
 #endif
@@ -1051,6 +1139,41 @@ bool OpenSSLStreamAdapter::VerifyPeerCertificate() {
   return true;
 }
 
+bool OpenSSLStreamAdapter::LoadSessionPeerCertificate() {
+  X509* cert = SSL_get_peer_certificate(ssl_);
+  if (!cert) {
+    RTC_LOG(LS_WARNING) << "Resumed session has no peer certificate.";
+    return !GetClientAuthEnabled();
+  }
+  peer_cert_chain_.reset(
+      new SSLCertChain(absl::make_unique<OpenSSLCertificate>(cert)));
+  X509_free(cert);
+
+  // Like in SSLVerifyCallback, the certificate is verified once the digest is
+  // known.
+  if (peer_certificate_digest_algorithm_.empty()) {
+    RTC_LOG(LS_INFO) << "Waiting to verify certificate until digest is known.";
+    return true;
+  }
+  return VerifyPeerCertificate();
+}
+
+std::string OpenSSLStreamAdapter::GetSessionKey() const {
+  if (!identity_ || !HasPeerCertificateDigest()) {
+    return std::string();
+  }
+  unsigned char digest[MessageDigest::kMaxSize];
+  size_t digest_length;
+  if (!identity_->certificate().ComputeDigest(DIGEST_SHA_256, digest,
+                                              sizeof(digest), &digest_length)) {
+    return std::string();
+  }
+  return hex_encode(reinterpret_cast<const char*>(digest), digest_length) +
+         " " + peer_certificate_digest_algorithm_ + " " +
+         hex_encode(peer_certificate_digest_value_.data<char>(),
+                    peer_certificate_digest_value_.size());
+}
+
 std::unique_ptr<SSLCertChain> OpenSSLStreamAdapter::GetPeerSSLCertChain()
     const {
   return peer_cert_chain_ ? peer_cert_chain_->Clone() : nullptr;
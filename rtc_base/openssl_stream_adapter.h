@@ -22,6 +22,7 @@
 #include "rtc_base/buffer.h"
 #include "rtc_base/message_queue.h"
 #include "rtc_base/openssl_identity.h"
+#include "rtc_base/openssl_session_cache.h"
 #include "rtc_base/ssl_identity.h"
 #include "rtc_base/ssl_stream_adapter.h"
 #include "rtc_base/stream.h"
@@ -79,6 +80,8 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   void SetMode(SSLMode mode) override;
   void SetMaxProtocolVersion(SSLProtocolVersion version) override;
   void SetInitialRetransmissionTimeout(int timeout_ms) override;
+  void SetSessionCache(SSLSessionCache* session_cache) override;
+  bool IsSessionResumed() const override;
 
   StreamResult Read(void* data,
                     size_t data_len,
@@ -94,6 +97,8 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   // TODO(guoweis): Move this away from a static class method.
   static std::string SslCipherSuiteToName(int crypto_suite);
 
+  static std::unique_ptr<SSLSessionCache> CreateSessionCache(SSLMode mode);
+
   bool GetSslCipherSuite(int* cipher) override;
 
   int GetSslVersion() const override;
@@ -171,6 +176,12 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   SSL_CTX* SetupSSLContext();
   // Verify the peer certificate matches the signaled digest.
   bool VerifyPeerCertificate();
+  // Records the peer certificate of a resumed session, and verifies it if the
+  // digest is known.
+  bool LoadSessionPeerCertificate();
+  // Identifies the sessions negotiated between our certificate and the one
+  // with the signaled digest; empty if either is unknown.
+  std::string GetSessionKey() const;
   // SSL certificate verification callback. See
   // SSL_CTX_set_cert_verify_callback.
   static int SSLVerifyCallback(X509_STORE_CTX* store, void* arg);
@@ -217,6 +228,9 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   // A 50-ms initial timeout ensures rapid setup on fast connections, but may
   // be too aggressive for low bandwidth links.
   int dtls_handshake_timeout_ms_ = 50;
+
+  // Sessions to resume, and to add the negotiated session to. Not owned.
+  OpenSSLSessionCache* session_cache_ = nullptr;
 };
 
 /////////////////////////////////////////////////////////////////////////////
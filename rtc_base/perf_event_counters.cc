@@ -0,0 +1,253 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/perf_event_counters.h"
+
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "rtc_base/logging.h"
+#include "rtc_base/system/arch.h"
+#include "system_wrappers/include/metrics.h"
+
+#if (defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)) && \
+    !defined(PERF_FLAG_FD_CLOEXEC)
+#define PERF_FLAG_FD_CLOEXEC (1UL << 3)
+#endif
+
+namespace rtc {
+namespace perf_event {
+namespace {
+
+// Up to 10^10 cycles or instructions, and 10^7 cache misses, in a scope.
+constexpr int kMaxKiloCount = 10000000;
+constexpr int kMaxCacheMisses = 10000000;
+constexpr int kNumBuckets = 50;
+
+std::atomic<bool> g_counters_enabled(false);
+
+webrtc::metrics::Histogram* GetHistogram(const char* site_name,
+                                         const char* counter_name,
+                                         int max) {
+  return webrtc::metrics::HistogramFactoryGetCounts(
+      std::string("WebRTC.PerfEvent.") + site_name + "." + counter_name, 1,
+      max, kNumBuckets);
+}
+
+void AddSample(webrtc::metrics::Histogram* histogram, uint64_t sample) {
+  if (histogram) {
+    webrtc::metrics::HistogramAdd(
+        histogram, static_cast<int>(std::min<uint64_t>(sample, INT_MAX)));
+  }
+}
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+
+// In the order of the members of Counts.
+constexpr uint64_t kEventConfigs[] = {PERF_COUNT_HW_CPU_CYCLES,
+                                      PERF_COUNT_HW_INSTRUCTIONS,
+                                      PERF_COUNT_HW_CACHE_MISSES};
+constexpr int kNumEvents = sizeof(kEventConfigs) / sizeof(kEventConfigs[0]);
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+uint64_t ReadPmc(uint32_t counter) {
+  uint32_t low;
+  uint32_t high;
+  asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+  return (static_cast<uint64_t>(high) << 32) | low;
+}
+#endif
+
+// The counters of a thread, opened as one group the first time the thread
+// counts a scope, and closed when it exits.
+class ThreadCounters {
+ public:
+  ThreadCounters() = default;
+  ~ThreadCounters() { Close(); }
+
+  bool Read(Counts* counts) {
+    if (state_ == State::kUnopened)
+      state_ = Open() ? State::kOpen : State::kFailed;
+    if (state_ != State::kOpen)
+      return false;
+    uint64_t values[kNumEvents];
+    if (!ReadPmcs(values) && !ReadGroup(values))
+      return false;
+    counts->cycles = values[0];
+    counts->instructions = values[1];
+    counts->cache_misses = values[2];
+    return true;
+  }
+
+ private:
+  enum class State { kUnopened, kOpen, kFailed };
+
+  bool Open() {
+    const long page_size = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < kNumEvents; ++i) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kEventConfigs[i];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds_[i] = static_cast<int>(
+          syscall(__NR_perf_event_open, &attr, 0 /* this thread */,
+                  -1 /* any cpu */, i == 0 ? -1 : fds_[0],
+                  PERF_FLAG_FD_CLOEXEC));
+      if (fds_[i] < 0) {
+        RTC_LOG_ERRNO(LS_WARNING) << "Failed to open perf event " << i;
+        Close();
+        return false;
+      }
+      // The mapped page lets ReadPmcs() read the counter without a syscall.
+      void* page =
+          mmap(nullptr, page_size, PROT_READ, MAP_SHARED, fds_[i], 0);
+      if (page != MAP_FAILED)
+        pages_[i] = static_cast<perf_event_mmap_page*>(page);
+    }
+    return true;
+  }
+
+  void Close() {
+    const long page_size = sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < kNumEvents; ++i) {
+      if (pages_[i])
+        munmap(const_cast<perf_event_mmap_page*>(pages_[i]), page_size);
+      pages_[i] = nullptr;
+      if (fds_[i] >= 0)
+        close(fds_[i]);
+      fds_[i] = -1;
+    }
+  }
+
+  // Reads the counters with rdpmc, following the protocol documented in
+  // linux/perf_event.h. Returns false if the kernel doesn't allow it.
+  bool ReadPmcs(uint64_t* values) const {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    for (int i = 0; i < kNumEvents; ++i) {
+      const volatile perf_event_mmap_page* page = pages_[i];
+      if (!page)
+        return false;
+      uint32_t seq;
+      uint64_t count;
+      do {
+        seq = page->lock;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        const uint32_t index = page->index;
+        if (!page->cap_user_rdpmc || index == 0)
+          return false;
+        const int shift = 64 - page->pmc_width;
+        count = page->offset +
+                (static_cast<int64_t>(ReadPmc(index - 1) << shift) >> shift);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+      } while (page->lock != seq);
+      values[i] = count;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool ReadGroup(uint64_t* values) const {
+    // The number of counters, followed by their values.
+    uint64_t data[1 + kNumEvents];
+    if (read(fds_[0], data, sizeof(data)) != sizeof(data) ||
+        data[0] != kNumEvents) {
+      return false;
+    }
+    memcpy(values, &data[1], kNumEvents * sizeof(uint64_t));
+    return true;
+  }
+
+  State state_ = State::kUnopened;
+  int fds_[kNumEvents] = {-1, -1, -1};
+  const perf_event_mmap_page* pages_[kNumEvents] = {};
+};
+
+thread_local ThreadCounters thread_counters;
+
+bool ReadThreadCounts(Counts* counts) {
+  return thread_counters.Read(counts);
+}
+
+#else
+
+bool ReadThreadCounts(Counts* counts) {
+  return false;
+}
+
+#endif  // defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+
+}  // namespace
+
+bool EnableCounters() {
+  // Hardware counters are often missing in VMs, so check that the counters of
+  // this thread can be read before counting on any thread.
+  Counts counts;
+  if (!ReadThreadCounts(&counts)) {
+    RTC_LOG(LS_WARNING) << "Hardware performance counters are not available.";
+    return false;
+  }
+  g_counters_enabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void DisableCounters() {
+  g_counters_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool CountersEnabled() {
+  return g_counters_enabled.load(std::memory_order_relaxed);
+}
+
+CounterSite::CounterSite(const char* name)
+    : kilo_cycles_(GetHistogram(name, "KiloCycles", kMaxKiloCount)),
+      kilo_instructions_(
+          GetHistogram(name, "KiloInstructions", kMaxKiloCount)),
+      cache_misses_(GetHistogram(name, "CacheMisses", kMaxCacheMisses)) {}
+
+void CounterSite::AddCounts(const Counts& counts) {
+  AddSample(kilo_cycles_, (counts.cycles + 500) / 1000);
+  AddSample(kilo_instructions_, (counts.instructions + 500) / 1000);
+  AddSample(cache_misses_, counts.cache_misses);
+}
+
+void ScopedCounters::Start(CounterSite* site) {
+  if (ReadThreadCounts(&start_))
+    site_ = site;
+}
+
+void ScopedCounters::Stop() {
+  Counts end;
+  if (!ReadThreadCounts(&end))
+    return;
+  Counts counts;
+  counts.cycles = end.cycles - start_.cycles;
+  counts.instructions = end.instructions - start_.instructions;
+  counts.cache_misses = end.cache_misses - start_.cache_misses;
+  site_->AddCounts(counts);
+}
+
+}  // namespace perf_event
+}  // namespace rtc
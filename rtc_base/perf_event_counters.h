@@ -0,0 +1,122 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_PERF_EVENT_COUNTERS_H_
+#define RTC_BASE_PERF_EVENT_COUNTERS_H_
+
+#include <stdint.h>
+
+#include "rtc_base/constructor_magic.h"
+
+// Hardware counters for hot paths: the CPU cycles, instructions and cache
+// misses of a scope, e.g. of processing an RTP packet or encoding a frame, read
+// with Linux perf_event_open(). The counts of each scope are added to the
+// histograms "WebRTC.PerfEvent.<name>.KiloCycles", ".KiloInstructions" and
+// ".CacheMisses" of system_wrappers/include/metrics.h.
+//
+// RTC_PERF_EVENT_SCOPE() compiles to nothing unless WebRTC is built with
+// rtc_enable_perf_event_counters=true. When it's compiled in, scopes only count
+// after rtc::perf_event::EnableCounters() and cost a relaxed atomic load until
+// then.
+//
+//   void ProcessPacket() {
+//     RTC_PERF_EVENT_SCOPE("Foo.ProcessPacket");
+//     ...
+//   }
+//
+// Only user space is counted, which perf_event_paranoid allows by default.
+
+#if !defined(WEBRTC_ENABLE_PERF_EVENT_COUNTERS)
+#define WEBRTC_ENABLE_PERF_EVENT_COUNTERS 0
+#endif
+
+namespace webrtc {
+namespace metrics {
+class Histogram;
+}  // namespace metrics
+}  // namespace webrtc
+
+namespace rtc {
+namespace perf_event {
+
+struct Counts {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+};
+
+// Starts counting scopes on all threads. Returns false, and counts nothing, if
+// the counters can't be opened, e.g. on other platforms than Linux and Android,
+// in VMs without a virtual PMU, or when perf_event_paranoid is 3.
+bool EnableCounters();
+void DisableCounters();
+bool CountersEnabled();
+
+// A counted scope in the code, with the histograms its counts are added to.
+class CounterSite {
+ public:
+  explicit CounterSite(const char* name);
+
+  void AddCounts(const Counts& counts);
+
+ private:
+  webrtc::metrics::Histogram* const kilo_cycles_;
+  webrtc::metrics::Histogram* const kilo_instructions_;
+  webrtc::metrics::Histogram* const cache_misses_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(CounterSite);
+};
+
+// Counts the current thread from construction to destruction, and adds the
+// counts to |site|. Use RTC_PERF_EVENT_SCOPE() rather than this directly, so
+// that the counting is compiled out by default.
+class ScopedCounters {
+ public:
+  explicit ScopedCounters(CounterSite* site) {
+    if (CountersEnabled())
+      Start(site);
+  }
+  ~ScopedCounters() {
+    if (site_)
+      Stop();
+  }
+
+ private:
+  void Start(CounterSite* site);
+  void Stop();
+
+  CounterSite* site_ = nullptr;
+  Counts start_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ScopedCounters);
+};
+
+}  // namespace perf_event
+}  // namespace rtc
+
+#if WEBRTC_ENABLE_PERF_EVENT_COUNTERS
+
+#define RTC_PERF_EVENT_UID3(a, b) rtc_perf_event_uid_##a##b
+#define RTC_PERF_EVENT_UID2(a, b) RTC_PERF_EVENT_UID3(a, b)
+#define RTC_PERF_EVENT_UID(prefix) RTC_PERF_EVENT_UID2(prefix, __LINE__)
+
+#define RTC_PERF_EVENT_SCOPE(name)                                      \
+  static rtc::perf_event::CounterSite* const RTC_PERF_EVENT_UID(site) = \
+      new rtc::perf_event::CounterSite(name);                           \
+  rtc::perf_event::ScopedCounters RTC_PERF_EVENT_UID(scope)(            \
+      RTC_PERF_EVENT_UID(site))
+
+#else
+
+#define RTC_PERF_EVENT_SCOPE(name)
+
+#endif  // WEBRTC_ENABLE_PERF_EVENT_COUNTERS
+
+#endif  // RTC_BASE_PERF_EVENT_COUNTERS_H_
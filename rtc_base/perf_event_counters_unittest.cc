@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/perf_event_counters.h"
+
+#include "rtc_base/logging.h"
+#include "system_wrappers/include/metrics.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace perf_event {
+namespace {
+
+// Keeps the compiler from removing the work of a counted scope.
+int CountPrimes(int limit) {
+  int num_primes = 0;
+  for (volatile int n = 2; n < limit; ++n) {
+    bool prime = true;
+    for (int d = 2; d * d <= n && prime; ++d)
+      prime = n % d != 0;
+    num_primes += prime;
+  }
+  return num_primes;
+}
+
+}  // namespace
+
+class PerfEventCountersTest : public ::testing::Test {
+ protected:
+  void SetUp() override { webrtc::metrics::Reset(); }
+  void TearDown() override { DisableCounters(); }
+};
+
+TEST_F(PerfEventCountersTest, AddsCountsToHistograms) {
+  CounterSite site("Test.AddCounts");
+  Counts counts;
+  counts.cycles = 2000400;
+  counts.instructions = 3000600;
+  counts.cache_misses = 70;
+  site.AddCounts(counts);
+  EXPECT_EQ(1, webrtc::metrics::NumEvents(
+                   "WebRTC.PerfEvent.Test.AddCounts.KiloCycles", 2000));
+  EXPECT_EQ(1, webrtc::metrics::NumEvents(
+                   "WebRTC.PerfEvent.Test.AddCounts.KiloInstructions", 3001));
+  EXPECT_EQ(1, webrtc::metrics::NumEvents(
+                   "WebRTC.PerfEvent.Test.AddCounts.CacheMisses", 70));
+}
+
+TEST_F(PerfEventCountersTest, CountsNothingUntilEnabled) {
+  CounterSite site("Test.Disabled");
+  {
+    ScopedCounters scope(&site);
+    EXPECT_GT(CountPrimes(10000), 0);
+  }
+  EXPECT_FALSE(CountersEnabled());
+  EXPECT_EQ(0, webrtc::metrics::NumSamples(
+                   "WebRTC.PerfEvent.Test.Disabled.KiloCycles"));
+}
+
+TEST_F(PerfEventCountersTest, CountsScopesWhenEnabled) {
+  if (!EnableCounters()) {
+    RTC_LOG(LS_INFO) << "Hardware counters not available, skipping test.";
+    return;
+  }
+  CounterSite site("Test.Enabled");
+  for (int i = 0; i < 3; ++i) {
+    ScopedCounters scope(&site);
+    EXPECT_GT(CountPrimes(100000), 0);
+  }
+  EXPECT_EQ(3, webrtc::metrics::NumSamples(
+                   "WebRTC.PerfEvent.Test.Enabled.KiloCycles"));
+  EXPECT_EQ(3, webrtc::metrics::NumSamples(
+                   "WebRTC.PerfEvent.Test.Enabled.KiloInstructions"));
+  EXPECT_EQ(3, webrtc::metrics::NumSamples(
+                   "WebRTC.PerfEvent.Test.Enabled.CacheMisses"));
+  // Finding the primes below 10^5 takes millions of instructions.
+  EXPECT_GT(webrtc::metrics::MinSample(
+                "WebRTC.PerfEvent.Test.Enabled.KiloInstructions"),
+            1000);
+
+  DisableCounters();
+  {
+    ScopedCounters scope(&site);
+    EXPECT_GT(CountPrimes(10000), 0);
+  }
+  EXPECT_EQ(3, webrtc::metrics::NumSamples(
+                   "WebRTC.PerfEvent.Test.Enabled.KiloCycles"));
+}
+
+}  // namespace perf_event
+}  // namespace rtc
@@ -411,6 +411,69 @@ int PhysicalSocket::RecvFrom(void* buffer,
   return received;
 }
 
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+int PhysicalSocket::SendToBatch(const Datagram* datagrams, size_t count) {
+  count = std::min(count, kMaxBatchSize);
+  mmsghdr messages[kMaxBatchSize];
+  iovec iovs[kMaxBatchSize];
+  sockaddr_storage addrs[kMaxBatchSize];
+  memset(messages, 0, sizeof(mmsghdr) * count);
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = datagrams[i].data;
+    iovs[i].iov_len = datagrams[i].size;
+    messages[i].msg_hdr.msg_iov = &iovs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_name = &addrs[i];
+    messages[i].msg_hdr.msg_namelen =
+        static_cast<socklen_t>(datagrams[i].addr.ToSockAddrStorage(&addrs[i]));
+  }
+  // Suppress SIGPIPE. See Send() for explanation.
+  int sent = ::sendmmsg(s_, messages, static_cast<unsigned int>(count),
+                        MSG_NOSIGNAL);
+  UpdateLastError();
+  MaybeRemapSendError();
+  if ((sent >= 0 && sent < static_cast<int>(count)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent;
+}
+
+int PhysicalSocket::RecvFromBatch(Datagram* datagrams, size_t count) {
+  count = std::min(count, kMaxBatchSize);
+  mmsghdr messages[kMaxBatchSize];
+  iovec iovs[kMaxBatchSize];
+  sockaddr_storage addrs[kMaxBatchSize];
+  memset(messages, 0, sizeof(mmsghdr) * count);
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = datagrams[i].data;
+    iovs[i].iov_len = datagrams[i].size;
+    messages[i].msg_hdr.msg_iov = &iovs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_name = &addrs[i];
+    messages[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+  }
+  int received = ::recvmmsg(s_, messages, static_cast<unsigned int>(count),
+                            MSG_DONTWAIT, nullptr);
+  UpdateLastError();
+  for (int i = 0; i < received; ++i) {
+    datagrams[i].size = messages[i].msg_len;
+    SocketAddressFromSockAddrStorage(addrs[i], &datagrams[i].addr);
+    // Per datagram receive times would need SO_TIMESTAMP control messages.
+    datagrams[i].timestamp = -1;
+  }
+  int error = GetError();
+  bool success = (received >= 0) || IsBlockingError(error);
+  if (udp_ || success) {
+    EnableEvents(DE_READ);
+  }
+  if (!success) {
+    RTC_LOG_F(LS_VERBOSE) << "Error = " << error;
+  }
+  return received;
+}
+#endif
+
 int PhysicalSocket::Listen(int backlog) {
   int err = ::listen(s_, backlog);
   UpdateLastError();
@@ -554,6 +617,15 @@ int PhysicalSocket::TranslateOption(Option opt, int* slevel, int* sopt) {
       return -1;
     case OPT_RTP_SENDTIME_EXTN_ID:
       return -1;  // No logging is necessary as this not a OS socket option.
+    case OPT_REUSEPORT:
+#if defined(SO_REUSEPORT)
+      *slevel = SOL_SOCKET;
+      *sopt = SO_REUSEPORT;
+      break;
+#else
+      RTC_LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+      return -1;
+#endif
     default:
       RTC_NOTREACHED();
       return -1;
@@ -163,6 +163,12 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
                size_t length,
                SocketAddress* out_addr,
                int64_t* timestamp) override;
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+  // Use sendmmsg() and recvmmsg(), for up to |kMaxBatchSize| datagrams per
+  // call.
+  int SendToBatch(const Datagram* datagrams, size_t count) override;
+  int RecvFromBatch(Datagram* datagrams, size_t count) override;
+#endif
 
   int Listen(int backlog) override;
   AsyncSocket* Accept(SocketAddress* out_addr) override;
@@ -171,6 +177,8 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 
   SocketServer* socketserver() { return ss_; }
 
+  static constexpr size_t kMaxBatchSize = 32;
+
  protected:
   int DoConnect(const SocketAddress& connect_addr);
 
@@ -406,6 +406,15 @@ TEST_F(PhysicalSocketTest, TestUdpIPv6) {
   SocketTest::TestUdpIPv6();
 }
 
+TEST_F(PhysicalSocketTest, TestUdpBatchIPv4) {
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestUdpBatchIPv4();
+}
+
+TEST_F(PhysicalSocketTest, TestUdpBatchIPv6) {
+  SocketTest::TestUdpBatchIPv6();
+}
+
 // Disable for TSan v2, see
 // https://code.google.com/p/webrtc/issues/detail?id=3498 for details.
 // Also disable for MSan, see:
@@ -0,0 +1,186 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/rtc_certificate_pool.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/location.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/time_utils.h"
+
+namespace rtc {
+
+namespace {
+
+// Pooled certificates that expire sooner than this are not handed out.
+const uint64_t kMinRemainingLifetimeMs = 24 * 60 * 60 * 1000;
+
+bool KeyParamsEqual(const KeyParams& a, const KeyParams& b) {
+  if (a.type() != b.type()) {
+    return false;
+  }
+  switch (a.type()) {
+    case KT_RSA:
+      return a.rsa_params().mod_size == b.rsa_params().mod_size &&
+             a.rsa_params().pub_exp == b.rsa_params().pub_exp;
+    case KT_ECDSA:
+      return a.ec_curve() == b.ec_curve();
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+// Handed to each PeerConnection, and keeps the pool alive as long as it is.
+class RTCCertificatePool::PooledGenerator
+    : public RTCCertificateGeneratorInterface {
+ public:
+  explicit PooledGenerator(const scoped_refptr<RTCCertificatePool>& pool)
+      : pool_(pool) {}
+
+  void GenerateCertificateAsync(
+      const KeyParams& key_params,
+      const absl::optional<uint64_t>& expires_ms,
+      const scoped_refptr<RTCCertificateGeneratorCallback>& callback) override {
+    pool_->GenerateCertificateAsync(key_params, expires_ms, callback);
+  }
+
+ private:
+  const scoped_refptr<RTCCertificatePool> pool_;
+};
+
+// Receives the certificates generated to refill the pool.
+class RTCCertificatePool::RefillCallback
+    : public RTCCertificateGeneratorCallback {
+ public:
+  RefillCallback(const scoped_refptr<RTCCertificatePool>& pool,
+                 const KeyParams& key_params)
+      : pool_(pool), key_params_(key_params) {}
+
+  void OnSuccess(const scoped_refptr<RTCCertificate>& certificate) override {
+    pool_->OnRefilled(key_params_, certificate);
+  }
+  void OnFailure() override { pool_->OnRefilled(key_params_, nullptr); }
+
+ private:
+  const scoped_refptr<RTCCertificatePool> pool_;
+  const KeyParams key_params_;
+};
+
+RTCCertificatePool::RTCCertificatePool(Thread* signaling_thread,
+                                       Thread* worker_thread)
+    : signaling_thread_(signaling_thread),
+      generator_(signaling_thread, worker_thread) {
+  RTC_DCHECK(signaling_thread_);
+}
+
+RTCCertificatePool::~RTCCertificatePool() = default;
+
+void RTCCertificatePool::Configure(const KeyParams& key_params, size_t size) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (!KeyParamsEqual(key_params, key_params_)) {
+    certificates_.clear();
+  }
+  key_params_ = key_params;
+  size_ = size;
+  while (certificates_.size() > size_) {
+    certificates_.pop_back();
+  }
+  MaybeRefill();
+}
+
+scoped_refptr<RTCCertificate> RTCCertificatePool::TakeCertificate(
+    const KeyParams& key_params) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (!KeyParamsEqual(key_params, key_params_)) {
+    return nullptr;
+  }
+  scoped_refptr<RTCCertificate> certificate;
+  const uint64_t now_ms = static_cast<uint64_t>(TimeUTCMillis());
+  while (!certificates_.empty() && !certificate) {
+    certificate = std::move(certificates_.front());
+    certificates_.pop_front();
+    if (certificate->HasExpired(now_ms + kMinRemainingLifetimeMs)) {
+      certificate = nullptr;
+    }
+  }
+  MaybeRefill();
+  return certificate;
+}
+
+size_t RTCCertificatePool::num_certificates() const {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  return certificates_.size();
+}
+
+std::unique_ptr<RTCCertificateGeneratorInterface>
+RTCCertificatePool::CreateGenerator() {
+  return absl::make_unique<PooledGenerator>(this);
+}
+
+void RTCCertificatePool::GenerateCertificateAsync(
+    const KeyParams& key_params,
+    const absl::optional<uint64_t>& expires_ms,
+    const scoped_refptr<RTCCertificateGeneratorCallback>& callback) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  RTC_DCHECK(callback);
+  scoped_refptr<RTCCertificate> certificate;
+  if (!expires_ms) {
+    certificate = TakeCertificate(key_params);
+  }
+  if (!certificate) {
+    ++num_generated_requests_;
+    generator_.GenerateCertificateAsync(key_params, expires_ms, callback);
+    return;
+  }
+  ++num_pooled_requests_;
+  // Callers expect the callback to be invoked asynchronously, like with the
+  // generator.
+  signaling_thread_->PostTask(RTC_FROM_HERE, [callback, certificate] {
+    callback->OnSuccess(certificate);
+  });
+}
+
+void RTCCertificatePool::MaybeRefill() {
+  if (refilling_ || certificates_.size() >= size_) {
+    return;
+  }
+  refilling_ = true;
+  generator_.GenerateCertificateAsync(
+      key_params_, absl::nullopt,
+      new RefCountedObject<RefillCallback>(this, key_params_));
+}
+
+void RTCCertificatePool::OnRefilled(
+    const KeyParams& key_params,
+    const scoped_refptr<RTCCertificate>& certificate) {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  refilling_ = false;
+  if (!certificate) {
+    // Don't retry, the key params are likely not supported. The next request
+    // will be generated on demand and try again.
+    RTC_LOG(LS_WARNING) << "Failed to generate a pooled certificate.";
+    return;
+  }
+  // The pool may have been reconfigured while the certificate was generated.
+  if (KeyParamsEqual(key_params, key_params_) &&
+      certificates_.size() < size_) {
+    certificates_.push_back(certificate);
+  }
+  MaybeRefill();
+}
+
+}  // namespace rtc
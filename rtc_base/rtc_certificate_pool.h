@@ -0,0 +1,84 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_RTC_CERTIFICATE_POOL_H_
+#define RTC_BASE_RTC_CERTIFICATE_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+
+#include "absl/types/optional.h"
+#include "api/scoped_refptr.h"
+#include "rtc_base/ref_count.h"
+#include "rtc_base/rtc_certificate.h"
+#include "rtc_base/rtc_certificate_generator.h"
+#include "rtc_base/ssl_identity.h"
+#include "rtc_base/thread.h"
+
+namespace rtc {
+
+// Keeps a number of certificates generated ahead of time, so that requests
+// for a certificate don't wait for key generation. Whenever a certificate is
+// taken, a new one is generated in the background on the worker thread, one
+// at a time. Requests with other key params, or with an expiration time, are
+// generated on demand like with |RTCCertificateGenerator|.
+//
+// Reference counted, so that the generator handed to each PeerConnection and
+// the generation in progress keep it alive. Must be used on the signaling
+// thread.
+class RTCCertificatePool : public RefCountInterface {
+ public:
+  RTCCertificatePool(Thread* signaling_thread, Thread* worker_thread);
+
+  // Sets the key params of the pooled certificates and how many to keep, and
+  // starts generating the missing ones. Pooled certificates with other key
+  // params are dropped. A |size| of zero empties the pool.
+  void Configure(const KeyParams& key_params, size_t size);
+
+  // Returns a pooled certificate with |key_params|, or null if there is none.
+  scoped_refptr<RTCCertificate> TakeCertificate(const KeyParams& key_params);
+
+  size_t num_certificates() const;
+  // The number of requests served from the pool, and generated on demand.
+  int num_pooled_requests() const { return num_pooled_requests_; }
+  int num_generated_requests() const { return num_generated_requests_; }
+
+  // Returns a generator that serves requests from this pool.
+  std::unique_ptr<RTCCertificateGeneratorInterface> CreateGenerator();
+
+ protected:
+  ~RTCCertificatePool() override;
+
+ private:
+  class PooledGenerator;
+  class RefillCallback;
+
+  void GenerateCertificateAsync(
+      const KeyParams& key_params,
+      const absl::optional<uint64_t>& expires_ms,
+      const scoped_refptr<RTCCertificateGeneratorCallback>& callback);
+  void MaybeRefill();
+  void OnRefilled(const KeyParams& key_params,
+                  const scoped_refptr<RTCCertificate>& certificate);
+
+  Thread* const signaling_thread_;
+  RTCCertificateGenerator generator_;
+  KeyParams key_params_;
+  size_t size_ = 0;
+  std::deque<scoped_refptr<RTCCertificate>> certificates_;
+  bool refilling_ = false;
+  int num_pooled_requests_ = 0;
+  int num_generated_requests_ = 0;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_RTC_CERTIFICATE_POOL_H_
@@ -0,0 +1,158 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/rtc_certificate_pool.h"
+
+#include <memory>
+
+#include "absl/types/optional.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/thread.h"
+#include "test/gtest.h"
+
+namespace rtc {
+
+namespace {
+
+const int kGenerationTimeoutMs = 10000;
+
+class CertificateCallback : public RTCCertificateGeneratorCallback {
+ public:
+  void OnSuccess(const scoped_refptr<RTCCertificate>& certificate) override {
+    certificate_ = certificate;
+    completed_ = true;
+  }
+  void OnFailure() override { completed_ = true; }
+
+  bool completed() const { return completed_; }
+  RTCCertificate* certificate() const { return certificate_.get(); }
+
+ private:
+  bool completed_ = false;
+  scoped_refptr<RTCCertificate> certificate_;
+};
+
+}  // namespace
+
+class RTCCertificatePoolTest : public ::testing::Test {
+ public:
+  RTCCertificatePoolTest() : worker_thread_(Thread::Create()) {
+    RTC_CHECK(worker_thread_->Start());
+    pool_ = new RefCountedObject<RTCCertificatePool>(Thread::Current(),
+                                                     worker_thread_.get());
+  }
+
+ protected:
+  std::unique_ptr<Thread> worker_thread_;
+  scoped_refptr<RTCCertificatePool> pool_;
+};
+
+TEST_F(RTCCertificatePoolTest, FillsToConfiguredSize) {
+  EXPECT_EQ(0u, pool_->num_certificates());
+  pool_->Configure(KeyParams::ECDSA(), 3);
+  EXPECT_EQ_WAIT(3u, pool_->num_certificates(), kGenerationTimeoutMs);
+  // No more than the configured number are generated.
+  Thread::Current()->ProcessMessages(100);
+  EXPECT_EQ(3u, pool_->num_certificates());
+}
+
+TEST_F(RTCCertificatePoolTest, RefillsAfterTake) {
+  pool_->Configure(KeyParams::ECDSA(), 2);
+  EXPECT_EQ_WAIT(2u, pool_->num_certificates(), kGenerationTimeoutMs);
+  scoped_refptr<RTCCertificate> first =
+      pool_->TakeCertificate(KeyParams::ECDSA());
+  scoped_refptr<RTCCertificate> second =
+      pool_->TakeCertificate(KeyParams::ECDSA());
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(second);
+  EXPECT_NE(first, second);
+  EXPECT_FALSE(pool_->TakeCertificate(KeyParams::ECDSA()));
+  EXPECT_EQ_WAIT(2u, pool_->num_certificates(), kGenerationTimeoutMs);
+}
+
+TEST_F(RTCCertificatePoolTest, DoesNotTakeOtherKeyParams) {
+  pool_->Configure(KeyParams::ECDSA(), 1);
+  EXPECT_EQ_WAIT(1u, pool_->num_certificates(), kGenerationTimeoutMs);
+  EXPECT_FALSE(pool_->TakeCertificate(KeyParams::RSA()));
+  EXPECT_EQ(1u, pool_->num_certificates());
+}
+
+TEST_F(RTCCertificatePoolTest, ReconfigureDropsOtherKeyParams) {
+  pool_->Configure(KeyParams::ECDSA(), 1);
+  EXPECT_EQ_WAIT(1u, pool_->num_certificates(), kGenerationTimeoutMs);
+  pool_->Configure(KeyParams::RSA(), 1);
+  EXPECT_EQ(0u, pool_->num_certificates());
+  EXPECT_EQ_WAIT(1u, pool_->num_certificates(), kGenerationTimeoutMs);
+  EXPECT_FALSE(pool_->TakeCertificate(KeyParams::ECDSA()));
+  EXPECT_TRUE(pool_->TakeCertificate(KeyParams::RSA()));
+
+  pool_->Configure(KeyParams::RSA(), 0);
+  Thread::Current()->ProcessMessages(100);
+  EXPECT_EQ(0u, pool_->num_certificates());
+}
+
+TEST_F(RTCCertificatePoolTest, GeneratorServesFromPoolAsynchronously) {
+  pool_->Configure(KeyParams::ECDSA(), 1);
+  EXPECT_EQ_WAIT(1u, pool_->num_certificates(), kGenerationTimeoutMs);
+  std::unique_ptr<RTCCertificateGeneratorInterface> generator =
+      pool_->CreateGenerator();
+  scoped_refptr<CertificateCallback> callback =
+      new RefCountedObject<CertificateCallback>();
+  generator->GenerateCertificateAsync(KeyParams::ECDSA(), absl::nullopt,
+                                      callback);
+  EXPECT_EQ(0u, pool_->num_certificates());
+  EXPECT_FALSE(callback->completed());
+  EXPECT_TRUE_WAIT(callback->completed(), kGenerationTimeoutMs);
+  EXPECT_TRUE(callback->certificate());
+  EXPECT_EQ(1, pool_->num_pooled_requests());
+  EXPECT_EQ(0, pool_->num_generated_requests());
+}
+
+TEST_F(RTCCertificatePoolTest, GeneratorGeneratesWhenPoolCannotServe) {
+  pool_->Configure(KeyParams::ECDSA(), 1);
+  EXPECT_EQ_WAIT(1u, pool_->num_certificates(), kGenerationTimeoutMs);
+  std::unique_ptr<RTCCertificateGeneratorInterface> generator =
+      pool_->CreateGenerator();
+
+  // Other key params.
+  scoped_refptr<CertificateCallback> rsa_callback =
+      new RefCountedObject<CertificateCallback>();
+  generator->GenerateCertificateAsync(KeyParams::RSA(), absl::nullopt,
+                                      rsa_callback);
+  // A specific expiration time.
+  scoped_refptr<CertificateCallback> expires_callback =
+      new RefCountedObject<CertificateCallback>();
+  generator->GenerateCertificateAsync(KeyParams::ECDSA(), 60000,
+                                      expires_callback);
+  EXPECT_TRUE_WAIT(rsa_callback->completed() && expires_callback->completed(),
+                   kGenerationTimeoutMs);
+  EXPECT_TRUE(rsa_callback->certificate());
+  EXPECT_TRUE(expires_callback->certificate());
+  EXPECT_EQ(1u, pool_->num_certificates());
+  EXPECT_EQ(0, pool_->num_pooled_requests());
+  EXPECT_EQ(2, pool_->num_generated_requests());
+}
+
+TEST_F(RTCCertificatePoolTest, GeneratorKeepsPoolAlive) {
+  pool_->Configure(KeyParams::ECDSA(), 1);
+  std::unique_ptr<RTCCertificateGeneratorInterface> generator =
+      pool_->CreateGenerator();
+  pool_ = nullptr;
+  scoped_refptr<CertificateCallback> callback =
+      new RefCountedObject<CertificateCallback>();
+  generator->GenerateCertificateAsync(KeyParams::ECDSA(), absl::nullopt,
+                                      callback);
+  EXPECT_TRUE_WAIT(callback->completed(), kGenerationTimeoutMs);
+  EXPECT_TRUE(callback->certificate());
+}
+
+}  // namespace rtc
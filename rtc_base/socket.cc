@@ -12,4 +12,26 @@
 
 namespace rtc {
 
+int Socket::SendToBatch(const Datagram* datagrams, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (SendTo(datagrams[i].data, datagrams[i].size, datagrams[i].addr) < 0) {
+      return i > 0 ? static_cast<int>(i) : -1;
+    }
+  }
+  return static_cast<int>(count);
+}
+
+int Socket::RecvFromBatch(Datagram* datagrams, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    Datagram& datagram = datagrams[i];
+    int received = RecvFrom(datagram.data, datagram.size, &datagram.addr,
+                            &datagram.timestamp);
+    if (received < 0) {
+      return i > 0 ? static_cast<int>(i) : -1;
+    }
+    datagram.size = static_cast<size_t>(received);
+  }
+  return static_cast<int>(count);
+}
+
 }  // namespace rtc
@@ -146,6 +146,25 @@ class Socket {
                        size_t cb,
                        SocketAddress* paddr,
                        int64_t* timestamp) = 0;
+  // A datagram sent by SendToBatch() or received by RecvFromBatch().
+  struct Datagram {
+    // The payload to send, or the buffer to receive into.
+    char* data = nullptr;
+    // The size of the payload, or of the buffer. RecvFromBatch() sets it to
+    // the size of the received datagram.
+    size_t size = 0;
+    // The destination, or the source of a received datagram.
+    SocketAddress addr;
+    // Receive time in microseconds, or -1 if unknown.
+    int64_t timestamp = -1;
+  };
+  // Send or receive several datagrams, with a single system call where the
+  // platform supports it. They may stop short of |count|, like a partial
+  // write, and return the number of datagrams that were sent or received, or
+  // -1 if the first one failed. The default implementations call SendTo()
+  // and RecvFrom() for each datagram.
+  virtual int SendToBatch(const Datagram* datagrams, size_t count);
+  virtual int RecvFromBatch(Datagram* datagrams, size_t count);
   virtual int Listen(int backlog) = 0;
   virtual Socket* Accept(SocketAddress* paddr) = 0;
   virtual int Close() = 0;
@@ -166,6 +185,8 @@ class Socket {
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
                                // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_REUSEPORT,             // Whether sockets may share their address
+                               // (SO_REUSEPORT), set before Bind().
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
@@ -199,6 +199,15 @@ void SocketTest::TestUdpReadyToSendIPv6() {
 #endif
 }
 
+void SocketTest::TestUdpBatchIPv4() {
+  UdpBatchInternal(kIPv4Loopback);
+}
+
+void SocketTest::TestUdpBatchIPv6() {
+  MAYBE_SKIP_IPV6;
+  UdpBatchInternal(kIPv6Loopback);
+}
+
 void SocketTest::TestGetSetOptionsIPv4() {
   GetSetOptionsInternal(kIPv4Loopback);
 }
@@ -948,6 +957,37 @@ void SocketTest::UdpInternal(const IPAddress& loopback) {
   }
 }
 
+void SocketTest::UdpBatchInternal(const IPAddress& loopback) {
+  SocketAddress empty = EmptySocketAddressWithFamily(loopback.family());
+  AsyncUDPSocket* receiver =
+      AsyncUDPSocket::Create(ss_, SocketAddress(loopback, 0));
+  ASSERT_TRUE(receiver);
+  receiver->EnableBatchedReads(4);
+  SocketAddress receiver_addr = receiver->GetLocalAddress();
+  TestClient client(absl::WrapUnique(receiver));
+  std::unique_ptr<AsyncUDPSocket> sender(AsyncUDPSocket::Create(ss_, empty));
+  ASSERT_TRUE(sender);
+
+  // More datagrams than are read per read event.
+  char payloads[][7] = {"foo", "bar", "bizbaz", "a", "bc", "def"};
+  Socket::Datagram datagrams[arraysize(payloads)];
+  for (size_t i = 0; i < arraysize(payloads); ++i) {
+    datagrams[i].data = payloads[i];
+    datagrams[i].size = strlen(payloads[i]);
+    datagrams[i].addr = receiver_addr;
+  }
+  EXPECT_EQ(static_cast<int>(arraysize(payloads)),
+            sender->SendToBatch(datagrams, arraysize(payloads),
+                                PacketOptions()));
+
+  SocketAddress addr;
+  for (const char* payload : payloads) {
+    EXPECT_TRUE(client.CheckNextPacket(payload, strlen(payload), &addr));
+    EXPECT_EQ(sender->GetLocalAddress().port(), addr.port());
+  }
+  EXPECT_TRUE(client.CheckNoPacket());
+}
+
 void SocketTest::UdpReadyToSend(const IPAddress& loopback) {
   SocketAddress empty = EmptySocketAddressWithFamily(loopback.family());
   // RFC 5737 - The blocks 192.0.2.0/24 (TEST-NET-1) ... are provided for use in
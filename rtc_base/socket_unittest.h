@@ -56,6 +56,8 @@ class SocketTest : public ::testing::Test {
   void TestUdpIPv6();
   void TestUdpReadyToSendIPv4();
   void TestUdpReadyToSendIPv6();
+  void TestUdpBatchIPv4();
+  void TestUdpBatchIPv6();
   void TestGetSetOptionsIPv4();
   void TestGetSetOptionsIPv6();
   void TestSocketRecvTimestampIPv4();
@@ -87,6 +89,7 @@ class SocketTest : public ::testing::Test {
   void SingleFlowControlCallbackInternal(const IPAddress& loopback);
   void UdpInternal(const IPAddress& loopback);
   void UdpReadyToSend(const IPAddress& loopback);
+  void UdpBatchInternal(const IPAddress& loopback);
   void GetSetOptionsInternal(const IPAddress& loopback);
   void SocketRecvTimestamp(const IPAddress& loopback);
 
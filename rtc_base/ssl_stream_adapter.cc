@@ -89,6 +89,10 @@ bool IsGcmCryptoSuiteName(const std::string& crypto_suite) {
           crypto_suite == CS_AEAD_AES_128_GCM);
 }
 
+std::unique_ptr<SSLSessionCache> SSLSessionCache::Create(SSLMode mode) {
+  return OpenSSLStreamAdapter::CreateSessionCache(mode);
+}
+
 SSLStreamAdapter* SSLStreamAdapter::Create(StreamInterface* stream) {
   return new OpenSSLStreamAdapter(stream);
 }
@@ -98,6 +102,12 @@ SSLStreamAdapter::SSLStreamAdapter(StreamInterface* stream)
 
 SSLStreamAdapter::~SSLStreamAdapter() {}
 
+void SSLStreamAdapter::SetSessionCache(SSLSessionCache* session_cache) {}
+
+bool SSLStreamAdapter::IsSessionResumed() const {
+  return false;
+}
+
 bool SSLStreamAdapter::GetSslCipherSuite(int* cipher_suite) {
   return false;
 }
@@ -110,6 +110,20 @@ enum { SSE_MSG_TRUNC = 0xff0001 };
 // Used to send back UMA histogram value. Logged when Dtls handshake fails.
 enum class SSLHandshakeError { UNKNOWN, INCOMPATIBLE_CIPHERSUITE, MAX_VALUE };
 
+// Remembers the sessions of completed handshakes, so that a later handshake
+// between the same two certificates can resume one in a single round trip
+// instead of two. Servers issue session tickets encrypted with keys shared by
+// all the adapters using the cache, and clients look up the session to offer
+// by the digests of both certificates. May be shared by any number of
+// adapters on one thread, and must outlive them.
+class SSLSessionCache {
+ public:
+  // Instantiates a cache for the selected implementation for the platform.
+  static std::unique_ptr<SSLSessionCache> Create(SSLMode mode);
+
+  virtual ~SSLSessionCache() = default;
+};
+
 class SSLStreamAdapter : public StreamAdapterInterface {
  public:
   // Instantiate an SSLStreamAdapter wrapping the given stream,
@@ -147,6 +161,15 @@ class SSLStreamAdapter : public StreamAdapterInterface {
   // This should only be called before StartSSL().
   virtual void SetInitialRetransmissionTimeout(int timeout_ms) = 0;
 
+  // Lets the handshake resume a session from |session_cache|, and adds the
+  // session it negotiates to it. The peer certificate of a resumed session is
+  // checked against the digest like that of a full handshake.
+  // This should only be called before StartSSL().
+  virtual void SetSessionCache(SSLSessionCache* session_cache);
+
+  // Returns true if the handshake resumed a previous session.
+  virtual bool IsSessionResumed() const;
+
   // StartSSL starts negotiation with a peer, whose certificate is verified
   // using the certificate digest. Generally, SetIdentity() and possibly
   // SetServerRole() should have been called before this.
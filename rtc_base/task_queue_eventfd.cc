@@ -0,0 +1,445 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_eventfd.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "api/task_queue/queued_task.h"
+#include "api/task_queue/task_queue_base.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/numerics/safe_conversions.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/time_utils.h"
+
+namespace webrtc {
+namespace {
+
+rtc::ThreadPriority TaskQueuePriorityToThreadPriority(
+    TaskQueueFactory::Priority priority) {
+  switch (priority) {
+    case TaskQueueFactory::Priority::HIGH:
+      return rtc::kRealtimePriority;
+    case TaskQueueFactory::Priority::LOW:
+      return rtc::kLowPriority;
+    case TaskQueueFactory::Priority::NORMAL:
+      return rtc::kNormalPriority;
+    default:
+      RTC_NOTREACHED();
+      return rtc::kNormalPriority;
+  }
+}
+
+// A posted task. Links itself into the posting queue, and then into the timer
+// wheel if it is delayed, so that posting allocates nothing else.
+struct TaskNode {
+  TaskNode() = default;
+  TaskNode(std::unique_ptr<QueuedTask> task, int64_t run_at_ms)
+      : task(std::move(task)), run_at_ms(run_at_ms) {}
+
+  std::atomic<TaskNode*> next{nullptr};
+  TaskNode* next_timer = nullptr;
+  std::unique_ptr<QueuedTask> task;
+  // The time to run the task at, or -1 to run it as soon as possible.
+  int64_t run_at_ms = -1;
+  // Breaks ties between delayed tasks to run at the same time.
+  uint64_t order = 0;
+};
+
+// Intrusive multi-producer single-consumer queue (Vyukov). Push() is wait-free
+// and may be called from any thread; Pop() may only be called from the single
+// consumer. Pop() can return null while a concurrent Push() is half done; the
+// pushing thread then wakes the consumer after finishing, see PostNode().
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  ~MpscQueue() {
+    while (TaskNode* node = Pop())
+      delete node;
+  }
+
+  void Push(TaskNode* node) {
+    node->next.store(nullptr);
+    TaskNode* prev = head_.exchange(node);
+    prev->next.store(node);
+  }
+
+  TaskNode* Pop() {
+    TaskNode* tail = tail_;
+    TaskNode* next = tail->next.load();
+    if (tail == &stub_) {
+      if (!next)
+        return nullptr;
+      tail_ = next;
+      tail = next;
+      next = next->next.load();
+    }
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    if (tail != head_.load())
+      return nullptr;
+    Push(&stub_);
+    next = tail->next.load();
+    if (next) {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+
+ private:
+  // Where producers add nodes.
+  std::atomic<TaskNode*> head_;
+  // Where the consumer removes them; only touched by the consumer.
+  TaskNode* tail_;
+  TaskNode stub_;
+};
+
+// Hierarchical timer wheel holding the delayed tasks of one queue. Level 0 has
+// |kSlots| slots of 1 ms, and every level above has |kSlots| slots each
+// covering a full turn of the level below, so that adding and expiring a timer
+// costs O(1) no matter how many are pending. When a level wraps around, the
+// next slot of the level above is cascaded down. Timers beyond the range of
+// the wheel (about 4.6 hours) wait in its last slot and are cascaded again.
+// Only used on the task queue thread.
+class TimerWheel {
+ public:
+  explicit TimerWheel(int64_t now_ms) : current_ms_(now_ms) {}
+  ~TimerWheel() {
+    for (auto& level : slots_) {
+      for (Slot& slot : level) {
+        while (TaskNode* node = slot.head) {
+          slot.head = node->next_timer;
+          delete node;
+        }
+      }
+    }
+  }
+
+  bool empty() const { return size_ == 0; }
+
+  // Adds |node|, which must be due after the current time of the wheel.
+  void Insert(TaskNode* node) {
+    RTC_DCHECK_GT(node->run_at_ms, current_ms_);
+    node->order = next_order_++;
+    Add(node);
+    ++size_;
+  }
+
+  // Advances the wheel to |now_ms| and appends the timers that are due by then
+  // to |expired|, in the order they are due.
+  void Advance(int64_t now_ms, std::vector<TaskNode*>* expired) {
+    const size_t first_expired = expired->size();
+    while (current_ms_ < now_ms) {
+      if (size_ == 0) {
+        current_ms_ = now_ms;
+        break;
+      }
+      // Skip ahead over turns of empty levels, up to just before the next
+      // cascade into them.
+      int empty_levels = 0;
+      while (empty_levels < kLevels - 1 && occupied_[empty_levels] == 0)
+        ++empty_levels;
+      if (empty_levels > 0) {
+        const int64_t skip_to =
+            current_ms_ | ((int64_t{1} << (kSlotBits * empty_levels)) - 1);
+        if (skip_to >= now_ms) {
+          current_ms_ = now_ms;
+          break;
+        }
+        current_ms_ = skip_to;
+      }
+
+      ++current_ms_;
+      int top_level = 0;
+      while (top_level < kLevels - 1 &&
+             (current_ms_ & LevelMask(top_level + 1)) == 0) {
+        ++top_level;
+      }
+      for (int level = top_level; level > 0; --level)
+        Cascade(level, SlotIndex(level, current_ms_));
+
+      Slot& slot = slots_[0][SlotIndex(0, current_ms_)];
+      for (TaskNode* node = slot.head; node;) {
+        TaskNode* next = node->next_timer;
+        RTC_DCHECK_LE(node->run_at_ms, current_ms_);
+        expired->push_back(node);
+        --size_;
+        node = next;
+      }
+      slot = Slot();
+      occupied_[0] &= ~(uint64_t{1} << SlotIndex(0, current_ms_));
+    }
+    std::sort(expired->begin() + first_expired, expired->end(),
+              [](const TaskNode* a, const TaskNode* b) {
+                return std::tie(a->run_at_ms, a->order) <
+                       std::tie(b->run_at_ms, b->order);
+              });
+  }
+
+  // Returns the time from |now_ms| until the wheel next needs advancing, or
+  // -1 if it is empty.
+  int64_t TimeUntilNextMs(int64_t now_ms) const {
+    if (size_ == 0)
+      return -1;
+    int64_t next_ms = std::numeric_limits<int64_t>::max();
+    for (int level = 0; level < kLevels; ++level) {
+      if (occupied_[level] == 0)
+        continue;
+      const int shift = kSlotBits * level;
+      const int start = (SlotIndex(level, current_ms_) + 1) % kSlots;
+      const uint64_t rotated = RotateRight(occupied_[level], start);
+      const int64_t turns = __builtin_ctzll(rotated) + 1;
+      next_ms = std::min(next_ms, ((current_ms_ >> shift) + turns) << shift);
+    }
+    return std::max<int64_t>(0, next_ms - now_ms);
+  }
+
+ private:
+  static constexpr int kSlotBits = 6;
+  static constexpr int kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 4;
+
+  struct Slot {
+    TaskNode* head = nullptr;
+    TaskNode* tail = nullptr;
+  };
+
+  static int64_t LevelMask(int level) {
+    return (int64_t{1} << (kSlotBits * level)) - 1;
+  }
+  static int SlotIndex(int level, int64_t ms) {
+    return static_cast<int>((ms >> (kSlotBits * level)) & (kSlots - 1));
+  }
+  static uint64_t RotateRight(uint64_t bits, int n) {
+    return (bits >> n) | (bits << ((kSlots - n) % kSlots));
+  }
+
+  // Puts |node| into the slot for its time, relative to the current time.
+  void Add(TaskNode* node) {
+    int64_t delay_ms = node->run_at_ms - current_ms_;
+    RTC_DCHECK_GE(delay_ms, 0);
+    int level = 0;
+    while (level < kLevels - 1 && delay_ms > LevelMask(level + 1))
+      ++level;
+    const int64_t max_delay_ms = LevelMask(kLevels);
+    delay_ms = std::min(delay_ms, max_delay_ms);
+    const int index = SlotIndex(level, current_ms_ + delay_ms);
+    Slot& slot = slots_[level][index];
+    node->next_timer = nullptr;
+    if (slot.tail)
+      slot.tail->next_timer = node;
+    else
+      slot.head = node;
+    slot.tail = node;
+    occupied_[level] |= uint64_t{1} << index;
+  }
+
+  void Cascade(int level, int index) {
+    Slot slot = slots_[level][index];
+    slots_[level][index] = Slot();
+    occupied_[level] &= ~(uint64_t{1} << index);
+    for (TaskNode* node = slot.head; node;) {
+      TaskNode* next = node->next_timer;
+      Add(node);
+      node = next;
+    }
+  }
+
+  int64_t current_ms_;
+  size_t size_ = 0;
+  uint64_t next_order_ = 0;
+  Slot slots_[kLevels][kSlots];
+  // Bit i of |occupied_[level]| is set when |slots_[level][i]| is not empty.
+  uint64_t occupied_[kLevels] = {};
+};
+
+class TaskQueueEventfd final : public TaskQueueBase {
+ public:
+  TaskQueueEventfd(absl::string_view queue_name, rtc::ThreadPriority priority);
+  ~TaskQueueEventfd() override;
+
+  void Delete() override;
+  void PostTask(std::unique_ptr<QueuedTask> task) override;
+  void PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds) override;
+
+ private:
+  // The most posted tasks to handle before checking the timers again.
+  static constexpr int kMaxTasksPerTimerCheck = 256;
+
+  static void ThreadMain(void* context);
+
+  void ProcessTasks();
+  // Runs |node|, or adds it to |timers| if it is not due yet.
+  void HandleNode(TaskNode* node, TimerWheel* timers);
+  void RunTask(TaskNode* node);
+  void PostNode(TaskNode* node);
+  void Wakeup();
+
+  const int wakeup_fd_;
+  MpscQueue queue_;
+  // True while the thread is going to sleep, or is sleeping, until woken by
+  // a write to |wakeup_fd_|. Posting threads take it back to false, so that
+  // only one of them writes, and none while the thread is busy.
+  std::atomic<bool> needs_wakeup_{false};
+  std::atomic<bool> quit_{false};
+  rtc::PlatformThread thread_;
+};
+
+TaskQueueEventfd::TaskQueueEventfd(absl::string_view queue_name,
+                                   rtc::ThreadPriority priority)
+    : wakeup_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+      thread_(&TaskQueueEventfd::ThreadMain, this, queue_name, priority) {
+  RTC_CHECK_GE(wakeup_fd_, 0) << "eventfd failed, errno: " << errno;
+  thread_.Start();
+}
+
+TaskQueueEventfd::~TaskQueueEventfd() {
+  close(wakeup_fd_);
+}
+
+void TaskQueueEventfd::Delete() {
+  RTC_DCHECK(!IsCurrent());
+  quit_.store(true);
+  Wakeup();
+  thread_.Stop();
+  delete this;
+}
+
+void TaskQueueEventfd::PostTask(std::unique_ptr<QueuedTask> task) {
+  PostNode(new TaskNode(std::move(task), /*run_at_ms=*/-1));
+}
+
+void TaskQueueEventfd::PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                                       uint32_t milliseconds) {
+  // The delay is counted from now, however long the task takes to reach the
+  // task queue thread.
+  PostNode(new TaskNode(std::move(task), rtc::TimeMillis() + milliseconds));
+}
+
+void TaskQueueEventfd::PostNode(TaskNode* node) {
+  queue_.Push(node);
+  // The thread checks the queue after setting |needs_wakeup_|, and before
+  // sleeping, so the write is needed only when it is set. This is also the
+  // case when the thread saw this node half pushed.
+  if (!IsCurrent() && needs_wakeup_.exchange(false))
+    Wakeup();
+}
+
+void TaskQueueEventfd::Wakeup() {
+  const uint64_t value = 1;
+  while (write(wakeup_fd_, &value, sizeof(value)) < 0) {
+    // Only fails with EAGAIN if the counter is about to overflow, in which
+    // case the thread is already woken.
+    if (errno != EINTR) {
+      RTC_DCHECK_EQ(errno, EAGAIN);
+      break;
+    }
+  }
+}
+
+// static
+void TaskQueueEventfd::ThreadMain(void* context) {
+  TaskQueueEventfd* me = static_cast<TaskQueueEventfd*>(context);
+  CurrentTaskQueueSetter set_current(me);
+  me->ProcessTasks();
+}
+
+void TaskQueueEventfd::ProcessTasks() {
+  TimerWheel timers(rtc::TimeMillis());
+  std::vector<TaskNode*> expired;
+  while (!quit_.load()) {
+    timers.Advance(rtc::TimeMillis(), &expired);
+    for (TaskNode* node : expired)
+      RunTask(node);
+    expired.clear();
+
+    int tasks_handled = 0;
+    while (tasks_handled < kMaxTasksPerTimerCheck) {
+      TaskNode* node = queue_.Pop();
+      if (!node)
+        break;
+      HandleNode(node, &timers);
+      ++tasks_handled;
+    }
+    if (tasks_handled == kMaxTasksPerTimerCheck)
+      continue;
+
+    // About to sleep; see PostNode().
+    needs_wakeup_.store(true);
+    if (TaskNode* node = queue_.Pop()) {
+      needs_wakeup_.store(false);
+      HandleNode(node, &timers);
+      continue;
+    }
+    if (quit_.load())
+      break;
+
+    const int64_t timeout_ms = timers.TimeUntilNextMs(rtc::TimeMillis());
+    struct pollfd fds = {wakeup_fd_, POLLIN, 0};
+    int result = poll(&fds, 1, rtc::saturated_cast<int>(timeout_ms));
+    if (result < 0 && errno != EINTR)
+      RTC_LOG_ERRNO(LS_ERROR) << "poll failed";
+    if (result > 0) {
+      uint64_t value;
+      while (read(wakeup_fd_, &value, sizeof(value)) < 0 && errno == EINTR) {
+      }
+    }
+    needs_wakeup_.store(false);
+  }
+}
+
+void TaskQueueEventfd::HandleNode(TaskNode* node, TimerWheel* timers) {
+  if (node->run_at_ms > rtc::TimeMillis())
+    timers->Insert(node);
+  else
+    RunTask(node);
+}
+
+void TaskQueueEventfd::RunTask(TaskNode* node) {
+  QueuedTask* task = node->task.release();
+  delete node;
+  if (task->Run())
+    delete task;
+}
+
+class TaskQueueEventfdFactory final : public TaskQueueFactory {
+ public:
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
+      absl::string_view name,
+      Priority priority) const override {
+    return std::unique_ptr<TaskQueueBase, TaskQueueDeleter>(
+        new TaskQueueEventfd(name,
+                             TaskQueuePriorityToThreadPriority(priority)));
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<TaskQueueFactory> CreateTaskQueueEventfdFactory() {
+  return absl::make_unique<TaskQueueEventfdFactory>();
+}
+
+}  // namespace webrtc
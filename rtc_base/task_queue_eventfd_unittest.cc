@@ -0,0 +1,133 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_eventfd.h"
+
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/task_queue/task_queue_test.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+INSTANTIATE_TEST_SUITE_P(Eventfd,
+                         TaskQueueTest,
+                         ::testing::Values(CreateTaskQueueEventfdFactory));
+
+TEST(TaskQueueEventfdTest, RunsDelayedTasksInDeadlineOrder) {
+  std::unique_ptr<TaskQueueFactory> factory = CreateTaskQueueEventfdFactory();
+  auto queue = factory->CreateTaskQueue("DeadlineOrder",
+                                        TaskQueueFactory::Priority::NORMAL);
+  // Delays from 0 to 390 ms, crossing the first level of the timer wheel,
+  // posted out of order.
+  constexpr int kNumTasks = 40;
+  constexpr int kDelayStepMs = 10;
+  std::vector<int> delays_run;
+  rtc::Event done;
+  const int64_t start_ms = rtc::TimeMillis();
+  for (int i = 0; i < kNumTasks; ++i) {
+    const int delay_ms = ((i * 7) % kNumTasks) * kDelayStepMs;
+    queue->PostDelayedTask(ToQueuedTask([&, delay_ms] {
+                             EXPECT_GE(rtc::TimeMillis() - start_ms, delay_ms);
+                             delays_run.push_back(delay_ms);
+                             if (delays_run.size() == kNumTasks)
+                               done.Set();
+                           }),
+                           delay_ms);
+  }
+  ASSERT_TRUE(done.Wait(5000));
+  for (int i = 0; i < kNumTasks; ++i)
+    EXPECT_EQ(i * kDelayStepMs, delays_run[i]);
+}
+
+TEST(TaskQueueEventfdTest, RunsTasksWithTheSameDeadlineInPostOrder) {
+  std::unique_ptr<TaskQueueFactory> factory = CreateTaskQueueEventfdFactory();
+  auto queue = factory->CreateTaskQueue("SameDeadline",
+                                        TaskQueueFactory::Priority::NORMAL);
+  constexpr int kNumTasks = 100;
+  std::vector<int> order;
+  rtc::Event done;
+  // Posted from the queue, so that all have the same deadline.
+  queue->PostTask(ToQueuedTask([&] {
+    for (int i = 0; i < kNumTasks; ++i) {
+      queue->PostDelayedTask(ToQueuedTask([&, i] {
+                               order.push_back(i);
+                               if (order.size() == kNumTasks)
+                                 done.Set();
+                             }),
+                             100);
+    }
+  }));
+  ASSERT_TRUE(done.Wait(5000));
+  for (int i = 0; i < kNumTasks; ++i)
+    EXPECT_EQ(i, order[i]);
+}
+
+struct Producer {
+  TaskQueueBase* queue;
+  int index;
+  int num_tasks;
+  std::vector<int>* last_run;
+  int* total_run;
+  rtc::Event* done;
+};
+
+void PostTasks(void* context) {
+  Producer* producer = static_cast<Producer*>(context);
+  for (int i = 0; i < producer->num_tasks; ++i) {
+    producer->queue->PostTask(ToQueuedTask([producer, i] {
+      // Tasks from one thread run in the order that thread posted them.
+      int& last_run = (*producer->last_run)[producer->index];
+      EXPECT_EQ(last_run + 1, i);
+      last_run = i;
+      if (++*producer->total_run ==
+          producer->num_tasks * static_cast<int>(producer->last_run->size()))
+        producer->done->Set();
+    }));
+  }
+}
+
+TEST(TaskQueueEventfdTest, RunsTasksPostedConcurrently) {
+  std::unique_ptr<TaskQueueFactory> factory = CreateTaskQueueEventfdFactory();
+  auto queue = factory->CreateTaskQueue("Concurrent",
+                                        TaskQueueFactory::Priority::NORMAL);
+  constexpr int kNumProducers = 4;
+  constexpr int kTasksPerProducer = 20000;
+  std::vector<int> last_run(kNumProducers, -1);
+  int total_run = 0;
+  rtc::Event done;
+
+  std::vector<Producer> producers;
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < kNumProducers; ++i) {
+    producers.push_back(Producer{queue.get(), i, kTasksPerProducer, &last_run,
+                                 &total_run, &done});
+  }
+  for (Producer& producer : producers) {
+    threads.push_back(absl::make_unique<rtc::PlatformThread>(
+        &PostTasks, &producer, "Producer"));
+    threads.back()->Start();
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+  ASSERT_TRUE(done.Wait(10000));
+  for (int last : last_run)
+    EXPECT_EQ(kTasksPerProducer - 1, last);
+}
+
+}  // namespace
+}  // namespace webrtc
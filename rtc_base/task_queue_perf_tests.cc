@@ -0,0 +1,285 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/task_queue/default_task_queue_factory.h"
+#include "api/task_queue/task_queue_factory.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/task_queue_stdlib.h"
+#include "rtc_base/task_queue_thread_pool.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+#include "rtc_base/task_queue_eventfd.h"
+#endif
+
+namespace webrtc {
+namespace {
+
+constexpr int kNumLatencySamples = 5000;
+constexpr int kNumProducers = 4;
+constexpr int kTasksPerProducer = 250000;
+constexpr int kNumDelayedTasks = 100000;
+constexpr int kMaxDelayMs = 1000;
+constexpr int kNumPeriodicQueues = 2000;
+constexpr int kPoolThreads = 4;
+constexpr int kPeriodMs = 20;
+constexpr int kPeriodicRunMs = 5000;
+
+struct NamedFactory {
+  std::string name;
+  std::function<std::unique_ptr<TaskQueueFactory>()> create;
+};
+
+std::vector<NamedFactory> Factories() {
+  std::vector<NamedFactory> factories = {
+      {"default", CreateDefaultTaskQueueFactory},
+      {"stdlib", CreateTaskQueueStdlibFactory}};
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_ANDROID)
+  factories.push_back({"eventfd", CreateTaskQueueEventfdFactory});
+#endif
+  return factories;
+}
+
+double Percentile(std::vector<double> values, double percentile) {
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(percentile * (values.size() - 1))];
+}
+
+// Posts one task at a time to an idle queue and measures the time until it
+// starts running, which includes waking the queue thread.
+void MeasurePostToRunLatency(const NamedFactory& factory) {
+  auto task_queue_factory = factory.create();
+  auto queue = task_queue_factory->CreateTaskQueue(
+      "Latency", TaskQueueFactory::Priority::NORMAL);
+  std::vector<double> latencies_us;
+  rtc::Event ran;
+  for (int i = 0; i < kNumLatencySamples; ++i) {
+    const int64_t posted_ns = rtc::TimeNanos();
+    queue->PostTask(ToQueuedTask([&] {
+      latencies_us.push_back(static_cast<double>(rtc::TimeNanos() - posted_ns) /
+                             rtc::kNumNanosecsPerMicrosec);
+      ran.Set();
+    }));
+    ran.Wait(rtc::Event::kForever);
+  }
+  test::PrintResult("task_queue", "_" + factory.name, "post_to_run_latency_p50",
+                    Percentile(latencies_us, 0.5), "us", true);
+  test::PrintResult("task_queue", "_" + factory.name, "post_to_run_latency_p99",
+                    Percentile(latencies_us, 0.99), "us", false);
+}
+
+struct ThroughputContext {
+  TaskQueueBase* queue;
+  int tasks_run = 0;
+  rtc::Event done;
+};
+
+void PostTasksForThroughput(void* param) {
+  ThroughputContext* context = static_cast<ThroughputContext*>(param);
+  for (int i = 0; i < kTasksPerProducer; ++i) {
+    context->queue->PostTask(ToQueuedTask([context] {
+      if (++context->tasks_run == kNumProducers * kTasksPerProducer)
+        context->done.Set();
+    }));
+  }
+}
+
+// Posts small tasks from |kNumProducers| threads at once, and measures how
+// many the queue runs per second.
+void MeasureThroughput(const NamedFactory& factory) {
+  auto task_queue_factory = factory.create();
+  auto queue = task_queue_factory->CreateTaskQueue(
+      "Throughput", TaskQueueFactory::Priority::NORMAL);
+  ThroughputContext context;
+  context.queue = queue.get();
+  std::vector<std::unique_ptr<rtc::PlatformThread>> producers;
+  for (int i = 0; i < kNumProducers; ++i) {
+    producers.push_back(absl::make_unique<rtc::PlatformThread>(
+        &PostTasksForThroughput, &context, "Producer"));
+  }
+  const int64_t start_us = rtc::TimeMicros();
+  for (auto& producer : producers)
+    producer->Start();
+  context.done.Wait(rtc::Event::kForever);
+  const int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  for (auto& producer : producers)
+    producer->Stop();
+  test::PrintResult("task_queue", "_" + factory.name, "throughput",
+                    kNumProducers * kTasksPerProducer *
+                        static_cast<double>(rtc::kNumMicrosecsPerSec) /
+                        elapsed_us,
+                    "tasks/s", true);
+}
+
+// Posts many delayed tasks with spread out delays, as with many pacers and
+// retransmission timers on one queue, and measures how late they run.
+void MeasureDelayedTaskLateness(const NamedFactory& factory) {
+  auto task_queue_factory = factory.create();
+  auto queue = task_queue_factory->CreateTaskQueue(
+      "Delayed", TaskQueueFactory::Priority::NORMAL);
+  std::vector<double> lateness_ms;
+  lateness_ms.reserve(kNumDelayedTasks);
+  rtc::Event done;
+  uint32_t random = 1;
+  for (int i = 0; i < kNumDelayedTasks; ++i) {
+    random = random * 1103515245 + 12345;
+    const uint32_t delay_ms = (random >> 8) % kMaxDelayMs;
+    const int64_t run_at_us =
+        rtc::TimeMicros() + delay_ms * rtc::kNumMicrosecsPerMillisec;
+    queue->PostDelayedTask(ToQueuedTask([&, run_at_us] {
+                             lateness_ms.push_back(
+                                 static_cast<double>(rtc::TimeMicros() -
+                                                     run_at_us) /
+                                 rtc::kNumMicrosecsPerMillisec);
+                             if (lateness_ms.size() == kNumDelayedTasks)
+                               done.Set();
+                           }),
+                           delay_ms);
+  }
+  done.Wait(rtc::Event::kForever);
+  test::PrintResult("task_queue", "_" + factory.name,
+                    "delayed_task_lateness_p50", Percentile(lateness_ms, 0.5),
+                    "ms", false);
+  test::PrintResult("task_queue", "_" + factory.name,
+                    "delayed_task_lateness_p99", Percentile(lateness_ms, 0.99),
+                    "ms", true);
+}
+
+// Reposts itself every |kPeriodMs| until its queue is deleted, like the
+// timers of an idle stream.
+class PeriodicTask : public QueuedTask {
+ public:
+  PeriodicTask(TaskQueueBase* queue, std::atomic<int>* runs)
+      : queue_(queue), runs_(runs) {}
+
+ private:
+  bool Run() override {
+    ++*runs_;
+    queue_->PostDelayedTask(absl::WrapUnique(this), kPeriodMs);
+    return false;
+  }
+
+  TaskQueueBase* const queue_;
+  std::atomic<int>* const runs_;
+};
+
+int64_t ContextSwitches() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// Returns a "<name>:  <value> kB" field of /proc/self/status, or 0.
+int64_t ProcessStatusKb(const char* name) {
+  int64_t value = 0;
+  FILE* file = fopen("/proc/self/status", "r");
+  if (!file)
+    return 0;
+  char line[256];
+  const size_t name_length = strlen(name);
+  while (fgets(line, sizeof(line), file)) {
+    if (strncmp(line, name, name_length) == 0 && line[name_length] == ':') {
+      value = strtoll(line + name_length + 1, nullptr, 10);
+      break;
+    }
+  }
+  fclose(file);
+  return value;
+}
+
+// Runs |kNumPeriodicQueues| queues that each run a small task every
+// |kPeriodMs|, as the per-stream queues of a media server, and measures the
+// memory, context switches and CPU that this costs.
+void MeasureManyPeriodicQueues(const std::string& name,
+                               const TaskQueueFactory& factory) {
+  const int64_t start_rss_kb = ProcessStatusKb("VmRSS");
+  const int64_t start_vm_kb = ProcessStatusKb("VmSize");
+  std::atomic<int> runs(0);
+  std::vector<std::unique_ptr<TaskQueueBase, TaskQueueDeleter>> queues;
+  for (int i = 0; i < kNumPeriodicQueues; ++i) {
+    queues.push_back(factory.CreateTaskQueue(
+        "Periodic", TaskQueueFactory::Priority::NORMAL));
+    queues.back()->PostDelayedTask(
+        absl::make_unique<PeriodicTask>(queues.back().get(), &runs),
+        i % kPeriodMs);
+  }
+  const int64_t rss_kb = ProcessStatusKb("VmRSS") - start_rss_kb;
+  const int64_t vm_kb = ProcessStatusKb("VmSize") - start_vm_kb;
+  const int64_t threads = ProcessStatusKb("Threads");
+
+  const int start_runs = runs.load();
+  const int64_t start_context_switches = ContextSwitches();
+  const int64_t start_cpu_ns = rtc::GetProcessCpuTimeNanos();
+  const int64_t start_ms = rtc::TimeMillis();
+  rtc::Event().Wait(kPeriodicRunMs);
+  const double elapsed_s = static_cast<double>(rtc::TimeMillis() - start_ms) /
+                           rtc::kNumMillisecsPerSec;
+  const int64_t cpu_ns = rtc::GetProcessCpuTimeNanos() - start_cpu_ns;
+  const int64_t context_switches = ContextSwitches() - start_context_switches;
+  const int run_count = runs.load() - start_runs;
+  queues.clear();
+
+  test::PrintResult("task_queue_periodic", "_" + name, "threads", threads,
+                    "count", false);
+  test::PrintResult("task_queue_periodic", "_" + name, "rss_increase",
+                    rss_kb / 1024.0, "MB", true);
+  test::PrintResult("task_queue_periodic", "_" + name,
+                    "virtual_memory_increase", vm_kb / 1024.0, "MB", false);
+  test::PrintResult("task_queue_periodic", "_" + name, "context_switches",
+                    context_switches / elapsed_s, "1/s", true);
+  test::PrintResult("task_queue_periodic", "_" + name, "cpu_usage",
+                    100.0 * cpu_ns / (elapsed_s * rtc::kNumNanosecsPerSec), "%",
+                    true);
+  test::PrintResult("task_queue_periodic", "_" + name, "tasks_run",
+                    run_count / elapsed_s, "tasks/s", false);
+}
+
+}  // namespace
+
+TEST(TaskQueuePerfTest, PostToRunLatency) {
+  for (const NamedFactory& factory : Factories())
+    MeasurePostToRunLatency(factory);
+}
+
+TEST(TaskQueuePerfTest, Throughput) {
+  for (const NamedFactory& factory : Factories())
+    MeasureThroughput(factory);
+}
+
+TEST(TaskQueuePerfTest, DelayedTaskLateness) {
+  for (const NamedFactory& factory : Factories())
+    MeasureDelayedTaskLateness(factory);
+}
+
+TEST(TaskQueuePerfTest, ManyPeriodicQueues) {
+  MeasureManyPeriodicQueues(
+      "thread_pool", *CreateTaskQueueThreadPoolFactory(kPoolThreads));
+  MeasureManyPeriodicQueues("thread_per_queue",
+                            *CreateDefaultTaskQueueFactory());
+}
+
+}  // namespace webrtc
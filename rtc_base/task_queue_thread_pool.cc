@@ -0,0 +1,430 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_thread_pool.h"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "api/scoped_refptr.h"
+#include "api/task_queue/queued_task.h"
+#include "api/task_queue/task_queue_base.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/ref_count.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/thread_annotations.h"
+#include "rtc_base/time_utils.h"
+
+namespace webrtc {
+namespace {
+
+// Most tasks a queue runs before its thread moves on to other queues.
+constexpr int kMaxTasksPerSlice = 32;
+
+// Index of the run queues for each priority, in the order they are served.
+constexpr int kNumPriorities = 3;
+
+int PriorityIndex(TaskQueueFactory::Priority priority) {
+  switch (priority) {
+    case TaskQueueFactory::Priority::HIGH:
+      return 0;
+    case TaskQueueFactory::Priority::NORMAL:
+      return 1;
+    case TaskQueueFactory::Priority::LOW:
+      return 2;
+    default:
+      RTC_NOTREACHED();
+      return 1;
+  }
+}
+
+class ThreadPool;
+
+class PooledTaskQueue : public TaskQueueBase, public rtc::RefCountInterface {
+ public:
+  PooledTaskQueue(ThreadPool* pool, int priority_index)
+      : pool_(pool), priority_index_(priority_index) {}
+
+  void Delete() override;
+  void PostTask(std::unique_ptr<QueuedTask> task) override;
+  void PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds) override;
+
+  int priority_index() const { return priority_index_; }
+
+  // Runs up to |kMaxTasksPerSlice| tasks on the calling pool thread. Returns
+  // true if the queue has more tasks and must be run again.
+  bool RunSlice();
+
+ protected:
+  ~PooledTaskQueue() override = default;
+
+ private:
+  ThreadPool* const pool_;
+  const int priority_index_;
+
+  rtc::CriticalSection lock_;
+  std::queue<std::unique_ptr<QueuedTask>> tasks_ RTC_GUARDED_BY(lock_);
+  // True from when the queue is handed to the pool to run, until it runs out
+  // of tasks.
+  bool scheduled_ RTC_GUARDED_BY(lock_) = false;
+  bool running_ RTC_GUARDED_BY(lock_) = false;
+  bool deleted_ RTC_GUARDED_BY(lock_) = false;
+  // Signaled when a task finishes running after Delete() was called.
+  rtc::Event stopped_running_;
+};
+
+// A pool thread, with the queues that are ready to run on it.
+struct PoolWorker {
+  ThreadPool* pool = nullptr;
+  size_t index = 0;
+  rtc::CriticalSection lock;
+  std::deque<rtc::scoped_refptr<PooledTaskQueue>> runnable[kNumPriorities]
+      RTC_GUARDED_BY(lock);
+  // Set when the thread is about to wait, or is waiting, on |wakeup|.
+  std::atomic<bool> idle{false};
+  rtc::Event wakeup;
+  std::unique_ptr<rtc::PlatformThread> thread;
+};
+
+ABSL_CONST_INIT thread_local PoolWorker* current_worker = nullptr;
+
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  // Hands |queue|, which has tasks to run, to a pool thread.
+  void Schedule(rtc::scoped_refptr<PooledTaskQueue> queue);
+
+  void PostDelayedTask(PooledTaskQueue* queue,
+                       std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds);
+  void CancelDelayedTasks(PooledTaskQueue* queue);
+
+ private:
+  struct DelayedEntryTimeout {
+    int64_t next_fire_at_ms;
+    uint64_t order;
+
+    bool operator<(const DelayedEntryTimeout& o) const {
+      return std::tie(next_fire_at_ms, order) <
+             std::tie(o.next_fire_at_ms, o.order);
+    }
+  };
+  struct DelayedTask {
+    PooledTaskQueue* queue;
+    std::unique_ptr<QueuedTask> task;
+  };
+
+  static void WorkerMain(void* context);
+  void RunWorker(PoolWorker* worker);
+  // Adds |queue| to the run queue of |worker|. Returns true if other queues
+  // are already waiting there.
+  bool Push(PoolWorker* worker, rtc::scoped_refptr<PooledTaskQueue> queue);
+  // Takes the next queue to run on |worker|, from its own run queues or else
+  // by stealing from other workers, highest priority first.
+  rtc::scoped_refptr<PooledTaskQueue> FindWork(PoolWorker* worker);
+  void WakeIdleWorker(size_t first_index);
+
+  static void TimerMain(void* context);
+  void RunTimers();
+
+  std::vector<std::unique_ptr<PoolWorker>> workers_;
+  std::atomic<size_t> next_worker_{0};
+  std::atomic<bool> quit_{false};
+
+  rtc::CriticalSection timer_lock_;
+  std::map<DelayedEntryTimeout, DelayedTask> delayed_tasks_
+      RTC_GUARDED_BY(timer_lock_);
+  uint64_t next_order_ RTC_GUARDED_BY(timer_lock_) = 0;
+  rtc::Event timer_wakeup_;
+  rtc::PlatformThread timer_thread_;
+};
+
+ThreadPool::ThreadPool(int num_threads)
+    : timer_thread_(&ThreadPool::TimerMain, this, "TaskQueuePoolTimer") {
+  RTC_DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    auto worker = absl::make_unique<PoolWorker>();
+    worker->pool = this;
+    worker->index = i;
+    rtc::StringBuilder name;
+    name << "TaskQueuePool" << i;
+    worker->thread = absl::make_unique<rtc::PlatformThread>(
+        &ThreadPool::WorkerMain, worker.get(), name.str());
+    workers_.push_back(std::move(worker));
+  }
+  for (auto& worker : workers_)
+    worker->thread->Start();
+  timer_thread_.Start();
+}
+
+ThreadPool::~ThreadPool() {
+  quit_.store(true);
+  timer_wakeup_.Set();
+  timer_thread_.Stop();
+  for (auto& worker : workers_)
+    worker->wakeup.Set();
+  for (auto& worker : workers_)
+    worker->thread->Stop();
+}
+
+void ThreadPool::Schedule(rtc::scoped_refptr<PooledTaskQueue> queue) {
+  // A queue posted to from a pool thread goes on that thread, which runs it
+  // next unless an idle thread steals it first. Otherwise the queues are
+  // spread over the threads. Either way an idle thread is woken, since the
+  // thread the queue is on may be busy, e.g. with the task that posted it,
+  // which may block.
+  PoolWorker* worker = current_worker;
+  if (!worker || worker->pool != this)
+    worker = workers_[next_worker_++ % workers_.size()].get();
+  Push(worker, std::move(queue));
+  WakeIdleWorker(worker->index);
+}
+
+bool ThreadPool::Push(PoolWorker* worker,
+                      rtc::scoped_refptr<PooledTaskQueue> queue) {
+  const int priority = queue->priority_index();
+  rtc::CritScope lock(&worker->lock);
+  bool others_waiting = false;
+  for (const auto& runnable : worker->runnable)
+    others_waiting |= !runnable.empty();
+  worker->runnable[priority].push_back(std::move(queue));
+  return others_waiting;
+}
+
+void ThreadPool::WakeIdleWorker(size_t first_index) {
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    PoolWorker* worker = workers_[(first_index + i) % workers_.size()].get();
+    if (worker->idle.exchange(false)) {
+      worker->wakeup.Set();
+      return;
+    }
+  }
+}
+
+rtc::scoped_refptr<PooledTaskQueue> ThreadPool::FindWork(PoolWorker* worker) {
+  for (int priority = 0; priority < kNumPriorities; ++priority) {
+    for (size_t i = 0; i < workers_.size(); ++i) {
+      PoolWorker* victim =
+          workers_[(worker->index + i) % workers_.size()].get();
+      rtc::CritScope lock(&victim->lock);
+      auto& runnable = victim->runnable[priority];
+      if (!runnable.empty()) {
+        rtc::scoped_refptr<PooledTaskQueue> queue = std::move(runnable.front());
+        runnable.pop_front();
+        return queue;
+      }
+    }
+  }
+  return nullptr;
+}
+
+// static
+void ThreadPool::WorkerMain(void* context) {
+  PoolWorker* worker = static_cast<PoolWorker*>(context);
+  worker->pool->RunWorker(worker);
+}
+
+void ThreadPool::RunWorker(PoolWorker* worker) {
+  current_worker = worker;
+  while (!quit_.load()) {
+    rtc::scoped_refptr<PooledTaskQueue> queue = FindWork(worker);
+    if (!queue) {
+      // Announce the wait before looking again, so that a queue scheduled
+      // in between either is found or wakes this thread.
+      worker->idle.store(true);
+      queue = FindWork(worker);
+      if (!queue) {
+        worker->wakeup.Wait(rtc::Event::kForever);
+        continue;
+      }
+      worker->idle.store(false);
+    }
+    if (queue->RunSlice() && Push(worker, queue))
+      WakeIdleWorker(worker->index);
+  }
+  current_worker = nullptr;
+}
+
+void ThreadPool::PostDelayedTask(PooledTaskQueue* queue,
+                                 std::unique_ptr<QueuedTask> task,
+                                 uint32_t milliseconds) {
+  DelayedEntryTimeout timeout;
+  timeout.next_fire_at_ms = rtc::TimeMillis() + milliseconds;
+  bool earliest;
+  {
+    rtc::CritScope lock(&timer_lock_);
+    timeout.order = next_order_++;
+    auto it =
+        delayed_tasks_.emplace(timeout, DelayedTask{queue, std::move(task)});
+    earliest = it.first == delayed_tasks_.begin();
+  }
+  if (earliest)
+    timer_wakeup_.Set();
+}
+
+void ThreadPool::CancelDelayedTasks(PooledTaskQueue* queue) {
+  std::vector<std::unique_ptr<QueuedTask>> cancelled;
+  {
+    rtc::CritScope lock(&timer_lock_);
+    for (auto it = delayed_tasks_.begin(); it != delayed_tasks_.end();) {
+      if (it->second.queue == queue) {
+        cancelled.push_back(std::move(it->second.task));
+        it = delayed_tasks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+// static
+void ThreadPool::TimerMain(void* context) {
+  static_cast<ThreadPool*>(context)->RunTimers();
+}
+
+void ThreadPool::RunTimers() {
+  while (!quit_.load()) {
+    int wait_ms = rtc::Event::kForever;
+    {
+      rtc::CritScope lock(&timer_lock_);
+      const int64_t now_ms = rtc::TimeMillis();
+      while (!delayed_tasks_.empty()) {
+        auto it = delayed_tasks_.begin();
+        if (it->first.next_fire_at_ms > now_ms) {
+          wait_ms = static_cast<int>(it->first.next_fire_at_ms - now_ms);
+          break;
+        }
+        // Posted under the lock, so that CancelDelayedTasks() returns only
+        // once no more tasks can be posted to the queue.
+        it->second.queue->PostTask(std::move(it->second.task));
+        delayed_tasks_.erase(it);
+      }
+    }
+    timer_wakeup_.Wait(wait_ms);
+  }
+}
+
+void PooledTaskQueue::Delete() {
+  RTC_DCHECK(!IsCurrent());
+  std::queue<std::unique_ptr<QueuedTask>> pending;
+  bool wait_for_running_task;
+  {
+    rtc::CritScope lock(&lock_);
+    deleted_ = true;
+    pending.swap(tasks_);
+    wait_for_running_task = running_;
+  }
+  if (wait_for_running_task)
+    stopped_running_.Wait(rtc::Event::kForever);
+  // No task of this queue is running now, so none can post delayed tasks.
+  pool_->CancelDelayedTasks(this);
+  // A pool thread may still hold a reference, and frees the queue when it
+  // finds that it was deleted.
+  Release();
+}
+
+void PooledTaskQueue::PostTask(std::unique_ptr<QueuedTask> task) {
+  {
+    rtc::CritScope lock(&lock_);
+    if (deleted_)
+      return;
+    tasks_.push(std::move(task));
+    if (scheduled_)
+      return;
+    scheduled_ = true;
+  }
+  pool_->Schedule(this);
+}
+
+void PooledTaskQueue::PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                                      uint32_t milliseconds) {
+  pool_->PostDelayedTask(this, std::move(task), milliseconds);
+}
+
+bool PooledTaskQueue::RunSlice() {
+  CurrentTaskQueueSetter set_current(this);
+  for (int i = 0; i < kMaxTasksPerSlice; ++i) {
+    std::unique_ptr<QueuedTask> task;
+    {
+      rtc::CritScope lock(&lock_);
+      if (deleted_ || tasks_.empty()) {
+        scheduled_ = false;
+        return false;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop();
+      running_ = true;
+    }
+
+    QueuedTask* release_ptr = task.release();
+    if (release_ptr->Run())
+      delete release_ptr;
+
+    bool deleted;
+    {
+      rtc::CritScope lock(&lock_);
+      running_ = false;
+      deleted = deleted_;
+    }
+    if (deleted) {
+      stopped_running_.Set();
+      return false;
+    }
+  }
+  rtc::CritScope lock(&lock_);
+  if (deleted_ || tasks_.empty()) {
+    scheduled_ = false;
+    return false;
+  }
+  return true;
+}
+
+class TaskQueueThreadPoolFactory final : public TaskQueueFactory {
+ public:
+  explicit TaskQueueThreadPoolFactory(int num_threads)
+      : pool_(absl::make_unique<ThreadPool>(num_threads)) {}
+
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
+      absl::string_view name,
+      Priority priority) const override {
+    PooledTaskQueue* queue = new rtc::RefCountedObject<PooledTaskQueue>(
+        pool_.get(), PriorityIndex(priority));
+    // Released by Delete().
+    queue->AddRef();
+    return std::unique_ptr<TaskQueueBase, TaskQueueDeleter>(queue);
+  }
+
+ private:
+  const std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace
+
+std::unique_ptr<TaskQueueFactory> CreateTaskQueueThreadPoolFactory(
+    int num_threads) {
+  return absl::make_unique<TaskQueueThreadPoolFactory>(num_threads);
+}
+
+}  // namespace webrtc
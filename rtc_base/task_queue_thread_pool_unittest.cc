@@ -0,0 +1,166 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_thread_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/task_queue/task_queue_test.h"
+#include "rtc_base/event.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/thread.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+std::unique_ptr<TaskQueueFactory> CreateFactoryWithFourThreads() {
+  return CreateTaskQueueThreadPoolFactory(4);
+}
+
+INSTANTIATE_TEST_SUITE_P(ThreadPool,
+                         TaskQueueTest,
+                         ::testing::Values(CreateFactoryWithFourThreads));
+
+TEST(TaskQueueThreadPoolTest, RunsEachQueueInOrderWithoutOverlap) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueThreadPoolFactory(4);
+  constexpr int kNumQueues = 50;
+  constexpr int kTasksPerQueue = 1000;
+
+  struct QueueState {
+    std::unique_ptr<TaskQueueBase, TaskQueueDeleter> queue;
+    std::atomic<bool> running{false};
+    int last_run = -1;
+  };
+  std::vector<QueueState> states(kNumQueues);
+  for (QueueState& state : states) {
+    state.queue =
+        factory->CreateTaskQueue("Queue", TaskQueueFactory::Priority::NORMAL);
+  }
+
+  std::atomic<int> tasks_left(kNumQueues * kTasksPerQueue);
+  rtc::Event done;
+  for (int i = 0; i < kTasksPerQueue; ++i) {
+    for (QueueState& state : states) {
+      state.queue->PostTask(ToQueuedTask([&state, &tasks_left, &done, i] {
+        EXPECT_TRUE(state.queue->IsCurrent());
+        EXPECT_FALSE(state.running.exchange(true));
+        EXPECT_EQ(state.last_run + 1, i);
+        state.last_run = i;
+        state.running.store(false);
+        if (--tasks_left == 0)
+          done.Set();
+      }));
+    }
+  }
+  EXPECT_TRUE(done.Wait(10000));
+}
+
+TEST(TaskQueueThreadPoolTest, RunsQueuesOnSeveralThreads) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueThreadPoolFactory(2);
+  auto first =
+      factory->CreateTaskQueue("First", TaskQueueFactory::Priority::NORMAL);
+  auto second =
+      factory->CreateTaskQueue("Second", TaskQueueFactory::Priority::NORMAL);
+  rtc::Event first_running;
+  rtc::Event second_ran;
+  rtc::Event first_done;
+  first->PostTask(ToQueuedTask([&] {
+    first_running.Set();
+    // Only succeeds if the other queue runs on another thread meanwhile.
+    EXPECT_TRUE(second_ran.Wait(1000));
+    first_done.Set();
+  }));
+  ASSERT_TRUE(first_running.Wait(1000));
+  second->PostTask(ToQueuedTask([&] { second_ran.Set(); }));
+  EXPECT_TRUE(first_done.Wait(2000));
+}
+
+TEST(TaskQueueThreadPoolTest, RunsQueuePostedToFromBlockedTask) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueThreadPoolFactory(2);
+  auto first =
+      factory->CreateTaskQueue("First", TaskQueueFactory::Priority::NORMAL);
+  auto second =
+      factory->CreateTaskQueue("Second", TaskQueueFactory::Priority::NORMAL);
+  rtc::Event second_ran;
+  rtc::Event first_done;
+  first->PostTask(ToQueuedTask([&] {
+    // Give the other thread time to find no work and wait.
+    rtc::Thread::SleepMs(50);
+    second->PostTask(ToQueuedTask([&] { second_ran.Set(); }));
+    // The other queue is scheduled on this thread, so it only runs meanwhile
+    // if the idle thread is woken to take it.
+    EXPECT_TRUE(second_ran.Wait(1000));
+    first_done.Set();
+  }));
+  EXPECT_TRUE(first_done.Wait(2000));
+}
+
+TEST(TaskQueueThreadPoolTest, RunsHigherPriorityQueuesFirst) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueThreadPoolFactory(1);
+  auto blocking =
+      factory->CreateTaskQueue("Blocking", TaskQueueFactory::Priority::NORMAL);
+  auto low = factory->CreateTaskQueue("Low", TaskQueueFactory::Priority::LOW);
+  auto normal =
+      factory->CreateTaskQueue("Normal", TaskQueueFactory::Priority::NORMAL);
+  auto high =
+      factory->CreateTaskQueue("High", TaskQueueFactory::Priority::HIGH);
+
+  rtc::Event blocked;
+  rtc::Event unblock;
+  blocking->PostTask(ToQueuedTask([&] {
+    blocked.Set();
+    unblock.Wait(rtc::Event::kForever);
+  }));
+  ASSERT_TRUE(blocked.Wait(1000));
+
+  std::vector<std::string> order;
+  rtc::Event done;
+  low->PostTask(ToQueuedTask([&] {
+    order.push_back("low");
+    done.Set();
+  }));
+  normal->PostTask(ToQueuedTask([&] { order.push_back("normal"); }));
+  high->PostTask(ToQueuedTask([&] { order.push_back("high"); }));
+  unblock.Set();
+  ASSERT_TRUE(done.Wait(1000));
+  EXPECT_EQ(order, std::vector<std::string>({"high", "normal", "low"}));
+}
+
+TEST(TaskQueueThreadPoolTest, DeleteWaitsForRunningTask) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueThreadPoolFactory(2);
+  auto queue =
+      factory->CreateTaskQueue("Queue", TaskQueueFactory::Priority::NORMAL);
+  rtc::Event running;
+  bool finished = false;
+  bool ran_after_delete = false;
+  queue->PostTask(ToQueuedTask([&] {
+    running.Set();
+    rtc::Thread::SleepMs(50);
+    finished = true;
+  }));
+  queue->PostTask(ToQueuedTask([&] { ran_after_delete = true; }));
+  ASSERT_TRUE(running.Wait(1000));
+  queue = nullptr;
+  EXPECT_TRUE(finished);
+  rtc::Thread::SleepMs(50);
+  EXPECT_FALSE(ran_after_delete);
+}
+
+}  // namespace
+}  // namespace webrtc
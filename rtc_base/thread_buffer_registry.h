@@ -0,0 +1,199 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_THREAD_BUFFER_REGISTRY_H_
+#define RTC_BASE_THREAD_BUFFER_REGISTRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace rtc {
+
+// Gives each thread a |Buffer| of its own, which the thread writes without
+// locking and a single reader drains, e.g. a ring buffer of log messages.
+// |Buffer| synchronizes the writing thread with the reader. A thread finds its
+// buffer through a thread local cache, and retires it when it exits, so that
+// the registry frees the buffer once the reader has read it for the last time.
+// A buffer stays alive while its thread runs, even if the registry is
+// destroyed.
+template <typename Buffer>
+class ThreadBufferRegistry {
+ public:
+  ThreadBufferRegistry() : id_(NextId()) {}
+
+  // Returns the buffer of the current thread, which is constructed from
+  // |args| the first time. Returns null while the thread exits, once its
+  // buffers have been retired.
+  template <typename... Args>
+  Buffer* GetThreadBuffer(Args&&... args) {
+    ThreadState& state = thread_state();
+    CachedBuffer& cached = state.cache[id_ % kCacheSize];
+    if (cached.registry_id == id_)
+      return cached.buffer;
+    if (state.retired)
+      return nullptr;
+
+    static thread_local ThreadEntries thread_entries;
+    Entry* entry = thread_entries.Find(id_);
+    if (!entry) {
+      auto new_entry =
+          std::make_shared<Entry>(id_, std::forward<Args>(args)...);
+      entry = new_entry.get();
+      {
+        CritScope cs(&crit_);
+        entries_.push_back(new_entry);
+      }
+      thread_entries.Add(std::move(new_entry));
+    }
+    cached.registry_id = id_;
+    cached.buffer = &entry->buffer;
+    return cached.buffer;
+  }
+
+  // Calls |read| with each buffer. A buffer that was retired before it's read
+  // has nothing more to come, and is freed after this read. Only ReadAll()
+  // removes buffers, so the ones passed to |read| stay valid without locking,
+  // as long as the calls to ReadAll() don't overlap.
+  template <typename Read>
+  void ReadAll(Read read) {
+    read_entries_.clear();
+    bool any_retired = false;
+    {
+      CritScope cs(&crit_);
+      for (const auto& entry : entries_) {
+        read_entries_.emplace_back(
+            entry.get(), entry->retired.load(std::memory_order_acquire));
+        any_retired |= read_entries_.back().second;
+      }
+    }
+    for (const auto& read_entry : read_entries_)
+      read(&read_entry.first->buffer);
+    if (!any_retired)
+      return;
+    CritScope cs(&crit_);
+    // Buffers are only added at the end meanwhile, so the listed ones come
+    // first, in the same order.
+    size_t kept = 0;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      if (i < read_entries_.size() && read_entries_[i].second)
+        continue;
+      entries_[kept++] = std::move(entries_[i]);
+    }
+    entries_.resize(kept);
+  }
+
+  // The number of threads with a buffer that hasn't been freed yet.
+  size_t size() {
+    CritScope cs(&crit_);
+    return entries_.size();
+  }
+
+ private:
+  // Number of registries whose buffer a thread remembers, so that it finds its
+  // buffer without locking. Only few registries of a type exist at a time.
+  static constexpr size_t kCacheSize = 4;
+
+  struct Entry {
+    template <typename... Args>
+    explicit Entry(uint64_t registry_id, Args&&... args)
+        : registry_id(registry_id), buffer(std::forward<Args>(args)...) {}
+
+    const uint64_t registry_id;
+    // Set by the thread when it exits, after its last write.
+    std::atomic<bool> retired{false};
+    Buffer buffer;
+  };
+
+  struct CachedBuffer {
+    uint64_t registry_id;
+    Buffer* buffer;
+  };
+
+  struct ThreadState {
+    CachedBuffer cache[kCacheSize];
+    // Set once the buffers of the thread are retired, for writes later in the
+    // exit of the thread.
+    bool retired;
+  };
+
+  // The buffers of the current thread in all registries. Retires them when
+  // the thread exits.
+  class ThreadEntries {
+   public:
+    ThreadEntries() = default;
+    ~ThreadEntries() {
+      ThreadState& state = thread_state();
+      state.retired = true;
+      for (CachedBuffer& cached : state.cache)
+        cached = CachedBuffer();
+      for (const auto& entry : entries_)
+        entry->retired.store(true, std::memory_order_release);
+    }
+
+    Entry* Find(uint64_t registry_id) const {
+      for (const auto& entry : entries_) {
+        if (entry->registry_id == registry_id)
+          return entry.get();
+      }
+      return nullptr;
+    }
+
+    void Add(std::shared_ptr<Entry> entry) {
+      // Forget the buffers of registries that have been destroyed.
+      entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                    [](const std::shared_ptr<Entry>& e) {
+                                      return e.use_count() == 1;
+                                    }),
+                     entries_.end());
+      entries_.push_back(std::move(entry));
+    }
+
+   private:
+    std::vector<std::shared_ptr<Entry>> entries_;
+
+    RTC_DISALLOW_COPY_AND_ASSIGN(ThreadEntries);
+  };
+
+  // Constant initialized, so that it's accessed without a guard.
+  static ThreadState& thread_state() {
+    static thread_local ThreadState state = {};
+    return state;
+  }
+
+  // Identifies the registry in the thread caches. Not reused, unlike the
+  // address of the registry.
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id(1);
+    return next_id.fetch_add(1);
+  }
+
+  const uint64_t id_;
+  CriticalSection crit_;
+  // Shared with the threads, which retire their buffer when they exit.
+  std::vector<std::shared_ptr<Entry>> entries_ RTC_GUARDED_BY(crit_);
+  // Used by ReadAll().
+  std::vector<std::pair<Entry*, bool>> read_entries_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ThreadBufferRegistry);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_THREAD_BUFFER_REGISTRY_H_
@@ -0,0 +1,177 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/thread_buffer_registry.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "rtc_base/platform_thread.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+// Keeps the values written by its thread. Only read by that thread, or once
+// it has exited.
+class TestBuffer {
+ public:
+  explicit TestBuffer(int* num_alive) : num_alive_(num_alive) {
+    ++*num_alive_;
+  }
+  ~TestBuffer() { --*num_alive_; }
+
+  void Write(int value) { values_.push_back(value); }
+  // Appends the values written so far to |values|, and releases them.
+  void Read(std::vector<int>* values) {
+    values->insert(values->end(), values_.begin(), values_.end());
+    values_.clear();
+  }
+
+ private:
+  int* const num_alive_;
+  std::vector<int> values_;
+};
+
+using TestRegistry = ThreadBufferRegistry<TestBuffer>;
+
+void RunFunction(void* function) {
+  (*static_cast<std::function<void()>*>(function))();
+}
+
+// Runs |function| on a thread of its own, and waits for the thread to exit.
+void RunOnThread(std::function<void()> function) {
+  PlatformThread thread(&RunFunction, &function, "Writer");
+  thread.Start();
+  thread.Stop();
+}
+
+std::vector<int> ReadAll(TestRegistry* registry) {
+  std::vector<int> values;
+  registry->ReadAll([&values](TestBuffer* buffer) { buffer->Read(&values); });
+  return values;
+}
+
+// The tests get buffers on threads of their own, since a thread keeps its
+// buffers until it exits, or until it gets a buffer from another registry.
+
+TEST(ThreadBufferRegistryTest, CreatesOneBufferPerThread) {
+  int num_alive = 0;
+  TestRegistry registry;
+  TestBuffer* buffer = nullptr;
+  TestBuffer* other_buffer = nullptr;
+  RunOnThread([&] {
+    buffer = registry.GetThreadBuffer(&num_alive);
+    ASSERT_TRUE(buffer);
+    EXPECT_EQ(buffer, registry.GetThreadBuffer(&num_alive));
+    buffer->Write(1);
+  });
+  RunOnThread([&] {
+    other_buffer = registry.GetThreadBuffer(&num_alive);
+    other_buffer->Write(2);
+  });
+  EXPECT_NE(buffer, other_buffer);
+  EXPECT_EQ(2, num_alive);
+  EXPECT_EQ(2u, registry.size());
+  EXPECT_EQ(std::vector<int>({1, 2}), ReadAll(&registry));
+}
+
+TEST(ThreadBufferRegistryTest, FreesBuffersOfExitedThreadsOnceRead) {
+  int num_alive = 0;
+  TestRegistry registry;
+  RunOnThread([&] {
+    for (int i = 0; i < 3; ++i)
+      RunOnThread([&] { registry.GetThreadBuffer(&num_alive)->Write(i); });
+    EXPECT_EQ(3, num_alive);
+    EXPECT_EQ(3u, registry.size());
+
+    registry.GetThreadBuffer(&num_alive)->Write(3);
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), ReadAll(&registry));
+    EXPECT_EQ(1, num_alive);
+    EXPECT_EQ(1u, registry.size());
+    registry.GetThreadBuffer(&num_alive)->Write(4);
+  });
+  EXPECT_EQ(1, num_alive);
+  EXPECT_EQ(std::vector<int>({4}), ReadAll(&registry));
+  EXPECT_EQ(0, num_alive);
+  EXPECT_EQ(0u, registry.size());
+}
+
+TEST(ThreadBufferRegistryTest, KeepsBuffersOfEachRegistry) {
+  // More registries than a thread remembers without looking them up.
+  int num_alive = 0;
+  std::vector<std::unique_ptr<TestRegistry>> registries;
+  RunOnThread([&] {
+    std::vector<TestBuffer*> buffers;
+    for (int i = 0; i < 6; ++i) {
+      registries.push_back(std::unique_ptr<TestRegistry>(new TestRegistry()));
+      buffers.push_back(registries.back()->GetThreadBuffer(&num_alive));
+    }
+    for (int i = 0; i < 6; ++i) {
+      EXPECT_EQ(buffers[i], registries[i]->GetThreadBuffer(&num_alive));
+      buffers[i]->Write(i);
+    }
+    EXPECT_EQ(6, num_alive);
+  });
+  for (int i = 0; i < 6; ++i)
+    EXPECT_EQ(std::vector<int>({i}), ReadAll(registries[i].get()));
+  EXPECT_EQ(0, num_alive);
+}
+
+TEST(ThreadBufferRegistryTest, ThreadReleasesBufferOfDestroyedRegistry) {
+  int num_alive = 0;
+  RunOnThread([&] {
+    auto registry = std::unique_ptr<TestRegistry>(new TestRegistry());
+    registry->GetThreadBuffer(&num_alive);
+    registry.reset();
+    // The thread may still write to its buffer.
+    EXPECT_EQ(1, num_alive);
+
+    // It releases the buffer when it gets one from another registry.
+    TestRegistry other_registry;
+    other_registry.GetThreadBuffer(&num_alive);
+    EXPECT_EQ(1, num_alive);
+  });
+  EXPECT_EQ(0, num_alive);
+}
+
+// Writes to the buffer of its thread when the thread exits, after the buffers
+// of the thread have been retired.
+class ExitWriter {
+ public:
+  ExitWriter(TestRegistry* registry, int* num_alive, bool* got_buffer)
+      : registry_(registry), num_alive_(num_alive), got_buffer_(got_buffer) {}
+  ~ExitWriter() {
+    *got_buffer_ = registry_->GetThreadBuffer(num_alive_) != nullptr;
+  }
+
+ private:
+  TestRegistry* const registry_;
+  int* const num_alive_;
+  bool* const got_buffer_;
+};
+
+TEST(ThreadBufferRegistryTest, HasNoBufferForExitingThread) {
+  int num_alive = 0;
+  bool got_buffer = true;
+  TestRegistry registry;
+  RunOnThread([&] {
+    // Destroyed after the buffers of the thread, which are set up later.
+    static thread_local ExitWriter writer(&registry, &num_alive, &got_buffer);
+    registry.GetThreadBuffer(&num_alive)->Write(1);
+  });
+  EXPECT_FALSE(got_buffer);
+  EXPECT_EQ(std::vector<int>({1}), ReadAll(&registry));
+  EXPECT_EQ(0, num_alive);
+}
+
+}  // namespace
+}  // namespace rtc
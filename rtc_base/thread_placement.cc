@@ -0,0 +1,256 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/thread_placement.h"
+
+#if defined(WEBRTC_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#endif
+#include <algorithm>
+#include <map>
+
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread_types.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace rtc {
+namespace {
+
+struct PlacedThread {
+  std::string name;
+  PlatformThreadRef ref;
+};
+
+// The running threads placed with SetCurrentThreadPlacement().
+class PlacedThreads {
+ public:
+  static PlacedThreads* Get() {
+    static PlacedThreads* const threads = new PlacedThreads();
+    return threads;
+  }
+
+  void Add(absl::string_view name) {
+    CritScope cs(&crit_);
+    PlacedThread& thread = threads_[CurrentThreadId()];
+    thread.name = std::string(name);
+    thread.ref = CurrentThreadRef();
+  }
+
+  void Remove() {
+    CritScope cs(&crit_);
+    threads_.erase(CurrentThreadId());
+  }
+
+  std::vector<ThreadCpuUsage> CpuUsage() {
+    // Threads remove themselves under the lock before they exit, so the ones
+    // listed can be read.
+    CritScope cs(&crit_);
+    std::vector<ThreadCpuUsage> usage;
+    usage.reserve(threads_.size());
+    for (const auto& thread : threads_) {
+      usage.push_back(
+          {thread.second.name, GetThreadCpuTimeNanos(thread.second.ref)});
+    }
+    return usage;
+  }
+
+ private:
+  CriticalSection crit_;
+  std::map<PlatformThreadId, PlacedThread> threads_ RTC_GUARDED_BY(crit_);
+};
+
+// Removes the current thread from PlacedThreads when it exits.
+class PlacedThreadRegistration {
+ public:
+  ~PlacedThreadRegistration() {
+    if (registered_)
+      PlacedThreads::Get()->Remove();
+  }
+
+  void Register(absl::string_view name) {
+    PlacedThreads::Get()->Add(name);
+    registered_ = true;
+  }
+
+ private:
+  bool registered_ = false;
+};
+
+thread_local PlacedThreadRegistration placed_thread_registration;
+
+#if defined(WEBRTC_LINUX)
+// Reads the CPUs of NUMA node |node| from sysfs, where they're listed like
+// "0-3,8-11".
+bool ReadNumaNodeCpus(int node, std::vector<int>* cpus) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+           node);
+  FILE* file = fopen(path, "r");
+  if (!file)
+    return false;
+  char list[1024];
+  const bool read = fgets(list, sizeof(list), file) != nullptr;
+  fclose(file);
+  if (!read)
+    return false;
+
+  const char* pos = list;
+  int first;
+  int length;
+  while (sscanf(pos, "%d%n", &first, &length) == 1) {
+    pos += length;
+    int last = first;
+    if (*pos == '-') {
+      if (sscanf(pos + 1, "%d%n", &last, &length) != 1)
+        return false;
+      pos += 1 + length;
+    }
+    for (int cpu = first; cpu <= last; ++cpu)
+      cpus->push_back(cpu);
+    if (*pos != ',')
+      break;
+    ++pos;
+  }
+  return !cpus->empty();
+}
+#endif  // defined(WEBRTC_LINUX)
+
+bool SetAffinity(const webrtc::ThreadPlacement& placement) {
+  if (placement.cpus.empty() && placement.numa_node < 0)
+    return true;
+
+#if defined(WEBRTC_LINUX)
+  std::vector<int> cpus = placement.cpus;
+  if (placement.numa_node >= 0) {
+    std::vector<int> node_cpus;
+    if (!ReadNumaNodeCpus(placement.numa_node, &node_cpus)) {
+      RTC_LOG(LS_WARNING) << "Failed to read the CPUs of NUMA node "
+                          << placement.numa_node;
+      return false;
+    }
+    if (cpus.empty()) {
+      cpus = node_cpus;
+    } else {
+      cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                                [&node_cpus](int cpu) {
+                                  return std::find(node_cpus.begin(),
+                                                   node_cpus.end(),
+                                                   cpu) == node_cpus.end();
+                                }),
+                 cpus.end());
+    }
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE)
+      CPU_SET(cpu, &cpu_set);
+  }
+  if (CPU_COUNT(&cpu_set) == 0) {
+    RTC_LOG(LS_WARNING) << "No CPUs to run the thread on.";
+    return false;
+  }
+  // 0 is the calling thread.
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    RTC_LOG_ERRNO(LS_WARNING) << "sched_setaffinity() failed.";
+    return false;
+  }
+  return true;
+#elif defined(WEBRTC_WIN)
+  ULONGLONG mask = 0;
+  for (int cpu : placement.cpus) {
+    if (cpu >= 0 && cpu < 64)
+      mask |= 1ULL << cpu;
+  }
+  if (placement.numa_node >= 0) {
+    ULONGLONG node_mask = 0;
+    if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(placement.numa_node),
+                                  &node_mask)) {
+      RTC_LOG(LS_WARNING) << "Failed to get the CPUs of NUMA node "
+                          << placement.numa_node;
+      return false;
+    }
+    mask = placement.cpus.empty() ? node_mask : mask & node_mask;
+  }
+  if (mask == 0) {
+    RTC_LOG(LS_WARNING) << "No CPUs to run the thread on.";
+    return false;
+  }
+  if (!SetThreadAffinityMask(GetCurrentThread(),
+                             static_cast<DWORD_PTR>(mask))) {
+    RTC_LOG(LS_WARNING) << "SetThreadAffinityMask() failed: "
+                        << GetLastError();
+    return false;
+  }
+  return true;
+#else
+  RTC_LOG(LS_WARNING) << "CPU affinity isn't supported on this platform.";
+  return false;
+#endif
+}
+
+bool SetScheduling(const webrtc::ThreadPlacement& placement) {
+  if (placement.scheduling == webrtc::ThreadPlacement::Scheduling::kDefault)
+    return true;
+
+#if defined(WEBRTC_LINUX)
+  int policy = SCHED_OTHER;
+  switch (placement.scheduling) {
+    case webrtc::ThreadPlacement::Scheduling::kDefault:
+    case webrtc::ThreadPlacement::Scheduling::kTimeSharing:
+      policy = SCHED_OTHER;
+      break;
+    case webrtc::ThreadPlacement::Scheduling::kFifo:
+      policy = SCHED_FIFO;
+      break;
+    case webrtc::ThreadPlacement::Scheduling::kRoundRobin:
+      policy = SCHED_RR;
+      break;
+  }
+  sched_param param;
+  param.sched_priority =
+      policy == SCHED_OTHER
+          ? 0
+          : std::min(std::max(placement.realtime_priority,
+                              sched_get_priority_min(policy)),
+                     sched_get_priority_max(policy));
+  const int error = pthread_setschedparam(pthread_self(), policy, &param);
+  if (error != 0) {
+    RTC_LOG(LS_WARNING) << "Failed to set the scheduling policy, error "
+                        << error;
+    return false;
+  }
+  return true;
+#else
+  RTC_LOG(LS_WARNING)
+      << "Scheduling policies aren't supported on this platform.";
+  return false;
+#endif
+}
+
+}  // namespace
+
+bool SetCurrentThreadPlacement(absl::string_view name,
+                               const webrtc::ThreadPlacement& placement) {
+  const bool affinity_set = SetAffinity(placement);
+  const bool scheduling_set = SetScheduling(placement);
+  placed_thread_registration.Register(name);
+  return affinity_set && scheduling_set;
+}
+
+std::vector<ThreadCpuUsage> GetPlacedThreadsCpuUsage() {
+  return PlacedThreads::Get()->CpuUsage();
+}
+
+}  // namespace rtc
@@ -0,0 +1,42 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_THREAD_PLACEMENT_H_
+#define RTC_BASE_THREAD_PLACEMENT_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "api/thread_placement.h"
+
+namespace rtc {
+
+// Applies |placement| to the current thread, and reports the thread as |name|
+// in GetPlacedThreadsCpuUsage() until it exits. Returns false if some part of
+// the placement couldn't be applied, e.g. a real-time policy without the
+// permission for it, or CPU affinity on Mac. The other parts are still applied.
+bool SetCurrentThreadPlacement(absl::string_view name,
+                               const webrtc::ThreadPlacement& placement);
+
+struct ThreadCpuUsage {
+  std::string name;
+  // CPU time since the thread started, from GetThreadCpuTimeNanos().
+  int64_t cpu_time_ns;
+};
+
+// Returns the CPU usage of the running threads placed with
+// SetCurrentThreadPlacement().
+std::vector<ThreadCpuUsage> GetPlacedThreadsCpuUsage();
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_THREAD_PLACEMENT_H_
@@ -0,0 +1,200 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(WEBRTC_LINUX)
+#include <sched.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "api/task_queue/default_task_queue_factory.h"
+#include "api/task_queue/thread_placement_task_queue_factory.h"
+#include "api/thread_placement.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/thread_placement.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+#if defined(WEBRTC_LINUX)
+
+// An audio-like task running every 10 ms, on the same CPU as threads that
+// don't leave it idle.
+constexpr int kPeriodMs = 10;
+constexpr int kNumPeriods = 300;
+constexpr int kNumBusyThreads = 4;
+constexpr char kQueueName[] = "PeriodicQueue";
+
+class FixedPlacementPolicy : public webrtc::ThreadPlacementPolicy {
+ public:
+  explicit FixedPlacementPolicy(const webrtc::ThreadPlacement& placement)
+      : placement_(placement) {}
+
+  webrtc::ThreadPlacement GetPlacement(
+      absl::string_view thread_name) const override {
+    return placement_;
+  }
+
+ private:
+  const webrtc::ThreadPlacement placement_;
+};
+
+// Spins on |cpu| with the time-sharing policy until destroyed.
+class BusyThread {
+ public:
+  explicit BusyThread(int cpu) : cpu_(cpu), thread_(&Run, this, "BusyThread") {
+    thread_.Start();
+  }
+  ~BusyThread() {
+    stop_.store(true, std::memory_order_relaxed);
+    thread_.Stop();
+  }
+
+ private:
+  static void Run(void* obj) {
+    BusyThread* thread = static_cast<BusyThread*>(obj);
+    webrtc::ThreadPlacement placement;
+    placement.cpus = {thread->cpu_};
+    placement.scheduling = webrtc::ThreadPlacement::Scheduling::kTimeSharing;
+    SetCurrentThreadPlacement("BusyThread", placement);
+    while (!thread->stop_.load(std::memory_order_relaxed)) {
+    }
+  }
+
+  const int cpu_;
+  std::atomic<bool> stop_{false};
+  PlatformThread thread_;
+};
+
+// Runs every kPeriodMs on |queue|, and records how late each run is.
+class PeriodicTask {
+ public:
+  explicit PeriodicTask(webrtc::TaskQueueBase* queue) : queue_(queue) {
+    queue_->PostTask(webrtc::ToQueuedTask([this] { Schedule(); }));
+  }
+
+  // Returns the lateness of the runs in microseconds, once they're done.
+  std::vector<int64_t> WaitForLateness() {
+    done_.Wait(Event::kForever);
+    return lateness_us_;
+  }
+
+ private:
+  void Schedule() {
+    target_us_ = TimeMicros() + kPeriodMs * kNumMicrosecsPerMillisec;
+    queue_->PostDelayedTask(webrtc::ToQueuedTask([this] { Run(); }),
+                            kPeriodMs);
+  }
+
+  void Run() {
+    lateness_us_.push_back(TimeMicros() - target_us_);
+    if (lateness_us_.size() < kNumPeriods) {
+      Schedule();
+    } else {
+      done_.Set();
+    }
+  }
+
+  webrtc::TaskQueueBase* const queue_;
+  Event done_;
+  int64_t target_us_ = 0;
+  std::vector<int64_t> lateness_us_;
+};
+
+int FirstAllowedCpu() {
+  cpu_set_t cpu_set;
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0)
+    return 0;
+  int cpu = 0;
+  while (!CPU_ISSET(cpu, &cpu_set))
+    ++cpu;
+  return cpu;
+}
+
+// Prints the mean, 99th percentile and maximum lateness of the periodic task
+// when its thread is placed with |placement|, and the CPU time of the thread.
+void MeasureJitter(const std::string& trace,
+                   webrtc::ThreadPlacement placement) {
+  const int cpu = FirstAllowedCpu();
+  placement.cpus = {cpu};
+  FixedPlacementPolicy policy(placement);
+  std::unique_ptr<webrtc::TaskQueueFactory> factory =
+      webrtc::CreateThreadPlacementTaskQueueFactory(
+          webrtc::CreateDefaultTaskQueueFactory(), &policy);
+  auto queue = factory->CreateTaskQueue(
+      kQueueName, webrtc::TaskQueueFactory::Priority::NORMAL);
+
+  std::vector<std::unique_ptr<BusyThread>> busy_threads;
+  for (int i = 0; i < kNumBusyThreads; ++i)
+    busy_threads.push_back(absl::make_unique<BusyThread>(cpu));
+  PeriodicTask task(queue.get());
+  std::vector<int64_t> lateness_us = task.WaitForLateness();
+  busy_threads.clear();
+
+  int64_t queue_cpu_time_ns = -1;
+  for (const ThreadCpuUsage& usage : GetPlacedThreadsCpuUsage()) {
+    if (usage.name == kQueueName)
+      queue_cpu_time_ns = usage.cpu_time_ns;
+  }
+  queue = nullptr;
+
+  std::sort(lateness_us.begin(), lateness_us.end());
+  int64_t total_us = 0;
+  for (int64_t us : lateness_us)
+    total_us += us;
+  webrtc::test::PrintResult(
+      "periodic_task_lateness", "", trace + "_mean",
+      static_cast<double>(total_us) / lateness_us.size(), "us", false);
+  webrtc::test::PrintResult("periodic_task_lateness", "", trace + "_p99",
+                            lateness_us[lateness_us.size() * 99 / 100], "us",
+                            false);
+  webrtc::test::PrintResult("periodic_task_lateness", "", trace + "_max",
+                            lateness_us.back(), "us", false);
+  webrtc::test::PrintResult(
+      "periodic_task_cpu_time", "", trace,
+      static_cast<double>(queue_cpu_time_ns) / kNumNanosecsPerMicrosec, "us",
+      false);
+}
+
+#endif  // defined(WEBRTC_LINUX)
+
+}  // namespace
+
+#if defined(WEBRTC_LINUX)
+
+TEST(ThreadPlacementPerfTest, TimeSharingScheduling) {
+  webrtc::ThreadPlacement placement;
+  placement.scheduling = webrtc::ThreadPlacement::Scheduling::kTimeSharing;
+  MeasureJitter("time_sharing", placement);
+}
+
+// Needs CAP_SYS_NICE or an RLIMIT_RTPRIO of 10, or measures the same as
+// time-sharing.
+TEST(ThreadPlacementPerfTest, FifoScheduling) {
+  webrtc::ThreadPlacement placement;
+  placement.scheduling = webrtc::ThreadPlacement::Scheduling::kFifo;
+  placement.realtime_priority = 10;
+  MeasureJitter("fifo", placement);
+}
+
+#endif  // defined(WEBRTC_LINUX)
+
+}  // namespace rtc
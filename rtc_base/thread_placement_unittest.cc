@@ -0,0 +1,105 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/thread_placement.h"
+
+#if defined(WEBRTC_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <functional>
+#include <string>
+
+#include "rtc_base/platform_thread.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+void RunFunction(void* function) {
+  (*static_cast<std::function<void()>*>(function))();
+}
+
+// Runs |function| on a thread of its own, so that the test thread keeps its
+// placement.
+void RunOnThread(std::function<void()> function) {
+  PlatformThread thread(&RunFunction, &function, "PlacementTest");
+  thread.Start();
+  thread.Stop();
+}
+
+const ThreadCpuUsage* FindThread(const std::vector<ThreadCpuUsage>& usage,
+                                 const std::string& name) {
+  for (const ThreadCpuUsage& thread : usage) {
+    if (thread.name == name)
+      return &thread;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST(ThreadPlacementTest, ReportsPlacedThreadsWhileRunning) {
+  RunOnThread([] {
+    EXPECT_TRUE(SetCurrentThreadPlacement("PlacedThread",
+                                          webrtc::ThreadPlacement()));
+    const std::vector<ThreadCpuUsage> usage = GetPlacedThreadsCpuUsage();
+    const ThreadCpuUsage* thread = FindThread(usage, "PlacedThread");
+    ASSERT_TRUE(thread);
+    EXPECT_GT(thread->cpu_time_ns, 0);
+  });
+  EXPECT_FALSE(FindThread(GetPlacedThreadsCpuUsage(), "PlacedThread"));
+}
+
+#if defined(WEBRTC_LINUX)
+TEST(ThreadPlacementTest, SetsCpuAffinity) {
+  RunOnThread([] {
+    cpu_set_t cpu_set;
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(cpu_set), &cpu_set));
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &cpu_set))
+      ++cpu;
+
+    webrtc::ThreadPlacement placement;
+    placement.cpus = {cpu};
+    EXPECT_TRUE(SetCurrentThreadPlacement("PinnedThread", placement));
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(cpu_set), &cpu_set));
+    EXPECT_EQ(1, CPU_COUNT(&cpu_set));
+    EXPECT_TRUE(CPU_ISSET(cpu, &cpu_set));
+  });
+}
+
+TEST(ThreadPlacementTest, FailsOnMissingNumaNode) {
+  RunOnThread([] {
+    webrtc::ThreadPlacement placement;
+    placement.numa_node = 4095;
+    EXPECT_FALSE(SetCurrentThreadPlacement("NumaThread", placement));
+  });
+}
+
+TEST(ThreadPlacementTest, SetsRealtimeSchedulingWherePermitted) {
+  RunOnThread([] {
+    webrtc::ThreadPlacement placement;
+    placement.scheduling = webrtc::ThreadPlacement::Scheduling::kRoundRobin;
+    placement.realtime_priority = 10;
+    const bool placed = SetCurrentThreadPlacement("RealtimeThread", placement);
+    int policy;
+    sched_param param;
+    ASSERT_EQ(0, pthread_getschedparam(pthread_self(), &policy, &param));
+    // Without CAP_SYS_NICE or an RLIMIT_RTPRIO the thread stays as it is.
+    EXPECT_EQ(placed ? SCHED_RR : SCHED_OTHER, policy);
+    if (placed) {
+      EXPECT_EQ(10, param.sched_priority);
+    }
+  });
+}
+#endif  // defined(WEBRTC_LINUX)
+
+}  // namespace rtc
@@ -80,6 +80,8 @@ inline bool IsDisabled(const char* name) {
 // This method can be called at most once before any other call into webrtc.
 // E.g. before the peer connection factory is constructed.
 // Note: trials_string must never be destroyed.
+// The string is parsed when it's set, so the default FindFullName() is a
+// hash map lookup, and changes to the string after the call aren't seen.
 void InitFieldTrialsFromString(const char* trials_string);
 
 const char* GetFieldTrialString();
@@ -37,6 +37,15 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
         "=d"(cpu_info[3])
       : "a"(info_type));
 }
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile(
+      "mov %%ebx, %%edi\n"
+      "cpuid\n"
+      "xchg %%edi, %%ebx\n"
+      : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]),
+        "=d"(cpu_info[3])
+      : "a"(info_type), "c"(sub_type));
+}
 #else
 static inline void __cpuid(int cpu_info[4], int info_type) {
   __asm__ volatile("cpuid\n"
@@ -44,10 +53,30 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
                      "=d"(cpu_info[3])
                    : "a"(info_type));
 }
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile("cpuid\n"
+                   : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]),
+                     "=d"(cpu_info[3])
+                   : "a"(info_type), "c"(sub_type));
+}
 #endif
 #endif  // _MSC_VER
 #endif  // WEBRTC_ARCH_X86_FAMILY
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Returns the value of the extended control register |xcr|, which tells which
+// register states the OS saves on context switches.
+static uint64_t xgetbv(uint32_t xcr) {
+#if defined(_MSC_VER)
+  return _xgetbv(xcr);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif  // _MSC_VER
+}
+#endif  // WEBRTC_ARCH_X86_FAMILY
+
 #if defined(WEBRTC_ARCH_X86_FAMILY)
 // Actual feature detection for x86.
 static int GetCPUInfo(CPUFeature feature) {
@@ -59,6 +88,23 @@ static int GetCPUInfo(CPUFeature feature) {
   if (feature == kSSE3) {
     return 0 != (cpu_info[2] & 0x00000001);
   }
+#if defined(WEBRTC_ENABLE_AVX2)
+  if (feature == kAVX2) {
+    // AVX2 code also uses FMA, and needs the OS to preserve the YMM registers
+    // (OSXSAVE set, and XMM and YMM state enabled in XCR0).
+    const bool has_fma = 0 != (cpu_info[2] & 0x00001000);
+    const bool has_osxsave = 0 != (cpu_info[2] & 0x08000000);
+    const bool has_avx = 0 != (cpu_info[2] & 0x10000000);
+    if (!has_fma || !has_osxsave || !has_avx || (xgetbv(0) & 0x6) != 0x6)
+      return 0;
+    int cpu_info7[4];
+    __cpuid(cpu_info7, 0);
+    if (cpu_info7[0] < 7)
+      return 0;
+    __cpuidex(cpu_info7, 7, 0);
+    return 0 != (cpu_info7[1] & 0x00000020);
+  }
+#endif  // WEBRTC_ENABLE_AVX2
   return 0;
 }
 #else
@@ -10,7 +10,11 @@
 #include "system_wrappers/include/field_trial.h"
 
 #include <stddef.h>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 // Simple field trial implementation, which allows client to
 // specify desired flags in InitFieldTrialsFromString.
@@ -20,14 +24,27 @@ namespace field_trial {
 static const char* trials_init_string = NULL;
 
 #ifndef WEBRTC_EXCLUDE_FIELD_TRIAL_DEFAULT
-std::string FindFullName(const std::string& name) {
-  if (trials_init_string == NULL)
-    return std::string();
+namespace {
 
-  std::string trials_string(trials_init_string);
-  if (trials_string.empty())
-    return std::string();
+// The name/value pairs of a trials string, parsed once when the string is set
+// so that lookups don't scan the whole string.
+struct ParsedTrials {
+  std::unordered_map<std::string, std::string> trials;
+  // The trials this replaced. Lookups on other threads may still be reading
+  // them, e.g. while test::ScopedFieldTrials restores the previous trials, so
+  // they're never deleted. Linking them keeps them reachable.
+  const ParsedTrials* previous = nullptr;
+};
+
+// Like |trials_init_string|, only replaced by InitFieldTrialsFromString().
+std::atomic<const ParsedTrials*> parsed_trials(nullptr);
 
+std::unique_ptr<ParsedTrials> ParseTrials(const char* init_string) {
+  std::unique_ptr<ParsedTrials> trials(new ParsedTrials());
+  if (init_string == NULL)
+    return trials;
+
+  const std::string trials_string(init_string);
   static const char kPersistentStringSeparator = '/';
   size_t next_item = 0;
   while (next_item < trials_string.length()) {
@@ -47,16 +64,36 @@ std::string FindFullName(const std::string& name) {
                             field_value_end - field_name_end - 1);
     next_item = field_value_end + 1;
 
-    if (name == field_name)
-      return field_value;
+    // The first value of a trial that is listed more than once wins.
+    trials->trials.emplace(std::move(field_name), std::move(field_value));
   }
-  return std::string();
+  return trials;
+}
+
+}  // namespace
+
+std::string FindFullName(const std::string& name) {
+  const ParsedTrials* trials = parsed_trials.load(std::memory_order_acquire);
+  if (trials == nullptr)
+    return std::string();
+  auto it = trials->trials.find(name);
+  if (it == trials->trials.end())
+    return std::string();
+  return it->second;
 }
 #endif  // WEBRTC_EXCLUDE_FIELD_TRIAL_DEFAULT
 
 // Optionally initialize field trial from a string.
 void InitFieldTrialsFromString(const char* trials_string) {
   trials_init_string = trials_string;
+#ifndef WEBRTC_EXCLUDE_FIELD_TRIAL_DEFAULT
+  ParsedTrials* trials = ParseTrials(trials_string).release();
+  trials->previous = parsed_trials.load(std::memory_order_relaxed);
+  while (!parsed_trials.compare_exchange_weak(trials->previous, trials,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+  }
+#endif  // WEBRTC_EXCLUDE_FIELD_TRIAL_DEFAULT
 }
 
 const char* GetFieldTrialString() {
@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "system_wrappers/include/field_trial.h"
+
+#include <atomic>
+
+#include "rtc_base/platform_thread.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace field_trial {
+namespace {
+
+class FieldTrialTest : public ::testing::Test {
+ protected:
+  FieldTrialTest() : previous_trials_(GetFieldTrialString()) {}
+  ~FieldTrialTest() override { InitFieldTrialsFromString(previous_trials_); }
+
+ private:
+  const char* const previous_trials_;
+};
+
+}  // namespace
+
+TEST_F(FieldTrialTest, FindsTrialsOfInitString) {
+  InitFieldTrialsFromString("WebRTC-Foo/Enabled/WebRTC-Bar/Disabled-10/");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-Foo"));
+  EXPECT_EQ("Disabled-10", FindFullName("WebRTC-Bar"));
+  EXPECT_EQ("", FindFullName("WebRTC-Baz"));
+  EXPECT_TRUE(IsEnabled("WebRTC-Foo"));
+  EXPECT_TRUE(IsDisabled("WebRTC-Bar"));
+}
+
+TEST_F(FieldTrialTest, FindsNothingWithoutInitString) {
+  InitFieldTrialsFromString(nullptr);
+  EXPECT_EQ("", FindFullName("WebRTC-Foo"));
+  InitFieldTrialsFromString("");
+  EXPECT_EQ("", FindFullName("WebRTC-Foo"));
+}
+
+TEST_F(FieldTrialTest, FirstValueOfRepeatedTrialWins) {
+  InitFieldTrialsFromString("WebRTC-Foo/Enabled/WebRTC-Foo/Disabled/");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-Foo"));
+}
+
+TEST_F(FieldTrialTest, IgnoresTrialsFromFirstMalformedOne) {
+  InitFieldTrialsFromString("WebRTC-Foo/Enabled/WebRTC-Bar//WebRTC-Baz/1/");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-Foo"));
+  EXPECT_EQ("", FindFullName("WebRTC-Bar"));
+  EXPECT_EQ("", FindFullName("WebRTC-Baz"));
+
+  InitFieldTrialsFromString("WebRTC-Foo/Enabled/WebRTC-Bar/Enabled");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-Foo"));
+  EXPECT_EQ("", FindFullName("WebRTC-Bar"));
+}
+
+TEST_F(FieldTrialTest, ReplacesTrialsOnInit) {
+  InitFieldTrialsFromString("WebRTC-Foo/Enabled/");
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-Foo"));
+  InitFieldTrialsFromString("WebRTC-Bar/Enabled/");
+  EXPECT_EQ("", FindFullName("WebRTC-Foo"));
+  EXPECT_EQ("Enabled", FindFullName("WebRTC-Bar"));
+}
+
+// Like test::ScopedFieldTrials replacing the trials while task queues look
+// them up. The replaced trials must stay readable.
+TEST_F(FieldTrialTest, FindsTrialsWhileReplaced) {
+  struct Lookups {
+    std::atomic<bool> stop{false};
+    std::atomic<int> unexpected{0};
+  } lookups;
+  InitFieldTrialsFromString("WebRTC-Foo/Enabled/");
+  rtc::PlatformThread thread(
+      [](void* obj) {
+        Lookups* lookups = static_cast<Lookups*>(obj);
+        while (!lookups->stop.load(std::memory_order_relaxed)) {
+          const std::string value = FindFullName("WebRTC-Foo");
+          if (value != "Enabled" && value != "Disabled")
+            lookups->unexpected.fetch_add(1, std::memory_order_relaxed);
+        }
+      },
+      &lookups, "FindFullName");
+  thread.Start();
+  for (int i = 0; i < 1000; ++i) {
+    InitFieldTrialsFromString(i % 2 ? "WebRTC-Foo/Enabled/"
+                                    : "WebRTC-Foo/Disabled/");
+  }
+  lookups.stop.store(true, std::memory_order_relaxed);
+  thread.Stop();
+  EXPECT_EQ(0, lookups.unexpected.load());
+}
+
+}  // namespace field_trial
+}  // namespace webrtc
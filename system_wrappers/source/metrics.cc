@@ -9,8 +9,13 @@
 
 #include "system_wrappers/include/metrics.h"
 
+#include <stdint.h>
 #include <algorithm>
+#include <atomic>
+#include <limits>
 
+#include "absl/base/attributes.h"
+#include "rtc_base/constructor_magic.h"
 #include "rtc_base/critical_section.h"
 #include "rtc_base/thread_annotations.h"
 
@@ -22,22 +27,112 @@ namespace metrics {
 class Histogram;
 
 namespace {
-// Limit for the maximum number of sample values that can be stored.
+// Limit for the maximum number of sample values that can be stored in the
+// sample map of a histogram. Values in its shards come on top of these.
 // TODO(asapersson): Consider using bucket count (and set up
 // linearly/exponentially spaced buckets) if samples are logged more frequently.
 const int kMaxSampleMapSize = 300;
 
+// Samples are first added to a shard of the histogram, picked by thread, so
+// that threads adding to the same histogram don't contend for a lock. Threads
+// get shards round-robin, and share them once there are more threads than
+// shards.
+const int kNumShards = 16;
+// The number of sample values a shard has room for. Values that don't fit are
+// added to the sample map of the histogram, under its lock.
+const int kShardSize = 64;
+const int kMaxShardProbes = 8;
+const int kEmptySlot = std::numeric_limits<int>::min();
+
+std::atomic<int> g_next_shard_index(0);
+ABSL_CONST_INIT thread_local int g_shard_index = -1;
+
+int CurrentShardIndex() {
+  if (g_shard_index < 0) {
+    g_shard_index =
+        g_next_shard_index.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  }
+  return g_shard_index;
+}
+
+// Counts of sample values, added to without locking. Values are never removed
+// from a shard, since a thread may be adding to them, only their counts reset.
+class HistogramShard {
+ public:
+  HistogramShard() {
+    for (Slot& slot : slots_) {
+      slot.value.store(kEmptySlot, std::memory_order_relaxed);
+      slot.count.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Returns false if there's no room for |sample|.
+  bool Add(int sample) {
+    uint32_t index = (static_cast<uint32_t>(sample) * 2654435761u) % kShardSize;
+    for (int probe = 0; probe < kMaxShardProbes; ++probe) {
+      Slot& slot = slots_[index];
+      int value = slot.value.load(std::memory_order_relaxed);
+      if (value == kEmptySlot) {
+        // On failure |value| is the value another thread put in the slot.
+        if (slot.value.compare_exchange_strong(value, sample,
+                                               std::memory_order_relaxed)) {
+          value = sample;
+        }
+      }
+      if (value == sample) {
+        slot.count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+      index = (index + 1) % kShardSize;
+    }
+    return false;
+  }
+
+  // Adds the counts of the shard to |samples|, and resets them if |reset|.
+  void CollectSamples(std::map<int, int>* samples, bool reset) {
+    for (Slot& slot : slots_) {
+      const int value = slot.value.load(std::memory_order_relaxed);
+      if (value == kEmptySlot)
+        continue;
+      const int count =
+          reset ? slot.count.exchange(0, std::memory_order_relaxed)
+                : slot.count.load(std::memory_order_relaxed);
+      if (count > 0)
+        (*samples)[value] += count;
+    }
+  }
+
+ private:
+  struct Slot {
+    std::atomic<int> value;
+    std::atomic<int> count;
+  };
+  Slot slots_[kShardSize];
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(HistogramShard);
+};
+
 class RtcHistogram {
  public:
   RtcHistogram(const std::string& name, int min, int max, int bucket_count)
       : min_(min), max_(max), info_(name, min, max, bucket_count) {
     RTC_DCHECK_GT(bucket_count, 0);
+    for (std::atomic<HistogramShard*>& shard : shards_)
+      shard.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~RtcHistogram() {
+    for (std::atomic<HistogramShard*>& shard : shards_)
+      delete shard.load(std::memory_order_relaxed);
   }
 
   void Add(int sample) {
     sample = std::min(sample, max_);
     sample = std::max(sample, min_ - 1);  // Underflow bucket.
 
+    if (GetShard(CurrentShardIndex())->Add(sample))
+      return;
+
     rtc::CritScope cs(&crit_);
     if (info_.samples.size() == kMaxSampleMapSize &&
         info_.samples.find(sample) == info_.samples.end()) {
@@ -49,15 +144,14 @@ class RtcHistogram {
   // Returns a copy (or nullptr if there are no samples) and clears samples.
   std::unique_ptr<SampleInfo> GetAndReset() {
     rtc::CritScope cs(&crit_);
-    if (info_.samples.empty())
-      return nullptr;
-
-    SampleInfo* copy =
-        new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count);
-
+    std::unique_ptr<SampleInfo> copy(
+        new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count));
     std::swap(info_.samples, copy->samples);
+    CollectShardSamples(&copy->samples, true);
+    if (copy->samples.empty())
+      return nullptr;
 
-    return std::unique_ptr<SampleInfo>(copy);
+    return copy;
   }
 
   const std::string& name() const { return info_.name; }
@@ -66,38 +160,65 @@ class RtcHistogram {
   void Reset() {
     rtc::CritScope cs(&crit_);
     info_.samples.clear();
+    std::map<int, int> shard_samples;
+    CollectShardSamples(&shard_samples, true);
   }
 
   int NumEvents(int sample) const {
-    rtc::CritScope cs(&crit_);
-    const auto it = info_.samples.find(sample);
-    return (it == info_.samples.end()) ? 0 : it->second;
+    const std::map<int, int> samples = Samples();
+    const auto it = samples.find(sample);
+    return (it == samples.end()) ? 0 : it->second;
   }
 
   int NumSamples() const {
     int num_samples = 0;
-    rtc::CritScope cs(&crit_);
-    for (const auto& sample : info_.samples) {
+    for (const auto& sample : Samples()) {
       num_samples += sample.second;
     }
     return num_samples;
   }
 
   int MinSample() const {
-    rtc::CritScope cs(&crit_);
-    return (info_.samples.empty()) ? -1 : info_.samples.begin()->first;
+    const std::map<int, int> samples = Samples();
+    return (samples.empty()) ? -1 : samples.begin()->first;
   }
 
   std::map<int, int> Samples() const {
     rtc::CritScope cs(&crit_);
-    return info_.samples;
+    std::map<int, int> samples = info_.samples;
+    CollectShardSamples(&samples, false);
+    return samples;
   }
 
  private:
+  HistogramShard* GetShard(int index) {
+    HistogramShard* shard = shards_[index].load(std::memory_order_acquire);
+    if (shard)
+      return shard;
+    HistogramShard* new_shard = new HistogramShard();
+    if (shards_[index].compare_exchange_strong(shard, new_shard,
+                                               std::memory_order_acq_rel)) {
+      return new_shard;
+    }
+    // Another thread sharing the shard created it first.
+    delete new_shard;
+    return shard;
+  }
+
+  void CollectShardSamples(std::map<int, int>* samples, bool reset) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_) {
+    for (const std::atomic<HistogramShard*>& shard : shards_) {
+      HistogramShard* shard_ptr = shard.load(std::memory_order_acquire);
+      if (shard_ptr)
+        shard_ptr->CollectSamples(samples, reset);
+    }
+  }
+
   rtc::CriticalSection crit_;
   const int min_;
   const int max_;
   SampleInfo info_ RTC_GUARDED_BY(crit_);
+  std::atomic<HistogramShard*> shards_[kNumShards];
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtcHistogram);
 };
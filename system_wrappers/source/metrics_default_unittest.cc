@@ -12,8 +12,12 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
 #include "system_wrappers/include/metrics.h"
 #include "test/gtest.h"
 
@@ -52,6 +56,31 @@ int NumEvents(const std::string& name,
 
   return it_sample->second;
 }
+
+const char kThreadsName[] = "Threads";
+const int kSamplesPerThread = 1000;
+
+// Adds the samples 0 to 9 to the same histogram as other threads, once all
+// threads are started.
+class SampleThread {
+ public:
+  explicit SampleThread(rtc::Event* start)
+      : start_(start), thread_(&Run, this, "SampleThread") {
+    thread_.Start();
+  }
+  ~SampleThread() { thread_.Stop(); }
+
+ private:
+  static void Run(void* obj) {
+    SampleThread* thread = static_cast<SampleThread*>(obj);
+    thread->start_->Wait(rtc::Event::kForever);
+    for (int i = 0; i < kSamplesPerThread; ++i)
+      RTC_HISTOGRAM_COUNTS_100(kThreadsName, i % 10);
+  }
+
+  rtc::Event* const start_;
+  rtc::PlatformThread thread_;
+};
 }  // namespace
 
 class MetricsDefaultTest : public ::testing::Test {
@@ -149,6 +178,47 @@ TEST_F(MetricsDefaultTest, GetAndReset) {
   EXPECT_EQ(1, metrics::NumEvents("Histogram2", 8));
 }
 
+TEST_F(MetricsDefaultTest, MergesSamplesOfThreads) {
+  // More threads than there are shards, so that some threads share a shard.
+  const int kNumThreads = 20;
+  rtc::Event start(true, false);
+  {
+    std::vector<std::unique_ptr<SampleThread>> threads;
+    for (int i = 0; i < kNumThreads; ++i)
+      threads.push_back(absl::make_unique<SampleThread>(&start));
+    start.Set();
+  }
+  EXPECT_EQ(kNumThreads * kSamplesPerThread,
+            metrics::NumSamples(kThreadsName));
+  EXPECT_EQ(kNumThreads * kSamplesPerThread / 10,
+            metrics::NumEvents(kThreadsName, 3));
+  // Values below the minimum end up in the underflow bucket.
+  EXPECT_EQ(kNumThreads * kSamplesPerThread / 10,
+            metrics::NumEvents(kThreadsName, 0));
+  EXPECT_EQ(0, metrics::MinSample(kThreadsName));
+
+  std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+  metrics::GetAndReset(&histograms);
+  EXPECT_EQ(kNumThreads * kSamplesPerThread,
+            NumSamples(kThreadsName, histograms));
+  EXPECT_EQ(0, metrics::NumSamples(kThreadsName));
+}
+
+TEST_F(MetricsDefaultTest, ManyDistinctSamples) {
+  const std::string kName = "ManyDistinct";
+  // More distinct values than a shard has room for.
+  for (int i = 1; i <= 200; ++i)
+    RTC_HISTOGRAM_COUNTS_1000(kName, i);
+  EXPECT_EQ(200, metrics::NumSamples(kName));
+  EXPECT_EQ(1, metrics::MinSample(kName));
+  EXPECT_EQ(1, metrics::NumEvents(kName, 100));
+  EXPECT_EQ(1, metrics::NumEvents(kName, 200));
+
+  std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+  metrics::GetAndReset(&histograms);
+  EXPECT_EQ(200u, histograms[kName]->samples.size());
+}
+
 TEST_F(MetricsDefaultTest, TestMinMaxBucket) {
   const std::string kName = "MinMaxCounts100";
   RTC_HISTOGRAM_COUNTS_100(kName, 4);
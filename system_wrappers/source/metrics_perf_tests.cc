@@ -0,0 +1,103 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "system_wrappers/include/metrics.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kSamplesPerThread = 500000;
+
+// Adds samples to the same histogram as the other threads, like per-packet
+// statistics of streams handled on different threads, once all threads are
+// started.
+class SampleThread {
+ public:
+  SampleThread(rtc::Event* start, bool sparse)
+      : start_(start), sparse_(sparse), thread_(&Run, this, "SampleThread") {
+    thread_.Start();
+  }
+
+  int64_t Join() {
+    thread_.Stop();
+    return cpu_time_ns_;
+  }
+
+ private:
+  static void Run(void* obj) {
+    SampleThread* thread = static_cast<SampleThread*>(obj);
+    thread->start_->Wait(rtc::Event::kForever);
+    const int64_t start_ns = rtc::GetThreadCpuTimeNanos();
+    if (thread->sparse_) {
+      for (int i = 0; i < kSamplesPerThread; ++i)
+        RTC_HISTOGRAM_COUNTS_SPARSE_1000("WebRTC.Perf.Sparse", i % 50);
+    } else {
+      for (int i = 0; i < kSamplesPerThread; ++i)
+        RTC_HISTOGRAM_COUNTS_1000("WebRTC.Perf.Counts", i % 50);
+    }
+    thread->cpu_time_ns_ = rtc::GetThreadCpuTimeNanos() - start_ns;
+  }
+
+  rtc::Event* const start_;
+  const bool sparse_;
+  rtc::PlatformThread thread_;
+  int64_t cpu_time_ns_ = 0;
+};
+
+// Prints the CPU time per added sample, with |num_threads| threads adding to
+// the same histogram at the same time.
+void MeasureHistogramAdd(const std::string& trace,
+                         bool sparse,
+                         int num_threads) {
+  metrics::Reset();
+  rtc::Event start(true, false);
+  std::vector<std::unique_ptr<SampleThread>> threads;
+  for (int i = 0; i < num_threads; ++i)
+    threads.push_back(absl::make_unique<SampleThread>(&start, sparse));
+  start.Set();
+  int64_t cpu_time_ns = 0;
+  for (auto& thread : threads)
+    cpu_time_ns += thread->Join();
+
+  EXPECT_EQ(num_threads * kSamplesPerThread,
+            metrics::NumSamples(sparse ? "WebRTC.Perf.Sparse"
+                                       : "WebRTC.Perf.Counts"));
+  webrtc::test::PrintResult(
+      "rtc_histogram", "", trace,
+      static_cast<double>(cpu_time_ns) / (num_threads * kSamplesPerThread),
+      "ns/sample", false);
+}
+
+}  // namespace
+
+TEST(MetricsPerfTest, HistogramCountsOneThread) {
+  MeasureHistogramAdd("counts_one_thread", false, 1);
+}
+
+TEST(MetricsPerfTest, HistogramCountsSixteenThreads) {
+  MeasureHistogramAdd("counts_sixteen_threads", false, 16);
+}
+
+// The sparse macros look the histogram up by name for each sample.
+TEST(MetricsPerfTest, HistogramCountsSparseSixteenThreads) {
+  MeasureHistogramAdd("counts_sparse_sixteen_threads", true, 16);
+}
+
+}  // namespace webrtc